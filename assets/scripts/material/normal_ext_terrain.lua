@@ -6,34 +6,37 @@ local terrain_texture_count <const> = 16
 local displacement_modes <const> = { none = 0, parallax_offset = 1, occlusion_mapping = 2 }
 local blend_modes <const> = { height = 0, basic = 1 }
 
-function make_constant_buffer(props)
-   local cb = constant_buffer_builder.new([[
-      float3 diffuse_color;
-      float3 specular_color;
-      bool use_envmap;
+local cb_layout = constant_buffer_layout.compile([[
+   float3 diffuse_color;
+   float3 specular_color;
+   bool use_envmap;
+
+   float3 texture_transforms[32];
 
-      float3 texture_transforms[32];
+   float2 texture_vars[16];
+]])
+local cb_fields = cb_layout:field_indices()
 
-      float2 texture_vars[16];
-   ]])
+function make_constant_buffer(props)
+   local cb = constant_buffer_builder.new(cb_layout)
    
-   cb:set("diffuse_color", props:get_float3("DiffuseColor", float3.new(1.0, 1.0, 1.0)))
-   cb:set("specular_color", props:get_float3("SpecularColor", float3.new(1.0, 1.0, 1.0)))
-   cb:set("use_envmap", props:get_bool("UseEnvmap", false))
+   cb:set_at(cb_fields.diffuse_color, props:get_float3("DiffuseColor", float3.new(1.0, 1.0, 1.0)))
+   cb:set_at(cb_fields.specular_color, props:get_float3("SpecularColor", float3.new(1.0, 1.0, 1.0)))
+   cb:set_at(cb_fields.use_envmap, props:get_bool("UseEnvmap", false))
       
    for i=0, (terrain_texture_count - 1) do
-      cb:set(string.format("texture_transforms[%i]", i * 2),
-             props:get_float3("TextureTransformsX" .. i,
-                              float3.new(1.0 / 16.0, 0.0, 0.0)))
-      cb:set(string.format("texture_transforms[%i]", i * 2 + 1),
-             props:get_float3("TextureTransformsY" .. i,
-                              float3.new(0.0, 0.0, 1.0 / 16.0)))
+      cb:set_at(cb_fields[string.format("texture_transforms[%i]", i * 2)],
+                props:get_float3("TextureTransformsX" .. i,
+                                 float3.new(1.0 / 16.0, 0.0, 0.0)))
+      cb:set_at(cb_fields[string.format("texture_transforms[%i]", i * 2 + 1)],
+                props:get_float3("TextureTransformsY" .. i,
+                                 float3.new(0.0, 0.0, 1.0 / 16.0)))
    end
 
    for i=0, (terrain_texture_count - 1) do
-      cb:set(string.format("texture_vars[%i]", i),
-             float2.new(props:get_float("HeightScale" .. i, 0.025),
-                        props:get_float("SpecularExponent" .. i, 64.0)))
+      cb:set_at(cb_fields[string.format("texture_vars[%i]", i)],
+                float2.new(props:get_float("HeightScale" .. i, 0.025),
+                           props:get_float("SpecularExponent" .. i, 64.0)))
    end
 
    return cb:complete()
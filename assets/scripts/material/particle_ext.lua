@@ -2,15 +2,18 @@
 constant_buffer_bind = constant_buffer_bind_flag.ps
 fail_safe_texture_index = 0
 
+local cb_layout = constant_buffer_layout.compile([[
+   bool   use_aniso_wrap_sampler;
+   float  brightness_scale;
+]])
+local cb_fields = cb_layout:field_indices()
+
 function make_constant_buffer(props)
-   local cb = constant_buffer_builder.new([[
-      bool   use_aniso_wrap_sampler;
-      float  brightness_scale;
-   ]])
+   local cb = constant_buffer_builder.new(cb_layout)
 
 
-   cb:set("use_aniso_wrap_sampler", props:get_bool("UseAnisotropicFiltering", false))
-   cb:set("brightness_scale", math2.exp2(props:get_float("EmissivePower", 1.0)))
+   cb:set_at(cb_fields.use_aniso_wrap_sampler, props:get_bool("UseAnisotropicFiltering", false))
+   cb:set_at(cb_fields.brightness_scale, math2.exp2(props:get_float("EmissivePower", 1.0)))
 
    return cb:complete()
 end
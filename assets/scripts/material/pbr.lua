@@ -2,20 +2,23 @@
 constant_buffer_bind = constant_buffer_bind_flag.ps
 fail_safe_texture_index = 0
 
+local cb_layout = constant_buffer_layout.compile([[
+   float3 base_color;
+   float base_metallicness;
+   float base_roughness;
+   float ao_strength;
+   float emissive_power;
+]])
+local cb_fields = cb_layout:field_indices()
+
 function make_constant_buffer(props)
-   local cb = constant_buffer_builder.new([[
-      float3 base_color;
-      float base_metallicness;
-      float base_roughness;
-      float ao_strength;
-      float emissive_power;
-   ]])
-
-   cb:set("base_color", props:get_float3("BaseColor", float3.new(1.0, 1.0, 1.0)))
-   cb:set("base_metallicness", props:get_float("Metallicness", 1.0))
-   cb:set("base_roughness", props:get_float("Roughness", 1.0))
-   cb:set("ao_strength", math2.rcp(props:get_float("AOStrength", 1.0)))
-   cb:set("emissive_power", math2.exp2(props:get_float("EmissivePower", 0.0)))
+   local cb = constant_buffer_builder.new(cb_layout)
+
+   cb:set_at(cb_fields.base_color, props:get_float3("BaseColor", float3.new(1.0, 1.0, 1.0)))
+   cb:set_at(cb_fields.base_metallicness, props:get_float("Metallicness", 1.0))
+   cb:set_at(cb_fields.base_roughness, props:get_float("Roughness", 1.0))
+   cb:set_at(cb_fields.ao_strength, math2.rcp(props:get_float("AOStrength", 1.0)))
+   cb:set_at(cb_fields.emissive_power, math2.exp2(props:get_float("EmissivePower", 0.0)))
 
    return cb:complete()
 end
@@ -2,13 +2,16 @@
 constant_buffer_bind = constant_buffer_bind_flag.ps
 fail_safe_texture_index = 0
 
+local cb_layout = constant_buffer_layout.compile([[
+   float emissive_power;
+]])
+local cb_fields = cb_layout:field_indices()
+
 function make_constant_buffer(props)
-   local cb = constant_buffer_builder.new([[
-      float emissive_power;
-   ]])
+   local cb = constant_buffer_builder.new(cb_layout)
 
 
-   cb:set("emissive_power", math2.exp2(props:get_float("EmissivePower", 0.0)))
+   cb:set_at(cb_fields.emissive_power, math2.exp2(props:get_float("EmissivePower", 0.0)))
 
    return cb:complete()
 end
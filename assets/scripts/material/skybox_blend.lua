@@ -2,14 +2,17 @@
 constant_buffer_bind = constant_buffer_bind_flag.ps
 fail_safe_texture_index = 0
 
+local cb_layout = constant_buffer_layout.compile([[
+   float blend_bottom;
+   float blend_top;
+]])
+local cb_fields = cb_layout:field_indices()
+
 function make_constant_buffer(props)
-   local cb = constant_buffer_builder.new([[
-      float blend_bottom;
-      float blend_top;
-   ]])
+   local cb = constant_buffer_builder.new(cb_layout)
 
-   cb:set("blend_bottom", props:get_float("BlendBottom", 0.0))
-   cb:set("blend_top", props:get_float("BlendTop", 100.0))
+   cb:set_at(cb_fields.blend_bottom, props:get_float("BlendBottom", 0.0))
+   cb:set_at(cb_fields.blend_top, props:get_float("BlendTop", 100.0))
 
    return cb:complete()
 end
@@ -31,14 +31,34 @@ using Binary_file_handle =
 
 class Binary_file : public Binary_file_handle {
 public:
-   enum class Mode { read, write };
+   enum class Mode { read, write, append };
 
    Binary_file() = default;
 
    Binary_file(const std::filesystem::path& path, const Mode mode)
    {
-      reset(CreateFileW(path.c_str(), mode == Mode::read ? GENERIC_READ : GENERIC_WRITE,
-                        0x0, nullptr, mode == Mode::read ? OPEN_EXISTING : CREATE_ALWAYS,
+      const DWORD access = [mode]() -> DWORD {
+         switch (mode) {
+         case Mode::read:
+            return GENERIC_READ;
+         case Mode::append:
+            return FILE_APPEND_DATA;
+         default:
+            return GENERIC_WRITE;
+         }
+      }();
+      const DWORD creation_disposition = [mode]() -> DWORD {
+         switch (mode) {
+         case Mode::read:
+            return OPEN_EXISTING;
+         case Mode::append:
+            return OPEN_ALWAYS;
+         default:
+            return CREATE_ALWAYS;
+         }
+      }();
+
+      reset(CreateFileW(path.c_str(), access, 0x0, nullptr, creation_disposition,
                         FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
 
       if (get() == INVALID_HANDLE_VALUE) {
@@ -54,8 +74,9 @@ public:
 
 class Binary_writer {
 public:
-   explicit Binary_writer(const std::filesystem::path& path)
-      : _file{path, Binary_file::Mode::write}
+   explicit Binary_writer(const std::filesystem::path& path,
+                          const Binary_file::Mode mode = Binary_file::Mode::write)
+      : _file{path, mode}
    {
    }
 
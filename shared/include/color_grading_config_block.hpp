@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+#pragma warning(push)
+#pragma warning(disable : 4996)
+#pragma warning(disable : 4127)
+#pragma warning(disable : 4251)
+#pragma warning(disable : 4275)
+
+#include <yaml-cpp/yaml.h>
+#pragma warning(pop)
+
+namespace sp {
+
+enum class Color_grading_config_tonemapper : std::uint32_t {
+   filmic,
+   aces_fitted,
+   filmic_heji2015,
+   reinhard,
+   none
+};
+
+enum class Color_grading_config_bloom_mode : std::uint32_t { blended, threshold };
+
+// Laid out like glm::vec3, kept as a plain array so the block and its compiler
+// don't need glm.
+using Color_grading_config_float3 = std::array<float, 3>;
+
+// Fixed layout parameter block for a region config. spfx_munge compiles the
+// .clrfx YAML into these and the runtime reads them in place. Enumerations
+// match the order of their effects:: counterparts. Any change to the layout
+// must bump the colorgrading regions version.
+struct Color_grading_config_block {
+   struct Color_grading {
+      Color_grading_config_float3 color_filter;
+      float saturation;
+      float exposure;
+      float brightness;
+      float contrast;
+
+      Color_grading_config_tonemapper tonemapper;
+
+      float filmic_toe_strength;
+      float filmic_toe_length;
+      float filmic_shoulder_strength;
+      float filmic_shoulder_length;
+      float filmic_shoulder_angle;
+      float filmic_heji_whitepoint;
+
+      Color_grading_config_float3 shadow_color;
+      Color_grading_config_float3 midtone_color;
+      Color_grading_config_float3 highlight_color;
+
+      float shadow_offset;
+      float midtone_offset;
+      float highlight_offset;
+
+      float hsv_hue_adjustment;
+      float hsv_saturation_adjustment;
+      float hsv_value_adjustment;
+
+      Color_grading_config_float3 channel_mix_red;
+      Color_grading_config_float3 channel_mix_green;
+      Color_grading_config_float3 channel_mix_blue;
+   };
+
+   struct Bloom {
+      std::uint32_t enabled;
+      Color_grading_config_bloom_mode mode;
+
+      float threshold;
+      float blend_factor;
+
+      float intensity;
+      Color_grading_config_float3 tint;
+
+      float inner_scale;
+      Color_grading_config_float3 inner_tint;
+
+      float inner_mid_scale;
+      Color_grading_config_float3 inner_mid_tint;
+
+      float mid_scale;
+      Color_grading_config_float3 mid_tint;
+
+      float outer_mid_scale;
+      Color_grading_config_float3 outer_mid_tint;
+
+      float outer_scale;
+      Color_grading_config_float3 outer_tint;
+
+      std::uint32_t use_dirt;
+      float dirt_scale;
+      Color_grading_config_float3 dirt_tint;
+      std::array<char, 64> dirt_texture_name; // Null terminated.
+   };
+
+   Color_grading color_grading;
+   std::uint32_t has_bloom;
+   Bloom bloom;
+};
+
+static_assert(sizeof(Color_grading_config_float3) == 12);
+static_assert(std::is_trivially_copyable_v<Color_grading_config_block>);
+static_assert(std::is_standard_layout_v<Color_grading_config_block>);
+static_assert(sizeof(Color_grading_config_block) == 352);
+
+// Compiles a .clrfx config into a parameter block. Missing or malformed
+// values take the same defaults the runtime YAML loading used to give them.
+auto compile_colorgrading_config(const YAML::Node& config) -> Color_grading_config_block;
+
+// Checks a .clrfx config against the config schema, throwing a
+// std::runtime_error naming the first unknown key or malformed value found.
+void validate_colorgrading_config(const YAML::Node& config);
+
+// Turns a parameter block back into a .clrfx config that compiles to it.
+auto decompile_colorgrading_config(const Color_grading_config_block& block)
+   -> YAML::Node;
+
+// Range checks a block read from a file, throwing a std::runtime_error if its
+// enumerations are out of range or its dirt texture name is unterminated.
+void check_colorgrading_config_block(const Color_grading_config_block& block);
+
+}
@@ -1,10 +1,11 @@
 #pragma once
 
+#include "color_grading_config_block.hpp"
 #include "ucfb_reader.hpp"
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -35,7 +36,8 @@ struct Color_grading_region_desc {
 
 struct Color_grading_regions {
    std::vector<Color_grading_region_desc> regions;
-   std::unordered_map<std::string, YAML::Node> configs;
+   std::vector<std::string> config_names;
+   std::vector<Color_grading_config_block> configs;
 };
 
 void write_colorgrading_regions(const std::filesystem::path& save_path,
@@ -46,6 +46,17 @@ struct Texture_data {
 auto load_patch_texture(ucfb::Reader_strict<"sptx"_mn> reader, ID3D11Device1& device)
    -> std::pair<Com_ptr<ID3D11ShaderResourceView>, std::string>;
 
+// Reads only the info and name of a patch texture, leaving the texture data
+// untouched.
+auto load_patch_texture_header(ucfb::Reader_strict<"sptx"_mn> reader)
+   -> std::pair<Texture_info, std::string>;
+
+// Reads the info and name of a patch texture and checks that its info is sane
+// and its subresources are all in bounds, without touching the texture data.
+// Throws std::runtime_error describing the first problem found.
+auto check_patch_texture(ucfb::Reader_strict<"sptx"_mn> reader)
+   -> std::pair<Texture_info, std::string>;
+
 void load_patch_texture(
    ucfb::Reader_strict<"sptx"_mn> reader,
    std::function<void(const Texture_info info)> info_callback,
@@ -37,6 +37,8 @@ constexpr auto to_string(const Shader_patch_prerelease_stage stage) noexcept
    using namespace std::literals;
 
    switch (stage) {
+   case Shader_patch_prerelease_stage::none:
+      return ""sv;
    case Shader_patch_prerelease_stage::rc:
       return "rc"sv;
    case Shader_patch_prerelease_stage::preview:
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cmath>
+
+namespace sp {
+
+template<typename Float>
+inline auto decompress_srgb(const Float v) -> Float
+{
+   return (v < Float{0.04045})
+             ? v / Float{12.92}
+             : std::pow(std::abs((v + Float{0.055})) / Float{1.055}, Float{2.4});
+}
+
+template<typename Float>
+inline auto compress_srgb(const Float v)
+{
+   return (v < Float{0.0031308})
+             ? v * Float{12.92}
+             : Float{1.055} * std::pow(std::abs(v), Float{1.0} / Float{2.4}) -
+                  Float{0.055};
+}
+
+}
@@ -11,8 +11,6 @@
 #include <type_traits>
 #include <vector>
 
-#include <gsl/gsl>
-
 namespace sp {
 
 //! \brief Splits a string along a delimiter, exclusively.
@@ -245,7 +243,7 @@ template<typename Char_t, typename Char_triats = std::char_traits<Char_t>>
 constexpr auto sectioned_split_split(
    std::basic_string_view<Char_t, Char_triats> string,
    typename std::common_type<std::basic_string_view<Char_t, Char_triats>>::type open,
-   typename std::common_type<std::basic_string_view<Char_t, Char_triats>>::type close = open) noexcept
+   typename std::common_type<std::basic_string_view<Char_t, Char_triats>>::type close) noexcept
    -> std::optional<std::array<std::basic_string_view<Char_t, Char_triats>, 2>>
 {
    if (!begins_with(string, open)) return std::nullopt;
@@ -296,13 +294,13 @@ constexpr auto trim_whitespace(std::basic_string_view<char, Char_triats> string)
       auto result = std::find_if(std::begin(string), std::end(string), not_ws);
 
       string.remove_prefix(
-         gsl::narrow_cast<std::size_t>(std::distance(std::begin(string), result)));
+         static_cast<std::size_t>(std::distance(std::begin(string), result)));
    }
    {
       auto result = std::find_if(std::rbegin(string), std::rend(string), not_ws);
 
       string.remove_suffix(
-         gsl::narrow_cast<std::size_t>(std::distance(std::rbegin(string), result)));
+         static_cast<std::size_t>(std::distance(std::rbegin(string), result)));
    }
 
    return string;
@@ -585,7 +583,7 @@ struct hash<sp::Ci_String_view> {
    result_type operator()(argument_type arg) const noexcept
    {
       constexpr std::uint64_t FNV_prime = 1099511628211;
-      constexpr std::uint64_t offset_basis = 14695981039346656037;
+      constexpr std::uint64_t offset_basis = 14695981039346656037ull;
 
       std::uint64_t hash = offset_basis;
 
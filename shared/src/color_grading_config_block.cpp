@@ -0,0 +1,404 @@
+#include "color_grading_config_block.hpp"
+#include "compose_exception.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace sp {
+
+namespace {
+
+using Float3 = Color_grading_config_float3;
+
+constexpr std::array<std::pair<std::string_view, Color_grading_config_tonemapper>, 5>
+   tonemapper_names{
+      {{"Filmic"sv, Color_grading_config_tonemapper::filmic},
+       {"ACES sRGB Fitted"sv, Color_grading_config_tonemapper::aces_fitted},
+       {"Filmic Heji 2015"sv, Color_grading_config_tonemapper::filmic_heji2015},
+       {"Reinhard"sv, Color_grading_config_tonemapper::reinhard},
+       {"None"sv, Color_grading_config_tonemapper::none}}};
+
+constexpr std::array<std::pair<std::string_view, Color_grading_config_bloom_mode>, 2>
+   bloom_mode_names{{{"Blended"sv, Color_grading_config_bloom_mode::blended},
+                     {"Threshold"sv, Color_grading_config_bloom_mode::threshold}}};
+
+// Reads the values of one section of a config. When lenient values are read
+// the way the YAML convert<> specializations for the effects params read them,
+// when strict anything that those would silently replace with a default is an
+// error instead.
+class Config_reader {
+public:
+   Config_reader(const YAML::Node& node, const std::string_view section,
+                 const bool strict)
+      : _node{node}, _section{section}, _strict{strict}
+   {
+      if (_strict && _node && !_node.IsMap() && !_node.IsNull()) {
+         throw compose_exception<std::runtime_error>("Color grading config section "sv,
+                                                     _section, " is not a map."sv);
+      }
+   }
+
+   auto child(const std::string_view key) -> YAML::Node
+   {
+      return lookup(key);
+   }
+
+   template<typename Type>
+   auto read(const std::string_view key, const Type fallback) -> Type
+   {
+      const YAML::Node value = lookup(key);
+
+      if (!_strict) return value.as<Type>(fallback);
+      if (!value) return fallback;
+
+      try {
+         return value.as<Type>();
+      }
+      catch (YAML::Exception&) {
+         throw compose_exception<std::runtime_error>("Color grading config value "sv,
+                                                     _section, "."sv, key,
+                                                     " is malformed."sv);
+      }
+   }
+
+   // Reads a vector an element at a time, the way the bloom tints have always
+   // been read. When lenient a short sequence only overrides the elements it has.
+   auto read_elements(const std::string_view key, Color_grading_config_float3 fallback)
+      -> Color_grading_config_float3
+   {
+      if (_strict) return read(key, fallback);
+
+      const YAML::Node value = lookup(key);
+
+      if (!value) return fallback;
+
+      for (std::size_t i = 0; i < fallback.size(); ++i) {
+         fallback[i] = value[i].as<float>(fallback[i]);
+      }
+
+      return fallback;
+   }
+
+   template<typename Enum, std::size_t count>
+   auto read_enum(const std::string_view key,
+                  const std::array<std::pair<std::string_view, Enum>, count>& names,
+                  const Enum absent_value, const Enum unknown_value) -> Enum
+   {
+      const YAML::Node value = lookup(key);
+
+      if (!value) return absent_value;
+
+      const auto name = read(key, ""s);
+
+      for (const auto& [enum_name, enum_value] : names) {
+         if (name == enum_name) return enum_value;
+      }
+
+      if (_strict) {
+         throw compose_exception<std::runtime_error>("Color grading config value "sv,
+                                                     _section, "."sv, key, " ("sv,
+                                                     name, ") is not recognized."sv);
+      }
+
+      return unknown_value;
+   }
+
+   // When strict, throws if the section has any key that was not read.
+   void finish() const
+   {
+      if (!_strict || !_node || !_node.IsMap()) return;
+
+      for (const auto& entry : _node) {
+         const auto key = entry.first.as<std::string>();
+
+         if (std::find(_known_keys.cbegin(), _known_keys.cend(), key) !=
+             _known_keys.cend()) {
+            continue;
+         }
+
+         throw compose_exception<std::runtime_error>("Unknown key "sv, key,
+                                                     " in color grading config section "sv,
+                                                     _section, "."sv);
+      }
+   }
+
+private:
+   auto lookup(const std::string_view key) -> YAML::Node
+   {
+      _known_keys.emplace_back(key);
+
+      // Indexing a missing section throws, treat its values as missing instead.
+      if (!_node) return YAML::Node{YAML::NodeType::Undefined};
+
+      return _node[std::string{key}];
+   }
+
+   const YAML::Node _node;
+   const std::string_view _section;
+   const bool _strict;
+   std::vector<std::string_view> _known_keys;
+};
+
+auto compile_color_grading(const YAML::Node& node, const bool strict)
+   -> Color_grading_config_block::Color_grading
+{
+   Config_reader reader{node, "ColorGrading"sv, strict};
+   Color_grading_config_block::Color_grading cg{};
+
+   // Defaults match effects::Color_grading_params.
+   cg.color_filter = reader.read("ColorFilter"sv, Float3{1.0f, 1.0f, 1.0f});
+
+   cg.saturation = reader.read("Saturation"sv, 1.0f);
+   cg.exposure = reader.read("Exposure"sv, 0.0f);
+   cg.brightness = reader.read("Brightness"sv, 1.0f);
+   cg.contrast = reader.read("Contrast"sv, 1.0f);
+
+   cg.tonemapper = reader.read_enum("Tonemapper"sv, tonemapper_names,
+                                    Color_grading_config_tonemapper::filmic,
+                                    Color_grading_config_tonemapper::filmic);
+
+   cg.filmic_toe_strength = reader.read("FilmicToeStrength"sv, 0.0f);
+   cg.filmic_toe_length = reader.read("FilmicToeLength"sv, 0.5f);
+   cg.filmic_shoulder_strength = reader.read("FilmicShoulderStrength"sv, 0.0f);
+   cg.filmic_shoulder_length = reader.read("FilmicShoulderLength"sv, 0.5f);
+   cg.filmic_shoulder_angle = reader.read("FilmicShoulderAngle"sv, 0.0f);
+   cg.filmic_heji_whitepoint = reader.read("FilmicHejiWhitepoint"sv, 1.0f);
+
+   cg.shadow_color = reader.read("ShadowColor"sv, Float3{1.0f, 1.0f, 1.0f});
+   cg.midtone_color = reader.read("MidtoneColor"sv, Float3{1.0f, 1.0f, 1.0f});
+   cg.highlight_color = reader.read("HighlightColor"sv, Float3{1.0f, 1.0f, 1.0f});
+
+   cg.shadow_offset = reader.read("ShadowOffset"sv, 0.0f);
+   cg.midtone_offset = reader.read("MidtoneOffset"sv, 0.0f);
+   cg.highlight_offset = reader.read("HighlightOffset"sv, 0.0f);
+
+   cg.hsv_hue_adjustment = reader.read("HSVHueAdjustment"sv, 0.0f);
+   cg.hsv_saturation_adjustment = reader.read("HSVSaturationAdjustment"sv, 1.0f);
+   cg.hsv_value_adjustment = reader.read("HSVValueAdjustment"sv, 1.0f);
+
+   cg.channel_mix_red = reader.read("ChannelMixRed"sv, Float3{1.0f, 0.0f, 0.0f});
+   cg.channel_mix_green = reader.read("ChannelMixGreen"sv, Float3{0.0f, 1.0f, 0.0f});
+   cg.channel_mix_blue = reader.read("ChannelMixBlue"sv, Float3{0.0f, 0.0f, 1.0f});
+
+   reader.finish();
+
+   return cg;
+}
+
+auto compile_bloom(const YAML::Node& node, const bool strict)
+   -> Color_grading_config_block::Bloom
+{
+   Config_reader reader{node, "Bloom"sv, strict};
+   Color_grading_config_block::Bloom bloom{};
+
+   // Defaults match effects::Bloom_params, apart from those the YAML loading
+   // has always overridden (Mode and Intensity).
+   bloom.enabled = reader.read("Enable"sv, true);
+   bloom.mode = reader.read_enum("Mode"sv, bloom_mode_names,
+                                 Color_grading_config_bloom_mode::threshold,
+                                 Color_grading_config_bloom_mode::blended);
+
+   const bool threshold_mode = bloom.mode == Color_grading_config_bloom_mode::threshold;
+
+   // Only the value for the current mode is used, the other keeps its default.
+   const auto threshold = reader.read("Threshold"sv, 1.0f);
+   const auto blend_factor = reader.read("BlendFactor"sv, 0.05f);
+
+   bloom.threshold = threshold_mode ? threshold : 1.0f;
+   bloom.blend_factor = threshold_mode ? 0.05f : blend_factor;
+
+   const Float3 white{1.0f, 1.0f, 1.0f};
+
+   bloom.intensity = reader.read("Intensity"sv, 0.75f);
+   bloom.tint = reader.read_elements("Tint"sv, white);
+
+   bloom.inner_scale = reader.read("InnerScale"sv, 1.0f);
+   bloom.inner_tint = reader.read_elements("InnerTint"sv, white);
+
+   bloom.inner_mid_scale = reader.read("InnerMidScale"sv, 1.0f);
+   bloom.inner_mid_tint = reader.read_elements("InnerMidTint"sv, white);
+
+   bloom.mid_scale = reader.read("MidScale"sv, 1.0f);
+   bloom.mid_tint = reader.read_elements("MidTint"sv, white);
+
+   bloom.outer_mid_scale = reader.read("OuterMidScale"sv, 1.0f);
+   bloom.outer_mid_tint = reader.read_elements("OuterMidTint"sv, white);
+
+   bloom.outer_scale = reader.read("OuterScale"sv, 1.0f);
+   bloom.outer_tint = reader.read_elements("OuterTint"sv, white);
+
+   bloom.use_dirt = reader.read("UseDirt"sv, false);
+   const auto dirt_scale = reader.read("DirtScale"sv, 1.0f);
+
+   bloom.dirt_scale = threshold_mode ? dirt_scale : 1.0f;
+   bloom.dirt_tint = reader.read_elements("DirtTint"sv, white);
+
+   const auto dirt_texture_name = reader.read("DirtTextureName"sv, ""s);
+
+   if (dirt_texture_name.size() >= bloom.dirt_texture_name.size()) {
+      throw compose_exception<std::runtime_error>(
+         "Color grading config Bloom.DirtTextureName "sv, dirt_texture_name,
+         " is too long. Max length is "sv, bloom.dirt_texture_name.size() - 1, "."sv);
+   }
+
+   std::copy(dirt_texture_name.cbegin(), dirt_texture_name.cend(),
+             bloom.dirt_texture_name.begin());
+
+   reader.finish();
+
+   return bloom;
+}
+
+auto compile_config(const YAML::Node& config, const bool strict)
+   -> Color_grading_config_block
+{
+   Config_reader reader{config, "root"sv, strict};
+   Color_grading_config_block block{};
+
+   block.color_grading = compile_color_grading(reader.child("ColorGrading"sv), strict);
+
+   if (const auto bloom = reader.child("Bloom"sv); bloom) {
+      block.has_bloom = true;
+      block.bloom = compile_bloom(bloom, strict);
+   }
+
+   reader.finish();
+
+   return block;
+}
+
+template<typename Enum, std::size_t count>
+auto enum_name(const Enum value,
+               const std::array<std::pair<std::string_view, Enum>, count>& names)
+   -> std::string
+{
+   for (const auto& [enum_name, enum_value] : names) {
+      if (value == enum_value) return std::string{enum_name};
+   }
+
+   throw std::runtime_error{"invalid colorgrading config block!"};
+}
+
+auto decompile_color_grading(const Color_grading_config_block::Color_grading& cg)
+   -> YAML::Node
+{
+   YAML::Node node;
+
+   node["ColorFilter"s] = cg.color_filter;
+
+   node["Saturation"s] = cg.saturation;
+   node["Exposure"s] = cg.exposure;
+   node["Brightness"s] = cg.brightness;
+   node["Contrast"s] = cg.contrast;
+
+   node["Tonemapper"s] = enum_name(cg.tonemapper, tonemapper_names);
+
+   node["FilmicToeStrength"s] = cg.filmic_toe_strength;
+   node["FilmicToeLength"s] = cg.filmic_toe_length;
+   node["FilmicShoulderStrength"s] = cg.filmic_shoulder_strength;
+   node["FilmicShoulderLength"s] = cg.filmic_shoulder_length;
+   node["FilmicShoulderAngle"s] = cg.filmic_shoulder_angle;
+   node["FilmicHejiWhitepoint"s] = cg.filmic_heji_whitepoint;
+
+   node["ShadowColor"s] = cg.shadow_color;
+   node["MidtoneColor"s] = cg.midtone_color;
+   node["HighlightColor"s] = cg.highlight_color;
+
+   node["ShadowOffset"s] = cg.shadow_offset;
+   node["MidtoneOffset"s] = cg.midtone_offset;
+   node["HighlightOffset"s] = cg.highlight_offset;
+
+   node["HSVHueAdjustment"s] = cg.hsv_hue_adjustment;
+   node["HSVSaturationAdjustment"s] = cg.hsv_saturation_adjustment;
+   node["HSVValueAdjustment"s] = cg.hsv_value_adjustment;
+
+   node["ChannelMixRed"s] = cg.channel_mix_red;
+   node["ChannelMixGreen"s] = cg.channel_mix_green;
+   node["ChannelMixBlue"s] = cg.channel_mix_blue;
+
+   return node;
+}
+
+auto decompile_bloom(const Color_grading_config_block::Bloom& bloom) -> YAML::Node
+{
+   YAML::Node node;
+
+   node["Enable"s] = bloom.enabled != 0;
+   node["Mode"s] = enum_name(bloom.mode, bloom_mode_names);
+
+   node["Threshold"s] = bloom.threshold;
+   node["BlendFactor"s] = bloom.blend_factor;
+
+   node["Intensity"s] = bloom.intensity;
+   node["Tint"s] = bloom.tint;
+
+   node["InnerScale"s] = bloom.inner_scale;
+   node["InnerTint"s] = bloom.inner_tint;
+
+   node["InnerMidScale"s] = bloom.inner_mid_scale;
+   node["InnerMidTint"s] = bloom.inner_mid_tint;
+
+   node["MidScale"s] = bloom.mid_scale;
+   node["MidTint"s] = bloom.mid_tint;
+
+   node["OuterMidScale"s] = bloom.outer_mid_scale;
+   node["OuterMidTint"s] = bloom.outer_mid_tint;
+
+   node["OuterScale"s] = bloom.outer_scale;
+   node["OuterTint"s] = bloom.outer_tint;
+
+   node["UseDirt"s] = bloom.use_dirt != 0;
+   node["DirtScale"s] = bloom.dirt_scale;
+   node["DirtTint"s] = bloom.dirt_tint;
+   node["DirtTextureName"s] = std::string{bloom.dirt_texture_name.data()};
+
+   return node;
+}
+
+}
+
+auto compile_colorgrading_config(const YAML::Node& config) -> Color_grading_config_block
+{
+   return compile_config(config, false);
+}
+
+void validate_colorgrading_config(const YAML::Node& config)
+{
+   compile_config(config, true);
+}
+
+
+auto decompile_colorgrading_config(const Color_grading_config_block& block)
+   -> YAML::Node
+{
+   check_colorgrading_config_block(block);
+
+   YAML::Node config;
+
+   config["ColorGrading"s] = decompile_color_grading(block.color_grading);
+
+   if (block.has_bloom) config["Bloom"s] = decompile_bloom(block.bloom);
+
+   return config;
+}
+
+void check_colorgrading_config_block(const Color_grading_config_block& block)
+{
+   const auto& dirt_texture_name = block.bloom.dirt_texture_name;
+
+   if (block.color_grading.tonemapper > Color_grading_config_tonemapper::none ||
+       block.bloom.mode > Color_grading_config_bloom_mode::threshold ||
+       std::find(dirt_texture_name.cbegin(), dirt_texture_name.cend(), '\0') ==
+          dirt_texture_name.cend()) {
+      throw std::runtime_error{"invalid colorgrading config block!"};
+   }
+}
+
+}
@@ -1,18 +1,23 @@
-
 #include "color_grading_regions_io.hpp"
+#include "glm_yaml_adapters.hpp"
 #include "ucfb_writer.hpp"
 #include "volume_resource.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <span>
+#include <string_view>
+#include <utility>
 
 #include <gsl/gsl>
 
+using namespace std::literals;
+
 namespace sp {
 
 namespace {
 
-enum class Colorgrading_version : std::uint32_t { v_1, current = v_1 };
+enum class Colorgrading_version : std::uint32_t { v_1, v_2, current = v_2 };
 
 }
 
@@ -23,6 +28,8 @@ void write_colorgrading_regions(const std::filesystem::path& save_path,
            std::numeric_limits<std::uint32_t>::max());
    Expects(colorgrading_regions.configs.size() <=
            std::numeric_limits<std::uint32_t>::max());
+   Expects(colorgrading_regions.config_names.size() ==
+           colorgrading_regions.configs.size());
 
    std::ostringstream ostream;
 
@@ -44,19 +51,13 @@ void write_colorgrading_regions(const std::filesystem::path& save_path,
       // write config count
       writer.write<std::uint32_t>(
          static_cast<std::uint32_t>(colorgrading_regions.configs.size()));
+      writer.write<std::uint32_t>(sizeof(Color_grading_config_block));
 
-      for (const auto& config : colorgrading_regions.configs) {
-         writer.write(config.first);
-
-         const auto yaml = YAML::Dump(config.second);
-
-         if (yaml.size() > std::numeric_limits<std::uint32_t>::max()) {
-            throw std::runtime_error{"config too large!"};
-         }
-
-         writer.write<std::uint32_t>(static_cast<std::uint32_t>(yaml.size()));
-         writer.write(std::span{yaml});
+      for (const auto& name : colorgrading_regions.config_names) {
+         writer.write(name);
       }
+
+      writer.write(std::span{colorgrading_regions.configs});
    }
 
    const auto regions_data = ostream.str();
@@ -70,7 +71,7 @@ auto load_colorgrading_regions(ucfb::Reader_strict<"clrg"_mn> reader) -> Color_g
 {
    const auto version = reader.read<Colorgrading_version>();
 
-   if (version != Colorgrading_version::v_1) {
+   if (version != Colorgrading_version::v_1 && version != Colorgrading_version::v_2) {
       throw std::runtime_error{"unexpected version for colorgrading regions!"};
    }
 
@@ -90,16 +91,38 @@ auto load_colorgrading_regions(ucfb::Reader_strict<"clrg"_mn> reader) -> Color_g
 
    const auto config_count = reader.read<std::uint32_t>();
 
-   for (auto i = 0; i < config_count; ++i) {
-      const auto name = reader.read_string();
+   colorgrading.config_names.reserve(config_count);
+   colorgrading.configs.reserve(config_count);
+
+   // Version 1 embedded each config as YAML, compile them here like munge does.
+   if (version == Colorgrading_version::v_1) {
+      for (std::uint32_t i = 0; i < config_count; ++i) {
+         colorgrading.config_names.emplace_back(reader.read_string());
+
+         const auto config_size = reader.read<std::uint32_t>();
+         const auto config_data = reader.read_array<char>(config_size);
 
-      const auto config_size = reader.read<std::uint32_t>();
-      const auto config_data = reader.read_array<char>(config_size);
+         colorgrading.configs.push_back(compile_colorgrading_config(
+            YAML::Load(std::string{config_data.data(), config_size})));
+      }
+
+      return colorgrading;
+   }
+
+   if (reader.read<std::uint32_t>() != sizeof(Color_grading_config_block)) {
+      throw std::runtime_error{"unexpected colorgrading config block size!"};
+   }
 
-      colorgrading.configs.emplace(name, YAML::Load(std::string{config_data.data(),
-                                                                config_size}));
+   for (std::uint32_t i = 0; i < config_count; ++i) {
+      colorgrading.config_names.emplace_back(reader.read_string());
    }
 
+   const auto blocks = reader.read_array<Color_grading_config_block>(config_count);
+
+   for (const auto& block : blocks) check_colorgrading_config_block(block);
+
+   colorgrading.configs.assign(blocks.begin(), blocks.end());
+
    return colorgrading;
 }
 
@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -67,6 +68,110 @@ auto load_patch_texture(ucfb::Reader_strict<"sptx"_mn> reader, ID3D11Device1& de
    }
 }
 
+auto load_patch_texture_header(ucfb::Reader_strict<"sptx"_mn> reader)
+   -> std::pair<Texture_info, std::string>
+{
+   const auto version =
+      reader.read_child_strict<"VER_"_mn>().read<Texture_version>();
+
+   if (version != Texture_version::current) {
+      throw std::runtime_error{"texture has unknown version"};
+   }
+
+   const auto name = reader.read_child_strict<"NAME"_mn>().read_string();
+   const auto info = reader.read_child_strict<"INFO"_mn>().read<Texture_info>();
+
+   return {info, std::string{name}};
+}
+
+auto check_patch_texture(ucfb::Reader_strict<"sptx"_mn> reader)
+   -> std::pair<Texture_info, std::string>
+{
+   auto [info, name] = load_patch_texture_header(reader);
+
+   if (info.type > Texture_type::texturecubearray) {
+      throw compose_exception<std::runtime_error>("texture "sv, std::quoted(name),
+                                                  " has unknown type."sv);
+   }
+
+   if (info.width == 0 || info.height == 0 || info.depth == 0 ||
+       info.array_size == 0 || info.mip_count == 0) {
+      throw compose_exception<std::runtime_error>("texture "sv, std::quoted(name),
+                                                  " has a zero sized dimension."sv);
+   }
+
+   const auto max_mip_count = static_cast<std::uint32_t>(
+      std::bit_width(std::max({info.width, info.height, info.depth})));
+
+   if (info.mip_count > max_mip_count) {
+      throw compose_exception<std::runtime_error>("texture "sv, std::quoted(name),
+                                                  " has more mips than its size allows."sv);
+   }
+
+   if (info.format == DXGI_FORMAT_UNKNOWN) {
+      throw compose_exception<std::runtime_error>("texture "sv, std::quoted(name),
+                                                  " has unknown format."sv);
+   }
+
+   const bool is_1d = info.type == Texture_type::texture1d ||
+                      info.type == Texture_type::texture1darray;
+   const bool is_3d = info.type == Texture_type::texture3d;
+
+   if ((is_1d && info.height != 1) || (is_3d ? info.array_size != 1 : info.depth != 1)) {
+      throw compose_exception<std::runtime_error>("texture "sv, std::quoted(name),
+                                                  " has dimensions that don't match its type."sv);
+   }
+
+   auto data = ucfb::skip_to_child<"DATA"_mn>(reader);
+
+   // Subresources are stored item by item, each item holding all its mips.
+   for (std::uint32_t item = 0; item < info.array_size; ++item) {
+      for (std::uint32_t mip = 0; mip < info.mip_count; ++mip) {
+         auto sub = data.read_child_strict<"SUB_"_mn>();
+
+         const auto [pitch, slice_pitch, sub_data_size, data_offset] =
+            sub.read_multi<UINT, UINT, std::uint32_t, std::uint32_t>();
+
+         const std::size_t mip_width = std::max(info.width >> mip, 1u);
+         const std::size_t mip_height = std::max(info.height >> mip, 1u);
+         const std::uint64_t mip_depth = std::max(info.depth >> mip, 1u);
+
+         std::size_t min_pitch = 0;
+         std::size_t min_slice_pitch = 0;
+
+         if (FAILED(DirectX::ComputePitch(info.format, mip_width, mip_height,
+                                          min_pitch, min_slice_pitch))) {
+            throw compose_exception<std::runtime_error>("texture "sv, std::quoted(name),
+                                                        " has unsupported format."sv);
+         }
+
+         // Block compressed formats store several pixel rows per pitch.
+         const std::uint64_t rows = min_pitch != 0 ? min_slice_pitch / min_pitch : 0;
+
+         if (pitch < min_pitch || (is_3d && slice_pitch < pitch * rows)) {
+            throw compose_exception<std::runtime_error>(
+               "texture "sv, std::quoted(name), " item #"sv, item, " mip #"sv, mip,
+               " has a pitch too small for its size."sv);
+         }
+
+         const std::uint64_t required_size =
+            is_3d ? slice_pitch * mip_depth : pitch * rows;
+
+         if (sub_data_size < required_size) {
+            throw compose_exception<std::runtime_error>(
+               "texture "sv, std::quoted(name), " item #"sv, item, " mip #"sv, mip,
+               " has "sv, sub_data_size, " bytes of data but needs "sv,
+               required_size, '.');
+         }
+
+         sub.consume_unaligned(data_offset);
+         sub.consume_unaligned(sub_data_size);
+      }
+   }
+
+   return {info, std::move(name)};
+}
+
 void load_patch_texture(
    ucfb::Reader_strict<"sptx"_mn> reader,
    std::function<void(const Texture_info info)> info_callback,
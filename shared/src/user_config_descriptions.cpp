@@ -309,6 +309,11 @@ Even if this flag is true the debug layer will only be enabled if a debugger is
 R"(Limit Shader Patch to using a DXGI 1.2 factory to work around a crash in the Visual Studio Graphics Debugger. This also bypasses all GPU selection logic.)"sv
 },
 
+{
+"Record Shader Usage"sv,      
+R"(Records which material shader variants are used on each map. Later loads of a map will use the recording to compile the variants it needs ahead of time. A report of the variants created and used is also saved for each map next to the shader cache. Only useful to modders.)"sv
+},
+
 {
 "Shader Cache Path"sv,      
 R"(Path for shader cache file.)"sv
@@ -1,11 +1,10 @@
 
 #include "bf2_log_monitor.hpp"
-#include "file_helpers.hpp"
-#include "string_utilities.hpp"
 
 #include <cmath>
 #include <filesystem>
 #include <string_view>
+#include <utility>
 
 #include "imgui/imgui.h"
 #include "imgui/imgui_stdlib.h"
@@ -18,40 +17,10 @@ namespace sp {
 
 const auto log_name = L"BFront2.log";
 
-struct BF2_log_entry {
-   std::string_view severity;
-   std::string_view file;
-   std::string_view message;
-};
-
 namespace {
 
-auto parse_log_file(const std::string_view log_file) noexcept
-   -> std::vector<BF2_log_entry>
-{
-   std::vector<BF2_log_entry> results;
-   results.reserve(2048);
-
-   for (auto line_rest = split_string_on(log_file, "\r\n"sv); !line_rest[1].empty();
-        line_rest = split_string_on(line_rest[1], "\r\n"sv)) {
-      if (line_rest[0].starts_with("Message Severity"sv)) {
-         const auto [file, message_rest] = split_string_on(line_rest[1], "\r\n"sv);
-         const auto [message, remainder] = split_string_on(message_rest, "\r\n"sv);
-
-         line_rest[1] = remainder;
-
-         results.push_back({.severity = line_rest[0], .file = file, .message = message});
-      }
-      else if (line_rest[0].empty()) {
-         results.push_back({.message = "\n"sv});
-      }
-      else {
-         results.push_back({.message = line_rest[0]});
-      }
-   }
-
-   return results;
-}
+// Oldest entries are dropped past this, so long sessions don't grow without bound.
+constexpr std::size_t max_log_entries = 16384;
 
 auto get_severity_color(const std::string_view severity) -> ImVec4
 {
@@ -65,11 +34,10 @@ auto get_severity_color(const std::string_view severity) -> ImVec4
    return {1.0f, 1.0f, 1.0f, 1.0f};
 }
 
-bool test_filter(const BF2_log_entry& entry, const std::regex& filter) noexcept
+bool test_filter(const BF2_log_entry& entry, const Log_filter& filter) noexcept
 {
-   return std::regex_search(entry.severity.cbegin(), entry.severity.cend(), filter) ||
-          std::regex_search(entry.file.cbegin(), entry.file.cend(), filter) ||
-          std::regex_search(entry.message.cbegin(), entry.message.cend(), filter);
+   return filter.matches(entry.severity) || filter.matches(entry.file) ||
+          filter.matches(entry.message);
 }
 
 }
@@ -102,17 +70,7 @@ void BF2_log_monitor::show_imgui(const bool input_enabled) noexcept
 
    if (input_enabled) {
       if (ImGui::InputText("Regex Filter", &_regex_str)) {
-         if (!_regex_str.empty()) {
-            try {
-               _regex = std::regex{_regex_str, std::regex::icase};
-            }
-            catch (std::regex_error&) {
-               _regex = std::nullopt;
-            }
-         }
-         else {
-            _regex = std::nullopt;
-         }
+         _filter = Log_filter{_regex_str};
       }
 
       ImGui::SameLine();
@@ -128,7 +86,7 @@ void BF2_log_monitor::show_imgui(const bool input_enabled) noexcept
    ImGui::BeginChild("Entries");
 
    for (const auto& entry : _log_entries) {
-      if (_regex && !test_filter(entry, *_regex)) continue;
+      if (!_filter.matches_everything() && !test_filter(entry, _filter)) continue;
 
       if (!entry.severity.empty()) {
          ImGui::PushStyleColor(ImGuiCol_Text, get_severity_color(entry.severity));
@@ -175,7 +133,9 @@ void BF2_log_monitor::run() noexcept
       std::terminate();
    }
 
-   const auto log_path = std::filesystem::current_path() /= log_name;
+   Log_tail log_tail{std::filesystem::current_path() /= log_name};
+
+   append_lines(log_tail.poll().lines);
 
    while (true) {
       const auto wait_objects = std::array{_join_event.get(), file_notify};
@@ -186,23 +146,64 @@ void BF2_log_monitor::run() noexcept
       switch (wait_status) {
       case WAIT_OBJECT_0:
          return;
-      case WAIT_OBJECT_0 + 1:
-         if (std::filesystem::exists(log_path) &&
-             std::filesystem::is_regular_file(log_path)) {
+      case WAIT_OBJECT_0 + 1: {
+         auto update = log_tail.poll();
+
+         if (update.reset) {
             std::lock_guard lock{_mutex};
 
-            _file_contents = load_string_file(log_path);
-            _log_entries = parse_log_file(_file_contents);
+            _log_entries.clear();
+            _partial_entry = {};
+            _partial_entry_lines_remaining = 0;
          }
 
+         append_lines(std::move(update.lines));
+
          if (!FindNextChangeNotification(file_notify)) {
             std::terminate();
          }
 
          break;
+      }
       default:
          std::terminate();
       }
    }
 }
-}
\ No newline at end of file
+
+void BF2_log_monitor::append_lines(std::vector<std::string> lines) noexcept
+{
+   if (lines.empty()) return;
+
+   std::lock_guard lock{_mutex};
+
+   // Messages with a severity span three lines, severity, file and then the
+   // message. Those are assembled in _partial_entry as the lines arrive.
+   for (auto& line : lines) {
+      if (_partial_entry_lines_remaining == 2) {
+         _partial_entry.file = std::move(line);
+         _partial_entry_lines_remaining = 1;
+      }
+      else if (_partial_entry_lines_remaining == 1) {
+         _partial_entry.message = std::move(line);
+         _partial_entry_lines_remaining = 0;
+
+         _log_entries.push_back(std::move(_partial_entry));
+         _partial_entry = {};
+      }
+      else if (line.starts_with("Message Severity"sv)) {
+         _partial_entry.severity = std::move(line);
+         _partial_entry_lines_remaining = 2;
+      }
+      else if (line.empty()) {
+         _log_entries.push_back({.message = "\n"s});
+      }
+      else {
+         _log_entries.push_back({.message = std::move(line)});
+      }
+   }
+
+   while (_log_entries.size() > max_log_entries) _log_entries.pop_front();
+}
+
+}
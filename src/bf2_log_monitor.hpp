@@ -1,17 +1,21 @@
 #pragma once
 
+#include "log_tail.hpp"
 #include "smart_win32_handle.hpp"
 
+#include <deque>
 #include <mutex>
-#include <optional>
-#include <regex>
 #include <string>
 #include <thread>
 #include <vector>
 
 namespace sp {
 
-struct BF2_log_entry;
+struct BF2_log_entry {
+   std::string severity;
+   std::string file;
+   std::string message;
+};
 
 class BF2_log_monitor {
 public:
@@ -31,14 +35,17 @@ public:
 private:
    void run() noexcept;
 
+   void append_lines(std::vector<std::string> lines) noexcept;
+
    std::thread _thread;
    win32::Unique_handle _join_event{CreateEventW(nullptr, true, false, nullptr)};
    mutable std::mutex _mutex;
-   std::string _file_contents;
-   std::vector<BF2_log_entry> _log_entries;
+   std::deque<BF2_log_entry> _log_entries;
+   BF2_log_entry _partial_entry;
+   int _partial_entry_lines_remaining = 0;
 
    std::string _regex_str = "";
-   std::optional<std::regex> _regex = std::nullopt;
+   Log_filter _filter;
    bool _auto_scroll = true;
    bool _overlay = false;
    float _transparency = 1.0f;
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+
+namespace sp::core {
+
+// Runs resource loads on a pool of background threads. Finished loads are
+// held until the owner collects them with retire_completed, so the owner
+// decides when a result becomes visible (the patch does it once per frame).
+// Knows nothing about D3D11 so the scheduling can be driven headlessly with
+// in-memory data.
+template<typename Result>
+class Async_resource_loader {
+public:
+   enum class Ticket : std::uint32_t {};
+
+   // Called on a worker thread. Must be safe to call from multiple threads at
+   // once.
+   using Load_function = std::function<Result(std::span<const std::byte> data)>;
+
+   Async_resource_loader(Load_function load, const std::size_t worker_count) noexcept
+      : _load{std::move(load)}
+   {
+      _workers.reserve(worker_count);
+
+      for (std::size_t i = 0; i < worker_count; ++i) {
+         _workers.emplace_back(
+            [this](std::stop_token stop_token) { worker_main(stop_token); });
+      }
+   }
+
+   ~Async_resource_loader()
+   {
+      for (auto& worker : _workers) worker.request_stop();
+
+      _work_cv.notify_all();
+
+      _workers.clear();
+   }
+
+   Async_resource_loader(const Async_resource_loader&) = delete;
+   auto operator=(const Async_resource_loader&) -> Async_resource_loader& = delete;
+
+   Async_resource_loader(Async_resource_loader&&) = delete;
+   auto operator=(Async_resource_loader&&) -> Async_resource_loader& = delete;
+
+   // Queues a load of the data. With no workers the load runs here, though
+   // the result is still only handed out by retire_completed.
+   auto enqueue(std::vector<std::byte> data) noexcept -> Ticket
+   {
+      std::unique_lock lock{_mutex};
+
+      const Ticket ticket{_next_ticket++};
+
+      if (_workers.empty()) {
+         _running.insert(ticket);
+
+         lock.unlock();
+
+         Job job{.ticket = ticket, .data = std::move(data)};
+
+         run(job);
+
+         return ticket;
+      }
+
+      _queue.push_back(Job{.ticket = ticket, .data = std::move(data)});
+
+      lock.unlock();
+
+      _work_cv.notify_one();
+
+      return ticket;
+   }
+
+   // Drops a load. Queued loads never run, loads already running have their
+   // result destroyed on completion instead of being retired.
+   void cancel(const Ticket ticket) noexcept
+   {
+      std::unique_lock lock{_mutex};
+
+      if (auto queued = std::ranges::find(_queue, ticket, &Job::ticket);
+          queued != _queue.end()) {
+         _queue.erase(queued);
+
+         const bool idle = is_idle();
+
+         lock.unlock();
+
+         if (idle) _idle_cv.notify_all();
+
+         return;
+      }
+
+      if (_running.contains(ticket)) {
+         _cancelled.insert(ticket);
+
+         return;
+      }
+
+      std::erase_if(_completed, [&](const auto& completed) {
+         return completed.first == ticket;
+      });
+   }
+
+   // Hands every finished load to callback(Ticket, Result&&) on the calling
+   // thread, in completion order.
+   template<typename Callback>
+   void retire_completed(Callback&& callback) noexcept
+   {
+      std::vector<std::pair<Ticket, Result>> completed;
+
+      {
+         std::scoped_lock lock{_mutex};
+
+         completed.swap(_completed);
+      }
+
+      for (auto& [ticket, result] : completed) {
+         callback(ticket, std::move(result));
+      }
+   }
+
+   // Count of loads queued or running, retired loads are not included.
+   auto pending_count() const noexcept -> std::size_t
+   {
+      std::scoped_lock lock{_mutex};
+
+      return _queue.size() + _running.size();
+   }
+
+   // Blocks until every queued and running load has finished.
+   void wait_idle() noexcept
+   {
+      std::unique_lock lock{_mutex};
+
+      _idle_cv.wait(lock, [this] { return is_idle(); });
+   }
+
+private:
+   struct Job {
+      Ticket ticket;
+      std::vector<std::byte> data;
+   };
+
+   bool is_idle() const noexcept
+   {
+      return _queue.empty() && _running.empty();
+   }
+
+   void worker_main(std::stop_token stop_token) noexcept
+   {
+      while (!stop_token.stop_requested()) {
+         std::unique_lock lock{_mutex};
+
+         if (!_work_cv.wait(lock, stop_token, [this] { return !_queue.empty(); })) {
+            return;
+         }
+
+         Job job = std::move(_queue.front());
+
+         _queue.pop_front();
+         _running.insert(job.ticket);
+
+         lock.unlock();
+
+         run(job);
+      }
+   }
+
+   void run(Job& job) noexcept
+   {
+      Result result = _load(job.data);
+
+      job.data = {};
+
+      std::unique_lock lock{_mutex};
+
+      _running.erase(job.ticket);
+
+      if (!_cancelled.erase(job.ticket)) {
+         _completed.emplace_back(job.ticket, std::move(result));
+      }
+
+      const bool idle = is_idle();
+
+      lock.unlock();
+
+      if (idle) _idle_cv.notify_all();
+   }
+
+   const Load_function _load;
+
+   mutable std::mutex _mutex;
+   std::condition_variable_any _work_cv;
+   std::condition_variable _idle_cv;
+   std::deque<Job> _queue;
+   absl::flat_hash_set<Ticket> _running;
+   absl::flat_hash_set<Ticket> _cancelled;
+   std::vector<std::pair<Ticket, Result>> _completed;
+   std::uint32_t _next_ticket = 0;
+
+   std::vector<std::jthread> _workers;
+};
+
+}
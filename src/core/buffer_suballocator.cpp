@@ -0,0 +1,179 @@
+
+#include "buffer_suballocator.hpp"
+#include "../logger.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace sp::core {
+
+namespace {
+
+auto align_up(const std::uint32_t value, const std::uint32_t alignment) noexcept
+   -> std::uint32_t
+{
+   return (value + (alignment - 1)) & ~(alignment - 1);
+}
+
+}
+
+Buffer_suballocator::Buffer_suballocator(const std::uint32_t capacity) noexcept
+   : _capacity{capacity}
+{
+   insert_free_block(0, capacity);
+}
+
+auto Buffer_suballocator::allocate(const std::uint32_t size,
+                                   const std::uint32_t alignment) noexcept
+   -> std::optional<Allocation_id>
+{
+   if (!std::has_single_bit(alignment)) {
+      log_and_terminate("Buffer suballocation alignment must be a power of two!"sv);
+   }
+
+   if (size == 0 || size > _capacity) return std::nullopt;
+
+   // Best fit, the smallest block the allocation fits in once aligned.
+   for (auto it = _free_blocks_by_size.lower_bound({size, 0});
+        it != _free_blocks_by_size.end(); ++it) {
+      const auto [block_size, block_offset] = *it;
+
+      const std::uint32_t aligned_offset = align_up(block_offset, alignment);
+      const std::uint32_t padding = aligned_offset - block_offset;
+
+      if (padding > block_size || (block_size - padding) < size) continue;
+
+      erase_free_block(_free_blocks.find(block_offset));
+
+      if (padding != 0) insert_free_block(block_offset, padding);
+
+      if (const std::uint32_t remaining = block_size - padding - size; remaining != 0) {
+         insert_free_block(aligned_offset + size, remaining);
+      }
+
+      Allocation_id id;
+
+      if (!_free_ids.empty()) {
+         id = _free_ids.back();
+         _free_ids.pop_back();
+      }
+      else {
+         id = Allocation_id{static_cast<std::uint32_t>(_allocations.size())};
+         _allocations.emplace_back();
+      }
+
+      _allocations[static_cast<std::uint32_t>(id)] = {.offset = aligned_offset,
+                                                      .size = size,
+                                                      .alignment = alignment,
+                                                      .live = true};
+      _used += size;
+      _allocation_count += 1;
+
+      return id;
+   }
+
+   return std::nullopt;
+}
+
+void Buffer_suballocator::free(const Allocation_id id) noexcept
+{
+   auto& allocation = _allocations[static_cast<std::uint32_t>(id)];
+
+   if (!std::exchange(allocation.live, false)) {
+      log_and_terminate("Attempt to free buffer suballocation twice!"sv);
+   }
+
+   _used -= allocation.size;
+   _allocation_count -= 1;
+   _free_ids.push_back(id);
+
+   insert_free_block(allocation.offset, allocation.size);
+}
+
+auto Buffer_suballocator::stats() const noexcept -> Stats
+{
+   return {.capacity = _capacity,
+           .used = _used,
+           .largest_free_block =
+              _free_blocks_by_size.empty() ? 0 : _free_blocks_by_size.rbegin()->first,
+           .allocation_count = _allocation_count,
+           .free_block_count = static_cast<std::uint32_t>(_free_blocks.size())};
+}
+
+auto Buffer_suballocator::defragment() noexcept -> std::vector<Relocation>
+{
+   std::vector<Relocation> relocations;
+   relocations.reserve(_allocation_count);
+
+   for (std::uint32_t i = 0; i < _allocations.size(); ++i) {
+      if (!_allocations[i].live) continue;
+
+      relocations.push_back({.id = Allocation_id{i},
+                             .old_offset = _allocations[i].offset,
+                             .size = _allocations[i].size});
+   }
+
+   std::ranges::sort(relocations, {}, &Relocation::old_offset);
+
+   std::uint32_t head = 0;
+
+   for (auto& relocation : relocations) {
+      auto& allocation = _allocations[static_cast<std::uint32_t>(relocation.id)];
+
+      relocation.new_offset = align_up(head, allocation.alignment);
+      allocation.offset = relocation.new_offset;
+
+      head = relocation.new_offset + relocation.size;
+   }
+
+   _free_blocks.clear();
+   _free_blocks_by_size.clear();
+
+   std::uint32_t previous_end = 0;
+
+   for (const auto& relocation : relocations) {
+      if (relocation.new_offset != previous_end) {
+         insert_free_block(previous_end, relocation.new_offset - previous_end);
+      }
+
+      previous_end = relocation.new_offset + relocation.size;
+   }
+
+   if (previous_end != _capacity) {
+      insert_free_block(previous_end, _capacity - previous_end);
+   }
+
+   return relocations;
+}
+
+void Buffer_suballocator::insert_free_block(std::uint32_t offset, std::uint32_t size) noexcept
+{
+   // Coalesce with the blocks either side.
+   if (auto next = _free_blocks.find(offset + size); next != _free_blocks.end()) {
+      size += next->second;
+
+      erase_free_block(next);
+   }
+
+   if (auto next = _free_blocks.lower_bound(offset); next != _free_blocks.begin()) {
+      if (auto previous = std::prev(next);
+          previous->first + previous->second == offset) {
+         offset = previous->first;
+         size += previous->second;
+
+         erase_free_block(previous);
+      }
+   }
+
+   _free_blocks.emplace(offset, size);
+   _free_blocks_by_size.emplace(size, offset);
+}
+
+void Buffer_suballocator::erase_free_block(
+   const std::map<std::uint32_t, std::uint32_t>::iterator it) noexcept
+{
+   _free_blocks_by_size.erase({it->second, it->first});
+   _free_blocks.erase(it);
+}
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace sp::core {
+
+// Hands out ranges of a larger buffer. Knows nothing about the buffer itself,
+// just offsets and sizes. Allocations are referred to by id and their offset
+// looked up when needed so that they can be moved by defragment.
+class Buffer_suballocator {
+public:
+   enum class Allocation_id : std::uint32_t {};
+
+   struct Stats {
+      std::uint32_t capacity = 0;
+      std::uint32_t used = 0;
+      std::uint32_t largest_free_block = 0;
+      std::uint32_t allocation_count = 0;
+      std::uint32_t free_block_count = 0;
+
+      // 0.0 when all free space is in one block, approaching 1.0 as free
+      // space gets split into many small blocks.
+      auto fragmentation() const noexcept -> float
+      {
+         const std::uint32_t free = capacity - used;
+
+         if (free == 0) return 0.0f;
+
+         return 1.0f - (static_cast<float>(largest_free_block) / static_cast<float>(free));
+      }
+   };
+
+   struct Relocation {
+      Allocation_id id;
+      std::uint32_t old_offset;
+      std::uint32_t new_offset;
+      std::uint32_t size;
+   };
+
+   explicit Buffer_suballocator(const std::uint32_t capacity) noexcept;
+
+   // Returns std::nullopt if there is no free block the allocation fits in.
+   auto allocate(const std::uint32_t size, const std::uint32_t alignment) noexcept
+      -> std::optional<Allocation_id>;
+
+   void free(const Allocation_id id) noexcept;
+
+   auto offset(const Allocation_id id) const noexcept -> std::uint32_t
+   {
+      return _allocations[static_cast<std::uint32_t>(id)].offset;
+   }
+
+   auto size(const Allocation_id id) const noexcept -> std::uint32_t
+   {
+      return _allocations[static_cast<std::uint32_t>(id)].size;
+   }
+
+   auto capacity() const noexcept -> std::uint32_t
+   {
+      return _capacity;
+   }
+
+   bool empty() const noexcept
+   {
+      return _allocation_count == 0;
+   }
+
+   auto stats() const noexcept -> Stats;
+
+   // Packs every live allocation towards the start of the buffer, leaving all
+   // free space in a single block at the end (save for any padding needed to
+   // keep allocations aligned). Returns where every live
+   // allocation was moved from and to (including ones that did not move) in
+   // order of their new offset.
+   auto defragment() noexcept -> std::vector<Relocation>;
+
+private:
+   struct Allocation {
+      std::uint32_t offset = 0;
+      std::uint32_t size = 0;
+      std::uint32_t alignment = 0;
+      bool live = false;
+   };
+
+   void insert_free_block(std::uint32_t offset, std::uint32_t size) noexcept;
+
+   void erase_free_block(const std::map<std::uint32_t, std::uint32_t>::iterator it) noexcept;
+
+   const std::uint32_t _capacity;
+   std::uint32_t _used = 0;
+   std::uint32_t _allocation_count = 0;
+
+   std::vector<Allocation> _allocations;
+   std::vector<Allocation_id> _free_ids;
+
+   // Free blocks keyed on offset, for coalescing neighbours on free.
+   std::map<std::uint32_t, std::uint32_t> _free_blocks;
+
+   // Free blocks keyed on (size, offset), for best fit allocation.
+   std::set<std::pair<std::uint32_t, std::uint32_t>> _free_blocks_by_size;
+};
+
+}
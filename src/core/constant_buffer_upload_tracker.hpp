@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace sp::core {
+
+// Tracks which registers of a constant buffer's CPU copy have been written
+// since it was last uploaded and keeps a copy of what was uploaded. Writes are
+// coalesced into one register range and at upload time only that range is
+// compared, letting uploads of unchanged contents be skipped. The buffers are
+// dynamic and rewritten whole (WRITE_DISCARD) so the range only bounds the
+// comparison, not the upload. Every write to the CPU copy must be marked,
+// unmarked writes are not compared and can be skipped.
+template<typename Buffer_struct>
+class Constant_buffer_upload_tracker {
+public:
+   static_assert(std::is_trivially_copyable_v<Buffer_struct>);
+
+   constexpr static std::uint32_t register_size = 16;
+   constexpr static std::uint32_t register_count =
+      (sizeof(Buffer_struct) + register_size - 1) / register_size;
+
+   struct Stats {
+      std::uint64_t uploads = 0;
+      std::uint64_t skipped = 0;
+   };
+
+   // Marks count registers starting at first_register as written.
+   void mark(const std::uint32_t first_register, const std::uint32_t count) noexcept
+   {
+      if (count == 0 || first_register >= register_count) return;
+
+      const std::uint32_t end =
+         first_register + std::min(count, register_count - first_register);
+
+      if (_dirty_begin == _dirty_end) {
+         _dirty_begin = first_register;
+         _dirty_end = end;
+      }
+      else {
+         _dirty_begin = std::min(_dirty_begin, first_register);
+         _dirty_end = std::max(_dirty_end, end);
+      }
+   }
+
+   // Marks the whole buffer as written, for fields set directly on the struct.
+   void mark_all() noexcept
+   {
+      _dirty_begin = 0;
+      _dirty_end = register_count;
+   }
+
+   bool dirty() const noexcept
+   {
+      return _dirty_begin != _dirty_end;
+   }
+
+   // Clears the written range and returns whether contents differ from the
+   // last upload. When they do they are recorded as uploaded, the caller must
+   // then upload them.
+   bool needs_upload(const Buffer_struct& contents) noexcept
+   {
+      if (!dirty()) return false;
+
+      const std::size_t begin = _dirty_begin * std::size_t{register_size};
+      const std::size_t end =
+         std::min(_dirty_end * std::size_t{register_size}, sizeof(Buffer_struct));
+
+      _dirty_begin = _dirty_end = 0;
+
+      const auto* const src = reinterpret_cast<const std::byte*>(&contents);
+      auto* const uploaded = reinterpret_cast<std::byte*>(&_uploaded_contents);
+
+      if (_uploaded && std::memcmp(uploaded + begin, src + begin, end - begin) == 0) {
+         _stats.skipped += 1;
+
+         return false;
+      }
+
+      // The whole buffer is uploaded so the copy must match all of it, not just
+      // the written range.
+      std::memcpy(uploaded, src, sizeof(Buffer_struct));
+
+      _uploaded = true;
+      _stats.uploads += 1;
+
+      return true;
+   }
+
+   // Forgets the uploaded contents, the next upload will not be skipped.
+   void invalidate() noexcept
+   {
+      _uploaded = false;
+
+      mark_all();
+   }
+
+   auto stats() const noexcept -> Stats
+   {
+      return _stats;
+   }
+
+private:
+   std::uint32_t _dirty_begin = 0;
+   std::uint32_t _dirty_end = register_count;
+   bool _uploaded = false;
+   Stats _stats;
+
+   Buffer_struct _uploaded_contents{};
+};
+
+}
@@ -0,0 +1,202 @@
+
+#include "draw_stream.hpp"
+#include "../logger.hpp"
+
+#include <fstream>
+
+namespace sp::core {
+
+namespace {
+
+constexpr auto payload_size(const Draw_stream_op op) noexcept -> std::size_t
+{
+   using namespace draw_stream;
+
+   switch (op) {
+   case Draw_stream_op::set_index_buffer:
+      return sizeof(Set_index_buffer);
+   case Draw_stream_op::set_vertex_buffer:
+      return sizeof(Set_vertex_buffer);
+   case Draw_stream_op::set_input_layout:
+      return sizeof(Set_input_layout);
+   case Draw_stream_op::set_game_shader:
+      return sizeof(Set_game_shader);
+   case Draw_stream_op::set_rendertarget:
+      return sizeof(Set_rendertarget);
+   case Draw_stream_op::set_depthstencil:
+      return sizeof(Set_depthstencil);
+   case Draw_stream_op::set_rasterizer_state:
+      return sizeof(Set_rasterizer_state);
+   case Draw_stream_op::set_depthstencil_state:
+      return sizeof(Set_depthstencil_state);
+   case Draw_stream_op::set_blend_state:
+      return sizeof(Set_blend_state);
+   case Draw_stream_op::set_fog_state:
+      return sizeof(Set_fog_state);
+   case Draw_stream_op::set_texture:
+      return sizeof(Set_texture);
+   case Draw_stream_op::set_patch_material:
+      return sizeof(Set_patch_material);
+   case Draw_stream_op::set_constants:
+      return sizeof(Set_constants);
+   case Draw_stream_op::draw:
+      return sizeof(Draw);
+   case Draw_stream_op::draw_indexed:
+      return sizeof(Draw_indexed);
+   case Draw_stream_op::clear_rendertarget:
+      return sizeof(Clear_rendertarget);
+   case Draw_stream_op::clear_depthstencil:
+      return sizeof(Clear_depthstencil);
+   case Draw_stream_op::set_projtex_mode:
+      return sizeof(Set_projtex_mode);
+   case Draw_stream_op::set_projtex_type:
+      return sizeof(Set_projtex_type);
+   case Draw_stream_op::set_projtex_cube:
+      return sizeof(Set_projtex_cube);
+   case Draw_stream_op::set_informal_projection_matrix:
+      return sizeof(Set_informal_projection_matrix);
+   case Draw_stream_op::set_informal_view_matrix:
+      return sizeof(Set_informal_view_matrix);
+   case Draw_stream_op::stretch_rendertarget:
+      return sizeof(Stretch_rendertarget);
+   case Draw_stream_op::color_fill_rendertarget:
+      return sizeof(Color_fill_rendertarget);
+   case Draw_stream_op::begin_query:
+      return sizeof(Begin_query);
+   case Draw_stream_op::end_query:
+      return sizeof(End_query);
+   case Draw_stream_op::update_ia_buffer:
+      return sizeof(Update_ia_buffer);
+   case Draw_stream_op::map_ia_buffer:
+      return sizeof(Map_ia_buffer);
+   case Draw_stream_op::unmap_ia_buffer:
+      return sizeof(Unmap_ia_buffer);
+   case Draw_stream_op::reset:
+      return sizeof(Reset);
+   case Draw_stream_op::present:
+   default:
+      return 0;
+   }
+}
+
+}
+
+Draw_stream_recorder::Draw_stream_recorder(const std::uint32_t frame_count) noexcept
+   : _frames_remaining{frame_count}
+{
+   _records.reserve(4194304);
+}
+
+void Draw_stream_recorder::record_constants(const Draw_stream_cb cb,
+                                            const std::uint32_t offset,
+                                            const std::span<const std::byte> constants) noexcept
+{
+   record(draw_stream::Set_constants{.cb = cb,
+                                     .offset = offset,
+                                     .size = static_cast<std::uint32_t>(
+                                        constants.size())});
+
+   _records.insert(_records.end(), constants.begin(), constants.end());
+}
+
+auto Draw_stream_recorder::object(const void* const pointer) noexcept -> Draw_stream_object
+{
+   if (!pointer) return draw_stream_null_object;
+
+   const auto [it, inserted] =
+      _objects.try_emplace(pointer, static_cast<Draw_stream_object>(_objects.size() + 1));
+
+   return it->second;
+}
+
+auto Draw_stream_recorder::stream() const noexcept -> std::vector<std::byte>
+{
+   Draw_stream_header header = _header;
+   header.object_count = static_cast<std::uint32_t>(_objects.size());
+
+   std::vector<std::byte> stream;
+   stream.resize(sizeof(Draw_stream_header) + _records.size());
+
+   std::memcpy(stream.data(), &header, sizeof(Draw_stream_header));
+   std::memcpy(stream.data() + sizeof(Draw_stream_header), _records.data(),
+               _records.size());
+
+   return stream;
+}
+
+void Draw_stream_recorder::save(const std::filesystem::path& path) const noexcept
+{
+   const auto data = stream();
+
+   std::error_code error;
+
+   std::filesystem::create_directories(path.parent_path(), error);
+
+   std::ofstream file{path, std::ios::binary};
+
+   file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+   if (!file) {
+      log(Log_level::error, "Failed to save draw stream to "sv, path.string());
+
+      return;
+   }
+
+   log(Log_level::info, "Saved draw stream to "sv, path.string());
+}
+
+Draw_stream_reader::Draw_stream_reader(const std::span<const std::byte> stream) noexcept
+{
+   if (stream.size() < sizeof(Draw_stream_header)) return;
+
+   std::memcpy(&_header, stream.data(), sizeof(Draw_stream_header));
+
+   if (_header.mn != "spds"_mn || _header.version != Draw_stream_header{}.version) {
+      return;
+   }
+
+   _records = stream.subspan(sizeof(Draw_stream_header));
+   _valid = true;
+}
+
+auto Draw_stream_reader::next() noexcept -> std::optional<Record>
+{
+   if (!_valid || _records.empty()) return std::nullopt;
+
+   const auto op = static_cast<Draw_stream_op>(_records[0]);
+
+   if (op >= Draw_stream_op::count) {
+      _valid = false;
+
+      return std::nullopt;
+   }
+
+   const std::size_t size = payload_size(op);
+
+   if (_records.size() < 1 + size) {
+      _valid = false;
+
+      return std::nullopt;
+   }
+
+   Record record{.op = op, .payload = _records.subspan(1, size)};
+
+   _records = _records.subspan(1 + size);
+
+   if (op == Draw_stream_op::set_constants) {
+      const auto constants = payload_as<draw_stream::Set_constants>(record);
+
+      if (_records.size() < constants.size) {
+         _valid = false;
+
+         return std::nullopt;
+      }
+
+      record.constants = _records.first(constants.size);
+      _records = _records.subspan(constants.size);
+   }
+
+   return record;
+}
+
+}
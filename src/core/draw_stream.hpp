@@ -0,0 +1,397 @@
+#pragma once
+
+#include "magic_number.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace sp::core {
+
+// A capture of the calls the game makes into Shader_patch's public interface,
+// kept free of any D3D11 types so saved streams can be read anywhere. Pointers
+// passed to the patch (buffers, states, textures, queries, materials) are
+// replaced by small ids numbered in the order the objects were first seen.
+// Written data (constants aside) is not captured, only its size.
+//
+// File layout is a Draw_stream_header followed by records, each a
+// Draw_stream_op byte followed by the op's payload struct. set_constants is
+// additionally followed by payload.size bytes of constant data.
+
+enum class Draw_stream_op : std::uint8_t {
+   set_index_buffer,
+   set_vertex_buffer,
+   set_input_layout,
+   set_game_shader,
+   set_rendertarget,
+   set_depthstencil,
+   set_rasterizer_state,
+   set_depthstencil_state,
+   set_blend_state,
+   set_fog_state,
+   set_texture,
+   set_patch_material,
+   set_constants,
+   draw,
+   draw_indexed,
+   clear_rendertarget,
+   clear_depthstencil,
+   present,
+   set_projtex_mode,
+   set_projtex_type,
+   set_projtex_cube,
+   set_informal_projection_matrix,
+   set_informal_view_matrix,
+   stretch_rendertarget,
+   color_fill_rendertarget,
+   begin_query,
+   end_query,
+   update_ia_buffer,
+   map_ia_buffer,
+   unmap_ia_buffer,
+   reset,
+
+   count
+};
+
+enum class Draw_stream_cb : std::uint8_t { scene, draw, fixedfunction, skin, draw_ps };
+
+using Draw_stream_object = std::uint32_t;
+
+constexpr Draw_stream_object draw_stream_null_object = 0;
+
+struct Draw_stream_header {
+   Magic_number mn = "spds"_mn;
+   std::uint32_t version = 2;
+   std::uint32_t frame_count = 0;
+   std::uint32_t object_count = 0;
+};
+
+namespace draw_stream {
+
+#pragma pack(push, 1)
+
+struct Set_index_buffer {
+   constexpr static auto op = Draw_stream_op::set_index_buffer;
+
+   Draw_stream_object buffer;
+   std::uint32_t offset;
+};
+
+struct Set_vertex_buffer {
+   constexpr static auto op = Draw_stream_op::set_vertex_buffer;
+
+   Draw_stream_object buffer;
+   std::uint32_t offset;
+   std::uint32_t stride;
+};
+
+struct Set_input_layout {
+   constexpr static auto op = Draw_stream_op::set_input_layout;
+
+   std::uint16_t layout_index;
+   bool compressed_position;
+   bool compressed_texcoords;
+   bool has_vertex_weights;
+};
+
+struct Set_game_shader {
+   constexpr static auto op = Draw_stream_op::set_game_shader;
+
+   std::uint32_t shader_index;
+};
+
+struct Set_rendertarget {
+   constexpr static auto op = Draw_stream_op::set_rendertarget;
+
+   std::int32_t rendertarget;
+};
+
+struct Set_depthstencil {
+   constexpr static auto op = Draw_stream_op::set_depthstencil;
+
+   std::uint8_t depthstencil;
+};
+
+struct Set_rasterizer_state {
+   constexpr static auto op = Draw_stream_op::set_rasterizer_state;
+
+   Draw_stream_object state;
+};
+
+struct Set_depthstencil_state {
+   constexpr static auto op = Draw_stream_op::set_depthstencil_state;
+
+   Draw_stream_object state;
+   std::uint8_t stencil_ref;
+   bool readonly;
+};
+
+struct Set_blend_state {
+   constexpr static auto op = Draw_stream_op::set_blend_state;
+
+   Draw_stream_object state;
+   bool additive_blending;
+};
+
+struct Set_fog_state {
+   constexpr static auto op = Draw_stream_op::set_fog_state;
+
+   bool enabled;
+   std::array<float, 4> color;
+};
+
+struct Set_texture {
+   constexpr static auto op = Draw_stream_op::set_texture;
+
+   std::uint8_t slot;
+   Draw_stream_object texture;
+   std::int32_t rendertarget; // -1 unless a rendertarget was bound as the texture.
+};
+
+struct Set_patch_material {
+   constexpr static auto op = Draw_stream_op::set_patch_material;
+
+   Draw_stream_object material;
+};
+
+struct Set_constants {
+   constexpr static auto op = Draw_stream_op::set_constants;
+
+   Draw_stream_cb cb;
+   std::uint32_t offset; // In bytes.
+   std::uint32_t size;
+};
+
+struct Draw {
+   constexpr static auto op = Draw_stream_op::draw;
+
+   std::uint8_t topology;
+   std::uint32_t vertex_count;
+   std::uint32_t start_vertex;
+};
+
+struct Draw_indexed {
+   constexpr static auto op = Draw_stream_op::draw_indexed;
+
+   std::uint8_t topology;
+   std::uint32_t index_count;
+   std::uint32_t start_index;
+   std::int32_t base_vertex;
+};
+
+struct Clear_rendertarget {
+   constexpr static auto op = Draw_stream_op::clear_rendertarget;
+
+   std::array<float, 4> color;
+};
+
+struct Clear_depthstencil {
+   constexpr static auto op = Draw_stream_op::clear_depthstencil;
+
+   float z;
+   std::uint8_t stencil;
+   bool clear_depth;
+   bool clear_stencil;
+};
+
+struct Present {
+   constexpr static auto op = Draw_stream_op::present;
+};
+
+struct Set_projtex_mode {
+   constexpr static auto op = Draw_stream_op::set_projtex_mode;
+
+   std::uint8_t mode;
+};
+
+struct Set_projtex_type {
+   constexpr static auto op = Draw_stream_op::set_projtex_type;
+
+   std::uint8_t type;
+};
+
+struct Set_projtex_cube {
+   constexpr static auto op = Draw_stream_op::set_projtex_cube;
+
+   Draw_stream_object texture;
+};
+
+struct Set_informal_projection_matrix {
+   constexpr static auto op = Draw_stream_op::set_informal_projection_matrix;
+
+   std::array<float, 16> matrix;
+};
+
+struct Set_informal_view_matrix {
+   constexpr static auto op = Draw_stream_op::set_informal_view_matrix;
+
+   std::array<float, 16> matrix;
+};
+
+struct Stretch_rendertarget {
+   constexpr static auto op = Draw_stream_op::stretch_rendertarget;
+
+   std::int32_t source;
+   std::array<double, 4> source_rect;
+   std::int32_t dest;
+   std::array<double, 4> dest_rect;
+};
+
+struct Color_fill_rendertarget {
+   constexpr static auto op = Draw_stream_op::color_fill_rendertarget;
+
+   std::int32_t rendertarget;
+   std::array<float, 4> color;
+   bool has_rect;
+   std::array<double, 4> rect;
+};
+
+struct Begin_query {
+   constexpr static auto op = Draw_stream_op::begin_query;
+
+   Draw_stream_object query;
+};
+
+struct End_query {
+   constexpr static auto op = Draw_stream_op::end_query;
+
+   Draw_stream_object query;
+};
+
+struct Update_ia_buffer {
+   constexpr static auto op = Draw_stream_op::update_ia_buffer;
+
+   Draw_stream_object buffer;
+   std::uint32_t offset;
+   std::uint32_t size;
+};
+
+struct Map_ia_buffer {
+   constexpr static auto op = Draw_stream_op::map_ia_buffer;
+
+   Draw_stream_object buffer;
+   std::uint8_t map_type;
+};
+
+struct Unmap_ia_buffer {
+   constexpr static auto op = Draw_stream_op::unmap_ia_buffer;
+
+   Draw_stream_object buffer;
+};
+
+struct Reset {
+   constexpr static auto op = Draw_stream_op::reset;
+
+   bool legacy_fullscreen;
+   bool aspect_ratio_hack;
+   std::uint32_t render_width;
+   std::uint32_t render_height;
+   std::uint32_t window_width;
+   std::uint32_t window_height;
+};
+
+#pragma pack(pop)
+
+}
+
+class Draw_stream_recorder {
+public:
+   explicit Draw_stream_recorder(const std::uint32_t frame_count) noexcept;
+
+   template<typename Payload>
+   void record(const Payload& payload) noexcept
+   {
+      static_assert(std::is_trivially_copyable_v<Payload>);
+
+      append(Payload::op);
+
+      if constexpr (!std::is_empty_v<Payload>) append(payload);
+
+      if constexpr (Payload::op == Draw_stream_op::present) {
+         _frames_remaining -= 1;
+         _header.frame_count += 1;
+      }
+   }
+
+   void record_constants(const Draw_stream_cb cb, const std::uint32_t offset,
+                         const std::span<const std::byte> constants) noexcept;
+
+   auto object(const void* const pointer) noexcept -> Draw_stream_object;
+
+   // Has every frame asked for been recorded?
+   bool done() const noexcept
+   {
+      return _frames_remaining == 0;
+   }
+
+   auto stream() const noexcept -> std::vector<std::byte>;
+
+   void save(const std::filesystem::path& path) const noexcept;
+
+private:
+   template<typename T>
+   void append(const T& value) noexcept
+   {
+      const auto offset = _records.size();
+
+      _records.resize(offset + sizeof(T));
+
+      std::memcpy(_records.data() + offset, &value, sizeof(T));
+   }
+
+   Draw_stream_header _header;
+   std::vector<std::byte> _records;
+   absl::flat_hash_map<const void*, Draw_stream_object> _objects;
+   std::uint32_t _frames_remaining;
+};
+
+// Walks the records of a stream. Returns nullopt once the end of the stream is
+// reached or if a record is truncated.
+class Draw_stream_reader {
+public:
+   struct Record {
+      Draw_stream_op op;
+      std::span<const std::byte> payload;
+      std::span<const std::byte> constants; // Only for set_constants.
+   };
+
+   explicit Draw_stream_reader(const std::span<const std::byte> stream) noexcept;
+
+   auto header() const noexcept -> const Draw_stream_header&
+   {
+      return _header;
+   }
+
+   bool valid() const noexcept
+   {
+      return _valid;
+   }
+
+   auto next() noexcept -> std::optional<Record>;
+
+   template<typename Payload>
+   static auto payload_as(const Record& record) noexcept -> Payload
+   {
+      Payload payload;
+
+      std::memcpy(&payload, record.payload.data(), sizeof(Payload));
+
+      return payload;
+   }
+
+private:
+   Draw_stream_header _header;
+   std::span<const std::byte> _records;
+   bool _valid = false;
+};
+
+}
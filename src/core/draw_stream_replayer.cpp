@@ -0,0 +1,489 @@
+#include "draw_stream_replayer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace sp::core {
+
+using namespace std::literals;
+
+namespace {
+
+template<typename Payload>
+auto payload_bytes(const Payload& payload) noexcept -> std::span<const std::byte>
+{
+   return std::as_bytes(std::span{&payload, 1});
+}
+
+template<typename Payload>
+auto as(const Draw_stream_reader::Record& record) noexcept -> Payload
+{
+   return Draw_stream_reader::payload_as<Payload>(record);
+}
+
+}
+
+auto replay_draw_stream(const std::span<const std::byte> stream,
+                        Draw_stream_target& target) noexcept -> Draw_stream_replay_stats
+{
+   using namespace draw_stream;
+
+   Draw_stream_replay_stats stats;
+   Draw_stream_reader reader{stream};
+
+   while (const auto record = reader.next()) {
+      stats.calls[static_cast<std::size_t>(record->op)] += 1;
+
+      bool replayed = true;
+
+      switch (record->op) {
+      case Draw_stream_op::set_index_buffer:
+         replayed = target.set_index_buffer(as<Set_index_buffer>(*record));
+         break;
+      case Draw_stream_op::set_vertex_buffer:
+         replayed = target.set_vertex_buffer(as<Set_vertex_buffer>(*record));
+         break;
+      case Draw_stream_op::set_input_layout:
+         replayed = target.set_input_layout(as<Set_input_layout>(*record));
+         break;
+      case Draw_stream_op::set_game_shader:
+         replayed = target.set_game_shader(as<Set_game_shader>(*record));
+         break;
+      case Draw_stream_op::set_rendertarget:
+         replayed = target.set_rendertarget(as<Set_rendertarget>(*record));
+         break;
+      case Draw_stream_op::set_depthstencil:
+         replayed = target.set_depthstencil(as<Set_depthstencil>(*record));
+         break;
+      case Draw_stream_op::set_rasterizer_state:
+         replayed = target.set_rasterizer_state(as<Set_rasterizer_state>(*record));
+         break;
+      case Draw_stream_op::set_depthstencil_state:
+         replayed = target.set_depthstencil_state(as<Set_depthstencil_state>(*record));
+         break;
+      case Draw_stream_op::set_blend_state:
+         replayed = target.set_blend_state(as<Set_blend_state>(*record));
+         break;
+      case Draw_stream_op::set_fog_state:
+         replayed = target.set_fog_state(as<Set_fog_state>(*record));
+         break;
+      case Draw_stream_op::set_texture:
+         replayed = target.set_texture(as<Set_texture>(*record));
+         break;
+      case Draw_stream_op::set_patch_material:
+         replayed = target.set_patch_material(as<Set_patch_material>(*record));
+         break;
+      case Draw_stream_op::set_constants:
+         replayed = target.set_constants(as<Set_constants>(*record), record->constants);
+         break;
+      case Draw_stream_op::draw:
+         replayed = target.draw(as<Draw>(*record));
+         stats.draws += replayed;
+         break;
+      case Draw_stream_op::draw_indexed:
+         replayed = target.draw_indexed(as<Draw_indexed>(*record));
+         stats.draws += replayed;
+         break;
+      case Draw_stream_op::clear_rendertarget:
+         replayed = target.clear_rendertarget(as<Clear_rendertarget>(*record));
+         break;
+      case Draw_stream_op::clear_depthstencil:
+         replayed = target.clear_depthstencil(as<Clear_depthstencil>(*record));
+         break;
+      case Draw_stream_op::present:
+         replayed = target.present();
+         stats.frames += 1;
+         break;
+      case Draw_stream_op::set_projtex_mode:
+         replayed = target.set_projtex_mode(as<Set_projtex_mode>(*record));
+         break;
+      case Draw_stream_op::set_projtex_type:
+         replayed = target.set_projtex_type(as<Set_projtex_type>(*record));
+         break;
+      case Draw_stream_op::set_projtex_cube:
+         replayed = target.set_projtex_cube(as<Set_projtex_cube>(*record));
+         break;
+      case Draw_stream_op::set_informal_projection_matrix:
+         replayed = target.set_informal_projection_matrix(
+            as<Set_informal_projection_matrix>(*record));
+         break;
+      case Draw_stream_op::set_informal_view_matrix:
+         replayed =
+            target.set_informal_view_matrix(as<Set_informal_view_matrix>(*record));
+         break;
+      case Draw_stream_op::stretch_rendertarget:
+         replayed = target.stretch_rendertarget(as<Stretch_rendertarget>(*record));
+         break;
+      case Draw_stream_op::color_fill_rendertarget:
+         replayed = target.color_fill_rendertarget(as<Color_fill_rendertarget>(*record));
+         break;
+      case Draw_stream_op::begin_query:
+         replayed = target.begin_query(as<Begin_query>(*record));
+         break;
+      case Draw_stream_op::end_query:
+         replayed = target.end_query(as<End_query>(*record));
+         break;
+      case Draw_stream_op::update_ia_buffer:
+         replayed = target.update_ia_buffer(as<Update_ia_buffer>(*record));
+         break;
+      case Draw_stream_op::map_ia_buffer:
+         replayed = target.map_ia_buffer(as<Map_ia_buffer>(*record));
+         break;
+      case Draw_stream_op::unmap_ia_buffer:
+         replayed = target.unmap_ia_buffer(as<Unmap_ia_buffer>(*record));
+         break;
+      case Draw_stream_op::reset:
+         replayed = target.reset(as<Reset>(*record));
+         break;
+      default:
+         replayed = false;
+         break;
+      }
+
+      if (!replayed) stats.skipped += 1;
+   }
+
+   stats.truncated = !reader.valid();
+
+   return stats;
+}
+
+template<typename Payload>
+void Counting_draw_stream_target::track(const Payload& payload) noexcept
+{
+   const auto bytes = payload_bytes(payload);
+   auto& last = _state.last[static_cast<std::size_t>(Payload::op)];
+
+   if (std::ranges::equal(last, bytes)) {
+      _redundant[static_cast<std::size_t>(Payload::op)] += 1;
+
+      return;
+   }
+
+   last.assign(bytes.begin(), bytes.end());
+}
+
+bool Counting_draw_stream_target::set_index_buffer(
+   const draw_stream::Set_index_buffer& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_vertex_buffer(
+   const draw_stream::Set_vertex_buffer& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_input_layout(
+   const draw_stream::Set_input_layout& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_game_shader(
+   const draw_stream::Set_game_shader& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_rendertarget(
+   const draw_stream::Set_rendertarget& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_depthstencil(
+   const draw_stream::Set_depthstencil& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_rasterizer_state(
+   const draw_stream::Set_rasterizer_state& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_depthstencil_state(
+   const draw_stream::Set_depthstencil_state& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_blend_state(
+   const draw_stream::Set_blend_state& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_fog_state(
+   const draw_stream::Set_fog_state& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_texture(
+   const draw_stream::Set_texture& args) noexcept
+{
+   auto& last = _state.textures[args.slot];
+
+   if (last && std::ranges::equal(payload_bytes(*last), payload_bytes(args))) {
+      _redundant[static_cast<std::size_t>(Draw_stream_op::set_texture)] += 1;
+
+      return true;
+   }
+
+   last = args;
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_patch_material(
+   const draw_stream::Set_patch_material& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_constants(
+   const draw_stream::Set_constants& args,
+   const std::span<const std::byte> constants) noexcept
+{
+   const auto cb = static_cast<std::size_t>(args.cb);
+
+   if (cb >= _state.constants.size()) return true;
+
+   auto& [data, written] = _state.constants[cb];
+
+   const std::size_t end = std::size_t{args.offset} + constants.size();
+
+   if (data.size() < end) {
+      data.resize(end);
+      written.resize(end);
+   }
+
+   const bool all_written =
+      std::all_of(written.begin() + args.offset, written.begin() + end,
+                  [](const bool b) { return b; });
+   const auto last = std::span{data}.subspan(args.offset, constants.size());
+
+   if (all_written && std::ranges::equal(last, constants)) {
+      _redundant[static_cast<std::size_t>(Draw_stream_op::set_constants)] += 1;
+
+      return true;
+   }
+
+   std::ranges::copy(constants, data.begin() + args.offset);
+   std::fill(written.begin() + args.offset, written.begin() + end, true);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::draw(const draw_stream::Draw&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::draw_indexed(const draw_stream::Draw_indexed&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::clear_rendertarget(
+   const draw_stream::Clear_rendertarget&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::clear_depthstencil(
+   const draw_stream::Clear_depthstencil&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::present() noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::set_projtex_mode(
+   const draw_stream::Set_projtex_mode& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_projtex_type(
+   const draw_stream::Set_projtex_type& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_projtex_cube(
+   const draw_stream::Set_projtex_cube& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_informal_projection_matrix(
+   const draw_stream::Set_informal_projection_matrix& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::set_informal_view_matrix(
+   const draw_stream::Set_informal_view_matrix& args) noexcept
+{
+   track(args);
+
+   return true;
+}
+
+bool Counting_draw_stream_target::stretch_rendertarget(
+   const draw_stream::Stretch_rendertarget&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::color_fill_rendertarget(
+   const draw_stream::Color_fill_rendertarget&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::begin_query(const draw_stream::Begin_query&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::end_query(const draw_stream::End_query&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::update_ia_buffer(
+   const draw_stream::Update_ia_buffer&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::map_ia_buffer(
+   const draw_stream::Map_ia_buffer&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::unmap_ia_buffer(
+   const draw_stream::Unmap_ia_buffer&) noexcept
+{
+   return true;
+}
+
+bool Counting_draw_stream_target::reset(const draw_stream::Reset&) noexcept
+{
+   // Nothing is bound after a reset so nothing that follows is redundant.
+   _state = {};
+
+   return true;
+}
+
+auto to_string(const Draw_stream_op op) noexcept -> std::string_view
+{
+   switch (op) {
+   case Draw_stream_op::set_index_buffer:
+      return "set_index_buffer"sv;
+   case Draw_stream_op::set_vertex_buffer:
+      return "set_vertex_buffer"sv;
+   case Draw_stream_op::set_input_layout:
+      return "set_input_layout"sv;
+   case Draw_stream_op::set_game_shader:
+      return "set_game_shader"sv;
+   case Draw_stream_op::set_rendertarget:
+      return "set_rendertarget"sv;
+   case Draw_stream_op::set_depthstencil:
+      return "set_depthstencil"sv;
+   case Draw_stream_op::set_rasterizer_state:
+      return "set_rasterizer_state"sv;
+   case Draw_stream_op::set_depthstencil_state:
+      return "set_depthstencil_state"sv;
+   case Draw_stream_op::set_blend_state:
+      return "set_blend_state"sv;
+   case Draw_stream_op::set_fog_state:
+      return "set_fog_state"sv;
+   case Draw_stream_op::set_texture:
+      return "set_texture"sv;
+   case Draw_stream_op::set_patch_material:
+      return "set_patch_material"sv;
+   case Draw_stream_op::set_constants:
+      return "set_constants"sv;
+   case Draw_stream_op::draw:
+      return "draw"sv;
+   case Draw_stream_op::draw_indexed:
+      return "draw_indexed"sv;
+   case Draw_stream_op::clear_rendertarget:
+      return "clear_rendertarget"sv;
+   case Draw_stream_op::clear_depthstencil:
+      return "clear_depthstencil"sv;
+   case Draw_stream_op::present:
+      return "present"sv;
+   case Draw_stream_op::set_projtex_mode:
+      return "set_projtex_mode"sv;
+   case Draw_stream_op::set_projtex_type:
+      return "set_projtex_type"sv;
+   case Draw_stream_op::set_projtex_cube:
+      return "set_projtex_cube"sv;
+   case Draw_stream_op::set_informal_projection_matrix:
+      return "set_informal_projection_matrix"sv;
+   case Draw_stream_op::set_informal_view_matrix:
+      return "set_informal_view_matrix"sv;
+   case Draw_stream_op::stretch_rendertarget:
+      return "stretch_rendertarget"sv;
+   case Draw_stream_op::color_fill_rendertarget:
+      return "color_fill_rendertarget"sv;
+   case Draw_stream_op::begin_query:
+      return "begin_query"sv;
+   case Draw_stream_op::end_query:
+      return "end_query"sv;
+   case Draw_stream_op::update_ia_buffer:
+      return "update_ia_buffer"sv;
+   case Draw_stream_op::map_ia_buffer:
+      return "map_ia_buffer"sv;
+   case Draw_stream_op::unmap_ia_buffer:
+      return "unmap_ia_buffer"sv;
+   case Draw_stream_op::reset:
+      return "reset"sv;
+   default:
+      return "unknown"sv;
+   }
+}
+
+}
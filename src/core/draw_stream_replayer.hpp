@@ -0,0 +1,218 @@
+#pragma once
+
+#include "draw_stream.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sp::core {
+
+// What a draw stream is replayed into. Each call returns false if it could not
+// be replayed, because it refers to something that no longer exists for
+// instance. Kept free of D3D11 so streams can be replayed anywhere.
+class Draw_stream_target {
+public:
+   virtual ~Draw_stream_target() = default;
+
+   virtual bool set_index_buffer(const draw_stream::Set_index_buffer& args) noexcept = 0;
+
+   virtual bool set_vertex_buffer(
+      const draw_stream::Set_vertex_buffer& args) noexcept = 0;
+
+   virtual bool set_input_layout(const draw_stream::Set_input_layout& args) noexcept = 0;
+
+   virtual bool set_game_shader(const draw_stream::Set_game_shader& args) noexcept = 0;
+
+   virtual bool set_rendertarget(const draw_stream::Set_rendertarget& args) noexcept = 0;
+
+   virtual bool set_depthstencil(const draw_stream::Set_depthstencil& args) noexcept = 0;
+
+   virtual bool set_rasterizer_state(
+      const draw_stream::Set_rasterizer_state& args) noexcept = 0;
+
+   virtual bool set_depthstencil_state(
+      const draw_stream::Set_depthstencil_state& args) noexcept = 0;
+
+   virtual bool set_blend_state(const draw_stream::Set_blend_state& args) noexcept = 0;
+
+   virtual bool set_fog_state(const draw_stream::Set_fog_state& args) noexcept = 0;
+
+   virtual bool set_texture(const draw_stream::Set_texture& args) noexcept = 0;
+
+   virtual bool set_patch_material(
+      const draw_stream::Set_patch_material& args) noexcept = 0;
+
+   virtual bool set_constants(const draw_stream::Set_constants& args,
+                              const std::span<const std::byte> constants) noexcept = 0;
+
+   virtual bool draw(const draw_stream::Draw& args) noexcept = 0;
+
+   virtual bool draw_indexed(const draw_stream::Draw_indexed& args) noexcept = 0;
+
+   virtual bool clear_rendertarget(
+      const draw_stream::Clear_rendertarget& args) noexcept = 0;
+
+   virtual bool clear_depthstencil(
+      const draw_stream::Clear_depthstencil& args) noexcept = 0;
+
+   virtual bool present() noexcept = 0;
+
+   virtual bool set_projtex_mode(const draw_stream::Set_projtex_mode& args) noexcept = 0;
+
+   virtual bool set_projtex_type(const draw_stream::Set_projtex_type& args) noexcept = 0;
+
+   virtual bool set_projtex_cube(const draw_stream::Set_projtex_cube& args) noexcept = 0;
+
+   virtual bool set_informal_projection_matrix(
+      const draw_stream::Set_informal_projection_matrix& args) noexcept = 0;
+
+   virtual bool set_informal_view_matrix(
+      const draw_stream::Set_informal_view_matrix& args) noexcept = 0;
+
+   virtual bool stretch_rendertarget(
+      const draw_stream::Stretch_rendertarget& args) noexcept = 0;
+
+   virtual bool color_fill_rendertarget(
+      const draw_stream::Color_fill_rendertarget& args) noexcept = 0;
+
+   virtual bool begin_query(const draw_stream::Begin_query& args) noexcept = 0;
+
+   virtual bool end_query(const draw_stream::End_query& args) noexcept = 0;
+
+   virtual bool update_ia_buffer(const draw_stream::Update_ia_buffer& args) noexcept = 0;
+
+   virtual bool map_ia_buffer(const draw_stream::Map_ia_buffer& args) noexcept = 0;
+
+   virtual bool unmap_ia_buffer(const draw_stream::Unmap_ia_buffer& args) noexcept = 0;
+
+   virtual bool reset(const draw_stream::Reset& args) noexcept = 0;
+};
+
+using Draw_stream_op_counts =
+   std::array<std::uint64_t, static_cast<std::size_t>(Draw_stream_op::count)>;
+
+struct Draw_stream_replay_stats {
+   std::uint32_t frames = 0;
+   std::uint64_t draws = 0;
+   Draw_stream_op_counts calls{};
+
+   // Calls the target could not replay.
+   std::uint64_t skipped = 0;
+
+   bool truncated = false;
+};
+
+// Feeds every record of the stream to the target in order.
+auto replay_draw_stream(const std::span<const std::byte> stream,
+                        Draw_stream_target& target) noexcept -> Draw_stream_replay_stats;
+
+// Counts the calls in a stream that set exactly the state the previous call
+// of the same kind did, the calls Shader_patch's dirty tracking exists to
+// filter out. Constants are compared byte for byte against what was last set.
+// Nothing is ever skipped.
+class Counting_draw_stream_target final : public Draw_stream_target {
+public:
+   auto redundant() const noexcept -> const Draw_stream_op_counts&
+   {
+      return _redundant;
+   }
+
+   bool set_index_buffer(const draw_stream::Set_index_buffer& args) noexcept override;
+
+   bool set_vertex_buffer(const draw_stream::Set_vertex_buffer& args) noexcept override;
+
+   bool set_input_layout(const draw_stream::Set_input_layout& args) noexcept override;
+
+   bool set_game_shader(const draw_stream::Set_game_shader& args) noexcept override;
+
+   bool set_rendertarget(const draw_stream::Set_rendertarget& args) noexcept override;
+
+   bool set_depthstencil(const draw_stream::Set_depthstencil& args) noexcept override;
+
+   bool set_rasterizer_state(
+      const draw_stream::Set_rasterizer_state& args) noexcept override;
+
+   bool set_depthstencil_state(
+      const draw_stream::Set_depthstencil_state& args) noexcept override;
+
+   bool set_blend_state(const draw_stream::Set_blend_state& args) noexcept override;
+
+   bool set_fog_state(const draw_stream::Set_fog_state& args) noexcept override;
+
+   bool set_texture(const draw_stream::Set_texture& args) noexcept override;
+
+   bool set_patch_material(const draw_stream::Set_patch_material& args) noexcept override;
+
+   bool set_constants(const draw_stream::Set_constants& args,
+                      const std::span<const std::byte> constants) noexcept override;
+
+   bool draw(const draw_stream::Draw& args) noexcept override;
+
+   bool draw_indexed(const draw_stream::Draw_indexed& args) noexcept override;
+
+   bool clear_rendertarget(const draw_stream::Clear_rendertarget& args) noexcept override;
+
+   bool clear_depthstencil(const draw_stream::Clear_depthstencil& args) noexcept override;
+
+   bool present() noexcept override;
+
+   bool set_projtex_mode(const draw_stream::Set_projtex_mode& args) noexcept override;
+
+   bool set_projtex_type(const draw_stream::Set_projtex_type& args) noexcept override;
+
+   bool set_projtex_cube(const draw_stream::Set_projtex_cube& args) noexcept override;
+
+   bool set_informal_projection_matrix(
+      const draw_stream::Set_informal_projection_matrix& args) noexcept override;
+
+   bool set_informal_view_matrix(
+      const draw_stream::Set_informal_view_matrix& args) noexcept override;
+
+   bool stretch_rendertarget(
+      const draw_stream::Stretch_rendertarget& args) noexcept override;
+
+   bool color_fill_rendertarget(
+      const draw_stream::Color_fill_rendertarget& args) noexcept override;
+
+   bool begin_query(const draw_stream::Begin_query& args) noexcept override;
+
+   bool end_query(const draw_stream::End_query& args) noexcept override;
+
+   bool update_ia_buffer(const draw_stream::Update_ia_buffer& args) noexcept override;
+
+   bool map_ia_buffer(const draw_stream::Map_ia_buffer& args) noexcept override;
+
+   bool unmap_ia_buffer(const draw_stream::Unmap_ia_buffer& args) noexcept override;
+
+   bool reset(const draw_stream::Reset& args) noexcept override;
+
+private:
+   // The last payload of every op, texture slots each get their own.
+   struct State {
+      std::array<std::vector<std::byte>, static_cast<std::size_t>(Draw_stream_op::count)>
+         last;
+      std::array<std::optional<draw_stream::Set_texture>, 256> textures;
+
+      struct Constants {
+         std::vector<std::byte> data;
+         std::vector<bool> written;
+      };
+
+      std::array<Constants, 5> constants;
+   };
+
+   template<typename Payload>
+   void track(const Payload& payload) noexcept;
+
+   State _state;
+   Draw_stream_op_counts _redundant{};
+};
+
+auto to_string(const Draw_stream_op op) noexcept -> std::string_view;
+
+}
@@ -0,0 +1,196 @@
+
+#include "game_buffer_arena.hpp"
+#include "../logger.hpp"
+
+#include <algorithm>
+
+#include <comdef.h>
+
+namespace sp::core {
+
+namespace {
+
+constexpr UINT page_size = 8 * 1024 * 1024;
+constexpr UINT dedicated_page_threshold = 1024 * 1024;
+constexpr UINT allocation_alignment = 16;
+
+// Below these compacting a page isn't worth the copy.
+constexpr float defragment_fragmentation_threshold = 0.5f;
+constexpr std::uint32_t defragment_free_block_threshold = 64;
+
+}
+
+Game_buffer_arena::Game_buffer_arena(Com_ptr<ID3D11Device5> device) noexcept
+   : _device{std::move(device)}
+{
+}
+
+auto Game_buffer_arena::allocate(const UINT size) noexcept -> Game_buffer
+{
+   if (size > dedicated_page_threshold) {
+      const auto page_index = create_page(size, true);
+
+      return {.page = page_index,
+              .allocation = *_pages[page_index]->allocator.allocate(size, allocation_alignment)};
+   }
+
+   for (std::uint32_t i = 0; i < _pages.size(); ++i) {
+      auto& page = _pages[i];
+
+      if (!page || page->dedicated) continue;
+
+      if (const auto allocation = page->allocator.allocate(size, allocation_alignment);
+          allocation) {
+         return {.page = i, .allocation = *allocation};
+      }
+   }
+
+   const auto page_index = create_page(page_size, false);
+
+   return {.page = page_index,
+           .allocation = *_pages[page_index]->allocator.allocate(size, allocation_alignment)};
+}
+
+void Game_buffer_arena::free(const Game_buffer& buffer) noexcept
+{
+   auto& page = _pages[buffer.page];
+
+   page->allocator.free(buffer.allocation);
+
+   if (!page->allocator.empty()) return;
+
+   // Keep one shared page around so a level load doesn't start by
+   // recreating it.
+   const bool last_shared_page =
+      !page->dedicated && std::ranges::count_if(_pages, [](const auto& other) {
+                             return other && !other->dedicated;
+                          }) == 1;
+
+   if (!last_shared_page) page = nullptr;
+}
+
+void Game_buffer_arena::update(ID3D11DeviceContext1& dc, const Game_buffer& buffer,
+                               const UINT offset, const UINT size,
+                               const std::byte* data) noexcept
+{
+   const auto [d3d11_buffer, buffer_offset] = resolve(buffer);
+
+   const D3D11_BOX box{buffer_offset + offset, 0, 0, buffer_offset + offset + size, 1, 1};
+
+   dc.UpdateSubresource(d3d11_buffer, 0, &box, data, 0, 0);
+}
+
+bool Game_buffer_arena::defragment(ID3D11DeviceContext1& dc) noexcept
+{
+   Page* worst_page = nullptr;
+   float worst_fragmentation = defragment_fragmentation_threshold;
+
+   for (auto& page : _pages) {
+      if (!page || page->dedicated) continue;
+
+      const auto stats = page->allocator.stats();
+
+      if (stats.free_block_count < defragment_free_block_threshold) continue;
+
+      if (const float fragmentation = stats.fragmentation();
+          fragmentation > worst_fragmentation) {
+         worst_page = page.get();
+         worst_fragmentation = fragmentation;
+      }
+   }
+
+   if (!worst_page) return false;
+
+   // Copy into a fresh buffer rather than sliding things down inside the old
+   // one, copies within a buffer can not overlap.
+   auto new_buffer = create_buffer(worst_page->allocator.capacity());
+
+   const auto relocations = worst_page->allocator.defragment();
+
+   for (auto it = relocations.begin(); it != relocations.end();) {
+      const UINT source_offset = it->old_offset;
+      const UINT dest_offset = it->new_offset;
+      UINT size = it->size;
+
+      // Allocations that stay next to each other can be copied together.
+      for (++it; it != relocations.end(); ++it) {
+         if (it->old_offset != source_offset + size || it->new_offset != dest_offset + size) {
+            break;
+         }
+
+         size += it->size;
+      }
+
+      const D3D11_BOX box{source_offset, 0, 0, source_offset + size, 1, 1};
+
+      dc.CopySubresourceRegion(new_buffer.get(), 0, dest_offset, 0, 0,
+                               worst_page->buffer.get(), 0, &box);
+   }
+
+   worst_page->buffer = std::move(new_buffer);
+
+   return true;
+}
+
+auto Game_buffer_arena::stats() const noexcept -> Stats
+{
+   Stats stats;
+
+   for (const auto& page : _pages) {
+      if (!page) continue;
+
+      const auto page_stats = page->allocator.stats();
+
+      stats.page_count += 1;
+      stats.dedicated_page_count += page->dedicated;
+      stats.capacity += page_stats.capacity;
+      stats.used += page_stats.used;
+      stats.allocation_count += page_stats.allocation_count;
+      stats.free_block_count += page_stats.free_block_count;
+
+      if (!page->dedicated) {
+         stats.worst_fragmentation =
+            std::max(stats.worst_fragmentation, page_stats.fragmentation());
+      }
+   }
+
+   return stats;
+}
+
+auto Game_buffer_arena::create_page(const UINT capacity, const bool dedicated) noexcept
+   -> std::uint32_t
+{
+   auto page = std::make_unique<Page>(Page{.buffer = create_buffer(capacity),
+                                           .allocator = Buffer_suballocator{capacity},
+                                           .dedicated = dedicated});
+
+   if (auto empty_slot = std::ranges::find(_pages, nullptr); empty_slot != _pages.end()) {
+      *empty_slot = std::move(page);
+
+      return static_cast<std::uint32_t>(empty_slot - _pages.begin());
+   }
+
+   _pages.push_back(std::move(page));
+
+   return static_cast<std::uint32_t>(_pages.size() - 1);
+}
+
+auto Game_buffer_arena::create_buffer(const UINT size) noexcept -> Com_ptr<ID3D11Buffer>
+{
+   Com_ptr<ID3D11Buffer> buffer;
+
+   const auto desc =
+      CD3D11_BUFFER_DESC{size, D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_INDEX_BUFFER,
+                         D3D11_USAGE_DEFAULT, 0};
+
+   if (const auto result =
+          _device->CreateBuffer(&desc, nullptr, buffer.clear_and_assign());
+       FAILED(result)) {
+      log_and_terminate("Failed to create game IA buffer arena page! reason: ",
+                        _com_error{result}.ErrorMessage());
+   }
+
+   return buffer;
+}
+
+}
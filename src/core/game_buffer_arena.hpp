@@ -0,0 +1,86 @@
+#pragma once
+
+#include "buffer_suballocator.hpp"
+#include "com_ptr.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <d3d11_4.h>
+
+namespace sp::core {
+
+// A static game vertex or index buffer living in a Game_buffer_arena.
+struct Game_buffer {
+   constexpr static std::uint32_t no_page = 0xffffffffu;
+
+   std::uint32_t page = no_page;
+   Buffer_suballocator::Allocation_id allocation{};
+
+   bool valid() const noexcept
+   {
+      return page != no_page;
+   }
+
+   bool operator==(const Game_buffer&) const noexcept = default;
+};
+
+// Suballocates the game's static vertex and index buffers out of a few large
+// D3D11 buffers instead of creating one D3D11 buffer for each.
+class Game_buffer_arena {
+public:
+   struct Stats {
+      std::uint32_t page_count = 0;
+      std::uint32_t dedicated_page_count = 0;
+      std::uint64_t capacity = 0;
+      std::uint64_t used = 0;
+      std::uint32_t allocation_count = 0;
+      std::uint32_t free_block_count = 0;
+      float worst_fragmentation = 0.0f;
+   };
+
+   explicit Game_buffer_arena(Com_ptr<ID3D11Device5> device) noexcept;
+
+   auto allocate(const UINT size) noexcept -> Game_buffer;
+
+   void free(const Game_buffer& buffer) noexcept;
+
+   void update(ID3D11DeviceContext1& dc, const Game_buffer& buffer, const UINT offset,
+               const UINT size, const std::byte* data) noexcept;
+
+   // Returns the D3D11 buffer and offset into it to bind the game buffer with.
+   auto resolve(const Game_buffer& buffer) const noexcept -> std::pair<ID3D11Buffer*, UINT>
+   {
+      const auto& page = *_pages[buffer.page];
+
+      return {page.buffer.get(), page.allocator.offset(buffer.allocation)};
+   }
+
+   // Compacts the worst fragmented page if it has gotten bad enough to be
+   // worth it. Returns true if a page was compacted, in which case any
+   // previously resolved buffer or offset may now be stale.
+   bool defragment(ID3D11DeviceContext1& dc) noexcept;
+
+   auto stats() const noexcept -> Stats;
+
+private:
+   struct Page {
+      Com_ptr<ID3D11Buffer> buffer;
+      Buffer_suballocator allocator;
+      bool dedicated = false;
+   };
+
+   auto create_page(const UINT capacity, const bool dedicated) noexcept -> std::uint32_t;
+
+   auto create_buffer(const UINT size) noexcept -> Com_ptr<ID3D11Buffer>;
+
+   const Com_ptr<ID3D11Device5> _device;
+
+   // Freed pages leave behind an empty slot so page indices stay stable.
+   std::vector<std::unique_ptr<Page>> _pages;
+};
+
+}
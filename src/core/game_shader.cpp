@@ -28,6 +28,7 @@ auto make_game_shader(shader::Rendertypes_database& database,
                       .rendertype = metadata.rendertype,
                       .srgb_state = metadata.srgb_state,
                       .shader_name = std::string{metadata.shader_name},
+                      .state_id = *database.state_name_id(metadata.shader_name),
                       .vertex_shader_flags = metadata.vertex_shader_flags,
                       .input_layouts = {std::move(vs_inputlayout),
                                         std::move(vs_bytecode)}};
@@ -25,6 +25,7 @@ struct Game_shader {
    const Rendertype rendertype;
    const std::array<bool, 4> srgb_state;
    const std::string shader_name;
+   const shader::State_name_id state_id;
    const shader::Vertex_shader_flags vertex_shader_flags;
 
    Shader_input_layouts input_layouts;
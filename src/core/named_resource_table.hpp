@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace sp::core {
+
+// Resources by name for Shader_resource_database. Resource is an owning
+// pointer (Com_ptr in the patch), resources are looked up and erased by the
+// raw pointer it holds.
+template<typename Resource>
+class Named_resource_table {
+public:
+   using Pointer = decltype(std::declval<const Resource&>().get());
+
+   // Creates the resource on first use. Returning null drops the resource.
+   using Deferred_load = std::function<Resource()>;
+
+   using const_iterator =
+      typename std::vector<std::pair<Resource, std::string>>::const_iterator;
+
+   Named_resource_table()
+   {
+      _resources.reserve(1024);
+   }
+
+   // Runs the name's deferred load if it has one and the resource hasn't been
+   // created yet. Returns nullptr if there is no resource with the name.
+   auto find(const std::string_view name) noexcept -> Pointer
+   {
+      if (auto it = std::ranges::find(_resources, name, &Entry::second);
+          it != _resources.end()) {
+         return it->first.get();
+      }
+
+      return load_deferred(name);
+   }
+
+   auto reverse_lookup(const Pointer resource) const noexcept
+      -> std::optional<std::string_view>
+   {
+      if (auto it = find_resource(resource); it != _resources.end()) return it->second;
+
+      return std::nullopt;
+   }
+
+   // Bumped whenever what a name looks up to may have changed.
+   auto generation() const noexcept -> std::uint64_t
+   {
+      return _generation;
+   }
+
+   // Adds the resource, replacing any existing or deferred one with the name.
+   void insert(Resource resource, std::string name) noexcept
+   {
+      _deferred.erase(name);
+      _generation += 1;
+
+      if (auto it = std::ranges::find(_resources, name, &Entry::second);
+          it != _resources.end()) {
+         it->first = std::move(resource);
+
+         return;
+      }
+
+      _resources.emplace_back(std::move(resource), std::move(name));
+   }
+
+   // Ignored if a resource with the name already exists.
+   void insert_deferred(Deferred_load load, const std::string_view name) noexcept
+   {
+      if (std::ranges::find(_resources, name, &Entry::second) != _resources.end()) {
+         return;
+      }
+
+      _deferred.insert_or_assign(std::string{name}, std::move(load));
+      _generation += 1;
+   }
+
+   // Returns false if the resource is not in the table.
+   bool erase(const Pointer resource) noexcept
+   {
+      auto it = find_resource(resource);
+
+      if (it == _resources.end()) return false;
+
+      _resources.erase(it);
+      _generation += 1;
+
+      return true;
+   }
+
+   void load_all_deferred() noexcept
+   {
+      while (!_deferred.empty()) {
+         load_deferred(std::string{_deferred.begin()->first});
+      }
+   }
+
+   auto begin() const noexcept -> const_iterator
+   {
+      return _resources.cbegin();
+   }
+
+   auto end() const noexcept -> const_iterator
+   {
+      return _resources.cend();
+   }
+
+private:
+   using Entry = std::pair<Resource, std::string>;
+
+   struct Hash {
+      using is_transparent = void;
+
+      auto operator()(const std::string_view name) const noexcept -> std::size_t
+      {
+         return absl::Hash<std::string_view>{}(name);
+      }
+   };
+
+   auto find_resource(const Pointer resource) const noexcept
+   {
+      return std::ranges::find_if(_resources, [resource](const Entry& entry) {
+         return entry.first.get() == resource;
+      });
+   }
+
+   auto load_deferred(const std::string_view name) noexcept -> Pointer
+   {
+      auto it = _deferred.find(name);
+
+      if (it == _deferred.end()) return nullptr;
+
+      const auto load = std::move(it->second);
+
+      _deferred.erase(it);
+
+      auto resource = load();
+
+      if (!resource) return nullptr;
+
+      return _resources.emplace_back(std::move(resource), std::string{name}).first.get();
+   }
+
+   std::vector<Entry> _resources;
+   absl::flat_hash_map<std::string, Deferred_load, Hash, std::equal_to<>> _deferred;
+   std::uint64_t _generation = 0;
+};
+
+}
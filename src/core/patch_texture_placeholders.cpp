@@ -0,0 +1,132 @@
+
+#include "patch_texture_placeholders.hpp"
+#include "../logger.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include <comdef.h>
+
+namespace sp::core {
+
+namespace {
+
+constexpr auto placeholder_format = DXGI_FORMAT_R8G8B8A8_UNORM;
+constexpr std::uint32_t placeholder_colour = 0xff808080u;
+
+}
+
+Patch_texture_placeholders::Patch_texture_placeholders(ID3D11Device5& device) noexcept
+   : _device{device}
+{
+   const std::array<std::uint32_t, 6> texels{
+      placeholder_colour, placeholder_colour, placeholder_colour,
+      placeholder_colour, placeholder_colour, placeholder_colour};
+
+   std::array<D3D11_SUBRESOURCE_DATA, 6> init_data;
+
+   init_data.fill({.pSysMem = texels.data(),
+                   .SysMemPitch = sizeof(std::uint32_t),
+                   .SysMemSlicePitch = sizeof(std::uint32_t)});
+
+   const D3D11_TEXTURE1D_DESC desc_1d{.Width = 1,
+                                      .MipLevels = 1,
+                                      .ArraySize = 1,
+                                      .Format = placeholder_format,
+                                      .Usage = D3D11_USAGE_IMMUTABLE,
+                                      .BindFlags = D3D11_BIND_SHADER_RESOURCE};
+
+   const D3D11_TEXTURE2D_DESC desc_2d{.Width = 1,
+                                      .Height = 1,
+                                      .MipLevels = 1,
+                                      .ArraySize = 1,
+                                      .Format = placeholder_format,
+                                      .SampleDesc = {1, 0},
+                                      .Usage = D3D11_USAGE_IMMUTABLE,
+                                      .BindFlags = D3D11_BIND_SHADER_RESOURCE};
+
+   const D3D11_TEXTURE3D_DESC desc_3d{.Width = 1,
+                                      .Height = 1,
+                                      .Depth = 1,
+                                      .MipLevels = 1,
+                                      .Format = placeholder_format,
+                                      .Usage = D3D11_USAGE_IMMUTABLE,
+                                      .BindFlags = D3D11_BIND_SHADER_RESOURCE};
+
+   D3D11_TEXTURE2D_DESC desc_cube = desc_2d;
+   desc_cube.ArraySize = 6;
+   desc_cube.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+
+   if (FAILED(device.CreateTexture1D(&desc_1d, init_data.data(),
+                                     _texture1d.clear_and_assign())) ||
+       FAILED(device.CreateTexture2D(&desc_2d, init_data.data(),
+                                     _texture2d.clear_and_assign())) ||
+       FAILED(device.CreateTexture3D(&desc_3d, init_data.data(),
+                                     _texture3d.clear_and_assign())) ||
+       FAILED(device.CreateTexture2D(&desc_cube, init_data.data(),
+                                     _texturecube.clear_and_assign()))) {
+      log_and_terminate("Failed to create patch texture placeholders!"sv);
+   }
+}
+
+auto Patch_texture_placeholders::create_view(const Texture_type type) const noexcept
+   -> Com_ptr<ID3D11ShaderResourceView>
+{
+   D3D11_SHADER_RESOURCE_VIEW_DESC desc{.Format = placeholder_format};
+   ID3D11Resource* resource = nullptr;
+
+   switch (type) {
+   case Texture_type::texture1d:
+      desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE1D;
+      desc.Texture1D = {.MostDetailedMip = 0, .MipLevels = 1};
+      resource = _texture1d.get();
+      break;
+   case Texture_type::texture1darray:
+      desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE1DARRAY;
+      desc.Texture1DArray = {.MostDetailedMip = 0, .MipLevels = 1, .ArraySize = 1};
+      resource = _texture1d.get();
+      break;
+   case Texture_type::texture2d:
+      desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+      desc.Texture2D = {.MostDetailedMip = 0, .MipLevels = 1};
+      resource = _texture2d.get();
+      break;
+   case Texture_type::texture2darray:
+      desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+      desc.Texture2DArray = {.MostDetailedMip = 0, .MipLevels = 1, .ArraySize = 1};
+      resource = _texture2d.get();
+      break;
+   case Texture_type::texture3d:
+      desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE3D;
+      desc.Texture3D = {.MostDetailedMip = 0, .MipLevels = 1};
+      resource = _texture3d.get();
+      break;
+   case Texture_type::texturecube:
+      desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+      desc.TextureCube = {.MostDetailedMip = 0, .MipLevels = 1};
+      resource = _texturecube.get();
+      break;
+   case Texture_type::texturecubearray:
+      desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBEARRAY;
+      desc.TextureCubeArray = {.MostDetailedMip = 0, .MipLevels = 1, .NumCubes = 1};
+      resource = _texturecube.get();
+      break;
+   default:
+      return nullptr;
+   }
+
+   Com_ptr<ID3D11ShaderResourceView> srv;
+
+   if (const auto result =
+          _device.CreateShaderResourceView(resource, &desc, srv.clear_and_assign());
+       FAILED(result)) {
+      log(Log_level::error, "Failed to create patch texture placeholder SRV! reason: "sv,
+          _com_error{result}.ErrorMessage());
+
+      return nullptr;
+   }
+
+   return srv;
+}
+
+}
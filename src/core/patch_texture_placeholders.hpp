@@ -0,0 +1,29 @@
+#pragma once
+
+#include "com_ptr.hpp"
+#include "patch_texture_io.hpp"
+
+#include <d3d11_4.h>
+
+namespace sp::core {
+
+// Grey 1x1 stand-ins bound under a patch texture's name while it loads. Every
+// view returned is a new SRV so placeholders can be told apart by pointer in
+// the shader resource database.
+class Patch_texture_placeholders {
+public:
+   explicit Patch_texture_placeholders(ID3D11Device5& device) noexcept;
+
+   auto create_view(const Texture_type type) const noexcept
+      -> Com_ptr<ID3D11ShaderResourceView>;
+
+private:
+   ID3D11Device5& _device;
+
+   Com_ptr<ID3D11Texture1D> _texture1d;
+   Com_ptr<ID3D11Texture2D> _texture2d;
+   Com_ptr<ID3D11Texture3D> _texture3d;
+   Com_ptr<ID3D11Texture2D> _texturecube;
+};
+
+}
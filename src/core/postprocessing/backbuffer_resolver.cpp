@@ -190,7 +190,10 @@ void Backbuffer_resolver::resolve_input(
 auto Backbuffer_resolver::get_blue_noise_texture(const Interfaces& interfaces) noexcept
    -> ID3D11ShaderResourceView*
 {
-   if (_blue_noise_srvs[0] == nullptr) {
+   if (_blue_noise_srvs[0] == nullptr ||
+       _blue_noise_generation != interfaces.resources.generation()) {
+      _blue_noise_generation = interfaces.resources.generation();
+
       for (int i = 0; i < 64; ++i) {
          _blue_noise_srvs[i] = interfaces.resources.at_if(
             "_SP_BUILTIN_blue_noise_rgb_"s + std::to_string(i));
@@ -73,6 +73,7 @@ private:
    const Com_ptr<ID3D11PixelShader> _resolve_ps_linear_x8;
    const Com_ptr<ID3D11Buffer> _resolve_cb;
    std::array<Com_ptr<ID3D11ShaderResourceView>, 64> _blue_noise_srvs;
+   std::uint64_t _blue_noise_generation = 0;
    xor_shift32 _resolve_xorshift;
    std::uniform_int_distribution<xor_shift32::result_type> _resolve_rand_dist{0, 63};
 };
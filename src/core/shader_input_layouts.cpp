@@ -1,6 +1,7 @@
 
 #include "shader_input_layouts.hpp"
 #include "../logger.hpp"
+#include "../shader/vertex_input_layout_dxgi.hpp"
 
 #include <algorithm>
 
@@ -8,6 +8,7 @@
 #include "../logger.hpp"
 #include "../material/editor.hpp"
 #include "../message_hooks.hpp"
+#include "../game_support/current_map.hpp"
 #include "../game_support/game_memory.hpp"
 #include "patch_material_io.hpp"
 #include "patch_texture_io.hpp"
@@ -19,6 +20,8 @@
 
 #include <chrono>
 #include <cmath>
+#include <ctime>
+#include <stdexcept>
 
 #include <comdef.h>
 
@@ -33,6 +36,7 @@ constexpr UINT extra_textures_start = 4;
 constexpr auto shadow_texture_format = DXGI_FORMAT_R8G8_UNORM;
 constexpr auto flares_texture_format = DXGI_FORMAT_A8_UNORM;
 constexpr auto screenshots_folder = L"ScreenShots/";
+constexpr auto draw_streams_folder = L"DrawStreams/";
 
 namespace {
 
@@ -237,6 +241,16 @@ void Shader_patch::reset(const Reset_flags flags, const UINT render_width,
                          const UINT render_height, const UINT window_width,
                          const UINT window_height) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Reset{.legacy_fullscreen = flags.legacy_fullscreen,
+                            .aspect_ratio_hack = flags.aspect_ratio_hack,
+                            .render_width = render_width,
+                            .render_height = render_height,
+                            .window_width = window_width,
+                            .window_height = window_height});
+   }
+
    _device_context->ClearState();
    _game_rendertargets.clear();
    _effects.cmaa2.clear_resources();
@@ -265,6 +279,8 @@ void Shader_patch::reset(const Reset_flags flags, const UINT render_width,
    _game_vertex_buffer_stride = 0;
    _game_index_buffer = nullptr;
    _game_vertex_buffer = nullptr;
+   _game_index_buffer_source = {};
+   _game_vertex_buffer_source = {};
    _game_blend_state = nullptr;
    _game_rs_state = nullptr;
    _game_depthstencil_state = nullptr;
@@ -292,6 +308,10 @@ void Shader_patch::set_expected_aspect_ratio(const float expected_aspect_ratio)
 
 void Shader_patch::present() noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Present{});
+   }
+
    _effects.profiler.end_frame(*_device_context);
    _game_postprocessing.end_frame();
 
@@ -318,6 +338,14 @@ void Shader_patch::present() noexcept
 
    _shader_database.cache_update();
 
+   defragment_game_buffers();
+
+   retire_patch_textures();
+
+   if (_draw_stream_recorder && _draw_stream_recorder->done()) {
+      save_draw_stream();
+   }
+
    if (_font_atlas_builder &&
        _font_atlas_builder->update_srv_database(_shader_resource_database)) {
       update_material_resources();
@@ -744,26 +772,44 @@ auto Shader_patch::create_patch_texture(const std::span<const std::byte> texture
    -> Texture_handle
 {
    try {
-      auto [srv, name] =
-         load_patch_texture(ucfb::Reader_strict<"sptx"_mn>{texture_data}, *_device);
+      // Only the header is read here, the texture itself is created on the
+      // loader's threads and swapped in for the placeholder on present.
+      const auto [info, name] =
+         load_patch_texture_header(ucfb::Reader_strict<"sptx"_mn>{texture_data});
 
-      auto* raw_srv = srv.get();
+      auto placeholder = _patch_texture_placeholders.create_view(info.type);
 
-      log(Log_level::info, "Loaded texture "sv, std::quoted(name));
+      if (!placeholder) {
+         throw std::runtime_error{"unable to create placeholder texture"};
+      }
+
+      auto* const placeholder_srv = placeholder.get();
+
+      _shader_resource_database.insert(std::move(placeholder), name);
+
+      const auto ticket =
+         _patch_texture_loader.enqueue({texture_data.begin(), texture_data.end()});
+
+      _patch_textures.emplace(ticket, placeholder_srv);
 
-      _shader_resource_database.insert(std::move(srv), name);
+      const auto texture_deleter = [this, ticket](ID3D11ShaderResourceView*) noexcept {
+         _patch_texture_loader.cancel(ticket);
 
-      const auto texture_deleter = [this](ID3D11ShaderResourceView* srv) noexcept {
-         const auto [exists, name] = _shader_resource_database.reverse_lookup(srv);
+         const auto texture = _patch_textures.extract(ticket);
+
+         if (texture.empty()) return;
+
+         const auto [exists, name] =
+            _shader_resource_database.reverse_lookup(texture.mapped());
 
          if (!exists) return; // Texture has already been replaced.
 
          log(Log_level::info, "Destroying texture "sv, std::quoted(name));
 
-         _shader_resource_database.erase(srv);
+         _shader_resource_database.erase(texture.mapped());
       };
 
-      return {raw_srv, texture_deleter};
+      return {placeholder_srv, texture_deleter};
    }
    catch (std::exception& e) {
       log(Log_level::error, "Failed to create unknown texture! reason: "sv, e.what());
@@ -776,32 +822,36 @@ auto Shader_patch::create_patch_material(const std::span<const std::byte> materi
    -> Material_handle
 {
    try {
-      const auto config =
-         read_patch_material(ucfb::Reader_strict<"matl"_mn>{material_data});
-
-      auto material = _materials
-                         .emplace_back(std::make_unique<material::Material>(
-                            _material_factory.create_material(config)))
-                         .get();
+      const auto material_deleter = [this](material::Material* material) noexcept {
+         auto owned = _materials.release(material);
 
-      log(Log_level::info, "Loaded material "sv, std::quoted(material->name));
+         if (!owned) return;
 
-      const auto material_deleter = [this](material::Material* material) noexcept {
          if (_patch_material == material) set_patch_material(nullptr);
 
-         for (auto it = _materials.begin(); it != _materials.end(); ++it) {
-            if (it->get() != material) continue;
-
-            log(Log_level::info, "Destroying material "sv, std::quoted(material->name));
+         log(Log_level::info, "Destroying material "sv, std::quoted(material->name));
 
-            _materials.erase(it);
+         if (_materials.empty()) _material_factory.clear_cache();
 
-            return;
+         // A draw stream being recorded may still refer to the material.
+         if (_draw_stream_recorder) {
+            _draw_stream_retired_materials.push_back(std::move(owned));
          }
-
-         log_and_terminate("Attempt to destroy nonexistant material!");
       };
 
+      if (auto* const material = _materials.acquire(material_data); material) {
+         return {material, material_deleter};
+      }
+
+      const auto config =
+         read_patch_material(ucfb::Reader_strict<"matl"_mn>{material_data});
+
+      auto* const material =
+         _materials.insert(material_data, std::make_unique<material::Material>(
+                                             _material_factory.create_material(config)));
+
+      log(Log_level::info, "Loaded material "sv, std::quoted(material->name));
+
       return {material, material_deleter};
    }
    catch (std::exception& e) {
@@ -870,6 +920,26 @@ auto Shader_patch::create_ia_buffer(const UINT size, const bool vertex_buffer,
    return buffer;
 }
 
+auto Shader_patch::create_game_buffer(const UINT size) noexcept -> Game_buffer
+{
+   return _game_buffer_arena.allocate(size);
+}
+
+void Shader_patch::destroy_game_buffer(const Game_buffer& buffer) noexcept
+{
+   // The D3D11 buffer stays bound but it can no longer be resolved again.
+   if (_game_index_buffer_source == buffer) _game_index_buffer_source = {};
+   if (_game_vertex_buffer_source == buffer) _game_vertex_buffer_source = {};
+
+   _game_buffer_arena.free(buffer);
+}
+
+void Shader_patch::update_game_buffer(const Game_buffer& buffer, const UINT offset,
+                                      const UINT size, const std::byte* data) noexcept
+{
+   _game_buffer_arena.update(*_device_context, buffer, offset, size, data);
+}
+
 void Shader_patch::load_colorgrading_regions(const std::span<const std::byte> regions_data) noexcept
 {
    try {
@@ -885,6 +955,14 @@ void Shader_patch::load_colorgrading_regions(const std::span<const std::byte> re
 void Shader_patch::update_ia_buffer(ID3D11Buffer& buffer, const UINT offset,
                                     const UINT size, const std::byte* data) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Update_ia_buffer{.buffer = draw_stream_object(&buffer,
+                                                                    copy_raw_com_ptr(buffer)),
+                                       .offset = offset,
+                                       .size = size});
+   }
+
    const D3D11_BOX box{offset, 0, 0, offset + size, 1, 1};
 
    _device_context->UpdateSubresource(&buffer, 0, &box, data, 0, 0);
@@ -893,6 +971,13 @@ void Shader_patch::update_ia_buffer(ID3D11Buffer& buffer, const UINT offset,
 auto Shader_patch::map_ia_buffer(ID3D11Buffer& buffer, const D3D11_MAP map_type) noexcept
    -> std::byte*
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Map_ia_buffer{.buffer = draw_stream_object(&buffer,
+                                                                 copy_raw_com_ptr(buffer)),
+                                    .map_type = static_cast<std::uint8_t>(map_type)});
+   }
+
    D3D11_MAPPED_SUBRESOURCE mapped;
 
    _device_context->Map(&buffer, 0, map_type, 0, &mapped);
@@ -902,6 +987,11 @@ auto Shader_patch::map_ia_buffer(ID3D11Buffer& buffer, const D3D11_MAP map_type)
 
 void Shader_patch::unmap_ia_buffer(ID3D11Buffer& buffer) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Unmap_ia_buffer{
+         .buffer = draw_stream_object(&buffer, copy_raw_com_ptr(buffer))});
+   }
+
    _device_context->Unmap(&buffer, 0);
 }
 
@@ -931,6 +1021,15 @@ void Shader_patch::stretch_rendertarget(const Game_rendertarget_id source,
                                         const Game_rendertarget_id dest,
                                         const Normalized_rect dest_rect) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Stretch_rendertarget{
+         .source = static_cast<std::int32_t>(source),
+         .source_rect = {source_rect.left, source_rect.top, source_rect.right,
+                         source_rect.bottom},
+         .dest = static_cast<std::int32_t>(dest),
+         .dest_rect = {dest_rect.left, dest_rect.top, dest_rect.right, dest_rect.bottom}});
+   }
+
    auto& src_rt = _game_rendertargets[static_cast<int>(source)];
    auto& dest_rt = _game_rendertargets[static_cast<int>(dest)];
 
@@ -1243,6 +1342,16 @@ void Shader_patch::color_fill_rendertarget(const Game_rendertarget_id rendertarg
                                            const glm::vec4 color,
                                            const Normalized_rect* normalized_rect) noexcept
 {
+   if (_draw_stream_recorder) {
+      const Normalized_rect rect = normalized_rect ? *normalized_rect : Normalized_rect{};
+
+      _draw_stream_recorder->record(draw_stream::Color_fill_rendertarget{
+         .rendertarget = static_cast<std::int32_t>(rendertarget),
+         .color = {color.r, color.g, color.b, color.a},
+         .has_rect = normalized_rect != nullptr,
+         .rect = {rect.left, rect.top, rect.right, rect.bottom}});
+   }
+
    if (auto& rt = _game_rendertargets[static_cast<int>(rendertarget)]; normalized_rect) {
       RECT rect = to_rect(rt, *normalized_rect);
 
@@ -1255,6 +1364,11 @@ void Shader_patch::color_fill_rendertarget(const Game_rendertarget_id rendertarg
 
 void Shader_patch::clear_rendertarget(const glm::vec4 color) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Clear_rendertarget{.color = {color.r, color.g, color.b, color.a}});
+   }
+
    _device_context->ClearRenderTargetView(
       _game_rendertargets[static_cast<int>(_current_game_rendertarget)].rtv.get(),
       &color.x);
@@ -1264,6 +1378,14 @@ void Shader_patch::clear_depthstencil(const float depth, const UINT8 stencil,
                                       const bool clear_depth,
                                       const bool clear_stencil) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Clear_depthstencil{.z = depth,
+                                         .stencil = stencil,
+                                         .clear_depth = clear_depth,
+                                         .clear_stencil = clear_stencil});
+   }
+
    if (clear_depth && _rt_sample_count == 1 &&
        _current_depthstencil_id == Game_depthstencil::nearscene && _frame_had_skyfog) {
       _device_context->SetMarkerInt(L"Swapped Near/Far Depth Stencil", 0);
@@ -1291,33 +1413,92 @@ void Shader_patch::clear_depthstencil(const float depth, const UINT8 stencil,
 
 void Shader_patch::set_index_buffer(ID3D11Buffer& buffer, const UINT offset) noexcept
 {
-   _game_index_buffer = copy_raw_com_ptr(buffer);
-   _game_index_buffer_offset = offset;
-   _ia_index_buffer_dirty = true;
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_index_buffer{
+         .buffer = draw_stream_object(&buffer, copy_raw_com_ptr(buffer)),
+         .offset = offset});
+   }
+
+   _game_index_buffer_source = {};
+
+   bind_index_buffer(buffer, offset);
+}
+
+void Shader_patch::set_index_buffer(const Game_buffer& buffer, const UINT offset) noexcept
+{
+   // Copy first, buffer may be referring to _game_index_buffer_source.
+   const Game_buffer source = buffer;
+   const auto [arena_buffer, arena_offset] = _game_buffer_arena.resolve(source);
+
+   // Recorded as what it resolved to, the game buffer may be gone by replay.
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_index_buffer{
+         .buffer = draw_stream_object(arena_buffer, copy_raw_com_ptr(arena_buffer)),
+         .offset = arena_offset + offset});
+   }
+
+   bind_index_buffer(*arena_buffer, arena_offset + offset);
+
+   _game_index_buffer_source = source;
+   _game_index_buffer_source_offset = offset;
 }
 
 void Shader_patch::set_vertex_buffer(ID3D11Buffer& buffer, const UINT offset,
                                      const UINT stride) noexcept
 {
-   _game_vertex_buffer = copy_raw_com_ptr(buffer);
-   _game_vertex_buffer_offset = offset;
-   _game_vertex_buffer_stride = stride;
-   _ia_vertex_buffer_dirty = true;
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_vertex_buffer{
+         .buffer = draw_stream_object(&buffer, copy_raw_com_ptr(buffer)),
+         .offset = offset,
+         .stride = stride});
+   }
+
+   _game_vertex_buffer_source = {};
+
+   bind_vertex_buffer(buffer, offset, stride);
+}
+
+void Shader_patch::set_vertex_buffer(const Game_buffer& buffer, const UINT offset,
+                                     const UINT stride) noexcept
+{
+   // Copy first, buffer may be referring to _game_vertex_buffer_source.
+   const Game_buffer source = buffer;
+   const auto [arena_buffer, arena_offset] = _game_buffer_arena.resolve(source);
+
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_vertex_buffer{
+         .buffer = draw_stream_object(arena_buffer, copy_raw_com_ptr(arena_buffer)),
+         .offset = arena_offset + offset,
+         .stride = stride});
+   }
+
+   bind_vertex_buffer(*arena_buffer, arena_offset + offset, stride);
+
+   _game_vertex_buffer_source = source;
+   _game_vertex_buffer_source_offset = offset;
 }
 
 void Shader_patch::set_input_layout(const Game_input_layout& input_layout) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_input_layout{
+         .layout_index = input_layout.layout_index,
+         .compressed_position = input_layout.compressed_position,
+         .compressed_texcoords = input_layout.compressed_texcoords,
+         .has_vertex_weights = input_layout.has_vertex_weights});
+   }
+
    _game_input_layout = input_layout;
    _shader_dirty = true;
 
    if (std::uint32_t{input_layout.compressed_position} != _cb_draw.compressed_position) {
       _cb_draw.compressed_position = input_layout.compressed_position;
-      _cb_draw_dirty = true;
+      _cb_draw_tracker.mark_all();
    }
 
    if (std::uint32_t{input_layout.compressed_texcoords} != _cb_draw.compressed_texcoords) {
       _cb_draw.compressed_texcoords = input_layout.compressed_texcoords;
-      _cb_draw_dirty = true;
+      _cb_draw_tracker.mark_all();
    }
 
    const std::uint32_t soft_skin = (input_layout.has_vertex_weights &
@@ -1326,12 +1507,17 @@ void Shader_patch::set_input_layout(const Game_input_layout& input_layout) noexc
 
    if (soft_skin != _cb_scene.vs_use_soft_skinning) {
       _cb_scene.vs_use_soft_skinning = soft_skin;
-      _cb_scene_dirty = true;
+      _cb_scene_tracker.mark_all();
    }
 }
 
 void Shader_patch::set_game_shader(const std::uint32_t shader_index) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Set_game_shader{.shader_index = shader_index});
+   }
+
    _game_shader = &_game_shaders[shader_index];
    _shader_dirty = true;
 
@@ -1345,22 +1531,33 @@ void Shader_patch::set_game_shader(const std::uint32_t shader_index) noexcept
    const std::uint32_t light_active_point_count = _game_shader->light_active_point_count;
    const std::uint32_t light_active_spot = _game_shader->light_active_spot;
 
-   _cb_draw_ps_dirty |=
-      ((std::exchange(_cb_draw_ps.light_active, light_active) != light_active) |
+   if ((std::exchange(_cb_draw_ps.light_active, light_active) != light_active) |
        (std::exchange(_cb_draw_ps.light_active_point_count,
                       light_active_point_count) != light_active_point_count) |
        (std::exchange(_cb_draw_ps.light_active_spot, light_active_spot) !=
-        light_active_spot));
+        light_active_spot)) {
+      _cb_draw_ps_tracker.mark_all();
+   }
 }
 
 void Shader_patch::set_rendertarget(const Game_rendertarget_id rendertarget) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_rendertarget{
+         .rendertarget = static_cast<std::int32_t>(rendertarget)});
+   }
+
    _om_targets_dirty = true;
    _current_game_rendertarget = rendertarget;
 }
 
 void Shader_patch::set_depthstencil(const Game_depthstencil depthstencil) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_depthstencil{
+         .depthstencil = static_cast<std::uint8_t>(depthstencil)});
+   }
+
    _om_targets_dirty = true;
 
    // When switching to farscene, mark that we need to capture the projection on first draw
@@ -1373,6 +1570,12 @@ void Shader_patch::set_depthstencil(const Game_depthstencil depthstencil) noexce
 
 void Shader_patch::set_rasterizer_state(ID3D11RasterizerState& rasterizer_state) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_rasterizer_state{
+         .state = draw_stream_object(&rasterizer_state,
+                                     copy_raw_com_ptr(rasterizer_state))});
+   }
+
    _game_rs_state = copy_raw_com_ptr(rasterizer_state);
    _rs_state_dirty = true;
 }
@@ -1381,6 +1584,14 @@ void Shader_patch::set_depthstencil_state(ID3D11DepthStencilState& depthstencil_
                                           const UINT8 stencil_ref,
                                           const bool readonly) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_depthstencil_state{
+         .state = draw_stream_object(&depthstencil_state,
+                                     copy_raw_com_ptr(depthstencil_state)),
+         .stencil_ref = stencil_ref,
+         .readonly = readonly});
+   }
+
    _game_depthstencil_state = copy_raw_com_ptr(depthstencil_state);
    _game_stencil_ref = stencil_ref;
    _om_depthstencil_state_dirty = true;
@@ -1392,16 +1603,28 @@ void Shader_patch::set_depthstencil_state(ID3D11DepthStencilState& depthstencil_
 void Shader_patch::set_blend_state(ID3D11BlendState1& blend_state,
                                    const bool additive_blending) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_blend_state{
+         .state = draw_stream_object(&blend_state, copy_raw_com_ptr(blend_state)),
+         .additive_blending = additive_blending});
+   }
+
    _game_blend_state = copy_raw_com_ptr(blend_state);
    _om_blend_state_dirty = true;
 
    _cb_draw_ps.additive_blending = additive_blending;
-   _cb_draw_ps_dirty = true;
+   _cb_draw_ps_tracker.mark_all();
 }
 
 void Shader_patch::set_fog_state(const bool enabled, const glm::vec4 color) noexcept
 {
-   _cb_draw_ps_dirty = true;
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Set_fog_state{.enabled = enabled,
+                                    .color = {color.r, color.g, color.b, color.a}});
+   }
+
+   _cb_draw_ps_tracker.mark_all();
    _cb_draw_ps.fog_enabled = enabled;
    _cb_draw_ps.fog_color = color;
 }
@@ -1410,6 +1633,13 @@ void Shader_patch::set_texture(const UINT slot, const Game_texture& texture) noe
 {
    Expects(slot < 4);
 
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_texture{
+         .slot = static_cast<std::uint8_t>(slot),
+         .texture = draw_stream_object(texture.srv.get(), texture),
+         .rendertarget = -1});
+   }
+
    _game_textures[slot] = texture;
    _ps_textures_dirty = true;
 }
@@ -1419,6 +1649,13 @@ void Shader_patch::set_texture(const UINT slot,
 {
    Expects(slot < 4);
 
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_texture{
+         .slot = static_cast<std::uint8_t>(slot),
+         .texture = draw_stream_null_object,
+         .rendertarget = static_cast<std::int32_t>(rendertarget)});
+   }
+
    const auto& srv = _game_rendertargets[static_cast<int>(rendertarget)].srv;
 
    _game_textures[slot] = {srv, srv};
@@ -1430,12 +1667,22 @@ void Shader_patch::set_texture(const UINT slot,
 
 void Shader_patch::set_projtex_mode(const Projtex_mode mode) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Set_projtex_mode{.mode = static_cast<std::uint8_t>(mode)});
+   }
+
    _projtex_mode_dirty = true;
    _projtex_mode = mode;
 }
 
 void Shader_patch::set_projtex_type(const Projtex_type type) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Set_projtex_type{.type = static_cast<std::uint8_t>(type)});
+   }
+
    if (type == Projtex_type::tex2d) {
       _cb_draw_ps.cube_projtex = false;
    }
@@ -1443,11 +1690,16 @@ void Shader_patch::set_projtex_type(const Projtex_type type) noexcept
       _cb_draw_ps.cube_projtex = true;
    }
 
-   _cb_draw_ps_dirty = true;
+   _cb_draw_ps_tracker.mark_all();
 }
 
 void Shader_patch::set_projtex_cube(const Game_texture& texture) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_projtex_cube{
+         .texture = draw_stream_object(texture.srv.get(), texture)});
+   }
+
    if (_lock_projtex_cube_slot) return;
 
    _extra_game_textures[0] = texture;
@@ -1456,6 +1708,11 @@ void Shader_patch::set_projtex_cube(const Game_texture& texture) noexcept
 
 void Shader_patch::set_patch_material(material::Material* material) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Set_patch_material{
+         .material = draw_stream_object(material, material)});
+   }
+
    if (_patch_material) {
       if (_patch_material->want_depth_buffer_input) {
          _ps_textures_material_wants_depthstencil = false;
@@ -1500,7 +1757,13 @@ void Shader_patch::set_patch_material(material::Material* material) noexcept
 void Shader_patch::set_constants(const cb::Scene_tag, const UINT offset,
                                  const std::span<const std::array<float, 4>> constants) noexcept
 {
-   _cb_scene_dirty = true;
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record_constants(Draw_stream_cb::scene,
+                                              offset * sizeof(std::array<float, 4>),
+                                              std::as_bytes(constants));
+   }
+
+   _cb_scene_tracker.mark(offset, static_cast<std::uint32_t>(constants.size()));
 
    std::memcpy(bit_cast<std::byte*>(&_cb_scene) +
                   (offset * sizeof(std::array<float, 4>)),
@@ -1513,13 +1776,15 @@ void Shader_patch::set_constants(const cb::Scene_tag, const UINT offset,
                                      : _cb_scene.vs_lighting_scale;
       const float scale = _linear_rendering ? 1.0f : default_scale;
 
-      _cb_draw_ps_dirty = true;
+      _cb_draw_ps_tracker.mark_all();
+      _cb_scene_tracker.mark(offsetof(cb::Scene, vs_lighting_scale) / sizeof(glm::vec4),
+                             1);
       _cb_scene.vs_lighting_scale = scale;
       _cb_draw_ps.ps_lighting_scale = scale;
    }
 
    if (offset < (offsetof(cb::Scene, vs_view_positionWS) / sizeof(glm::vec4))) {
-      _cb_draw_ps_dirty = true;
+      _cb_draw_ps_tracker.mark_all();
       _cb_draw_ps.ps_view_positionWS = _cb_scene.vs_view_positionWS;
    }
 }
@@ -1527,7 +1792,13 @@ void Shader_patch::set_constants(const cb::Scene_tag, const UINT offset,
 void Shader_patch::set_constants(const cb::Draw_tag, const UINT offset,
                                  const std::span<const std::array<float, 4>> constants) noexcept
 {
-   _cb_draw_dirty = true;
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record_constants(Draw_stream_cb::draw,
+                                              offset * sizeof(std::array<float, 4>),
+                                              std::as_bytes(constants));
+   }
+
+   _cb_draw_tracker.mark(offset, static_cast<std::uint32_t>(constants.size()));
 
    std::memcpy(bit_cast<std::byte*>(&_cb_draw) +
                   (offset * sizeof(std::array<float, 4>)),
@@ -1535,6 +1806,8 @@ void Shader_patch::set_constants(const cb::Draw_tag, const UINT offset,
 
    if (offset < (offsetof(cb::Draw, normaltex_decompress) / sizeof(glm::vec4)) or
        offset < (offsetof(cb::Draw, position_decompress_min) / sizeof(glm::vec4))) {
+      _cb_draw_tracker.mark(0, offsetof(cb::Draw, position_decompress_max) /
+                                  sizeof(glm::vec4));
       _cb_draw.compressed_position = _game_input_layout.compressed_position;
       _cb_draw.compressed_texcoords = _game_input_layout.compressed_texcoords;
    }
@@ -1543,6 +1816,11 @@ void Shader_patch::set_constants(const cb::Draw_tag, const UINT offset,
 void Shader_patch::set_constants(const cb::Fixedfunction_tag,
                                  cb::Fixedfunction constants) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record_constants(Draw_stream_cb::fixedfunction, 0,
+                                              std::as_bytes(std::span{&constants, 1}));
+   }
+
    update_dynamic_buffer(*_device_context, *_cb_fixedfunction_buffer, constants);
 
    _game_postprocessing.blur_factor(constants.texture_factor.a);
@@ -1551,7 +1829,13 @@ void Shader_patch::set_constants(const cb::Fixedfunction_tag,
 void Shader_patch::set_constants(const cb::Skin_tag, const UINT offset,
                                  const std::span<const std::array<float, 4>> constants) noexcept
 {
-   _cb_skin_dirty = true;
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record_constants(Draw_stream_cb::skin,
+                                              offset * sizeof(std::array<float, 4>),
+                                              std::as_bytes(constants));
+   }
+
+   _cb_skin_tracker.mark(offset, static_cast<std::uint32_t>(constants.size()));
 
    std::memcpy(bit_cast<std::byte*>(&_cb_skin) +
                   (offset * sizeof(std::array<float, 4>)),
@@ -1561,7 +1845,13 @@ void Shader_patch::set_constants(const cb::Skin_tag, const UINT offset,
 void Shader_patch::set_constants(const cb::Draw_ps_tag, const UINT offset,
                                  const std::span<const std::array<float, 4>> constants) noexcept
 {
-   _cb_draw_ps_dirty = true;
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record_constants(Draw_stream_cb::draw_ps,
+                                              offset * sizeof(std::array<float, 4>),
+                                              std::as_bytes(constants));
+   }
+
+   _cb_draw_ps_tracker.mark(offset, static_cast<std::uint32_t>(constants.size()));
 
    std::memcpy(bit_cast<std::byte*>(&_cb_draw_ps) +
                   (offset * sizeof(std::array<float, 4>)),
@@ -1570,6 +1860,14 @@ void Shader_patch::set_constants(const cb::Draw_ps_tag, const UINT offset,
 
 void Shader_patch::set_informal_projection_matrix(const glm::mat4 matrix) noexcept
 {
+   if (_draw_stream_recorder) {
+      draw_stream::Set_informal_projection_matrix args;
+
+      std::memcpy(args.matrix.data(), &matrix, sizeof(args.matrix));
+
+      _draw_stream_recorder->record(args);
+   }
+
    _informal_projection_matrix = matrix;
 
    // Capture far scene projection when set while in farscene mode
@@ -1581,12 +1879,27 @@ void Shader_patch::set_informal_projection_matrix(const glm::mat4 matrix) noexce
 
 void Shader_patch::set_informal_view_matrix(const glm::mat4& matrix) noexcept
 {
+   if (_draw_stream_recorder) {
+      draw_stream::Set_informal_view_matrix args;
+
+      std::memcpy(args.matrix.data(), &matrix, sizeof(args.matrix));
+
+      _draw_stream_recorder->record(args);
+   }
+
     _informal_view_matrix = matrix;
 }
 
 void Shader_patch::draw(const D3D11_PRIMITIVE_TOPOLOGY topology,
                         const UINT vertex_count, const UINT start_vertex) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Draw{.topology = static_cast<std::uint8_t>(topology),
+                           .vertex_count = vertex_count,
+                           .start_vertex = start_vertex});
+   }
+
    update_dirty_state(topology);
 
    if (_discard_draw_calls) return;
@@ -1604,6 +1917,14 @@ void Shader_patch::draw_indexed(const D3D11_PRIMITIVE_TOPOLOGY topology,
                                 const UINT index_count, const UINT start_index,
                                 const INT base_vertex) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(
+         draw_stream::Draw_indexed{.topology = static_cast<std::uint8_t>(topology),
+                                   .index_count = index_count,
+                                   .start_index = start_index,
+                                   .base_vertex = base_vertex});
+   }
+
    update_dirty_state(topology);
 
    if (_discard_draw_calls) return;
@@ -1619,11 +1940,21 @@ void Shader_patch::draw_indexed(const D3D11_PRIMITIVE_TOPOLOGY topology,
 
 void Shader_patch::begin_query(ID3D11Query& query) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::Begin_query{
+         .query = draw_stream_object(&query, copy_raw_com_ptr(query))});
+   }
+
    _device_context->Begin(&query);
 }
 
 void Shader_patch::end_query(ID3D11Query& query) noexcept
 {
+   if (_draw_stream_recorder) {
+      _draw_stream_recorder->record(draw_stream::End_query{
+         .query = draw_stream_object(&query, copy_raw_com_ptr(query))});
+   }
+
    _device_context->End(&query);
 }
 
@@ -1908,6 +2239,7 @@ void Shader_patch::game_rendertype_changed() noexcept
       }
    }
    else if (_shader_rendertype == Rendertype::skyfog) {
+      _cb_scene_tracker.mark_all();
       _cb_scene.prev_near_scene_fade_scale = _cb_scene.near_scene_fade_scale;
       _cb_scene.prev_near_scene_fade_offset = _cb_scene.near_scene_fade_offset;
       _frame_had_skyfog = true;
@@ -2181,7 +2513,7 @@ void Shader_patch::update_dirty_state(const D3D11_PRIMITIVE_TOPOLOGY draw_primit
          _device_context->OMSetRenderTargets(1, &rtv, current_depthstencil());
       }
 
-      _cb_draw_ps_dirty = true;
+      _cb_draw_ps_tracker.mark_all();
       _cb_draw_ps.rt_resolution = {rt.width, rt.height, 1.0f / rt.width,
                                    1.0f / rt.height};
 
@@ -2200,7 +2532,7 @@ void Shader_patch::update_dirty_state(const D3D11_PRIMITIVE_TOPOLOGY draw_primit
 
          _device_context->RSSetViewports(1, &viewport);
 
-         _cb_scene_dirty = true;
+         _cb_scene_tracker.mark_all();
          _cb_scene.pixel_offset =
             glm::vec2{1.f, -1.f} / glm::vec2{viewport.Width, viewport.Height};
       }
@@ -2218,19 +2550,19 @@ void Shader_patch::update_dirty_state(const D3D11_PRIMITIVE_TOPOLOGY draw_primit
                                        nullptr, 0xffffffff);
    }
 
-   if (std::exchange(_cb_scene_dirty, false)) {
+   if (_cb_scene_tracker.needs_upload(_cb_scene)) {
       update_dynamic_buffer(*_device_context, *_cb_scene_buffer, _cb_scene);
    }
 
-   if (std::exchange(_cb_draw_dirty, false)) {
+   if (_cb_draw_tracker.needs_upload(_cb_draw)) {
       update_dynamic_buffer(*_device_context, *_cb_draw_buffer, _cb_draw);
    }
 
-   if (std::exchange(_cb_skin_dirty, false)) {
+   if (_cb_skin_tracker.needs_upload(_cb_skin)) {
       update_dynamic_buffer(*_device_context, *_cb_skin_buffer, _cb_skin);
    }
 
-   if (std::exchange(_cb_draw_ps_dirty, false)) {
+   if (_cb_draw_ps_tracker.needs_upload(_cb_draw_ps)) {
       update_dynamic_buffer(*_device_context, *_cb_draw_ps_buffer, _cb_draw_ps);
    }
 
@@ -2254,7 +2586,7 @@ void Shader_patch::update_shader() noexcept
       if (_shader_rendertype == _patch_material->overridden_rendertype) {
          _patch_material->shader->update(*_device_context, _input_layout_descriptions,
                                          _game_input_layout.layout_index,
-                                         _game_shader->shader_name, vs_flags,
+                                         _game_shader->state_id, vs_flags,
                                          _oit_active);
          return;
       }
@@ -2277,7 +2609,8 @@ void Shader_patch::update_frame_state() noexcept
    using namespace std::chrono;
    const auto time = steady_clock{}.now().time_since_epoch();
 
-   _cb_scene_dirty = true;
+   _cb_scene_tracker.mark_all();
+   _cb_draw_ps_tracker.mark_all();
    _cb_scene.time = duration<float>{(time % 3600s)}.count();
    _cb_draw_ps.time_seconds = duration_cast<duration<float>>((time % 3600s)).count();
    _cb_draw_ps.supersample_alpha_test = user_config.graphics.supersample_alpha_test;
@@ -2314,7 +2647,7 @@ void Shader_patch::update_imgui() noexcept
        ImGui::ShowDemoWindow();
        user_config.show_imgui();
        _effects.show_imgui(_window);
-       material::show_editor(_material_factory, _materials);
+       material::show_editor(_material_factory, _materials.materials());
        if (_bf2_log_monitor) _bf2_log_monitor->show_imgui(true);
 
        // Dev Tools Window
@@ -2342,6 +2675,73 @@ void Shader_patch::update_imgui() noexcept
            else {
                ImGui::TextDisabled("Projection controls not available for this game version");
            }
+
+           ImGui::SeparatorText("Game Buffer Arena");
+
+           const auto arena_stats = _game_buffer_arena.stats();
+
+           ImGui::Text("Pages: %u (%u dedicated)", arena_stats.page_count,
+                       arena_stats.dedicated_page_count);
+           ImGui::Text("Used: %.2f / %.2f MB", arena_stats.used / (1024.0 * 1024.0),
+                       arena_stats.capacity / (1024.0 * 1024.0));
+           ImGui::Text("Buffers: %u Free Blocks: %u", arena_stats.allocation_count,
+                       arena_stats.free_block_count);
+           ImGui::Text("Worst Fragmentation: %.1f%%",
+                       arena_stats.worst_fragmentation * 100.0f);
+
+           ImGui::SeparatorText("Materials");
+
+           const auto material_cache_stats = _material_factory.cache_stats();
+
+           ImGui::Text("Materials: %zu (%zu references)",
+                       _materials.materials().size(), _materials.reference_count());
+           ImGui::Text("Cached Builds: %zu Constant Buffers: %zu",
+                       material_cache_stats.build_entries,
+                       material_cache_stats.constant_buffer_entries);
+           ImGui::Text("Cache Hits: %llu Misses: %llu", material_cache_stats.hits,
+                       material_cache_stats.misses);
+
+           ImGui::SeparatorText("Depth of Field Rendertargets");
+
+           const auto& dof_report = _effects.postprocess.dof_rendertarget_report();
+
+           ImGui::Text("Transients: %u Targets: %u", dof_report.transient_count,
+                       dof_report.slot_count);
+           ImGui::Text("Aliased: %.1fMB Unaliased: %.1fMB Peak Live: %.1fMB",
+                       dof_report.aliased_bytes / (1024.0 * 1024.0),
+                       dof_report.unaliased_bytes / (1024.0 * 1024.0),
+                       dof_report.peak_live_bytes / (1024.0 * 1024.0));
+
+           ImGui::SeparatorText("Draw Stream");
+
+           ImGui::SliderInt("Capture Frames", &_draw_stream_capture_frames, 1, 60);
+
+           if (_draw_stream_recorder) {
+               ImGui::TextDisabled("Capturing...");
+           }
+           else if (ImGui::Button("Capture Draw Stream")) {
+               _draw_stream_recorder = std::make_unique<Draw_stream_recorder>(
+                  static_cast<std::uint32_t>(_draw_stream_capture_frames));
+           }
+
+           if (_draw_stream_replay_stats) {
+               const auto& stats = *_draw_stream_replay_stats;
+
+               ImGui::Text("Frames: %u Draws: %llu Skipped: %llu", stats.frames,
+                           stats.draws, stats.skipped);
+
+               if (stats.truncated) ImGui::TextDisabled("Stream was truncated.");
+
+               for (std::size_t i = 0; i < stats.calls.size(); ++i) {
+                   if (stats.calls[i] == 0) continue;
+
+                   const auto name = to_string(static_cast<Draw_stream_op>(i));
+
+                   ImGui::Text("%.*s: %llu calls, %llu redundant",
+                               static_cast<int>(name.size()), name.data(),
+                               stats.calls[i], _draw_stream_redundant[i]);
+               }
+           }
        }
        ImGui::End();
    }
@@ -2563,11 +2963,79 @@ void Shader_patch::update_team_colors() noexcept
 
 void Shader_patch::update_material_resources() noexcept
 {
-   for (auto& mat : _materials) {
+   for (auto& mat : _materials.materials()) {
       mat->update_resources(_shader_resource_database);
    }
 }
 
+void Shader_patch::retire_patch_textures() noexcept
+{
+   bool retired_any = false;
+
+   _patch_texture_loader.retire_completed([&](const Patch_texture_loader::Ticket ticket,
+                                              Loaded_patch_texture loaded) {
+      auto it = _patch_textures.find(ticket);
+
+      if (it == _patch_textures.end()) return;
+
+      const auto [exists, name] = _shader_resource_database.reverse_lookup(it->second);
+
+      if (!exists) return; // Texture has already been replaced.
+
+      if (!loaded.srv) {
+         log(Log_level::error, "Failed to load texture "sv, std::quoted(name),
+             " reason: "sv, loaded.error);
+
+         return;
+      }
+
+      log(Log_level::info, "Loaded texture "sv, std::quoted(name));
+
+      it->second = loaded.srv.get();
+
+      _shader_resource_database.insert(std::move(loaded.srv), name);
+
+      retired_any = true;
+   });
+
+   if (retired_any) update_material_resources();
+}
+
+void Shader_patch::save_draw_stream() noexcept
+{
+   const auto recorder = std::move(_draw_stream_recorder);
+
+   const auto map = game_support::current_map();
+   const auto path =
+      std::filesystem::path{draw_streams_folder} /
+      fmt::format("{}_{}.spds", map.empty() ? "frontend"s : map, std::time(nullptr));
+
+   recorder->save(path);
+
+   // Count the capture straight away so the Dev Tools can show how much of
+   // the frame's binding was redundant. This never touches the device.
+   Counting_draw_stream_target target;
+
+   _draw_stream_replay_stats = replay_draw_stream(recorder->stream(), target);
+   _draw_stream_redundant = target.redundant();
+
+   _draw_stream_objects.clear();
+   _draw_stream_retired_materials.clear();
+}
+
+auto Shader_patch::load_patch_texture_async(ID3D11Device5& device,
+                                            const std::span<const std::byte> data) noexcept
+   -> Loaded_patch_texture
+{
+   try {
+      return {.srv =
+                 load_patch_texture(ucfb::Reader_strict<"sptx"_mn>{data}, device).first};
+   }
+   catch (std::exception& e) {
+      return {.error = e.what()};
+   }
+}
+
 void Shader_patch::recreate_patch_backbuffer() noexcept
 {
    _patch_backbuffer = {};
@@ -2622,8 +3090,8 @@ void Shader_patch::set_linear_rendering(bool linear_rendering) noexcept
       _cb_draw_ps.ps_lighting_scale = _stock_bloom_used_last_frame ? 0.5f : 1.0f;
    }
 
-   _cb_scene_dirty = true;
-   _cb_draw_ps_dirty = true;
+   _cb_scene_tracker.mark_all();
+   _cb_draw_ps_tracker.mark_all();
    _ps_textures_dirty = true;
    _ps_extra_textures_dirty = true;
    _linear_rendering = linear_rendering;
@@ -2694,6 +3162,51 @@ void Shader_patch::patch_backbuffer_resolve() noexcept
    restore_all_game_state();
 }
 
+void Shader_patch::defragment_game_buffers() noexcept
+{
+   if (!_game_buffer_arena.defragment(*_device_context)) return;
+
+   if (_game_index_buffer_source.valid()) {
+      const auto [buffer, offset] = _game_buffer_arena.resolve(_game_index_buffer_source);
+
+      bind_index_buffer(*buffer, offset + _game_index_buffer_source_offset);
+   }
+
+   if (_game_vertex_buffer_source.valid()) {
+      const auto [buffer, offset] = _game_buffer_arena.resolve(_game_vertex_buffer_source);
+
+      bind_vertex_buffer(*buffer, offset + _game_vertex_buffer_source_offset,
+                         _game_vertex_buffer_stride);
+   }
+}
+
+void Shader_patch::bind_index_buffer(ID3D11Buffer& buffer, const UINT offset) noexcept
+{
+   if (_game_index_buffer.get() == &buffer && _game_index_buffer_offset == offset) {
+      return;
+   }
+
+   _game_index_buffer = copy_raw_com_ptr(buffer);
+   _game_index_buffer_offset = offset;
+   _ia_index_buffer_dirty = true;
+}
+
+void Shader_patch::bind_vertex_buffer(ID3D11Buffer& buffer, const UINT offset,
+                                      const UINT stride) noexcept
+{
+   // Static buffers share arena buffers so the game switching buffers is
+   // often just a change of offset, or nothing at all.
+   if (_game_vertex_buffer.get() == &buffer && _game_vertex_buffer_offset == offset &&
+       _game_vertex_buffer_stride == stride) {
+      return;
+   }
+
+   _game_vertex_buffer = copy_raw_com_ptr(buffer);
+   _game_vertex_buffer_offset = offset;
+   _game_vertex_buffer_stride = stride;
+   _ia_vertex_buffer_dirty = true;
+}
+
 void Shader_patch::restore_all_game_state() noexcept
 {
    _device_context->ClearState();
@@ -2707,10 +3220,10 @@ void Shader_patch::restore_all_game_state() noexcept
    _om_blend_state_dirty = true;
    _ps_textures_dirty = true;
    _ps_extra_textures_dirty = true;
-   _cb_scene_dirty = true;
-   _cb_draw_dirty = true;
-   _cb_skin_dirty = true;
-   _cb_draw_ps_dirty = true;
+   _cb_scene_tracker.mark_all();
+   _cb_draw_tracker.mark_all();
+   _cb_skin_tracker.mark_all();
+   _cb_draw_ps_tracker.mark_all();
    _projtex_mode_dirty = true;
    _primitive_topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
 
@@ -5,17 +5,23 @@
 #include "../effects/rendertarget_allocator.hpp"
 #include "../material/factory.hpp"
 #include "../material/material.hpp"
+#include "../material/material_registry.hpp"
 #include "../material/shader_factory.hpp"
 #include "../shader/database.hpp"
 #include "../user_config.hpp"
 #include "backbuffer_cmaa2_views.hpp"
+#include "async_resource_loader.hpp"
 #include "basic_builtin_textures.hpp"
 #include "com_ptr.hpp"
+#include "constant_buffer_upload_tracker.hpp"
 #include "constant_buffers.hpp"
 #include "d3d11_helpers.hpp"
 #include "depth_msaa_resolver.hpp"
 #include "depthstencil.hpp"
+#include "draw_stream.hpp"
+#include "draw_stream_replayer.hpp"
 #include "game_alt_postprocessing.hpp"
+#include "game_buffer_arena.hpp"
 #include "game_input_layout.hpp"
 #include "game_rendertarget.hpp"
 #include "game_shader.hpp"
@@ -26,6 +32,7 @@
 #include "normalized_rect.hpp"
 #include "oit_provider.hpp"
 #include "patch_effects_config_handle.hpp"
+#include "patch_texture_placeholders.hpp"
 #include "postprocessing/backbuffer_resolver.hpp"
 #include "sampler_states.hpp"
 #include "small_function.hpp"
@@ -35,9 +42,15 @@
 #include "texture_loader.hpp"
 #include "tools/pixel_inspector.hpp"
 
+#include <memory>
+#include <optional>
 #include <span>
+#include <string>
+#include <variant>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include <glm/glm.hpp>
 
 #include <DirectXTex.h>
@@ -153,6 +166,15 @@ public:
                          const bool index_buffer, const bool dynamic) noexcept
       -> Com_ptr<ID3D11Buffer>;
 
+   // Static game vertex and index buffers, suballocated from a shared arena.
+
+   auto create_game_buffer(const UINT size) noexcept -> Game_buffer;
+
+   void destroy_game_buffer(const Game_buffer& buffer) noexcept;
+
+   void update_game_buffer(const Game_buffer& buffer, const UINT offset,
+                           const UINT size, const std::byte* data) noexcept;
+
    void load_colorgrading_regions(const std::span<const std::byte> regions_data) noexcept;
 
    void update_ia_buffer(ID3D11Buffer& buffer, const UINT offset,
@@ -184,9 +206,14 @@ public:
 
    void set_index_buffer(ID3D11Buffer& buffer, const UINT offset) noexcept;
 
+   void set_index_buffer(const Game_buffer& buffer, const UINT offset) noexcept;
+
    void set_vertex_buffer(ID3D11Buffer& buffer, const UINT offset,
                           const UINT stride) noexcept;
 
+   void set_vertex_buffer(const Game_buffer& buffer, const UINT offset,
+                          const UINT stride) noexcept;
+
    void set_input_layout(const Game_input_layout& input_layout) noexcept;
 
    void set_game_shader(const std::uint32_t game_shader_index) noexcept;
@@ -312,6 +339,47 @@ private:
 
    void patch_backbuffer_resolve() noexcept;
 
+   void defragment_game_buffers() noexcept;
+
+   // Binds for set_index_buffer and set_vertex_buffer, for use when the patch
+   // rebinds buffers itself so it isn't recorded as a call from the game.
+
+   void bind_index_buffer(ID3D11Buffer& buffer, const UINT offset) noexcept;
+
+   void bind_vertex_buffer(ID3D11Buffer& buffer, const UINT offset,
+                           const UINT stride) noexcept;
+
+   struct Loaded_patch_texture {
+      Com_ptr<ID3D11ShaderResourceView> srv;
+      std::string error;
+   };
+
+   using Patch_texture_loader = Async_resource_loader<Loaded_patch_texture>;
+
+   void retire_patch_textures() noexcept;
+
+   void save_draw_stream() noexcept;
+
+   // Returns the id for object in the draw stream being recorded, keeping
+   // object alive until the capture is saved so its address can't be reused by
+   // another object and end up sharing its id.
+   template<typename Object>
+   auto draw_stream_object(const void* const key, Object object) noexcept
+      -> Draw_stream_object
+   {
+      const Draw_stream_object id = _draw_stream_recorder->object(key);
+
+      if (id > _draw_stream_objects.size()) {
+         _draw_stream_objects.emplace_back(std::move(object));
+      }
+
+      return id;
+   }
+
+   static auto load_patch_texture_async(ID3D11Device5& device,
+                                        const std::span<const std::byte> data) noexcept
+      -> Loaded_patch_texture;
+
    constexpr static auto _game_backbuffer_index = Game_rendertarget_id{0};
 
    const Com_ptr<ID3D11Device5> _device;
@@ -333,6 +401,8 @@ private:
    float _expected_aspect_ratio = 0.75f;
    Swapchain _swapchain;
 
+   Game_buffer_arena _game_buffer_arena{_device};
+
    Input_layout_descriptions _input_layout_descriptions;
    shader::Database _shader_database{_device,
                                      {.shader_cache = user_config.developer.shader_cache_path,
@@ -376,6 +446,14 @@ private:
    Com_ptr<ID3D11Buffer> _game_vertex_buffer;
    UINT _game_vertex_buffer_offset = 0;
    UINT _game_vertex_buffer_stride = 0;
+
+   // The arena buffers (if any) the above were resolved from and the offsets
+   // the game bound them with, kept to resolve them again should the arena
+   // move them.
+   Game_buffer _game_index_buffer_source;
+   UINT _game_index_buffer_source_offset = 0;
+   Game_buffer _game_vertex_buffer_source;
+   UINT _game_vertex_buffer_source_offset = 0;
    Com_ptr<ID3D11RasterizerState> _game_rs_state;
    Com_ptr<ID3D11DepthStencilState> _game_depthstencil_state;
    Com_ptr<ID3D11BlendState1> _game_blend_state_override;
@@ -401,10 +479,6 @@ private:
    bool _ps_extra_textures_dirty = true;
    bool _ps_textures_material_wants_refraction = false;
    bool _ps_textures_shader_wants_refraction = false;
-   bool _cb_scene_dirty = true;
-   bool _cb_draw_dirty = true;
-   bool _cb_skin_dirty = true;
-   bool _cb_draw_ps_dirty = true;
    bool _projtex_mode_dirty = true;
 
    // Frame State
@@ -438,6 +512,11 @@ private:
    cb::Skin _cb_skin{};
    cb::Draw_ps _cb_draw_ps{};
 
+   Constant_buffer_upload_tracker<cb::Scene> _cb_scene_tracker;
+   Constant_buffer_upload_tracker<cb::Draw> _cb_draw_tracker;
+   Constant_buffer_upload_tracker<cb::Skin> _cb_skin_tracker;
+   Constant_buffer_upload_tracker<cb::Draw_ps> _cb_draw_ps_tracker;
+
    const Com_ptr<ID3D11Buffer> _cb_scene_buffer =
       create_dynamic_constant_buffer(*_device, sizeof(_cb_scene));
    const Com_ptr<ID3D11Buffer> _cb_draw_buffer =
@@ -574,7 +653,19 @@ private:
 
    material::Factory _material_factory{_device, _shader_rendertypes_database,
                                        _shader_resource_database};
-   std::vector<std::unique_ptr<material::Material>> _materials;
+   material::Material_registry _materials;
+
+   const Patch_texture_placeholders _patch_texture_placeholders{*_device};
+   Patch_texture_loader _patch_texture_loader{
+      [device = _device](const std::span<const std::byte> data) {
+         return load_patch_texture_async(*device, data);
+      },
+      2};
+
+   // The SRV currently in the database for each live patch texture, either
+   // its placeholder or once retired the loaded texture.
+   absl::flat_hash_map<Patch_texture_loader::Ticket, ID3D11ShaderResourceView*>
+      _patch_textures;
 
    glm::mat4 _informal_projection_matrix;
    glm::mat4 _informal_view_matrix;
@@ -605,6 +696,18 @@ private:
 
    std::unique_ptr<BF2_log_monitor> _bf2_log_monitor;
 
+   using Draw_stream_live_object =
+      std::variant<Com_ptr<ID3D11Buffer>, Com_ptr<ID3D11RasterizerState>,
+                   Com_ptr<ID3D11DepthStencilState>, Com_ptr<ID3D11BlendState1>,
+                   Com_ptr<ID3D11Query>, Game_texture, material::Material*>;
+
+   std::unique_ptr<Draw_stream_recorder> _draw_stream_recorder;
+   std::vector<Draw_stream_live_object> _draw_stream_objects; // Indexed by id - 1.
+   std::vector<std::unique_ptr<material::Material>> _draw_stream_retired_materials;
+   std::optional<Draw_stream_replay_stats> _draw_stream_replay_stats;
+   Draw_stream_op_counts _draw_stream_redundant{};
+   int _draw_stream_capture_frames = 1;
+
    tools::Pixel_inspector _pixel_inspector{_device, _shader_database};
 };
 }
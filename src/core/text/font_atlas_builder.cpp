@@ -1,14 +1,20 @@
 
 #include "font_atlas_builder.hpp"
 #include "../../freetype_helpers.hpp"
+#include "../../game_support/font_cache.hpp"
 #include "../../game_support/font_info.hpp"
 #include "../../logger.hpp"
 #include "../../user_config.hpp"
 #include "../../windows_fonts_folder.hpp"
+#include "glyph_atlas.hpp"
+#include "skyline_packer.hpp"
 #include "utility.hpp"
 
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
 #include <execution>
 #include <filesystem>
 #include <numeric>
@@ -39,15 +45,6 @@ struct Rendered_glyph {
    std::vector<std::byte> data;
 };
 
-struct Glyph_location {
-   float left;
-   float right;
-   float top;
-   float bottom;
-};
-
-static_assert(sizeof(Glyph_location) == 16);
-
 auto copy_freetype_bitmap(FT_Bitmap bitmap) -> Rendered_glyph
 {
    Rendered_glyph glyph{.width = bitmap.width, .height = bitmap.rows};
@@ -62,81 +59,114 @@ auto copy_freetype_bitmap(FT_Bitmap bitmap) -> Rendered_glyph
    return glyph;
 }
 
-struct Pack_target {
-   std::uint32_t pitch;
-   std::span<std::byte> data;
-   float width;
-   float height;
-   std::span<Glyph_location, glyph_count> locations;
-};
+auto font_cache_directory() -> std::filesystem::path
+{
+   return user_config.developer.shader_cache_path.parent_path() / L".font_cache"sv;
+}
 
-auto pack_glyphs(const std::array<Rendered_glyph, glyph_count>& rendered_glyphs,
-                 std::optional<Pack_target> output)
-   -> std::pair<std::uint32_t, std::uint32_t>
+auto render_glyphs(FT_Face face, const std::uint32_t pixel_size,
+                   const std::atomic_bool& cancel)
+   -> std::optional<std::array<Rendered_glyph, glyph_count>>
+{
+   FT_Set_Pixel_Sizes(face, 0, pixel_size);
+
+   std::array<Rendered_glyph, glyph_count> rendered_glyphs;
+
+   for (std::size_t i = 0; i < rendered_glyphs.size(); ++i) {
+      if (cancel.load(std::memory_order_relaxed)) return std::nullopt;
+
+      auto glyph_index = FT_Get_Char_Index(face, game_glyphs[i]);
+
+      freetype_checked_call(FT_Load_Glyph(face, glyph_index, FT_LOAD_NO_BITMAP));
+
+      freetype_checked_call(FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL));
+
+      rendered_glyphs[i] = copy_freetype_bitmap(face->glyph->bitmap);
+   }
+
+   return rendered_glyphs;
+}
+
+auto pack_glyphs(const std::array<Rendered_glyph, glyph_count>& rendered_glyphs)
+   -> Glyph_atlas
 {
    static_assert(glyph_count <= std::numeric_limits<std::uint8_t>::max());
    std::array<std::uint8_t, glyph_count> pack_order;
 
    std::iota(pack_order.begin(), pack_order.end(), std::uint8_t{0});
 
+   // Tallest first, breaking ties on the index keeps the atlas deterministic.
    std::ranges::sort(pack_order, [&](const std::uint8_t l, const std::uint8_t r) {
-      return rendered_glyphs[l].height < rendered_glyphs[r].height;
+      const Rendered_glyph& l_glyph = rendered_glyphs[l];
+      const Rendered_glyph& r_glyph = rendered_glyphs[r];
+
+      if (l_glyph.height != r_glyph.height) return l_glyph.height > r_glyph.height;
+      if (l_glyph.width != r_glyph.width) return l_glyph.width > r_glyph.width;
+
+      return l < r;
    });
 
    constexpr std::uint32_t atlas_max_width = 8192;
    constexpr std::uint32_t atlas_max_height = 8192;
 
-   std::uint32_t max_row_height = 0;
-   std::uint32_t pack_head_x = 0;
-   std::uint32_t pack_head_y = 0;
-   bool multiple_rows = false;
+   // Glyphs are packed with a pixel of padding to their right and bottom. The
+   // packing width is picked to make the atlas roughly square.
+   std::uint64_t padded_area = 0;
+   std::uint32_t max_padded_width = 1;
+
+   for (const auto& glyph : rendered_glyphs) {
+      padded_area += std::uint64_t{glyph.width + 1} * (glyph.height + 1);
+      max_padded_width = std::max(max_padded_width, glyph.width + 1);
+   }
+
+   if (max_padded_width > atlas_max_width) {
+      log_and_terminate("Required font atlas is too big!"sv);
+   }
+
+   const std::uint32_t pack_width =
+      std::clamp(std::bit_ceil(static_cast<std::uint32_t>(
+                    std::ceil(std::sqrt(static_cast<double>(padded_area))))),
+                 max_padded_width, atlas_max_width);
+
+   Skyline_packer packer{pack_width, atlas_max_height};
+   std::array<Skyline_packer::Position, glyph_count> positions;
+
+   Glyph_atlas atlas{.width = 1, .height = 1};
 
    for (auto i : pack_order) {
-      auto& glyph = rendered_glyphs[i];
+      const Rendered_glyph& glyph = rendered_glyphs[i];
 
-      if ((pack_head_x + glyph.width) >= atlas_max_width) {
-         if ((pack_head_y += (std::exchange(max_row_height, 0) + 1)) >= atlas_max_height) {
-            log_and_terminate("Required font atlas is too big!"sv);
-         }
+      const auto position = packer.pack(glyph.width + 1, glyph.height + 1);
 
-         multiple_rows = true;
-         pack_head_x = 0;
-      }
+      if (!position) log_and_terminate("Required font atlas is too big!"sv);
 
-      if (output) {
-         for (std::uint32_t y = 0; y < glyph.height; ++y) {
-            auto* const dest_row = &output->data[(pack_head_y + y) * output->pitch];
-            auto* const dest = dest_row + pack_head_x;
-            auto* const src = glyph.data.data() + (y * glyph.width);
-
-            std::memcpy(dest, src, glyph.width);
-         }
-
-         const float atlas_left = (pack_head_x + 0.5f) / output->width;
-         const float atlas_right = (pack_head_x + glyph.width + 0.5f) / output->width;
-         const float atlas_top = (pack_head_y + 0.5f) / output->height;
-         const float atlas_bottom =
-            (pack_head_y + glyph.height + 0.5f) / output->height;
-
-         output->locations[i] = {.left = atlas_left,
-                                 .right = atlas_right,
-                                 .top = atlas_top,
-                                 .bottom = atlas_bottom};
-      }
+      positions[i] = *position;
 
-      pack_head_x += glyph.width + 1;
-      max_row_height = std::max(glyph.height, max_row_height);
+      atlas.width = std::max(atlas.width, position->x + glyph.width);
+      atlas.height = std::max(atlas.height, position->y + glyph.height);
    }
 
-   if ((pack_head_y += max_row_height) >= atlas_max_height) {
-      log_and_terminate("Required font atlas is too big!"sv);
-   }
+   atlas.pixels.resize(atlas.width * atlas.height);
+
+   const float atlas_width = static_cast<float>(atlas.width);
+   const float atlas_height = static_cast<float>(atlas.height);
 
-   const std::uint32_t atlas_width =
-      multiple_rows ? atlas_max_width : (pack_head_x - 1);
-   const std::uint32_t atlas_height = pack_head_y;
+   for (std::size_t i = 0; i < glyph_count; ++i) {
+      const Rendered_glyph& glyph = rendered_glyphs[i];
+      const auto [x, y] = positions[i];
+
+      for (std::uint32_t row = 0; row < glyph.height; ++row) {
+         std::memcpy(&atlas.pixels[(y + row) * atlas.width + x],
+                     glyph.data.data() + (row * glyph.width), glyph.width);
+      }
 
-   return {atlas_width, atlas_height};
+      atlas.locations[i] = {.left = (x + 0.5f) / atlas_width,
+                            .right = (x + glyph.width + 0.5f) / atlas_width,
+                            .top = (y + 0.5f) / atlas_height,
+                            .bottom = (y + glyph.height + 0.5f) / atlas_height};
+   }
+
+   return atlas;
 }
 
 }
@@ -145,12 +175,15 @@ struct Freetype_state {
    explicit Freetype_state(std::vector<FT_Byte> font_data) noexcept
       : font_data{std::move(font_data)}
    {
+      font_hash = game_support::hash_font_data(std::as_bytes(std::span{this->font_data}));
+
       for (auto& face : faces) {
          face = make_freetype_face(library, this->font_data);
       }
    }
 
    std::vector<FT_Byte> font_data;
+   std::uint64_t font_hash = 0;
    Freetype_ptr<FT_Library, FT_Done_FreeType> library = make_freetype_library();
    std::array<Freetype_ptr<FT_Face, FT_Done_Face>, atlas_count> faces;
 };
@@ -218,42 +251,36 @@ void Font_atlas_builder::build_atlases(const std::uint32_t dpi) noexcept
 void Font_atlas_builder::build_atlas(const std::size_t atlas_index,
                                      const std::uint32_t dpi) noexcept
 {
-   FT_Face face = _freetype_state->faces[atlas_index].get();
-
-   FT_Set_Pixel_Sizes(face, 0, atlas_font_sizes[atlas_index] * dpi / base_dpi);
-
-   std::array<Rendered_glyph, glyph_count> rendered_glyphs;
-
-   for (std::size_t i = 0; i < rendered_glyphs.size(); ++i) {
-      if (_cancel_build.load(std::memory_order_relaxed)) return;
-
-      auto glyph_index = FT_Get_Char_Index(face, game_glyphs[i]);
-
-      freetype_checked_call(FT_Load_Glyph(face, glyph_index, FT_LOAD_NO_BITMAP));
-
-      freetype_checked_call(FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL));
-
-      auto& bitmap = face->glyph->bitmap;
-
-      rendered_glyphs[i] = copy_freetype_bitmap(bitmap);
+   const game_support::Font_cache_key cache_key{
+      .font_hash = _freetype_state->font_hash,
+      .freetype_version = freetype_version,
+      .pixel_size = atlas_font_sizes[atlas_index] * dpi / base_dpi,
+      .dpi = dpi};
+
+   std::optional<Glyph_atlas> atlas;
+
+   if (const auto payload = game_support::load_font_cache(font_cache_directory(),
+                                                          "atlas"sv, cache_key);
+       payload) {
+      atlas = deserialize_atlas(*payload);
    }
 
-   const auto [atlas_width, atlas_height] = pack_glyphs(rendered_glyphs, std::nullopt);
+   const bool from_cache = atlas.has_value();
 
-   std::vector<std::byte> atlas_data;
-   atlas_data.resize(atlas_width * atlas_height);
+   if (!atlas) {
+      const auto rendered_glyphs =
+         render_glyphs(_freetype_state->faces[atlas_index].get(),
+                       cache_key.pixel_size, _cancel_build);
 
-   std::array<Glyph_location, glyph_count> atlas_locations;
+      if (!rendered_glyphs) return;
 
-   pack_glyphs(rendered_glyphs,
-               Pack_target{.pitch = atlas_width,
-                           .data = atlas_data,
-                           .width = static_cast<float>(atlas_width),
-                           .height = static_cast<float>(atlas_height),
-                           .locations = atlas_locations});
+      atlas = pack_glyphs(*rendered_glyphs);
+   }
 
    if (_cancel_build.load(std::memory_order_relaxed)) return;
 
+   const auto& atlas_locations = atlas->locations;
+
    const D3D11_BUFFER_DESC buffer_desc{.ByteWidth = sizeof(atlas_locations),
                                        .Usage = D3D11_USAGE_IMMUTABLE,
                                        .BindFlags = D3D11_BIND_SHADER_RESOURCE,
@@ -283,18 +310,18 @@ void Font_atlas_builder::build_atlas(const std::size_t atlas_index,
       log_and_terminate("Failed to create SRV for font atlas index!"sv);
    }
 
-   const D3D11_TEXTURE2D_DESC texture_desc{.Width = atlas_width,
-                                           .Height = atlas_height,
+   const D3D11_TEXTURE2D_DESC texture_desc{.Width = atlas->width,
+                                           .Height = atlas->height,
                                            .MipLevels = 1,
                                            .ArraySize = 1,
                                            .Format = atlas_format,
                                            .SampleDesc = {1, 0},
                                            .Usage = D3D11_USAGE_IMMUTABLE,
                                            .BindFlags = D3D11_BIND_SHADER_RESOURCE};
-   const D3D11_SUBRESOURCE_DATA init_texture_data{.pSysMem = atlas_data.data(),
-                                                  .SysMemPitch = atlas_width,
+   const D3D11_SUBRESOURCE_DATA init_texture_data{.pSysMem = atlas->pixels.data(),
+                                                  .SysMemPitch = atlas->width,
                                                   .SysMemSlicePitch =
-                                                     atlas_width * atlas_height};
+                                                     atlas->width * atlas->height};
 
    Com_ptr<ID3D11Texture2D> atlas_texture;
    if (FAILED(_device->CreateTexture2D(&texture_desc, &init_texture_data,
@@ -308,13 +335,21 @@ void Font_atlas_builder::build_atlas(const std::size_t atlas_index,
       log_and_terminate("Failed to create SRV for font atlas!"sv);
    }
 
-   std::scoped_lock lock{_atlas_mutex};
+   {
+      std::scoped_lock lock{_atlas_mutex};
 
-   _atlas_index_buffer[atlas_index] = atlas_index_buffer;
-   _atlas_index_srv[atlas_index] = atlas_index_srv;
-   _atlas_texture[atlas_index] = atlas_texture;
-   _atlas_texture_srv[atlas_index] = atlas_texture_srv;
-   _atlas_dirty[atlas_index].store(true);
+      _atlas_index_buffer[atlas_index] = atlas_index_buffer;
+      _atlas_index_srv[atlas_index] = atlas_index_srv;
+      _atlas_texture[atlas_index] = atlas_texture;
+      _atlas_texture_srv[atlas_index] = atlas_texture_srv;
+      _atlas_dirty[atlas_index].store(true);
+   }
+
+   // Saved after the atlas is in use so a cache miss doesn't delay it further.
+   if (!from_cache) {
+      game_support::save_font_cache(font_cache_directory(), "atlas"sv, cache_key,
+                                    serialize_atlas(*atlas));
+   }
 }
 
 }
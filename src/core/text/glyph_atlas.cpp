@@ -0,0 +1,72 @@
+
+#include "glyph_atlas.hpp"
+
+#include <cstring>
+
+namespace sp::core::text {
+
+namespace {
+
+// An atlas in the font cache, followed by width * height pixels.
+struct Cached_atlas_header {
+   std::uint32_t width;
+   std::uint32_t height;
+   std::array<Glyph_location, game_support::glyph_count> locations;
+};
+
+}
+
+auto serialize_atlas(const Glyph_atlas& atlas) -> std::vector<std::byte>
+{
+   const Cached_atlas_header header{.width = atlas.width,
+                                    .height = atlas.height,
+                                    .locations = atlas.locations};
+
+   std::vector<std::byte> payload;
+   payload.resize(sizeof(Cached_atlas_header) + atlas.pixels.size());
+
+   std::memcpy(payload.data(), &header, sizeof(Cached_atlas_header));
+   std::memcpy(payload.data() + sizeof(Cached_atlas_header), atlas.pixels.data(),
+               atlas.pixels.size());
+
+   return payload;
+}
+
+auto deserialize_atlas(const std::span<const std::byte> payload)
+   -> std::optional<Glyph_atlas>
+{
+   if (payload.size() < sizeof(Cached_atlas_header)) return std::nullopt;
+
+   Cached_atlas_header header;
+
+   std::memcpy(&header, payload.data(), sizeof(Cached_atlas_header));
+
+   if (header.width == 0 || header.width > 8192 || header.height == 0 ||
+       header.height > 8192 ||
+       payload.size() != sizeof(Cached_atlas_header) +
+                            std::size_t{header.width} * header.height) {
+      return std::nullopt;
+   }
+
+   // Locations are offset by half a texel so they can reach just past 1.0.
+   const float max_right = (header.width + 0.5f) / header.width;
+   const float max_bottom = (header.height + 0.5f) / header.height;
+
+   for (const Glyph_location& location : header.locations) {
+      // Written so NaNs fail too.
+      if (!(location.left >= 0.0f && location.left <= location.right &&
+            location.right <= max_right && location.top >= 0.0f &&
+            location.top <= location.bottom && location.bottom <= max_bottom)) {
+         return std::nullopt;
+      }
+   }
+
+   const auto pixels = payload.subspan(sizeof(Cached_atlas_header));
+
+   return Glyph_atlas{.width = header.width,
+                      .height = header.height,
+                      .locations = header.locations,
+                      .pixels = {pixels.begin(), pixels.end()}};
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../../game_support/font_info.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace sp::core::text {
+
+struct Glyph_location {
+   float left;
+   float right;
+   float top;
+   float bottom;
+};
+
+static_assert(sizeof(Glyph_location) == 16);
+
+struct Glyph_atlas {
+   std::uint32_t width = 0;
+   std::uint32_t height = 0;
+   std::array<Glyph_location, game_support::glyph_count> locations{};
+   std::vector<std::byte> pixels;
+};
+
+// Serializes an atlas into a font cache payload.
+auto serialize_atlas(const Glyph_atlas& atlas) -> std::vector<std::byte>;
+
+// Reads back an atlas from a font cache payload. Returns nullopt if the payload
+// is truncated or describes an atlas that could not have been built.
+auto deserialize_atlas(const std::span<const std::byte> payload)
+   -> std::optional<Glyph_atlas>;
+
+}
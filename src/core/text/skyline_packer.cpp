@@ -0,0 +1,99 @@
+
+#include "skyline_packer.hpp"
+
+#include <algorithm>
+
+namespace sp::core::text {
+
+Skyline_packer::Skyline_packer(const std::uint32_t width,
+                               const std::uint32_t max_height) noexcept
+   : _width{width}, _max_height{max_height}
+{
+   _skyline.push_back({.x = 0, .y = 0, .width = width});
+}
+
+auto Skyline_packer::pack(const std::uint32_t width, const std::uint32_t height) noexcept
+   -> std::optional<Position>
+{
+   std::optional<std::size_t> best_index;
+   std::uint32_t best_y = 0;
+
+   for (std::size_t i = 0; i < _skyline.size(); ++i) {
+      const auto y = fit(i, width);
+
+      if (!y || *y + height > _max_height) continue;
+
+      if (!best_index || *y < best_y) {
+         best_index = i;
+         best_y = *y;
+      }
+   }
+
+   if (!best_index) return std::nullopt;
+
+   const Position position{.x = _skyline[*best_index].x, .y = best_y};
+
+   // Zero sized rectangles still get a position but leave the skyline alone.
+   if (width != 0 && height != 0) {
+      place(*best_index, {.x = position.x, .y = best_y + height, .width = width});
+   }
+
+   return position;
+}
+
+auto Skyline_packer::fit(const std::size_t index, const std::uint32_t width) const noexcept
+   -> std::optional<std::uint32_t>
+{
+   const std::uint32_t x = _skyline[index].x;
+
+   if (width > _width - x) return std::nullopt;
+
+   std::uint32_t y = 0;
+   std::uint32_t remaining = width;
+
+   for (std::size_t i = index; remaining > 0; ++i) {
+      y = std::max(y, _skyline[i].y);
+      remaining -= std::min(remaining, _skyline[i].width);
+   }
+
+   return y;
+}
+
+void Skyline_packer::place(const std::size_t index, const Segment segment) noexcept
+{
+   _skyline.insert(_skyline.begin() + index, segment);
+
+   const std::uint32_t segment_right = segment.x + segment.width;
+
+   // Trim the segments now underneath the new one.
+   for (std::size_t i = index + 1; i < _skyline.size();) {
+      Segment& covered = _skyline[i];
+
+      if (covered.x >= segment_right) break;
+
+      const std::uint32_t overlap = segment_right - covered.x;
+
+      if (overlap < covered.width) {
+         covered.x += overlap;
+         covered.width -= overlap;
+
+         break;
+      }
+
+      _skyline.erase(_skyline.begin() + i);
+   }
+
+   for (std::size_t i = 0; i + 1 < _skyline.size();) {
+      if (_skyline[i].y == _skyline[i + 1].y) {
+         _skyline[i].width += _skyline[i + 1].width;
+         _skyline.erase(_skyline.begin() + i + 1);
+      }
+      else {
+         ++i;
+      }
+   }
+
+   _height = std::max(_height, segment.y);
+}
+
+}
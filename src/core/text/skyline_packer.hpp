@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace sp::core::text {
+
+// Packs rectangles into an area of fixed width using the skyline bottom-left
+// heuristic, each rectangle goes wherever its top edge ends up lowest (leftmost
+// on ties). The result depends only on the sizes and order of the rectangles
+// packed.
+class Skyline_packer {
+public:
+   struct Position {
+      std::uint32_t x;
+      std::uint32_t y;
+   };
+
+   Skyline_packer(const std::uint32_t width, const std::uint32_t max_height) noexcept;
+
+   // Returns nullopt if the rectangle does not fit.
+   auto pack(const std::uint32_t width, const std::uint32_t height) noexcept
+      -> std::optional<Position>;
+
+   // The height of the tallest point of the skyline.
+   auto height() const noexcept -> std::uint32_t
+   {
+      return _height;
+   }
+
+private:
+   struct Segment {
+      std::uint32_t x;
+      std::uint32_t y;
+      std::uint32_t width;
+   };
+
+   auto fit(const std::size_t index, const std::uint32_t width) const noexcept
+      -> std::optional<std::uint32_t>;
+
+   void place(const std::size_t index, const Segment segment) noexcept;
+
+   const std::uint32_t _width;
+   const std::uint32_t _max_height;
+   std::uint32_t _height = 0;
+
+   std::vector<Segment> _skyline;
+};
+
+}
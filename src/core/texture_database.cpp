@@ -76,14 +76,11 @@ auto Shader_resource_database::at_if(const std::string_view name) const noexcept
 auto Shader_resource_database::reverse_lookup(ID3D11ShaderResourceView* srv) noexcept
    -> Reverse_lookup_result
 {
-   auto it = std::find_if(_resources.cbegin(), _resources.cend(),
-                          [srv](const auto& res) { return res.first == srv; });
+   const auto name = _resources.reverse_lookup(srv);
 
-   if (it == _resources.cend()) {
-      return {.found = false};
-   }
+   if (!name) return {.found = false};
 
-   return {.found = true, .name = it->second};
+   return {.found = true, .name = *name};
 }
 
 void Shader_resource_database::insert(Com_ptr<ID3D11ShaderResourceView> srv,
@@ -91,34 +88,30 @@ void Shader_resource_database::insert(Com_ptr<ID3D11ShaderResourceView> srv,
 {
    std::string name_str{name.empty() ? unknown_resource_name(*srv) : name};
 
-   if (auto it =
-          std::find_if(_resources.begin(), _resources.end(),
-                       [&](const auto& res) { return res.second == name_str; });
-       it != _resources.end()) {
-      it->first = std::move(srv);
+   _resources.insert(std::move(srv), std::move(name_str));
+}
 
-      return;
-   }
+void Shader_resource_database::insert_deferred(Deferred_load load,
+                                               const std::string_view name) noexcept
+{
+   Expects(!name.empty());
 
-   _resources.emplace_back(std::move(srv), std::move(name_str));
+   _resources.insert_deferred(std::move(load), name);
 }
 
 void Shader_resource_database::erase(ID3D11ShaderResourceView* srv) noexcept
 {
-   auto it = std::find_if(_resources.cbegin(), _resources.cend(),
-                          [srv](const auto& res) { return res.first == srv; });
-
-   if (it == _resources.cend()) {
+   if (!_resources.erase(srv)) {
       log_and_terminate("Attempt to erase shader resource not present in database!"sv);
    }
-
-   _resources.erase(it);
 }
 
 auto Shader_resource_database::imgui_resource_picker() noexcept -> Imgui_pick_result
 {
    Imgui_pick_result result{};
 
+   _resources.load_all_deferred();
+
    ImGui::InputText("Filter", _imgui_filter);
 
    ImGui::BeginChild("Resource List", {400.f, 64.0f * 10.0f});
@@ -161,10 +154,7 @@ auto Shader_resource_database::lookup(const std::string_view name) const noexcep
 {
    if (name.front() == '$') return builtin_lookup(name);
 
-   auto it = std::find_if(_resources.cbegin(), _resources.cend(),
-                          [name](const auto& res) { return res.second == name; });
-
-   return (it != _resources.cend()) ? it->first.get() : nullptr;
+   return _resources.find(name);
 }
 
 auto Shader_resource_database::builtin_lookup(const std::string_view name) const noexcept
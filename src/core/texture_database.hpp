@@ -1,18 +1,25 @@
 #pragma once
 
 #include "com_ptr.hpp"
+#include "named_resource_table.hpp"
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
 #include <gsl/gsl>
 
 #include <d3d11_1.h>
 
 namespace sp::core {
 
+// Not thread safe, not even for const use. Lookups may create deferred
+// resources and so write to the database, it must only be used from the
+// rendering thread like the rest of Shader_patch's state.
 class Shader_resource_database {
 public:
    struct Imgui_pick_result {
@@ -30,9 +37,27 @@ public:
 
    auto reverse_lookup(ID3D11ShaderResourceView* srv) noexcept -> Reverse_lookup_result;
 
+   // Bumped whenever what a name looks up to may have changed, like when a
+   // texture loaded in the background replaces its placeholder. Anything
+   // holding onto a looked up resource should look it up again when this
+   // changes.
+   auto generation() const noexcept -> std::uint64_t
+   {
+      return _resources.generation();
+   }
+
    void insert(Com_ptr<ID3D11ShaderResourceView> texture_srv,
                const std::string_view name) noexcept;
 
+   // Creates the resource on first use. Returning null drops the resource.
+   using Deferred_load =
+      Named_resource_table<Com_ptr<ID3D11ShaderResourceView>>::Deferred_load;
+
+   // Adds a resource that is only created by load the first time it is looked
+   // up. Ignored if a resource with the name already exists, inserting one
+   // later replaces it.
+   void insert_deferred(Deferred_load load, const std::string_view name) noexcept;
+
    void erase(ID3D11ShaderResourceView* srv) noexcept;
 
    auto imgui_resource_picker() noexcept -> Imgui_pick_result;
@@ -44,12 +69,9 @@ private:
    auto builtin_lookup(const std::string_view name) const noexcept
       -> ID3D11ShaderResourceView*;
 
-   std::vector<std::pair<Com_ptr<ID3D11ShaderResourceView>, std::string>> _resources = [] {
-      std::vector<std::pair<Com_ptr<ID3D11ShaderResourceView>, std::string>> res;
-      res.reserve(1024);
-
-      return res;
-   }();
+   // Lookups are const for users of the database but may create deferred
+   // resources, hence mutable. See the threading note above.
+   mutable Named_resource_table<Com_ptr<ID3D11ShaderResourceView>> _resources;
    std::string _imgui_filter;
 };
 }
@@ -2,30 +2,44 @@
 #include "texture_loader.hpp"
 #include "../logger.hpp"
 #include "memory_mapped_file.hpp"
-#include "patch_texture_io.hpp"
+
+#include <iomanip>
+#include <memory>
 
 namespace sp::core {
 
 auto load_texture_lvl(const std::filesystem::path lvl_path,
                       ID3D11Device1& device) noexcept -> Shader_resource_database
 {
-   try {
-      win32::Memeory_mapped_file file{lvl_path};
-      ucfb::Reader reader{file.bytes()};
-      Shader_resource_database database;
-
-      while (reader) {
-         auto [srv, name] =
-            load_patch_texture(reader.read_child_strict<"sptx"_mn>(), device);
+   std::shared_ptr<const win32::Memeory_mapped_file> file;
 
-         database.insert(std::move(srv), std::move(name));
-      }
-
-      return database;
+   try {
+      file = std::make_shared<const win32::Memeory_mapped_file>(lvl_path);
    }
    catch (std::exception& e) {
       log_and_terminate("Failed to load builtin textures! reason: ", e.what());
    }
+
+   Shader_resource_database database;
+
+   for (auto& entry : index_texture_lvl(file->bytes())) {
+      database.insert_deferred(
+         [file, chunk = entry.chunk, name = entry.name,
+          &device]() -> Com_ptr<ID3D11ShaderResourceView> {
+            try {
+               return load_patch_texture(chunk, device).first;
+            }
+            catch (std::exception& e) {
+               log(Log_level::error, "Failed to load builtin texture "sv,
+                   std::quoted(name), "! reason: "sv, e.what());
+
+               return nullptr;
+            }
+         },
+         entry.name);
+   }
+
+   return database;
 }
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "texture_database.hpp"
+#include "texture_lvl_index.hpp"
 
 #include <filesystem>
 #include <utility>
@@ -9,6 +10,8 @@ struct ID3D11Device1;
 
 namespace sp::core {
 
+// Indexes the lvl and adds its textures to a database as deferred resources,
+// each is only created the first time it is used.
 auto load_texture_lvl(const std::filesystem::path lvl_path,
                       ID3D11Device1& device) noexcept -> Shader_resource_database;
 
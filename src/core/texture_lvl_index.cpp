@@ -0,0 +1,67 @@
+
+#include "texture_lvl_index.hpp"
+#include "../logger.hpp"
+
+#include <algorithm>
+
+namespace sp::core {
+
+auto index_texture_lvl(const std::span<const std::byte> lvl_data) noexcept
+   -> std::vector<Texture_lvl_entry>
+{
+   constexpr std::size_t header_size = 8;
+
+   if (lvl_data.size() < header_size ||
+       bit_cast<Magic_number>(lvl_data) != "ucfb"_mn) {
+      log(Log_level::error, "Builtin textures lvl is not a ucfb file."sv);
+
+      return {};
+   }
+
+   const std::size_t lvl_size = bit_cast<std::uint32_t>(lvl_data.subspan(4, 4));
+   const std::size_t available_size = lvl_data.size() - header_size;
+
+   if (lvl_size > available_size) {
+      log(Log_level::warning, "Builtin textures lvl is truncated, it is "sv,
+          lvl_size - available_size, " bytes short."sv);
+   }
+
+   ucfb::Reader reader{"ucfb"_mn,
+                       lvl_data.subspan(header_size, std::min(lvl_size, available_size))};
+
+   std::vector<Texture_lvl_entry> entries;
+
+   for (std::size_t index = 0; reader; ++index) {
+      auto child = reader.read_child(std::nothrow);
+
+      if (!child) {
+         log(Log_level::warning, "Builtin texture #"sv, index,
+             " is truncated, ignoring it and the rest of the lvl."sv);
+
+         break;
+      }
+
+      if (child->magic_number() != "sptx"_mn) {
+         log(Log_level::warning, "Builtin texture #"sv, index,
+             " is not an sptx chunk, skipping it."sv);
+
+         continue;
+      }
+
+      const ucfb::Reader_strict<"sptx"_mn> sptx{*child};
+
+      try {
+         auto [info, name] = check_patch_texture(sptx);
+
+         entries.push_back({.name = std::move(name), .info = info, .chunk = sptx});
+      }
+      catch (std::exception& e) {
+         log(Log_level::warning, "Builtin texture #"sv, index,
+             " is malformed, skipping it. reason: "sv, e.what());
+      }
+   }
+
+   return entries;
+}
+
+}
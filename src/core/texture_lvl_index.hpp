@@ -0,0 +1,25 @@
+#pragma once
+
+#include "patch_texture_io.hpp"
+#include "ucfb_reader.hpp"
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace sp::core {
+
+struct Texture_lvl_entry {
+   std::string name;
+   Texture_info info;
+   ucfb::Reader_strict<"sptx"_mn> chunk;
+};
+
+// Indexes the sptx chunks of a textures lvl, reading only their headers.
+// Malformed or truncated entries are logged and left out. The entries view
+// lvl_data.
+auto index_texture_lvl(const std::span<const std::byte> lvl_data) noexcept
+   -> std::vector<Texture_lvl_entry>;
+
+}
@@ -153,9 +153,9 @@ public:
 
       _lock_offset = lock_offset;
       _lock_size = lock_size;
-      _lock_data = upload_scratch_buffer.lock(_size - lock_offset);
+      _lock_lease = upload_scratch_buffer.lock(_size - lock_offset);
 
-      *data = _lock_data;
+      *data = _lock_lease.data();
 
       return S_OK;
    }
@@ -168,11 +168,11 @@ public:
          log_and_terminate("Unexpected buffer unlock!");
       }
 
-      _shader_patch.update_ia_buffer(*_buffer, std::exchange(_lock_offset, 0),
-                                     std::exchange(_lock_size, 0),
-                                     std::exchange(_lock_data, nullptr));
+      _shader_patch.update_game_buffer(_buffer, std::exchange(_lock_offset, 0),
+                                       std::exchange(_lock_size, 0),
+                                       _lock_lease.data());
 
-      upload_scratch_buffer.unlock();
+      _lock_lease.reset();
 
       return S_OK;
    }
@@ -186,20 +186,21 @@ private:
    Basic_buffer_managed(core::Shader_patch& shader_patch, const UINT size) noexcept
       : _shader_patch{shader_patch}, _size{size}
    {
-      this->resource = _buffer.get();
+      this->resource = _buffer;
    }
 
-   ~Basic_buffer_managed() = default;
+   ~Basic_buffer_managed()
+   {
+      _shader_patch.destroy_game_buffer(_buffer);
+   }
 
    core::Shader_patch& _shader_patch;
    const UINT _size;
-   const Com_ptr<ID3D11Buffer> _buffer{
-      _shader_patch.create_ia_buffer(_size, type == Buffer_type::vertex_buffer,
-                                     type == Buffer_type::index_buffer, false)};
+   const core::Game_buffer _buffer{_shader_patch.create_game_buffer(_size)};
 
    UINT _lock_offset{};
    UINT _lock_size{};
-   std::byte* _lock_data = nullptr;
+   Upload_scratch_buffer::Lease _lock_lease;
    bool _lock_status = false;
 
    ULONG _ref_count = 1;
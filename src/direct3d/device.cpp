@@ -1262,9 +1262,13 @@ HRESULT Device::SetStreamSource(UINT stream_number, IDirect3DVertexBuffer9* stre
 
    const auto& resource = *reinterpret_cast<Resource*>(stream_data);
 
-   resource.visit([&](ID3D11Buffer* buffer) {
-      _shader_patch.set_vertex_buffer(*buffer, offset_in_bytes, stride);
-   });
+   resource.visit(
+      [&](const core::Game_buffer& buffer) {
+         _shader_patch.set_vertex_buffer(buffer, offset_in_bytes, stride);
+      },
+      [&](ID3D11Buffer* buffer) {
+         _shader_patch.set_vertex_buffer(*buffer, offset_in_bytes, stride);
+      });
 
    return S_OK;
 }
@@ -1278,6 +1282,7 @@ HRESULT Device::SetIndices(IDirect3DIndexBuffer9* index_data) noexcept
    const auto& resource = *reinterpret_cast<Resource*>(index_data);
 
    resource.visit(
+      [&](const core::Game_buffer& buffer) { _shader_patch.set_index_buffer(buffer, 0); },
       [&](ID3D11Buffer* buffer) { _shader_patch.set_index_buffer(*buffer, 0); });
 
    return S_OK;
@@ -1475,8 +1480,9 @@ auto Device::create_vertex_declaration(const D3DVERTEXELEMENT9* const vertex_ele
       }
    }
 
-   return Vertex_declaration::create(_shader_patch,
-                                     std::span{vertex_elements, decl_count});
+   return Vertex_declaration::create(
+      _vertex_declaration_cache.get(_shader_patch,
+                                    std::span{vertex_elements, decl_count}));
 }
 
 void Device::draw_common() noexcept
@@ -8,6 +8,7 @@
 #include "surface_backbuffer.hpp"
 #include "surface_depthstencil.hpp"
 #include "texture_stage_state_manager.hpp"
+#include "vertex_declaration.hpp"
 
 #include <array>
 
@@ -617,6 +618,7 @@ private:
    D3DVIEWPORT9 _viewport{0,    0,   _perceived_width, _perceived_height,
                           0.0f, 1.0f};
    Texture_stage_state_manager _texture_stage_manager{};
+   Vertex_declaration_cache _vertex_declaration_cache;
 
    ULONG _ref_count = 1;
 };
@@ -0,0 +1,77 @@
+
+#include "expand_rows.hpp"
+
+#include <emmintrin.h>
+
+namespace sp::d3d9 {
+
+void expand_l8_row_scalar(const std::byte* const src, std::byte* const dest,
+                          const std::uint32_t width) noexcept
+{
+   for (std::uint32_t x = 0; x < width; ++x) {
+      dest[x * 4 + 0] = dest[x * 4 + 1] = dest[x * 4 + 2] = src[x];
+      dest[x * 4 + 3] = std::byte{0xffu};
+   }
+}
+
+void expand_a8l8_row_scalar(const std::byte* const src, std::byte* const dest,
+                            const std::uint32_t width) noexcept
+{
+   for (std::uint32_t x = 0; x < width; ++x) {
+      dest[x * 4 + 0] = dest[x * 4 + 1] = dest[x * 4 + 2] = src[x * 2];
+      dest[x * 4 + 3] = src[x * 2 + 1];
+   }
+}
+
+// SSE2 is the baseline the patch is built for, so no runtime dispatch is needed.
+
+void expand_l8_row(const std::byte* const src, std::byte* const dest,
+                   const std::uint32_t width) noexcept
+{
+   const __m128i alpha = _mm_set1_epi8(-1);
+
+   std::uint32_t x = 0;
+
+   for (; x + 16 <= width; x += 16) {
+      const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+
+      const __m128i ll_lo = _mm_unpacklo_epi8(l, l);
+      const __m128i ll_hi = _mm_unpackhi_epi8(l, l);
+      const __m128i la_lo = _mm_unpacklo_epi8(l, alpha);
+      const __m128i la_hi = _mm_unpackhi_epi8(l, alpha);
+
+      auto* const out = reinterpret_cast<__m128i*>(dest + x * 4);
+
+      _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(ll_lo, la_lo));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(ll_lo, la_lo));
+      _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(ll_hi, la_hi));
+      _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(ll_hi, la_hi));
+   }
+
+   expand_l8_row_scalar(src + x, dest + x * 4, width - x);
+}
+
+void expand_a8l8_row(const std::byte* const src, std::byte* const dest,
+                     const std::uint32_t width) noexcept
+{
+   const __m128i luminance_mask = _mm_set1_epi16(0xff);
+
+   std::uint32_t x = 0;
+
+   for (; x + 8 <= width; x += 8) {
+      const __m128i la =
+         _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 2));
+
+      const __m128i l = _mm_and_si128(la, luminance_mask);
+      const __m128i ll = _mm_or_si128(l, _mm_slli_epi16(l, 8));
+
+      auto* const out = reinterpret_cast<__m128i*>(dest + x * 4);
+
+      _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(ll, la));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(ll, la));
+   }
+
+   expand_a8l8_row_scalar(src + x * 2, dest + x * 4, width - x);
+}
+
+}
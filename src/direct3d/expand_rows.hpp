@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sp::d3d9 {
+
+// Row kernels used to expand single and dual channel D3D9 formats that have
+// no D3D11 equivalent into R8G8B8A8. Each reads one row of width pixels from
+// src and writes width RGBA pixels to dest.
+
+// L8 -> LLL1
+void expand_l8_row(const std::byte* const src, std::byte* const dest,
+                   const std::uint32_t width) noexcept;
+
+// A8L8 -> LLLA
+void expand_a8l8_row(const std::byte* const src, std::byte* const dest,
+                     const std::uint32_t width) noexcept;
+
+// Scalar versions of the above. These are the reference the SSE2 kernels must
+// match bit for bit and also handle the pixels left over after the last full
+// vector.
+
+void expand_l8_row_scalar(const std::byte* const src, std::byte* const dest,
+                          const std::uint32_t width) noexcept;
+
+void expand_a8l8_row_scalar(const std::byte* const src, std::byte* const dest,
+                            const std::uint32_t width) noexcept;
+
+}
@@ -0,0 +1,163 @@
+
+#include "fixedfunction_state_classifier.hpp"
+
+#include <bit>
+#include <cstddef>
+
+namespace sp::d3d9 {
+
+namespace {
+
+using namespace fixedfunction_values;
+
+constexpr std::uint32_t any = 0xffffffffu;
+
+// Stage 0 and 1 color/alpha op and args, stage 2 color/alpha op, then the
+// texture factor class. Matches the layout of Fixedfunction_state_key.
+struct State_pattern {
+   Fixedfunction_shader shader;
+   std::array<std::uint32_t, 15> fields;
+};
+
+constexpr auto factor_damage = static_cast<std::uint32_t>(Texture_factor_class::damage_color);
+constexpr auto factor_white = static_cast<std::uint32_t>(Texture_factor_class::white);
+
+// clang-format off
+constexpr std::array state_patterns = {
+   State_pattern{Fixedfunction_shader::color_fill,
+                 {top_selectarg1, ta_tfactor, ta_texture,
+                  top_selectarg1, ta_tfactor, ta_texture,
+                  top_disable, any, any, top_disable, any, any,
+                  any, any,
+                  any}},
+   State_pattern{Fixedfunction_shader::damage_overlay,
+                 {top_modulate, ta_tfactor, ta_texture,
+                  top_modulate, ta_tfactor, ta_texture,
+                  top_disable, any, any, top_disable, any, any,
+                  any, any,
+                  factor_damage}},
+   State_pattern{Fixedfunction_shader::plain_texture,
+                 {top_modulate, ta_tfactor, ta_texture,
+                  top_modulate, ta_tfactor, ta_texture,
+                  top_disable, any, any, top_disable, any, any,
+                  any, any,
+                  factor_white}},
+   State_pattern{Fixedfunction_shader::scene_blur,
+                 {top_modulate, ta_tfactor, ta_texture,
+                  top_selectarg1, ta_tfactor, ta_texture,
+                  top_disable, any, any, top_disable, any, any,
+                  any, any,
+                  any}},
+   // This state is also used for the endgame screen fade.
+   State_pattern{Fixedfunction_shader::zoom_blur,
+                 {top_modulate, ta_tfactor, ta_texture,
+                  top_modulate, ta_tfactor, ta_texture,
+                  top_selectarg1, ta_current, ta_current,
+                  top_modulate, ta_tfactor, ta_texture,
+                  top_disable, top_disable,
+                  any}},
+};
+// clang-format on
+
+constexpr auto canonical_value(const std::uint32_t value) noexcept -> std::uint8_t
+{
+   return value < 0xffu ? static_cast<std::uint8_t>(value) : std::uint8_t{0xffu};
+}
+
+// Each pattern becomes a mask of the key bytes it tests and the values they
+// must hold, a state is then matched against it with two masked compares.
+using State_words = std::array<std::uint64_t, 2>;
+
+struct Compiled_pattern {
+   State_words mask;
+   State_words key;
+};
+
+constexpr auto compile_patterns() noexcept
+   -> std::array<Compiled_pattern, state_patterns.size()>
+{
+   std::array<Compiled_pattern, state_patterns.size()> compiled{};
+
+   for (std::size_t index = 0; index < state_patterns.size(); ++index) {
+      const State_pattern& pattern = state_patterns[index];
+
+      Fixedfunction_state_key mask{};
+      Fixedfunction_state_key key{};
+
+      for (std::size_t i = 0; i < pattern.fields.size(); ++i) {
+         if (pattern.fields[i] == any) continue;
+
+         mask[i] = 0xffu;
+         key[i] = canonical_value(pattern.fields[i]);
+      }
+
+      compiled[index] = {.mask = std::bit_cast<State_words>(mask),
+                         .key = std::bit_cast<State_words>(key)};
+   }
+
+   return compiled;
+}
+
+constexpr auto compiled_patterns = compile_patterns();
+
+}
+
+auto make_fixedfunction_state_key(const Fixedfunction_stage_values& values,
+                                  const Texture_factor_class texture_factor_class) noexcept
+   -> Fixedfunction_state_key
+{
+   const auto& stages = values.stages;
+
+   return {canonical_value(stages[0].colorop),
+           canonical_value(stages[0].colorarg1),
+           canonical_value(stages[0].colorarg2),
+           canonical_value(stages[0].alphaop),
+           canonical_value(stages[0].alphaarg1),
+           canonical_value(stages[0].alphaarg2),
+           canonical_value(stages[1].colorop),
+           canonical_value(stages[1].colorarg1),
+           canonical_value(stages[1].colorarg2),
+           canonical_value(stages[1].alphaop),
+           canonical_value(stages[1].alphaarg1),
+           canonical_value(stages[1].alphaarg2),
+           canonical_value(values.stage2_colorop),
+           canonical_value(values.stage2_alphaop),
+           static_cast<std::uint8_t>(texture_factor_class),
+           0};
+}
+
+auto classify_texture_factor(const std::uint32_t texture_factor) noexcept
+   -> Texture_factor_class
+{
+   constexpr auto white = 0xffffffffu;
+   constexpr auto damage_color = 0xdf2020u;
+
+   if (texture_factor == white) return Texture_factor_class::white;
+
+   if ((texture_factor & 0xffffffu) == damage_color) {
+      return Texture_factor_class::damage_color;
+   }
+
+   return Texture_factor_class::other;
+}
+
+auto classify_fixedfunction_state(const Fixedfunction_state_key& state) noexcept
+   -> Fixedfunction_shader
+{
+   const auto words = std::bit_cast<State_words>(state);
+
+   // The earliest pattern in the table wins should they ever stop being
+   // disjoint.
+   for (std::size_t index = 0; index < compiled_patterns.size(); ++index) {
+      const Compiled_pattern& pattern = compiled_patterns[index];
+
+      if ((words[0] & pattern.mask[0]) == pattern.key[0] &&
+          (words[1] & pattern.mask[1]) == pattern.key[1]) {
+         return state_patterns[index].shader;
+      }
+   }
+
+   return Fixedfunction_shader::unknown;
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace sp::d3d9 {
+
+// Picks the game shader that implements the fixed function texture stage
+// state the game has set. Kept free of the D3D9 headers, the stage values are
+// plain DWORDs.
+
+enum class Fixedfunction_shader : std::uint8_t {
+   color_fill,
+   damage_overlay,
+   plain_texture,
+   scene_blur,
+   zoom_blur,
+   unknown
+};
+
+enum class Texture_factor_class : std::uint8_t { other, damage_color, white };
+
+// The D3DTEXTUREOP and D3DTA values the recognized states are made of.
+namespace fixedfunction_values {
+
+constexpr std::uint32_t top_disable = 1;
+constexpr std::uint32_t top_selectarg1 = 2;
+constexpr std::uint32_t top_modulate = 4;
+
+constexpr std::uint32_t ta_current = 1;
+constexpr std::uint32_t ta_texture = 2;
+constexpr std::uint32_t ta_tfactor = 3;
+
+}
+
+// The stage values a fixed function state is classified by.
+struct Fixedfunction_stage_values {
+   struct Stage {
+      std::uint32_t colorop;
+      std::uint32_t colorarg1;
+      std::uint32_t colorarg2;
+      std::uint32_t alphaop;
+      std::uint32_t alphaarg1;
+      std::uint32_t alphaarg2;
+   };
+
+   std::array<Stage, 2> stages;
+
+   std::uint32_t stage2_colorop;
+   std::uint32_t stage2_alphaop;
+};
+
+// The stage values each clamped to a byte (values that don't fit become 0xff)
+// followed by the Texture_factor_class.
+using Fixedfunction_state_key = std::array<std::uint8_t, 16>;
+
+auto make_fixedfunction_state_key(const Fixedfunction_stage_values& values,
+                                  const Texture_factor_class texture_factor_class) noexcept
+   -> Fixedfunction_state_key;
+
+auto classify_texture_factor(const std::uint32_t texture_factor) noexcept
+   -> Texture_factor_class;
+
+// Returns Fixedfunction_shader::unknown for states matching no pattern.
+auto classify_fixedfunction_state(const Fixedfunction_state_key& state) noexcept
+   -> Fixedfunction_shader;
+
+}
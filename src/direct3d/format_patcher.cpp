@@ -1,12 +1,12 @@
 
 #include "format_patcher.hpp"
 #include "../logger.hpp"
+#include "expand_rows.hpp"
 #include "upload_scratch_buffer.hpp"
 #include "utility.hpp"
 
 #include <array>
 #include <execution>
-#include <span>
 
 #include <glm/glm.hpp>
 
@@ -16,7 +16,28 @@ namespace sp::d3d9 {
 
 namespace {
 
-Upload_scratch_buffer patchup_scratch_buffer{524288u, 524288u};
+Upload_scratch_buffer patchup_scratch_buffer{524288u};
+
+// Mips smaller than this (in pixels) are expanded on the calling thread, for
+// them handing rows out to other threads costs more than the expansion.
+constexpr UINT parallel_patch_min_pixels = 256u * 256u;
+
+template<auto expand_row>
+void patch_rows(const UINT width, const UINT height, const core::Mapped_texture source,
+                const core::Mapped_texture dest) noexcept
+{
+   const auto patch_row = [&](const std::ptrdiff_t y) noexcept {
+      expand_row(source.data + (source.row_pitch * y),
+                 dest.data + (dest.row_pitch * y), width);
+   };
+
+   if (width * height < parallel_patch_min_pixels) {
+      for (UINT y = 0; y < height; ++y) patch_row(y);
+   }
+   else {
+      std::for_each_n(std::execution::par, Index_iterator{}, height, patch_row);
+   }
+}
 
 class Format_patcher_l8 final : public Format_patcher {
 public:
@@ -86,18 +107,7 @@ private:
                               core::Mapped_texture source,
                               core::Mapped_texture dest) noexcept
    {
-      std::for_each_n(std::execution::par_unseq, Index_iterator{}, height, [&](const int y) {
-         const auto src_row =
-            std::span{source.data + (source.row_pitch * y), source.row_pitch};
-         auto dest_row = std::span{dest.data + (dest.row_pitch * y), dest.row_pitch};
-
-         for (auto x = 0; x < width; ++x) {
-            auto dest_pixel = dest_row.subspan(4 * x, 4);
-
-            dest_pixel[0] = dest_pixel[1] = dest_pixel[2] = src_row[x];
-            dest_pixel[3] = std::byte{0xffu};
-         }
-      });
+      patch_rows<expand_l8_row>(width, height, source, dest);
    }
 
    UINT _dynamic_width;
@@ -173,18 +183,7 @@ private:
                               core::Mapped_texture source,
                               core::Mapped_texture dest) noexcept
    {
-      std::for_each_n(std::execution::par_unseq, Index_iterator{}, height, [&](const int y) {
-         const auto src_row =
-            std::span{source.data + (source.row_pitch * y), source.row_pitch};
-         auto dest_row = std::span{dest.data + (dest.row_pitch * y), dest.row_pitch};
-
-         for (auto x = 0; x < width; ++x) {
-            dest_row[x * 4] = src_row[x * 2];
-            dest_row[x * 4 + 1] = src_row[x * 2];
-            dest_row[x * 4 + 2] = src_row[x * 2];
-            dest_row[x * 4 + 3] = src_row[x * 2 + 1];
-         }
-      });
+      patch_rows<expand_a8l8_row>(width, height, source, dest);
    }
 
    UINT _dynamic_width;
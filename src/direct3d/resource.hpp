@@ -37,8 +37,9 @@ public:
 
    using Resource_variant =
       std::variant<std::monostate, core::Game_texture, core::Game_rendertarget_id,
-                   ID3D11Buffer*, core::Game_depthstencil, core::Texture_handle,
-                   core::Material_handle, core::Patch_effects_config_handle>;
+                   ID3D11Buffer*, core::Game_buffer, core::Game_depthstencil,
+                   core::Texture_handle, core::Material_handle,
+                   core::Patch_effects_config_handle>;
 
    template<typename Type>
    const Type* get_if() const noexcept
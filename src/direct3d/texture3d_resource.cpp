@@ -1,7 +1,6 @@
 
 #include "texture3d_resource.hpp"
 #include "debug_trace.hpp"
-#include "upload_scratch_buffer.hpp"
 #include "volume_resource.hpp"
 
 #include <span>
@@ -114,11 +113,11 @@ HRESULT Texture3d_resource::LockBox(UINT level, D3DLOCKED_BOX* locked_box,
       log_and_terminate("Unexpected volume texture lock call!");
    }
 
-   _lock_data = upload_scratch_buffer.lock(_resource_size);
+   _lock_lease = upload_scratch_buffer.lock(_resource_size);
 
    locked_box->RowPitch = _width;
    locked_box->SlicePitch = _width * _height;
-   locked_box->pBits = _lock_data;
+   locked_box->pBits = _lock_lease.data();
 
    return S_OK;
 }
@@ -135,7 +134,7 @@ HRESULT Texture3d_resource::UnlockBox(UINT level) noexcept
 
    create_resource();
 
-   upload_scratch_buffer.unlock();
+   _lock_lease.reset();
 
    return S_OK;
 }
@@ -143,13 +142,13 @@ HRESULT Texture3d_resource::UnlockBox(UINT level) noexcept
 void Texture3d_resource::create_resource() noexcept
 {
    const auto volume_res_header = bit_cast<Volume_resource_header>(
-      std::span{_lock_data, sizeof(Volume_resource_header)});
+      std::span{_lock_lease.data(), sizeof(Volume_resource_header)});
 
    if (volume_res_header.mn != "spvr"_mn) {
       log_and_terminate("Unexpected volume resource magic number!");
    }
 
-   const std::span payload{_lock_data + sizeof(Volume_resource_header),
+   const std::span payload{_lock_lease.data() + sizeof(Volume_resource_header),
                            volume_res_header.payload_size};
 
    switch (volume_res_header.type) {
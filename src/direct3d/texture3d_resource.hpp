@@ -4,6 +4,7 @@
 #include "../logger.hpp"
 #include "base_texture.hpp"
 #include "com_ptr.hpp"
+#include "upload_scratch_buffer.hpp"
 
 #include <memory>
 
@@ -137,7 +138,7 @@ private:
    const UINT _resource_size{_width * _height * _depth};
 
    bool _locked = false;
-   std::byte* _lock_data = nullptr;
+   Upload_scratch_buffer::Lease _lock_lease;
 
    ULONG _ref_count = 1;
 };
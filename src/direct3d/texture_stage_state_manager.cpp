@@ -1,21 +1,34 @@
 #include "../game_support/munged_shader_declarations.hpp"
+#include "../logger.hpp"
 #include "helpers.hpp"
 #include "texture_stage_state_manager.hpp"
 
-#include <algorithm>
 #include <gsl/gsl>
 #include <iterator>
 #include <ranges>
+#include <string>
 #include <tuple>
 
 namespace sp::d3d9 {
 
+static_assert(fixedfunction_values::top_disable == D3DTOP_DISABLE);
+static_assert(fixedfunction_values::top_selectarg1 == D3DTOP_SELECTARG1);
+static_assert(fixedfunction_values::top_modulate == D3DTOP_MODULATE);
+static_assert(fixedfunction_values::ta_current == D3DTA_CURRENT);
+static_assert(fixedfunction_values::ta_texture == D3DTA_TEXTURE);
+static_assert(fixedfunction_values::ta_tfactor == D3DTA_TFACTOR);
+static_assert(D3DCOLOR_ARGB(0xff, 0xff, 0xff, 0xff) == 0xffffffffu);
+
 void Texture_stage_state_manager::set(const UINT stage,
                                       const D3DTEXTURESTAGESTATETYPE state,
                                       const DWORD value) noexcept
 {
    Expects(stage < _stages.size());
 
+   if (get(stage, state) == value) return;
+
+   _classification_dirty = true;
+
    switch (state) {
    case D3DTSS_COLOROP:
       _stages[stage].colorop = value;
@@ -123,27 +136,34 @@ DWORD Texture_stage_state_manager::get(const UINT stage,
 
 void Texture_stage_state_manager::update(core::Shader_patch& shader_patch,
                                          const DWORD texture_factor,
-                                         const D3DVIEWPORT9& viewport) const noexcept
+                                         const D3DVIEWPORT9& viewport) noexcept
 {
-   if (is_color_fill_state()) {
-      shader_patch.set_game_shader(_color_fill_shader);
-   }
-   else if (is_damage_overlay_state(texture_factor)) {
-      shader_patch.set_game_shader(_damage_overlay_shader);
-   }
-   else if (is_plain_texture_state(texture_factor)) {
-      shader_patch.set_game_shader(_plain_texture_shader);
-   }
-   else if (is_scene_blur_state()) {
-      shader_patch.set_game_shader(_scene_blur_shader);
-   }
-   else if (is_zoom_blur_state()) { // This state is also used for the endgame screen fade.
-      shader_patch.set_game_shader(_zoom_blur_shader);
-   }
-   else {
-      log_and_terminate("Unexpected fixed function texture state!");
+   const auto texture_factor_class = classify_texture_factor(texture_factor);
+
+   if (_classification_dirty || texture_factor_class != _classified_texture_factor) {
+      const auto state_key = make_state_key(texture_factor_class);
+
+      _classified_shader = classify_fixedfunction_state(state_key);
+      _classified_texture_factor = texture_factor_class;
+      _classification_dirty = false;
+
+      if (_classified_shader == Fixedfunction_shader::unknown &&
+          _logged_unknown_states.insert(state_key).second) {
+         std::string state_hex;
+
+         for (const auto value : state_key) {
+            fmt::format_to(std::back_inserter(state_hex), "{:02x}"sv, value);
+         }
+
+         log_fmt(Log_level::warning,
+                 "Unexpected fixed function texture state {}! Using the plain "
+                 "texture shader for it."sv,
+                 state_hex);
+      }
    }
 
+   shader_patch.set_game_shader(shader_index(_classified_shader));
+
    shader_patch.set_constants(core::cb::fixedfunction,
                               {.texture_factor = unpack_d3dcolor(texture_factor),
                                .inv_resolution = {1.0f / viewport.Width,
@@ -153,86 +173,44 @@ void Texture_stage_state_manager::update(core::Shader_patch& shader_patch,
 void Texture_stage_state_manager::reset() noexcept
 {
    _stages = default_stages_state();
+   _classification_dirty = true;
 }
 
-bool Texture_stage_state_manager::is_scene_blur_state() const noexcept
-{
-   if (_stages[1].colorop != D3DTOP_DISABLE) return false;
-   if (_stages[1].alphaop != D3DTOP_DISABLE) return false;
-   if (_stages[0].colorop != D3DTOP_MODULATE) return false;
-   if (_stages[0].colorarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[0].colorarg2 != D3DTA_TEXTURE) return false;
-   if (_stages[0].alphaop != D3DTOP_SELECTARG1) return false;
-   if (_stages[0].alphaarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[0].alphaarg2 != D3DTA_TEXTURE) return false;
-
-   return true;
-}
-
-bool Texture_stage_state_manager::is_zoom_blur_state() const noexcept
+auto Texture_stage_state_manager::make_state_key(
+   const Texture_factor_class texture_factor_class) const noexcept -> State_key
 {
-   if (_stages[2].colorop != D3DTOP_DISABLE) return false;
-   if (_stages[2].alphaop != D3DTOP_DISABLE) return false;
-   if (_stages[1].colorop != D3DTOP_SELECTARG1) return false;
-   if (_stages[1].colorarg1 != D3DTA_CURRENT) return false;
-   if (_stages[1].colorarg2 != D3DTA_CURRENT) return false;
-   if (_stages[1].alphaop != D3DTOP_MODULATE) return false;
-   if (_stages[1].alphaarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[1].alphaarg2 != D3DTA_TEXTURE) return false;
-   if (_stages[0].colorop != D3DTOP_MODULATE) return false;
-   if (_stages[0].colorarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[0].colorarg2 != D3DTA_TEXTURE) return false;
-   if (_stages[0].alphaop != D3DTOP_MODULATE) return false;
-   if (_stages[0].alphaarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[0].alphaarg2 != D3DTA_TEXTURE) return false;
-
-   return true;
+   const auto stage_values = [this](const UINT stage) {
+      return Fixedfunction_stage_values::Stage{_stages[stage].colorop,
+                                               _stages[stage].colorarg1,
+                                               _stages[stage].colorarg2,
+                                               _stages[stage].alphaop,
+                                               _stages[stage].alphaarg1,
+                                               _stages[stage].alphaarg2};
+   };
+
+   return make_fixedfunction_state_key({.stages = {stage_values(0), stage_values(1)},
+                                        .stage2_colorop = _stages[2].colorop,
+                                        .stage2_alphaop = _stages[2].alphaop},
+                                       texture_factor_class);
 }
 
-bool Texture_stage_state_manager::is_damage_overlay_state(const DWORD texture_factor) const noexcept
+auto Texture_stage_state_manager::shader_index(const Fixedfunction_shader shader) const
+   noexcept -> std::uint32_t
 {
-   constexpr auto damage_color = 0xdf2020u;
-
-   if (_stages[1].colorop != D3DTOP_DISABLE) return false;
-   if (_stages[1].alphaop != D3DTOP_DISABLE) return false;
-   if (_stages[0].colorop != D3DTOP_MODULATE) return false;
-   if (_stages[0].colorarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[0].colorarg2 != D3DTA_TEXTURE) return false;
-   if (_stages[0].alphaop != D3DTOP_MODULATE) return false;
-   if (_stages[0].alphaarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[0].alphaarg2 != D3DTA_TEXTURE) return false;
-   if ((texture_factor & 0xffffffu) != damage_color) return false;
-
-   return true;
-}
-
-bool Texture_stage_state_manager::is_plain_texture_state(const DWORD texture_factor) const noexcept
-{
-   if (_stages[1].colorop != D3DTOP_DISABLE) return false;
-   if (_stages[1].alphaop != D3DTOP_DISABLE) return false;
-   if (_stages[0].colorop != D3DTOP_MODULATE) return false;
-   if (_stages[0].colorarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[0].colorarg2 != D3DTA_TEXTURE) return false;
-   if (_stages[0].alphaop != D3DTOP_MODULATE) return false;
-   if (_stages[0].alphaarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[0].alphaarg2 != D3DTA_TEXTURE) return false;
-   if (texture_factor != D3DCOLOR_ARGB(0xff, 0xff, 0xff, 0xff)) return false;
-
-   return true;
-}
-
-bool Texture_stage_state_manager::is_color_fill_state() const noexcept
-{
-   if (_stages[1].colorop != D3DTOP_DISABLE) return false;
-   if (_stages[1].alphaop != D3DTOP_DISABLE) return false;
-   if (_stages[0].colorop != D3DTOP_SELECTARG1) return false;
-   if (_stages[0].colorarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[0].colorarg2 != D3DTA_TEXTURE) return false;
-   if (_stages[0].alphaop != D3DTOP_SELECTARG1) return false;
-   if (_stages[0].alphaarg1 != D3DTA_TFACTOR) return false;
-   if (_stages[0].alphaarg2 != D3DTA_TEXTURE) return false;
-
-   return true;
+   switch (shader) {
+   case Fixedfunction_shader::color_fill:
+      return _color_fill_shader;
+   case Fixedfunction_shader::damage_overlay:
+      return _damage_overlay_shader;
+   case Fixedfunction_shader::scene_blur:
+      return _scene_blur_shader;
+   case Fixedfunction_shader::zoom_blur:
+      return _zoom_blur_shader;
+   case Fixedfunction_shader::plain_texture:
+   case Fixedfunction_shader::unknown:
+   default:
+      return _plain_texture_shader;
+   }
 }
 
 auto Texture_stage_state_manager::get_game_shader_index(Rendertype rendertype,
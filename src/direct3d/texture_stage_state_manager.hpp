@@ -1,8 +1,12 @@
 #pragma once
 
 #include "../core/shader_patch.hpp"
+#include "fixedfunction_state_classifier.hpp"
 
 #include <array>
+#include <cstdint>
+
+#include <absl/container/flat_hash_set.h>
 
 #include <d3d9.h>
 
@@ -16,20 +20,19 @@ public:
    DWORD get(const UINT stage, const D3DTEXTURESTAGESTATETYPE state) const noexcept;
 
    void update(core::Shader_patch& shader_patch, const DWORD texture_factor,
-               const D3DVIEWPORT9& viewport) const noexcept;
+               const D3DVIEWPORT9& viewport) noexcept;
 
    void reset() noexcept;
 
-private:
-   bool is_scene_blur_state() const noexcept;
-
-   bool is_zoom_blur_state() const noexcept;
-
-   bool is_damage_overlay_state(const DWORD texture_factor) const noexcept;
+   using Fixedfunction_shader = d3d9::Fixedfunction_shader;
+   using Texture_factor_class = d3d9::Texture_factor_class;
+   using State_key = Fixedfunction_state_key;
 
-   bool is_plain_texture_state(const DWORD texture_factor) const noexcept;
+private:
+   auto make_state_key(const Texture_factor_class texture_factor_class) const noexcept
+      -> State_key;
 
-   bool is_color_fill_state() const noexcept;
+   auto shader_index(const Fixedfunction_shader shader) const noexcept -> std::uint32_t;
 
    static auto get_game_shader_index(Rendertype rendertype,
                                      const std::string_view shader_name)
@@ -105,6 +108,12 @@ private:
 
    std::array<Stage_state, 4> _stages = default_stages_state();
 
+   bool _classification_dirty = true;
+   Texture_factor_class _classified_texture_factor = Texture_factor_class::other;
+   Fixedfunction_shader _classified_shader = Fixedfunction_shader::unknown;
+
+   absl::flat_hash_set<State_key> _logged_unknown_states;
+
    const std::uint32_t _color_fill_shader =
       get_game_shader_index(Rendertype::fixedfunc_color_fill, "color fill");
 
@@ -1,46 +1,327 @@
 #pragma once
 
+#include "../logger.hpp"
+
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
-
-#include <gsl/gsl>
+#include <new>
+#include <utility>
 
 namespace sp::d3d9 {
 
-class Upload_scratch_buffer {
+// Backing memory policy for Basic_upload_ring. Both the ring itself and any
+// oversize/overflow leases are allocated through it.
+struct Heap_upload_memory {
+   constexpr static std::size_t alignment = 16;
+
+   static auto allocate(const std::size_t size) noexcept -> std::byte*
+   {
+      return static_cast<std::byte*>(
+         ::operator new(size, std::align_val_t{alignment}, std::nothrow));
+   }
+
+   static void deallocate(std::byte* const memory, const std::size_t size) noexcept
+   {
+      ::operator delete(memory, size, std::align_val_t{alignment});
+   }
+};
+
+// Fixed capacity ring of upload leases. Any number of threads may hold leases
+// at once, space is reserved with a CAS on the packed (sequence, position)
+// head and reclaimed strictly in reservation order once every older lease has
+// been released, like fences on a GPU upload heap. When the ring is full (or
+// the lease would not fit in it at all) the lease falls back to a private
+// allocation from the memory policy.
+template<typename Memory_policy>
+class Basic_upload_ring {
 public:
-   Upload_scratch_buffer(const std::size_t max_persist_size = 16777216u,
-                         const std::size_t starting_size = 16777216u) noexcept;
+   constexpr static std::size_t alignment = Memory_policy::alignment;
+
+   class Lease {
+   public:
+      Lease() = default;
+
+      ~Lease()
+      {
+         reset();
+      }
+
+      Lease(Lease&& other) noexcept
+         : _ring{std::exchange(other._ring, nullptr)},
+           _data{std::exchange(other._data, nullptr)},
+           _size{std::exchange(other._size, 0)},
+           _sequence{std::exchange(other._sequence, fallback_sequence)}
+      {
+      }
+
+      auto operator=(Lease&& other) noexcept -> Lease&
+      {
+         if (this == &other) return *this;
+
+         reset();
+
+         _ring = std::exchange(other._ring, nullptr);
+         _data = std::exchange(other._data, nullptr);
+         _size = std::exchange(other._size, 0);
+         _sequence = std::exchange(other._sequence, fallback_sequence);
+
+         return *this;
+      }
+
+      Lease(const Lease&) = delete;
+      auto operator=(const Lease&) -> Lease& = delete;
+
+      auto data() const noexcept -> std::byte*
+      {
+         return _data;
+      }
+
+      auto size() const noexcept -> std::size_t
+      {
+         return _size;
+      }
+
+      // Was the lease served from the ring (as opposed to a fallback allocation)?
+      bool in_ring() const noexcept
+      {
+         return _ring && _sequence != fallback_sequence;
+      }
+
+      explicit operator bool() const noexcept
+      {
+         return _data != nullptr;
+      }
+
+      void reset() noexcept
+      {
+         if (!_ring) return;
+
+         _ring->release(*this);
+         _ring = nullptr;
+         _data = nullptr;
+         _size = 0;
+         _sequence = fallback_sequence;
+      }
+
+   private:
+      friend Basic_upload_ring;
+
+      Lease(Basic_upload_ring& ring, std::byte* const data, const std::size_t size,
+            const std::uint64_t sequence) noexcept
+         : _ring{&ring}, _data{data}, _size{size}, _sequence{sequence}
+      {
+      }
+
+      Basic_upload_ring* _ring = nullptr;
+      std::byte* _data = nullptr;
+      std::size_t _size = 0;
+      std::uint64_t _sequence = fallback_sequence;
+   };
+
+   struct Stats {
+      std::size_t capacity = 0;
+      std::size_t in_use = 0;
+      std::size_t outstanding_leases = 0;
+      std::uint64_t ring_leases = 0;
+      std::uint64_t fallback_leases = 0;
+   };
+
+   explicit Basic_upload_ring(const std::size_t capacity = 16777216u) noexcept
+      : _capacity{capacity}, _memory{Memory_policy::allocate(capacity)}
+   {
+      if (!std::has_single_bit(capacity) || capacity < alignment ||
+          capacity > position_mask) {
+         log_and_terminate("Upload ring capacity must be a power of two!"sv);
+      }
+
+      if (!_memory) log_and_terminate("Failed to allocate memory for upload ring!"sv);
+   }
+
+   ~Basic_upload_ring()
+   {
+      Memory_policy::deallocate(_memory, _capacity);
+   }
+
+   Basic_upload_ring(const Basic_upload_ring&) = delete;
+   auto operator=(const Basic_upload_ring&) -> Basic_upload_ring& = delete;
+
+   Basic_upload_ring(Basic_upload_ring&&) = delete;
+   auto operator=(Basic_upload_ring&&) -> Basic_upload_ring& = delete;
 
-   ~Upload_scratch_buffer() = default;
+   // Leases at least required_size bytes. The memory is valid until the lease
+   // is reset or destroyed.
+   [[nodiscard]] auto lock(const std::size_t required_size) noexcept -> Lease
+   {
+      const std::size_t size = round_up(std::max(required_size, std::size_t{1}));
 
-   Upload_scratch_buffer(const Upload_scratch_buffer&) = delete;
-   Upload_scratch_buffer& operator=(const Upload_scratch_buffer&) = delete;
+      if (size <= _capacity) {
+         for (;;) {
+            // Tail first, the head can never be behind a tail read before it.
+            const std::uint64_t tail = _tail.load(std::memory_order_acquire);
+            std::uint64_t head = _head.load(std::memory_order_acquire);
+            const std::uint64_t sequence = unpack_sequence(head);
+            const std::uint64_t head_position = unpack_position(head);
 
-   Upload_scratch_buffer(Upload_scratch_buffer&&) = delete;
-   Upload_scratch_buffer& operator=(Upload_scratch_buffer&&) = delete;
+            if (((sequence - unpack_sequence(tail)) & sequence_mask) >= max_leases) {
+               break;
+            }
 
-   std::byte* lock(const std::size_t required_size) noexcept;
+            // Leases never straddle the end of the ring, skip to the start
+            // instead. The skipped bytes belong to this lease and are
+            // reclaimed along with it.
+            std::uint64_t begin = head_position;
 
-   void unlock() noexcept;
+            if ((begin & (_capacity - 1)) + size > _capacity) {
+               begin += _capacity - (begin & (_capacity - 1));
+            }
+
+            const std::uint64_t end = (begin + size) & position_mask;
+
+            if (((end - unpack_position(tail)) & position_mask) > _capacity) break;
+
+            if (_head.compare_exchange_weak(head, pack(sequence + 1, end),
+                                            std::memory_order_acq_rel)) {
+               _slots[sequence % max_leases].end.store(end, std::memory_order_relaxed);
+               _ring_leases.fetch_add(1, std::memory_order_relaxed);
+
+               return Lease{*this, _memory + (begin & (_capacity - 1)), size,
+                            sequence & sequence_mask};
+            }
+         }
+      }
+
+      auto* const memory = Memory_policy::allocate(size);
+
+      if (!memory) {
+         log_and_terminate("Failed to allocate memory for upload scratch lease!"sv);
+      }
+
+      _fallback_leases.fetch_add(1, std::memory_order_relaxed);
+
+      return Lease{*this, memory, size, fallback_sequence};
+   }
+
+   auto stats() const noexcept -> Stats
+   {
+      const std::uint64_t head = _head.load(std::memory_order_acquire);
+      const std::uint64_t tail = _tail.load(std::memory_order_acquire);
+
+      return {.capacity = _capacity,
+              .in_use = static_cast<std::size_t>(
+                 (unpack_position(head) - unpack_position(tail)) & position_mask),
+              .outstanding_leases = static_cast<std::size_t>(
+                 (unpack_sequence(head) - unpack_sequence(tail)) & sequence_mask),
+              .ring_leases = _ring_leases.load(std::memory_order_relaxed),
+              .fallback_leases = _fallback_leases.load(std::memory_order_relaxed)};
+   }
+
+   auto capacity() const noexcept -> std::size_t
+   {
+      return _capacity;
+   }
 
 private:
-   void ensure_min_size(const std::size_t required_size) noexcept;
+   constexpr static std::size_t max_leases = 64;
+
+   // The head and tail pack a lease sequence number in the top bits and a byte
+   // position in the bottom bits so both can be updated with one CAS.
+   // Positions wrap at 2^44 which is a multiple of any valid capacity.
+   constexpr static std::uint64_t position_bits = 44;
+   constexpr static std::uint64_t position_mask = (1ull << position_bits) - 1;
+   constexpr static std::uint64_t sequence_mask = (1ull << (64 - position_bits)) - 1;
+   constexpr static std::uint64_t fallback_sequence = ~0ull;
+
+   static_assert(max_leases <= sequence_mask);
+
+   struct alignas(64) Slot {
+      std::atomic<std::uint64_t> end = 0;
+      std::atomic_bool released = false;
+   };
 
-   void ensure_within_size(const std::size_t max_size) noexcept;
+   constexpr static auto pack(const std::uint64_t sequence,
+                              const std::uint64_t position) noexcept -> std::uint64_t
+   {
+      return ((sequence & sequence_mask) << position_bits) | (position & position_mask);
+   }
 
-   void resize(const std::size_t new_size) noexcept;
+   constexpr static auto unpack_sequence(const std::uint64_t packed) noexcept
+      -> std::uint64_t
+   {
+      return packed >> position_bits;
+   }
 
-   using Block = std::aligned_storage_t<65536, 16>;
+   constexpr static auto unpack_position(const std::uint64_t packed) noexcept
+      -> std::uint64_t
+   {
+      return packed & position_mask;
+   }
 
-   std::atomic_bool _locked = false;
-   std::unique_ptr<Block[]> _memory = nullptr;
-   std::size_t _size = 0;
+   constexpr static auto round_up(const std::size_t size) noexcept -> std::size_t
+   {
+      return (size + (alignment - 1)) & ~(alignment - 1);
+   }
 
-   const std::size_t _max_persist_size;
+   void release(Lease& lease) noexcept
+   {
+      if (lease._sequence == fallback_sequence) {
+         Memory_policy::deallocate(lease._data, lease._size);
+
+         return;
+      }
+
+      _slots[lease._sequence % max_leases].released.store(true,
+                                                            std::memory_order_release);
+
+      reclaim();
+   }
+
+   // Advances the tail over every released lease at the front of the ring.
+   // Whoever wins the exchange on a slot's released flag owns moving the tail
+   // past it. If the tail moved on in the meantime the flag we took belongs to
+   // a newer lease in the same slot, so hand it back and look again.
+   void reclaim() noexcept
+   {
+      for (;;) {
+         std::uint64_t tail = _tail.load(std::memory_order_acquire);
+         const std::uint64_t sequence = unpack_sequence(tail);
+
+         if (sequence == unpack_sequence(_head.load(std::memory_order_acquire))) {
+            return;
+         }
+
+         Slot& slot = _slots[sequence % max_leases];
+
+         if (!slot.released.load(std::memory_order_acquire)) return;
+         if (!slot.released.exchange(false, std::memory_order_acq_rel)) continue;
+
+         const std::uint64_t end = slot.end.load(std::memory_order_relaxed);
+
+         if (!_tail.compare_exchange_strong(tail, pack(sequence + 1, end),
+                                            std::memory_order_acq_rel)) {
+            slot.released.store(true, std::memory_order_release);
+         }
+      }
+   }
+
+   const std::size_t _capacity;
+   std::byte* const _memory;
+
+   alignas(64) std::atomic<std::uint64_t> _head = 0;
+   alignas(64) std::atomic<std::uint64_t> _tail = 0;
+
+   std::array<Slot, max_leases> _slots;
+
+   std::atomic<std::uint64_t> _ring_leases = 0;
+   std::atomic<std::uint64_t> _fallback_leases = 0;
 };
 
+using Upload_scratch_buffer = Basic_upload_ring<Heap_upload_memory>;
+
 extern Upload_scratch_buffer upload_scratch_buffer;
 
 }
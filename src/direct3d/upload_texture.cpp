@@ -46,12 +46,13 @@ Upload_texture::Upload_texture(Upload_scratch_buffer& scratch_buffer,
                                const DXGI_FORMAT format, const UINT width,
                                const UINT height, const UINT depth,
                                const UINT mip_levels, const UINT array_size) noexcept
-   : _scratch_buffer{scratch_buffer}, _mip_levels{mip_levels}
+   : _lease{scratch_buffer.lock(
+        calc_size(format, width, height, depth, mip_levels, array_size))},
+     _mip_levels{mip_levels}
 {
    Expects(mip_levels > 0 && array_size >= 1);
 
-   const auto size = calc_size(format, width, height, depth, mip_levels, array_size);
-   auto* const data = scratch_buffer.lock(size);
+   auto* const data = _lease.data();
 
    _surfaces = {reinterpret_cast<core::Mapped_texture*>(data), array_size * mip_levels};
 
@@ -88,8 +89,6 @@ Upload_texture::~Upload_texture()
       "An array of core::Mapped_texture was explicitly constructed into the "
       "scratch buffer but was not explicitly destroyed. (Trivial "
       "destructibility was expected.)");
-
-   _scratch_buffer.unlock();
 }
 
 auto Upload_texture::subresource(const UINT mip, const UINT index) noexcept
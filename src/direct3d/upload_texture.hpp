@@ -32,7 +32,7 @@ public:
 private:
    std::span<core::Mapped_texture> _surfaces;
 
-   Upload_scratch_buffer& _scratch_buffer;
+   Upload_scratch_buffer::Lease _lease;
    const UINT _mip_levels;
 };
 
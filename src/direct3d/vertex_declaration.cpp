@@ -2,14 +2,73 @@
 #include "vertex_declaration.hpp"
 #include "debug_trace.hpp"
 #include "helpers.hpp"
+#include "vertex_element_translation.hpp"
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
 namespace sp::d3d9 {
 
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::position) == D3DDECLUSAGE_POSITION);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::blendweight) ==
+              D3DDECLUSAGE_BLENDWEIGHT);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::blendindices) ==
+              D3DDECLUSAGE_BLENDINDICES);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::normal) == D3DDECLUSAGE_NORMAL);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::psize) == D3DDECLUSAGE_PSIZE);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::texcoord) == D3DDECLUSAGE_TEXCOORD);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::tangent) == D3DDECLUSAGE_TANGENT);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::binormal) == D3DDECLUSAGE_BINORMAL);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::tessfactor) ==
+              D3DDECLUSAGE_TESSFACTOR);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::positiont) ==
+              D3DDECLUSAGE_POSITIONT);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::color) == D3DDECLUSAGE_COLOR);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::fog) == D3DDECLUSAGE_FOG);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::depth) == D3DDECLUSAGE_DEPTH);
+static_assert(static_cast<D3DDECLUSAGE>(Decl_usage::sample) == D3DDECLUSAGE_SAMPLE);
+
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::float1) == D3DDECLTYPE_FLOAT1);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::float2) == D3DDECLTYPE_FLOAT2);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::float3) == D3DDECLTYPE_FLOAT3);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::float4) == D3DDECLTYPE_FLOAT4);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::d3dcolor) == D3DDECLTYPE_D3DCOLOR);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::ubyte4) == D3DDECLTYPE_UBYTE4);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::short2) == D3DDECLTYPE_SHORT2);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::short4) == D3DDECLTYPE_SHORT4);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::ubyte4n) == D3DDECLTYPE_UBYTE4N);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::short2n) == D3DDECLTYPE_SHORT2N);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::short4n) == D3DDECLTYPE_SHORT4N);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::ushort2n) == D3DDECLTYPE_USHORT2N);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::ushort4n) == D3DDECLTYPE_USHORT4N);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::udec3) == D3DDECLTYPE_UDEC3);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::dec3n) == D3DDECLTYPE_DEC3N);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::float16_2) == D3DDECLTYPE_FLOAT16_2);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::float16_4) == D3DDECLTYPE_FLOAT16_4);
+static_assert(static_cast<D3DDECLTYPE>(Decl_type::unused) == D3DDECLTYPE_UNUSED);
+
+static_assert(static_cast<DXGI_FORMAT>(Element_format::unknown) == DXGI_FORMAT_UNKNOWN);
+static_assert(static_cast<DXGI_FORMAT>(Element_format::r32g32b32a32_float) ==
+              DXGI_FORMAT_R32G32B32A32_FLOAT);
+static_assert(static_cast<DXGI_FORMAT>(Element_format::r32g32b32_float) ==
+              DXGI_FORMAT_R32G32B32_FLOAT);
+static_assert(static_cast<DXGI_FORMAT>(Element_format::r16g16b16a16_sint) ==
+              DXGI_FORMAT_R16G16B16A16_SINT);
+static_assert(static_cast<DXGI_FORMAT>(Element_format::r32g32_float) ==
+              DXGI_FORMAT_R32G32_FLOAT);
+static_assert(static_cast<DXGI_FORMAT>(Element_format::r16g16_sint) ==
+              DXGI_FORMAT_R16G16_SINT);
+static_assert(static_cast<DXGI_FORMAT>(Element_format::r32_float) ==
+              DXGI_FORMAT_R32_FLOAT);
+static_assert(static_cast<DXGI_FORMAT>(Element_format::b8g8r8a8_unorm) ==
+              DXGI_FORMAT_B8G8R8A8_UNORM);
+
 namespace {
 
 void add_missing_tangents(std::vector<D3DVERTEXELEMENT9>& elements) noexcept
@@ -51,6 +110,37 @@ void add_missing_tangents(std::vector<D3DVERTEXELEMENT9>& elements) noexcept
    }
 }
 
+auto translate_element(const D3DVERTEXELEMENT9& elem) noexcept
+   -> std::optional<Element_translation>
+{
+   Element_translation translation;
+
+   switch (element_translations.translate(elem.Usage, elem.Type, translation)) {
+   case Element_translation_result::translated:
+      return translation;
+   case Element_translation_result::pretransformed:
+      return Element_translation{static_cast<Element_format>(
+         d3d_decl_type_to_dxgi_format(static_cast<D3DDECLTYPE>(elem.Type)))};
+   case Element_translation_result::unknown_usage:
+      log_fmt(Log_level::warning,
+              "Unknown or unsupported D3DDECLUSAGE ('{}') encountered. "
+              "Rendering maybe buggy or SP may even crash.",
+              d3d_decl_usage_to_string(static_cast<D3DDECLUSAGE>(elem.Usage)));
+
+      return std::nullopt;
+   case Element_translation_result::unknown_type:
+   default:
+      log_fmt(Log_level::warning,
+              "Unknown or unsupported D3DDECLTYPE ('{}') for usagae '{}' "
+              "encountered. "
+              "Rendering maybe buggy or SP may even crash.",
+              elem.Type,
+              d3d_decl_usage_to_string(static_cast<D3DDECLUSAGE>(elem.Usage)));
+
+      return std::nullopt;
+   }
+}
+
 auto create_input_layout(core::Shader_patch& shader_patch,
                          std::span<const D3DVERTEXELEMENT9> d3d9_elements) noexcept
    -> core::Game_input_layout
@@ -68,167 +158,79 @@ auto create_input_layout(core::Shader_patch& shader_patch,
    bool has_vertex_weights = false;
 
    for (const auto& elem : patched_d3d9_elements) {
+      if (elem.Usage == D3DDECLUSAGE_BLENDWEIGHT) has_vertex_weights = true;
+
+      const auto translation = translate_element(elem);
+
+      if (!translation) continue;
+
+      compressed_position |= translation->flag == Element_flag::compressed_position;
+      compressed_texcoords |= translation->flag == Element_flag::compressed_texcoords;
+
       core::Input_layout_element desc{};
 
       desc.semantic_name =
          d3d_decl_usage_to_string(static_cast<D3DDECLUSAGE>(elem.Usage));
       desc.semantic_index = elem.UsageIndex;
+      desc.format = static_cast<DXGI_FORMAT>(translation->format);
       desc.input_slot = elem.Stream;
       desc.aligned_byte_offset = elem.Offset;
 
-      bool is_valid = true;
-
-      switch (elem.Usage) {
-      case D3DDECLUSAGE_POSITION: {
-         switch (elem.Type) {
-         case D3DDECLTYPE_FLOAT1: {
-            desc.format = DXGI_FORMAT_R32_FLOAT;
-         } break;
-         case D3DDECLTYPE_FLOAT2: {
-            desc.format = DXGI_FORMAT_R32G32_FLOAT;
-         } break;
-         case D3DDECLTYPE_FLOAT3: {
-            desc.format = DXGI_FORMAT_R32G32B32_FLOAT;
-         } break;
-         case D3DDECLTYPE_FLOAT4: {
-            desc.format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-         } break;
-         case D3DDECLTYPE_SHORT2: {
-            desc.format = DXGI_FORMAT_R16G16_SINT;
-         } break;
-         case D3DDECLTYPE_SHORT4: {
-            desc.format = DXGI_FORMAT_R16G16B16A16_SINT;
-
-            compressed_position = true;
-         } break;
-         default: {
-            is_valid = false;
-
-            log_fmt(Log_level::warning,
-                    "Unknown or unsupported D3DDECLTYPE ('{}') for usagae '{}' "
-                    "encountered. "
-                    "Rendering maybe buggy or SP may even crash.",
-                    elem.Type, desc.semantic_name);
-         } break;
-         }
-      } break;
-      case D3DDECLUSAGE_BLENDWEIGHT: {
-         has_vertex_weights = true;
-
-         switch (elem.Type) {
-         case D3DDECLTYPE_FLOAT1: {
-            desc.format = DXGI_FORMAT_R32_FLOAT;
-         } break;
-         case D3DDECLTYPE_FLOAT2: {
-            desc.format = DXGI_FORMAT_R32G32_FLOAT;
-         } break;
-         case D3DDECLTYPE_FLOAT3: {
-            desc.format = DXGI_FORMAT_R32G32B32_FLOAT;
-         } break;
-         case D3DDECLTYPE_FLOAT4: {
-            desc.format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-         } break;
-         case D3DDECLTYPE_D3DCOLOR: {
-            desc.format = DXGI_FORMAT_B8G8R8A8_UNORM;
-         } break;
-         default: {
-            is_valid = false;
-
-            log_fmt(Log_level::warning,
-                    "Unknown or unsupported D3DDECLTYPE ('{}') for usagae '{}' "
-                    "encountered. "
-                    "Rendering maybe buggy or SP may even crash.",
-                    elem.Type, desc.semantic_name);
-         } break;
-         }
-      } break;
-      case D3DDECLUSAGE_BLENDINDICES:
-      case D3DDECLUSAGE_COLOR: {
-         switch (elem.Type) {
-         case D3DDECLTYPE_D3DCOLOR: {
-            desc.format = DXGI_FORMAT_B8G8R8A8_UNORM;
-         } break;
-         default: {
-            is_valid = false;
-
-            log_fmt(Log_level::warning,
-                    "Unknown or unsupported D3DDECLTYPE ('{}') for usagae '{}' "
-                    "encountered. "
-                    "Rendering maybe buggy or SP may even crash.",
-                    elem.Type, desc.semantic_name);
-         } break;
-         }
-      } break;
-      case D3DDECLUSAGE_NORMAL:
-      case D3DDECLUSAGE_TANGENT:
-      case D3DDECLUSAGE_BINORMAL: {
-         switch (elem.Type) {
-         case D3DDECLTYPE_D3DCOLOR: {
-            desc.format = DXGI_FORMAT_B8G8R8A8_UNORM;
-         } break;
-         case D3DDECLTYPE_FLOAT3: {
-            desc.format = DXGI_FORMAT_R32G32B32_FLOAT;
-         } break;
-         default: {
-            is_valid = false;
-
-            log_fmt(Log_level::warning,
-                    "Unknown or unsupported D3DDECLTYPE ('{}') for usagae '{}' "
-                    "encountered. "
-                    "Rendering maybe buggy or SP may even crash.",
-                    elem.Type, desc.semantic_name);
-         } break;
-         }
-      } break;
-      case D3DDECLUSAGE_TEXCOORD: {
-         switch (elem.Type) {
-         case D3DDECLTYPE_FLOAT2: {
-            desc.format = DXGI_FORMAT_R32G32_FLOAT;
-         } break;
-         case D3DDECLTYPE_SHORT2: {
-            desc.format = DXGI_FORMAT_R16G16_SINT;
-
-            compressed_texcoords = true;
-         } break;
-         default: {
-            is_valid = false;
-
-            log_fmt(Log_level::warning,
-                    "Unknown or unsupported D3DDECLTYPE ('{}') for usagae '{}' "
-                    "encountered. "
-                    "Rendering maybe buggy or SP may even crash.",
-                    elem.Type, desc.semantic_name);
-         } break;
-         }
-      } break;
-      case D3DDECLUSAGE_POSITIONT: {
-         desc.format =
-            d3d_decl_type_to_dxgi_format(static_cast<D3DDECLTYPE>(elem.Type));
-      } break;
-      default: {
-         is_valid = false;
-
-         log_fmt(Log_level::warning,
-                 "Unknown or unsupported D3DDECLUSAGE ('{}') encountered. "
-                 "Rendering maybe buggy or SP may even crash.",
-                 desc.semantic_name);
-      } break;
-      }
-
-      if (is_valid) elements.push_back(desc);
+      elements.push_back(desc);
    }
 
    return shader_patch.create_game_input_layout(elements, compressed_position,
                                                 compressed_texcoords,
                                                 has_vertex_weights);
 }
+
+// The key is the raw bytes of the elements with the (unused) method cleared,
+// so declarations that only differ by it share a layout.
+auto make_declaration_key(const std::span<const D3DVERTEXELEMENT9> elements) noexcept
+   -> std::string
+{
+   std::string key;
+   key.resize(elements.size_bytes());
+
+   std::memcpy(key.data(), elements.data(), elements.size_bytes());
+
+   for (std::size_t i = 0; i < elements.size(); ++i) {
+      key[i * sizeof(D3DVERTEXELEMENT9) + offsetof(D3DVERTEXELEMENT9, Method)] = '\0';
+   }
+
+   return key;
+}
+}
+
+auto Vertex_declaration_cache::get(core::Shader_patch& shader_patch,
+                                   const std::span<const D3DVERTEXELEMENT9> elements) noexcept
+   -> core::Game_input_layout
+{
+   auto key = make_declaration_key(elements);
+
+   if (auto it = _layouts.find(key); it != _layouts.end()) {
+      _stats.hits += 1;
+
+      return it->second;
+   }
+
+   _stats.misses += 1;
+
+   const auto input_layout = create_input_layout(shader_patch, elements);
+
+   _layouts.emplace(std::move(key), input_layout);
+
+   log_debug("Created input layout for vertex declaration. ({} cache hits, {} "
+             "misses)"sv,
+             _stats.hits, _stats.misses);
+
+   return input_layout;
 }
 
 Com_ptr<Vertex_declaration> Vertex_declaration::create(
-   core::Shader_patch& shader_patch,
-   const std::span<const D3DVERTEXELEMENT9> elements) noexcept
+   const core::Game_input_layout& input_layout) noexcept
 {
-   return Com_ptr{new Vertex_declaration{shader_patch, elements}};
+   return Com_ptr{new Vertex_declaration{input_layout}};
 }
 
 HRESULT Vertex_declaration::QueryInterface(const IID& iid, void** object) noexcept
@@ -272,9 +274,8 @@ ULONG Vertex_declaration::Release() noexcept
    return ref_count;
 }
 
-Vertex_declaration::Vertex_declaration(core::Shader_patch& shader_patch,
-                                       const std::span<const D3DVERTEXELEMENT9> elements) noexcept
-   : _input_layout{create_input_layout(shader_patch, elements)}
+Vertex_declaration::Vertex_declaration(const core::Game_input_layout& input_layout) noexcept
+   : _input_layout{input_layout}
 {
 }
 }
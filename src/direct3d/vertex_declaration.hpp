@@ -4,17 +4,44 @@
 #include "../logger.hpp"
 #include "com_ptr.hpp"
 
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include <absl/container/flat_hash_map.h>
 #include <gsl/gsl>
 
 #include <d3d9.h>
 
 namespace sp::d3d9 {
 
+// Translations of D3D9 vertex elements into game input layouts. The game
+// creates many identical declarations, they share one translation.
+class Vertex_declaration_cache {
+public:
+   struct Stats {
+      std::uint64_t hits = 0;
+      std::uint64_t misses = 0;
+   };
+
+   auto get(core::Shader_patch& shader_patch,
+            const std::span<const D3DVERTEXELEMENT9> elements) noexcept
+      -> core::Game_input_layout;
+
+   auto stats() const noexcept -> Stats
+   {
+      return _stats;
+   }
+
+private:
+   absl::flat_hash_map<std::string, core::Game_input_layout> _layouts;
+   Stats _stats;
+};
+
 class Vertex_declaration final : public IDirect3DVertexDeclaration9 {
 public:
    static Com_ptr<Vertex_declaration> create(
-      core::Shader_patch& shader_patch,
-      const std::span<const D3DVERTEXELEMENT9> elements) noexcept;
+      const core::Game_input_layout& input_layout) noexcept;
 
    Vertex_declaration(const Vertex_declaration&) = delete;
    Vertex_declaration& operator=(const Vertex_declaration&) = delete;
@@ -46,8 +73,7 @@ public:
    }
 
 private:
-   Vertex_declaration(core::Shader_patch& shader_patch,
-                      const std::span<const D3DVERTEXELEMENT9> elements) noexcept;
+   Vertex_declaration(const core::Game_input_layout& input_layout) noexcept;
    ~Vertex_declaration() = default;
 
    const core::Game_input_layout _input_layout;
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace sp::d3d9 {
+
+// The translation of D3D9 vertex element usage and type pairs into DXGI
+// formats. Kept free of the D3D9 and DXGI headers, the enums mirror the SDK's
+// values and vertex_declaration.cpp checks that they match.
+
+enum class Decl_usage : std::uint8_t {
+   position = 0,
+   blendweight = 1,
+   blendindices = 2,
+   normal = 3,
+   psize = 4,
+   texcoord = 5,
+   tangent = 6,
+   binormal = 7,
+   tessfactor = 8,
+   positiont = 9,
+   color = 10,
+   fog = 11,
+   depth = 12,
+   sample = 13
+};
+
+enum class Decl_type : std::uint8_t {
+   float1 = 0,
+   float2 = 1,
+   float3 = 2,
+   float4 = 3,
+   d3dcolor = 4,
+   ubyte4 = 5,
+   short2 = 6,
+   short4 = 7,
+   ubyte4n = 8,
+   short2n = 9,
+   short4n = 10,
+   ushort2n = 11,
+   ushort4n = 12,
+   udec3 = 13,
+   dec3n = 14,
+   float16_2 = 15,
+   float16_4 = 16,
+   unused = 17
+};
+
+enum class Element_format : std::uint32_t {
+   unknown = 0,
+   r32g32b32a32_float = 2,
+   r32g32b32_float = 6,
+   r16g16b16a16_sint = 14,
+   r32g32_float = 16,
+   r16g16_sint = 38,
+   r32_float = 41,
+   b8g8r8a8_unorm = 87
+};
+
+enum class Element_flag : std::uint8_t {
+   none,
+   compressed_position,
+   compressed_texcoords
+};
+
+struct Element_translation {
+   Element_format format = Element_format::unknown;
+   Element_flag flag = Element_flag::none;
+
+   bool operator==(const Element_translation&) const = default;
+};
+
+enum class Element_translation_result : std::uint8_t {
+   translated,
+   // Pretransformed positions take any type, their format comes from the type
+   // alone.
+   pretransformed,
+   unknown_usage,
+   unknown_type
+};
+
+struct Element_translation_table {
+   constexpr static std::size_t usage_count =
+      static_cast<std::size_t>(Decl_usage::sample) + 1;
+   constexpr static std::size_t type_count =
+      static_cast<std::size_t>(Decl_type::unused);
+
+   std::array<std::array<Element_translation, type_count>, usage_count> formats{};
+   std::array<bool, usage_count> known_usage{};
+
+   constexpr void add(const Decl_usage usage, const Decl_type type,
+                      const Element_format format,
+                      const Element_flag flag = Element_flag::none) noexcept
+   {
+      const auto usage_index = static_cast<std::size_t>(usage);
+
+      known_usage[usage_index] = true;
+      formats[usage_index][static_cast<std::size_t>(type)] = {format, flag};
+   }
+
+   // Translates a D3DVERTEXELEMENT9's Usage and Type, translation is only set
+   // for Element_translation_result::translated.
+   constexpr auto translate(const std::uint8_t usage, const std::uint8_t type,
+                            Element_translation& translation) const noexcept
+      -> Element_translation_result
+   {
+      if (usage >= usage_count || !known_usage[usage]) {
+         return Element_translation_result::unknown_usage;
+      }
+
+      if (usage == static_cast<std::size_t>(Decl_usage::positiont)) {
+         return Element_translation_result::pretransformed;
+      }
+
+      if (type >= type_count ||
+          formats[usage][type].format == Element_format::unknown) {
+         return Element_translation_result::unknown_type;
+      }
+
+      translation = formats[usage][type];
+
+      return Element_translation_result::translated;
+   }
+};
+
+// The usage and type pairs the game uses and their formats. Pairs not in the
+// table are dropped from the layout.
+constexpr auto element_translations = [] {
+   using enum Decl_usage;
+   using enum Decl_type;
+   using enum Element_format;
+
+   Element_translation_table table;
+
+   table.add(position, float1, r32_float);
+   table.add(position, float2, r32g32_float);
+   table.add(position, float3, r32g32b32_float);
+   table.add(position, float4, r32g32b32a32_float);
+   table.add(position, short2, r16g16_sint);
+   table.add(position, short4, r16g16b16a16_sint,
+             Element_flag::compressed_position);
+
+   table.add(blendweight, float1, r32_float);
+   table.add(blendweight, float2, r32g32_float);
+   table.add(blendweight, float3, r32g32b32_float);
+   table.add(blendweight, float4, r32g32b32a32_float);
+   table.add(blendweight, d3dcolor, b8g8r8a8_unorm);
+
+   table.add(blendindices, d3dcolor, b8g8r8a8_unorm);
+   table.add(color, d3dcolor, b8g8r8a8_unorm);
+
+   for (const auto usage : {normal, tangent, binormal}) {
+      table.add(usage, d3dcolor, b8g8r8a8_unorm);
+      table.add(usage, float3, r32g32b32_float);
+   }
+
+   table.add(texcoord, float2, r32g32_float);
+   table.add(texcoord, short2, r16g16_sint, Element_flag::compressed_texcoords);
+
+   table.known_usage[static_cast<std::size_t>(positiont)] = true;
+
+   return table;
+}();
+
+}
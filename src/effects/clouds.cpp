@@ -167,8 +167,11 @@ void Clouds::render(ID3D11DeviceContext1& dc,
    Constants cb = pack_constants(_params, input);
    core::update_dynamic_buffer(dc, *_constant_buffer, cb);
 
-   // Get cloud octave texture (lazy load)
-   if (!_cloud_octaves_srv) {
+   // Get cloud octave texture (lazy load). Looked up again whenever the
+   // database changes, the first lookup may have returned a placeholder for a
+   // texture that was still loading.
+   if (!_cloud_octaves_srv || _cloud_octaves_generation != textures.generation()) {
+      _cloud_octaves_generation = textures.generation();
       _cloud_octaves_srv = textures.at_if("_SP_BUILTIN_cloud_octaves"sv);
 
       // Fallback to perlin if octave texture not available
@@ -185,6 +185,7 @@ private:
 
    // Cloud octave texture (RGBA = 4 noise octaves)
    Com_ptr<ID3D11ShaderResourceView> _cloud_octaves_srv;
+   std::uint64_t _cloud_octaves_generation = 0;
 };
 
 }
@@ -131,6 +131,70 @@ void add_params(Bloom_params& dest, const Bloom_params& src, const float src_wei
    dest.dirt_tint += (src.dirt_tint * src_weight);
 }
 
+static_assert(static_cast<int>(Tonemapper::none) ==
+              static_cast<int>(Color_grading_config_tonemapper::none));
+static_assert(static_cast<int>(Bloom_mode::threshold) ==
+              static_cast<int>(Color_grading_config_bloom_mode::threshold));
+
+auto unpack_float3(const Color_grading_config_float3& float3) noexcept -> glm::vec3
+{
+   return {float3[0], float3[1], float3[2]};
+}
+
+auto unpack_cg_params(const Color_grading_config_block::Color_grading& block) noexcept
+   -> Color_grading_params
+{
+   return {.color_filter = unpack_float3(block.color_filter),
+           .saturation = block.saturation,
+           .exposure = block.exposure,
+           .brightness = block.brightness,
+           .contrast = block.contrast,
+           .tonemapper = static_cast<Tonemapper>(block.tonemapper),
+           .filmic_toe_strength = block.filmic_toe_strength,
+           .filmic_toe_length = block.filmic_toe_length,
+           .filmic_shoulder_strength = block.filmic_shoulder_strength,
+           .filmic_shoulder_length = block.filmic_shoulder_length,
+           .filmic_shoulder_angle = block.filmic_shoulder_angle,
+           .filmic_heji_whitepoint = block.filmic_heji_whitepoint,
+           .shadow_color = unpack_float3(block.shadow_color),
+           .midtone_color = unpack_float3(block.midtone_color),
+           .highlight_color = unpack_float3(block.highlight_color),
+           .shadow_offset = block.shadow_offset,
+           .midtone_offset = block.midtone_offset,
+           .highlight_offset = block.highlight_offset,
+           .hsv_hue_adjustment = block.hsv_hue_adjustment,
+           .hsv_saturation_adjustment = block.hsv_saturation_adjustment,
+           .hsv_value_adjustment = block.hsv_value_adjustment,
+           .channel_mix_red = unpack_float3(block.channel_mix_red),
+           .channel_mix_green = unpack_float3(block.channel_mix_green),
+           .channel_mix_blue = unpack_float3(block.channel_mix_blue)};
+}
+
+auto unpack_bloom_params(const Color_grading_config_block::Bloom& block) noexcept
+   -> Bloom_params
+{
+   return {.enabled = block.enabled != 0,
+           .mode = static_cast<Bloom_mode>(block.mode),
+           .threshold = block.threshold,
+           .blend_factor = block.blend_factor,
+           .intensity = block.intensity,
+           .tint = unpack_float3(block.tint),
+           .inner_scale = block.inner_scale,
+           .inner_tint = unpack_float3(block.inner_tint),
+           .inner_mid_scale = block.inner_mid_scale,
+           .inner_mid_tint = unpack_float3(block.inner_mid_tint),
+           .mid_scale = block.mid_scale,
+           .mid_tint = unpack_float3(block.mid_tint),
+           .outer_mid_scale = block.outer_mid_scale,
+           .outer_mid_tint = unpack_float3(block.outer_mid_tint),
+           .outer_scale = block.outer_scale,
+           .outer_tint = unpack_float3(block.outer_tint),
+           .use_dirt = block.use_dirt != 0,
+           .dirt_scale = block.dirt_scale,
+           .dirt_tint = unpack_float3(block.dirt_tint),
+           .dirt_texture_name = block.dirt_texture_name.data()};
+}
+
 void save_configs(const std::filesystem::path& path,
                   const std::vector<Color_grading_params>& params,
                   const std::vector<std::optional<Bloom_params>>& bloom_params,
@@ -375,18 +439,20 @@ void Color_grading_regions_blender::init_region_params(const Color_grading_regio
          "Too many color grading region configs. Max supported is 65535.");
    }
 
+   Expects(regions.config_names.size() == regions.configs.size());
+
    _region_cg_params.reserve(regions.configs.size());
    _region_bloom_params.reserve(regions.configs.size());
    _region_params_names.reserve(regions.configs.size());
 
-   for (const auto& config : regions.configs) {
-      _region_cg_params.emplace_back(
-         config.second["ColorGrading"s].as<Color_grading_params>(Color_grading_params{}));
-      _region_bloom_params.push_back(
-         config.second["Bloom"s]
-            ? std::optional{config.second["Bloom"s].as<Bloom_params>()}
-            : std::nullopt);
-      _region_params_names.emplace_back(config.first);
+   for (std::size_t i = 0; i < regions.configs.size(); ++i) {
+      const auto& config = regions.configs[i];
+
+      _region_cg_params.push_back(unpack_cg_params(config.color_grading));
+      _region_bloom_params.push_back(config.has_bloom
+                                        ? std::optional{unpack_bloom_params(config.bloom)}
+                                        : std::nullopt);
+      _region_params_names.emplace_back(regions.config_names[i]);
    }
 }
 
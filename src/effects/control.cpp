@@ -200,6 +200,17 @@ namespace sp::effects {
 
                 ImGui::Checkbox("Profiler Enabled", &profiler.enabled);
 
+                if (profiler.capturing_trace()) {
+                    ImGui::TextDisabled("Capturing Profiler Trace...");
+                }
+                else if (ImGui::Button("Capture Profiler Trace")) {
+                    profiler.capture_trace(
+                        static_cast<std::uint32_t>(_profiler_trace_frames));
+                }
+
+                ImGui::SameLine();
+                ImGui::SliderInt("Trace Frames", &_profiler_trace_frames, 1, 120);
+
                 ImGui::Separator();
 
                 imgui_save_widget(game_window);
@@ -106,6 +106,7 @@ namespace sp::effects {
         bool _has_auto_user_config = false;
         bool _open_failure = false;
         bool _save_failure = false;
+        int _profiler_trace_frames = 10;
 
         Effects_control_config _config{};
         Cubemap_alignment _cubemap_alignment{};
@@ -0,0 +1,155 @@
+
+#include "frame_graph.hpp"
+
+#include <algorithm>
+
+#include <fmt/format.h>
+
+namespace sp::effects {
+
+void Frame_graph::clear() noexcept
+{
+   _resources.clear();
+   _passes.clear();
+   _uses.clear();
+}
+
+auto Frame_graph::create_transient(const Resource_desc& desc) noexcept -> Resource
+{
+   _resources.push_back(desc);
+   _resources.back().imported = false;
+
+   return Resource{static_cast<std::uint32_t>(_resources.size() - 1)};
+}
+
+auto Frame_graph::import_resource(const std::string_view name) noexcept -> Resource
+{
+   _resources.push_back({.name = name, .imported = true});
+
+   return Resource{static_cast<std::uint32_t>(_resources.size() - 1)};
+}
+
+auto Frame_graph::add_pass(const std::string_view name, std::initializer_list<Resource> reads,
+                           std::initializer_list<Resource> writes) noexcept -> std::uint32_t
+{
+   _passes.push_back({.name = name,
+                      .first_use = static_cast<std::uint32_t>(_uses.size()),
+                      .read_count = static_cast<std::uint32_t>(reads.size()),
+                      .write_count = static_cast<std::uint32_t>(writes.size())});
+
+   _uses.insert(_uses.end(), reads.begin(), reads.end());
+   _uses.insert(_uses.end(), writes.begin(), writes.end());
+
+   return static_cast<std::uint32_t>(_passes.size() - 1);
+}
+
+void plan_frame_graph(const Frame_graph& graph, Frame_graph_plan& plan) noexcept
+{
+   using Resource = Frame_graph::Resource;
+
+   const auto pass_count = static_cast<std::uint32_t>(graph.pass_count());
+   const std::size_t resource_count = graph.resource_count();
+
+   plan.lifetimes.assign(resource_count, {});
+   plan.resource_slots.assign(resource_count, Frame_graph_plan::no_slot);
+   plan.slots.clear();
+   plan.report = {};
+   plan.errors.clear();
+
+   for (std::uint32_t pass = 0; pass < pass_count; ++pass) {
+      const auto use = [&](const Resource resource) -> Frame_graph_plan::Lifetime& {
+         auto& lifetime = plan.lifetimes[static_cast<std::size_t>(resource)];
+
+         lifetime.first_pass = std::min(lifetime.first_pass, pass);
+         lifetime.last_pass = std::max(lifetime.last_pass, pass);
+
+         return lifetime;
+      };
+
+      for (const Resource resource : graph.reads(pass)) {
+         const auto& lifetime = use(resource);
+
+         if (!graph.imported(resource) && lifetime.first_write == Frame_graph_plan::no_pass) {
+            plan.errors.push_back(
+               fmt::format("Pass '{}' reads transient '{}' before it is written.",
+                           graph.pass_name(pass), graph.resource(resource).name));
+         }
+      }
+
+      for (const Resource resource : graph.writes(pass)) {
+         auto& lifetime = use(resource);
+
+         lifetime.first_write = std::min(lifetime.first_write, pass);
+      }
+   }
+
+   // Assign transients in order of first use, each takes the first slot of
+   // its class that has been free since before its first pass.
+   for (std::uint32_t pass = 0; pass < pass_count; ++pass) {
+      const auto assign = [&](const Resource resource) {
+         const auto i = static_cast<std::size_t>(resource);
+         const auto& lifetime = plan.lifetimes[i];
+
+         if (graph.imported(resource) || lifetime.first_pass != pass ||
+             plan.resource_slots[i] != Frame_graph_plan::no_slot) {
+            return;
+         }
+
+         const auto& desc = graph.resource(resource);
+
+         auto slot = std::ranges::find_if(plan.slots, [&](const Frame_graph_plan::Slot& slot) {
+            return slot.alias_class == desc.alias_class &&
+                   slot.lifetime.last_pass < lifetime.first_pass;
+         });
+
+         if (slot == plan.slots.end()) {
+            plan.slots.push_back({.alias_class = desc.alias_class,
+                                  .size = desc.size,
+                                  .lifetime = lifetime});
+            slot = plan.slots.end() - 1;
+         }
+         else {
+            slot->size = std::max(slot->size, desc.size);
+            slot->lifetime.last_pass = lifetime.last_pass;
+         }
+
+         plan.resource_slots[i] = static_cast<std::uint32_t>(slot - plan.slots.begin());
+
+         plan.report.transient_count += 1;
+         plan.report.unaliased_bytes += desc.size;
+      };
+
+      for (const Resource resource : graph.reads(pass)) assign(resource);
+      for (const Resource resource : graph.writes(pass)) assign(resource);
+   }
+
+   plan.report.slot_count = static_cast<std::uint32_t>(plan.slots.size());
+
+   for (const auto& slot : plan.slots) plan.report.aliased_bytes += slot.size;
+
+   for (std::uint32_t pass = 0; pass < pass_count; ++pass) {
+      std::uint64_t live_bytes = 0;
+
+      for (std::size_t i = 0; i < resource_count; ++i) {
+         const auto& lifetime = plan.lifetimes[i];
+
+         if (plan.resource_slots[i] != Frame_graph_plan::no_slot &&
+             lifetime.first_pass <= pass && pass <= lifetime.last_pass) {
+            live_bytes += graph.resource(Resource{static_cast<std::uint32_t>(i)}).size;
+         }
+      }
+
+      plan.report.peak_live_bytes = std::max(plan.report.peak_live_bytes, live_bytes);
+   }
+}
+
+auto plan_frame_graph(const Frame_graph& graph) noexcept -> Frame_graph_plan
+{
+   Frame_graph_plan plan;
+
+   plan_frame_graph(graph, plan);
+
+   return plan;
+}
+
+}
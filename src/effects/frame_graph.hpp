@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sp::effects {
+
+// Declares the passes of a frame (or part of one) and the targets they read
+// and write. Knows nothing about D3D11, transients are described only by an
+// alias class (transients may only share memory with transients of the same
+// class) and a size so graphs can be planned and checked anywhere.
+//
+// Graphs are meant to be rebuilt every frame, clear keeps the storage of the
+// last graph so doing so doesn't allocate. Names are not copied and must
+// outlive the graph, in practice they're string literals.
+class Frame_graph {
+public:
+   enum class Resource : std::uint32_t {};
+
+   struct Resource_desc {
+      std::string_view name;
+      std::uint64_t alias_class = 0;
+      std::uint64_t size = 0;
+      bool imported = false;
+   };
+
+   void clear() noexcept;
+
+   auto create_transient(const Resource_desc& desc) noexcept -> Resource;
+
+   // Adds a resource owned outside the graph. It's tracked for validation but
+   // never aliased.
+   auto import_resource(const std::string_view name) noexcept -> Resource;
+
+   auto add_pass(const std::string_view name, std::initializer_list<Resource> reads,
+                 std::initializer_list<Resource> writes) noexcept -> std::uint32_t;
+
+   auto resource(const Resource resource) const noexcept -> const Resource_desc&
+   {
+      return _resources[static_cast<std::size_t>(resource)];
+   }
+
+   bool imported(const Resource resource) const noexcept
+   {
+      return _resources[static_cast<std::size_t>(resource)].imported;
+   }
+
+   auto resource_count() const noexcept -> std::size_t
+   {
+      return _resources.size();
+   }
+
+   auto pass_count() const noexcept -> std::size_t
+   {
+      return _passes.size();
+   }
+
+   auto pass_name(const std::uint32_t pass) const noexcept -> std::string_view
+   {
+      return _passes[pass].name;
+   }
+
+   auto reads(const std::uint32_t pass) const noexcept -> std::span<const Resource>
+   {
+      return std::span{_uses}.subspan(_passes[pass].first_use, _passes[pass].read_count);
+   }
+
+   auto writes(const std::uint32_t pass) const noexcept -> std::span<const Resource>
+   {
+      return std::span{_uses}.subspan(_passes[pass].first_use + _passes[pass].read_count,
+                                      _passes[pass].write_count);
+   }
+
+private:
+   // A pass's reads followed by its writes are stored contiguously in _uses.
+   struct Pass {
+      std::string_view name;
+      std::uint32_t first_use = 0;
+      std::uint32_t read_count = 0;
+      std::uint32_t write_count = 0;
+   };
+
+   std::vector<Resource_desc> _resources;
+   std::vector<Pass> _passes;
+   std::vector<Resource> _uses;
+};
+
+struct Frame_graph_plan {
+   constexpr static std::uint32_t no_slot = 0xffffffffu;
+   constexpr static std::uint32_t no_pass = 0xffffffffu;
+
+   // Inclusive range of passes a resource is used in.
+   struct Lifetime {
+      std::uint32_t first_pass = no_pass;
+      std::uint32_t last_pass = 0;
+      std::uint32_t first_write = no_pass;
+
+      bool used() const noexcept
+      {
+         return first_pass <= last_pass;
+      }
+   };
+
+   // A physical target shared by every transient assigned to it. It must be
+   // held from the first pass of its first transient to the last pass of its
+   // last one.
+   struct Slot {
+      std::uint64_t alias_class = 0;
+      std::uint64_t size = 0;
+      Lifetime lifetime;
+   };
+
+   struct Report {
+      std::uint32_t transient_count = 0;
+      std::uint32_t slot_count = 0;
+
+      // Memory needed if every transient had its own target.
+      std::uint64_t unaliased_bytes = 0;
+
+      // Memory needed by the planned slots.
+      std::uint64_t aliased_bytes = 0;
+
+      // Most memory live at any one pass, the floor for any aliasing scheme.
+      std::uint64_t peak_live_bytes = 0;
+   };
+
+   std::vector<Lifetime> lifetimes;
+   std::vector<std::uint32_t> resource_slots;
+   std::vector<Slot> slots;
+
+   Report report;
+
+   // Problems found in the graph, such as a transient being read before any
+   // pass writes it.
+   std::vector<std::string> errors;
+
+   auto slot(const Frame_graph::Resource resource) const noexcept -> std::uint32_t
+   {
+      return resource_slots[static_cast<std::size_t>(resource)];
+   }
+};
+
+// Computes the lifetime of every resource and assigns transients to slots,
+// transients of the same alias class whose lifetimes do not overlap share a
+// slot. Deterministic, the same graph always produces the same plan. The
+// storage already in plan is reused.
+void plan_frame_graph(const Frame_graph& graph, Frame_graph_plan& plan) noexcept;
+
+auto plan_frame_graph(const Frame_graph& graph) noexcept -> Frame_graph_plan;
+
+}
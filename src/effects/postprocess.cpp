@@ -15,6 +15,7 @@
 #include "postprocess_params.hpp"
 #include "profiler.hpp"
 #include "rendertarget_allocator.hpp"
+#include "rendertarget_graph.hpp"
 #include "utility.hpp"
 
 #include <array>
@@ -367,6 +368,11 @@ namespace sp::effects {
         {
             return _fog_params;
         }
+
+        auto dof_rendertarget_report() const noexcept -> const Frame_graph_plan::Report&
+        {
+            return _dof_graph.report();
+        }
         void color_grading_regions(const Color_grading_regions& colorgrading_regions) noexcept
         {
             _color_grading_regions_blender.regions(colorgrading_regions);
@@ -683,39 +689,85 @@ namespace sp::effects {
                    .inv_near_mask_size = {1.0f / near_mask_width, 1.0f / near_mask_height},
                 });
 
+            // floodfill takes over prepare's targets and, when processing at
+            // full resolution, compose takes over gather_near's. The graph
+            // works that out from the pass lifetimes.
+            const Rendertarget_desc process_desc{ .format = DXGI_FORMAT_R16G16B16A16_FLOAT,
+                                                  .width = process_width,
+                                                  .height = process_height,
+                                                  .bind_flags = rendertarget_bind_srv_rtv };
+
+            auto& graph = _dof_graph;
+
+            graph.clear();
+
+            const auto prepare_near = graph.create("DOF Prepare Near"sv, process_desc);
+            const auto prepare_far = graph.create("DOF Prepare Far"sv, process_desc);
+            const auto near_mask =
+                graph.create("DOF Near Mask"sv,
+                             { .format = DXGI_FORMAT_R8_UNORM,
+                               .width = near_mask_width,
+                               .height = near_mask_height,
+                               .bind_flags = rendertarget_bind_srv_rtv_uav });
+            const auto near_mask_blur_x =
+                graph.create("DOF Near Mask Blur X"sv,
+                             { .format = DXGI_FORMAT_R8_UNORM,
+                               .width = near_mask_width,
+                               .height = near_mask_height,
+                               .bind_flags = rendertarget_bind_srv_rtv });
+            const auto gather_near = graph.create("DOF Gather Near"sv, process_desc);
+            const auto gather_far = graph.create("DOF Gather Far"sv, process_desc);
+            const auto floodfill_near = graph.create("DOF Floodfill Near"sv, process_desc);
+            const auto floodfill_far = graph.create("DOF Floodfill Far"sv, process_desc);
+            const auto compose_target =
+                graph.create("DOF Compose"sv,
+                             { .format = DXGI_FORMAT_R16G16B16A16_FLOAT,
+                               .width = input.width(),
+                               .height = input.height(),
+                               .bind_flags = rendertarget_bind_srv_rtv });
+
+            const auto prepare_pass =
+                graph.add_pass("Prepare"sv, {}, { prepare_near, prepare_far });
+            const auto near_mask_pass =
+                graph.add_pass("Near Mask"sv, { prepare_near }, { near_mask });
+            const auto blur_x_near_mask_pass =
+                graph.add_pass("Blur X Near Mask"sv, { near_mask }, { near_mask_blur_x });
+            const auto blur_y_near_mask_pass =
+                graph.add_pass("Blur Y Near Mask"sv, { near_mask_blur_x }, { near_mask });
+            const auto gather_pass =
+                graph.add_pass("Gather"sv, { prepare_near, near_mask, prepare_far },
+                               { gather_near, gather_far });
+            const auto floodfill_pass =
+                graph.add_pass("Floodfill"sv, { gather_near, gather_far },
+                               { floodfill_near, floodfill_far });
+            const auto compose_pass =
+                graph.add_pass("Compose"sv, { floodfill_near, floodfill_far },
+                               { compose_target });
+
+            graph.plan();
+
             std::array<ID3D11ShaderResourceView*, 4> srvs{};
             set_viewport(dc, process_width, process_height);
 
+            graph.begin_pass(prepare_pass, allocator);
+
             srvs = { input.srv(), &input_depth };
 
             dc.PSSetShader(prepare_ps, nullptr, 0);
             dc.PSSetConstantBuffers(1, 1, _dof_constant_buffer.get_ptr_ptr());
 
-            auto prepare_near =
-                allocator.allocate({ .format = DXGI_FORMAT_R16G16B16A16_FLOAT,
-                                    .width = process_width,
-                                    .height = process_height,
-                                    .bind_flags = rendertarget_bind_srv_rtv });
-            auto prepare_far =
-                allocator.allocate({ .format = DXGI_FORMAT_R16G16B16A16_FLOAT,
-                                    .width = process_width,
-                                    .height = process_height,
-                                    .bind_flags = rendertarget_bind_srv_rtv });
-
-            do_pass(dc, srvs, { prepare_near.rtv(), prepare_far.rtv() });
-
-            auto near_mask =
-                allocator.allocate({ .format = DXGI_FORMAT_R8_UNORM,
-                                    .width = near_mask_width,
-                                    .height = near_mask_height,
-                                    .bind_flags = rendertarget_bind_srv_rtv_uav });
+            do_pass(dc, srvs, { graph.get(prepare_near).rtv(), graph.get(prepare_far).rtv() });
+
+            graph.end_pass(prepare_pass);
 
             {
+                graph.begin_pass(near_mask_pass, allocator);
+
                 dc.OMSetRenderTargets(0, nullptr, nullptr);
 
-                srvs = { prepare_near.srv() };
+                srvs = { graph.get(prepare_near).srv() };
 
-                auto* uav = near_mask.uav();
+                auto* uav = graph.get(near_mask).uav();
 
                 dc.CSSetShaderResources(0, srvs.size(), srvs.data());
                 dc.CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
@@ -729,88 +781,81 @@ namespace sp::effects {
                 dc.CSSetShaderResources(0, srvs.size(), srvs.data());
                 dc.CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
 
-                srvs = { near_mask.srv() };
+                graph.end_pass(near_mask_pass);
+                graph.begin_pass(blur_x_near_mask_pass, allocator);
 
-                auto near_mask_blur_x =
-                    allocator.allocate({ .format = DXGI_FORMAT_R8_UNORM,
-                                        .width = near_mask_width,
-                                        .height = near_mask_height,
-                                        .bind_flags = rendertarget_bind_srv_rtv });
-
-                srvs = { near_mask.srv() };
+                srvs = { graph.get(near_mask).srv() };
 
                 dc.PSSetShader(blur_x_near_mask_ps, nullptr, 0);
 
-                do_pass(dc, srvs, *near_mask_blur_x.rtv());
+                do_pass(dc, srvs, *graph.get(near_mask_blur_x).rtv());
+
+                graph.end_pass(blur_x_near_mask_pass);
+                graph.begin_pass(blur_y_near_mask_pass, allocator);
 
-                srvs = { near_mask_blur_x.srv() };
+                srvs = { graph.get(near_mask_blur_x).srv() };
 
                 dc.PSSetShader(blur_y_near_mask_ps, nullptr, 0);
 
                 clear_ps_srvs<1>(dc);
 
-                do_pass(dc, srvs, *near_mask.rtv());
+                do_pass(dc, srvs, *graph.get(near_mask).rtv());
+
+                graph.end_pass(blur_y_near_mask_pass);
             }
 
             set_viewport(dc, process_width, process_height);
 
-            srvs = { prepare_near.srv(), near_mask.srv(), prepare_far.srv() };
+            graph.begin_pass(gather_pass, allocator);
 
-            auto gather_near =
-                allocator.allocate({ .format = DXGI_FORMAT_R16G16B16A16_FLOAT,
-                                    .width = process_width,
-                                    .height = process_height,
-                                    .bind_flags = rendertarget_bind_srv_rtv });
-            auto gather_far =
-                allocator.allocate({ .format = DXGI_FORMAT_R16G16B16A16_FLOAT,
-                                    .width = process_width,
-                                    .height = process_height,
-                                    .bind_flags = rendertarget_bind_srv_rtv });
+            srvs = { graph.get(prepare_near).srv(), graph.get(near_mask).srv(),
+                     graph.get(prepare_far).srv() };
 
             if (separate_gather) {
                 dc.PSSetShader(gather_near_ps, nullptr, 0);
 
-                do_pass(dc, srvs, *gather_near.rtv());
+                do_pass(dc, srvs, *graph.get(gather_near).rtv());
 
                 dc.PSSetShader(gather_far_ps, nullptr, 0);
 
-                do_pass(dc, srvs, *gather_far.rtv());
+                do_pass(dc, srvs, *graph.get(gather_far).rtv());
             }
             else {
                 dc.PSSetShader(gather_ps, nullptr, 0);
 
-                do_pass(dc, srvs, { gather_near.rtv(), gather_far.rtv() });
+                do_pass(dc, srvs, { graph.get(gather_near).rtv(), graph.get(gather_far).rtv() });
             }
 
-            auto floodfill_near = std::move(prepare_near);
-            auto floodfill_far = std::move(prepare_far);
+            graph.end_pass(gather_pass);
+            graph.begin_pass(floodfill_pass, allocator);
 
-            srvs = { gather_near.srv(), gather_far.srv() };
+            srvs = { graph.get(gather_near).srv(), graph.get(gather_far).srv() };
 
             dc.PSSetShader(_dof_floodfill_ps.get(), nullptr, 0);
 
             clear_ps_srvs<3>(dc);
 
-            do_pass(dc, srvs, { floodfill_near.rtv(), floodfill_far.rtv() });
+            do_pass(dc, srvs,
+                    { graph.get(floodfill_near).rtv(), graph.get(floodfill_far).rtv() });
 
-            auto compose_target =
-                process_factor == 1
-                ? std::move(gather_near)
-                : allocator.allocate({ .format = DXGI_FORMAT_R16G16B16A16_FLOAT,
-                                      .width = input.width(),
-                                      .height = input.height(),
-                                      .bind_flags = rendertarget_bind_srv_rtv });
+            graph.end_pass(floodfill_pass);
+            graph.begin_pass(compose_pass, allocator);
 
-            srvs = { floodfill_near.srv(), floodfill_far.srv(), input.srv(), &input_depth };
+            srvs = { graph.get(floodfill_near).srv(), graph.get(floodfill_far).srv(),
+                     input.srv(), &input_depth };
 
             dc.PSSetShader(compose_ps, nullptr, 0);
 
             clear_ps_srvs<2>(dc);
 
-            set_viewport(dc, compose_target.width(), compose_target.height());
-            do_pass(dc, srvs, *compose_target.rtv());
+            auto output = graph.take(compose_target);
+
+            set_viewport(dc, output.width(), output.height());
+            do_pass(dc, srvs, *output.rtv());
+
+            graph.end_pass(compose_pass);
 
-            return std::move(compose_target);
+            return Work_texture{ std::move(output) };
         }
 
         auto do_fog(ID3D11DeviceContext1& dc, Rendertarget_allocator& allocator,
@@ -1329,7 +1374,11 @@ namespace sp::effects {
         auto blue_noise_srv(const core::Shader_resource_database& textures) noexcept
             -> ID3D11ShaderResourceView*
         {
-            if (_blue_noise_srvs.empty()) {
+            if (_blue_noise_srvs.empty() ||
+                _blue_noise_generation != textures.generation()) {
+                _blue_noise_srvs.clear();
+                _blue_noise_generation = textures.generation();
+
                 for (int i = 0; i < 64; ++i) {
                     _blue_noise_srvs.emplace_back(
                         textures.at_if("_SP_BUILTIN_blue_noise_rgb_"s + std::to_string(i)));
@@ -1417,9 +1466,9 @@ namespace sp::effects {
                 postprocess_finalize_flags |= Postprocess_finalize_flags::vignette_active;
 
             _postprocess_combine_ps =
-                _shaders.entrypoint("main_combine_ps"sv, postprocess_combine_flags);
+                _shaders.entrypoint(_combine_ps_id, postprocess_combine_flags);
             _postprocess_finalize_ps =
-                _shaders.entrypoint("main_finalize_ps"sv, postprocess_finalize_flags);
+                _shaders.entrypoint(_finalize_ps_id, postprocess_finalize_flags);
         }
 
         struct Resolve_constants {
@@ -1617,6 +1666,10 @@ namespace sp::effects {
             core::create_dynamic_constant_buffer(*_device, sizeof(Fog_constants));
 
         shader::Group_pixel& _shaders;
+        const shader::Entrypoint_id _combine_ps_id =
+            _shaders.entrypoint_id("main_combine_ps"sv);
+        const shader::Entrypoint_id _finalize_ps_id =
+            _shaders.entrypoint_id("main_finalize_ps"sv);
 
         const Com_ptr<ID3D11VertexShader> _fullscreen_vs;
         const Com_ptr<ID3D11PixelShader> _stock_hdr_to_linear_ps;
@@ -1670,6 +1723,8 @@ namespace sp::effects {
         DOF_params _dof_params{};
         Fog_params _fog_params{};
 
+        Rendertarget_graph _dof_graph;
+
         Hdr_state _hdr_state = Hdr_state::hdr;
 
         bool _config_changed = true;
@@ -1685,6 +1740,7 @@ namespace sp::effects {
         std::uniform_int_distribution<int> _random_int_dist{ 0, 63 };
 
         std::vector<Com_ptr<ID3D11ShaderResourceView>> _blue_noise_srvs;
+        std::uint64_t _blue_noise_generation = 0;
 
         std::string _bloom_dirt_texture_name;
 
@@ -1798,4 +1854,10 @@ namespace sp::effects {
     {
         return _impl->fog_params();
     }
+
+    auto Postprocess::dof_rendertarget_report() const noexcept
+        -> const Frame_graph_plan::Report&
+    {
+        return _impl->dof_rendertarget_report();
+    }
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "color_grading_regions_io.hpp"
 #include "com_ptr.hpp"
 #include "ffx_cas.hpp"
+#include "frame_graph.hpp"
 #include "helpers.hpp"
 #include "postprocess_params.hpp"
 #include "profiler.hpp"
@@ -79,6 +80,9 @@ public:
 
    auto fog_params() const noexcept -> const Fog_params&;
 
+   // How the depth of field targets were aliased the last time it ran.
+   auto dof_rendertarget_report() const noexcept -> const Frame_graph_plan::Report&;
+
    void color_grading_regions(const Color_grading_regions& colorgrading_regions) noexcept;
 
    void show_color_grading_regions_imgui(
@@ -0,0 +1,129 @@
+
+#include "profile_trace.hpp"
+
+#include <algorithm>
+
+#include <fmt/format.h>
+
+namespace sp::effects {
+
+namespace {
+
+// Chrome trace viewer thread id for the GPU timeline, kept well clear of the
+// CPU thread indices.
+constexpr std::uint32_t gpu_trace_thread = 0x10000;
+
+void write_json_string(std::ostream& out, const std::string_view string) noexcept
+{
+   out << '"';
+
+   for (const char c : string) {
+      switch (c) {
+      case '"':
+         out << "\\\"";
+         break;
+      case '\\':
+         out << "\\\\";
+         break;
+      default:
+         if (static_cast<unsigned char>(c) < 0x20) {
+            out << fmt::format("\\u{:04x}", static_cast<unsigned int>(c));
+         }
+         else {
+            out << c;
+         }
+      }
+   }
+
+   out << '"';
+}
+
+}
+
+auto Profile_section_names::intern(const std::string_view name) noexcept
+   -> Profile_section_id
+{
+   if (auto it = _ids.find(name); it != _ids.end()) return it->second;
+
+   const Profile_section_id id{static_cast<std::uint32_t>(_names.size())};
+
+   _names.emplace_back(name);
+   _ids.emplace(_names.back(), id);
+
+   return id;
+}
+
+auto profile_thread_index() noexcept -> std::uint32_t
+{
+   static std::atomic_uint32_t next_index = 0;
+   thread_local const std::uint32_t index =
+      next_index.fetch_add(1, std::memory_order_relaxed);
+
+   return index;
+}
+
+Profile_event_buffer::Profile_event_buffer(const std::size_t capacity) noexcept
+   : _capacity{capacity}, _events{std::make_unique<Profile_event[]>(capacity)}
+{
+}
+
+bool Profile_event_buffer::push(const Profile_event& event) noexcept
+{
+   const std::size_t index = _count.fetch_add(1, std::memory_order_relaxed);
+
+   if (index >= _capacity) {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+
+      return false;
+   }
+
+   _events[index] = event;
+
+   return true;
+}
+
+auto Profile_event_buffer::events() const noexcept -> std::span<const Profile_event>
+{
+   return {_events.get(), std::min(_count.load(std::memory_order_acquire), _capacity)};
+}
+
+void Profile_event_buffer::clear() noexcept
+{
+   _count.store(0, std::memory_order_release);
+}
+
+Profile_trace_capture::Profile_trace_capture(const std::uint32_t frame_count) noexcept
+   : _frames_remaining{frame_count}
+{
+}
+
+void Profile_trace_capture::add_frame(const std::span<const Profile_event> events) noexcept
+{
+   if (done()) return;
+
+   _events.insert(_events.end(), events.begin(), events.end());
+   _frames_remaining -= 1;
+}
+
+void Profile_trace_capture::write_chrome_trace(std::ostream& out,
+                                               const Profile_section_names& names) const noexcept
+{
+   out << R"({"displayTimeUnit":"ms","traceEvents":[)"
+       << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << gpu_trace_thread
+       << R"(,"args":{"name":"GPU"}})";
+
+   for (const auto& event : _events) {
+      const bool gpu = event.timeline == Profile_timeline::gpu;
+
+      out << ",\n{\"name\":";
+      write_json_string(out, names.name(event.section));
+      out << fmt::format(R"(,"cat":"{}","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":1,"tid":{},"args":{{"depth":{}}}}})",
+                         gpu ? "gpu" : "cpu", event.begin_ns / 1000.0,
+                         (event.end_ns - event.begin_ns) / 1000.0,
+                         gpu ? gpu_trace_thread : event.thread, event.depth);
+   }
+
+   out << "\n]}\n";
+}
+
+}
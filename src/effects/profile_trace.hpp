@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+
+namespace sp::effects {
+
+// Event collection and trace export for the Profiler. Nothing in here touches
+// D3D11, timestamps are plain nanoseconds from whatever clock the caller uses.
+
+enum class Profile_section_id : std::uint32_t {};
+
+enum class Profile_timeline : std::uint8_t { cpu, gpu };
+
+class Profile_section_names {
+public:
+   auto intern(const std::string_view name) noexcept -> Profile_section_id;
+
+   auto name(const Profile_section_id id) const noexcept -> std::string_view
+   {
+      return _names[static_cast<std::size_t>(id)];
+   }
+
+private:
+   struct Hash {
+      using is_transparent = void;
+
+      auto operator()(const std::string_view name) const noexcept -> std::size_t
+      {
+         return absl::Hash<std::string_view>{}(name);
+      }
+   };
+
+   absl::flat_hash_map<std::string, Profile_section_id, Hash, std::equal_to<>> _ids;
+   std::deque<std::string> _names;
+};
+
+struct Profile_event {
+   Profile_section_id section;
+   Profile_timeline timeline;
+   std::uint16_t depth;
+   std::uint32_t thread;
+   std::uint64_t begin_ns;
+   std::uint64_t end_ns;
+};
+
+// Small stable index for the calling thread, for use as Profile_event::thread.
+auto profile_thread_index() noexcept -> std::uint32_t;
+
+// Fixed capacity buffer of one frame's events. push is lock-free and may be
+// called from any thread, events that don't fit are counted and dropped.
+// events and clear must only be called once every push for the frame has
+// returned.
+class Profile_event_buffer {
+public:
+   explicit Profile_event_buffer(const std::size_t capacity) noexcept;
+
+   bool push(const Profile_event& event) noexcept;
+
+   auto events() const noexcept -> std::span<const Profile_event>;
+
+   void clear() noexcept;
+
+   auto dropped() const noexcept -> std::uint64_t
+   {
+      return _dropped.load(std::memory_order_relaxed);
+   }
+
+private:
+   const std::size_t _capacity;
+   const std::unique_ptr<Profile_event[]> _events;
+
+   std::atomic_size_t _count = 0;
+   std::atomic_uint64_t _dropped = 0;
+};
+
+// Collects the events of a number of frames and writes them out in the Chrome
+// trace event format (viewable in chrome://tracing or Perfetto).
+class Profile_trace_capture {
+public:
+   explicit Profile_trace_capture(const std::uint32_t frame_count) noexcept;
+
+   void add_frame(const std::span<const Profile_event> events) noexcept;
+
+   bool done() const noexcept
+   {
+      return _frames_remaining == 0;
+   }
+
+   auto event_count() const noexcept -> std::size_t
+   {
+      return _events.size();
+   }
+
+   void write_chrome_trace(std::ostream& out,
+                           const Profile_section_names& names) const noexcept;
+
+private:
+   std::vector<Profile_event> _events;
+   std::uint32_t _frames_remaining;
+};
+
+}
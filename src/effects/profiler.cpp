@@ -1,7 +1,11 @@
 
 #include "profiler.hpp"
+#include "../logger.hpp"
 
 #include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
 #include <numeric>
 
 #include <gsl/gsl>
@@ -17,6 +21,7 @@ struct Profile_timings {
    float max_duration;
    float min_duration;
    std::string_view name;
+   std::uint16_t depth;
 };
 }
 
@@ -30,22 +35,21 @@ auto Profiler::begin_section(ID3D11DeviceContext1& dc,
 {
    if (!enabled) return npos;
 
-   const std::size_t index = [&]() {
-      if (const auto index = find_section(name); index == npos) {
-         _sections.emplace_back(name, *_device);
+   const std::size_t parent = _section_stack.empty() ? npos : _section_stack.back();
+   const std::size_t index = find_section(parent, _section_names.intern(name));
 
-         return _sections.size() - 1;
-      }
-      else {
-         return index;
-      }
-   }();
-
-   auto& section = _sections[index].second;
+   auto& section = _sections[index];
 
    if (std::exchange(section.queried, true)) std::terminate();
 
    section.last_start_time = std::chrono::high_resolution_clock::now();
+   section.cpu_begin_ns = now_ns();
+
+   if (_section_stack.empty() && !_frame_cpu_begin_ns[_current_frame]) {
+      _frame_cpu_begin_ns[_current_frame] = section.cpu_begin_ns;
+   }
+
+   _section_stack.push_back(index);
 
    dc.Begin(section.disjoint_queries[_current_frame].get());
    dc.End(section.time_stamp_begin_queries[_current_frame].get());
@@ -59,27 +63,53 @@ void Profiler::end_section(ID3D11DeviceContext1& dc, const std::size_t index) no
 
    if (!enabled || index == npos) return;
 
-   Section_data& section = _sections[index].second;
+   Section_data& section = _sections[index];
 
    if (!std::exchange(section.queried, false)) std::terminate();
 
+   if (auto it = std::ranges::find(_section_stack, index); it != _section_stack.end()) {
+      _section_stack.erase(it, _section_stack.end());
+   }
+
    dc.End(section.time_stamp_end_queries[_current_frame].get());
    dc.End(section.disjoint_queries[_current_frame].get());
 
    section.active = true;
+
+   if (_trace_capture) {
+      _events.push({.section = section.name,
+                    .timeline = Profile_timeline::cpu,
+                    .depth = section.depth,
+                    .thread = profile_thread_index(),
+                    .begin_ns = section.cpu_begin_ns,
+                    .end_ns = now_ns()});
+   }
 }
 
 void Profiler::end_frame(ID3D11DeviceContext1& dc) noexcept
 {
    _current_frame = (_current_frame + 1) % query_frame_latency;
+   _section_stack.clear();
+
+   const std::uint64_t frame_cpu_begin_ns =
+      std::exchange(_frame_cpu_begin_ns[_current_frame], 0);
 
    if (!enabled) return;
 
    std::vector<Profile_timings> timings_list;
    timings_list.reserve(_sections.size());
 
-   for (auto& name_section : _sections) {
-      Section_data& section = name_section.second;
+   struct Gpu_timing {
+      std::size_t section;
+      UINT64 begin;
+      UINT64 end;
+      UINT64 frequency;
+   };
+
+   std::vector<Gpu_timing> gpu_timings;
+
+   for (std::size_t index = 0; index < _sections.size(); ++index) {
+      Section_data& section = _sections[index];
 
       if (!std::exchange(section.active, false)) continue;
 
@@ -107,6 +137,13 @@ void Profiler::end_frame(ID3D11DeviceContext1& dc) noexcept
          section.min_duration = std::min(section.min_duration, duration);
          section.current_duration_sample = (section.current_duration_sample + 1) %
                                            section.duration_samples.size();
+
+         if (_trace_capture) {
+            gpu_timings.push_back({.section = index,
+                                   .begin = begin,
+                                   .end = end,
+                                   .frequency = disjoint.Frequency});
+         }
       }
 
       Profile_timings timings;
@@ -116,11 +153,39 @@ void Profiler::end_frame(ID3D11DeviceContext1& dc) noexcept
                                  section.duration_samples.size();
       timings.max_duration = section.max_duration;
       timings.min_duration = section.min_duration;
-      timings.name = name_section.first;
+      timings.name = _section_names.name(section.name);
+      timings.depth = section.depth;
 
       timings_list.emplace_back(timings);
    }
 
+   if (_trace_capture) {
+      // There is no way to calibrate the GPU clock against the CPU's in D3D11
+      // so line the frame's first GPU timestamp up with the CPU time its first
+      // section began.
+      const auto gpu_origin =
+         std::ranges::min_element(gpu_timings, std::less{}, &Gpu_timing::begin);
+
+      for (const auto& timing : gpu_timings) {
+         const auto to_ns = [&](const UINT64 ticks) {
+            return frame_cpu_begin_ns +
+                   static_cast<std::uint64_t>((ticks - gpu_origin->begin) * 1.0e9 /
+                                              timing.frequency);
+         };
+
+         _events.push({.section = _sections[timing.section].name,
+                       .timeline = Profile_timeline::gpu,
+                       .depth = _sections[timing.section].depth,
+                       .begin_ns = to_ns(timing.begin),
+                       .end_ns = to_ns(timing.end)});
+      }
+
+      _trace_capture->add_frame(_events.events());
+      _events.clear();
+
+      if (_trace_capture->done()) save_trace();
+   }
+
    std::sort(timings_list.begin(), timings_list.end(),
              [](const Profile_timings& left, const Profile_timings& right) {
                 return left.last_start_time < right.last_start_time;
@@ -143,7 +208,8 @@ void Profiler::end_frame(ID3D11DeviceContext1& dc) noexcept
    ImGui::Separator();
 
    for (const auto& timings : timings_list) {
-      ImGui::Text("%s avg: %f max: %f min %f", timings.name.data(),
+      ImGui::Text("%*s%.*s avg: %f max: %f min %f", timings.depth * 2, "",
+                  static_cast<int>(timings.name.size()), timings.name.data(),
                   timings.average_duration, timings.max_duration,
                   timings.min_duration);
    }
@@ -151,13 +217,60 @@ void Profiler::end_frame(ID3D11DeviceContext1& dc) noexcept
    ImGui::End();
 }
 
-auto Profiler::find_section(const std::string_view name) const noexcept -> std::size_t
+void Profiler::capture_trace(const std::uint32_t frame_count) noexcept
 {
-   for (std::size_t i = 0; i < _sections.size(); ++i) {
-      if (_sections[i].first == name) return i;
+   enabled = true;
+
+   _events.clear();
+   _trace_capture = std::make_unique<Profile_trace_capture>(frame_count);
+}
+
+auto Profiler::find_section(const std::size_t parent, const Profile_section_id name) noexcept
+   -> std::size_t
+{
+   const auto [it, inserted] = _section_lookup.try_emplace({parent, name}, _sections.size());
+
+   if (inserted) {
+      auto& section = _sections.emplace_back(*_device);
+
+      section.name = name;
+      section.parent = parent;
+      section.depth = parent == npos
+                         ? std::uint16_t{0}
+                         : static_cast<std::uint16_t>(_sections[parent].depth + 1);
+   }
+
+   return it->second;
+}
+
+auto Profiler::now_ns() const noexcept -> std::uint64_t
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - _epoch)
+      .count();
+}
+
+void Profiler::save_trace() noexcept
+{
+   const std::filesystem::path path =
+      fmt::format("ProfilerTraces/effects_{}.json", std::time(nullptr));
+
+   std::error_code error;
+
+   std::filesystem::create_directories(path.parent_path(), error);
+
+   std::ofstream file{path};
+
+   _trace_capture->write_chrome_trace(file, _section_names);
+
+   if (!file) {
+      log(Log_level::error, "Failed to save profiler trace to "sv, path.string());
+   }
+   else {
+      log(Log_level::info, "Saved profiler trace to "sv, path.string());
    }
 
-   return npos;
+   _trace_capture = nullptr;
 }
 
 Profiler::Section_data::Section_data(ID3D11Device1& device) noexcept
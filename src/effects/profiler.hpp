@@ -1,14 +1,19 @@
 #pragma once
 
 #include "com_ptr.hpp"
+#include "profile_trace.hpp"
 
 #include <array>
 #include <chrono>
 #include <limits>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include <d3d11_1.h>
 
 namespace sp::effects {
@@ -30,17 +35,37 @@ public:
 
    void end_frame(ID3D11DeviceContext1& dc) noexcept;
 
+   // Records the CPU and GPU timings of the next frame_count frames and saves
+   // them as a Chrome trace once done.
+   void capture_trace(const std::uint32_t frame_count) noexcept;
+
+   bool capturing_trace() const noexcept
+   {
+      return _trace_capture != nullptr;
+   }
+
    bool enabled = false;
 
 private:
    constexpr static std::size_t query_frame_latency = 5;
    constexpr static std::size_t npos = std::numeric_limits<std::size_t>::max();
 
-   auto find_section(const std::string_view name) const noexcept -> std::size_t;
+   auto find_section(const std::size_t parent, const Profile_section_id name) noexcept
+      -> std::size_t;
+
+   auto now_ns() const noexcept -> std::uint64_t;
+
+   void save_trace() noexcept;
 
    struct Section_data {
       Section_data(ID3D11Device1& device) noexcept;
 
+      Profile_section_id name;
+      std::size_t parent = npos;
+      std::uint16_t depth = 0;
+
+      std::uint64_t cpu_begin_ns = 0;
+
       std::array<Com_ptr<ID3D11Query>, query_frame_latency> disjoint_queries{};
       std::array<Com_ptr<ID3D11Query>, query_frame_latency> time_stamp_begin_queries{};
       std::array<Com_ptr<ID3D11Query>, query_frame_latency> time_stamp_end_queries{};
@@ -56,10 +81,21 @@ private:
    };
 
    const Com_ptr<ID3D11Device1> _device;
+   const std::chrono::steady_clock::time_point _epoch = std::chrono::steady_clock::now();
 
    std::size_t _current_frame = 0;
 
-   std::vector<std::pair<std::string, Section_data>> _sections;
+   // CPU time the first section of the frame each query slot belongs to
+   // began. GPU timestamps are placed relative to it in traces.
+   std::array<std::uint64_t, query_frame_latency> _frame_cpu_begin_ns{};
+
+   std::vector<Section_data> _sections;
+   absl::flat_hash_map<std::pair<std::size_t, Profile_section_id>, std::size_t> _section_lookup;
+   std::vector<std::size_t> _section_stack;
+
+   Profile_section_names _section_names;
+   Profile_event_buffer _events{4096};
+   std::unique_ptr<Profile_trace_capture> _trace_capture;
 };
 
 class Profile {
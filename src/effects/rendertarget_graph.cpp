@@ -0,0 +1,105 @@
+
+#include "rendertarget_graph.hpp"
+#include "../logger.hpp"
+
+#include <algorithm>
+
+#include <DirectXTex.h>
+
+namespace sp::effects {
+
+void Rendertarget_graph::clear() noexcept
+{
+   _graph.clear();
+   _descs.clear();
+   _slot_targets.clear();
+}
+
+auto Rendertarget_graph::create(const std::string_view name,
+                                const Rendertarget_desc& desc) noexcept -> Resource
+{
+   // Only identical descs can share a target, so the alias class is just the
+   // index of the first transient with this desc.
+   const auto alias_class =
+      static_cast<std::uint64_t>(std::ranges::find(_descs, desc) - _descs.begin());
+   const auto size = std::uint64_t{desc.width} * desc.height *
+                     DirectX::BitsPerPixel(desc.format) / 8;
+
+   _descs.push_back(desc);
+
+   return _graph.create_transient(
+      {.name = name, .alias_class = alias_class, .size = size});
+}
+
+auto Rendertarget_graph::add_pass(const std::string_view name,
+                                  std::initializer_list<Resource> reads,
+                                  std::initializer_list<Resource> writes) noexcept -> Pass
+{
+   return _graph.add_pass(name, reads, writes);
+}
+
+void Rendertarget_graph::plan() noexcept
+{
+   plan_frame_graph(_graph, _plan);
+
+   for (const auto& error : _plan.errors) log(Log_level::warning, error);
+
+   _slot_descs.resize(_plan.slots.size());
+
+   for (std::size_t i = 0; i < _descs.size(); ++i) {
+      const auto slot = _plan.slot(Resource{static_cast<std::uint32_t>(i)});
+
+      if (slot != Frame_graph_plan::no_slot) _slot_descs[slot] = _descs[i];
+   }
+
+   _slot_targets.clear();
+   _slot_targets.resize(_plan.slots.size());
+}
+
+void Rendertarget_graph::begin_pass(const Pass pass, Rendertarget_allocator& allocator) noexcept
+{
+   for (std::size_t slot = 0; slot < _plan.slots.size(); ++slot) {
+      if (_plan.slots[slot].lifetime.first_pass == pass) {
+         _slot_targets[slot].emplace(allocator.allocate(_slot_descs[slot]));
+      }
+   }
+}
+
+void Rendertarget_graph::end_pass(const Pass pass) noexcept
+{
+   for (std::size_t slot = 0; slot < _plan.slots.size(); ++slot) {
+      if (_plan.slots[slot].lifetime.last_pass == pass) _slot_targets[slot].reset();
+   }
+}
+
+auto Rendertarget_graph::get(const Resource resource) const noexcept
+   -> const Rendertarget_allocator::Handle&
+{
+   const auto slot = _plan.slot(resource);
+
+   if (slot == Frame_graph_plan::no_slot || !_slot_targets[slot]) {
+      log_and_terminate("Attempt to use rendertarget graph transient outside of its passes!"sv);
+   }
+
+   return *_slot_targets[slot];
+}
+
+auto Rendertarget_graph::take(const Resource resource) noexcept
+   -> Rendertarget_allocator::Handle
+{
+   const auto slot = _plan.slot(resource);
+
+   if (slot == Frame_graph_plan::no_slot || !_slot_targets[slot] ||
+       _plan.slots[slot].lifetime.last_pass !=
+          _plan.lifetimes[static_cast<std::size_t>(resource)].last_pass) {
+      log_and_terminate("Attempt to take rendertarget graph transient that is still in use!"sv);
+   }
+
+   auto handle = std::move(*_slot_targets[slot]);
+
+   _slot_targets[slot].reset();
+
+   return handle;
+}
+
+}
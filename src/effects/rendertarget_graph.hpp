@@ -0,0 +1,71 @@
+#pragma once
+
+#include "frame_graph.hpp"
+#include "rendertarget_allocator.hpp"
+
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace sp::effects {
+
+// Runs a Frame_graph of rendertarget passes. Transients with the same
+// Rendertarget_desc and non-overlapping lifetimes share one target, and each
+// target is only taken from the allocator for the span of passes that need it
+// so anything allocated around the graph can reuse it.
+//
+// Keep one around and clear it each time the passes are declared, the storage
+// is reused so declaring and planning don't allocate once warmed up.
+class Rendertarget_graph {
+public:
+   using Resource = Frame_graph::Resource;
+   using Pass = std::uint32_t;
+
+   void clear() noexcept;
+
+   auto create(const std::string_view name, const Rendertarget_desc& desc) noexcept
+      -> Resource;
+
+   auto add_pass(const std::string_view name, std::initializer_list<Resource> reads,
+                 std::initializer_list<Resource> writes) noexcept -> Pass;
+
+   // Plans the declared passes, must be called before the first begin_pass.
+   void plan() noexcept;
+
+   // Takes the targets first used by pass from the allocator.
+   void begin_pass(const Pass pass, Rendertarget_allocator& allocator) noexcept;
+
+   // Returns the targets last used by pass to the allocator.
+   void end_pass(const Pass pass) noexcept;
+
+   // The target backing a transient. Only valid inside the passes that use it.
+   auto get(const Resource resource) const noexcept -> const Rendertarget_allocator::Handle&;
+
+   // Takes ownership of a transient's target so it can outlive the graph. Only
+   // valid inside the transient's last pass and only if nothing after it shares
+   // the target.
+   auto take(const Resource resource) noexcept -> Rendertarget_allocator::Handle;
+
+   auto graph() const noexcept -> const Frame_graph&
+   {
+      return _graph;
+   }
+
+   // The report from the last plan.
+   auto report() const noexcept -> const Frame_graph_plan::Report&
+   {
+      return _plan.report;
+   }
+
+private:
+   Frame_graph _graph;
+   std::vector<Rendertarget_desc> _descs;
+
+   Frame_graph_plan _plan;
+   std::vector<Rendertarget_desc> _slot_descs;
+   std::vector<std::optional<Rendertarget_allocator::Handle>> _slot_targets;
+};
+
+}
@@ -1,4 +1,5 @@
 
+#include "game_support/current_map.hpp"
 #include "game_support/font_declarations.hpp"
 #include "game_support/munged_shader_declarations.hpp"
 #include "logger.hpp"
@@ -123,7 +124,9 @@ auto edit_core_lvl() noexcept -> win32::Unique_handle
                       [] {
                          return game_support::create_font_declarations(
                             windows_fonts_folder() /
-                            user_config.developer.scalable_font_name);
+                               user_config.developer.scalable_font_name,
+                            user_config.developer.shader_cache_path.parent_path() /
+                               L".font_cache"sv);
                       })
          : std::future<game_support::Font_declarations>{};
 
@@ -299,6 +302,8 @@ extern "C" HANDLE WINAPI CreateFileA_hook(LPCSTR file_name,
                                           HANDLE template_file)
 {
    if (user_config.enabled && file_name) {
+      game_support::note_lvl_file_opened(file_name);
+
       if (Ci_String_view{file_name} == R"(data\_lvl_pc\core.lvl)"_svci)
          return edit_core_lvl().release();
       else if (Ci_String_view{file_name} == R"(data\_lvl_pc\shader_patch_api.script)"_svci)
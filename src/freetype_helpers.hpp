@@ -2,6 +2,7 @@
 
 #include "logger.hpp"
 
+#include <cstdint>
 #include <filesystem>
 #include <span>
 
@@ -10,6 +11,11 @@
 
 namespace sp {
 
+// Glyph rendering can change between FreeType versions so this is part of font
+// cache keys.
+constexpr std::uint32_t freetype_version =
+   FREETYPE_MAJOR * 10000 + FREETYPE_MINOR * 100 + FREETYPE_PATCH;
+
 template<typename T, auto deleter>
 struct Freetype_ptr {
    Freetype_ptr() = default;
@@ -0,0 +1,85 @@
+
+#include "current_map.hpp"
+#include "string_utilities.hpp"
+
+#include <atomic>
+#include <mutex>
+
+using namespace std::literals;
+
+namespace sp::game_support {
+
+namespace {
+
+std::mutex current_map_mutex;
+std::string current_map_name;
+std::atomic_uint32_t current_map_generation_counter = 0;
+
+// Map .lvl files live in a folder named after the map and are themselves
+// named after it, like "_lvl_pc\tat\tat2.lvl" or "_lvl_pc\ABC\ABC.lvl". The
+// shell gets treated as its own map so its draws don't get attributed to
+// whichever map was played last.
+auto map_name_from_lvl_path(const std::string_view file_name) noexcept
+   -> std::string_view
+{
+   const std::string_view lvl_extension = ".lvl"sv;
+
+   if (file_name.size() <= lvl_extension.size() ||
+       view_as_ci_string(file_name.substr(file_name.size() - lvl_extension.size())) !=
+          ".lvl"_svci) {
+      return ""sv;
+   }
+
+   const auto file_sep = file_name.find_last_of("\\/"sv);
+
+   if (file_sep == file_name.npos) return ""sv;
+
+   const auto stem = file_name.substr(file_sep + 1, file_name.size() - file_sep - 1 -
+                                                       lvl_extension.size());
+
+   const auto dir_sep = file_name.find_last_of("\\/"sv, file_sep - 1);
+   const auto dir = dir_sep == file_name.npos
+                       ? file_name.substr(0, file_sep)
+                       : file_name.substr(dir_sep + 1, file_sep - dir_sep - 1);
+
+   if (view_as_ci_string(dir) == "_lvl_pc"_svci) {
+      return view_as_ci_string(stem) == "shell"_svci ? stem : ""sv;
+   }
+
+   if (dir.empty() || stem.size() < dir.size() ||
+       view_as_ci_string(stem.substr(0, dir.size())) != view_as_ci_string(dir)) {
+      return ""sv;
+   }
+
+   return stem;
+}
+
+}
+
+void note_lvl_file_opened(const std::string_view file_name) noexcept
+{
+   const auto map_name = map_name_from_lvl_path(file_name);
+
+   if (map_name.empty()) return;
+
+   std::scoped_lock lock{current_map_mutex};
+
+   if (view_as_ci_string(map_name) == view_as_ci_string(current_map_name)) return;
+
+   current_map_name = map_name;
+   current_map_generation_counter.fetch_add(1, std::memory_order_release);
+}
+
+auto current_map() noexcept -> std::string
+{
+   std::scoped_lock lock{current_map_mutex};
+
+   return current_map_name;
+}
+
+auto current_map_generation() noexcept -> std::uint32_t
+{
+   return current_map_generation_counter.load(std::memory_order_acquire);
+}
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace sp::game_support {
+
+// Tracks which map the game is currently loading or playing, as best as can
+// be told from the .lvl files it opens. Safe to call from any thread.
+
+void note_lvl_file_opened(const std::string_view file_name) noexcept;
+
+auto current_map() noexcept -> std::string;
+
+// Incremented each time the current map changes.
+auto current_map_generation() noexcept -> std::uint32_t;
+
+}
@@ -0,0 +1,121 @@
+
+#include "font_cache.hpp"
+#include "../logger.hpp"
+#include "magic_number.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#include <fmt/format.h>
+
+namespace sp::game_support {
+
+namespace {
+
+struct Font_cache_header {
+   Magic_number mn = "spfc"_mn;
+   std::uint32_t version = 1;
+   Font_cache_key key;
+   std::uint64_t payload_size = 0;
+   std::uint64_t payload_hash = 0;
+};
+
+static_assert(sizeof(Font_cache_header) == 48);
+
+// Larger than the largest atlas that could be built, anything bigger is corrupt.
+constexpr std::uint64_t max_payload_size = 8192ull * 8192ull + 65536ull;
+
+auto cache_path(const std::filesystem::path& directory, const std::string_view kind,
+                const Font_cache_key& key) -> std::filesystem::path
+{
+   return directory / fmt::format("{}_{:016x}_{}_{}.bin", kind, key.font_hash,
+                                  key.pixel_size, key.dpi);
+}
+
+}
+
+auto hash_font_data(const std::span<const std::byte> data) noexcept -> std::uint64_t
+{
+   // FNV-1a
+   constexpr std::uint64_t offset_basis = 14695981039346656037ull;
+   constexpr std::uint64_t prime = 1099511628211ull;
+
+   std::uint64_t hash = offset_basis;
+
+   for (const std::byte b : data) {
+      hash ^= static_cast<std::uint64_t>(b);
+      hash *= prime;
+   }
+
+   return hash;
+}
+
+auto load_font_cache(const std::filesystem::path& directory, const std::string_view kind,
+                     const Font_cache_key& key) noexcept
+   -> std::optional<std::vector<std::byte>>
+{
+   try {
+      std::ifstream file{cache_path(directory, kind, key), std::ios::binary};
+
+      if (!file) return std::nullopt;
+
+      Font_cache_header header;
+
+      if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+         return std::nullopt;
+      }
+
+      if (header.mn != Font_cache_header{}.mn ||
+          header.version != Font_cache_header{}.version || header.key != key ||
+          header.payload_size > max_payload_size) {
+         return std::nullopt;
+      }
+
+      std::vector<std::byte> payload;
+      payload.resize(static_cast<std::size_t>(header.payload_size));
+
+      if (!file.read(reinterpret_cast<char*>(payload.data()), payload.size()) ||
+          hash_font_data(payload) != header.payload_hash) {
+         log(Log_level::warning, "Ignoring corrupt font cache entry "sv, kind);
+
+         return std::nullopt;
+      }
+
+      return payload;
+   }
+   catch (std::exception&) {
+      return std::nullopt;
+   }
+}
+
+void save_font_cache(const std::filesystem::path& directory, const std::string_view kind,
+                     const Font_cache_key& key,
+                     const std::span<const std::byte> payload) noexcept
+{
+   try {
+      std::filesystem::create_directories(directory);
+
+      const auto path = cache_path(directory, kind, key);
+      const auto write_path = std::filesystem::path{path} += L".TEMP"sv;
+
+      const Font_cache_header header{.key = key,
+                                     .payload_size = payload.size(),
+                                     .payload_hash = hash_font_data(payload)};
+
+      {
+         std::ofstream file{write_path, std::ios::binary};
+
+         file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+         file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+
+         if (!file) throw std::runtime_error{"failed to write font cache entry"};
+      }
+
+      std::filesystem::rename(write_path, path);
+   }
+   catch (std::exception&) {
+      log(Log_level::warning, "Failed to save font cache entry "sv, kind);
+   }
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sp::game_support {
+
+// Identifies an entry in the on-disk font cache. An entry is only used if every
+// field matches, so anything that changes the rendered output belongs here.
+struct Font_cache_key {
+   std::uint64_t font_hash = 0;
+   std::uint32_t freetype_version = 0;
+   std::uint32_t pixel_size = 0;
+   std::uint32_t dpi = 0;
+
+   bool operator==(const Font_cache_key&) const noexcept = default;
+};
+
+auto hash_font_data(const std::span<const std::byte> data) noexcept -> std::uint64_t;
+
+// Returns the payload of a cache entry. Missing entries, entries for a different
+// key and entries that fail validation all return nullopt.
+auto load_font_cache(const std::filesystem::path& directory, const std::string_view kind,
+                     const Font_cache_key& key) noexcept
+   -> std::optional<std::vector<std::byte>>;
+
+// Failing to save is logged and otherwise ignored, the entry is just generated
+// again next time.
+void save_font_cache(const std::filesystem::path& directory, const std::string_view kind,
+                     const Font_cache_key& key,
+                     const std::span<const std::byte> payload) noexcept;
+
+}
@@ -1,9 +1,13 @@
 #include "font_declarations.hpp"
 #include "../freetype_helpers.hpp"
+#include "font_cache.hpp"
 #include "font_info.hpp"
 #include "patch_material_io.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <future>
+#include <optional>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -26,14 +30,14 @@ struct Glyph_metrics {
 struct Font_metrics {
    unsigned font_size;
    unsigned font_height;
-   std::array<Glyph_metrics, glyph_count> glyphs;
+   std::array<Glyph_metrics, glyph_count> glyphs{};
 };
 
 auto load_font_metrics(FT_Face face, const FT_UInt font_size) -> Font_metrics
 {
    freetype_checked_call(FT_Set_Pixel_Sizes(face, 0, font_size));
 
-   std::array<Glyph_metrics, glyph_count> glyphs;
+   std::array<Glyph_metrics, glyph_count> glyphs{};
 
    for (std::size_t i = 0; i < glyph_count; ++i) {
       auto glyph_index = FT_Get_Char_Index(face, game_glyphs[i]);
@@ -53,6 +57,37 @@ auto load_font_metrics(FT_Face face, const FT_UInt font_size) -> Font_metrics
    return {.font_size = font_size, .font_height = font_height, .glyphs = glyphs};
 }
 
+auto metrics_cache_key(const std::uint64_t font_hash, const std::uint32_t font_size)
+   noexcept -> Font_cache_key
+{
+   return {.font_hash = font_hash,
+           .freetype_version = freetype_version,
+           .pixel_size = font_size};
+}
+
+auto load_cached_font_metrics(const std::filesystem::path& cache_directory,
+                              const Font_cache_key& key) -> std::optional<Font_metrics>
+{
+   const auto payload = load_font_cache(cache_directory, "metrics"sv, key);
+
+   if (!payload || payload->size() != sizeof(Font_metrics)) return std::nullopt;
+
+   Font_metrics metrics;
+
+   std::memcpy(&metrics, payload->data(), sizeof(Font_metrics));
+
+   // Declarations store these as bytes, anything larger can't have come from us.
+   const bool valid =
+      metrics.font_size == key.pixel_size && metrics.font_height <= 255 &&
+      std::ranges::all_of(metrics.glyphs, [](const Glyph_metrics& glyph) {
+         return glyph.advance <= 255 && glyph.width <= 255 && glyph.height <= 255;
+      });
+
+   if (!valid) return std::nullopt;
+
+   return metrics;
+}
+
 auto make_font_declaration(std::string name, std::string_view atlas_index,
                            std::string_view atlas_texture,
                            const Font_metrics& metrics) -> ucfb::Editor_data_chunk
@@ -141,39 +176,61 @@ auto make_font_declaration(std::string name, std::string_view atlas_index,
 
 }
 
-auto create_font_declarations(const std::filesystem::path& font_path) -> Font_declarations
+auto create_font_declarations(const std::filesystem::path& font_path,
+                              const std::filesystem::path& cache_directory)
+   -> Font_declarations
 {
    const static Font_declarations font_declarations = [&] {
-      auto freetype_library = make_freetype_library();
-
       const std::vector<FT_Byte> font_data = load_font_data(font_path);
+      const std::uint64_t font_hash = hash_font_data(std::as_bytes(std::span{font_data}));
 
-      std::array freetype_faces{make_freetype_face(freetype_library, font_data),
-                                make_freetype_face(freetype_library, font_data),
-                                make_freetype_face(freetype_library, font_data),
-                                make_freetype_face(freetype_library, font_data)};
+      std::array<std::optional<Font_metrics>, atlas_font_sizes.size()> font_metrics;
 
-      const auto make_metrics_async = [&](const std::size_t i) {
-         return std::async(std::launch::async, [i, &freetype_faces] {
-            return load_font_metrics(freetype_faces[i], atlas_font_sizes[i]);
-         });
-      };
+      for (std::size_t i = 0; i < font_metrics.size(); ++i) {
+         font_metrics[i] =
+            load_cached_font_metrics(cache_directory,
+                                     metrics_cache_key(font_hash, atlas_font_sizes[i]));
+      }
+
+      // FreeType is only needed for sizes missing from the cache.
+      const bool all_cached = std::ranges::all_of(font_metrics, [](const auto& metrics) {
+         return metrics.has_value();
+      });
+
+      if (!all_cached) {
+         auto freetype_library = make_freetype_library();
+
+         std::array<Freetype_ptr<FT_Face, FT_Done_Face>, atlas_font_sizes.size()>
+            freetype_faces;
+         std::array<std::future<Font_metrics>, atlas_font_sizes.size()>
+            font_metrics_futures;
 
-      std::array font_metrics_futures{make_metrics_async(large_index),
-                                      make_metrics_async(medium_index),
-                                      make_metrics_async(small_index),
-                                      make_metrics_async(tiny_index)};
+         for (std::size_t i = 0; i < font_metrics.size(); ++i) {
+            if (font_metrics[i]) continue;
 
-      std::array font_metrics{font_metrics_futures[large_index].get(),
-                              font_metrics_futures[medium_index].get(),
-                              font_metrics_futures[small_index].get(),
-                              font_metrics_futures[tiny_index].get()};
+            freetype_faces[i] = make_freetype_face(freetype_library, font_data);
+            font_metrics_futures[i] =
+               std::async(std::launch::async, [i, &freetype_faces] {
+                  return load_font_metrics(freetype_faces[i], atlas_font_sizes[i]);
+               });
+         }
+
+         for (std::size_t i = 0; i < font_metrics.size(); ++i) {
+            if (!font_metrics_futures[i].valid()) continue;
+
+            font_metrics[i] = font_metrics_futures[i].get();
+
+            save_font_cache(cache_directory, "metrics"sv,
+                            metrics_cache_key(font_hash, atlas_font_sizes[i]),
+                            std::as_bytes(std::span{&*font_metrics[i], 1}));
+         }
+      }
 
       const auto make_declaration_from_index = [&](std::string_view name,
                                                    const std::size_t i) {
          return std::pair{name,
                           make_font_declaration(std::string{name}, atlas_index_names[i],
-                                                atlas_names[i], font_metrics[i])};
+                                                atlas_names[i], *font_metrics[i])};
       };
 
       Font_declarations declarations{
@@ -11,7 +11,9 @@ const std::size_t font_count = 5;
 using Font_declarations =
    std::array<std::pair<std::string_view, ucfb::Editor_data_chunk>, font_count>;
 
-auto create_font_declarations(const std::filesystem::path& font_path)
+// Font metrics are cached in cache_directory, keyed on the font's contents.
+auto create_font_declarations(const std::filesystem::path& font_path,
+                              const std::filesystem::path& cache_directory)
    -> Font_declarations;
 
 }
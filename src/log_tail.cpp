@@ -0,0 +1,218 @@
+
+#include "log_tail.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <utility>
+
+using namespace std::literals;
+
+namespace sp {
+
+namespace {
+
+// How much of the start of the file is remembered to detect it being replaced.
+constexpr std::size_t head_size = 256;
+
+constexpr std::size_t read_chunk_size = 1048576;
+
+auto read_bytes(std::ifstream& file, const std::uint64_t offset, const std::size_t count,
+                std::string& out) noexcept -> std::size_t
+{
+   out.resize(count);
+
+   file.clear();
+   file.seekg(offset);
+   file.read(out.data(), count);
+
+   out.resize(static_cast<std::size_t>(file.gcount()));
+
+   return out.size();
+}
+
+auto to_lower(const char c) noexcept -> char
+{
+   return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+// Filter literals are stored lowercase, so only the text needs folding.
+bool equals_lowercase(const char text, const char lowercase) noexcept
+{
+   return to_lower(text) == lowercase;
+}
+
+bool is_regex_syntax(const char c) noexcept
+{
+   return "\\^$.|?*+()[]{}"sv.find(c) != std::string_view::npos;
+}
+
+// Returns the literal text of a pattern if it has no regex syntax besides
+// escaped syntax characters.
+auto pattern_literal(const std::string_view pattern) noexcept -> std::optional<std::string>
+{
+   std::string literal;
+   literal.reserve(pattern.size());
+
+   for (std::size_t i = 0; i < pattern.size(); ++i) {
+      if (pattern[i] == '\\') {
+         if (i + 1 == pattern.size() || !is_regex_syntax(pattern[i + 1])) {
+            return std::nullopt;
+         }
+
+         literal += to_lower(pattern[++i]);
+      }
+      else if (is_regex_syntax(pattern[i])) {
+         return std::nullopt;
+      }
+      else {
+         literal += to_lower(pattern[i]);
+      }
+   }
+
+   return literal;
+}
+
+}
+
+Log_tail::Log_tail(std::filesystem::path path, const std::uint64_t max_initial_bytes) noexcept
+   : _path{std::move(path)}, _max_initial_bytes{max_initial_bytes}
+{
+}
+
+auto Log_tail::poll() noexcept -> Update
+{
+   Update update;
+
+   std::error_code error;
+
+   const std::uint64_t size = std::filesystem::file_size(_path, error);
+
+   if (error) {
+      if (_opened) {
+         reset();
+         update.reset = true;
+      }
+
+      return update;
+   }
+
+   std::ifstream file{_path, std::ios::binary};
+
+   if (!file) return update;
+
+   std::string head;
+   read_bytes(file, 0, static_cast<std::size_t>(std::min<std::uint64_t>(size, head_size)),
+              head);
+
+   if (_opened && (size < _offset || !head.starts_with(_head))) {
+      reset();
+      update.reset = true;
+   }
+
+   _head = std::move(head);
+
+   if (!_opened) {
+      _opened = true;
+      _offset = size > _max_initial_bytes ? size - _max_initial_bytes : 0;
+      _skip_first_line = _offset != 0;
+   }
+
+   std::string chunk;
+
+   while (_offset < size) {
+      const auto count = static_cast<std::size_t>(
+         std::min<std::uint64_t>(size - _offset, read_chunk_size));
+
+      if (read_bytes(file, _offset, count, chunk) == 0) break;
+
+      _offset += chunk.size();
+
+      split_lines(chunk, update.lines);
+   }
+
+   return update;
+}
+
+void Log_tail::reset() noexcept
+{
+   _opened = false;
+   _skip_first_line = false;
+   _offset = 0;
+   _head.clear();
+   _partial_line.clear();
+}
+
+void Log_tail::split_lines(std::string_view data, std::vector<std::string>& lines) noexcept
+{
+   for (auto newline = data.find('\n'); newline != data.npos; newline = data.find('\n')) {
+      auto line = data.substr(0, newline);
+
+      data.remove_prefix(newline + 1);
+
+      if (std::exchange(_skip_first_line, false)) {
+         _partial_line.clear();
+
+         continue;
+      }
+
+      if (!_partial_line.empty()) {
+         _partial_line += line;
+         line = _partial_line;
+      }
+
+      if (line.ends_with('\r')) line.remove_suffix(1);
+
+      lines.emplace_back(line);
+      _partial_line.clear();
+   }
+
+   _partial_line += data;
+}
+
+Log_filter::Log_filter(const std::string_view pattern) noexcept
+{
+   if (pattern.empty()) return;
+
+   if (auto literal = pattern_literal(pattern); literal) {
+      _kind = Kind::substring;
+      _literal = std::move(*literal);
+
+      return;
+   }
+
+   if (pattern.starts_with('^')) {
+      if (auto literal = pattern_literal(pattern.substr(1)); literal) {
+         _kind = Kind::prefix;
+         _literal = std::move(*literal);
+
+         return;
+      }
+   }
+
+   try {
+      _regex.emplace(pattern.cbegin(), pattern.cend(), std::regex::icase);
+      _kind = Kind::regex;
+   }
+   catch (std::regex_error&) {
+   }
+}
+
+bool Log_filter::matches(const std::string_view text) const noexcept
+{
+   switch (_kind) {
+   case Kind::substring:
+      return !std::ranges::search(text, _literal, equals_lowercase).empty();
+   case Kind::prefix:
+      return text.size() >= _literal.size() &&
+             std::ranges::equal(text.substr(0, _literal.size()), _literal,
+                                equals_lowercase);
+   case Kind::regex:
+      return std::regex_search(text.cbegin(), text.cend(), *_regex);
+   case Kind::everything:
+   default:
+      return true;
+   }
+}
+
+}
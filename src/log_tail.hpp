@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sp {
+
+// Reads lines appended to a text file since the last poll. Only the offset
+// read up to is remembered, so the cost of a poll is proportional to what was
+// appended. If the file shrinks or its first bytes change it is taken to have
+// been truncated or replaced and is read again from the start. Uses only the
+// standard library, so it can be driven anywhere.
+class Log_tail {
+public:
+   struct Update {
+      bool reset = false; // Lines from previous polls are stale.
+      std::vector<std::string> lines;
+   };
+
+   // When first opened (or after a reset) only the last max_initial_bytes of
+   // the file are read.
+   explicit Log_tail(std::filesystem::path path,
+                     const std::uint64_t max_initial_bytes = 4194304) noexcept;
+
+   // Returns complete lines (without line terminators) appended since the
+   // last poll. A trailing line with no terminator is held until it is ended.
+   auto poll() noexcept -> Update;
+
+private:
+   void reset() noexcept;
+
+   void split_lines(std::string_view data, std::vector<std::string>& lines) noexcept;
+
+   const std::filesystem::path _path;
+   const std::uint64_t _max_initial_bytes;
+
+   bool _opened = false;
+   bool _skip_first_line = false;
+   std::uint64_t _offset = 0;
+   std::string _head;
+   std::string _partial_line;
+};
+
+// A case insensitive filter for log lines. Patterns that contain no regex
+// syntax are matched as plain substrings and patterns that are only anchored
+// at the start as prefixes, a std::regex is only built for anything else.
+// Invalid regexes and empty patterns match everything.
+class Log_filter {
+public:
+   Log_filter() = default;
+
+   explicit Log_filter(const std::string_view pattern) noexcept;
+
+   bool matches(const std::string_view text) const noexcept;
+
+   bool matches_everything() const noexcept
+   {
+      return _kind == Kind::everything;
+   }
+
+private:
+   enum class Kind { everything, substring, prefix, regex };
+
+   Kind _kind = Kind::everything;
+   std::string _literal;
+   std::optional<std::regex> _regex;
+};
+
+}
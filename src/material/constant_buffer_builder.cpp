@@ -1,245 +1,76 @@
 
 #include "constant_buffer_builder.hpp"
 #include "../logger.hpp"
-#include "overloaded.hpp"
-#include "string_utilities.hpp"
-#include "utility.hpp"
 
-#include <charconv>
+#include <array>
+#include <cstring>
 #include <typeinfo>
 
-#include <fmt/format.h>
-
 namespace sp::material {
 
 namespace {
 
-enum class Type {
-   float_,
-   float2,
-   float3,
-   float4,
-   int_,
-   int2,
-   int3,
-   int4,
-   uint,
-   uint2,
-   uint3,
-   uint4,
-   bool_
-};
-
-auto type_size(const Type type) -> std::size_t
-{
-   switch (type) {
-   case Type::float_:
-   case Type::int_:
-   case Type::uint:
-   case Type::bool_:
-      return 4;
-   case Type::float2:
-   case Type::int2:
-   case Type::uint2:
-      return 8;
-   case Type::float3:
-   case Type::int3:
-   case Type::uint3:
-      return 12;
-   case Type::float4:
-   case Type::int4:
-   case Type::uint4:
-      return 16;
-   }
-
-   std::terminate();
-}
+using Type = Constant_buffer_layout::Type;
 
-struct Pack_result {
-   std::size_t offset = 0;
-   std::size_t size = 0;
-};
-
-auto pack_type(const Type type, const std::size_t size, const bool array_item) -> Pack_result
+auto to_type_name(const Type type) -> std::string_view
 {
-   const std::size_t alignment = 16;
-   const std::size_t aligned_size = next_multiple_of<alignment>(size);
-
-   if (array_item) {
-      return {.offset = aligned_size, .size = aligned_size + type_size(type)};
-   }
+   constexpr std::array<std::string_view, 13> names{"float"sv, "float2"sv, "float3"sv,
+                                                    "float4"sv, "int"sv,    "int2"sv,
+                                                    "int3"sv,   "int4"sv,   "uint"sv,
+                                                    "uint2"sv,  "uint3"sv,  "uint4"sv,
+                                                    "bool"sv};
 
-   if (is_multiple_of<alignment>(size)) {
-      return {.offset = size, .size = size + type_size(type)};
-   }
+   return names[static_cast<std::size_t>(type)];
+}
 
-   if ((aligned_size - size) >= type_size(type)) {
-      return {.offset = size, .size = size + type_size(type)};
-   }
+static_assert(std::variant_size_v<Constant_buffer_builder::value_type> ==
+              static_cast<std::size_t>(Type::bool_) + 1);
 
-   return {.offset = aligned_size, .size = aligned_size + type_size(type)};
 }
 
-auto parse_type(const std::string_view type_str) noexcept -> Type
+Constant_buffer_builder::Constant_buffer_builder(const std::string_view layout) noexcept
+   : Constant_buffer_builder{Constant_buffer_layout::compile(layout)}
 {
-   absl::flat_hash_map<std::string_view, Type> types =
-      {{"float"sv, Type::float_},  {"float1"sv, Type::float_},
-       {"float2"sv, Type::float2}, {"float3"sv, Type::float3},
-       {"float4"sv, Type::float4}, {"int"sv, Type::int_},
-       {"int1"sv, Type::int_},     {"int2"sv, Type::int2},
-       {"int3"sv, Type::int3},     {"int4"sv, Type::int4},
-       {"uint"sv, Type::uint},     {"uint1"sv, Type::uint},
-       {"uint2"sv, Type::uint2},   {"uint3"sv, Type::uint3},
-       {"uint4"sv, Type::uint4},   {"bool"sv, Type::bool_}};
-
-   auto type = types.find(type_str);
-
-   if (type == types.end()) {
-      log_and_terminate_fmt("Invalid type in constant buffer layout '{}'!"sv, type_str);
-   }
-
-   return type->second;
 }
 
-template<typename T>
-void parse_layout(const std::string_view layout, T&& callback) noexcept
+Constant_buffer_builder::Constant_buffer_builder(
+   std::shared_ptr<const Constant_buffer_layout> layout) noexcept
+   : _layout{std::move(layout)},
+     _backing_storage{_layout->defaults().begin(), _layout->defaults().end()}
 {
-   for (auto line : Lines_iterator{layout}) {
-      auto string = trim_whitespace(line.string);
-
-      if (string.empty()) continue;
-
-      string = split_string_on(string, "//"sv)[0];
-
-      if (string.empty()) continue;
-
-      auto [type_string, var_name] = split_string_on(string, " "sv);
-
-      type_string = trim_whitespace(type_string);
-      var_name = split_string_on(var_name, ";"sv)[0];
-      var_name = trim_whitespace(var_name);
-
-      if (type_string.empty() || var_name.empty()) {
-         log_and_terminate_fmt("Parse error on line #{} in constant buffer layout!"sv,
-                               line.number);
-      }
-
-      if (auto [array_var_name, size_str] = split_string_on(var_name, "["sv);
-          !size_str.empty()) {
-         size_str = split_string_on(size_str, "]"sv)[0];
-         size_str = trim_whitespace(size_str);
-
-         std::size_t size = 0;
+}
 
-         if (std::from_chars(size_str.data(), size_str.data() + size_str.size(), size)
-                .ec != std::errc{}) {
-            log_and_terminate_fmt("Parse error on line #{} in constant buffer layout! Unable to parse array size '{}'."sv,
-                                  line.number, size_str);
-         }
+void Constant_buffer_builder::set_at(const std::size_t field_index,
+                                     const value_type& value) noexcept
+{
+   const auto fields = _layout->fields();
 
-         for (std::size_t i = 0; i < size; ++i) {
-            callback(fmt::format("{}[{}]"sv, array_var_name, i),
-                     parse_type(type_string), true);
-         }
-      }
-      else {
-         callback(var_name, parse_type(type_string), false);
-      }
+   if (field_index >= fields.size()) {
+      log_and_terminate_fmt("Material constant buffer field index '{}' is out of range!"sv,
+                            field_index);
    }
-}
 
-}
+   if (_backing_storage.size() != _layout->size()) {
+      log_and_terminate("Attempt to set material constant buffer field after completion!"sv);
+   }
 
-Constant_buffer_builder::Constant_buffer_builder(const std::string_view layout) noexcept
-{
-   std::size_t size = 0;
-
-   parse_layout(layout, [&](const std::string_view, const Type type, const bool array_item) {
-      size = pack_type(type, size, array_item).size;
-   });
-
-   _backing_storage.resize(next_multiple_of<buffer_size_alignment>(size));
-
-   size = 0;
-
-   parse_layout(layout, [&](const std::string_view field, const Type type,
-                            const bool array_item) {
-      auto packed = pack_type(type, size, array_item);
-      size = packed.size;
-
-      switch (type) {
-      case Type::float_:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset]) float);
-         break;
-      case Type::float2:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset]) glm::vec2);
-         break;
-      case Type::float3:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset]) glm::vec3);
-         break;
-      case Type::float4:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset]) glm::vec4);
-         break;
-      case Type::int_:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset])
-                                          std::int32_t);
-         break;
-      case Type::int2:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset])
-                                          glm::ivec2);
-         break;
-      case Type::int3:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset])
-                                          glm::ivec3);
-         break;
-      case Type::int4:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset])
-                                          glm::ivec4);
-         break;
-      case Type::uint:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset])
-                                          std::uint32_t);
-         break;
-      case Type::uint2:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset])
-                                          glm::uvec2);
-         break;
-      case Type::uint3:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset])
-                                          glm::uvec3);
-         break;
-      case Type::uint4:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset])
-                                          glm::uvec4);
-         break;
-      case Type::bool_:
-         _field_mapping.emplace(field, new (&_backing_storage[packed.offset]) bool);
-         break;
-      }
-   });
-}
+   const auto& field = fields[field_index];
 
-void Constant_buffer_builder::set(const std::string_view field_name,
-                                  const value_type& value) noexcept
-{
-   if (auto field = _field_mapping.find(field_name); field != _field_mapping.end()) {
-      // clang-format off
+   if (static_cast<std::size_t>(field.type) != value.index()) {
       std::visit(
-         overloaded{
-            []<typename D, typename S, typename = std::enable_if_t<std::is_same_v<D, S>>>(
-               D* const dest, const S& src) { *dest = src; },
-            [&]<typename D, typename S,
-                typename = std::enable_if_t<!std::is_same_v<D, S>>>(D* const, const S&) {
-               log_and_terminate_fmt("Type mismatch (field type: {} arg type: {}) for material constant buffer field '{}'!"sv,
-                                     typeid(D).name(), typeid(S).name(), field_name);
-            },
+         [&]<typename S>(const S&) {
+            log_and_terminate_fmt("Type mismatch (field type: {} arg type: {}) for material constant buffer field '{}'!"sv,
+                                  to_type_name(field.type), typeid(S).name(),
+                                  field.name);
          },
-         field->second, value);
-   }
-   else {
-      log_and_terminate_fmt("Attempt to set nonexistent material constant buffer field '{}'!"sv,
-                            field_name);
+         value);
    }
+
+   std::visit(
+      [&]<typename S>(const S& src) {
+         std::memcpy(&_backing_storage[field.offset], &src, sizeof(S));
+      },
+      value);
 }
-// clang-format on
+
 }
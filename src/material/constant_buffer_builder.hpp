@@ -1,13 +1,15 @@
 #pragma once
 
+#include "constant_buffer_layout.hpp"
+
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <string_view>
-#include <type_traits>
 #include <variant>
 #include <vector>
 
-#include <absl/container/flat_hash_map.h>
 #include <glm/glm.hpp>
 
 namespace sp::material {
@@ -21,10 +23,13 @@ public:
                    bool // bool values
                    >;
 
-   constexpr static std::size_t buffer_size_alignment = 256;
+   constexpr static std::size_t buffer_size_alignment =
+      Constant_buffer_layout::buffer_size_alignment;
 
    explicit Constant_buffer_builder(const std::string_view layout) noexcept;
 
+   explicit Constant_buffer_builder(std::shared_ptr<const Constant_buffer_layout> layout) noexcept;
+
    void set_int(const std::string_view field_name, const std::int32_t value) noexcept
    {
       set(field_name, value);
@@ -35,24 +40,35 @@ public:
       set(field_name, value);
    }
 
-   void set(const std::string_view field_name, const value_type& value) noexcept;
+   void set(const std::string_view field_name, const value_type& value) noexcept
+   {
+      set_at(_layout->index_of(field_name), value);
+   }
 
-   auto complete() noexcept -> std::vector<std::byte>
+   void set_at(const std::size_t field_index, const value_type& value) noexcept;
+
+   void set_int_at(const std::size_t field_index, const std::int32_t value) noexcept
    {
-      _field_mapping.clear();
+      set_at(field_index, value);
+   }
 
-      return std::move(_backing_storage);
+   void set_uint_at(const std::size_t field_index, const std::uint32_t value) noexcept
+   {
+      set_at(field_index, value);
    }
 
-private:
-   template<typename... Args>
-   static auto value_ptr_type_helper(std::variant<Args...>)
-      -> std::variant<Args* const...>;
+   auto index_of(const std::string_view field_name) const noexcept -> std::size_t
+   {
+      return _layout->index_of(field_name);
+   }
 
-   using value_ptr_type = std::invoke_result_t<decltype(
-      []() { return value_ptr_type_helper(value_type{}); })>;
+   auto complete() noexcept -> std::vector<std::byte>
+   {
+      return std::move(_backing_storage);
+   }
 
-   absl::flat_hash_map<std::string, value_ptr_type> _field_mapping;
+private:
+   std::shared_ptr<const Constant_buffer_layout> _layout;
    std::vector<std::byte> _backing_storage;
 };
 
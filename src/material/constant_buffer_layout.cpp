@@ -0,0 +1,201 @@
+#include "constant_buffer_layout.hpp"
+#include "../logger.hpp"
+#include "string_utilities.hpp"
+
+#include <charconv>
+#include <mutex>
+
+#include <fmt/format.h>
+
+namespace sp::material {
+
+namespace {
+
+using Type = Constant_buffer_layout::Type;
+
+auto align_up(const std::size_t value, const std::size_t alignment) noexcept
+   -> std::size_t
+{
+   return (value + alignment - 1) / alignment * alignment;
+}
+
+auto type_size(const Type type) -> std::size_t
+{
+   switch (type) {
+   case Type::float_:
+   case Type::int_:
+   case Type::uint:
+   case Type::bool_:
+      return 4;
+   case Type::float2:
+   case Type::int2:
+   case Type::uint2:
+      return 8;
+   case Type::float3:
+   case Type::int3:
+   case Type::uint3:
+      return 12;
+   case Type::float4:
+   case Type::int4:
+   case Type::uint4:
+      return 16;
+   }
+
+   std::terminate();
+}
+
+struct Pack_result {
+   std::size_t offset = 0;
+   std::size_t size = 0;
+};
+
+auto pack_type(const Type type, const std::size_t size, const bool array_item) -> Pack_result
+{
+   const std::size_t alignment = 16;
+   const std::size_t aligned_size = align_up(size, alignment);
+
+   if (array_item) {
+      return {.offset = aligned_size, .size = aligned_size + type_size(type)};
+   }
+
+   if (size % alignment == 0) {
+      return {.offset = size, .size = size + type_size(type)};
+   }
+
+   if ((aligned_size - size) >= type_size(type)) {
+      return {.offset = size, .size = size + type_size(type)};
+   }
+
+   return {.offset = aligned_size, .size = aligned_size + type_size(type)};
+}
+
+auto parse_type(const std::string_view type_str) noexcept -> Type
+{
+   absl::flat_hash_map<std::string_view, Type> types =
+      {{"float"sv, Type::float_},  {"float1"sv, Type::float_},
+       {"float2"sv, Type::float2}, {"float3"sv, Type::float3},
+       {"float4"sv, Type::float4}, {"int"sv, Type::int_},
+       {"int1"sv, Type::int_},     {"int2"sv, Type::int2},
+       {"int3"sv, Type::int3},     {"int4"sv, Type::int4},
+       {"uint"sv, Type::uint},     {"uint1"sv, Type::uint},
+       {"uint2"sv, Type::uint2},   {"uint3"sv, Type::uint3},
+       {"uint4"sv, Type::uint4},   {"bool"sv, Type::bool_}};
+
+   auto type = types.find(type_str);
+
+   if (type == types.end()) {
+      log_and_terminate_fmt("Invalid type in constant buffer layout '{}'!"sv, type_str);
+   }
+
+   return type->second;
+}
+
+template<typename T>
+void parse_layout(const std::string_view layout, T&& callback) noexcept
+{
+   for (auto line : Lines_iterator{layout}) {
+      auto string = trim_whitespace(line.string);
+
+      if (string.empty()) continue;
+
+      string = split_string_on(string, "//"sv)[0];
+
+      if (string.empty()) continue;
+
+      auto [type_string, var_name] = split_string_on(string, " "sv);
+
+      type_string = trim_whitespace(type_string);
+      var_name = split_string_on(var_name, ";"sv)[0];
+      var_name = trim_whitespace(var_name);
+
+      if (type_string.empty() || var_name.empty()) {
+         log_and_terminate_fmt("Parse error on line #{} in constant buffer layout!"sv,
+                               line.number);
+      }
+
+      if (auto [array_var_name, size_str] = split_string_on(var_name, "["sv);
+          !size_str.empty()) {
+         size_str = split_string_on(size_str, "]"sv)[0];
+         size_str = trim_whitespace(size_str);
+
+         std::size_t size = 0;
+
+         if (std::from_chars(size_str.data(), size_str.data() + size_str.size(), size)
+                .ec != std::errc{}) {
+            log_and_terminate_fmt("Parse error on line #{} in constant buffer layout! Unable to parse array size '{}'."sv,
+                                  line.number, size_str);
+         }
+
+         for (std::size_t i = 0; i < size; ++i) {
+            callback(fmt::format("{}[{}]"sv, array_var_name, i),
+                     parse_type(type_string), true);
+         }
+      }
+      else {
+         callback(var_name, parse_type(type_string), false);
+      }
+   }
+}
+
+constexpr std::size_t max_constant_buffer_size = 65536;
+
+static_assert((Constant_buffer_layout::buffer_size_alignment &
+               (Constant_buffer_layout::buffer_size_alignment - 1)) == 0);
+
+}
+
+auto Constant_buffer_layout::compile(const std::string_view layout) noexcept
+   -> std::shared_ptr<const Constant_buffer_layout>
+{
+   // Material scripts create a builder from the same layout string every time
+   // they make a constant buffer, so only parse each layout once.
+   static std::mutex mutex;
+   static absl::flat_hash_map<std::string, std::shared_ptr<const Constant_buffer_layout>,
+                              Hash, std::equal_to<>>
+      cache;
+
+   std::scoped_lock lock{mutex};
+
+   if (auto it = cache.find(layout); it != cache.end()) return it->second;
+
+   return cache
+      .emplace(std::string{layout}, std::make_shared<const Constant_buffer_layout>(layout))
+      .first->second;
+}
+
+Constant_buffer_layout::Constant_buffer_layout(const std::string_view layout) noexcept
+{
+   std::size_t size = 0;
+
+   parse_layout(layout, [&](const std::string_view field, const Type type,
+                            const bool array_item) {
+      auto packed = pack_type(type, size, array_item);
+      size = packed.size;
+
+      _field_indices.emplace(field, static_cast<std::uint32_t>(_fields.size()));
+      _fields.push_back({.name = std::string{field},
+                         .type = type,
+                         .offset = static_cast<std::uint32_t>(packed.offset)});
+   });
+
+   const std::size_t buffer_size = align_up(size, buffer_size_alignment);
+
+   if (buffer_size > max_constant_buffer_size) {
+      log_and_terminate_fmt("Constant buffer layout is too large ({} bytes)!"sv, size);
+   }
+
+   _defaults.resize(buffer_size);
+}
+
+auto Constant_buffer_layout::index_of(const std::string_view field_name) const noexcept
+   -> std::size_t
+{
+   if (auto field = _field_indices.find(field_name); field != _field_indices.end()) {
+      return field->second;
+   }
+
+   log_and_terminate_fmt("Attempt to set nonexistent material constant buffer field '{}'!"sv,
+                         field_name);
+}
+
+}
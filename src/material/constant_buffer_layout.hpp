@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+
+namespace sp::material {
+
+// A constant buffer layout compiled once into a plan of field offsets and
+// types plus the default contents of the buffer. Plans are immutable and
+// shared, compile returns the same plan for the same layout string.
+class Constant_buffer_layout
+   : public std::enable_shared_from_this<Constant_buffer_layout> {
+public:
+   constexpr static std::size_t buffer_size_alignment = 256;
+
+   // Matches the order of the alternatives in Constant_buffer_builder::value_type.
+   enum class Type : std::uint8_t {
+      float_,
+      float2,
+      float3,
+      float4,
+      int_,
+      int2,
+      int3,
+      int4,
+      uint,
+      uint2,
+      uint3,
+      uint4,
+      bool_
+   };
+
+   struct Field {
+      std::string name;
+      Type type;
+      std::uint32_t offset;
+   };
+
+   static auto compile(const std::string_view layout) noexcept
+      -> std::shared_ptr<const Constant_buffer_layout>;
+
+   explicit Constant_buffer_layout(const std::string_view layout) noexcept;
+
+   // Returns the index of a field, terminates if there is no such field.
+   auto index_of(const std::string_view field_name) const noexcept -> std::size_t;
+
+   auto fields() const noexcept -> std::span<const Field>
+   {
+      return _fields;
+   }
+
+   auto defaults() const noexcept -> std::span<const std::byte>
+   {
+      return _defaults;
+   }
+
+   auto size() const noexcept -> std::size_t
+   {
+      return _defaults.size();
+   }
+
+private:
+   struct Hash {
+      using is_transparent = void;
+
+      auto operator()(const std::string_view name) const noexcept -> std::size_t
+      {
+         return absl::Hash<std::string_view>{}(name);
+      }
+   };
+
+   std::vector<Field> _fields;
+   absl::flat_hash_map<std::string, std::uint32_t, Hash, std::equal_to<>> _field_indices;
+   std::vector<std::byte> _defaults;
+};
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../shader/common.hpp"
+#include "../shader/state_names.hpp"
+
+#include <cstdint>
+#include <utility>
+
+namespace sp::material {
+
+struct Draw_key {
+   shader::State_name_id state_id{};
+   shader::Vertex_shader_flags vs_flags{};
+   std::uint16_t layout_index = 0;
+
+   bool operator==(const Draw_key&) const noexcept = default;
+};
+
+// Remembers what the last draw resolved to. Materials tend to be drawn several
+// times in a row with the same state, flags and layout so this lets the draw
+// skip all of its lookups.
+template<typename Resolved>
+class Draw_cache {
+public:
+   // Returns nullptr unless the last draw had the same key and was reusable.
+   auto find(const Draw_key& key) const noexcept -> const Resolved*
+   {
+      return _reusable && _key == key ? &_resolved : nullptr;
+   }
+
+   // Stores a draw's resolved state. Draws that aren't reusable (ones with
+   // shaders still compiling for instance) are resolved again next time.
+   auto store(const Draw_key& key, Resolved resolved, const bool reusable) noexcept
+      -> const Resolved&
+   {
+      _key = key;
+      _resolved = std::move(resolved);
+      _reusable = reusable;
+
+      return _resolved;
+   }
+
+   void invalidate() noexcept
+   {
+      _reusable = false;
+   }
+
+private:
+   Draw_key _key;
+   Resolved _resolved{};
+   bool _reusable = false;
+};
+
+}
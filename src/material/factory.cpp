@@ -8,6 +8,11 @@
 
 #include "../core/d3d11_helpers.hpp"
 
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <variant>
+
 #pragma warning(disable : 4702)
 #include <sol/sol.hpp>
 #pragma warning(default : 4702)
@@ -18,6 +23,9 @@ namespace sp::material {
 
 namespace {
 
+constexpr std::size_t max_cached_builds = 1024;
+constexpr std::size_t max_cached_constant_buffers = 4096;
+
 auto make_constant_buffer(ID3D11Device5& device, Material_type& material_type,
                           Properties_view properties_view,
                           Resource_info_views resource_info_views)
@@ -62,6 +70,92 @@ auto make_fail_safe_texture(const std::int32_t fail_safe_texture_index,
    return resources[fail_safe_texture_index];
 }
 
+template<typename T>
+void append_key_bytes(std::string& key, const T& value) noexcept
+{
+   static_assert(std::is_trivially_copyable_v<T>);
+
+   key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Canonical key for everything a material build depends on. Properties and
+// resource properties are sorted by name so materials that list them in a
+// different order still share a build.
+auto make_material_key(const material::Material& material) noexcept -> std::string
+{
+   std::string key = material.type;
+
+   key += '\0';
+
+   std::vector<const Material_property*> properties;
+   properties.reserve(material.properties.size());
+
+   for (const auto& prop : material.properties) properties.push_back(&prop);
+
+   std::ranges::stable_sort(properties, std::less{}, &Material_property::name);
+
+   for (const auto* prop : properties) {
+      key += prop->name;
+      key += '\0';
+      key += static_cast<char>(prop->value.index());
+
+      std::visit(
+         [&](const auto& var) {
+            append_key_bytes(key, var.value);
+            append_key_bytes(key, var.min);
+            append_key_bytes(key, var.max);
+         },
+         prop->value);
+   }
+
+   std::vector<const std::pair<const std::string, std::string>*> resource_properties;
+   resource_properties.reserve(material.resource_properties.size());
+
+   for (const auto& resource_prop : material.resource_properties) {
+      resource_properties.push_back(&resource_prop);
+   }
+
+   std::ranges::sort(resource_properties, std::less{},
+                     [](const auto* resource_prop) -> const std::string& {
+                        return resource_prop->first;
+                     });
+
+   for (const auto* resource_prop : resource_properties) {
+      key += '\1';
+      key += resource_prop->first;
+      key += '\0';
+      key += resource_prop->second;
+      key += '\0';
+   }
+
+   return key;
+}
+
+// The constant buffer can also depend on the dimensions of the material's
+// resources so those are part of its key as well.
+auto make_constant_buffer_key(const std::string& material_key,
+                              const Resource_info_views& resource_info_views,
+                              const std::size_t vs_resource_count,
+                              const std::size_t ps_resource_count) noexcept -> std::string
+{
+   std::string key = material_key;
+
+   key += '\2';
+   append_key_bytes(key, static_cast<std::uint32_t>(vs_resource_count));
+
+   for (std::size_t i = 0; i < vs_resource_count; ++i) {
+      append_key_bytes(key, resource_info_views.vs.get(i));
+   }
+
+   append_key_bytes(key, static_cast<std::uint32_t>(ps_resource_count));
+
+   for (std::size_t i = 0; i < ps_resource_count; ++i) {
+      append_key_bytes(key, resource_info_views.ps.get(i));
+   }
+
+   return key;
+}
+
 }
 
 struct Factory_lua_state {
@@ -117,26 +211,19 @@ void Factory::update_material(material::Material& material) noexcept
 {
    auto& material_type = _material_types.at(material.type);
 
-   Properties_view properties_view{material.properties};
+   const std::string key = make_material_key(material);
+   const Material_build& build = build_material(material, key);
 
    if (material_type->has_resources()) {
-      material.ps_shader_resources_names =
-         material_type->make_resources_vec(properties_view, material.resource_properties);
+      material.ps_shader_resources_names = build.ps_shader_resources_names;
    }
 
    if (material_type->has_vs_resources()) {
-      material.vs_shader_resources_names =
-         material_type->make_vs_resources_vec(properties_view,
-                                              material.resource_properties);
+      material.vs_shader_resources_names = build.vs_shader_resources_names;
    }
 
-   material.shader =
-      material_type->has_shader_flags()
-         ? _shader_factory.create(material.type,
-                                  material_type->get_shader_flags(properties_view))
-         : _shader_factory.create(material.type, {});
-
-   material.cb_bind = material_type->constant_buffer_bind();
+   material.shader = build.shader;
+   material.cb_bind = build.cb_bind;
 
    material.vs_shader_resources =
       make_resources(material.vs_shader_resources_names, _shader_resource_database);
@@ -144,20 +231,98 @@ void Factory::update_material(material::Material& material) noexcept
       make_resources(material.ps_shader_resources_names, _shader_resource_database);
 
    material.fail_safe_game_texture =
-      make_fail_safe_texture(material_type->fail_safe_texture_index(),
-                             material.ps_shader_resources);
-   material.want_depth_buffer_input = material_type->get_want_depth_buffer_input();
-   material.want_refraction_buffer_input =
-      material_type->get_want_refraction_buffer_input();
+      make_fail_safe_texture(build.fail_safe_texture_index, material.ps_shader_resources);
+   material.want_depth_buffer_input = build.want_depth_buffer_input;
+   material.want_refraction_buffer_input = build.want_refraction_buffer_input;
 
    if (material_type->has_constant_buffer()) {
       Resource_info_views resource_info_views{.vs = {material.vs_shader_resources},
                                               .ps = {material.ps_shader_resources}};
 
-      material.constant_buffer =
-         make_constant_buffer(*_device, *material_type, properties_view,
-                              resource_info_views);
+      const std::string cb_key =
+         make_constant_buffer_key(key, resource_info_views,
+                                  material.vs_shader_resources.size(),
+                                  material.ps_shader_resources.size());
+
+      if (auto it = _constant_buffer_cache.find(cb_key);
+          it != _constant_buffer_cache.end()) {
+         material.constant_buffer = it->second;
+      }
+      else {
+         // The editor rebuilds materials every frame while they're open, don't
+         // let the cache grow without bound from that.
+         if (_constant_buffer_cache.size() >= max_cached_constant_buffers) {
+            _constant_buffer_cache.clear();
+         }
+
+         material.constant_buffer =
+            make_constant_buffer(*_device, *material_type,
+                                 Properties_view{material.properties},
+                                 resource_info_views);
+
+         _constant_buffer_cache.emplace(cb_key, material.constant_buffer);
+      }
+   }
+}
+
+auto Factory::build_material(const material::Material& material,
+                             const std::string& key) -> const Material_build&
+{
+   if (auto it = _build_cache.find(key); it != _build_cache.end()) {
+      _cache_hits += 1;
+
+      return it->second;
+   }
+
+   _cache_misses += 1;
+
+   if (_build_cache.size() >= max_cached_builds) _build_cache.clear();
+
+   auto& material_type = _material_types.at(material.type);
+
+   Properties_view properties_view{material.properties};
+
+   Material_build build{.vs_shader_resources_names = material.vs_shader_resources_names,
+                        .ps_shader_resources_names = material.ps_shader_resources_names};
+
+   if (material_type->has_resources()) {
+      build.ps_shader_resources_names =
+         material_type->make_resources_vec(properties_view, material.resource_properties);
    }
+
+   if (material_type->has_vs_resources()) {
+      build.vs_shader_resources_names =
+         material_type->make_vs_resources_vec(properties_view,
+                                              material.resource_properties);
+   }
+
+   build.shader = material_type->has_shader_flags()
+                     ? _shader_factory.create(material.type,
+                                              material_type->get_shader_flags(
+                                                 properties_view))
+                     : _shader_factory.create(material.type, {});
+
+   build.cb_bind = material_type->constant_buffer_bind();
+   build.fail_safe_texture_index = material_type->fail_safe_texture_index();
+   build.want_depth_buffer_input = material_type->get_want_depth_buffer_input();
+   build.want_refraction_buffer_input =
+      material_type->get_want_refraction_buffer_input();
+
+   return _build_cache.emplace(key, std::move(build)).first->second;
+}
+
+auto Factory::cache_stats() const noexcept -> Cache_stats
+{
+   return {.build_entries = _build_cache.size(),
+           .constant_buffer_entries = _constant_buffer_cache.size(),
+           .hits = _cache_hits,
+           .misses = _cache_misses};
+}
+
+void Factory::clear_cache() noexcept
+{
+   _build_cache.clear();
+   _constant_buffer_cache.clear();
 }
 
 auto Factory::shader_resource_database() const noexcept -> core::Shader_resource_database&
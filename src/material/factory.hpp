@@ -6,6 +6,7 @@
 #include "patch_material_io.hpp"
 #include "shader_factory.hpp"
 
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <string>
@@ -36,13 +37,47 @@ public:
 
    auto shader_resource_database() const noexcept -> core::Shader_resource_database&;
 
+   struct Cache_stats {
+      std::size_t build_entries = 0;
+      std::size_t constant_buffer_entries = 0;
+      std::uint64_t hits = 0;
+      std::uint64_t misses = 0;
+   };
+
+   auto cache_stats() const noexcept -> Cache_stats;
+
+   // Drops every memoized material build. Materials already created keep
+   // whatever they were built with.
+   void clear_cache() noexcept;
+
 private:
+   // The parts of a material that depend only on its type, properties and
+   // resource properties. Identical materials share these, including the
+   // shader set.
+   struct Material_build {
+      Material::Resource_names vs_shader_resources_names;
+      Material::Resource_names ps_shader_resources_names;
+      std::shared_ptr<Shader_set> shader;
+      Constant_buffer_bind cb_bind;
+      std::int32_t fail_safe_texture_index;
+      bool want_depth_buffer_input;
+      bool want_refraction_buffer_input;
+   };
+
+   auto build_material(const material::Material& material, const std::string& key)
+      -> const Material_build&;
+
    Com_ptr<ID3D11Device5> _device;
    Shader_factory _shader_factory;
    core::Shader_resource_database& _shader_resource_database;
    std::unique_ptr<Factory_lua_state> _lua_state_owner;
 
    absl::flat_hash_map<std::string, std::unique_ptr<Material_type>> _material_types;
+
+   absl::flat_hash_map<std::string, Material_build> _build_cache;
+   absl::flat_hash_map<std::string, Com_ptr<ID3D11Buffer>> _constant_buffer_cache;
+   std::uint64_t _cache_hits = 0;
+   std::uint64_t _cache_misses = 0;
 };
 
 }
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "../logger.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace sp::material {
+
+// Owns the patch's materials. Materials created from identical data are shared
+// and reference counted, so a material munged into several levels (or
+// requested repeatedly by the game) is only ever built once. Removal is O(1).
+template<typename T>
+class Basic_material_registry {
+public:
+   // Returns the material previously created from identical data and adds a
+   // reference to it, or nullptr if there is no such material.
+   auto acquire(const std::span<const std::byte> material_data) noexcept -> T*
+   {
+      auto it = _by_data.find(make_key(material_data));
+
+      if (it == _by_data.end()) return nullptr;
+
+      _entries.at(it->second).ref_count += 1;
+      _reference_count += 1;
+
+      return it->second;
+   }
+
+   // Adds a newly created material with a single reference.
+   auto insert(const std::span<const std::byte> material_data,
+               std::unique_ptr<T> material) noexcept -> T*
+   {
+      auto* const pointer = material.get();
+      auto key = make_key(material_data);
+
+      if (_by_data.contains(key)) {
+         log_and_terminate("Attempt to register a material twice!"sv);
+      }
+
+      _by_data.emplace(key, pointer);
+      _entries.emplace(pointer, Entry{.index = _materials.size(),
+                                      .ref_count = 1,
+                                      .key = std::move(key)});
+      _materials.emplace_back(std::move(material));
+      _reference_count += 1;
+
+      return pointer;
+   }
+
+   // Drops a reference. When it was the last reference the material is
+   // removed from the registry and ownership of it is returned.
+   auto release(T* const material) noexcept -> std::unique_ptr<T>
+   {
+      auto it = _entries.find(material);
+
+      if (it == _entries.end()) {
+         log_and_terminate("Attempt to destroy nonexistant material!"sv);
+      }
+
+      _reference_count -= 1;
+
+      if (--it->second.ref_count != 0) return nullptr;
+
+      const std::size_t index = it->second.index;
+
+      _by_data.erase(it->second.key);
+      _entries.erase(it);
+
+      std::unique_ptr<T> owned = std::move(_materials[index]);
+
+      if (index != _materials.size() - 1) {
+         _materials[index] = std::move(_materials.back());
+         _entries.at(_materials[index].get()).index = index;
+      }
+
+      _materials.pop_back();
+
+      return owned;
+   }
+
+   auto materials() const noexcept -> const std::vector<std::unique_ptr<T>>&
+   {
+      return _materials;
+   }
+
+   bool empty() const noexcept
+   {
+      return _materials.empty();
+   }
+
+   // Count of references held across all materials.
+   auto reference_count() const noexcept -> std::size_t
+   {
+      return _reference_count;
+   }
+
+private:
+   struct Entry {
+      std::size_t index;
+      std::size_t ref_count;
+      std::string key;
+   };
+
+   static auto make_key(const std::span<const std::byte> material_data) noexcept
+      -> std::string
+   {
+      return {reinterpret_cast<const char*>(material_data.data()), material_data.size()};
+   }
+
+   std::vector<std::unique_ptr<T>> _materials;
+   absl::flat_hash_map<T*, Entry> _entries;
+   absl::flat_hash_map<std::string, T*> _by_data;
+   std::size_t _reference_count = 0;
+};
+
+struct Material;
+
+using Material_registry = Basic_material_registry<Material>;
+
+}
@@ -1,5 +1,8 @@
 
 #include "shader_factory.hpp"
+#include "../user_config.hpp"
+
+using namespace std::literals;
 
 namespace sp::material {
 
@@ -7,17 +10,25 @@ Shader_factory::Shader_factory(Com_ptr<ID3D11Device5> device,
                                shader::Rendertypes_database& shaders) noexcept
    : _device{std::move(device)}, _shaders{shaders}
 {
+   if (user_config.developer.record_shader_usage) {
+      _usage_profile = std::make_unique<Shader_usage_profile>(
+         user_config.developer.shader_cache_path.parent_path() / L"shader_usage"sv);
+   }
 }
 
 auto Shader_factory::create(std::string rendertype, Flags flags) noexcept
    -> std::shared_ptr<Shader_set>
 {
    if (auto it = _cache.find(std::tie(rendertype, flags)); it != _cache.end()) {
+      it->second->prewarm();
+
       return it->second;
    }
 
-   auto shader_set = std::make_shared<Shader_set>(_device, _shaders[rendertype],
-                                                  flags, rendertype);
+   auto shader_set = std::make_shared<Shader_set>(_device, _shaders[rendertype], flags,
+                                                  rendertype, _usage_profile.get());
+
+   shader_set->prewarm();
 
    return _cache
       .emplace(std::tuple{std::move(rendertype), std::move(flags)}, std::move(shader_set))
@@ -2,7 +2,9 @@
 
 #include "../shader/database.hpp"
 #include "shader_set.hpp"
+#include "shader_usage_profile.hpp"
 
+#include <memory>
 #include <tuple>
 
 #include <absl/container/flat_hash_map.h>
@@ -34,6 +36,8 @@ private:
    const Com_ptr<ID3D11Device5> _device;
    shader::Rendertypes_database& _shaders;
 
+   std::unique_ptr<Shader_usage_profile> _usage_profile;
+
    absl::flat_hash_map<std::tuple<std::string, Flags>, std::shared_ptr<Shader_set>, Hash, std::equal_to<>> _cache;
 };
 
@@ -3,7 +3,10 @@
 #include "../logger.hpp"
 #include "../user_config.hpp"
 
+#include <algorithm>
 #include <bitset>
+#include <optional>
+#include <utility>
 
 using namespace std::literals;
 
@@ -17,97 +20,244 @@ auto flags_to_bitstring(const Enum flags) -> std::string
    return std::bitset<32>{static_cast<unsigned long>(flags)}.to_string();
 }
 
+auto make_usage_key(const std::string& name, std::span<const std::string> extra_flags)
+   -> std::string
+{
+   std::string key = name;
+
+   if (extra_flags.empty()) return key;
+
+   key += '[';
+
+   for (bool first = true; const auto& flag : extra_flags) {
+      if (!std::exchange(first, false)) key += ',';
+
+      key += flag;
+   }
+
+   key += ']';
+
+   return key;
+}
+
 }
 
 Shader_set::Shader_set(Com_ptr<ID3D11Device1> device, shader::Rendertype& rendertype,
-                       std::span<const std::string> extra_flags, std::string name) noexcept
-   : _device{std::move(device)}, _shaders{init_shaders(rendertype, extra_flags)}, _name{std::move(name)}
+                       std::span<const std::string> extra_flags, std::string name,
+                       Shader_usage_profile* usage_profile) noexcept
+   : _device{std::move(device)},
+     _rendertype{rendertype},
+     _extra_flags{extra_flags.begin(), extra_flags.end()},
+     _states(rendertype.rendertypes().state_name_count()),
+     _name{std::move(name)},
+     _usage_profile{usage_profile},
+     _usage_key{make_usage_key(_name, extra_flags)}
 {
 }
 
 void Shader_set::update(ID3D11DeviceContext1& dc,
                         const core::Input_layout_descriptions& layout_descriptions,
-                        const std::uint16_t layout_index, const std::string& state_name,
+                        const std::uint16_t layout_index,
+                        const shader::State_name_id state_id,
                         const shader::Vertex_shader_flags vertex_shader_flags,
                         const bool oit_active) noexcept
 {
-   auto& state = get_state(state_name);
+   const Draw_key key{.state_id = state_id,
+                      .vs_flags = vertex_shader_flags,
+                      .layout_index = layout_index};
+
+   const Resolved_draw* draw = _last_draw.find(key);
 
-   auto& vs = state.get_vs(vertex_shader_flags, state_name, _name);
+   if (!draw) [[unlikely]] draw = &resolve_draw(layout_descriptions, key);
 
-   auto& input_layout =
-      vs.input_layouts.get(*_device, layout_descriptions, layout_index);
+   auto& state = *draw->state;
+   auto& vs = *draw->vs;
+
+   if (_usage_profile && vs.used_generation != _usage_profile->generation()) [[unlikely]] {
+      record_used(vs, state_id);
+   }
 
-   dc.IASetInputLayout(&input_layout);
+   dc.IASetInputLayout(draw->input_layout);
    dc.VSSetShader(vs.vs.get(), nullptr, 0);
 
    dc.PSSetShader((oit_active ? state.pixel_oit : state.pixel).get(), nullptr, 0);
 }
 
-auto Shader_set::Material_shader_state::get_vs(const shader::Vertex_shader_flags flags,
-                                               const std::string& state_name,
-                                               const std::string& shader_name) noexcept
-   -> Material_vertex_shader&
+void Shader_set::prewarm() noexcept
 {
-   if (auto shader = vertex.find(flags); shader != vertex.cend()) {
-      return shader->second;
+   if (!_usage_profile) return;
+
+   const auto generation = _usage_profile->generation();
+
+   if (std::exchange(_prewarmed_generation, generation) == generation) return;
+
+   for (const auto& [state_name, vs_flags] :
+        _usage_profile->prewarm_variants(_usage_key)) {
+      auto* const rendertype_state = _rendertype.find_state(state_name);
+
+      // Profiles can be stale, skip anything that no longer exists.
+      if (!rendertype_state || !rendertype_state->has_vertex_variation(vs_flags)) {
+         continue;
+      }
+
+      const auto state_id = *_rendertype.rendertypes().state_name_id(state_name);
+
+      auto& state = get_state(state_id);
+
+      if (std::ranges::find(state.vertex, vs_flags, &Material_vertex_shader::flags) ==
+          state.vertex.end()) {
+         create_vs(state, vs_flags, state_id);
+      }
+   }
+}
+
+auto Shader_set::resolve_draw(const core::Input_layout_descriptions& layout_descriptions,
+                              const Draw_key& key) noexcept -> const Resolved_draw&
+{
+   auto& state = get_state(key.state_id);
+
+   if (state.pending) [[unlikely]] {
+      state.pending = !try_resolve_pixel(state);
    }
 
-   log_and_terminate("Failed to find vertex shader for material shader '"sv,
-                     shader_name, "' with shader state '"sv, state_name,
-                     "'! vertex shader flags: ("sv, flags_to_bitstring(flags),
-                     ") '"sv, to_string(flags), "'"sv);
+   auto& vs = get_vs(state, key.vs_flags, key.state_id);
+
+   // Pending shaders get swapped out once they finish compiling, so keep
+   // coming back here until they have.
+   return _last_draw.store(key,
+                           {.state = &state,
+                            .vs = &vs,
+                            .input_layout = &vs.input_layouts->get(*_device,
+                                                                   layout_descriptions,
+                                                                   key.layout_index)},
+                           !state.pending && !vs.pending);
 }
 
-auto Shader_set::get_state(const std::string& state_name) noexcept
+auto Shader_set::get_state(const shader::State_name_id state_id) noexcept
    -> Material_shader_state&
 {
-   if (auto state = _shaders.find(state_name); state != _shaders.cend()) {
-      return state->second;
-   }
+   auto& state = _states[static_cast<std::size_t>(state_id)];
+
+   // Rendertype::state terminates for us if the state does not exist.
+   if (!state) state.emplace(create_state(_rendertype.state(state_id)));
 
-   log_and_terminate("Failed to find shader state '"sv, state_name,
-                     "' for material shader '"sv, _name, "'!"sv);
+   return *state;
 }
 
-auto Shader_set::init_shaders(shader::Rendertype& rendertype,
-                              std::span<const std::string> extra_flags) noexcept -> Shaders
+auto Shader_set::get_vs(Material_shader_state& state,
+                        const shader::Vertex_shader_flags flags,
+                        const shader::State_name_id state_id) noexcept
+   -> Material_vertex_shader&
 {
-   Shaders shaders;
+   if (auto shader = std::ranges::find(state.vertex, flags, &Material_vertex_shader::flags);
+       shader != state.vertex.end()) {
+      if (shader->pending) [[unlikely]] try_resolve_vs(state, *shader);
+
+      return *shader;
+   }
 
-   for (const auto& [name, state] : rendertype) {
-      shaders[name] = init_state(*state, extra_flags);
+   if (!state.rendertype_state->has_vertex_variation(flags)) {
+      log_and_terminate("Failed to find vertex shader for material shader '"sv,
+                        _name, "' with shader state '"sv, state_name(state_id),
+                        "'! vertex shader flags: ("sv, flags_to_bitstring(flags),
+                        ") '"sv, to_string(flags), "'"sv);
    }
 
-   return shaders;
+   return create_vs(state, flags, state_id);
 }
 
-auto Shader_set::init_state(shader::Rendertype_state& state,
-                            std::span<const std::string> extra_flags) noexcept
+auto Shader_set::create_state(shader::Rendertype_state& rendertype_state) noexcept
    -> Material_shader_state
 {
-   return {init_vs_entrypoint(state, extra_flags), state.pixel(extra_flags),
-           state.pixel_oit(extra_flags)};
+   Material_shader_state state{.rendertype_state = &rendertype_state,
+                               .extra_static_flags =
+                                  rendertype_state.extra_static_flags(_extra_flags)};
+
+   if (_extra_flags.empty()) {
+      state.pixel = rendertype_state.pixel();
+      state.pixel_oit = rendertype_state.pixel_oit();
+   }
+   else if (!try_resolve_pixel(state)) {
+      state.pixel = rendertype_state.pixel();
+      state.pixel_oit = rendertype_state.pixel_oit();
+      state.pending = true;
+   }
+
+   return state;
+}
+
+auto Shader_set::create_vs(Material_shader_state& state,
+                           const shader::Vertex_shader_flags flags,
+                           const shader::State_name_id state_id) noexcept
+   -> Material_vertex_shader&
+{
+   auto& rendertype_state = *state.rendertype_state;
+
+   auto variant =
+      _extra_flags.empty()
+         ? std::nullopt
+         : rendertype_state.vertex_async(flags, state.extra_static_flags);
+   const bool pending = !_extra_flags.empty() && !variant;
+
+   if (!variant) variant = rendertype_state.vertex(flags);
+
+   auto& [shader, bytecode, input_layout] = *variant;
+
+   if (_usage_profile) {
+      _usage_profile->record_created(_usage_key, state_name(state_id), flags);
+   }
+
+   // Growing the state's variants can move the one the last draw pointed at.
+   _last_draw.invalidate();
+
+   auto& vs = state.vertex.emplace_back(
+      Material_vertex_shader{.flags = flags, .vs = std::move(shader), .pending = pending});
+
+   vs.input_layouts.emplace(std::move(input_layout), std::move(bytecode));
+
+   return vs;
+}
+
+bool Shader_set::try_resolve_pixel(Material_shader_state& state) noexcept
+{
+   auto pixel = state.rendertype_state->pixel_async(state.extra_static_flags);
+   auto pixel_oit = state.rendertype_state->pixel_oit_async(state.extra_static_flags);
+
+   if (!pixel || !pixel_oit) return false;
+
+   state.pixel = std::move(*pixel);
+   state.pixel_oit = std::move(*pixel_oit);
+
+   return true;
+}
+
+void Shader_set::try_resolve_vs(Material_shader_state& state,
+                                Material_vertex_shader& vs) noexcept
+{
+   auto variant = state.rendertype_state->vertex_async(vs.flags, state.extra_static_flags);
+
+   if (!variant) return;
+
+   auto& [shader, bytecode, input_layout] = *variant;
+
+   // The input layouts were created against the stand in's bytecode.
+   vs.vs = std::move(shader);
+   vs.input_layouts.emplace(std::move(input_layout), std::move(bytecode));
+   vs.pending = false;
+}
+
+void Shader_set::record_used(Material_vertex_shader& vs,
+                             const shader::State_name_id state_id) noexcept
+{
+   vs.used_generation = _usage_profile->generation();
+
+   _usage_profile->record_used(_usage_key, state_name(state_id), vs.flags);
 }
 
-auto Shader_set::init_vs_entrypoint(shader::Rendertype_state& state,
-                                    std::span<const std::string> extra_flags) noexcept
-   -> absl::flat_hash_map<shader::Vertex_shader_flags, Material_vertex_shader>
+auto Shader_set::state_name(const shader::State_name_id state_id) const noexcept
+   -> const std::string&
 {
-   absl::flat_hash_map<shader::Vertex_shader_flags, Material_vertex_shader> shaders;
-
-   state.vertex_copy_all(
-      [&](shader::Vertex_shader_flags flags, Com_ptr<ID3D11VertexShader> shader,
-          sp::shader::Bytecode_blob bytecode,
-          sp::shader::Vertex_input_layout input_sig) noexcept {
-         shaders.emplace(flags,
-                         Material_vertex_shader{.vs = std::move(shader),
-                                                .input_layouts = {std::move(input_sig),
-                                                                  std::move(bytecode)}});
-      },
-      extra_flags);
-
-   return shaders;
+   return _rendertype.rendertypes().state_name(state_id);
 }
 
 }
@@ -4,8 +4,16 @@
 #include "../core/shader_input_layouts.hpp"
 #include "../shader/database.hpp"
 #include "com_ptr.hpp"
+#include "draw_cache.hpp"
+#include "shader_usage_profile.hpp"
 
-#include <absl/container/flat_hash_map.h>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <absl/container/inlined_vector.h>
 
 #include <d3d11_1.h>
 
@@ -14,51 +22,97 @@ namespace sp::material {
 class Shader_set {
 public:
    Shader_set(Com_ptr<ID3D11Device1> device, shader::Rendertype& rendertype,
-              std::span<const std::string> extra_flags, std::string name) noexcept;
+              std::span<const std::string> extra_flags, std::string name,
+              Shader_usage_profile* usage_profile) noexcept;
 
    void update(ID3D11DeviceContext1& dc,
                const core::Input_layout_descriptions& layout_descriptions,
-               const std::uint16_t layout_index, const std::string& state_name,
+               const std::uint16_t layout_index, const shader::State_name_id state_id,
                const shader::Vertex_shader_flags vertex_shader_flags,
                const bool oit_active) noexcept;
 
+   // Creates the variants the usage profile recorded as used the last time the
+   // current map was played. Does nothing if it has already been done for the
+   // current map or if there is no usage profile.
+   void prewarm() noexcept;
+
 private:
    struct Material_vertex_shader {
+      shader::Vertex_shader_flags flags;
+
       Com_ptr<ID3D11VertexShader> vs;
 
-      core::Shader_input_layouts input_layouts;
+      // Only ever empty while being replaced, Shader_input_layouts can not be
+      // assigned to.
+      std::optional<core::Shader_input_layouts> input_layouts;
+
+      // Set while the variant is being compiled in the background and the
+      // state's plain rendertype shader is standing in for it.
+      bool pending = false;
+
+      std::uint32_t used_generation = Shader_usage_profile::no_generation;
    };
 
    struct Material_shader_state {
-      absl::flat_hash_map<shader::Vertex_shader_flags, Material_vertex_shader> vertex;
+      shader::Rendertype_state* rendertype_state = nullptr;
+
+      // The set's extra flags resolved against the state's entrypoints.
+      shader::Rendertype_state::Extra_static_flags extra_static_flags;
+
+      // A state has at most four vertex shader variations.
+      absl::InlinedVector<Material_vertex_shader, 4> vertex;
       Com_ptr<ID3D11PixelShader> pixel;
       Com_ptr<ID3D11PixelShader> pixel_oit;
 
-      auto get_vs(const shader::Vertex_shader_flags flags,
-                  const std::string& state_name, const std::string& shader_name) noexcept
-         -> Material_vertex_shader&;
+      // Set while the state's pixel shaders are being compiled in the
+      // background and the state's plain rendertype shaders are standing in
+      // for them.
+      bool pending = false;
+   };
+
+   struct Resolved_draw {
+      Material_shader_state* state = nullptr;
+      Material_vertex_shader* vs = nullptr;
+      ID3D11InputLayout* input_layout = nullptr;
    };
 
-   using Shaders = absl::flat_hash_map<std::string, Material_shader_state>;
+   auto resolve_draw(const core::Input_layout_descriptions& layout_descriptions,
+                     const Draw_key& key) noexcept -> const Resolved_draw&;
 
-   auto get_state(const std::string& state_name) noexcept -> Material_shader_state&;
+   auto get_state(const shader::State_name_id state_id) noexcept
+      -> Material_shader_state&;
 
-   static auto init_shaders(shader::Rendertype& rendertype,
-                            std::span<const std::string> extra_flags) noexcept
-      -> Shaders;
+   auto get_vs(Material_shader_state& state, const shader::Vertex_shader_flags flags,
+               const shader::State_name_id state_id) noexcept -> Material_vertex_shader&;
 
-   static auto init_state(shader::Rendertype_state& state,
-                          std::span<const std::string> extra_flags) noexcept
+   auto create_state(shader::Rendertype_state& rendertype_state) noexcept
       -> Material_shader_state;
 
-   static auto init_vs_entrypoint(shader::Rendertype_state& state,
-                                  std::span<const std::string> extra_flags) noexcept
-      -> absl::flat_hash_map<shader::Vertex_shader_flags, Material_vertex_shader>;
+   auto create_vs(Material_shader_state& state, const shader::Vertex_shader_flags flags,
+                  const shader::State_name_id state_id) noexcept
+      -> Material_vertex_shader&;
+
+   bool try_resolve_pixel(Material_shader_state& state) noexcept;
+
+   void try_resolve_vs(Material_shader_state& state, Material_vertex_shader& vs) noexcept;
+
+   void record_used(Material_vertex_shader& vs, const shader::State_name_id state_id) noexcept;
+
+   auto state_name(const shader::State_name_id state_id) const noexcept
+      -> const std::string&;
 
    const Com_ptr<ID3D11Device1> _device;
 
-   Shaders _shaders;
+   shader::Rendertype& _rendertype;
+   const std::vector<std::string> _extra_flags;
+
+   // Indexed by shader::State_name_id, empty until the state is first used.
+   std::vector<std::optional<Material_shader_state>> _states;
+   Draw_cache<Resolved_draw> _last_draw;
    std::string _name;
-};
 
+   Shader_usage_profile* const _usage_profile = nullptr;
+   std::string _usage_key;
+   std::uint32_t _prewarmed_generation = Shader_usage_profile::no_generation;
+};
 }
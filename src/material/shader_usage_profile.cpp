@@ -0,0 +1,226 @@
+
+#include "shader_usage_profile.hpp"
+#include "../logger.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <string_view>
+#include <tuple>
+
+using namespace std::literals;
+
+namespace sp::material {
+
+namespace {
+
+auto split_profile_line(const std::string_view line) noexcept
+   -> std::optional<std::tuple<std::string_view, std::string_view, shader::Vertex_shader_flags>>
+{
+   const auto first_tab = line.find('\t');
+
+   if (first_tab == line.npos) return std::nullopt;
+
+   const auto second_tab = line.find('\t', first_tab + 1);
+
+   if (second_tab == line.npos) return std::nullopt;
+
+   const auto flags_str = line.substr(second_tab + 1);
+
+   std::uint32_t flags = 0;
+
+   if (std::from_chars(flags_str.data(), flags_str.data() + flags_str.size(), flags)
+          .ec != std::errc{}) {
+      return std::nullopt;
+   }
+
+   return std::tuple{line.substr(0, first_tab),
+                     line.substr(first_tab + 1, second_tab - first_tab - 1),
+                     static_cast<shader::Vertex_shader_flags>(flags)};
+}
+
+}
+
+Shader_usage_profile::Shader_usage_profile(std::filesystem::path directory) noexcept
+   : _directory{std::move(directory)}
+{
+   std::error_code ec;
+
+   std::filesystem::create_directories(_directory, ec);
+
+   if (ec) {
+      log(Log_level::warning, "Failed to create shader usage profile directory "sv,
+          _directory, " reason: "sv, ec.message());
+   }
+}
+
+Shader_usage_profile::~Shader_usage_profile()
+{
+   if (_map_name.empty()) return;
+
+   save_profile();
+   save_report();
+}
+
+auto Shader_usage_profile::prewarm_variants(const std::string& shader_set) noexcept
+   -> std::span<const Variant>
+{
+   if (auto it = _prewarm.find(shader_set); it != _prewarm.end()) {
+      return it->second;
+   }
+
+   return {};
+}
+
+void Shader_usage_profile::record_created(const std::string& shader_set,
+                                          const std::string& state,
+                                          const shader::Vertex_shader_flags vs_flags) noexcept
+{
+   _created[shader_set].insert(Variant{state, vs_flags});
+}
+
+void Shader_usage_profile::record_used(const std::string& shader_set,
+                                       const std::string& state,
+                                       const shader::Vertex_shader_flags vs_flags) noexcept
+{
+   _used[shader_set].insert(Variant{state, vs_flags});
+}
+
+void Shader_usage_profile::switch_map(const std::uint32_t map_generation) noexcept
+{
+   if (!_map_name.empty()) {
+      save_profile();
+      save_report();
+   }
+
+   _generation = map_generation;
+   _map_name = game_support::current_map();
+   _prewarm.clear();
+   _created.clear();
+   _used.clear();
+
+   if (!_map_name.empty()) load_profile();
+}
+
+void Shader_usage_profile::load_profile() noexcept
+{
+   std::ifstream file{profile_path()};
+
+   if (!file) return;
+
+   std::size_t variant_count = 0;
+
+   for (std::string line; std::getline(file, line);) {
+      const auto split = split_profile_line(line);
+
+      if (!split) {
+         log(Log_level::warning, "Ignoring malformed line in shader usage profile for "sv,
+             std::quoted(_map_name));
+
+         continue;
+      }
+
+      const auto& [shader_set, state, vs_flags] = *split;
+
+      _prewarm[std::string{shader_set}].push_back(Variant{std::string{state}, vs_flags});
+
+      variant_count += 1;
+   }
+
+   log(Log_level::info, "Loaded shader usage profile for "sv, std::quoted(_map_name),
+       " with "sv, variant_count, " variants."sv);
+}
+
+void Shader_usage_profile::save_profile() const noexcept
+{
+   if (_used.empty()) return;
+
+   std::ofstream file{profile_path()};
+
+   if (!file) {
+      log(Log_level::warning, "Failed to save shader usage profile for "sv,
+          std::quoted(_map_name));
+
+      return;
+   }
+
+   for (const auto& [shader_set, variants] : _used) {
+      for (const auto& variant : variants) {
+         file << shader_set << '\t' << variant.state << '\t'
+              << static_cast<std::uint32_t>(variant.vs_flags) << '\n';
+      }
+   }
+}
+
+void Shader_usage_profile::save_report() const noexcept
+{
+   if (_created.empty() && _used.empty()) return;
+
+   std::vector<std::tuple<std::string_view, std::string_view, shader::Vertex_shader_flags, bool, bool>>
+      rows;
+
+   std::size_t created_count = 0;
+   std::size_t used_count = 0;
+   std::size_t created_unused_count = 0;
+
+   for (const auto& [shader_set, variants] : _created) {
+      const auto used = _used.find(shader_set);
+
+      for (const auto& variant : variants) {
+         const bool was_used = used != _used.end() && used->second.contains(variant);
+
+         rows.emplace_back(shader_set, variant.state, variant.vs_flags, true, was_used);
+
+         created_count += 1;
+         created_unused_count += !was_used;
+      }
+   }
+
+   for (const auto& [shader_set, variants] : _used) {
+      const auto created = _created.find(shader_set);
+
+      for (const auto& variant : variants) {
+         used_count += 1;
+
+         // Variants created while playing an earlier map that got carried over.
+         if (created == _created.end() || !created->second.contains(variant)) {
+            rows.emplace_back(shader_set, variant.state, variant.vs_flags, false, true);
+         }
+      }
+   }
+
+   std::ranges::sort(rows);
+
+   std::ofstream file{report_path()};
+
+   if (!file) {
+      log(Log_level::warning, "Failed to save shader usage report for "sv,
+          std::quoted(_map_name));
+
+      return;
+   }
+
+   file << "Shader usage report for "sv << _map_name << '\n'
+        << "Created: "sv << created_count << '\n'
+        << "Used: "sv << used_count << '\n'
+        << "Created but never used: "sv << created_unused_count << "\n\n"sv;
+
+   for (const auto& [shader_set, state, vs_flags, created, used] : rows) {
+      file << (created ? "created "sv : "        "sv) << (used ? "used   "sv : "unused "sv)
+           << shader_set << ' ' << state << " ("sv << to_string(vs_flags) << ")\n"sv;
+   }
+}
+
+auto Shader_usage_profile::profile_path() const noexcept -> std::filesystem::path
+{
+   return _directory / (_map_name + ".usage"s);
+}
+
+auto Shader_usage_profile::report_path() const noexcept -> std::filesystem::path
+{
+   return _directory / (_map_name + "_report.txt"s);
+}
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../game_support/current_map.hpp"
+#include "../shader/common.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+namespace sp::material {
+
+// Records which material shader variants get created and drawn with on each
+// map. When a map is left the variants that were drawn are saved as that
+// map's profile, along with a report comparing them against the variants that
+// were created. The next time the map is loaded the profile is used to create
+// the variants ahead of their first draw.
+class Shader_usage_profile {
+public:
+   struct Variant {
+      std::string state;
+      shader::Vertex_shader_flags vs_flags;
+
+      template<typename H>
+      friend H AbslHashValue(H h, const Variant& variant)
+      {
+         return H::combine(std::move(h), variant.state, variant.vs_flags);
+      }
+
+      bool operator==(const Variant&) const noexcept = default;
+   };
+
+   constexpr static std::uint32_t no_generation = 0xffffffffu;
+
+   explicit Shader_usage_profile(std::filesystem::path directory) noexcept;
+
+   ~Shader_usage_profile();
+
+   Shader_usage_profile(const Shader_usage_profile&) = delete;
+   auto operator=(const Shader_usage_profile&) -> Shader_usage_profile& = delete;
+
+   Shader_usage_profile(Shader_usage_profile&&) = delete;
+   auto operator=(Shader_usage_profile&&) -> Shader_usage_profile& = delete;
+
+   // Returns the generation of the current map, switching over to the new
+   // map's profile first if it has changed.
+   auto generation() noexcept -> std::uint32_t
+   {
+      if (const auto map_generation = game_support::current_map_generation();
+          map_generation != _generation) [[unlikely]] {
+         switch_map(map_generation);
+      }
+
+      return _generation;
+   }
+
+   auto prewarm_variants(const std::string& shader_set) noexcept
+      -> std::span<const Variant>;
+
+   void record_created(const std::string& shader_set, const std::string& state,
+                       const shader::Vertex_shader_flags vs_flags) noexcept;
+
+   void record_used(const std::string& shader_set, const std::string& state,
+                    const shader::Vertex_shader_flags vs_flags) noexcept;
+
+private:
+   using Variants = absl::flat_hash_map<std::string, absl::flat_hash_set<Variant>>;
+
+   void switch_map(const std::uint32_t map_generation) noexcept;
+
+   void load_profile() noexcept;
+
+   void save_profile() const noexcept;
+
+   void save_report() const noexcept;
+
+   auto profile_path() const noexcept -> std::filesystem::path;
+
+   auto report_path() const noexcept -> std::filesystem::path;
+
+   const std::filesystem::path _directory;
+
+   std::uint32_t _generation = no_generation;
+   std::string _map_name;
+
+   absl::flat_hash_map<std::string, std::vector<Variant>> _prewarm;
+   Variants _created;
+   Variants _used;
+};
+
+}
@@ -83,15 +83,56 @@ void add_vec_types(sol::state& lua) noexcept
    create_vec_type<glm::uvec4>(lua, "uint4");
 }
 
+void add_constant_buffer_layout(sol::state& lua) noexcept
+{
+   auto constant_buffer_layout =
+      lua.new_usertype<Constant_buffer_layout>("constant_buffer_layout",
+                                               sol::no_constructor);
+
+   // Compiled layouts are cached for the life of the process so scripts can
+   // safely hold onto a reference.
+   constant_buffer_layout["compile"sv] =
+      [](const std::string_view layout) noexcept -> const Constant_buffer_layout& {
+      return *Constant_buffer_layout::compile(layout);
+   };
+
+   constant_buffer_layout["index_of"sv] = &Constant_buffer_layout::index_of;
+
+   // Returns a table of field name to field index for use with set_at.
+   constant_buffer_layout["field_indices"sv] =
+      [](const Constant_buffer_layout& layout, sol::this_state state) noexcept {
+         const auto fields = layout.fields();
+
+         sol::table indices =
+            sol::state_view{state}.create_table(0, static_cast<int>(fields.size()));
+
+         for (std::size_t i = 0; i < fields.size(); ++i) {
+            indices[fields[i].name] = i;
+         }
+
+         return indices;
+      };
+}
+
 void add_constant_buffer_builder(sol::state& lua) noexcept
 {
    auto constant_buffer_builder = lua.new_usertype<Constant_buffer_builder>(
       "constant_buffer_builder",
-      sol::constructors<Constant_buffer_builder(std::string_view)>());
+      sol::factories(
+         [](const std::string_view layout) noexcept {
+            return Constant_buffer_builder{layout};
+         },
+         [](const Constant_buffer_layout& layout) noexcept {
+            return Constant_buffer_builder{layout.shared_from_this()};
+         }));
 
    constant_buffer_builder["set"sv] = &Constant_buffer_builder::set;
    constant_buffer_builder["set_int"sv] = &Constant_buffer_builder::set_int;
    constant_buffer_builder["set_uint"sv] = &Constant_buffer_builder::set_uint;
+   constant_buffer_builder["set_at"sv] = &Constant_buffer_builder::set_at;
+   constant_buffer_builder["set_int_at"sv] = &Constant_buffer_builder::set_int_at;
+   constant_buffer_builder["set_uint_at"sv] = &Constant_buffer_builder::set_uint_at;
+   constant_buffer_builder["index_of"sv] = &Constant_buffer_builder::index_of;
    constant_buffer_builder["complete"sv] = &Constant_buffer_builder::complete;
 }
 
@@ -209,6 +250,7 @@ void add_math(sol::state& lua) noexcept
 void sol_create_usertypes(sol::state& lua) noexcept
 {
    add_vec_types(lua);
+   add_constant_buffer_layout(lua);
    add_constant_buffer_builder(lua);
    add_prop_makers(lua);
    add_properties_view(lua);
@@ -1,12 +1,8 @@
 #pragma once
 
-#include "com_ptr.hpp"
-
 #include <cstddef>
 #include <memory>
 
-#include <d3dcommon.h>
-
 namespace sp::shader {
 
 class Bytecode_blob {
@@ -19,14 +15,10 @@ public:
       _size = size;
    }
 
-   explicit Bytecode_blob(Com_ptr<ID3DBlob> blob)
+   // Shares ownership of data, which can alias whatever owns the bytecode.
+   Bytecode_blob(std::shared_ptr<std::byte[]> data, const std::size_t size) noexcept
+      : _data{std::move(data)}, _size{size}
    {
-      if (!blob) return;
-
-      _data = {std::shared_ptr<ID3DBlob>{blob.unmanaged_copy(),
-                                         [](ID3DBlob* blob) { blob->Release(); }},
-               static_cast<std::byte*>(blob->GetBufferPointer())};
-      _size = blob->GetBufferSize();
    }
 
    auto data() noexcept -> std::byte*
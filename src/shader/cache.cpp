@@ -1,11 +1,16 @@
 #include "cache.hpp"
 #include "../logger.hpp"
 #include "binary_io_winapi.hpp"
+#include "magic_number.hpp"
+#include "memory_mapped_file.hpp"
 #include "shader_patch_version.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
 #include <ranges>
 #include <span>
+#include <stdexcept>
 #include <vector>
 
 using namespace std::literals;
@@ -13,7 +18,203 @@ using std::filesystem::file_time_type;
 
 namespace sp::shader {
 
+namespace {
+
+constexpr auto journal_record_magic = "JREC"_mn;
+
+// Every journal record starts with one of these. The checksum covers the
+// record's payload so a record torn by a crash mid-write can be detected.
+struct Journal_record_header {
+   Magic_number magic;
+   std::uint32_t checksum;
+   std::uint64_t size;
+};
+
+static_assert(sizeof(Journal_record_header) == 16);
+
+auto checksum(const std::span<const std::byte> bytes) noexcept -> std::uint32_t
+{
+   constexpr std::uint32_t FNV_prime = 16777619;
+   constexpr std::uint32_t offset_basis = 2166136261;
+
+   std::uint32_t hash = offset_basis;
+
+   for (auto b : bytes) {
+      hash ^= static_cast<std::uint32_t>(b);
+      hash *= FNV_prime;
+   }
+
+   return hash;
+}
+
+class Record_serializer {
+public:
+   template<Binary_io_trivial T>
+   void write(const T& value) noexcept
+   {
+      const auto offset = _bytes.size();
+
+      _bytes.resize(offset + sizeof(T));
+
+      std::memcpy(_bytes.data() + offset, &value, sizeof(T));
+   }
+
+   void write(const std::span<const std::byte> bytes) noexcept
+   {
+      _bytes.insert(_bytes.end(), bytes.begin(), bytes.end());
+   }
+
+   void write(const std::string_view str) noexcept
+   {
+      write(str.size());
+      write(std::as_bytes(std::span{str}));
+   }
+
+   auto bytes() const noexcept -> const std::vector<std::byte>&
+   {
+      return _bytes;
+   }
+
+private:
+   std::vector<std::byte> _bytes;
+};
+
+class Record_deserializer {
+public:
+   explicit Record_deserializer(const std::span<const std::byte> bytes) noexcept
+      : _bytes{bytes}
+   {
+   }
+
+   template<Binary_io_trivial T>
+   auto read() -> T
+   {
+      T value;
+
+      std::memcpy(&value, read_bytes(sizeof(T)).data(), sizeof(T));
+
+      return value;
+   }
+
+   auto read_bytes(const std::size_t size) -> std::span<const std::byte>
+   {
+      if (size > _bytes.size()) {
+         throw std::runtime_error{"unexpected end of journal record"};
+      }
+
+      auto bytes = _bytes.first(size);
+
+      _bytes = _bytes.subspan(size);
+
+      return bytes;
+   }
+
+   auto read_string() -> std::string
+   {
+      const auto bytes = read_bytes(read<std::size_t>());
+
+      return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+   }
+
+   auto remaining() const noexcept -> std::size_t
+   {
+      return _bytes.size();
+   }
+
+private:
+   std::span<const std::byte> _bytes;
+};
+
+auto serialize_record(const Cache_record& record) noexcept -> Record_serializer
+{
+   Record_serializer payload;
+
+   payload.write(record.stage);
+   payload.write(record.group);
+   payload.write(record.entrypoint);
+   payload.write(record.static_flags);
+   payload.write(record.game_flags);
+   payload.write(record.bytecode.size());
+   payload.write(std::span{record.bytecode.data(), record.bytecode.size()});
+
+   return payload;
+}
+
+auto deserialize_record(const std::span<const std::byte> bytes) -> Cache_record
+{
+   Record_deserializer payload{bytes};
+
+   Cache_record record;
+
+   record.stage = payload.read<Stage>();
+   record.group = payload.read_string();
+   record.entrypoint = payload.read_string();
+   record.static_flags = payload.read<std::uint64_t>();
+   record.game_flags = payload.read<Vertex_shader_flags>();
+
+   const auto bytecode = payload.read_bytes(payload.read<std::size_t>());
+
+   record.bytecode = Bytecode_blob{bytecode.size()};
+
+   std::ranges::copy(bytecode, record.bytecode.begin());
+
+   if (payload.remaining() != 0) {
+      throw std::runtime_error{"unexpected trailing data in journal record"};
+   }
+
+   return record;
+}
+
+void write_journal_header(Binary_writer& journal)
+{
+   journal.write(current_shader_patch_version.major, current_shader_patch_version.minor,
+                 current_shader_patch_version.patch,
+                 current_shader_patch_version.prerelease_stage,
+                 current_shader_patch_version.prerelease);
+}
+
+void write_journal_record(Binary_writer& journal, const Cache_record& record)
+{
+   const auto payload = serialize_record(record);
+
+   Record_serializer record_bytes;
+
+   record_bytes.write(Journal_record_header{.magic = journal_record_magic,
+                                            .checksum = checksum(payload.bytes()),
+                                            .size = payload.bytes().size()});
+   record_bytes.write(payload.bytes());
+
+   // One write per record, so the only way to get a partial record is a crash
+   // mid-write.
+   journal.write(record_bytes.bytes());
+}
+
+template<typename T>
+auto create_shader_from_record(ID3D11Device5& device, const Cache_record& record,
+                               auto create) -> Com_ptr<T>
+{
+   Com_ptr<T> shader;
+
+   if (const auto result = std::invoke(create, device, record.bytecode.data(),
+                                       record.bytecode.size(), nullptr,
+                                       shader.clear_and_assign());
+       FAILED(result)) {
+      log_debug("Failed to create shader from cached bytecode {}:{}({:x})"sv,
+                record.group, record.entrypoint, record.static_flags);
+
+      return nullptr;
+   }
+
+   log_debug("Loaded and created cached shader {}:{}({:x})"sv, record.group,
+             record.entrypoint, record.static_flags);
+
+   return shader;
+}
+
+}
+
 Cache::Cache(ID3D11Device5& device, const std::filesystem::path& cache_path) noexcept
+   : _journal_path{std::filesystem::path{cache_path} += L".journal"sv}
 {
    load_from_file(device, cache_path);
 }
@@ -22,7 +223,7 @@ void Cache::clear_stale_entries(const Source_file_dependency_index& dependency_i
                                 const Source_file_store& file_store,
                                 const std::span<const Group_definition> groups) noexcept
 {
-   std::lock_guard lock{_mutex};
+   std::scoped_lock lock{_mutex, _journal_mutex};
 
    absl::flat_hash_set<std::string_view> dependents;
    dependents.reserve(file_store.size());
@@ -31,6 +232,8 @@ void Cache::clear_stale_entries(const Source_file_dependency_index& dependency_i
       if (group.last_write_time > std::exchange(_group_last_write_times[group.group_name],
                                                 group.last_write_time)) {
          invalidate_group_nolock(group.group_name);
+         _compaction_pending = true;
+
          continue;
       }
 
@@ -53,6 +256,8 @@ void Cache::clear_stale_entries(const Source_file_dependency_index& dependency_i
          if (file_store.last_write_time(dependent) >
              _shader_last_write_times[dependent]) {
             invalidate_group_nolock(group.group_name);
+            _compaction_pending = true;
+
             break;
          }
       }
@@ -67,7 +272,23 @@ void Cache::clear_stale_entries(const Source_file_dependency_index& dependency_i
 
 void Cache::save_to_file(const std::filesystem::path& cache_path)
 {
-   std::shared_lock lock{_mutex};
+   std::shared_ptr<const std::vector<Cache_record>> records;
+   std::size_t records_epoch = 0;
+   absl::flat_hash_map<std::string, file_time_type> group_last_write_times;
+   absl::flat_hash_map<std::string, file_time_type> shader_last_write_times;
+
+   // The file is written without holding any of the cache's locks, anything
+   // that modifies the records in the meantime copies them first.
+   {
+      std::scoped_lock lock{_journal_mutex};
+
+      if (!std::exchange(_compaction_pending, false)) return;
+
+      records = _records;
+      records_epoch = _records_epoch;
+      group_last_write_times = _group_last_write_times;
+      shader_last_write_times = _shader_last_write_times;
+   }
 
    try {
       const auto write_path = std::filesystem::path{cache_path} += L".TEMP"sv;
@@ -80,29 +301,31 @@ void Cache::save_to_file(const std::filesystem::path& cache_path)
                  current_shader_patch_version.prerelease_stage,
                  current_shader_patch_version.prerelease);
 
-      const auto write_stage_cache =
-         [&file]<typename K, typename V>(const Basic_cache_map<K, V>& cache) {
-            file.write(cache.size());
+      const auto write_stage_records = [&](const Stage stage) {
+         const auto stage_records =
+            *records | std::views::filter([stage](const Cache_record& record) {
+               return record.stage == stage;
+            });
 
-            for (const auto& [index, entry] : cache) {
-               file.write(index.group.size(), index.group);
-               file.write(index.entrypoint.size(), index.entrypoint);
-               file.write(index.static_flags);
+         file.write(static_cast<std::size_t>(std::ranges::distance(stage_records)));
 
-               if constexpr (std::is_same_v<K, Cache_index_vs>) {
-                  file.write(index.game_flags);
-               }
+         for (const auto& record : stage_records) {
+            file.write(record.group.size(), record.group);
+            file.write(record.entrypoint.size(), record.entrypoint);
+            file.write(record.static_flags);
 
-               file.write(entry.bytecode.size(), entry.bytecode);
-            }
-         };
+            if (stage == Stage::vertex) file.write(record.game_flags);
+
+            file.write(record.bytecode.size(), record.bytecode);
+         }
+      };
 
-      write_stage_cache(_cs_cache);
-      write_stage_cache(_vs_cache);
-      write_stage_cache(_ds_cache);
-      write_stage_cache(_hs_cache);
-      write_stage_cache(_gs_cache);
-      write_stage_cache(_ps_cache);
+      write_stage_records(Stage::compute);
+      write_stage_records(Stage::vertex);
+      write_stage_records(Stage::domain);
+      write_stage_records(Stage::hull);
+      write_stage_records(Stage::geometry);
+      write_stage_records(Stage::pixel);
 
       // write last write times
       const auto write_last_writes =
@@ -115,8 +338,8 @@ void Cache::save_to_file(const std::filesystem::path& cache_path)
             }
          };
 
-      write_last_writes(_group_last_write_times);
-      write_last_writes(_shader_last_write_times);
+      write_last_writes(group_last_write_times);
+      write_last_writes(shader_last_write_times);
 
       file.close();
 
@@ -126,106 +349,404 @@ void Cache::save_to_file(const std::filesystem::path& cache_path)
    }
    catch (std::exception&) {
       log(Log_level::warning, "Failed to save shader cache to file!"sv);
+
+      std::scoped_lock lock{_journal_mutex};
+
+      _compaction_pending = true;
+
+      return;
    }
+
+   std::scoped_lock lock{_journal_mutex};
+
+   // If records were removed while the file was being written the journal
+   // has to stay as it is, the next compaction will clean it up.
+   if (records_epoch != _records_epoch) {
+      _compaction_pending = true;
+
+      return;
+   }
+
+   const auto new_records = std::span{*_records}.subspan(records->size());
+
+   restart_journal(new_records);
+
+   if (!new_records.empty()) _compaction_pending = true;
+}
+
+bool Cache::compaction_pending() const noexcept
+{
+   std::scoped_lock lock{_journal_mutex};
+
+   return _compaction_pending;
 }
 
 void Cache::load_from_file(ID3D11Device5& device, const std::filesystem::path& cache_path)
 {
+   std::vector<Cache_record> records;
+
    if (!std::filesystem::exists(cache_path)) {
       log(Log_level::info, "Shader bytecode cache not present on disk."sv);
-
-      return;
    }
+   else {
+      try {
+         Binary_reader file{cache_path};
 
-   try {
-      Binary_reader file{cache_path};
+         Shader_patch_version cache_sp_version{};
 
-      Shader_patch_version cache_sp_version{};
+         file.read_to(cache_sp_version.major, cache_sp_version.minor,
+                      cache_sp_version.patch, cache_sp_version.prerelease_stage,
+                      cache_sp_version.prerelease);
 
-      file.read_to(cache_sp_version.major, cache_sp_version.minor,
-                   cache_sp_version.patch, cache_sp_version.prerelease_stage,
-                   cache_sp_version.prerelease);
+         if (cache_sp_version != current_shader_patch_version) {
+            log(Log_level::info,
+                "Shader bytecode cache is from a different version of Shader Patch, discarding it."sv);
 
-      if (cache_sp_version != current_shader_patch_version) return;
+            // The journal is from the same version as the cache file,
+            // neither is any use.
+            std::error_code ec;
+            std::filesystem::remove(_journal_path, ec);
 
-      const auto read_string = [&file](auto& out) {
-         out.resize(file.read<std::size_t>());
+            return;
+         }
 
-         file.read_to(out);
-      };
+         const auto read_string = [&file](auto& out) {
+            out.resize(file.read<std::size_t>());
+
+            file.read_to(out);
+         };
 
-      const auto read_stage_cache =
-         [&]<typename K, typename V>(Basic_cache_map<K, V>& cache, auto create) {
+         const auto read_stage_records = [&](const Stage stage) {
             const auto entry_count = file.read<std::size_t>();
 
             for (std::size_t i = 0; i < entry_count; ++i) {
+               Cache_record record{.stage = stage};
 
-               K index;
+               read_string(record.group);
+               read_string(record.entrypoint);
 
-               read_string(index.group);
-               read_string(index.entrypoint);
+               file.read_to(record.static_flags);
 
-               file.read_to(index.static_flags);
+               if (stage == Stage::vertex) file.read_to(record.game_flags);
 
-               if constexpr (std::is_same_v<K, Cache_index_vs>) {
-                  file.read_to(index.game_flags);
-               }
+               record.bytecode = Bytecode_blob{file.read<std::size_t>()};
+
+               file.read_to(record.bytecode);
+
+               records.push_back(std::move(record));
+            }
+         };
+
+         read_stage_records(Stage::compute);
+         read_stage_records(Stage::vertex);
+         read_stage_records(Stage::domain);
+         read_stage_records(Stage::hull);
+         read_stage_records(Stage::geometry);
+         read_stage_records(Stage::pixel);
 
-               Bytecode_blob bytecode{file.read<std::size_t>()};
+         // read last write times
+         const auto read_last_writes =
+            [&](absl::flat_hash_map<std::string, std::filesystem::file_time_type>& last_writes) {
+               const auto count = file.read<std::size_t>();
 
-               file.read_to(bytecode);
+               last_writes.reserve(count);
 
-               Com_ptr<V> shader;
+               for (std::size_t i = 0; i < count; ++i) {
+                  std::string name;
 
-               if (const auto result =
-                      std::invoke(create, device, bytecode.data(), bytecode.size(),
-                                  nullptr, shader.clear_and_assign());
-                   FAILED(result)) {
-                  log_debug("Failed to create shader from cached bytecode {}:{}({:x})"sv,
-                            index.group, index.entrypoint, index.static_flags);
+                  read_string(name);
 
-                  return;
+                  last_writes[std::move(name)] = file_time_type{file_time_type::duration{
+                     file.read<file_time_type::duration::rep>()}};
                }
+            };
 
-               log_debug("Loaded and created cached shader {}:{}({:x})"sv,
-                         index.group, index.entrypoint, index.static_flags);
+         read_last_writes(_group_last_write_times);
+         read_last_writes(_shader_last_write_times);
+      }
+      catch (std::exception&) {
+         log(Log_level::warning,
+             "Failed to load shader cache to file! Slow startup expected."sv);
 
-               cache.emplace(std::move(index),
-                             Cache_entry<V>{.shader = std::move(shader),
-                                            .bytecode = std::move(bytecode)});
-            }
-         };
+         records.clear();
+      }
+   }
+
+   try {
+      auto journal_records = load_journal(_journal_path);
 
-      read_stage_cache(_cs_cache, &ID3D11Device5::CreateComputeShader);
-      read_stage_cache(_vs_cache, &ID3D11Device5::CreateVertexShader);
-      read_stage_cache(_ds_cache, &ID3D11Device5::CreateDomainShader);
-      read_stage_cache(_hs_cache, &ID3D11Device5::CreateHullShader);
-      read_stage_cache(_gs_cache, &ID3D11Device5::CreateGeometryShader);
-      read_stage_cache(_ps_cache, &ID3D11Device5::CreatePixelShader);
+      if (!journal_records.empty()) {
+         log(Log_level::info, "Recovered "sv, journal_records.size(),
+             " shader(s) from the shader cache journal."sv);
 
-      // read last write times
-      const auto read_last_writes =
-         [&](absl::flat_hash_map<std::string, std::filesystem::file_time_type>& last_writes) {
-            const auto count = file.read<std::size_t>();
+         _compaction_pending = true;
+      }
+
+      std::ranges::move(journal_records, std::back_inserter(records));
+   }
+   catch (std::exception&) {
+      log(Log_level::warning, "Failed to read shader cache journal!"sv);
+   }
+
+   for (auto& record : records) {
+      const auto add = [&]<typename K, typename V>(Basic_cache_map<K, V>& cache,
+                                                   auto create) {
+         auto shader = create_shader_from_record<V>(device, record, create);
+
+         if (!shader) return;
 
-            last_writes.reserve(count);
+         K index;
 
-            for (std::size_t i = 0; i < count; ++i) {
-               std::string name;
+         index.group = record.group;
+         index.entrypoint = record.entrypoint;
+         index.static_flags = record.static_flags;
 
-               read_string(name);
+         if constexpr (std::is_same_v<K, Cache_index_vs>) {
+            index.game_flags = record.game_flags;
+         }
+
+         cache.insert_or_assign(std::move(index),
+                                Cache_entry<V>{.shader = std::move(shader),
+                                               .bytecode = record.bytecode});
+      };
 
-               last_writes[std::move(name)] = file_time_type{file_time_type::duration{
-                  file.read<file_time_type::duration::rep>()}};
+      switch (record.stage) {
+      case Stage::compute:
+         add(_cs_cache, &ID3D11Device5::CreateComputeShader);
+         break;
+      case Stage::vertex:
+         add(_vs_cache, &ID3D11Device5::CreateVertexShader);
+         break;
+      case Stage::hull:
+         add(_hs_cache, &ID3D11Device5::CreateHullShader);
+         break;
+      case Stage::domain:
+         add(_ds_cache, &ID3D11Device5::CreateDomainShader);
+         break;
+      case Stage::geometry:
+         add(_gs_cache, &ID3D11Device5::CreateGeometryShader);
+         break;
+      case Stage::pixel:
+         add(_ps_cache, &ID3D11Device5::CreatePixelShader);
+         break;
+      }
+   }
+
+   // Rebuild the records from the maps so later duplicates and entries that
+   // failed to load are dropped.
+   const auto add_records = [&]<typename K, typename V>(const Basic_cache_map<K, V>& cache) {
+      for (const auto& [index, entry] : cache) {
+         Cache_record record{.stage = stage_of<V>(),
+                             .group = index.group,
+                             .entrypoint = index.entrypoint,
+                             .static_flags = index.static_flags,
+                             .bytecode = entry.bytecode};
+
+         if constexpr (std::is_same_v<K, Cache_index_vs>) {
+            record.game_flags = index.game_flags;
+         }
+
+         _record_indices.emplace(record_key(record), _records->size());
+         _records->push_back(std::move(record));
+      }
+   };
+
+   add_records(_cs_cache);
+   add_records(_vs_cache);
+   add_records(_ds_cache);
+   add_records(_hs_cache);
+   add_records(_gs_cache);
+   add_records(_ps_cache);
+}
+
+auto Cache::load_journal(const std::filesystem::path& journal_path)
+   -> std::vector<Cache_record>
+{
+   if (!std::filesystem::exists(journal_path) ||
+       std::filesystem::file_size(journal_path) == 0) {
+      return {};
+   }
+
+   std::vector<Cache_record> records;
+   bool torn = false;
+   bool other_version = false;
+
+   {
+      win32::Memeory_mapped_file file{journal_path};
+
+      Record_deserializer journal{file.bytes()};
+
+      Shader_patch_version journal_sp_version{};
+
+      try {
+         journal_sp_version.major = journal.read<decltype(journal_sp_version.major)>();
+         journal_sp_version.minor = journal.read<decltype(journal_sp_version.minor)>();
+         journal_sp_version.patch = journal.read<decltype(journal_sp_version.patch)>();
+         journal_sp_version.prerelease_stage =
+            journal.read<decltype(journal_sp_version.prerelease_stage)>();
+         journal_sp_version.prerelease =
+            journal.read<decltype(journal_sp_version.prerelease)>();
+      }
+      catch (std::exception&) {
+         torn = true;
+      }
+
+      other_version = !torn && journal_sp_version != current_shader_patch_version;
+
+      while (!torn && !other_version && journal.remaining() != 0) {
+         try {
+            const auto header = journal.read<Journal_record_header>();
+
+            if (header.magic != journal_record_magic) {
+               throw std::runtime_error{"bad journal record magic"};
             }
-         };
 
-      read_last_writes(_group_last_write_times);
-      read_last_writes(_shader_last_write_times);
+            const auto payload = journal.read_bytes(header.size);
+
+            if (checksum(payload) != header.checksum) {
+               throw std::runtime_error{"bad journal record checksum"};
+            }
+
+            records.push_back(deserialize_record(payload));
+         }
+         catch (std::exception&) {
+            torn = true;
+         }
+      }
    }
-   catch (std::exception&) {
+
+   // Records from another version are no use, start over without them.
+   if (other_version) {
+      log(Log_level::info,
+          "Shader cache journal is from a different version of Shader Patch, discarding it."sv);
+
+      restart_journal({});
+
+      return {};
+   }
+
+   // Anything appended after a torn record (or a torn header) would be
+   // unreachable, so rewrite the journal with just the good records before
+   // it's appended to again.
+   if (torn) {
       log(Log_level::warning,
-          "Failed to load shader cache to file! Slow startup expected."sv);
+          "Shader cache journal was damaged (likely from a crash), discarding its tail."sv);
+
+      restart_journal(records);
+   }
+
+   return records;
+}
+
+void Cache::append_record_nolock(Cache_record record) noexcept
+{
+   _compaction_pending = true;
+
+   if (!_journal_failed) {
+      try {
+         if (!_journal) {
+            const bool new_journal = !std::filesystem::exists(_journal_path) ||
+                                     std::filesystem::file_size(_journal_path) == 0;
+
+            _journal.emplace(_journal_path, Binary_file::Mode::append);
+
+            if (new_journal) write_journal_header(*_journal);
+         }
+
+         write_journal_record(*_journal, record);
+      }
+      catch (std::exception&) {
+         log(Log_level::warning,
+             "Failed to write to shader cache journal! New shaders will only be saved periodically."sv);
+
+         _journal = std::nullopt;
+         _journal_failed = true;
+      }
+   }
+
+   auto& records = writable_records_nolock();
+
+   const auto [index, inserted] =
+      _record_indices.try_emplace(record_key(record), records.size());
+
+   // A variant can be added again (after being compiled by two threads at
+   // once for instance), keep only the newest record of it.
+   if (inserted) {
+      records.push_back(std::move(record));
+   }
+   else {
+      records[index->second] = std::move(record);
+      _records_epoch += 1;
+   }
+}
+
+void Cache::invalidate_group_nolock(const std::string_view group) noexcept
+{
+   invalidate_group_impl(group, _vs_cache, _cs_cache, _ds_cache, _hs_cache,
+                         _gs_cache, _ps_cache);
+
+   const auto in_group = [group](const Cache_record& record) noexcept {
+      return record.group == group;
+   };
+
+   if (std::ranges::none_of(*_records, in_group)) return;
+
+   auto& records = writable_records_nolock();
+
+   std::erase_if(records, in_group);
+
+   _record_indices.clear();
+
+   for (std::size_t i = 0; i < records.size(); ++i) {
+      _record_indices.emplace(record_key(records[i]), i);
+   }
+
+   _records_epoch += 1;
+   _compaction_pending = true;
+}
+
+auto Cache::writable_records_nolock() noexcept -> std::vector<Cache_record>&
+{
+   // A save still writing out the records keeps the copy it has.
+   if (_records.use_count() > 1) {
+      _records = std::make_shared<std::vector<Cache_record>>(*_records);
+   }
+
+   return *_records;
+}
+
+auto Cache::record_key(const Cache_record& record) noexcept -> Record_key
+{
+   return {.stage = record.stage,
+           .group = record.group,
+           .entrypoint = record.entrypoint,
+           .static_flags = record.static_flags,
+           .game_flags = record.game_flags};
+}
+
+void Cache::restart_journal(const std::span<const Cache_record> records) noexcept
+{
+   _journal = std::nullopt;
+
+   try {
+      const auto write_path = std::filesystem::path{_journal_path} += L".TEMP"sv;
+
+      {
+         Binary_writer journal{write_path};
+
+         write_journal_header(journal);
+
+         for (const auto& record : records) write_journal_record(journal, record);
+      }
+
+      std::filesystem::rename(write_path, _journal_path);
+
+      _journal_failed = false;
+   }
+   catch (std::exception&) {
+      log(Log_level::warning, "Failed to restart shader cache journal!"sv);
+
+      _journal_failed = true;
    }
 }
 
@@ -1,14 +1,20 @@
 #pragma once
 
+#include "binary_io_winapi.hpp"
 #include "bytecode_blob.hpp"
 #include "com_ptr.hpp"
+#include "common.hpp"
 #include "group_definition.hpp"
 #include "source_file_dependency_index.hpp"
 #include "source_file_store.hpp"
 
 #include <cstddef>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <span>
 #include <tuple>
 #include <vector>
 
@@ -67,14 +73,30 @@ struct Cache_index_vs {
    }
 };
 
+// A cache entry as it is persisted to disk.
+struct Cache_record {
+   Stage stage;
+   std::string group;
+   std::string entrypoint;
+   std::uint64_t static_flags;
+   Vertex_shader_flags game_flags = Vertex_shader_flags::none;
+   Bytecode_blob bytecode;
+};
+
+// Shader cache with an on disk copy. New entries are appended to a journal
+// next to the cache file as they're added, the journal is then periodically
+// compacted into the main cache file with save_to_file. Both are read back
+// (skipping any torn records left behind by a crash) on load.
 class Cache {
 public:
    Cache(ID3D11Device5& device, const std::filesystem::path& cache_path) noexcept;
 
+   // Entries are returned by copy, the maps can rehash as soon as the lock is
+   // released.
    template<typename T>
    auto get_if(const std::string_view group_name, const std::string_view entrypoint_name,
                const std::uint64_t static_flags) const noexcept
-      -> const Cache_entry<T>*
+      -> std::optional<Cache_entry<T>>
    {
       std::shared_lock lock{_mutex};
 
@@ -86,7 +108,7 @@ public:
                   const std::string_view entrypoint_name,
                   const std::uint64_t static_flags,
                   const Vertex_shader_flags game_flags) const noexcept
-      -> const Cache_entry<ID3D11VertexShader>*
+      -> std::optional<Cache_entry<ID3D11VertexShader>>
    {
       std::shared_lock lock{_mutex};
 
@@ -98,30 +120,54 @@ public:
    void add(const std::string_view group_name, const std::string_view entrypoint_name,
             const std::uint64_t static_flags, Cache_entry<T> cache_entry) noexcept
    {
-      std::scoped_lock lock{_mutex};
+      std::unique_lock cache_lock{_mutex};
 
       auto& cache = cache_map<T>(*this);
 
       cache[Cache_index{.group = std::string{group_name},
                         .entrypoint = std::string{entrypoint_name},
-                        .static_flags = static_flags}] = std::move(cache_entry);
+                        .static_flags = static_flags}] = cache_entry;
+
+      // Take the journal's lock before letting go of the cache's so entries
+      // are journaled in the order they were inserted and an invalidation
+      // can't land between the two.
+      std::scoped_lock journal_lock{_journal_mutex};
+
+      cache_lock.unlock();
+
+      append_record_nolock(Cache_record{.stage = stage_of<T>(),
+                                        .group = std::string{group_name},
+                                        .entrypoint = std::string{entrypoint_name},
+                                        .static_flags = static_flags,
+                                        .bytecode = std::move(cache_entry.bytecode)});
    }
 
    void add_vs(const std::string_view group_name, const std::string_view entrypoint_name,
                const std::uint64_t static_flags, const Vertex_shader_flags game_flags,
                Cache_entry<ID3D11VertexShader> cache_entry) noexcept
    {
-      std::scoped_lock lock{_mutex};
+      std::unique_lock cache_lock{_mutex};
 
       _vs_cache[Cache_index_vs{.group = std::string{group_name},
                                .entrypoint = std::string{entrypoint_name},
                                .static_flags = static_flags,
-                               .game_flags = game_flags}] = std::move(cache_entry);
+                               .game_flags = game_flags}] = cache_entry;
+
+      std::scoped_lock journal_lock{_journal_mutex};
+
+      cache_lock.unlock();
+
+      append_record_nolock(Cache_record{.stage = Stage::vertex,
+                                        .group = std::string{group_name},
+                                        .entrypoint = std::string{entrypoint_name},
+                                        .static_flags = static_flags,
+                                        .game_flags = game_flags,
+                                        .bytecode = std::move(cache_entry.bytecode)});
    }
 
    void invalidate_group(const std::string_view group) noexcept
    {
-      std::lock_guard lock{_mutex};
+      std::scoped_lock lock{_mutex, _journal_mutex};
 
       invalidate_group_nolock(group);
    }
@@ -130,15 +176,37 @@ public:
                             const Source_file_store& file_store,
                             const std::span<const Group_definition> groups) noexcept;
 
+   // Compacts the journal into the main cache file. The records are shared
+   // with the save rather than copied so the journal's lock is only held
+   // briefly and adding entries is never blocked on the file being written.
    void save_to_file(const std::filesystem::path& cache_path);
 
+   // If there are entries in the journal (or invalidated entries still in
+   // the cache file) that a call to save_to_file would compact.
+   bool compaction_pending() const noexcept;
+
 private:
    void load_from_file(ID3D11Device5& device, const std::filesystem::path& cache_path);
 
-   void invalidate_group_nolock(const std::string_view group) noexcept
+   auto load_journal(const std::filesystem::path& journal_path) -> std::vector<Cache_record>;
+
+   void append_record_nolock(Cache_record record) noexcept;
+
+   void restart_journal(const std::span<const Cache_record> records) noexcept;
+
+   void invalidate_group_nolock(const std::string_view group) noexcept;
+
+   auto writable_records_nolock() noexcept -> std::vector<Cache_record>&;
+
+   template<typename T>
+   constexpr static auto stage_of() noexcept -> Stage
    {
-      invalidate_group_impl(group, _vs_cache, _cs_cache, _ds_cache, _hs_cache,
-                            _gs_cache, _ps_cache);
+      if constexpr (std::is_same_v<T, ID3D11ComputeShader>) return Stage::compute;
+      if constexpr (std::is_same_v<T, ID3D11VertexShader>) return Stage::vertex;
+      if constexpr (std::is_same_v<T, ID3D11HullShader>) return Stage::hull;
+      if constexpr (std::is_same_v<T, ID3D11DomainShader>) return Stage::domain;
+      if constexpr (std::is_same_v<T, ID3D11GeometryShader>) return Stage::geometry;
+      if constexpr (std::is_same_v<T, ID3D11PixelShader>) return Stage::pixel;
    }
 
    template<typename... Args>
@@ -151,6 +219,25 @@ private:
        ...);
    }
 
+   struct Record_key {
+      Stage stage;
+      std::string group;
+      std::string entrypoint;
+      std::uint64_t static_flags;
+      Vertex_shader_flags game_flags;
+
+      template<typename H>
+      friend H AbslHashValue(H h, const Record_key& key)
+      {
+         return H::combine(std::move(h), key.stage, key.group, key.entrypoint,
+                           key.static_flags, key.game_flags);
+      }
+
+      bool operator==(const Record_key&) const noexcept = default;
+   };
+
+   static auto record_key(const Cache_record& record) noexcept -> Record_key;
+
    struct Group_info {
       bool dirty = true;
       std::string name;
@@ -179,13 +266,13 @@ private:
 
    template<typename C, typename K>
    auto get_if_impl(const C& container, K k) const noexcept
-      -> std::add_pointer_t<const typename C::mapped_type>
+      -> std::optional<typename C::mapped_type>
    {
       if (auto it = container.find(k); it != container.end()) {
-         return &it->second;
+         return it->second;
       }
 
-      return nullptr;
+      return std::nullopt;
    }
 
    template<typename T, typename S>
@@ -219,6 +306,23 @@ private:
    Cache_map<ID3D11GeometryShader> _gs_cache;
    Cache_map<ID3D11PixelShader> _ps_cache;
 
+   // Everything below is guarded by _journal_mutex. When both mutexes are
+   // needed _mutex must be locked first.
+   mutable std::mutex _journal_mutex;
+
+   std::filesystem::path _journal_path;
+   std::optional<Binary_writer> _journal;
+   bool _journal_failed = false;
+   bool _compaction_pending = false;
+
+   // Copied on write while a save still holds onto them. Adding a variant
+   // that's already recorded replaces its record in place, found through
+   // _record_indices.
+   std::shared_ptr<std::vector<Cache_record>> _records =
+      std::make_shared<std::vector<Cache_record>>();
+   absl::flat_hash_map<Record_key, std::size_t> _record_indices;
+   std::size_t _records_epoch = 0;
+
    absl::flat_hash_map<std::string, std::filesystem::file_time_type> _group_last_write_times;
    absl::flat_hash_map<std::string, std::filesystem::file_time_type> _shader_last_write_times;
 };
@@ -0,0 +1,174 @@
+
+#include "compile_service.hpp"
+
+#include <algorithm>
+
+namespace sp::shader {
+
+Compile_service::Compile_service(Compile_backend& backend, Completion_callback on_complete,
+                                 const std::size_t worker_count) noexcept
+   : _backend{backend}, _on_complete{std::move(on_complete)}
+{
+   _workers.reserve(worker_count);
+
+   for (std::size_t i = 0; i < worker_count; ++i) {
+      _workers.emplace_back(
+         [this](std::stop_token stop_token) { worker_main(stop_token); });
+   }
+}
+
+Compile_service::~Compile_service()
+{
+   for (auto& worker : _workers) worker.request_stop();
+
+   _work_cv.notify_all();
+
+   _workers.clear();
+}
+
+void Compile_service::compile_async(const Compile_key& key,
+                                    const Entrypoint_description& entrypoint) noexcept
+{
+   std::unique_lock lock{_mutex};
+
+   if (_in_flight.contains(key)) return;
+
+   auto promise = std::make_shared<std::promise<Bytecode_blob>>();
+
+   _in_flight.emplace(key, promise->get_future().share());
+
+   // With no workers to hand the job off to compile it here, the caller still
+   // gets single-flight behaviour just not the background part.
+   if (_workers.empty()) {
+      lock.unlock();
+
+      Job job{.key = key, .entrypoint = &entrypoint, .promise = std::move(promise)};
+
+      run(job);
+
+      return;
+   }
+
+   _queue.push_back(
+      Job{.key = key, .entrypoint = &entrypoint, .promise = std::move(promise)});
+
+   lock.unlock();
+
+   _work_cv.notify_one();
+}
+
+auto Compile_service::compile_wait(const Compile_key& key,
+                                   const Entrypoint_description& entrypoint) noexcept
+   -> Bytecode_blob
+{
+   std::unique_lock lock{_mutex};
+
+   if (auto it = _in_flight.find(key); it != _in_flight.end()) {
+      auto future = it->second;
+
+      // If nobody has picked the job up yet run it here rather than waiting
+      // behind whatever else is in the queue.
+      if (auto queued = std::ranges::find(_queue, key, &Job::key);
+          queued != _queue.end()) {
+         Job job = std::move(*queued);
+
+         _queue.erase(queued);
+
+         lock.unlock();
+
+         run(job);
+      }
+      else {
+         lock.unlock();
+      }
+
+      return future.get();
+   }
+
+   auto promise = std::make_shared<std::promise<Bytecode_blob>>();
+
+   auto future = promise->get_future().share();
+
+   _in_flight.emplace(key, future);
+
+   lock.unlock();
+
+   Job job{.key = key, .entrypoint = &entrypoint, .promise = std::move(promise)};
+
+   run(job);
+
+   return future.get();
+}
+
+bool Compile_service::in_flight(const Compile_key& key) const noexcept
+{
+   std::scoped_lock lock{_mutex};
+
+   return _in_flight.contains(key);
+}
+
+auto Compile_service::in_flight_count() const noexcept -> std::size_t
+{
+   std::scoped_lock lock{_mutex};
+
+   return _in_flight.size();
+}
+
+void Compile_service::wait_idle() noexcept
+{
+   std::unique_lock lock{_mutex};
+
+   _idle_cv.wait(lock, [this] { return _in_flight.empty(); });
+}
+
+auto Compile_service::default_worker_count() noexcept -> std::size_t
+{
+   // Leave the game's main and render threads alone, shader compiles are
+   // memory hungry so don't go wild on large machines either.
+   const std::size_t hardware_threads = std::thread::hardware_concurrency();
+
+   return std::clamp<std::size_t>(hardware_threads, 3, 6) - 2;
+}
+
+void Compile_service::worker_main(std::stop_token stop_token) noexcept
+{
+   while (true) {
+      std::unique_lock lock{_mutex};
+
+      // Once stopped keep going until the queue is empty, anything queued has
+      // a shared future waiting on it that must not be left broken.
+      _work_cv.wait(lock, stop_token, [this] { return !_queue.empty(); });
+
+      if (_queue.empty()) return;
+
+      Job job = std::move(_queue.front());
+
+      _queue.pop_front();
+
+      lock.unlock();
+
+      run(job);
+   }
+}
+
+void Compile_service::run(Job& job) noexcept
+{
+   auto bytecode = _backend.compile(*job.entrypoint, job.key.static_flags,
+                                    job.key.game_flags);
+
+   if (_on_complete) _on_complete(job.key, bytecode);
+
+   job.promise->set_value(std::move(bytecode));
+
+   std::unique_lock lock{_mutex};
+
+   _in_flight.erase(job.key);
+
+   const bool idle = _in_flight.empty();
+
+   lock.unlock();
+
+   if (idle) _idle_cv.notify_all();
+}
+
+}
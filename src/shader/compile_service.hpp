@@ -0,0 +1,117 @@
+#pragma once
+
+#include "bytecode_blob.hpp"
+#include "common.hpp"
+#include "entrypoint_description.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace sp::shader {
+
+struct Compile_key {
+   Stage stage;
+   std::string group;
+   std::string entrypoint;
+   std::uint64_t static_flags;
+   Vertex_shader_flags game_flags = Vertex_shader_flags::none;
+
+   template<typename H>
+   friend H AbslHashValue(H h, const Compile_key& key)
+   {
+      return H::combine(std::move(h), key.stage, key.group, key.entrypoint,
+                        key.static_flags, key.game_flags);
+   }
+
+   bool operator==(const Compile_key&) const noexcept = default;
+};
+
+// Compiles shader source to bytecode. Must be safe to call from multiple
+// threads at once.
+class Compile_backend {
+public:
+   virtual ~Compile_backend() = default;
+
+   virtual auto compile(const Entrypoint_description& entrypoint,
+                        const std::uint64_t static_flags,
+                        const Vertex_shader_flags game_flags) noexcept -> Bytecode_blob = 0;
+};
+
+// Runs shader compiles on a pool of background threads, making sure any one
+// shader variant is only ever compiled once no matter how many callers ask for
+// it at the same time.
+class Compile_service {
+public:
+   // Called on the thread that ran the compile before any waiters are woken
+   // and before the key stops being reported as in flight. Used to publish the
+   // result (to a cache for instance) so that there is no window in which a
+   // caller can find the variant neither in flight nor published.
+   using Completion_callback =
+      std::function<void(const Compile_key& key, const Bytecode_blob& bytecode)>;
+
+   Compile_service(Compile_backend& backend, Completion_callback on_complete,
+                   const std::size_t worker_count) noexcept;
+
+   // Finishes every queued compile before returning.
+   ~Compile_service();
+
+   Compile_service(const Compile_service&) = delete;
+   auto operator=(const Compile_service&) -> Compile_service& = delete;
+
+   Compile_service(Compile_service&&) = delete;
+   auto operator=(Compile_service&&) -> Compile_service& = delete;
+
+   // Queues a background compile for the key unless one is already in flight.
+   // The entrypoint description must outlive the compile.
+   void compile_async(const Compile_key& key,
+                      const Entrypoint_description& entrypoint) noexcept;
+
+   // Compiles on the calling thread, or if the key is already in flight waits
+   // for and returns the result of that compile instead.
+   auto compile_wait(const Compile_key& key,
+                     const Entrypoint_description& entrypoint) noexcept -> Bytecode_blob;
+
+   bool in_flight(const Compile_key& key) const noexcept;
+
+   auto in_flight_count() const noexcept -> std::size_t;
+
+   // Blocks until every queued and running compile has finished.
+   void wait_idle() noexcept;
+
+   static auto default_worker_count() noexcept -> std::size_t;
+
+private:
+   struct Job {
+      Compile_key key;
+      const Entrypoint_description* entrypoint;
+      std::shared_ptr<std::promise<Bytecode_blob>> promise;
+   };
+
+   void worker_main(std::stop_token stop_token) noexcept;
+
+   void run(Job& job) noexcept;
+
+   Compile_backend& _backend;
+   const Completion_callback _on_complete;
+
+   mutable std::mutex _mutex;
+   std::condition_variable_any _work_cv;
+   std::condition_variable _idle_cv;
+   std::deque<Job> _queue;
+   absl::flat_hash_map<Compile_key, std::shared_future<Bytecode_blob>> _in_flight;
+
+   std::vector<std::jthread> _workers;
+};
+
+}
@@ -1,8 +1,11 @@
 
 #include "compiler.hpp"
 #include "../logger.hpp"
+#include "com_ptr.hpp"
 #include "retry_dialog.hpp"
 
+#include <mutex>
+#include <shared_mutex>
 #include <type_traits>
 
 #include <absl/container/inlined_vector.h>
@@ -17,6 +20,14 @@ namespace {
 
 using Shader_defines = absl::InlinedVector<D3D_SHADER_MACRO, 64>;
 
+// Compiles can run concurrently from the compile service's workers, only a
+// retry (which reloads the source files) needs exclusive access to the store.
+std::shared_mutex file_store_reload_mutex;
+
+// Keeps failed compiles from opening a retry dialog each. Deliberately separate
+// from the reload mutex so compiles on other threads carry on while it's open.
+std::mutex retry_dialog_mutex;
+
 class Includer : public ID3DInclude {
 public:
    explicit Includer(const Source_file_store& file_store)
@@ -154,6 +165,8 @@ auto compile(Source_file_store& file_store, const Entrypoint_description& entryp
              const std::uint64_t static_flags,
              const Vertex_shader_flags vertex_shader_flags) noexcept -> Bytecode_blob
 {
+   std::shared_lock reload_lock{file_store_reload_mutex};
+
    auto source = file_store.data(entrypoint.source_name);
 
    if (!source) {
@@ -181,8 +194,22 @@ auto compile(Source_file_store& file_store, const Entrypoint_description& entryp
                                                       error_messages->GetBufferPointer()),
                                                    error_messages->GetBufferSize()};
 
-      if (retry_dialog("Shader Compile Error"s, error_message_view)) {
-         file_store.reload();
+      reload_lock.unlock();
+
+      bool retry = false;
+
+      {
+         std::scoped_lock dialog_lock{retry_dialog_mutex};
+
+         retry = retry_dialog("Shader Compile Error"s, error_message_view);
+      }
+
+      if (retry) {
+         {
+            std::scoped_lock lock{file_store_reload_mutex};
+
+            file_store.reload();
+         }
 
          return compile(file_store, entrypoint, static_flags, vertex_shader_flags);
       }
@@ -193,6 +220,10 @@ auto compile(Source_file_store& file_store, const Entrypoint_description& entryp
    log_debug("Compiled shader {}:{}({:x})"sv, entrypoint.source_name,
              entrypoint.function_name, static_flags);
 
-   return Bytecode_blob{std::move(bytecode_result)};
+   const std::shared_ptr<ID3DBlob> blob{bytecode_result.unmanaged_copy(),
+                                        [](ID3DBlob* blob) { blob->Release(); }};
+
+   return Bytecode_blob{{blob, static_cast<std::byte*>(blob->GetBufferPointer())},
+                        blob->GetBufferSize()};
 }
 }
@@ -2,11 +2,13 @@
 #include "database.hpp"
 #include "../logger.hpp"
 #include "cache.hpp"
+#include "compile_service.hpp"
 #include "compiler.hpp"
 #include "entrypoint_description.hpp"
 #include "group_definition.hpp"
 #include "source_file_dependency_index.hpp"
 #include "source_file_store.hpp"
+#include "variant_table.hpp"
 
 #include <algorithm>
 #include <bitset>
@@ -208,18 +210,30 @@ auto create_rendertype_state_descs(const Group_definition& definition,
    return states;
 }
 
-class Cache_disk_updater {
+class D3d_compile_backend final : public Compile_backend {
 public:
-   constexpr static auto min_update_interval = 1min;
+   explicit D3d_compile_backend(Source_file_store& file_store) noexcept
+      : _file_store{file_store}
+   {
+   }
 
-   void mark_dirty() noexcept
+   auto compile(const Entrypoint_description& entrypoint, const std::uint64_t static_flags,
+                const Vertex_shader_flags game_flags) noexcept -> Bytecode_blob override
    {
-      _disk_cache_dirty = true;
+      return shader::compile(_file_store, entrypoint, static_flags, game_flags);
    }
 
-   bool should_update() const noexcept
+private:
+   Source_file_store& _file_store;
+};
+
+class Cache_disk_updater {
+public:
+   constexpr static auto min_update_interval = 1min;
+
+   bool should_update(const Cache& cache) const noexcept
    {
-      if (!_disk_cache_dirty) return false;
+      if (!cache.compaction_pending()) return false;
 
       return (std::chrono::steady_clock::now() - _last_update) >= min_update_interval;
    }
@@ -229,12 +243,10 @@ public:
       _update_future = std::async(std::launch::async, [&cache, cache_path] {
          cache.save_to_file(cache_path);
       });
-      _disk_cache_dirty = false;
       _last_update = std::chrono::steady_clock::now();
    }
 
 private:
-   bool _disk_cache_dirty = false;
    std::chrono::steady_clock::time_point _last_update =
       std::chrono::steady_clock::now();
    std::future<void> _update_future;
@@ -244,6 +256,8 @@ private:
 
 class Database_internal {
 public:
+   using Entrypoint_ids = absl::flat_hash_map<std::string, Entrypoint_id>;
+
    Database_internal(Com_ptr<ID3D11Device5> device, Database_file_paths file_paths)
       : _device{device}, _file_paths{std::move(file_paths)}
    {
@@ -255,8 +269,16 @@ public:
            definitions | filter([](const Group_definition& definition) {
               return !definition.entrypoints.empty();
            })) {
-         _entrypoint_descs.emplace(definition.group_name,
-                                   create_entrypoint_descs(definition));
+         auto& group_ids = _entrypoint_ids[definition.group_name];
+
+         for (auto& [name, desc] : create_entrypoint_descs(definition)) {
+            group_ids.emplace(name, Entrypoint_id{static_cast<std::uint32_t>(
+                                       _entrypoints.size())});
+
+            _entrypoints.push_back(Interned_entrypoint{.group_name = definition.group_name,
+                                                       .entrypoint_name = name,
+                                                       .desc = std::move(desc)});
+         }
       }
 
       for (const auto& definition :
@@ -272,95 +294,171 @@ public:
 
       _cache.clear_stale_entries(_source_dependency_index, _source_file_store,
                                  definitions);
+
+      _resolved = std::make_unique<Variant_table<Resolved_variant>[]>(_entrypoints.size());
+   }
+
+   Database_internal(const Database_internal&) = delete;
+   auto operator=(const Database_internal&) -> Database_internal& = delete;
+
+   Database_internal(Database_internal&&) = delete;
+   auto operator=(Database_internal&&) -> Database_internal& = delete;
+
+   auto entrypoint_id(const std::string_view group_name,
+                      const std::string_view entrypoint_name) const noexcept -> Entrypoint_id
+   {
+      const auto& group_ids = entrypoint_ids(group_name);
+
+      if (auto entrypoint = group_ids.find(entrypoint_name);
+          entrypoint != group_ids.end()) {
+         return entrypoint->second;
+      }
+
+      log_and_terminate("Unable to find shader entrypoint '"sv, entrypoint_name,
+                        "' in shader group '"sv, group_name, "'!"sv);
+   }
+
+   auto entrypoint_ids(const std::string_view group_name) const noexcept
+      -> const Entrypoint_ids&
+   {
+      if (auto group = _entrypoint_ids.find(group_name); group != _entrypoint_ids.end()) {
+         return group->second;
+      }
+
+      log_and_terminate("Unable to find shader group '"sv, group_name, "'!"sv);
    }
 
    template<typename T>
-   auto get(const std::string_view group_name, const std::string_view entrypoint_name,
-            const std::uint64_t static_flags) noexcept -> Com_ptr<T>
+   auto get(const Entrypoint_id id, const std::uint64_t static_flags) noexcept
+      -> Com_ptr<T>
    {
-      if (auto cached = _cache.get_if<T>(group_name, entrypoint_name, static_flags);
-          cached) {
-         return cached->shader;
+      if (const auto* resolved = find_resolved(id, static_flags); resolved) [[likely]] {
+         return resolved_shader<T>(*resolved);
       }
 
-      // Multithreading stuff to stop double compilation goes here.
+      const auto& entrypoint = get_entrypoint(to_stage<T>(), id);
+
+      if (auto cached = _cache.get_if<T>(entrypoint.group_name,
+                                         entrypoint.entrypoint_name, static_flags);
+          cached) {
+         return resolved_shader<T>(resolve(id, static_flags, *cached));
+      }
 
-      const auto& entrypoint_desc = get_entrypoint_desc(group_name, entrypoint_name);
+      _compile_service.compile_wait(Compile_key{.stage = to_stage<T>(),
+                                                .group = entrypoint.group_name,
+                                                .entrypoint = entrypoint.entrypoint_name,
+                                                .static_flags = static_flags},
+                                    entrypoint.desc);
 
-      if (entrypoint_desc.stage != to_stage<T>()) {
-         log_and_terminate("Shader stage mismatch for entrypoint '"sv,
-                           entrypoint_name, "' from group '"sv, group_name, "'"sv);
+      if (auto cached = _cache.get_if<T>(entrypoint.group_name,
+                                         entrypoint.entrypoint_name, static_flags);
+          cached) {
+         return resolved_shader<T>(resolve(id, static_flags, *cached));
       }
 
-      auto bytecode = compile(_source_file_store, entrypoint_desc, static_flags);
+      log_and_terminate("Compiled shader for entrypoint '"sv, entrypoint.entrypoint_name,
+                        "' from group '"sv, entrypoint.group_name,
+                        "' is missing from the cache!"sv);
+   }
+
+   template<typename T>
+   auto get_async(const Entrypoint_id id, const std::uint64_t static_flags) noexcept
+      -> std::optional<Com_ptr<T>>
+   {
+      if (const auto* resolved = find_resolved(id, static_flags); resolved) [[likely]] {
+         return resolved_shader<T>(*resolved);
+      }
 
-      auto shader = create_shader<T>(*_device, bytecode);
+      const auto& entrypoint = get_entrypoint(to_stage<T>(), id);
 
-      if (!shader) {
-         log_and_terminate("Unable to recover from failed shader creation!"sv);
+      if (auto cached = _cache.get_if<T>(entrypoint.group_name,
+                                         entrypoint.entrypoint_name, static_flags);
+          cached) {
+         return resolved_shader<T>(resolve(id, static_flags, *cached));
       }
 
-      _cache.add<T>(group_name, entrypoint_name, static_flags,
-                    {.shader = shader, .bytecode = bytecode});
-      _cache_disk_updater.mark_dirty();
+      _compile_service.compile_async(Compile_key{.stage = to_stage<T>(),
+                                                 .group = entrypoint.group_name,
+                                                 .entrypoint = entrypoint.entrypoint_name,
+                                                 .static_flags = static_flags},
+                                     entrypoint.desc);
 
-      return shader;
+      return std::nullopt;
    }
 
-   auto get_vs(const std::string_view group_name,
-               const std::string_view entrypoint_name, const std::uint64_t static_flags,
+   auto get_vs(const Entrypoint_id id, const std::uint64_t static_flags,
                const Vertex_shader_flags game_flags) noexcept
       -> std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>
    {
-      const auto& entrypoint_desc = get_entrypoint_desc(group_name, entrypoint_name);
-
-      auto vertex_input_layout =
-         entrypoint_desc.vertex_state.use_custom_input_layout
-            ? Vertex_input_layout{entrypoint_desc.vertex_state
-                                     .custom_input_layout.begin(),
-                                  entrypoint_desc.vertex_state
-                                     .custom_input_layout.end()}
-            : get_vertex_input_layout(entrypoint_desc.vertex_state.generic_input_state,
-                                      game_flags);
-
-      if (auto cached = _cache.get_vs_if(group_name, entrypoint_name,
+      if (const auto* resolved = find_resolved(id, static_flags, game_flags); resolved)
+         [[likely]] {
+         return resolved_vs(*resolved);
+      }
+
+      const auto& entrypoint = get_entrypoint(Stage::vertex, id);
+
+      if (auto cached = _cache.get_vs_if(entrypoint.group_name, entrypoint.entrypoint_name,
                                          static_flags, game_flags);
           cached) {
-         return {cached->shader, cached->bytecode, std::move(vertex_input_layout)};
+         return resolved_vs(resolve_vs(id, static_flags, game_flags, *cached));
       }
 
-      // Multithreading stuff to stop double compilation goes here.
+      _compile_service.compile_wait(Compile_key{.stage = Stage::vertex,
+                                                .group = entrypoint.group_name,
+                                                .entrypoint = entrypoint.entrypoint_name,
+                                                .static_flags = static_flags,
+                                                .game_flags = game_flags},
+                                    entrypoint.desc);
 
-      if (entrypoint_desc.stage != Stage::vertex) {
-         log_and_terminate("Shader stage mismatch for entrypoint '"sv,
-                           entrypoint_name, "' from group '"sv, group_name, "'"sv);
+      if (auto cached = _cache.get_vs_if(entrypoint.group_name, entrypoint.entrypoint_name,
+                                         static_flags, game_flags);
+          cached) {
+         return resolved_vs(resolve_vs(id, static_flags, game_flags, *cached));
       }
 
-      auto bytecode =
-         compile(_source_file_store, entrypoint_desc, static_flags, game_flags);
+      log_and_terminate("Compiled shader for entrypoint '"sv, entrypoint.entrypoint_name,
+                        "' from group '"sv, entrypoint.group_name,
+                        "' is missing from the cache!"sv);
+   }
+
+   auto get_vs_async(const Entrypoint_id id, const std::uint64_t static_flags,
+                     const Vertex_shader_flags game_flags) noexcept
+      -> std::optional<std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>>
+   {
+      if (const auto* resolved = find_resolved(id, static_flags, game_flags); resolved)
+         [[likely]] {
+         return resolved_vs(*resolved);
+      }
 
-      auto shader = create_shader<ID3D11VertexShader>(*_device, bytecode);
+      const auto& entrypoint = get_entrypoint(Stage::vertex, id);
 
-      if (!shader) {
-         log_and_terminate("Unable to recover from failed shader creation!"sv);
+      if (auto cached = _cache.get_vs_if(entrypoint.group_name, entrypoint.entrypoint_name,
+                                         static_flags, game_flags);
+          cached) {
+         return resolved_vs(resolve_vs(id, static_flags, game_flags, *cached));
       }
 
-      _cache.add_vs(group_name, entrypoint_name, static_flags, game_flags,
-                    {.shader = shader, .bytecode = bytecode});
-      _cache_disk_updater.mark_dirty();
+      _compile_service.compile_async(Compile_key{.stage = Stage::vertex,
+                                                 .group = entrypoint.group_name,
+                                                 .entrypoint = entrypoint.entrypoint_name,
+                                                 .static_flags = static_flags,
+                                                 .game_flags = game_flags},
+                                     entrypoint.desc);
 
-      return {shader, bytecode, std::move(vertex_input_layout)};
+      return std::nullopt;
    }
 
    void cache_update() noexcept
    {
-      if (_cache_disk_updater.should_update()) {
+      if (_cache_disk_updater.should_update(_cache)) {
          _cache_disk_updater.update(_cache, _file_paths.shader_cache);
       }
    }
 
    void force_cache_save_to_disk() noexcept
    {
+      _compile_service.wait_idle();
+
       _cache.save_to_file(_file_paths.shader_cache);
    }
 
@@ -370,9 +468,10 @@ public:
    {
       absl::flat_hash_map<std::string, std::unique_ptr<T>> groups;
 
-      for (const auto& [group, entrypoints] : _entrypoint_descs) {
-         for (const auto& [entrypoint_name, entrypoint] : entrypoints) {
-            if (entrypoint.stage == to_stage<typename T::shader_interface>()) {
+      for (const auto& [group, entrypoints] : _entrypoint_ids) {
+         for (const auto& [entrypoint_name, id] : entrypoints) {
+            if (_entrypoints[static_cast<std::size_t>(id)].desc.stage ==
+                to_stage<typename T::shader_interface>()) {
                groups.emplace(group, std::make_unique<T>(group, *this));
 
                break;
@@ -390,23 +489,134 @@ public:
    }
 
 private:
-   auto get_entrypoint_desc(const std::string_view group_name,
-                            const std::string_view entrypoint_name) const noexcept
-      -> const Entrypoint_description&
+   struct Interned_entrypoint {
+      std::string group_name;
+      std::string entrypoint_name;
+      Entrypoint_description desc;
+   };
+
+   // A variant of an entrypoint that has been handed out before. Added to the
+   // entrypoint's table once and never modified or removed afterwards, so
+   // repeat requests are found there instead of hashing names and taking the
+   // cache's lock.
+   struct Resolved_variant {
+      Com_ptr<ID3D11DeviceChild> shader;
+      Bytecode_blob bytecode;
+      Vertex_input_layout input_layout;
+   };
+
+   auto find_resolved(const Entrypoint_id id, const std::uint64_t static_flags,
+                      const Vertex_shader_flags game_flags = Vertex_shader_flags::none) const noexcept
+      -> const Resolved_variant*
+   {
+      return _resolved[static_cast<std::size_t>(id)].find(
+         {.static_flags = static_flags, .game_flags = game_flags});
+   }
 
+   template<typename T>
+   auto resolve(const Entrypoint_id id, const std::uint64_t static_flags,
+                const Cache_entry<T>& cached) noexcept -> const Resolved_variant&
    {
-      if (auto group = _entrypoint_descs.find(group_name);
-          group != _entrypoint_descs.end()) {
-         if (auto entrypoint = group->second.find(entrypoint_name);
-             entrypoint != group->second.end()) {
-            return entrypoint->second;
-         }
+      return _resolved[static_cast<std::size_t>(id)].insert(
+         {.static_flags = static_flags},
+         Resolved_variant{.shader = copy_raw_com_ptr(
+                             static_cast<ID3D11DeviceChild&>(*cached.shader))});
+   }
+
+   auto resolve_vs(const Entrypoint_id id, const std::uint64_t static_flags,
+                   const Vertex_shader_flags game_flags,
+                   const Cache_entry<ID3D11VertexShader>& cached) noexcept
+      -> const Resolved_variant&
+   {
+      return _resolved[static_cast<std::size_t>(id)].insert(
+         {.static_flags = static_flags, .game_flags = game_flags},
+         Resolved_variant{.shader = copy_raw_com_ptr(
+                             static_cast<ID3D11DeviceChild&>(*cached.shader)),
+                          .bytecode = cached.bytecode,
+                          .input_layout = make_vertex_input_layout(
+                             _entrypoints[static_cast<std::size_t>(id)].desc,
+                             game_flags)});
+   }
 
-         log_and_terminate("Unable to find shader entrypoint '"sv, entrypoint_name,
-                           "' in shader group '"sv, group_name, "'!"sv);
+   template<typename T>
+   static auto resolved_shader(const Resolved_variant& resolved) noexcept -> Com_ptr<T>
+   {
+      return copy_raw_com_ptr(static_cast<T&>(*resolved.shader));
+   }
+
+   static auto resolved_vs(const Resolved_variant& resolved) noexcept
+      -> std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>
+   {
+      return {resolved_shader<ID3D11VertexShader>(resolved), resolved.bytecode,
+              resolved.input_layout};
+   }
+
+   auto get_entrypoint(const Stage stage, const Entrypoint_id id) const noexcept
+      -> const Interned_entrypoint&
+   {
+      const auto& entrypoint = _entrypoints[static_cast<std::size_t>(id)];
+
+      if (entrypoint.desc.stage != stage) {
+         log_and_terminate("Shader stage mismatch for entrypoint '"sv,
+                           entrypoint.entrypoint_name, "' from group '"sv,
+                           entrypoint.group_name, "'"sv);
       }
 
-      log_and_terminate("Unable to find shader group '"sv, group_name, "'!"sv);
+      return entrypoint;
+   }
+
+   static auto make_vertex_input_layout(const Entrypoint_description& entrypoint_desc,
+                                        const Vertex_shader_flags game_flags) noexcept
+      -> Vertex_input_layout
+   {
+      return entrypoint_desc.vertex_state.use_custom_input_layout
+                ? Vertex_input_layout{entrypoint_desc.vertex_state.custom_input_layout.begin(),
+                                      entrypoint_desc.vertex_state.custom_input_layout.end()}
+                : get_vertex_input_layout(entrypoint_desc.vertex_state.generic_input_state,
+                                          game_flags);
+   }
+
+   // Called from the compile service (potentially on a worker thread) once
+   // bytecode for a variant is ready. Device object creation is free threaded.
+   void add_compiled(const Compile_key& key, const Bytecode_blob& bytecode) noexcept
+   {
+      const auto add = [&]<typename T>(T*) {
+         auto shader = create_shader<T>(*_device, bytecode);
+
+         if (!shader) {
+            log_and_terminate("Unable to recover from failed shader creation!"sv);
+         }
+
+         if constexpr (std::is_same_v<T, ID3D11VertexShader>) {
+            _cache.add_vs(key.group, key.entrypoint, key.static_flags, key.game_flags,
+                          {.shader = std::move(shader), .bytecode = bytecode});
+         }
+         else {
+            _cache.add<T>(key.group, key.entrypoint, key.static_flags,
+                          {.shader = std::move(shader), .bytecode = bytecode});
+         }
+      };
+
+      switch (key.stage) {
+      case Stage::compute:
+         add(static_cast<ID3D11ComputeShader*>(nullptr));
+         break;
+      case Stage::vertex:
+         add(static_cast<ID3D11VertexShader*>(nullptr));
+         break;
+      case Stage::hull:
+         add(static_cast<ID3D11HullShader*>(nullptr));
+         break;
+      case Stage::domain:
+         add(static_cast<ID3D11DomainShader*>(nullptr));
+         break;
+      case Stage::geometry:
+         add(static_cast<ID3D11GeometryShader*>(nullptr));
+         break;
+      case Stage::pixel:
+         add(static_cast<ID3D11PixelShader*>(nullptr));
+         break;
+      }
    }
 
    Com_ptr<ID3D11Device5> _device;
@@ -416,8 +626,22 @@ private:
    Source_file_store _source_file_store{_file_paths.shader_source_files};
    Source_file_dependency_index _source_dependency_index{_source_file_store};
 
-   absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, Entrypoint_description>> _entrypoint_descs;
+   // Interned entrypoints, indexed by Entrypoint_id. Never modified after
+   // construction so references into it are stable.
+   std::vector<Interned_entrypoint> _entrypoints;
+   absl::flat_hash_map<std::string, Entrypoint_ids> _entrypoint_ids;
+
+   // Each entrypoint's resolved variants, indexed by Entrypoint_id.
+   std::unique_ptr<Variant_table<Resolved_variant>[]> _resolved;
    absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, Rendertype_state_description>> _rendertypes_states;
+
+   D3d_compile_backend _compile_backend{_source_file_store};
+   Compile_service _compile_service{_compile_backend,
+                                    [this](const Compile_key& key,
+                                           const Bytecode_blob& bytecode) {
+                                       add_compiled(key, bytecode);
+                                    },
+                                    Compile_service::default_worker_count()};
 };
 
 Database::Database(Com_ptr<ID3D11Device5> device, Database_file_paths file_paths) noexcept
@@ -479,32 +703,47 @@ auto Database::internal() noexcept -> Database_internal&
 }
 
 Group_base::Group_base(std::string name, Database_internal& database)
-   : _name{std::move(name)}, _database{database}
+   : _name{std::move(name)},
+     _database{database},
+     _entrypoint_ids{database.entrypoint_ids(_name)}
 {
 }
 
-auto Group_base::entrypoint(const Stage stage, const std::string_view entrypoint_name,
+auto Group_base::entrypoint(const Stage stage, const Entrypoint_id id,
                             const std::uint64_t static_flags) noexcept
    -> Com_ptr<IUnknown>
 {
    switch (stage) {
    case Stage::compute:
-      return _database.get<ID3D11ComputeShader>(_name, entrypoint_name, static_flags);
+      return _database.get<ID3D11ComputeShader>(id, static_flags);
    case Stage::hull:
-      return _database.get<ID3D11HullShader>(_name, entrypoint_name, static_flags);
+      return _database.get<ID3D11HullShader>(id, static_flags);
    case Stage::domain:
-      return _database.get<ID3D11DomainShader>(_name, entrypoint_name, static_flags);
+      return _database.get<ID3D11DomainShader>(id, static_flags);
    case Stage::geometry:
-      return _database.get<ID3D11GeometryShader>(_name, entrypoint_name, static_flags);
+      return _database.get<ID3D11GeometryShader>(id, static_flags);
    case Stage::pixel:
-      return _database.get<ID3D11PixelShader>(_name, entrypoint_name, static_flags);
+      return _database.get<ID3D11PixelShader>(id, static_flags);
    default:
       std::terminate();
    }
 }
 
+auto Group_base::entrypoint_id(const std::string_view entrypoint_name) const noexcept
+   -> Entrypoint_id
+{
+   if (auto it = _entrypoint_ids.find(entrypoint_name); it != _entrypoint_ids.end()) {
+      return it->second;
+   }
+
+   log_and_terminate("Unable to find shader entrypoint '"sv, entrypoint_name,
+                     "' in shader group '"sv, _name, "'!"sv);
+}
+
 Group_vertex::Group_vertex(std::string name, Database_internal& database)
-   : _name{std::move(name)}, _database{database}
+   : _name{std::move(name)},
+     _database{database},
+     _entrypoint_ids{database.entrypoint_ids(_name)}
 {
 }
 
@@ -513,7 +752,25 @@ auto Group_vertex::entrypoint(const std::string_view entrypoint_name,
                               const Vertex_shader_flags game_flags) noexcept
    -> std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>
 {
-   return _database.get_vs(_name, entrypoint_name, static_flags, game_flags);
+   return entrypoint(entrypoint_id(entrypoint_name), static_flags, game_flags);
+}
+
+auto Group_vertex::entrypoint(const Entrypoint_id id, const std::uint64_t static_flags,
+                              const Vertex_shader_flags game_flags) noexcept
+   -> std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>
+{
+   return _database.get_vs(id, static_flags, game_flags);
+}
+
+auto Group_vertex::entrypoint_id(const std::string_view entrypoint_name) const noexcept
+   -> Entrypoint_id
+{
+   if (auto it = _entrypoint_ids.find(entrypoint_name); it != _entrypoint_ids.end()) {
+      return it->second;
+   }
+
+   log_and_terminate("Unable to find shader entrypoint '"sv, entrypoint_name,
+                     "' in shader group '"sv, _name, "'!"sv);
 }
 
 Rendertypes_database::Rendertypes_database(Database& database, const bool oit_capable) noexcept
@@ -521,11 +778,15 @@ Rendertypes_database::Rendertypes_database(Database& database, const bool oit_ca
    const auto& rendertypes_states =
       database.internal().get_shader_rendertypes_states();
 
+   for (const auto& [rendertype, states] : rendertypes_states) {
+      for (const auto& [state, desc] : states) _state_names.intern(state);
+   }
+
    _rendertypes.reserve(rendertypes_states.size());
 
    for (const auto& [rendertype, states] : rendertypes_states) {
       _rendertypes[rendertype] =
-         std::make_unique<Rendertype>(database.internal(), states, rendertype,
+         std::make_unique<Rendertype>(database.internal(), *this, states, rendertype,
                                       oit_capable);
    }
 }
@@ -540,15 +801,38 @@ auto Rendertypes_database::operator[](const std::string_view rendertype) noexcep
    log_and_terminate("Attempt to get nonexistent rendertype '"sv, rendertype, "'!"sv);
 }
 
-Rendertype::Rendertype(Database_internal& database,
+auto Rendertypes_database::state_name_id(const std::string_view state) const noexcept
+   -> std::optional<State_name_id>
+{
+   return _state_names.find(state);
+}
+
+auto Rendertypes_database::state_name(const State_name_id id) const noexcept
+   -> const std::string&
+{
+   return _state_names.name(id);
+}
+
+auto Rendertypes_database::state_name_count() const noexcept -> std::size_t
+{
+   return _state_names.size();
+}
+
+Rendertype::Rendertype(Database_internal& database, const Rendertypes_database& rendertypes,
                        const absl::flat_hash_map<std::string, Rendertype_state_description>& states,
                        std::string name, const bool oit_capable)
-   : _name{std::move(name)}
+   : _rendertypes{rendertypes}, _name{std::move(name)}
 {
    _states.reserve(states.size());
+   _states_by_id.resize(rendertypes.state_name_count());
 
    for (const auto& [state, desc] : states) {
-      _states[state] = std::make_unique<Rendertype_state>(database, desc, oit_capable);
+      auto& state_ptr = _states[state];
+
+      state_ptr = std::make_unique<Rendertype_state>(database, desc, oit_capable);
+
+      _states_by_id[static_cast<std::size_t>(*rendertypes.state_name_id(state))] =
+         state_ptr.get();
    }
 }
 
@@ -562,10 +846,37 @@ auto Rendertype::state(const std::string_view state) noexcept -> Rendertype_stat
                      "' from rendertype'"sv, _name, "'!"sv);
 }
 
+void Rendertype::state_not_found(const State_name_id state) const noexcept
+{
+   log_and_terminate("Attempt to get nonexistent state '"sv, _rendertypes.state_name(state),
+                     "' from rendertype'"sv, _name, "'!"sv);
+}
+
+auto Rendertype::find_state(const std::string_view state) noexcept -> Rendertype_state*
+{
+   if (auto it = _states.find(state); it != _states.end()) {
+      return it->second.get();
+   }
+
+   return nullptr;
+}
+
 Rendertype_state::Rendertype_state(Database_internal& database,
                                    Rendertype_state_description description,
                                    const bool oit_capable)
-   : _database{database}, _desc{std::move(description)}, _oit_capable{oit_capable}
+   : _database{database},
+     _desc{std::move(description)},
+     _vs_entrypoint{database.entrypoint_id(_desc.group_name, _desc.vs_entrypoint)},
+     _ps_entrypoint{database.entrypoint_id(_desc.group_name, _desc.ps_entrypoint)},
+     _ps_oit_entrypoint{_desc.ps_oit_entrypoint
+                           ? std::optional{database.entrypoint_id(_desc.group_name,
+                                                                  *_desc.ps_oit_entrypoint)}
+                           : std::nullopt},
+     _vs_static_flag_bits{make_static_flag_bits(_desc.vs_static_flag_names.as_span())},
+     _ps_static_flag_bits{make_static_flag_bits(_desc.ps_static_flag_names.as_span())},
+     _ps_oit_static_flag_bits{
+        make_static_flag_bits(_desc.ps_oit_static_flag_names.as_span())},
+     _oit_capable{oit_capable}
 {
 }
 
@@ -574,57 +885,78 @@ auto Rendertype_state::vertex(const Vertex_shader_flags game_flags) noexcept
 {
    if (!vertex_shader_supported(game_flags)) return {nullptr, {}, {}};
 
-   return _database.get_vs(_desc.group_name, _desc.vs_entrypoint,
-                           _desc.vs_static_flags, game_flags);
+   return get_vertex(_desc.vs_static_flags, game_flags);
 }
 
 auto Rendertype_state::pixel() noexcept -> Com_ptr<ID3D11PixelShader>
 {
-   return _database.get<ID3D11PixelShader>(_desc.group_name, _desc.ps_entrypoint,
-                                           _desc.ps_static_flags);
+   return get_pixel(_ps_entrypoint, _desc.ps_static_flags, _pixel_memo);
 }
 
 auto Rendertype_state::pixel_oit() noexcept -> Com_ptr<ID3D11PixelShader>
 {
-   if (!_oit_capable || !_desc.ps_oit_entrypoint) return nullptr;
+   if (!_oit_capable || !_ps_oit_entrypoint) return nullptr;
 
-   return _database.get<ID3D11PixelShader>(_desc.group_name, *_desc.ps_oit_entrypoint,
-                                           _desc.ps_oit_static_flags);
+   return get_pixel(*_ps_oit_entrypoint, _desc.ps_oit_static_flags, _pixel_oit_memo);
+}
+
+auto Rendertype_state::extra_static_flags(const std::span<const std::string> flag_names) const noexcept
+   -> Extra_static_flags
+{
+   return {.vs = eval_static_flags(_vs_static_flag_bits, flag_names),
+           .ps = eval_static_flags(_ps_static_flag_bits, flag_names),
+           .ps_oit = eval_static_flags(_ps_oit_static_flag_bits, flag_names)};
 }
 
 auto Rendertype_state::vertex(const Vertex_shader_flags game_flags,
-                              std::span<const std::string> extra_flags) noexcept
+                              const Extra_static_flags& extra_flags) noexcept
    -> std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>
 {
    if (!vertex_shader_supported(game_flags)) return {nullptr, {}, {}};
 
-   const auto extra_static_flags =
-      eval_static_flags(_desc.vs_static_flag_names.as_span(), extra_flags);
+   return get_vertex(_desc.vs_static_flags | extra_flags.vs, game_flags);
+}
 
-   return _database.get_vs(_desc.group_name, _desc.vs_entrypoint,
-                           _desc.vs_static_flags | extra_static_flags, game_flags);
+auto Rendertype_state::pixel(const Extra_static_flags& extra_flags) noexcept
+   -> Com_ptr<ID3D11PixelShader>
+{
+   return get_pixel(_ps_entrypoint, _desc.ps_static_flags | extra_flags.ps, _pixel_memo);
 }
 
-auto Rendertype_state::pixel(std::span<const std::string> extra_flags) noexcept
+auto Rendertype_state::pixel_oit(const Extra_static_flags& extra_flags) noexcept
    -> Com_ptr<ID3D11PixelShader>
 {
-   const auto extra_static_flags =
-      eval_static_flags(_desc.ps_static_flag_names.as_span(), extra_flags);
+   if (!_oit_capable || !_ps_oit_entrypoint) return nullptr;
 
-   return _database.get<ID3D11PixelShader>(_desc.group_name, _desc.ps_entrypoint,
-                                           _desc.ps_static_flags | extra_static_flags);
+   return get_pixel(*_ps_oit_entrypoint, _desc.ps_oit_static_flags | extra_flags.ps_oit,
+                    _pixel_oit_memo);
 }
 
-auto Rendertype_state::pixel_oit(std::span<const std::string> extra_flags) noexcept
-   -> Com_ptr<ID3D11PixelShader>
+auto Rendertype_state::vertex_async(const Vertex_shader_flags game_flags,
+                                    const Extra_static_flags& extra_flags) noexcept
+   -> std::optional<std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>>
+{
+   if (!vertex_shader_supported(game_flags)) {
+      return std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>{};
+   }
+
+   return get_vertex_async(_desc.vs_static_flags | extra_flags.vs, game_flags);
+}
+
+auto Rendertype_state::pixel_async(const Extra_static_flags& extra_flags) noexcept
+   -> std::optional<Com_ptr<ID3D11PixelShader>>
 {
-   if (!_oit_capable || !_desc.ps_oit_entrypoint) return nullptr;
+   return get_pixel_async(_ps_entrypoint, _desc.ps_static_flags | extra_flags.ps,
+                          _pixel_memo);
+}
 
-   const auto extra_static_flags =
-      eval_static_flags(_desc.ps_oit_static_flag_names.as_span(), extra_flags);
+auto Rendertype_state::pixel_oit_async(const Extra_static_flags& extra_flags) noexcept
+   -> std::optional<Com_ptr<ID3D11PixelShader>>
+{
+   if (!_oit_capable || !_ps_oit_entrypoint) return Com_ptr<ID3D11PixelShader>{};
 
-   return _database.get<ID3D11PixelShader>(_desc.group_name, *_desc.ps_oit_entrypoint,
-                                           _desc.ps_oit_static_flags | extra_static_flags);
+   return get_pixel_async(*_ps_oit_entrypoint,
+                          _desc.ps_oit_static_flags | extra_flags.ps_oit, _pixel_oit_memo);
 }
 
 bool Rendertype_state::vertex_shader_supported(const Vertex_shader_flags game_flags) const noexcept
@@ -664,19 +996,90 @@ bool Rendertype_state::vertex_shader_supported(const Vertex_shader_flags game_fl
    return true;
 }
 
-auto Rendertype_state::eval_static_flags(const std::span<const std::string> flag_names,
+auto Rendertype_state::make_static_flag_bits(const std::span<const std::string> flag_names) noexcept
+   -> Static_flag_bits
+{
+   Static_flag_bits flag_bits;
+
+   flag_bits.reserve(flag_names.size());
+
+   for (std::size_t i = 0; i < flag_names.size(); ++i) {
+      flag_bits.emplace(flag_names[i], std::uint64_t{1} << i);
+   }
+
+   return flag_bits;
+}
+
+auto Rendertype_state::eval_static_flags(const Static_flag_bits& flag_bits,
                                          const std::span<const std::string> set_flags) noexcept
    -> std::uint64_t
 {
-   std::bitset<Static_flags::max_flags> flags{};
+   std::uint64_t flags = 0;
 
-   const std::size_t flag_count = flag_names.size();
+   for (const auto& flag : set_flags) {
+      if (auto it = flag_bits.find(flag); it != flag_bits.end()) {
+         flags |= it->second;
+      }
+   }
 
-   for (std::size_t i = 0u; i < flag_count; ++i) {
-      flags[i] = std::ranges::count(set_flags, flag_names[i]) != 0;
+   return flags;
+}
+
+auto Rendertype_state::get_vertex(const std::uint64_t static_flags,
+                                  const Vertex_shader_flags game_flags) noexcept
+   -> std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>
+{
+   const auto key = std::pair{static_flags, game_flags};
+
+   if (auto it = _vertex_memo.find(key); it != _vertex_memo.end()) {
+      return it->second;
    }
 
-   return flags.to_ullong();
+   return _vertex_memo
+      .emplace(key, _database.get_vs(_vs_entrypoint, static_flags, game_flags))
+      .first->second;
+}
+
+auto Rendertype_state::get_vertex_async(const std::uint64_t static_flags,
+                                        const Vertex_shader_flags game_flags) noexcept
+   -> std::optional<std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>>
+{
+   const auto key = std::pair{static_flags, game_flags};
+
+   if (auto it = _vertex_memo.find(key); it != _vertex_memo.end()) {
+      return it->second;
+   }
+
+   auto variant = _database.get_vs_async(_vs_entrypoint, static_flags, game_flags);
+
+   if (variant) _vertex_memo.emplace(key, *variant);
+
+   return variant;
+}
+
+auto Rendertype_state::get_pixel(const Entrypoint_id entrypoint, const std::uint64_t static_flags,
+                                 absl::flat_hash_map<std::uint64_t, Com_ptr<ID3D11PixelShader>>& memo) noexcept
+   -> Com_ptr<ID3D11PixelShader>
+{
+   if (auto it = memo.find(static_flags); it != memo.end()) return it->second;
+
+   return memo
+      .emplace(static_flags, _database.get<ID3D11PixelShader>(entrypoint, static_flags))
+      .first->second;
+}
+
+auto Rendertype_state::get_pixel_async(
+   const Entrypoint_id entrypoint, const std::uint64_t static_flags,
+   absl::flat_hash_map<std::uint64_t, Com_ptr<ID3D11PixelShader>>& memo) noexcept
+   -> std::optional<Com_ptr<ID3D11PixelShader>>
+{
+   if (auto it = memo.find(static_flags); it != memo.end()) return it->second;
+
+   auto shader = _database.get_async<ID3D11PixelShader>(entrypoint, static_flags);
+
+   if (shader) memo.emplace(static_flags, *shader);
+
+   return shader;
 }
 
 }
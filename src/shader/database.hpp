@@ -5,6 +5,7 @@
 #include "common.hpp"
 #include "rendertype_state_description.hpp"
 #include "small_function.hpp"
+#include "state_names.hpp"
 #include "vertex_input_layout.hpp"
 
 #include <filesystem>
@@ -12,7 +13,10 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <absl/container/flat_hash_map.h>
 
@@ -33,6 +37,12 @@ using Group_domain = Group<ID3D11DomainShader>;
 using Group_geometry = Group<ID3D11GeometryShader>;
 using Group_pixel = Group<ID3D11PixelShader>;
 
+// Interned (group, entrypoint) name pair, assigned when shader definitions are
+// loaded.
+enum class Entrypoint_id : std::uint32_t {};
+
+using Entrypoint_ids = absl::flat_hash_map<std::string, Entrypoint_id>;
+
 template<typename T>
 concept Static_shader_flags = std::is_integral_v<T> || std::is_enum_v<T>;
 
@@ -102,13 +112,19 @@ class Group_base {
 public:
    Group_base(std::string name, Database_internal& database);
 
+   // Looks up an entrypoint's id so code requesting it repeatedly (with
+   // changing static flags for instance) can skip the name lookup.
+   auto entrypoint_id(const std::string_view entrypoint_name) const noexcept
+      -> Entrypoint_id;
+
 protected:
-   auto entrypoint(const Stage stage, const std::string_view entrypoint_name,
+   auto entrypoint(const Stage stage, const Entrypoint_id entrypoint,
                    const std::uint64_t static_flags) noexcept -> Com_ptr<IUnknown>;
 
    const std::string _name;
 
    Database_internal& _database;
+   const Entrypoint_ids& _entrypoint_ids;
 };
 
 template<typename T>
@@ -136,7 +152,20 @@ public:
    auto entrypoint(const std::string_view name,
                    const std::uint64_t static_flags = 0) noexcept -> Com_ptr<T>
    {
-      auto abstract_shader = Group_base::entrypoint(shader_stage, name, static_flags);
+      return entrypoint(entrypoint_id(name), static_flags);
+   }
+
+   template<Static_shader_flags Flags>
+   auto entrypoint(const Entrypoint_id id, const Flags static_flags = {}) noexcept
+      -> Com_ptr<T>
+   {
+      return entrypoint(id, static_cast<std::uint64_t>(static_flags));
+   }
+
+   auto entrypoint(const Entrypoint_id id, const std::uint64_t static_flags = 0) noexcept
+      -> Com_ptr<T>
+   {
+      auto abstract_shader = Group_base::entrypoint(shader_stage, id, static_flags);
 
       Com_ptr<T> shader;
 
@@ -145,6 +174,8 @@ public:
       return shader;
    }
 
+   using Group_base::entrypoint_id;
+
    auto name() const noexcept -> std::string_view
    {
       return _name;
@@ -178,6 +209,13 @@ public:
                    const Vertex_shader_flags game_flags = {}) noexcept
       -> std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>;
 
+   auto entrypoint(const Entrypoint_id id, const std::uint64_t static_flags = 0,
+                   const Vertex_shader_flags game_flags = {}) noexcept
+      -> std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>;
+
+   auto entrypoint_id(const std::string_view entrypoint_name) const noexcept
+      -> Entrypoint_id;
+
    auto name() const noexcept -> std::string_view
    {
       return _name;
@@ -187,6 +225,7 @@ private:
    const std::string _name;
 
    Database_internal& _database;
+   const Entrypoint_ids& _entrypoint_ids;
 };
 
 class Rendertype;
@@ -204,7 +243,17 @@ public:
 
    auto operator[](const std::string_view rendertype) noexcept -> Rendertype&;
 
+   // Returns std::nullopt if no rendertype has a state with the name.
+   auto state_name_id(const std::string_view state) const noexcept
+      -> std::optional<State_name_id>;
+
+   auto state_name(const State_name_id id) const noexcept -> const std::string&;
+
+   auto state_name_count() const noexcept -> std::size_t;
+
 private:
+   State_names _state_names;
+
    absl::flat_hash_map<std::string, std::unique_ptr<Rendertype>> _rendertypes;
 };
 
@@ -217,7 +266,7 @@ public:
    using iterator = Container::iterator;
    using const_iterator = Container::const_iterator;
 
-   Rendertype(Database_internal& database,
+   Rendertype(Database_internal& database, const Rendertypes_database& rendertypes,
               const absl::flat_hash_map<std::string, Rendertype_state_description>& states,
               std::string name, const bool oit_capable);
 
@@ -229,6 +278,24 @@ public:
 
    auto state(const std::string_view state) noexcept -> Rendertype_state&;
 
+   // Returns nullptr if the state does not exist.
+   auto find_state(const std::string_view state) noexcept -> Rendertype_state*;
+
+   auto state(const State_name_id state) noexcept -> Rendertype_state&
+   {
+      if (const auto index = static_cast<std::size_t>(state);
+          index < _states_by_id.size() && _states_by_id[index]) [[likely]] {
+         return *_states_by_id[index];
+      }
+
+      state_not_found(state);
+   }
+
+   auto rendertypes() const noexcept -> const Rendertypes_database&
+   {
+      return _rendertypes;
+   }
+
    auto begin() noexcept -> iterator
    {
       return _states.begin();
@@ -260,7 +327,11 @@ public:
    }
 
 private:
+   [[noreturn]] void state_not_found(const State_name_id state) const noexcept;
+
    Container _states;
+   std::vector<Rendertype_state*> _states_by_id;
+   const Rendertypes_database& _rendertypes;
    const std::string _name;
 };
 
@@ -282,12 +353,25 @@ public:
 
    auto pixel_oit() noexcept -> Com_ptr<ID3D11PixelShader>;
 
+   // Extra static flags set on top of the state's own, resolved to bits for
+   // each of the state's entrypoints. Resolve them once with
+   // extra_static_flags and hold onto them, flag names the state's
+   // entrypoints don't have are ignored.
+   struct Extra_static_flags {
+      std::uint64_t vs = 0;
+      std::uint64_t ps = 0;
+      std::uint64_t ps_oit = 0;
+   };
+
+   auto extra_static_flags(const std::span<const std::string> flag_names) const noexcept
+      -> Extra_static_flags;
+
    auto vertex(const Vertex_shader_flags game_flags,
-               std::span<const std::string> extra_flags) noexcept
+               const Extra_static_flags& extra_flags) noexcept
       -> std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>;
 
    template<State_vertex_callback Callback>
-   void vertex_copy_all(Callback&& callback, std::span<const std::string> extra_flags) noexcept
+   void vertex_copy_all(Callback&& callback, const Extra_static_flags& extra_flags) noexcept
    {
       eval_vertex_shader_variations([&](const Vertex_shader_flags flags) {
          auto [shader, bytecode, input_layout] = vertex(flags, extra_flags);
@@ -297,12 +381,66 @@ public:
       });
    }
 
-   auto pixel(std::span<const std::string> extra_flags) noexcept
+   auto pixel(const Extra_static_flags& extra_flags) noexcept
       -> Com_ptr<ID3D11PixelShader>;
 
-   auto pixel_oit(std::span<const std::string> extra_flags) noexcept
+   auto pixel_oit(const Extra_static_flags& extra_flags) noexcept
       -> Com_ptr<ID3D11PixelShader>;
 
+   // The *_async functions never block on a shader compile. If the variant is
+   // not yet compiled they queue it for compilation in the background and
+   // return std::nullopt, callers should use a fallback shader and ask again
+   // later.
+
+   auto vertex_async(const Vertex_shader_flags game_flags,
+                     const Extra_static_flags& extra_flags) noexcept
+      -> std::optional<std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>>;
+
+   template<State_vertex_callback Callback>
+   bool vertex_copy_all_async(Callback&& callback,
+                              const Extra_static_flags& extra_flags) noexcept
+   {
+      bool ready = true;
+
+      eval_vertex_shader_variations([&](const Vertex_shader_flags flags) {
+         auto variant = vertex_async(flags, extra_flags);
+
+         if (!variant) {
+            ready = false;
+
+            return;
+         }
+
+         if (!ready) return;
+
+         auto& [shader, bytecode, input_layout] = *variant;
+
+         callback(flags, std::move(shader), std::move(bytecode),
+                  std::move(input_layout));
+      });
+
+      return ready;
+   }
+
+   auto pixel_async(const Extra_static_flags& extra_flags) noexcept
+      -> std::optional<Com_ptr<ID3D11PixelShader>>;
+
+   auto pixel_oit_async(const Extra_static_flags& extra_flags) noexcept
+      -> std::optional<Com_ptr<ID3D11PixelShader>>;
+
+   // Checks if the flags are one of the vertex shader variations the state
+   // provides, that is one that vertex_copy_all would pass to its callback.
+   bool has_vertex_variation(const Vertex_shader_flags game_flags) const noexcept
+   {
+      bool found = false;
+
+      eval_vertex_shader_variations([&](const Vertex_shader_flags flags) {
+         found |= (flags == game_flags);
+      });
+
+      return found;
+   }
+
 private:
    bool vertex_shader_supported(const Vertex_shader_flags game_flags) const noexcept;
 
@@ -345,14 +483,52 @@ private:
       }
    }
 
-   static auto eval_static_flags(const std::span<const std::string> flag_names,
+   using Static_flag_bits = absl::flat_hash_map<std::string, std::uint64_t>;
+
+   static auto make_static_flag_bits(const std::span<const std::string> flag_names) noexcept
+      -> Static_flag_bits;
+
+   static auto eval_static_flags(const Static_flag_bits& flag_bits,
                                  const std::span<const std::string> set_flags) noexcept
       -> std::uint64_t;
 
+   auto get_vertex(const std::uint64_t static_flags,
+                   const Vertex_shader_flags game_flags) noexcept
+      -> std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>;
+
+   auto get_vertex_async(const std::uint64_t static_flags,
+                         const Vertex_shader_flags game_flags) noexcept
+      -> std::optional<std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>>;
+
+   auto get_pixel(const Entrypoint_id entrypoint, const std::uint64_t static_flags,
+                  absl::flat_hash_map<std::uint64_t, Com_ptr<ID3D11PixelShader>>& memo) noexcept
+      -> Com_ptr<ID3D11PixelShader>;
+
+   auto get_pixel_async(const Entrypoint_id entrypoint, const std::uint64_t static_flags,
+                        absl::flat_hash_map<std::uint64_t, Com_ptr<ID3D11PixelShader>>& memo) noexcept
+      -> std::optional<Com_ptr<ID3D11PixelShader>>;
+
    Database_internal& _database;
 
    const Rendertype_state_description _desc;
 
+   const Entrypoint_id _vs_entrypoint;
+   const Entrypoint_id _ps_entrypoint;
+   const std::optional<Entrypoint_id> _ps_oit_entrypoint;
+
+   const Static_flag_bits _vs_static_flag_bits;
+   const Static_flag_bits _ps_static_flag_bits;
+   const Static_flag_bits _ps_oit_static_flag_bits;
+
+   // Shaders this state has already resolved, keyed on their final static
+   // flags. States are only ever used from the render thread so these are
+   // read and filled without any locking.
+   absl::flat_hash_map<std::pair<std::uint64_t, Vertex_shader_flags>,
+                       std::tuple<Com_ptr<ID3D11VertexShader>, Bytecode_blob, Vertex_input_layout>>
+      _vertex_memo;
+   absl::flat_hash_map<std::uint64_t, Com_ptr<ID3D11PixelShader>> _pixel_memo;
+   absl::flat_hash_map<std::uint64_t, Com_ptr<ID3D11PixelShader>> _pixel_oit_memo;
+
    const bool _oit_capable;
 };
 
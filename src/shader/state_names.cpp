@@ -0,0 +1,45 @@
+
+#include "state_names.hpp"
+#include "../logger.hpp"
+
+#include <limits>
+
+using namespace std::literals;
+
+namespace sp::shader {
+
+auto State_names::intern(const std::string_view name) noexcept -> State_name_id
+{
+   if (auto it = _ids.find(name); it != _ids.end()) return it->second;
+
+   if (_names.size() > std::numeric_limits<std::uint16_t>::max()) {
+      log_and_terminate("Too many unique rendertype state names!"sv);
+   }
+
+   const State_name_id id{static_cast<std::uint16_t>(_names.size())};
+
+   _ids.emplace(name, id);
+   _names.emplace_back(name);
+
+   return id;
+}
+
+auto State_names::find(const std::string_view name) const noexcept
+   -> std::optional<State_name_id>
+{
+   if (auto it = _ids.find(name); it != _ids.end()) return it->second;
+
+   return std::nullopt;
+}
+
+auto State_names::name(const State_name_id id) const noexcept -> const std::string&
+{
+   return _names.at(static_cast<std::size_t>(id));
+}
+
+auto State_names::size() const noexcept -> std::size_t
+{
+   return _names.size();
+}
+
+}
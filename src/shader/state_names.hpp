@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace sp::shader {
+
+// Interned rendertype state name. Shared between all rendertypes so that a
+// game shader's state can be looked up in the rendertype of a material
+// overriding it without going through the name.
+enum class State_name_id : std::uint16_t {};
+
+class State_names {
+public:
+   // Returns the name's id, assigning it the next free one if it is new.
+   auto intern(const std::string_view name) noexcept -> State_name_id;
+
+   // Returns std::nullopt if the name has not been interned.
+   auto find(const std::string_view name) const noexcept -> std::optional<State_name_id>;
+
+   auto name(const State_name_id id) const noexcept -> const std::string&;
+
+   auto size() const noexcept -> std::size_t;
+
+private:
+   struct Hash {
+      using is_transparent = void;
+
+      auto operator()(const std::string_view name) const noexcept -> std::size_t
+      {
+         return absl::Hash<std::string_view>{}(name);
+      }
+   };
+
+   std::vector<std::string> _names;
+   absl::flat_hash_map<std::string, State_name_id, Hash, std::equal_to<>> _ids;
+};
+
+}
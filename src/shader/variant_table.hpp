@@ -0,0 +1,132 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace sp::shader {
+
+// Insert-only map from an entrypoint's variant flags to a value. Lookups take
+// no locks and can run while other threads insert. Values are never moved or
+// freed until the table is destroyed, so references to them stay valid.
+//
+// Keys are hashed into a fixed number of buckets, each a lock-free list, so
+// entrypoints with many variants (material entrypoints with lots of static
+// flags for instance) don't end up walking one long list.
+template<typename T>
+class Variant_table {
+public:
+   struct Key {
+      std::uint64_t static_flags = 0;
+      Vertex_shader_flags game_flags = Vertex_shader_flags::none;
+
+      bool operator==(const Key&) const noexcept = default;
+   };
+
+   Variant_table() = default;
+
+   ~Variant_table()
+   {
+      for (auto& bucket : _buckets) {
+         const Node* node = bucket.load(std::memory_order_acquire);
+
+         while (node) delete std::exchange(node, node->next);
+      }
+   }
+
+   Variant_table(const Variant_table&) = delete;
+   auto operator=(const Variant_table&) -> Variant_table& = delete;
+
+   Variant_table(Variant_table&&) = delete;
+   auto operator=(Variant_table&&) -> Variant_table& = delete;
+
+   auto find(const Key key) const noexcept -> const T*
+   {
+      const Node* node =
+         find_node(_buckets[bucket_index(key)].load(std::memory_order_acquire), nullptr, key);
+
+      return node ? &node->value : nullptr;
+   }
+
+   // Inserts the value unless the key is already present. Either way returns
+   // the value in the table, racing inserts of one key all get the same value.
+   auto insert(const Key key, T value) noexcept -> const T&
+   {
+      auto& head = _buckets[bucket_index(key)];
+
+      auto node = std::make_unique<Node>(key, std::move(value));
+
+      const Node* expected = head.load(std::memory_order_acquire);
+      const Node* checked_until = nullptr;
+
+      while (true) {
+         // Only the nodes published since the last check need looking at.
+         if (const Node* existing = find_node(expected, checked_until, key); existing) {
+            return existing->value;
+         }
+
+         checked_until = expected;
+         node->next = expected;
+
+         if (head.compare_exchange_weak(expected, node.get(), std::memory_order_release,
+                                        std::memory_order_acquire)) {
+            return node.release()->value;
+         }
+      }
+   }
+
+   auto size() const noexcept -> std::size_t
+   {
+      std::size_t size = 0;
+
+      for (const auto& bucket : _buckets) {
+         for (const Node* node = bucket.load(std::memory_order_acquire); node;
+              node = node->next) {
+            size += 1;
+         }
+      }
+
+      return size;
+   }
+
+private:
+   struct Node {
+      Node(const Key key, T value) noexcept : key{key}, value{std::move(value)} {}
+
+      const Key key;
+      const T value;
+      const Node* next = nullptr;
+   };
+
+   constexpr static std::size_t bucket_count_log2 = 5;
+   constexpr static std::size_t bucket_count = 1 << bucket_count_log2;
+
+   static auto bucket_index(const Key key) noexcept -> std::size_t
+   {
+      // Fibonacci hashing, static flags are dense low bits so they need mixing.
+      const std::uint64_t bits =
+         key.static_flags ^ (static_cast<std::uint64_t>(key.game_flags) << 48);
+
+      return static_cast<std::size_t>((bits * 0x9e3779b97f4a7c15ull) >>
+                                      (64 - bucket_count_log2));
+   }
+
+   static auto find_node(const Node* node, const Node* const end, const Key key) noexcept
+      -> const Node*
+   {
+      for (; node != end; node = node->next) {
+         if (node->key == key) return node;
+      }
+
+      return nullptr;
+   }
+
+   std::array<std::atomic<const Node*>, bucket_count> _buckets{};
+};
+
+}
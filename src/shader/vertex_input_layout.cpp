@@ -1,5 +1,6 @@
 
 #include "vertex_input_layout.hpp"
+#include "vertex_input_layout_dxgi.hpp"
 
 #include <exception>
 
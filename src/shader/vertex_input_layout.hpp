@@ -7,8 +7,6 @@
 
 #include <absl/container/inlined_vector.h>
 
-#include <dxgiformat.h>
-
 namespace sp::shader {
 
 struct Vertex_generic_input_state {
@@ -44,10 +42,6 @@ struct Vertex_input_element {
 
 using Vertex_input_layout = absl::InlinedVector<Vertex_input_element, 12>;
 
-auto dxgi_format_to_input_type(const DXGI_FORMAT format) noexcept -> Vertex_input_type;
-
-auto input_type_to_dxgi_format(const Vertex_input_type type) noexcept -> DXGI_FORMAT;
-
 auto get_vertex_input_layout(const Vertex_generic_input_state state,
                              const Vertex_shader_flags flags) -> Vertex_input_layout;
 
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "vertex_input_layout.hpp"
+
+#include <dxgiformat.h>
+
+namespace sp::shader {
+
+auto dxgi_format_to_input_type(const DXGI_FORMAT format) noexcept -> Vertex_input_type;
+
+auto input_type_to_dxgi_format(const Vertex_input_type type) noexcept -> DXGI_FORMAT;
+
+}
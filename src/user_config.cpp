@@ -713,6 +713,9 @@ void User_config::parse_file(const std::string& path)
    developer.use_dxgi_1_2_factory =
       config["Developer"s]["Use DXGI 1.2 Factory"s].as<bool>(developer.use_dxgi_1_2_factory);
 
+   developer.record_shader_usage =
+      config["Developer"s]["Record Shader Usage"s].as<bool>(developer.record_shader_usage);
+
    developer.shader_cache_path =
       config["Developer"s]["Shader Cache Path"s].as<std::string>();
 
@@ -860,6 +863,7 @@ void User_config::save_file(const std::string& path, const std::string& temp_pat
       write_value("Allow Event Queries", printify(developer.allow_event_queries));
       write_value("Use D3D11 Debug Layer", printify(developer.use_d3d11_debug_layer));
       write_value("Use DXGI 1.2 Factory", printify(developer.use_dxgi_1_2_factory));
+      write_value("Record Shader Usage", printify(developer.record_shader_usage));
       write_value("Shader Cache Path", printify_dynamic(developer.shader_cache_path));
       write_value("Shader Definitions Path",
                   printify_dynamic(developer.shader_definitions_path));
@@ -123,6 +123,7 @@ struct User_config {
       bool allow_event_queries = false;
       bool use_d3d11_debug_layer = false;
       bool use_dxgi_1_2_factory = false;
+      bool record_shader_usage = false;
 
       std::filesystem::path shader_cache_path =
          LR"(.\data\shaderpatch\.shader_dxbc_cache)";
@@ -0,0 +1,306 @@
+
+#include "core/async_resource_loader.hpp"
+#include "core/named_resource_table.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp::core {
+
+namespace {
+
+using Loader = Async_resource_loader<std::shared_ptr<int>>;
+
+// Loads block while the gate is closed so tests can hold them mid-load.
+class Gate {
+public:
+   void close()
+   {
+      std::scoped_lock lock{_mutex};
+
+      _open = false;
+   }
+
+   void open()
+   {
+      {
+         std::scoped_lock lock{_mutex};
+
+         _open = true;
+      }
+
+      _cv.notify_all();
+   }
+
+   void pass()
+   {
+      std::unique_lock lock{_mutex};
+
+      _waiting += 1;
+      _cv.notify_all();
+
+      _cv.wait(lock, [&] { return _open; });
+   }
+
+   void wait_for_waiting(const int count)
+   {
+      std::unique_lock lock{_mutex};
+
+      _cv.wait(lock, [&] { return _waiting >= count; });
+   }
+
+private:
+   std::mutex _mutex;
+   std::condition_variable _cv;
+   bool _open = true;
+   int _waiting = 0;
+};
+
+auto make_data(const int value) -> std::vector<std::byte>
+{
+   return {static_cast<std::byte>(value)};
+}
+
+auto retire_all(Loader& loader) -> std::vector<std::pair<Loader::Ticket, int>>
+{
+   std::vector<std::pair<Loader::Ticket, int>> retired;
+
+   loader.retire_completed([&](const Loader::Ticket ticket, std::shared_ptr<int> result) {
+      retired.emplace_back(ticket, *result);
+   });
+
+   return retired;
+}
+
+}
+
+TEST(Async_resource_loader, results_are_held_until_retired)
+{
+   Loader loader{[](std::span<const std::byte> data) {
+                    return std::make_shared<int>(static_cast<int>(data[0]));
+                 },
+                 2};
+
+   const auto first = loader.enqueue(make_data(1));
+   const auto second = loader.enqueue(make_data(2));
+
+   loader.wait_idle();
+
+   EXPECT_EQ(loader.pending_count(), 0u);
+
+   auto retired = retire_all(loader);
+
+   std::ranges::sort(retired);
+
+   ASSERT_EQ(retired.size(), 2u);
+   EXPECT_EQ(retired[0], std::pair(first, 1));
+   EXPECT_EQ(retired[1], std::pair(second, 2));
+   EXPECT_TRUE(retire_all(loader).empty());
+}
+
+TEST(Async_resource_loader, loads_inline_without_workers)
+{
+   std::thread::id load_thread;
+
+   Loader loader{[&](std::span<const std::byte> data) {
+                    load_thread = std::this_thread::get_id();
+
+                    return std::make_shared<int>(static_cast<int>(data[0]));
+                 },
+                 0};
+
+   const auto ticket = loader.enqueue(make_data(3));
+
+   EXPECT_EQ(load_thread, std::this_thread::get_id());
+   EXPECT_EQ(retire_all(loader), (std::vector{std::pair(ticket, 3)}));
+}
+
+TEST(Async_resource_loader, cancelled_queued_loads_never_run)
+{
+   Gate gate;
+   std::atomic_int loads = 0;
+
+   Loader loader{[&](std::span<const std::byte> data) {
+                    gate.pass();
+                    loads += 1;
+
+                    return std::make_shared<int>(static_cast<int>(data[0]));
+                 },
+                 1};
+
+   gate.close();
+
+   const auto running = loader.enqueue(make_data(1));
+   gate.wait_for_waiting(1);
+
+   const auto queued = loader.enqueue(make_data(2));
+
+   loader.cancel(queued);
+
+   EXPECT_EQ(loader.pending_count(), 1u);
+
+   gate.open();
+   loader.wait_idle();
+
+   EXPECT_EQ(loads, 1);
+   EXPECT_EQ(retire_all(loader), (std::vector{std::pair(running, 1)}));
+}
+
+TEST(Async_resource_loader, cancelled_running_loads_are_not_retired)
+{
+   Gate gate;
+
+   Loader loader{[&](std::span<const std::byte> data) {
+                    gate.pass();
+
+                    return std::make_shared<int>(static_cast<int>(data[0]));
+                 },
+                 1};
+
+   gate.close();
+
+   const auto ticket = loader.enqueue(make_data(1));
+   gate.wait_for_waiting(1);
+
+   loader.cancel(ticket);
+
+   gate.open();
+   loader.wait_idle();
+
+   EXPECT_TRUE(retire_all(loader).empty());
+
+   // The ticket's cancellation must not leak onto later loads.
+   const auto later = loader.enqueue(make_data(2));
+
+   loader.wait_idle();
+
+   EXPECT_EQ(retire_all(loader), (std::vector{std::pair(later, 2)}));
+}
+
+TEST(Async_resource_loader, cancelled_completed_loads_are_not_retired)
+{
+   Loader loader{[](std::span<const std::byte> data) {
+                    return std::make_shared<int>(static_cast<int>(data[0]));
+                 },
+                 1};
+
+   const auto cancelled = loader.enqueue(make_data(1));
+   const auto kept = loader.enqueue(make_data(2));
+
+   loader.wait_idle();
+   loader.cancel(cancelled);
+
+   EXPECT_EQ(retire_all(loader), (std::vector{std::pair(kept, 2)}));
+}
+
+TEST(Async_resource_loader, destroying_the_loader_mid_load_drops_its_results)
+{
+   Gate gate;
+   std::atomic_int loads = 0;
+   std::weak_ptr<int> result;
+
+   {
+      // Declared before the loader so the gate only opens once the loader is
+      // being destroyed.
+      std::jthread opener;
+
+      Loader loader{[&](std::span<const std::byte> data) {
+                       gate.pass();
+                       loads += 1;
+
+                       auto loaded = std::make_shared<int>(static_cast<int>(data[0]));
+
+                       if (data[0] == std::byte{1}) result = loaded;
+
+                       return loaded;
+                    },
+                    1};
+
+      gate.close();
+
+      loader.enqueue(make_data(1));
+      gate.wait_for_waiting(1);
+
+      for (int i = 2; i < 8; ++i) loader.enqueue(make_data(i));
+
+      opener = std::jthread{[&] {
+         std::this_thread::sleep_for(std::chrono::milliseconds{50});
+         gate.open();
+      }};
+   }
+
+   EXPECT_EQ(loads, 1);
+   EXPECT_TRUE(result.expired());
+}
+
+// How the patch uses the loader, a placeholder sits under the name until the
+// load is retired into the resource table, consumers holding onto a looked up
+// resource notice the generation change and look it up again.
+TEST(Async_resource_loader, retired_results_are_seen_after_the_generation_bump)
+{
+   Loader loader{[](std::span<const std::byte> data) {
+                    return std::make_shared<int>(static_cast<int>(data[0]));
+                 },
+                 1};
+
+   Named_resource_table<std::shared_ptr<int>> resources;
+
+   auto placeholder = std::make_shared<int>(0);
+
+   resources.insert(placeholder, "clouds");
+
+   const auto ticket = loader.enqueue(make_data(5));
+
+   struct Consumer {
+      int* resource = nullptr;
+      std::uint64_t generation = 0;
+
+      void update(Named_resource_table<std::shared_ptr<int>>& resources)
+      {
+         if (!resource || generation != resources.generation()) {
+            generation = resources.generation();
+            resource = resources.find("clouds");
+         }
+      }
+   } consumer;
+
+   consumer.update(resources);
+
+   EXPECT_EQ(consumer.resource, placeholder.get());
+
+   loader.wait_idle();
+
+   // Nothing changes until the owner retires the load.
+   consumer.update(resources);
+
+   EXPECT_EQ(consumer.resource, placeholder.get());
+
+   loader.retire_completed([&](const Loader::Ticket retired, std::shared_ptr<int> result) {
+      EXPECT_EQ(retired, ticket);
+
+      resources.insert(std::move(result), "clouds");
+   });
+
+   consumer.update(resources);
+
+   ASSERT_NE(consumer.resource, nullptr);
+   EXPECT_EQ(*consumer.resource, 5);
+
+   // And once caught up the consumer doesn't look up again.
+   const auto generation = consumer.generation;
+
+   consumer.update(resources);
+
+   EXPECT_EQ(consumer.generation, generation);
+}
+
+}
@@ -0,0 +1,84 @@
+
+#include "core/buffer_suballocator.hpp"
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace sp::core {
+
+namespace {
+
+// Allocates and frees game sized vertex and index buffers at random, keeping
+// roughly the argument's number of them alive the way a map streaming in and
+// out does.
+void buffer_suballocator_churn(benchmark::State& state)
+{
+   const auto target_live = static_cast<std::size_t>(state.range(0));
+
+   Buffer_suballocator allocator{64 << 20};
+   std::mt19937 engine{static_cast<std::uint32_t>(target_live)};
+   std::vector<Buffer_suballocator::Allocation_id> live;
+
+   live.reserve(target_live * 2);
+
+   for (auto _ : state) {
+      if (live.size() < target_live || engine() % 2 == 0) {
+         if (const auto id = allocator.allocate(64 + engine() % 16384, 16); id) {
+            live.push_back(*id);
+
+            continue;
+         }
+      }
+
+      if (live.empty()) continue;
+
+      const std::size_t index = engine() % live.size();
+
+      allocator.free(live[index]);
+      live[index] = live.back();
+      live.pop_back();
+   }
+
+   state.counters["fragmentation"] = allocator.stats().fragmentation();
+}
+
+void buffer_suballocator_defragment(benchmark::State& state)
+{
+   const auto count = static_cast<std::size_t>(state.range(0));
+
+   Buffer_suballocator allocator{64 << 20};
+   std::mt19937 engine{static_cast<std::uint32_t>(count)};
+
+   for (auto _ : state) {
+      state.PauseTiming();
+
+      std::vector<Buffer_suballocator::Allocation_id> live;
+
+      for (std::size_t i = 0; i < count; ++i) {
+         if (const auto id = allocator.allocate(64 + engine() % 16384, 16); id) {
+            live.push_back(*id);
+         }
+      }
+
+      for (std::size_t i = 0; i < live.size(); i += 2) allocator.free(live[i]);
+
+      state.ResumeTiming();
+
+      benchmark::DoNotOptimize(allocator.defragment());
+
+      state.PauseTiming();
+
+      for (std::size_t i = 1; i < live.size(); i += 2) allocator.free(live[i]);
+
+      state.ResumeTiming();
+   }
+}
+
+}
+
+BENCHMARK(buffer_suballocator_churn)->Arg(256)->Arg(4096);
+BENCHMARK(buffer_suballocator_defragment)->Arg(256)->Arg(4096);
+
+}
@@ -0,0 +1,81 @@
+
+#include "color_grading_config_block.hpp"
+
+#include "../synthetic_color_grading_configs.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace sp {
+
+namespace {
+
+// Loading a version 1 clrg chunk, every region config is parsed as YAML and
+// compiled.
+void colorgrading_load_yaml(benchmark::State& state)
+{
+   const auto configs =
+      tests::make_synthetic_colorgrading_config_yaml(static_cast<std::size_t>(
+                                                        state.range(0)),
+                                                     0);
+
+   for (auto _ : state) {
+      std::vector<Color_grading_config_block> blocks;
+      blocks.reserve(configs.size());
+
+      for (const auto& config : configs) {
+         blocks.push_back(compile_colorgrading_config(YAML::Load(config)));
+      }
+
+      benchmark::DoNotOptimize(blocks.data());
+   }
+
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Loading a version 2 clrg chunk, the blocks are range checked where they are
+// and copied out in one go.
+void colorgrading_load_blocks(benchmark::State& state)
+{
+   const auto configs =
+      tests::make_synthetic_colorgrading_config_yaml(static_cast<std::size_t>(
+                                                        state.range(0)),
+                                                     0);
+
+   std::vector<Color_grading_config_block> compiled;
+
+   for (const auto& config : configs) {
+      compiled.push_back(compile_colorgrading_config(YAML::Load(config)));
+   }
+
+   std::vector<char> chunk(compiled.size() * sizeof(Color_grading_config_block));
+
+   std::memcpy(chunk.data(), compiled.data(), chunk.size());
+
+   for (auto _ : state) {
+      const auto* const first =
+         reinterpret_cast<const Color_grading_config_block*>(chunk.data());
+      const auto* const last = first + compiled.size();
+
+      for (const auto* block = first; block != last; ++block) {
+         check_colorgrading_config_block(*block);
+      }
+
+      std::vector<Color_grading_config_block> blocks{first, last};
+
+      benchmark::DoNotOptimize(blocks.data());
+   }
+
+   state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}
+
+BENCHMARK(colorgrading_load_yaml)->ArgName("regions")->Arg(500);
+BENCHMARK(colorgrading_load_blocks)->ArgName("regions")->Arg(500);
+
+}
@@ -0,0 +1,116 @@
+
+#include "material/constant_buffer_layout.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace sp::material {
+
+namespace {
+
+constexpr std::size_t material_count = 10000;
+
+// normal_bf3.lua's layout, the most common material type.
+constexpr auto layout_string = R"(
+   float3 base_diffuse_color;
+   float  gloss_map_weight;
+   float3 base_specular_color;
+   float  specular_exponent;
+   bool   use_ao_texture;
+   bool   use_emissive_texture;
+   float  emissive_texture_scale;
+   float  emissive_power;
+   bool   use_env_map;
+   float  env_map_vis;
+   float  dynamic_normal_sign;
+   bool   use_outline_light;
+   float3 outline_light_color;
+   float  outline_light_width;
+   float  outline_light_fade;
+   float  height_scale;
+   float  parallax_scale_x;
+   bool   use_terrain_fade;
+   float3 horizon_color;
+   float  fade_start;
+   float  fade_end;
+   float  fade_power;
+   float  horizon_desaturation;
+   float  opacity_cutoff;
+   float  horizon_intensity;
+   bool   use_atmosphere_map;
+   float  atmosphere_flip_x;
+   float  atmosphere_flip_y;
+   float  atmosphere_flip_z;
+)";
+
+auto type_size(const Constant_buffer_layout::Type type) -> std::size_t
+{
+   return (static_cast<std::size_t>(type) % 4 + 1) * 4;
+}
+
+const std::array<std::byte, 16> value{};
+
+// What building a material's constant buffer cost before layouts were
+// compiled, the layout is parsed for every buffer and every field is set by
+// name.
+void build_buffers_reparsed(benchmark::State& state)
+{
+   const Constant_buffer_layout names_layout{layout_string};
+   std::vector<std::string> names;
+
+   for (const auto& field : names_layout.fields()) {
+      names.push_back(field.name);
+   }
+
+   for (auto _ : state) {
+      for (std::size_t i = 0; i < material_count; ++i) {
+         const Constant_buffer_layout layout{layout_string};
+         std::vector<std::byte> buffer{layout.defaults().begin(),
+                                       layout.defaults().end()};
+
+         for (const auto& name : names) {
+            const auto& field = layout.fields()[layout.index_of(name)];
+
+            std::memcpy(&buffer[field.offset], value.data(), type_size(field.type));
+         }
+
+         benchmark::DoNotOptimize(buffer.data());
+      }
+   }
+
+   state.SetItemsProcessed(state.iterations() * material_count);
+}
+
+// Materials fill buffers from a compiled plan, copying its defaults and
+// setting each field by index.
+void build_buffers_compiled(benchmark::State& state)
+{
+   for (auto _ : state) {
+      for (std::size_t i = 0; i < material_count; ++i) {
+         const auto layout = Constant_buffer_layout::compile(layout_string);
+         std::vector<std::byte> buffer{layout->defaults().begin(),
+                                       layout->defaults().end()};
+
+         for (const auto& field : layout->fields()) {
+            std::memcpy(&buffer[field.offset], value.data(), type_size(field.type));
+         }
+
+         benchmark::DoNotOptimize(buffer.data());
+      }
+   }
+
+   state.SetItemsProcessed(state.iterations() * material_count);
+}
+
+}
+
+BENCHMARK(build_buffers_reparsed);
+BENCHMARK(build_buffers_compiled);
+
+}
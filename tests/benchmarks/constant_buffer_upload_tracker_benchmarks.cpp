@@ -0,0 +1,112 @@
+
+#include "core/constant_buffer_upload_tracker.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace sp::core {
+
+namespace {
+
+// The size of cb::Skin, the largest of the buffers the game writes into.
+struct Skin {
+   std::array<std::array<float, 4>, 45> registers;
+};
+
+constexpr std::size_t draw_count = 4096;
+
+// A draw's worth of set_constants calls: the registers written and the values
+// they are written with. Most draws repeat the previous draw's values, as
+// consecutive draws of the same model do.
+struct Draw_constants {
+   std::uint32_t first_register;
+   std::uint32_t count;
+   float value;
+};
+
+auto make_draws(const std::uint32_t changed_percent) -> std::vector<Draw_constants>
+{
+   std::mt19937 random{0};
+   std::uniform_int_distribution<std::uint32_t> percent{0, 99};
+   std::uniform_int_distribution<std::uint32_t> bone_count{1, 15};
+
+   std::vector<Draw_constants> draws;
+   draws.reserve(draw_count);
+
+   float value = 0.0f;
+
+   for (std::size_t i = 0; i < draw_count; ++i) {
+      if (percent(random) < changed_percent) value += 1.0f;
+
+      draws.push_back({.first_register = 0, .count = bone_count(random) * 3, .value = value});
+   }
+
+   return draws;
+}
+
+void apply(Skin& skin, const Draw_constants& draw) noexcept
+{
+   for (std::uint32_t i = 0; i < draw.count; ++i) {
+      skin.registers[draw.first_register + i].fill(draw.value);
+   }
+}
+
+// Uploading on every draw, the copy stands in for the map and write of the
+// dynamic buffer.
+void cb_upload_untracked(benchmark::State& state)
+{
+   const auto draws = make_draws(static_cast<std::uint32_t>(state.range(0)));
+
+   Skin skin{};
+   Skin mapped{};
+
+   for (auto _ : state) {
+      for (const auto& draw : draws) {
+         apply(skin, draw);
+
+         std::memcpy(&mapped, &skin, sizeof(Skin));
+         benchmark::ClobberMemory();
+      }
+   }
+
+   state.SetItemsProcessed(state.iterations() * draw_count);
+}
+
+void cb_upload_tracked(benchmark::State& state)
+{
+   const auto draws = make_draws(static_cast<std::uint32_t>(state.range(0)));
+
+   Skin skin{};
+   Skin mapped{};
+   Constant_buffer_upload_tracker<Skin> tracker;
+
+   for (auto _ : state) {
+      for (const auto& draw : draws) {
+         tracker.mark(draw.first_register, draw.count);
+         apply(skin, draw);
+
+         if (tracker.needs_upload(skin)) {
+            std::memcpy(&mapped, &skin, sizeof(Skin));
+            benchmark::ClobberMemory();
+         }
+      }
+   }
+
+   state.SetItemsProcessed(state.iterations() * draw_count);
+   state.counters["skipped"] = benchmark::Counter(
+      static_cast<double>(tracker.stats().skipped),
+      benchmark::Counter::kAvgIterations);
+}
+
+}
+
+BENCHMARK(cb_upload_untracked)->ArgName("changed_percent")->Arg(5)->Arg(50)->Arg(100);
+BENCHMARK(cb_upload_tracked)->ArgName("changed_percent")->Arg(5)->Arg(50)->Arg(100);
+
+}
@@ -0,0 +1,187 @@
+
+#include "material/draw_cache.hpp"
+#include "shader/state_names.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/inlined_vector.h>
+
+#include <benchmark/benchmark.h>
+
+namespace sp::material {
+
+namespace {
+
+using shader::State_name_id;
+using shader::Vertex_shader_flags;
+
+const std::vector<std::string> state_names{"unlit",   "unlit_lightmap", "lit",
+                                           "lit_lightmap", "scrolling",  "static_lighting",
+                                           "shadow",  "zprepass"};
+
+const std::vector<Vertex_shader_flags> vs_flag_variants{
+   Vertex_shader_flags::position | Vertex_shader_flags::normal |
+      Vertex_shader_flags::texcoords,
+   Vertex_shader_flags::position | Vertex_shader_flags::normal |
+      Vertex_shader_flags::texcoords | Vertex_shader_flags::hard_skinned,
+   Vertex_shader_flags::position | Vertex_shader_flags::normal |
+      Vertex_shader_flags::texcoords | Vertex_shader_flags::color};
+
+constexpr std::uint16_t layout_count = 24;
+
+// Stands in for Shader_set's per state data, a state's vertex shaders each
+// with the input layouts created for them so far.
+struct Vertex_shader {
+   Vertex_shader_flags flags;
+   std::vector<std::pair<std::int32_t, const int*>> layouts;
+};
+
+struct State {
+   absl::InlinedVector<Vertex_shader, 4> vertex;
+};
+
+struct Draw {
+   std::string state_name;
+   State_name_id state_id;
+   Vertex_shader_flags vs_flags;
+   std::uint16_t layout_index;
+};
+
+const int input_layout = 0;
+
+auto make_state() -> State
+{
+   State state;
+
+   for (const auto flags : vs_flag_variants) {
+      auto& vs = state.vertex.emplace_back(Vertex_shader{.flags = flags, .layouts = {}});
+
+      for (std::int32_t i = 0; i < layout_count; ++i) {
+         vs.layouts.emplace_back(i, &input_layout);
+      }
+   }
+
+   return state;
+}
+
+auto find_layout(const Vertex_shader& vs, const std::uint16_t index) -> const int*
+{
+   for (const auto& [layout_index, layout] : vs.layouts) {
+      if (layout_index == index) return layout;
+   }
+
+   return nullptr;
+}
+
+auto find_vs(State& state, const Vertex_shader_flags flags) -> Vertex_shader&
+{
+   return *std::ranges::find(state.vertex, flags, &Vertex_shader::flags);
+}
+
+// A frame's worth of material draws, each material drawn a few times in a row
+// with the same state, flags and layout the way the game submits them.
+auto make_draws(const shader::State_names& names, const std::size_t repeat)
+   -> std::vector<Draw>
+{
+   std::mt19937 engine{static_cast<std::uint32_t>(repeat)};
+   std::vector<Draw> draws;
+
+   while (draws.size() < 4096) {
+      const auto& name = state_names[engine() % state_names.size()];
+      const Draw draw{.state_name = name,
+                      .state_id = *names.find(name),
+                      .vs_flags = vs_flag_variants[engine() % vs_flag_variants.size()],
+                      .layout_index =
+                         static_cast<std::uint16_t>(engine() % layout_count)};
+
+      draws.insert(draws.end(), repeat, draw);
+   }
+
+   return draws;
+}
+
+void draw_loop_cached(benchmark::State& benchmark_state)
+{
+   struct Resolved {
+      const int* input_layout = nullptr;
+   };
+
+   shader::State_names names;
+
+   for (const auto& name : state_names) names.intern(name);
+
+   std::vector<std::optional<State>> states(names.size());
+   Draw_cache<Resolved> last_draw;
+
+   const auto draws =
+      make_draws(names, static_cast<std::size_t>(benchmark_state.range(0)));
+
+   for (auto _ : benchmark_state) {
+      for (const auto& draw : draws) {
+         const Draw_key key{.state_id = draw.state_id,
+                            .vs_flags = draw.vs_flags,
+                            .layout_index = draw.layout_index};
+
+         const Resolved* resolved = last_draw.find(key);
+
+         if (!resolved) {
+            auto& state = states[static_cast<std::size_t>(draw.state_id)];
+
+            if (!state) state.emplace(make_state());
+
+            resolved = &last_draw.store(key,
+                                        {.input_layout =
+                                            find_layout(find_vs(*state, draw.vs_flags),
+                                                        draw.layout_index)},
+                                        true);
+         }
+
+         benchmark::DoNotOptimize(resolved->input_layout);
+      }
+   }
+
+   benchmark_state.SetItemsProcessed(benchmark_state.iterations() * draws.size());
+}
+
+// Shader_set::update before state names were interned, every draw looks its
+// state up by name and then searches for its flags and layout.
+void draw_loop_name_keyed(benchmark::State& benchmark_state)
+{
+   shader::State_names names;
+
+   for (const auto& name : state_names) names.intern(name);
+
+   absl::flat_hash_map<std::string, State> states;
+
+   const auto draws =
+      make_draws(names, static_cast<std::size_t>(benchmark_state.range(0)));
+
+   for (auto _ : benchmark_state) {
+      for (const auto& draw : draws) {
+         auto state = states.find(draw.state_name);
+
+         if (state == states.end()) {
+            state = states.emplace(draw.state_name, make_state()).first;
+         }
+
+         benchmark::DoNotOptimize(
+            find_layout(find_vs(state->second, draw.vs_flags), draw.layout_index));
+      }
+   }
+
+   benchmark_state.SetItemsProcessed(benchmark_state.iterations() * draws.size());
+}
+
+}
+
+BENCHMARK(draw_loop_cached)->Arg(1)->Arg(4)->Arg(16);
+BENCHMARK(draw_loop_name_keyed)->Arg(1)->Arg(4)->Arg(16);
+
+}
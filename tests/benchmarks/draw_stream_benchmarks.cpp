@@ -0,0 +1,111 @@
+
+#include "core/draw_stream_replayer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace sp::core {
+
+namespace {
+
+// A heavy capture, frames of thousands of draws each rebinding buffers,
+// states, textures and draw constants the way the game does with some of the
+// binds repeating the previous draw's.
+auto record_frames(const std::uint32_t frame_count) -> std::vector<std::byte>
+{
+   using namespace draw_stream;
+
+   std::mt19937 engine{frame_count};
+   Draw_stream_recorder recorder{frame_count};
+
+   std::vector<int> objects(256);
+   const auto object = [&] {
+      return recorder.object(&objects[engine() % objects.size()]);
+   };
+
+   std::array<std::byte, 256> constants{};
+
+   for (std::uint32_t frame = 0; frame < frame_count; ++frame) {
+      recorder.record(Clear_rendertarget{.color = {0.0f, 0.0f, 0.0f, 1.0f}});
+      recorder.record_constants(Draw_stream_cb::scene, 0, constants);
+
+      for (int i = 0; i < 4096; ++i) {
+         recorder.record(
+            Set_vertex_buffer{.buffer = object(), .offset = 0, .stride = 32});
+         recorder.record(Set_index_buffer{.buffer = object(), .offset = 0});
+         recorder.record(Set_input_layout{.layout_index = static_cast<std::uint16_t>(
+                                             engine() % 16),
+                                          .compressed_position = true,
+                                          .compressed_texcoords = true,
+                                          .has_vertex_weights = false});
+         recorder.record(Set_patch_material{.material = object()});
+         recorder.record(Set_blend_state{.state = object(), .additive_blending = false});
+
+         for (std::uint8_t slot = 0; slot < 4; ++slot) {
+            recorder.record(
+               Set_texture{.slot = slot, .texture = object(), .rendertarget = -1});
+         }
+
+         constants[engine() % 64] = static_cast<std::byte>(engine());
+
+         recorder.record_constants(Draw_stream_cb::draw, 0,
+                                   std::span{constants}.first(64));
+         recorder.record(Draw_indexed{.topology = 4,
+                                      .index_count = 96,
+                                      .start_index = 0,
+                                      .base_vertex = 0});
+      }
+
+      recorder.record(Present{});
+   }
+
+   return recorder.stream();
+}
+
+void replay_counting(benchmark::State& benchmark_state)
+{
+   const auto stream =
+      record_frames(static_cast<std::uint32_t>(benchmark_state.range(0)));
+
+   std::uint64_t draws = 0;
+
+   for (auto _ : benchmark_state) {
+      Counting_draw_stream_target target;
+
+      draws += replay_draw_stream(stream, target).draws;
+
+      benchmark::DoNotOptimize(target.redundant());
+   }
+
+   benchmark_state.SetItemsProcessed(static_cast<std::int64_t>(draws));
+   benchmark_state.SetBytesProcessed(benchmark_state.iterations() *
+                                     static_cast<std::int64_t>(stream.size()));
+}
+
+void read_stream(benchmark::State& benchmark_state)
+{
+   const auto stream =
+      record_frames(static_cast<std::uint32_t>(benchmark_state.range(0)));
+
+   for (auto _ : benchmark_state) {
+      Draw_stream_reader reader{stream};
+
+      while (const auto record = reader.next()) benchmark::DoNotOptimize(record->op);
+   }
+
+   benchmark_state.SetBytesProcessed(benchmark_state.iterations() *
+                                     static_cast<std::int64_t>(stream.size()));
+}
+
+}
+
+BENCHMARK(replay_counting)->Arg(1)->Arg(8);
+BENCHMARK(read_stream)->Arg(1)->Arg(8);
+
+}
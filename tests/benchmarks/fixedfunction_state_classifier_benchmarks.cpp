@@ -0,0 +1,83 @@
+
+#include "direct3d/fixedfunction_state_classifier.hpp"
+
+#include "../synthetic_fixedfunction_states.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace sp::d3d9 {
+
+namespace {
+
+constexpr std::size_t draw_count = 4096;
+
+auto draws() -> const std::vector<tests::Fixedfunction_draw>&
+{
+   static const auto draws = tests::make_fixedfunction_draws(draw_count, 0);
+
+   return draws;
+}
+
+void fixedfunction_classify_reference(benchmark::State& state)
+{
+   for (auto _ : state) {
+      for (const auto& draw : draws()) {
+         benchmark::DoNotOptimize(
+            tests::classify_fixedfunction_reference(draw.values, draw.texture_factor));
+      }
+   }
+
+   state.SetItemsProcessed(state.iterations() * draw_count);
+}
+
+void fixedfunction_classify(benchmark::State& state)
+{
+   for (auto _ : state) {
+      for (const auto& draw : draws()) {
+         benchmark::DoNotOptimize(classify_fixedfunction_state(make_fixedfunction_state_key(
+            draw.values, classify_texture_factor(draw.texture_factor))));
+      }
+   }
+
+   state.SetItemsProcessed(state.iterations() * draw_count);
+}
+
+// As Texture_stage_state_manager does, only classifying again when a stage
+// value or the texture factor class has changed since the last draw.
+void fixedfunction_classify_memoized(benchmark::State& state)
+{
+   for (auto _ : state) {
+      const Fixedfunction_stage_values* classified_values = nullptr;
+      auto classified_factor = Texture_factor_class::other;
+      auto shader = Fixedfunction_shader::unknown;
+
+      for (const auto& draw : draws()) {
+         const auto factor = classify_texture_factor(draw.texture_factor);
+
+         if (!classified_values ||
+             std::memcmp(classified_values, &draw.values, sizeof(draw.values)) != 0 ||
+             factor != classified_factor) {
+            shader = classify_fixedfunction_state(
+               make_fixedfunction_state_key(draw.values, factor));
+            classified_values = &draw.values;
+            classified_factor = factor;
+         }
+
+         benchmark::DoNotOptimize(shader);
+      }
+   }
+
+   state.SetItemsProcessed(state.iterations() * draw_count);
+}
+
+}
+
+BENCHMARK(fixedfunction_classify_reference);
+BENCHMARK(fixedfunction_classify);
+BENCHMARK(fixedfunction_classify_memoized);
+
+}
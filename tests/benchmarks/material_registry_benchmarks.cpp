@@ -0,0 +1,64 @@
+
+#include "material/material_registry.hpp"
+
+#include "../synthetic_materials.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace sp::material {
+
+namespace {
+
+// Stands in for a built material, building one is what sharing saves.
+struct Fake_material {
+   std::vector<std::byte> constants = std::vector<std::byte>(256);
+};
+
+// Loads and then unloads every material of a set of levels. The blob count and
+// the materials actually built are reported so the dedup ratio can be read off.
+void load_synthetic_levels(benchmark::State& benchmark_state)
+{
+   const auto blobs =
+      tests::make_synthetic_levels(static_cast<std::size_t>(benchmark_state.range(0)),
+                                   256, 128);
+
+   std::size_t builds = 0;
+
+   for (auto _ : benchmark_state) {
+      Basic_material_registry<Fake_material> registry;
+      std::vector<Fake_material*> loaded;
+
+      builds = 0;
+
+      for (const auto& blob : blobs) {
+         auto* material = registry.acquire(blob);
+
+         if (!material) {
+            material = registry.insert(blob, std::make_unique<Fake_material>());
+            builds += 1;
+         }
+
+         loaded.push_back(material);
+      }
+
+      for (auto* material : loaded) benchmark::DoNotOptimize(registry.release(material));
+   }
+
+   benchmark_state.SetItemsProcessed(benchmark_state.iterations() *
+                                     static_cast<std::int64_t>(blobs.size()));
+   benchmark_state.counters["blobs"] = static_cast<double>(blobs.size());
+   benchmark_state.counters["built"] = static_cast<double>(builds);
+   benchmark_state.counters["dedup_ratio"] =
+      static_cast<double>(blobs.size()) / static_cast<double>(builds);
+}
+
+}
+
+BENCHMARK(load_synthetic_levels)->Arg(1)->Arg(4)->Arg(16);
+
+}
@@ -0,0 +1,103 @@
+
+#include "effects/profile_trace.hpp"
+
+#include <barrier>
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+namespace sp::effects {
+
+namespace {
+
+constexpr std::size_t events_per_frame = 4096;
+
+auto make_frame(Profile_section_names& names) -> std::vector<Profile_event>
+{
+   std::vector<Profile_event> events;
+   events.reserve(events_per_frame);
+
+   for (std::size_t i = 0; i < events_per_frame; ++i) {
+      const auto begin_ns = static_cast<std::uint64_t>(i) * 1000;
+
+      events.push_back({.section = names.intern(fmt::format("Section {}", i % 64)),
+                        .timeline = i % 2 ? Profile_timeline::gpu : Profile_timeline::cpu,
+                        .depth = static_cast<std::uint16_t>(i % 4),
+                        .thread = 0,
+                        .begin_ns = begin_ns,
+                        .end_ns = begin_ns + 750});
+   }
+
+   return events;
+}
+
+std::optional<Profile_event_buffer> shared_buffer;
+std::optional<std::barrier<>> frame_end;
+
+void setup_event_buffer(const benchmark::State& state)
+{
+   shared_buffer.emplace(events_per_frame);
+   frame_end.emplace(state.threads());
+}
+
+// One frame's worth of events pushed from state.threads() threads at once,
+// the buffer is cleared between frames once every thread is done pushing.
+void event_buffer_push(benchmark::State& state)
+{
+   const std::size_t per_thread = events_per_frame / state.threads();
+   const Profile_event event{.section = Profile_section_id{0},
+                             .timeline = Profile_timeline::cpu,
+                             .depth = 0,
+                             .thread = profile_thread_index(),
+                             .begin_ns = 0,
+                             .end_ns = 1};
+
+   for (auto _ : state) {
+      for (std::size_t i = 0; i < per_thread; ++i) shared_buffer->push(event);
+
+      frame_end->arrive_and_wait();
+
+      if (state.thread_index() == 0) shared_buffer->clear();
+
+      frame_end->arrive_and_wait();
+   }
+
+   if (state.thread_index() == 0 && shared_buffer->dropped() != 0) {
+      state.SkipWithError("Events were dropped.");
+   }
+
+   state.SetItemsProcessed(state.iterations() * per_thread);
+}
+
+void chrome_trace_export(benchmark::State& state)
+{
+   Profile_section_names names;
+
+   const auto frame = make_frame(names);
+   const auto frame_count = static_cast<std::uint32_t>(state.range(0));
+
+   Profile_trace_capture capture{frame_count};
+
+   for (std::uint32_t i = 0; i < frame_count; ++i) capture.add_frame(frame);
+
+   for (auto _ : state) {
+      std::ostringstream out;
+
+      capture.write_chrome_trace(out, names);
+
+      benchmark::DoNotOptimize(out.tellp());
+   }
+
+   state.SetItemsProcessed(state.iterations() * capture.event_count());
+}
+
+}
+
+BENCHMARK(event_buffer_push)->Setup(setup_event_buffer)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(chrome_trace_export)->Arg(1)->Arg(60);
+
+}
@@ -0,0 +1,81 @@
+
+#include "terrain_file.hpp"
+
+#include "../synthetic_terrain.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace sp {
+
+namespace {
+
+using tests::Float3;
+
+// A 1024x1024 terrain using its full extents, the largest the game supports.
+auto large_terrain() -> const std::vector<std::byte>&
+{
+   static const auto bytes = tests::make_synthetic_terrain(
+      {.terrain_length = 1024, .half_extent = 512, .prelit = true, .seed = 0});
+
+   return bytes;
+}
+
+auto identity_remap() -> std::array<std::uint8_t, 16>
+{
+   std::array<std::uint8_t, 16> remap;
+
+   std::iota(remap.begin(), remap.end(), std::uint8_t{0});
+
+   return remap;
+}
+
+void terrain_decode_reference(benchmark::State& state)
+{
+   const auto file = parse_terrain_file(large_terrain());
+   const auto remap = identity_remap();
+
+   for (auto _ : state) {
+      auto terrain = tests::decode_reference_terrain(file, Float3{}, remap);
+
+      benchmark::DoNotOptimize(terrain.position.data());
+   }
+
+   state.SetItemsProcessed(state.iterations() * file.length() * file.length());
+}
+
+void terrain_decode(benchmark::State& state)
+{
+   const auto file = parse_terrain_file(large_terrain());
+   const auto remap = identity_remap();
+   const std::size_t texel_count = file.length() * file.length();
+
+   for (auto _ : state) {
+      std::vector<Float3> position(texel_count);
+      std::vector<Float3> color(texel_count);
+      std::vector<Float3> diffuse_lighting(texel_count);
+      std::vector<std::array<float, 16>> texture_weights(texel_count);
+
+      decode_terrain_heights(file, Float3{}, std::span{position});
+      decode_terrain_colors(file, std::span{color});
+      decode_terrain_diffuse_lighting(file, std::span{diffuse_lighting});
+      decode_terrain_texture_weights(file, remap, texture_weights);
+
+      benchmark::DoNotOptimize(position.data());
+   }
+
+   state.SetItemsProcessed(state.iterations() * texel_count);
+}
+
+}
+
+BENCHMARK(terrain_decode_reference)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(terrain_decode)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}
@@ -0,0 +1,120 @@
+
+#include "shader/variant_table.hpp"
+
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <benchmark/benchmark.h>
+
+namespace sp::shader {
+
+namespace {
+
+auto random_flags(const std::size_t count) -> std::vector<std::uint64_t>
+{
+   std::mt19937_64 engine{count};
+   std::vector<std::uint64_t> flags;
+
+   for (std::size_t i = 0; i < count; ++i) flags.push_back(engine() & 0xffff);
+
+   return flags;
+}
+
+// How a repeat shader request was found before entrypoints were interned, the
+// group and entrypoint names are hashed and the cache's lock taken each time.
+struct Name_keyed_cache {
+   struct Key {
+      std::string group;
+      std::string entrypoint;
+      std::uint64_t static_flags;
+
+      template<typename H>
+      friend H AbslHashValue(H h, const Key& key)
+      {
+         return H::combine(std::move(h), key.group, key.entrypoint, key.static_flags);
+      }
+
+      bool operator==(const Key&) const noexcept = default;
+
+      bool operator==(const std::tuple<const std::string_view&, const std::string_view&,
+                                       const std::uint64_t&>& right) const noexcept
+      {
+         return std::tie(group, entrypoint, static_flags) == right;
+      }
+   };
+
+   struct Hash_transparent {
+      using is_transparent = void;
+
+      template<typename T>
+      auto operator()(const T& t) const noexcept -> std::size_t
+      {
+         return absl::Hash<T>{}(t);
+      }
+   };
+
+   auto find(const std::string_view group, const std::string_view entrypoint,
+             const std::uint64_t static_flags) const noexcept -> const std::uint64_t*
+   {
+      std::shared_lock lock{mutex};
+
+      const auto it = map.find(std::tie(group, entrypoint, static_flags));
+
+      return it != map.end() ? &it->second : nullptr;
+   }
+
+   mutable std::shared_mutex mutex;
+   absl::flat_hash_map<Key, std::uint64_t, Hash_transparent, std::equal_to<>> map;
+};
+
+void variant_table_lookup(benchmark::State& state)
+{
+   const auto flags = random_flags(static_cast<std::size_t>(state.range(0)));
+
+   Variant_table<std::uint64_t> table;
+
+   for (const auto& static_flags : flags) table.insert({.static_flags = static_flags}, static_flags);
+
+   std::size_t i = 0;
+
+   for (auto _ : state) {
+      benchmark::DoNotOptimize(table.find({.static_flags = flags[i]}));
+
+      i = (i + 1) % flags.size();
+   }
+}
+
+void name_keyed_lookup(benchmark::State& state)
+{
+   using namespace std::literals;
+
+   const auto flags = random_flags(static_cast<std::size_t>(state.range(0)));
+
+   Name_keyed_cache cache;
+
+   for (const auto& static_flags : flags) {
+      cache.map.emplace(Name_keyed_cache::Key{"normal_ext", "main_opaque_ps", static_flags},
+                        static_flags);
+   }
+
+   std::size_t i = 0;
+
+   for (auto _ : state) {
+      benchmark::DoNotOptimize(cache.find("normal_ext"sv, "main_opaque_ps"sv, flags[i]));
+
+      i = (i + 1) % flags.size();
+   }
+}
+
+}
+
+BENCHMARK(variant_table_lookup)->Arg(1)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK(name_keyed_lookup)->Arg(1)->Arg(16)->Arg(256)->Arg(4096);
+
+}
@@ -0,0 +1,133 @@
+
+#include "vertex_buffer_codec.hpp"
+
+#include "../synthetic_vertex_buffer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace sp {
+
+namespace {
+
+using tests::Vertex_buffer;
+
+// A large skinned and normal mapped segment, the layout the munge spends most
+// of its time converting.
+constexpr std::size_t vertex_count = 65536;
+
+const tests::Position_decompress pos_decompress{.low = {-64.0f, -64.0f, -64.0f},
+                                                .mul = {128.0f, 128.0f, 128.0f}};
+const tests::Position_compress pos_compress{.min = {-64.0f, -64.0f, -64.0f},
+                                            .div = {128.0f, 128.0f, 128.0f}};
+
+auto skinned_flags(const bool compressed) -> Vbuf_flags
+{
+   auto flags = Vbuf_flags::position | Vbuf_flags::blendindices |
+                Vbuf_flags::blendweight | Vbuf_flags::normal | Vbuf_flags::tangents |
+                Vbuf_flags::texcoords;
+
+   if (compressed) {
+      flags |= Vbuf_flags::position_compressed | Vbuf_flags::blendinfo_compressed |
+               Vbuf_flags::normal_compressed | Vbuf_flags::texcoord_compressed;
+   }
+
+   return flags;
+}
+
+auto skinned_vertex_buffer() -> const Vertex_buffer&
+{
+   static const Vertex_buffer buffer = [] {
+      auto buffer = tests::make_synthetic_vertex_buffer(vertex_count, 0);
+
+      buffer.colors = nullptr;
+      buffer.static_lighting_colors = nullptr;
+
+      return buffer;
+   }();
+
+   return buffer;
+}
+
+void vbuf_decode_reference(benchmark::State& state)
+{
+   const auto flags = skinned_flags(state.range(0) != 0);
+   const auto bytes =
+      tests::make_synthetic_vbuf(get_vbuf_stride(flags) * vertex_count, 0);
+
+   for (auto _ : state) {
+      auto decoded =
+         tests::reference_vbuf::decode(flags, bytes.data(), vertex_count, pos_decompress);
+
+      benchmark::DoNotOptimize(decoded.first.positions.get());
+   }
+
+   state.SetItemsProcessed(state.iterations() * vertex_count);
+   state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+void vbuf_decode(benchmark::State& state)
+{
+   const auto flags = skinned_flags(state.range(0) != 0);
+   const auto stride = get_vbuf_stride(flags);
+   const auto bytes = tests::make_synthetic_vbuf(stride * vertex_count, 0);
+
+   for (auto _ : state) {
+      Vertex_buffer decoded{vertex_count, flags};
+
+      decode_vbuf_vertices(flags,
+                           {.data = bytes.data(), .count = vertex_count, .stride = stride},
+                           pos_decompress, decoded);
+
+      benchmark::DoNotOptimize(decoded.positions.get());
+   }
+
+   state.SetItemsProcessed(state.iterations() * vertex_count);
+   state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+void vbuf_encode_reference(benchmark::State& state)
+{
+   const auto& buffer = skinned_vertex_buffer();
+   const auto flags = get_vbuf_flags(buffer, state.range(0) != 0);
+
+   for (auto _ : state) {
+      auto bytes = tests::reference_vbuf::encode(buffer, flags, pos_compress);
+
+      benchmark::DoNotOptimize(bytes.data());
+   }
+
+   state.SetItemsProcessed(state.iterations() * vertex_count);
+   state.SetBytesProcessed(state.iterations() * get_vbuf_stride(flags) * vertex_count);
+}
+
+void vbuf_encode(benchmark::State& state)
+{
+   const auto& buffer = skinned_vertex_buffer();
+   const auto flags = get_vbuf_flags(buffer, state.range(0) != 0);
+   const auto stride = get_vbuf_stride(flags);
+
+   for (auto _ : state) {
+      std::vector<std::byte> bytes(stride * vertex_count);
+
+      encode_vbuf_vertices(buffer, flags, pos_compress,
+                           {.data = bytes.data(), .count = vertex_count, .stride = stride});
+
+      benchmark::DoNotOptimize(bytes.data());
+   }
+
+   state.SetItemsProcessed(state.iterations() * vertex_count);
+   state.SetBytesProcessed(state.iterations() * stride * vertex_count);
+}
+
+}
+
+BENCHMARK(vbuf_decode_reference)->ArgName("compressed")->Arg(0)->Arg(1);
+BENCHMARK(vbuf_decode)->ArgName("compressed")->Arg(0)->Arg(1);
+BENCHMARK(vbuf_encode_reference)->ArgName("compressed")->Arg(0)->Arg(1);
+BENCHMARK(vbuf_encode)->ArgName("compressed")->Arg(0)->Arg(1);
+
+}
@@ -0,0 +1,317 @@
+
+#include "core/buffer_suballocator.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp::core {
+
+namespace {
+
+using Allocation_id = Buffer_suballocator::Allocation_id;
+
+// Checks the live allocations are in bounds, aligned and don't overlap, and
+// that the stats agree with them.
+void expect_consistent(const Buffer_suballocator& allocator,
+                       const std::vector<Allocation_id>& live, const std::uint32_t alignment)
+{
+   struct Range {
+      std::uint32_t offset;
+      std::uint32_t size;
+   };
+
+   std::vector<Range> ranges;
+   std::uint32_t used = 0;
+
+   for (const auto id : live) {
+      ranges.push_back({allocator.offset(id), allocator.size(id)});
+      used += allocator.size(id);
+
+      EXPECT_EQ(allocator.offset(id) % alignment, 0u);
+      EXPECT_LE(allocator.offset(id) + allocator.size(id), allocator.capacity());
+   }
+
+   std::ranges::sort(ranges, {}, &Range::offset);
+
+   for (std::size_t i = 1; i < ranges.size(); ++i) {
+      EXPECT_LE(ranges[i - 1].offset + ranges[i - 1].size, ranges[i].offset);
+   }
+
+   const auto stats = allocator.stats();
+
+   EXPECT_EQ(stats.used, used);
+   EXPECT_EQ(stats.allocation_count, live.size());
+   EXPECT_LE(stats.largest_free_block, stats.capacity - stats.used);
+}
+
+}
+
+TEST(Buffer_suballocator, allocations_are_packed_from_the_start)
+{
+   Buffer_suballocator allocator{1024};
+
+   const auto a = allocator.allocate(100, 1);
+   const auto b = allocator.allocate(200, 1);
+
+   ASSERT_TRUE(a && b);
+   EXPECT_EQ(allocator.offset(*a), 0u);
+   EXPECT_EQ(allocator.offset(*b), 100u);
+   EXPECT_EQ(allocator.size(*b), 200u);
+
+   const auto stats = allocator.stats();
+
+   EXPECT_EQ(stats.used, 300u);
+   EXPECT_EQ(stats.allocation_count, 2u);
+   EXPECT_EQ(stats.largest_free_block, 724u);
+   EXPECT_EQ(stats.free_block_count, 1u);
+}
+
+TEST(Buffer_suballocator, freed_neighbours_coalesce)
+{
+   Buffer_suballocator allocator{1024};
+
+   const auto a = *allocator.allocate(256, 1);
+   const auto b = *allocator.allocate(256, 1);
+   const auto c = *allocator.allocate(256, 1);
+
+   allocator.free(a);
+   allocator.free(c);
+
+   // Two holes, the one at the start and the one from c merged with the tail.
+   EXPECT_EQ(allocator.stats().free_block_count, 2u);
+   EXPECT_EQ(allocator.stats().largest_free_block, 512u);
+
+   allocator.free(b);
+
+   EXPECT_TRUE(allocator.empty());
+   EXPECT_EQ(allocator.stats().free_block_count, 1u);
+   EXPECT_EQ(allocator.stats().largest_free_block, 1024u);
+   EXPECT_EQ(allocator.stats().fragmentation(), 0.0f);
+}
+
+TEST(Buffer_suballocator, allocation_picks_the_best_fitting_block)
+{
+   Buffer_suballocator allocator{1024};
+
+   const auto a = *allocator.allocate(300, 1);
+   allocator.allocate(16, 1);
+   const auto c = *allocator.allocate(100, 1);
+   allocator.allocate(16, 1);
+
+   allocator.free(a);
+   allocator.free(c);
+
+   const auto d = allocator.allocate(90, 1);
+
+   ASSERT_TRUE(d);
+   EXPECT_EQ(allocator.offset(*d), 316u);
+}
+
+TEST(Buffer_suballocator, offsets_are_aligned)
+{
+   Buffer_suballocator allocator{4096};
+
+   std::vector<Allocation_id> live;
+
+   for (const std::uint32_t alignment : {1u, 4u, 16u, 256u, 64u, 2u}) {
+      const auto id = allocator.allocate(7, alignment);
+
+      ASSERT_TRUE(id);
+      EXPECT_EQ(allocator.offset(*id) % alignment, 0u);
+
+      live.push_back(*id);
+   }
+
+   expect_consistent(allocator, live, 1);
+}
+
+TEST(Buffer_suballocator, alignment_padding_is_returned_as_free_space)
+{
+   Buffer_suballocator allocator{1024};
+
+   allocator.allocate(10, 1);
+   const auto aligned = allocator.allocate(16, 256);
+
+   ASSERT_TRUE(aligned);
+   EXPECT_EQ(allocator.offset(*aligned), 256u);
+
+   // The padding between 10 and 256 can still be allocated from.
+   const auto small = allocator.allocate(200, 1);
+
+   ASSERT_TRUE(small);
+   EXPECT_EQ(allocator.offset(*small), 10u);
+}
+
+TEST(Buffer_suballocator, fails_once_exhausted)
+{
+   Buffer_suballocator allocator{256};
+
+   EXPECT_FALSE(allocator.allocate(0, 1));
+   EXPECT_FALSE(allocator.allocate(257, 1));
+
+   std::vector<Allocation_id> live;
+
+   for (int i = 0; i < 4; ++i) live.push_back(*allocator.allocate(64, 1));
+
+   EXPECT_FALSE(allocator.allocate(1, 1));
+
+   allocator.free(live[1]);
+
+   EXPECT_FALSE(allocator.allocate(65, 1));
+   EXPECT_TRUE(allocator.allocate(64, 1));
+}
+
+TEST(Buffer_suballocator, fails_when_only_fragmented_space_is_left)
+{
+   Buffer_suballocator allocator{1024};
+
+   std::vector<Allocation_id> live;
+
+   for (int i = 0; i < 16; ++i) live.push_back(*allocator.allocate(64, 1));
+
+   for (int i = 0; i < 16; i += 2) allocator.free(live[i]);
+
+   EXPECT_EQ(allocator.stats().used, 512u);
+   EXPECT_EQ(allocator.stats().largest_free_block, 64u);
+   EXPECT_FLOAT_EQ(allocator.stats().fragmentation(), 1.0f - 64.0f / 512.0f);
+   EXPECT_FALSE(allocator.allocate(128, 1));
+}
+
+TEST(Buffer_suballocator, ids_are_reused_after_free)
+{
+   Buffer_suballocator allocator{1024};
+
+   const auto a = *allocator.allocate(64, 1);
+
+   allocator.free(a);
+
+   EXPECT_EQ(*allocator.allocate(32, 1), a);
+   EXPECT_EQ(allocator.size(a), 32u);
+}
+
+TEST(Buffer_suballocator, stays_consistent_through_churn)
+{
+   constexpr std::uint32_t alignment = 16;
+
+   Buffer_suballocator allocator{1 << 20};
+   std::mt19937 engine{7};
+   std::vector<Allocation_id> live;
+   std::size_t failed = 0;
+
+   for (int i = 0; i < 20000; ++i) {
+      if (live.empty() || engine() % 5 < 3) {
+         const std::uint32_t size = 16 + engine() % 4096;
+
+         if (const auto id = allocator.allocate(size, alignment); id) {
+            live.push_back(*id);
+         }
+         else {
+            failed += 1;
+         }
+      }
+      else {
+         const std::size_t index = engine() % live.size();
+
+         allocator.free(live[index]);
+         live[index] = live.back();
+         live.pop_back();
+      }
+
+      if (i % 1000 == 0) expect_consistent(allocator, live, alignment);
+   }
+
+   expect_consistent(allocator, live, alignment);
+
+   // Churn should have run the allocator full and left holes behind.
+   EXPECT_GT(failed, 0u);
+   EXPECT_GT(allocator.stats().free_block_count, 1u);
+   EXPECT_GT(allocator.stats().fragmentation(), 0.0f);
+
+   for (const auto id : live) allocator.free(id);
+
+   EXPECT_TRUE(allocator.empty());
+   EXPECT_EQ(allocator.stats().free_block_count, 1u);
+   EXPECT_EQ(allocator.stats().largest_free_block, allocator.capacity());
+}
+
+TEST(Buffer_suballocator, defragment_leaves_one_free_block)
+{
+   constexpr std::uint32_t alignment = 16;
+
+   Buffer_suballocator allocator{1 << 16};
+   std::mt19937 engine{11};
+   std::vector<Allocation_id> live;
+
+   for (int i = 0; i < 2000; ++i) {
+      if (live.empty() || engine() % 2 == 0) {
+         const std::uint32_t size = alignment * (1 + engine() % 32);
+
+         if (const auto id = allocator.allocate(size, alignment); id) {
+            live.push_back(*id);
+         }
+      }
+      else {
+         const std::size_t index = engine() % live.size();
+
+         allocator.free(live[index]);
+         live[index] = live.back();
+         live.pop_back();
+      }
+   }
+
+   ASSERT_GT(allocator.stats().fragmentation(), 0.0f);
+
+   const auto used = allocator.stats().used;
+   const auto relocations = allocator.defragment();
+
+   ASSERT_EQ(relocations.size(), live.size());
+
+   for (std::size_t i = 0; i < relocations.size(); ++i) {
+      const auto& relocation = relocations[i];
+
+      EXPECT_EQ(allocator.offset(relocation.id), relocation.new_offset);
+      EXPECT_EQ(allocator.size(relocation.id), relocation.size);
+      EXPECT_LE(relocation.new_offset, relocation.old_offset);
+
+      if (i > 0) {
+         EXPECT_LT(relocations[i - 1].new_offset, relocation.new_offset);
+      }
+   }
+
+   expect_consistent(allocator, live, alignment);
+
+   EXPECT_EQ(allocator.stats().used, used);
+   EXPECT_EQ(allocator.stats().free_block_count, 1u);
+   EXPECT_EQ(allocator.stats().fragmentation(), 0.0f);
+
+   // The packed free space is usable as one block.
+   EXPECT_TRUE(allocator.allocate(allocator.stats().largest_free_block, 1));
+}
+
+TEST(Buffer_suballocator, defragment_only_leaves_alignment_padding_behind)
+{
+   Buffer_suballocator allocator{4096};
+
+   const auto a = *allocator.allocate(10, 1);
+   const auto b = *allocator.allocate(100, 1);
+   const auto c = *allocator.allocate(20, 64);
+   const auto d = *allocator.allocate(30, 1);
+
+   allocator.free(b);
+
+   const auto relocations = allocator.defragment();
+
+   ASSERT_EQ(relocations.size(), 3u);
+   EXPECT_EQ(allocator.offset(a), 0u);
+   EXPECT_EQ(allocator.offset(c), 64u);
+   EXPECT_EQ(allocator.offset(d), 84u);
+
+   // The padding before c and the tail.
+   EXPECT_EQ(allocator.stats().free_block_count, 2u);
+   EXPECT_EQ(allocator.stats().largest_free_block, 4096u - 114u);
+}
+
+}
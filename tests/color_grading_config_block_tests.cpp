@@ -0,0 +1,249 @@
+
+#include "color_grading_config_block.hpp"
+
+#include "synthetic_color_grading_configs.hpp"
+
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp {
+
+namespace {
+
+using namespace std::literals;
+
+auto same_block(const Color_grading_config_block& left,
+                const Color_grading_config_block& right) noexcept -> bool
+{
+   return std::memcmp(&left, &right, sizeof(Color_grading_config_block)) == 0;
+}
+
+auto compile(const std::string& yaml) -> Color_grading_config_block
+{
+   return compile_colorgrading_config(YAML::Load(yaml));
+}
+
+void validate(const std::string& yaml)
+{
+   validate_colorgrading_config(YAML::Load(yaml));
+}
+
+}
+
+TEST(Color_grading_config_block, empty_config_takes_defaults)
+{
+   const auto block = compile(""s);
+   const auto& cg = block.color_grading;
+
+   EXPECT_EQ(cg.color_filter, (Color_grading_config_float3{1.0f, 1.0f, 1.0f}));
+   EXPECT_EQ(cg.saturation, 1.0f);
+   EXPECT_EQ(cg.exposure, 0.0f);
+   EXPECT_EQ(cg.tonemapper, Color_grading_config_tonemapper::filmic);
+   EXPECT_EQ(cg.filmic_toe_length, 0.5f);
+   EXPECT_EQ(cg.hsv_value_adjustment, 1.0f);
+   EXPECT_EQ(cg.channel_mix_red, (Color_grading_config_float3{1.0f, 0.0f, 0.0f}));
+   EXPECT_EQ(cg.channel_mix_green, (Color_grading_config_float3{0.0f, 1.0f, 0.0f}));
+   EXPECT_EQ(cg.channel_mix_blue, (Color_grading_config_float3{0.0f, 0.0f, 1.0f}));
+
+   EXPECT_EQ(block.has_bloom, 0u);
+   EXPECT_TRUE(same_block(block, compile("ColorGrading: {}"s)));
+}
+
+TEST(Color_grading_config_block, empty_bloom_takes_defaults)
+{
+   const auto block = compile("Bloom: {}"s);
+   const auto& bloom = block.bloom;
+
+   EXPECT_EQ(block.has_bloom, 1u);
+   EXPECT_EQ(bloom.enabled, 1u);
+   EXPECT_EQ(bloom.mode, Color_grading_config_bloom_mode::threshold);
+   EXPECT_EQ(bloom.threshold, 1.0f);
+   EXPECT_EQ(bloom.blend_factor, 0.05f);
+   EXPECT_EQ(bloom.intensity, 0.75f);
+   EXPECT_EQ(bloom.tint, (Color_grading_config_float3{1.0f, 1.0f, 1.0f}));
+   EXPECT_EQ(bloom.use_dirt, 0u);
+   EXPECT_EQ(bloom.dirt_texture_name[0], '\0');
+}
+
+TEST(Color_grading_config_block, compiles_values)
+{
+   const auto block = compile(R"(
+ColorGrading:
+   ColorFilter: [0.5, 0.25, 2]
+   Exposure: -1.5
+   Tonemapper: Filmic Heji 2015
+   ChannelMixBlue: [0.1, 0.2, 0.3]
+Bloom:
+   Enable: false
+   Mode: Threshold
+   Threshold: 0.8
+   InnerTint: [1, 0, 0.5]
+   UseDirt: true
+   DirtTextureName: lens_dirt
+)"s);
+
+   EXPECT_EQ(block.color_grading.color_filter,
+             (Color_grading_config_float3{0.5f, 0.25f, 2.0f}));
+   EXPECT_EQ(block.color_grading.exposure, -1.5f);
+   EXPECT_EQ(block.color_grading.tonemapper,
+             Color_grading_config_tonemapper::filmic_heji2015);
+   EXPECT_EQ(block.color_grading.channel_mix_blue,
+             (Color_grading_config_float3{0.1f, 0.2f, 0.3f}));
+
+   EXPECT_EQ(block.bloom.enabled, 0u);
+   EXPECT_EQ(block.bloom.threshold, 0.8f);
+   EXPECT_EQ(block.bloom.inner_tint, (Color_grading_config_float3{1.0f, 0.0f, 0.5f}));
+   EXPECT_EQ(block.bloom.use_dirt, 1u);
+   EXPECT_EQ(std::string{block.bloom.dirt_texture_name.data()}, "lens_dirt"s);
+}
+
+// Only the values for the bloom mode in use are kept, the others stay at their
+// defaults.
+TEST(Color_grading_config_block, bloom_mode_selects_values)
+{
+   const auto threshold = compile(
+      "Bloom: {Mode: Threshold, Threshold: 0.5, BlendFactor: 0.5, DirtScale: 2}"s);
+
+   EXPECT_EQ(threshold.bloom.threshold, 0.5f);
+   EXPECT_EQ(threshold.bloom.blend_factor, 0.05f);
+   EXPECT_EQ(threshold.bloom.dirt_scale, 2.0f);
+
+   const auto blended = compile(
+      "Bloom: {Mode: Blended, Threshold: 0.5, BlendFactor: 0.5, DirtScale: 2}"s);
+
+   EXPECT_EQ(blended.bloom.mode, Color_grading_config_bloom_mode::blended);
+   EXPECT_EQ(blended.bloom.threshold, 1.0f);
+   EXPECT_EQ(blended.bloom.blend_factor, 0.5f);
+   EXPECT_EQ(blended.bloom.dirt_scale, 1.0f);
+}
+
+TEST(Color_grading_config_block, lenient_falls_back)
+{
+   const auto block = compile(R"(
+ColorGrading:
+   Saturation: lots
+   ColorFilter: [1, 2]
+   Tonemapper: Hable
+   Unknown: 1
+Bloom:
+   Mode: Bright
+   Tint: [0.5]
+)"s);
+
+   EXPECT_EQ(block.color_grading.saturation, 1.0f);
+   EXPECT_EQ(block.color_grading.color_filter,
+             (Color_grading_config_float3{1.0f, 1.0f, 1.0f}));
+   EXPECT_EQ(block.color_grading.tonemapper, Color_grading_config_tonemapper::filmic);
+
+   // An unknown mode was always read as blended, a short tint only overrides
+   // the elements it has.
+   EXPECT_EQ(block.bloom.mode, Color_grading_config_bloom_mode::blended);
+   EXPECT_EQ(block.bloom.tint, (Color_grading_config_float3{0.5f, 1.0f, 1.0f}));
+}
+
+TEST(Color_grading_config_block, strict_rejects_what_lenient_accepts)
+{
+   EXPECT_NO_THROW(validate(""s));
+   EXPECT_NO_THROW(validate("ColorGrading: {Saturation: 2}\nBloom: {Tint: [1, 1, 1]}"s));
+
+   for (const auto& yaml : {"Colorgrading: {}"s,
+                            "ColorGrading: {Saturation: lots}"s,
+                            "ColorGrading: {Sat: 1}"s,
+                            "ColorGrading: {ColorFilter: [1, 2]}"s,
+                            "ColorGrading: {Tonemapper: Hable}"s,
+                            "ColorGrading: [1, 2]"s,
+                            "Bloom: {Mode: Bright}"s,
+                            "Bloom: {Tint: [0.5]}"s,
+                            "Bloom: {Enable: maybe}"s}) {
+      EXPECT_NO_THROW(compile(yaml)) << yaml;
+      EXPECT_THROW(validate(yaml), std::runtime_error) << yaml;
+   }
+}
+
+TEST(Color_grading_config_block, dirt_texture_name_too_long)
+{
+   const auto yaml = "Bloom: {DirtTextureName: "s + std::string(64, 'a') + "}"s;
+
+   EXPECT_THROW(compile(yaml), std::runtime_error);
+   EXPECT_THROW(validate(yaml), std::runtime_error);
+
+   const auto block =
+      compile("Bloom: {DirtTextureName: "s + std::string(63, 'a') + "}"s);
+
+   EXPECT_EQ(std::string{block.bloom.dirt_texture_name.data()}, std::string(63, 'a'));
+}
+
+TEST(Color_grading_config_block, round_trip)
+{
+   std::mt19937 random{0};
+
+   for (int i = 0; i < 500; ++i) {
+      const auto config = tests::make_synthetic_colorgrading_config(random);
+      const auto block = compile_colorgrading_config(config);
+
+      const auto decompiled = YAML::Dump(decompile_colorgrading_config(block));
+
+      ASSERT_NO_THROW(validate(decompiled)) << decompiled;
+      ASSERT_TRUE(same_block(block, compile(decompiled)))
+         << YAML::Dump(config) << "\n---\n"
+         << decompiled;
+
+      // Synthetic configs only hold valid values, so they validate too.
+      ASSERT_NO_THROW(validate_colorgrading_config(config)) << YAML::Dump(config);
+   }
+}
+
+TEST(Color_grading_config_block, round_trip_through_bytes)
+{
+   std::mt19937 random{1};
+   std::vector<Color_grading_config_block> blocks;
+
+   for (int i = 0; i < 64; ++i) {
+      blocks.push_back(compile_colorgrading_config(
+         tests::make_synthetic_colorgrading_config(random)));
+   }
+
+   std::vector<char> bytes(blocks.size() * sizeof(Color_grading_config_block));
+
+   std::memcpy(bytes.data(), blocks.data(), bytes.size());
+
+   for (std::size_t i = 0; i < blocks.size(); ++i) {
+      Color_grading_config_block read;
+
+      std::memcpy(&read, bytes.data() + i * sizeof(Color_grading_config_block),
+                  sizeof(Color_grading_config_block));
+
+      EXPECT_NO_THROW(check_colorgrading_config_block(read));
+      EXPECT_TRUE(same_block(read, blocks[i]));
+   }
+}
+
+TEST(Color_grading_config_block, check_rejects_corrupt_blocks)
+{
+   const auto valid = compile("Bloom: {DirtTextureName: dirt}"s);
+
+   EXPECT_NO_THROW(check_colorgrading_config_block(valid));
+
+   auto tonemapper = valid;
+   tonemapper.color_grading.tonemapper = static_cast<Color_grading_config_tonemapper>(5);
+
+   EXPECT_THROW(check_colorgrading_config_block(tonemapper), std::runtime_error);
+   EXPECT_THROW(decompile_colorgrading_config(tonemapper), std::runtime_error);
+
+   auto mode = valid;
+   mode.bloom.mode = static_cast<Color_grading_config_bloom_mode>(2);
+
+   EXPECT_THROW(check_colorgrading_config_block(mode), std::runtime_error);
+
+   auto name = valid;
+   name.bloom.dirt_texture_name.fill('a');
+
+   EXPECT_THROW(check_colorgrading_config_block(name), std::runtime_error);
+}
+
+}
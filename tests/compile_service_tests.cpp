@@ -0,0 +1,301 @@
+
+#include "shader/compile_service.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+#include <gtest/gtest.h>
+
+namespace sp::shader {
+
+namespace {
+
+using namespace std::literals;
+
+// Stands in for the D3D compiler. Every compile returns its static flags as
+// the bytecode and compiles of held flags block until they're released.
+class Fake_backend final : public Compile_backend {
+public:
+   auto compile(const Entrypoint_description&, const std::uint64_t static_flags,
+                const Vertex_shader_flags) noexcept -> Bytecode_blob override
+   {
+      std::unique_lock lock{_mutex};
+
+      _compiles[static_flags] += 1;
+      _threads[static_flags] = std::this_thread::get_id();
+      _started += 1;
+      _started_cv.notify_all();
+
+      _held_cv.wait(lock, [&] { return !_held.contains(static_flags); });
+
+      lock.unlock();
+
+      Bytecode_blob bytecode{sizeof(static_flags)};
+
+      std::memcpy(bytecode.data(), &static_flags, sizeof(static_flags));
+
+      return bytecode;
+   }
+
+   void hold(const std::uint64_t static_flags)
+   {
+      std::scoped_lock lock{_mutex};
+
+      _held.insert(static_flags);
+   }
+
+   void release(const std::uint64_t static_flags)
+   {
+      {
+         std::scoped_lock lock{_mutex};
+
+         _held.erase(static_flags);
+      }
+
+      _held_cv.notify_all();
+   }
+
+   void wait_started(const std::size_t count)
+   {
+      std::unique_lock lock{_mutex};
+
+      _started_cv.wait(lock, [&] { return _started >= count; });
+   }
+
+   auto compiles(const std::uint64_t static_flags) const -> std::size_t
+   {
+      std::scoped_lock lock{_mutex};
+
+      const auto it = _compiles.find(static_flags);
+
+      return it != _compiles.end() ? it->second : 0;
+   }
+
+   auto thread(const std::uint64_t static_flags) const -> std::thread::id
+   {
+      std::scoped_lock lock{_mutex};
+
+      return _threads.at(static_flags);
+   }
+
+private:
+   mutable std::mutex _mutex;
+   std::condition_variable _held_cv;
+   std::condition_variable _started_cv;
+   std::size_t _started = 0;
+   absl::flat_hash_set<std::uint64_t> _held;
+   absl::flat_hash_map<std::uint64_t, std::size_t> _compiles;
+   absl::flat_hash_map<std::uint64_t, std::thread::id> _threads;
+};
+
+auto make_key(const std::uint64_t static_flags) -> Compile_key
+{
+   return {.stage = Stage::pixel,
+           .group = "test",
+           .entrypoint = "main_ps",
+           .static_flags = static_flags};
+}
+
+auto bytecode_flags(const Bytecode_blob& bytecode) -> std::uint64_t
+{
+   std::uint64_t static_flags = 0;
+
+   if (bytecode.size() == sizeof(static_flags)) {
+      std::memcpy(&static_flags, bytecode.data(), sizeof(static_flags));
+   }
+
+   return static_flags;
+}
+
+const Entrypoint_description entrypoint{.function_name = {},
+                                        .source_name = {},
+                                        .stage = Stage::pixel,
+                                        .vertex_state = {},
+                                        .static_flags = {},
+                                        .preprocessor_defines = {}};
+
+}
+
+TEST(Compile_service, concurrent_requests_for_one_key_compile_once)
+{
+   Fake_backend backend;
+   Compile_service service{backend, {}, 2};
+
+   backend.hold(7);
+   service.compile_async(make_key(7), entrypoint);
+   backend.wait_started(1);
+
+   constexpr std::size_t waiter_count = 8;
+
+   std::latch waiters_started{waiter_count};
+   std::atomic_size_t matching_results = 0;
+   std::vector<std::jthread> waiters;
+
+   for (std::size_t i = 0; i < waiter_count; ++i) {
+      waiters.emplace_back([&] {
+         waiters_started.count_down();
+
+         if (bytecode_flags(service.compile_wait(make_key(7), entrypoint)) == 7) {
+            matching_results += 1;
+         }
+      });
+   }
+
+   waiters_started.wait();
+
+   // Give the waiters time to find the compile in flight before it finishes.
+   std::this_thread::sleep_for(20ms);
+
+   service.compile_async(make_key(7), entrypoint);
+   backend.release(7);
+
+   waiters.clear();
+   service.wait_idle();
+
+   EXPECT_EQ(matching_results, waiter_count);
+   EXPECT_EQ(backend.compiles(7), 1u);
+   EXPECT_FALSE(service.in_flight(make_key(7)));
+}
+
+TEST(Compile_service, different_game_flags_are_different_keys)
+{
+   Fake_backend backend;
+   Compile_service service{backend, {}, 0};
+
+   Compile_key skinned = make_key(1);
+   skinned.game_flags = Vertex_shader_flags::hard_skinned;
+
+   service.compile_wait(make_key(1), entrypoint);
+   service.compile_wait(skinned, entrypoint);
+
+   EXPECT_EQ(backend.compiles(1), 2u);
+}
+
+TEST(Compile_service, waiting_on_a_queued_compile_runs_it_on_the_waiting_thread)
+{
+   Fake_backend backend;
+   Compile_service service{backend, {}, 1};
+
+   // Keep the only worker busy so the second compile stays queued.
+   backend.hold(1);
+   service.compile_async(make_key(1), entrypoint);
+   backend.wait_started(1);
+
+   service.compile_async(make_key(2), entrypoint);
+
+   EXPECT_TRUE(service.in_flight(make_key(2)));
+   EXPECT_EQ(bytecode_flags(service.compile_wait(make_key(2), entrypoint)), 2u);
+   EXPECT_EQ(backend.thread(2), std::this_thread::get_id());
+   EXPECT_TRUE(service.in_flight(make_key(1)));
+
+   backend.release(1);
+   service.wait_idle();
+
+   EXPECT_EQ(backend.compiles(1), 1u);
+   EXPECT_EQ(backend.compiles(2), 1u);
+}
+
+TEST(Compile_service, queued_compiles_are_spread_across_workers)
+{
+   constexpr std::size_t worker_count = 4;
+
+   Fake_backend backend;
+   Compile_service service{backend, {}, worker_count};
+
+   for (std::uint64_t i = 0; i < worker_count; ++i) {
+      backend.hold(i);
+      service.compile_async(make_key(i), entrypoint);
+   }
+
+   // Only returns once every worker is inside a compile at the same time.
+   backend.wait_started(worker_count);
+
+   for (std::uint64_t i = 0; i < worker_count; ++i) backend.release(i);
+
+   service.wait_idle();
+
+   absl::flat_hash_set<std::thread::id> threads;
+
+   for (std::uint64_t i = 0; i < worker_count; ++i) threads.insert(backend.thread(i));
+
+   EXPECT_EQ(threads.size(), worker_count);
+   EXPECT_FALSE(threads.contains(std::this_thread::get_id()));
+}
+
+TEST(Compile_service, wait_idle_returns_once_every_compile_is_published)
+{
+   constexpr std::uint64_t job_count = 64;
+
+   Fake_backend backend;
+   std::atomic_size_t published = 0;
+   Compile_service service{backend,
+                           [&](const Compile_key& key, const Bytecode_blob& bytecode) {
+                              if (bytecode_flags(bytecode) == key.static_flags) {
+                                 published += 1;
+                              }
+                           },
+                           3};
+
+   service.wait_idle();
+
+   for (std::uint64_t i = 0; i < job_count; ++i) {
+      service.compile_async(make_key(i), entrypoint);
+   }
+
+   service.wait_idle();
+
+   EXPECT_EQ(published, job_count);
+   EXPECT_EQ(service.in_flight_count(), 0u);
+
+   for (std::uint64_t i = 0; i < job_count; ++i) EXPECT_EQ(backend.compiles(i), 1u);
+}
+
+TEST(Compile_service, compiles_inline_without_workers)
+{
+   Fake_backend backend;
+   Compile_service service{backend, {}, 0};
+
+   service.compile_async(make_key(3), entrypoint);
+
+   EXPECT_EQ(backend.compiles(3), 1u);
+   EXPECT_EQ(backend.thread(3), std::this_thread::get_id());
+   EXPECT_EQ(service.in_flight_count(), 0u);
+}
+
+TEST(Compile_service, destroying_the_service_finishes_queued_compiles)
+{
+   constexpr std::uint64_t job_count = 8;
+
+   Fake_backend backend;
+   std::atomic_size_t published = 0;
+
+   {
+      Compile_service service{backend,
+                              [&](const Compile_key&, const Bytecode_blob&) {
+                                 published += 1;
+                              },
+                              1};
+
+      backend.hold(0);
+
+      for (std::uint64_t i = 0; i < job_count; ++i) {
+         service.compile_async(make_key(i), entrypoint);
+      }
+
+      backend.wait_started(1);
+      backend.release(0);
+   }
+
+   EXPECT_EQ(published, job_count);
+}
+
+}
@@ -0,0 +1,177 @@
+
+#include "material/constant_buffer_layout.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+namespace sp::material {
+
+namespace {
+
+using Type = Constant_buffer_layout::Type;
+
+auto offset_of(const Constant_buffer_layout& layout, const std::string_view name)
+   -> std::uint32_t
+{
+   return layout.fields()[layout.index_of(name)].offset;
+}
+
+}
+
+TEST(Constant_buffer_layout, fields_are_packed_into_16_byte_registers)
+{
+   const Constant_buffer_layout layout{R"(
+      float3 color;
+      float  weight;
+      float2 scale;
+      float3 direction; // Doesn't fit after scale.
+      float  power;
+      float4 tint;
+   )"};
+
+   ASSERT_EQ(layout.fields().size(), 6);
+
+   EXPECT_EQ(offset_of(layout, "color"), 0);
+   EXPECT_EQ(offset_of(layout, "weight"), 12);
+   EXPECT_EQ(offset_of(layout, "scale"), 16);
+   EXPECT_EQ(offset_of(layout, "direction"), 32);
+   EXPECT_EQ(offset_of(layout, "power"), 44);
+   EXPECT_EQ(offset_of(layout, "tint"), 48);
+}
+
+TEST(Constant_buffer_layout, array_items_each_start_a_register)
+{
+   const Constant_buffer_layout layout{R"(
+      float  first;
+      float2 items[3];
+      float  last;
+   )"};
+
+   ASSERT_EQ(layout.fields().size(), 5);
+
+   EXPECT_EQ(offset_of(layout, "first"), 0);
+   EXPECT_EQ(offset_of(layout, "items[0]"), 16);
+   EXPECT_EQ(offset_of(layout, "items[1]"), 32);
+   EXPECT_EQ(offset_of(layout, "items[2]"), 48);
+   EXPECT_EQ(offset_of(layout, "last"), 56);
+}
+
+TEST(Constant_buffer_layout, types_are_parsed)
+{
+   const Constant_buffer_layout types{R"(
+      float1 a;
+      float2 b;
+      float3 c;
+      float4 d;
+      int1 e;
+      int2 f;
+      int3 g;
+      int4 h;
+      uint1 i;
+      uint2 j;
+      uint3 k;
+      uint4 l;
+      bool m;
+   )"};
+
+   ASSERT_EQ(types.fields().size(), 13);
+
+   for (std::size_t i = 0; i < types.fields().size(); ++i) {
+      EXPECT_EQ(types.fields()[i].type, static_cast<Type>(i));
+   }
+}
+
+TEST(Constant_buffer_layout, defaults_are_zeroed_and_256_byte_aligned)
+{
+   const Constant_buffer_layout single{"float value;"};
+
+   EXPECT_EQ(single.size(), 256);
+   EXPECT_TRUE(std::ranges::all_of(single.defaults(),
+                                   [](const std::byte b) { return b == std::byte{}; }));
+
+   const Constant_buffer_layout spilled{"float4 values[16];\nfloat last;"};
+
+   EXPECT_EQ(spilled.size(), 512);
+   EXPECT_EQ(spilled.size() % Constant_buffer_layout::buffer_size_alignment, 0);
+}
+
+TEST(Constant_buffer_layout, comments_and_blank_lines_are_skipped)
+{
+   const Constant_buffer_layout layout{R"(
+      // Lighting
+
+      float3 light_color; // In linear space.
+      //float unused;
+      float  light_intensity;
+   )"};
+
+   ASSERT_EQ(layout.fields().size(), 2);
+   EXPECT_EQ(layout.fields()[0].name, "light_color");
+   EXPECT_EQ(layout.fields()[1].name, "light_intensity");
+}
+
+TEST(Constant_buffer_layout, compile_shares_plans_by_layout)
+{
+   const auto first = Constant_buffer_layout::compile("float3 color;\nfloat weight;");
+   const auto again = Constant_buffer_layout::compile("float3 color;\nfloat weight;");
+   const auto other = Constant_buffer_layout::compile("float4 color;");
+
+   EXPECT_EQ(first, again);
+   EXPECT_NE(first, other);
+   EXPECT_EQ(first->fields().size(), 2);
+}
+
+TEST(Constant_buffer_layout, material_script_layout_compiles)
+{
+   // normal_bf3.lua's layout.
+   const Constant_buffer_layout layout{R"(
+      float3 base_diffuse_color;
+      float  gloss_map_weight;
+      float3 base_specular_color;
+      float  specular_exponent;
+      bool   use_ao_texture;
+      bool   use_emissive_texture;
+      float  emissive_texture_scale;
+      float  emissive_power;
+      bool   use_env_map;
+      float  env_map_vis;
+      float  dynamic_normal_sign;
+      bool   use_outline_light;
+      float3 outline_light_color;
+      float  outline_light_width;
+      float  outline_light_fade;
+      float  height_scale;
+      float  parallax_scale_x;
+      bool   use_terrain_fade;
+      float3 horizon_color;
+      float  fade_start;
+      float  fade_end;
+      float  fade_power;
+      float  horizon_desaturation;
+      float  opacity_cutoff;
+      float  horizon_intensity;
+      bool   use_atmosphere_map;
+      float  atmosphere_flip_x;
+      float  atmosphere_flip_y;
+      float  atmosphere_flip_z;
+   )"};
+
+   ASSERT_EQ(layout.fields().size(), 29);
+
+   EXPECT_EQ(offset_of(layout, "specular_exponent"), 28);
+   EXPECT_EQ(offset_of(layout, "outline_light_color"), 64);
+   EXPECT_EQ(offset_of(layout, "horizon_color"), 96);
+   EXPECT_EQ(offset_of(layout, "atmosphere_flip_z"), 144);
+   EXPECT_EQ(layout.size(), 256);
+   EXPECT_EQ(layout.index_of("fade_start"), 19);
+}
+
+TEST(Constant_buffer_layout, oversized_layouts_terminate)
+{
+   EXPECT_DEATH(Constant_buffer_layout{"float4 values[4097];"}, "");
+}
+
+}
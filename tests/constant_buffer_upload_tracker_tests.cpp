@@ -0,0 +1,246 @@
+
+#include "core/constant_buffer_upload_tracker.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+namespace sp::core {
+
+namespace {
+
+// Eight registers, like a small game constant buffer.
+struct Buffer {
+   std::array<std::array<float, 4>, 8> registers;
+};
+
+// Five and a half registers, the last is only partially covered by the struct.
+struct Unaligned_buffer {
+   std::array<float, 22> values;
+};
+
+using Tracker = Constant_buffer_upload_tracker<Buffer>;
+
+// Writes value to a register without marking it.
+void write(Buffer& buffer, const std::uint32_t index, const float value)
+{
+   buffer.registers[index] = {value, value, value, value};
+}
+
+// Writes value to a register and marks it, as set_constants does.
+void write(Tracker& tracker, Buffer& buffer, const std::uint32_t index, const float value)
+{
+   tracker.mark(index, 1);
+   write(buffer, index, value);
+}
+
+// Uploads the initial contents so later uploads can be skipped.
+auto make_uploaded_tracker(const Buffer& buffer) -> Tracker
+{
+   Tracker tracker;
+
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+
+   return tracker;
+}
+
+}
+
+TEST(Constant_buffer_upload_tracker, register_count)
+{
+   EXPECT_EQ(Tracker::register_count, 8u);
+   EXPECT_EQ(Constant_buffer_upload_tracker<Unaligned_buffer>::register_count, 6u);
+}
+
+TEST(Constant_buffer_upload_tracker, first_upload_always_happens)
+{
+   Tracker tracker;
+   const Buffer buffer{};
+
+   EXPECT_TRUE(tracker.dirty());
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+   EXPECT_FALSE(tracker.dirty());
+   EXPECT_EQ(tracker.stats().uploads, 1u);
+}
+
+TEST(Constant_buffer_upload_tracker, clean_buffer_is_not_compared)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   EXPECT_FALSE(tracker.needs_upload(buffer));
+   EXPECT_EQ(tracker.stats().skipped, 0u);
+}
+
+TEST(Constant_buffer_upload_tracker, skips_unchanged_upload)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   write(tracker, buffer, 3, 0.0f);
+
+   EXPECT_TRUE(tracker.dirty());
+   EXPECT_FALSE(tracker.needs_upload(buffer));
+   EXPECT_FALSE(tracker.dirty());
+   EXPECT_EQ(tracker.stats().uploads, 1u);
+   EXPECT_EQ(tracker.stats().skipped, 1u);
+}
+
+TEST(Constant_buffer_upload_tracker, uploads_changed_register)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   write(tracker, buffer, 3, 1.0f);
+
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+   EXPECT_EQ(tracker.stats().uploads, 2u);
+
+   // Writing the same value again is then skipped.
+   write(tracker, buffer, 3, 1.0f);
+
+   EXPECT_FALSE(tracker.needs_upload(buffer));
+}
+
+TEST(Constant_buffer_upload_tracker, write_back_to_uploaded_value_is_skipped)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   write(tracker, buffer, 5, 2.0f);
+   write(tracker, buffer, 5, 0.0f);
+
+   EXPECT_FALSE(tracker.needs_upload(buffer));
+}
+
+// The invariant Shader_patch relies on: an unmarked write outside the range
+// that was marked is not compared, so the upload is skipped and the write lost.
+TEST(Constant_buffer_upload_tracker, range_mark_hides_unmarked_write)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   write(buffer, 6, 4.0f);
+   write(tracker, buffer, 1, 0.0f);
+
+   EXPECT_FALSE(tracker.needs_upload(buffer));
+
+   // Marking the written register makes it visible again.
+   tracker.mark(6, 1);
+
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+}
+
+TEST(Constant_buffer_upload_tracker, unmarked_write_without_any_mark_is_lost)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   write(buffer, 0, 1.0f);
+
+   EXPECT_FALSE(tracker.dirty());
+   EXPECT_FALSE(tracker.needs_upload(buffer));
+}
+
+// Marks coalesce into one range, so unmarked writes between two marked
+// registers are still compared.
+TEST(Constant_buffer_upload_tracker, marks_coalesce)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   write(buffer, 4, 1.0f);
+   write(tracker, buffer, 2, 0.0f);
+   write(tracker, buffer, 6, 0.0f);
+
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+}
+
+// Uploads shadow the whole buffer, an unmarked write that made it into an
+// upload is not compared against stale contents later.
+TEST(Constant_buffer_upload_tracker, upload_records_whole_buffer)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   write(buffer, 7, 3.0f);
+   write(tracker, buffer, 0, 1.0f);
+
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+
+   tracker.mark_all();
+
+   EXPECT_FALSE(tracker.needs_upload(buffer));
+}
+
+TEST(Constant_buffer_upload_tracker, mark_all_catches_unmarked_writes)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   write(buffer, 0, 1.0f);
+   write(buffer, 7, 1.0f);
+   tracker.mark_all();
+
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+
+   tracker.mark_all();
+
+   EXPECT_FALSE(tracker.needs_upload(buffer));
+   EXPECT_EQ(tracker.stats().skipped, 1u);
+}
+
+TEST(Constant_buffer_upload_tracker, invalidate_forces_upload)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   tracker.invalidate();
+
+   EXPECT_TRUE(tracker.dirty());
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+   EXPECT_EQ(tracker.stats().uploads, 2u);
+
+   // Only the next upload is forced.
+   tracker.mark_all();
+
+   EXPECT_FALSE(tracker.needs_upload(buffer));
+}
+
+TEST(Constant_buffer_upload_tracker, out_of_range_marks_are_clamped)
+{
+   Buffer buffer{};
+   Tracker tracker = make_uploaded_tracker(buffer);
+
+   tracker.mark(8, 4);
+   tracker.mark(2, 0);
+
+   EXPECT_FALSE(tracker.dirty());
+
+   write(buffer, 7, 1.0f);
+   tracker.mark(6, 100);
+
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+}
+
+TEST(Constant_buffer_upload_tracker, partial_last_register)
+{
+   using Unaligned_tracker = Constant_buffer_upload_tracker<Unaligned_buffer>;
+
+   Unaligned_buffer buffer{};
+   Unaligned_tracker tracker;
+
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+
+   buffer.values[21] = 1.0f;
+   tracker.mark(5, 1);
+
+   EXPECT_TRUE(tracker.needs_upload(buffer));
+
+   tracker.mark(5, 1);
+
+   EXPECT_FALSE(tracker.needs_upload(buffer));
+}
+
+}
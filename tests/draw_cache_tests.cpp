@@ -0,0 +1,82 @@
+
+#include "material/draw_cache.hpp"
+
+#include <gtest/gtest.h>
+
+namespace sp::material {
+
+namespace {
+
+using shader::State_name_id;
+using shader::Vertex_shader_flags;
+
+const Draw_key key{.state_id = State_name_id{2},
+                   .vs_flags = Vertex_shader_flags::position,
+                   .layout_index = 5};
+
+}
+
+TEST(Draw_cache, finds_the_stored_draw)
+{
+   Draw_cache<int> cache;
+
+   EXPECT_EQ(cache.find(key), nullptr);
+   EXPECT_EQ(cache.store(key, 7, true), 7);
+
+   ASSERT_NE(cache.find(key), nullptr);
+   EXPECT_EQ(*cache.find(key), 7);
+}
+
+TEST(Draw_cache, misses_when_any_part_of_the_key_changes)
+{
+   Draw_cache<int> cache;
+
+   cache.store(key, 7, true);
+
+   Draw_key other_state = key;
+   other_state.state_id = State_name_id{3};
+
+   Draw_key other_flags = key;
+   other_flags.vs_flags = Vertex_shader_flags::position | Vertex_shader_flags::color;
+
+   Draw_key other_layout = key;
+   other_layout.layout_index = 6;
+
+   EXPECT_EQ(cache.find(other_state), nullptr);
+   EXPECT_EQ(cache.find(other_flags), nullptr);
+   EXPECT_EQ(cache.find(other_layout), nullptr);
+}
+
+TEST(Draw_cache, only_remembers_the_last_draw)
+{
+   Draw_cache<int> cache;
+
+   Draw_key other = key;
+   other.layout_index = 6;
+
+   cache.store(key, 7, true);
+   cache.store(other, 8, true);
+
+   EXPECT_EQ(cache.find(key), nullptr);
+   EXPECT_EQ(*cache.find(other), 8);
+}
+
+TEST(Draw_cache, unreusable_draws_are_not_found)
+{
+   Draw_cache<int> cache;
+
+   EXPECT_EQ(cache.store(key, 7, false), 7);
+   EXPECT_EQ(cache.find(key), nullptr);
+}
+
+TEST(Draw_cache, invalidate_forgets_the_draw)
+{
+   Draw_cache<int> cache;
+
+   cache.store(key, 7, true);
+   cache.invalidate();
+
+   EXPECT_EQ(cache.find(key), nullptr);
+}
+
+}
@@ -0,0 +1,384 @@
+
+#include "core/draw_stream_replayer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp::core {
+
+namespace {
+
+auto count(const Draw_stream_op_counts& counts, const Draw_stream_op op) -> std::uint64_t
+{
+   return counts[static_cast<std::size_t>(op)];
+}
+
+auto constants(const float value) -> std::array<std::byte, 16>
+{
+   std::array<std::byte, 16> bytes;
+
+   for (std::size_t i = 0; i < bytes.size(); i += sizeof(float)) {
+      std::memcpy(&bytes[i], &value, sizeof(float));
+   }
+
+   return bytes;
+}
+
+// Two frames of a scene drawn the way the game draws it, rebinding state it
+// already has bound between most draws.
+auto record_frames() -> std::vector<std::byte>
+{
+   using namespace draw_stream;
+
+   Draw_stream_recorder recorder{2};
+
+   const std::array<int, 4> objects{};
+   const auto vertex_buffer = recorder.object(&objects[0]);
+   const auto blend_state = recorder.object(&objects[1]);
+   const auto diffuse = recorder.object(&objects[2]);
+   const auto detail = recorder.object(&objects[3]);
+
+   for (int frame = 0; frame < 2; ++frame) {
+      recorder.record(Clear_rendertarget{.color = {0.0f, 0.0f, 0.0f, 1.0f}});
+      recorder.record_constants(Draw_stream_cb::scene, 0, constants(1.0f));
+
+      for (int i = 0; i < 3; ++i) {
+         recorder.record(
+            Set_vertex_buffer{.buffer = vertex_buffer, .offset = 0, .stride = 32});
+         recorder.record(
+            Set_blend_state{.state = blend_state, .additive_blending = false});
+         recorder.record(Set_texture{.slot = 0, .texture = diffuse, .rendertarget = -1});
+         recorder.record(Set_texture{.slot = 1, .texture = detail, .rendertarget = -1});
+         recorder.record_constants(Draw_stream_cb::draw, 0,
+                                   constants(static_cast<float>(i / 2)));
+         recorder.record(Draw_indexed{.topology = 4,
+                                      .index_count = 96,
+                                      .start_index = 0,
+                                      .base_vertex = 0});
+      }
+
+      recorder.record(Present{});
+   }
+
+   return recorder.stream();
+}
+
+// Refuses every draw, the way a target would for a capture whose objects are
+// gone.
+class Draw_refusing_target final : public Draw_stream_target {
+public:
+   bool set_index_buffer(const draw_stream::Set_index_buffer&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_vertex_buffer(const draw_stream::Set_vertex_buffer&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_input_layout(const draw_stream::Set_input_layout&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_game_shader(const draw_stream::Set_game_shader&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_rendertarget(const draw_stream::Set_rendertarget&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_depthstencil(const draw_stream::Set_depthstencil&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_rasterizer_state(const draw_stream::Set_rasterizer_state&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_depthstencil_state(
+      const draw_stream::Set_depthstencil_state&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_blend_state(const draw_stream::Set_blend_state&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_fog_state(const draw_stream::Set_fog_state&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_texture(const draw_stream::Set_texture&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_patch_material(const draw_stream::Set_patch_material&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_constants(const draw_stream::Set_constants&,
+                      const std::span<const std::byte>) noexcept override
+   {
+      return true;
+   }
+
+   bool draw(const draw_stream::Draw&) noexcept override
+   {
+      return false;
+   }
+
+   bool draw_indexed(const draw_stream::Draw_indexed&) noexcept override
+   {
+      return false;
+   }
+
+   bool clear_rendertarget(const draw_stream::Clear_rendertarget&) noexcept override
+   {
+      return true;
+   }
+
+   bool clear_depthstencil(const draw_stream::Clear_depthstencil&) noexcept override
+   {
+      return true;
+   }
+
+   bool present() noexcept override
+   {
+      return true;
+   }
+
+   bool set_projtex_mode(const draw_stream::Set_projtex_mode&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_projtex_type(const draw_stream::Set_projtex_type&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_projtex_cube(const draw_stream::Set_projtex_cube&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_informal_projection_matrix(
+      const draw_stream::Set_informal_projection_matrix&) noexcept override
+   {
+      return true;
+   }
+
+   bool set_informal_view_matrix(
+      const draw_stream::Set_informal_view_matrix&) noexcept override
+   {
+      return true;
+   }
+
+   bool stretch_rendertarget(const draw_stream::Stretch_rendertarget&) noexcept override
+   {
+      return true;
+   }
+
+   bool color_fill_rendertarget(
+      const draw_stream::Color_fill_rendertarget&) noexcept override
+   {
+      return true;
+   }
+
+   bool begin_query(const draw_stream::Begin_query&) noexcept override
+   {
+      return true;
+   }
+
+   bool end_query(const draw_stream::End_query&) noexcept override
+   {
+      return true;
+   }
+
+   bool update_ia_buffer(const draw_stream::Update_ia_buffer&) noexcept override
+   {
+      return true;
+   }
+
+   bool map_ia_buffer(const draw_stream::Map_ia_buffer&) noexcept override
+   {
+      return true;
+   }
+
+   bool unmap_ia_buffer(const draw_stream::Unmap_ia_buffer&) noexcept override
+   {
+      return true;
+   }
+
+   bool reset(const draw_stream::Reset&) noexcept override
+   {
+      return true;
+   }
+};
+
+}
+
+TEST(Draw_stream_replayer, counts_a_recorded_stream)
+{
+   const auto stream = record_frames();
+
+   Counting_draw_stream_target target;
+
+   const auto stats = replay_draw_stream(stream, target);
+   const auto& redundant = target.redundant();
+
+   EXPECT_EQ(stats.frames, 2);
+   EXPECT_EQ(stats.draws, 6);
+   EXPECT_EQ(stats.skipped, 0);
+   EXPECT_FALSE(stats.truncated);
+
+   EXPECT_EQ(count(stats.calls, Draw_stream_op::set_vertex_buffer), 6);
+   EXPECT_EQ(count(stats.calls, Draw_stream_op::set_blend_state), 6);
+   EXPECT_EQ(count(stats.calls, Draw_stream_op::set_texture), 12);
+   EXPECT_EQ(count(stats.calls, Draw_stream_op::set_constants), 8);
+   EXPECT_EQ(count(stats.calls, Draw_stream_op::draw_indexed), 6);
+   EXPECT_EQ(count(stats.calls, Draw_stream_op::clear_rendertarget), 2);
+   EXPECT_EQ(count(stats.calls, Draw_stream_op::present), 2);
+
+   // Only the very first bind of each is needed, state carries across frames.
+   EXPECT_EQ(count(redundant, Draw_stream_op::set_vertex_buffer), 5);
+   EXPECT_EQ(count(redundant, Draw_stream_op::set_blend_state), 5);
+   EXPECT_EQ(count(redundant, Draw_stream_op::set_texture), 10);
+
+   // Draw constants are 0, 0, 1 each frame so the second draw of a frame and
+   // the scene constants of the second frame are redundant.
+   EXPECT_EQ(count(redundant, Draw_stream_op::set_constants), 3);
+
+   EXPECT_EQ(count(redundant, Draw_stream_op::draw_indexed), 0);
+   EXPECT_EQ(count(redundant, Draw_stream_op::clear_rendertarget), 0);
+}
+
+TEST(Draw_stream_replayer, texture_slots_are_tracked_separately)
+{
+   Draw_stream_recorder recorder{1};
+
+   const auto texture = recorder.object(&recorder);
+   const auto set_texture = [&](const std::uint8_t slot, const Draw_stream_object texture,
+                                const std::int32_t rendertarget) {
+      recorder.record(draw_stream::Set_texture{.slot = slot,
+                                               .texture = texture,
+                                               .rendertarget = rendertarget});
+   };
+
+   set_texture(0, texture, -1);
+   set_texture(1, texture, -1);
+   set_texture(0, texture, -1);
+   set_texture(1, draw_stream_null_object, 2);
+
+   Counting_draw_stream_target target;
+
+   replay_draw_stream(recorder.stream(), target);
+
+   EXPECT_EQ(count(target.redundant(), Draw_stream_op::set_texture), 1);
+}
+
+TEST(Draw_stream_replayer, constants_are_only_redundant_once_written)
+{
+   Draw_stream_recorder recorder{1};
+
+   const std::array<std::byte, 32> zeros{};
+
+   // Unwritten constants compare equal to zero in the shadow copy but still
+   // need uploading.
+   recorder.record_constants(Draw_stream_cb::skin, 16, std::span{zeros}.first(16));
+   recorder.record_constants(Draw_stream_cb::skin, 0, zeros);
+   recorder.record_constants(Draw_stream_cb::skin, 0, zeros);
+   recorder.record_constants(Draw_stream_cb::skin, 8, std::span{zeros}.first(8));
+   recorder.record_constants(Draw_stream_cb::draw_ps, 0, zeros);
+
+   Counting_draw_stream_target target;
+
+   replay_draw_stream(recorder.stream(), target);
+
+   EXPECT_EQ(count(target.redundant(), Draw_stream_op::set_constants), 2);
+}
+
+TEST(Draw_stream_replayer, reset_forgets_bound_state)
+{
+   Draw_stream_recorder recorder{1};
+
+   const draw_stream::Set_vertex_buffer vertex_buffer{
+      .buffer = recorder.object(&recorder), .offset = 0, .stride = 32};
+
+   recorder.record(vertex_buffer);
+   recorder.record(vertex_buffer);
+   recorder.record(draw_stream::Reset{.legacy_fullscreen = false,
+                                      .aspect_ratio_hack = false,
+                                      .render_width = 1920,
+                                      .render_height = 1080,
+                                      .window_width = 1920,
+                                      .window_height = 1080});
+   recorder.record(vertex_buffer);
+
+   Counting_draw_stream_target target;
+
+   replay_draw_stream(recorder.stream(), target);
+
+   EXPECT_EQ(count(target.redundant(), Draw_stream_op::set_vertex_buffer), 1);
+}
+
+TEST(Draw_stream_replayer, calls_the_target_refuses_are_skipped)
+{
+   const auto stream = record_frames();
+
+   Draw_refusing_target target;
+
+   const auto stats = replay_draw_stream(stream, target);
+
+   EXPECT_EQ(stats.draws, 0);
+   EXPECT_EQ(stats.skipped, 6);
+   EXPECT_EQ(count(stats.calls, Draw_stream_op::draw_indexed), 6);
+}
+
+TEST(Draw_stream_replayer, truncated_streams_are_flagged)
+{
+   auto stream = record_frames();
+   stream.resize(stream.size() - 3);
+
+   Counting_draw_stream_target target;
+
+   const auto stats = replay_draw_stream(stream, target);
+
+   EXPECT_TRUE(stats.truncated);
+   EXPECT_EQ(stats.frames, 1);
+   EXPECT_LT(stats.draws, 6);
+}
+
+TEST(Draw_stream_replayer, streams_with_bad_headers_replay_nothing)
+{
+   auto stream = record_frames();
+   stream[0] = std::byte{0};
+
+   Counting_draw_stream_target target;
+
+   const auto stats = replay_draw_stream(stream, target);
+
+   EXPECT_TRUE(stats.truncated);
+   EXPECT_EQ(stats.frames, 0);
+   EXPECT_EQ(stats.draws, 0);
+}
+
+}
@@ -0,0 +1,136 @@
+
+#include "core/draw_stream.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp::core {
+
+TEST(Draw_stream, records_read_back_in_order)
+{
+   Draw_stream_recorder recorder{1};
+
+   const int buffer = 0;
+   const std::array<std::byte, 4> constants{std::byte{1}, std::byte{2}, std::byte{3},
+                                            std::byte{4}};
+
+   recorder.record(draw_stream::Set_index_buffer{.buffer = recorder.object(&buffer),
+                                                 .offset = 16});
+   recorder.record_constants(Draw_stream_cb::draw, 32, constants);
+   recorder.record(draw_stream::Present{});
+
+   EXPECT_TRUE(recorder.done());
+
+   const auto stream = recorder.stream();
+   Draw_stream_reader reader{stream};
+
+   ASSERT_TRUE(reader.valid());
+   EXPECT_EQ(reader.header().frame_count, 1);
+   EXPECT_EQ(reader.header().object_count, 1);
+
+   auto record = reader.next();
+
+   ASSERT_TRUE(record);
+   ASSERT_EQ(record->op, Draw_stream_op::set_index_buffer);
+
+   const auto index_buffer =
+      Draw_stream_reader::payload_as<draw_stream::Set_index_buffer>(*record);
+
+   EXPECT_EQ(index_buffer.buffer, 1);
+   EXPECT_EQ(index_buffer.offset, 16);
+
+   record = reader.next();
+
+   ASSERT_TRUE(record);
+   ASSERT_EQ(record->op, Draw_stream_op::set_constants);
+   EXPECT_EQ(Draw_stream_reader::payload_as<draw_stream::Set_constants>(*record).offset,
+             32);
+   EXPECT_TRUE(std::ranges::equal(record->constants, constants));
+
+   record = reader.next();
+
+   ASSERT_TRUE(record);
+   EXPECT_EQ(record->op, Draw_stream_op::present);
+   EXPECT_FALSE(reader.next());
+   EXPECT_TRUE(reader.valid());
+}
+
+TEST(Draw_stream, objects_get_ids_in_the_order_they_are_seen)
+{
+   Draw_stream_recorder recorder{1};
+
+   const std::array<int, 2> objects{};
+
+   EXPECT_EQ(recorder.object(nullptr), draw_stream_null_object);
+   EXPECT_EQ(recorder.object(&objects[1]), 1);
+   EXPECT_EQ(recorder.object(&objects[0]), 2);
+   EXPECT_EQ(recorder.object(&objects[1]), 1);
+}
+
+TEST(Draw_stream, truncated_records_invalidate_the_reader)
+{
+   Draw_stream_recorder recorder{1};
+
+   recorder.record(
+      draw_stream::Draw{.topology = 4, .vertex_count = 3, .start_vertex = 0});
+
+   auto stream = recorder.stream();
+   stream.pop_back();
+
+   Draw_stream_reader reader{stream};
+
+   ASSERT_TRUE(reader.valid());
+   EXPECT_FALSE(reader.next());
+   EXPECT_FALSE(reader.valid());
+}
+
+TEST(Draw_stream, truncated_constants_invalidate_the_reader)
+{
+   Draw_stream_recorder recorder{1};
+
+   const std::array<std::byte, 16> constants{};
+
+   recorder.record_constants(Draw_stream_cb::scene, 0, constants);
+
+   auto stream = recorder.stream();
+   stream.resize(stream.size() - 4);
+
+   Draw_stream_reader reader{stream};
+
+   EXPECT_FALSE(reader.next());
+   EXPECT_FALSE(reader.valid());
+}
+
+TEST(Draw_stream, unknown_ops_invalidate_the_reader)
+{
+   auto stream = Draw_stream_recorder{1}.stream();
+   stream.push_back(std::byte{0xff});
+
+   Draw_stream_reader reader{stream};
+
+   EXPECT_FALSE(reader.next());
+   EXPECT_FALSE(reader.valid());
+}
+
+TEST(Draw_stream, bad_headers_are_rejected)
+{
+   auto stream = Draw_stream_recorder{1}.stream();
+
+   EXPECT_FALSE(Draw_stream_reader{std::span{stream}.first(4)}.valid());
+
+   stream[0] = std::byte{'x'};
+
+   EXPECT_FALSE(Draw_stream_reader{stream}.valid());
+
+   auto old_version = Draw_stream_recorder{1}.stream();
+   old_version[4] = std::byte{1};
+
+   EXPECT_FALSE(Draw_stream_reader{old_version}.valid());
+}
+
+}
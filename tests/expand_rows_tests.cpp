@@ -0,0 +1,117 @@
+
+#include "direct3d/expand_rows.hpp"
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp::d3d9 {
+
+namespace {
+
+// Covers empty rows, rows shorter than one vector, exact multiples of both
+// kernels' vector widths and rows with a leftover tail.
+constexpr std::array<std::uint32_t, 12> test_widths{0,  1,  7,  8,  9,   15,
+                                                    16, 17, 31, 33, 256, 1001};
+
+auto random_bytes(const std::size_t count, const std::uint32_t seed)
+   -> std::vector<std::byte>
+{
+   std::mt19937 engine{seed};
+   std::uniform_int_distribution<int> distribution{0, 255};
+
+   std::vector<std::byte> bytes(count);
+
+   for (auto& b : bytes) b = static_cast<std::byte>(distribution(engine));
+
+   return bytes;
+}
+
+}
+
+TEST(Expand_rows, l8_scalar_replicates_luminance_with_opaque_alpha)
+{
+   const std::array src{std::byte{0x00}, std::byte{0x7f}, std::byte{0xff}};
+   std::array<std::byte, 12> dest{};
+
+   expand_l8_row_scalar(src.data(), dest.data(), 3);
+
+   const std::array<std::byte, 12> expected{
+      std::byte{0x00}, std::byte{0x00}, std::byte{0x00}, std::byte{0xff},
+      std::byte{0x7f}, std::byte{0x7f}, std::byte{0x7f}, std::byte{0xff},
+      std::byte{0xff}, std::byte{0xff}, std::byte{0xff}, std::byte{0xff}};
+
+   EXPECT_EQ(dest, expected);
+}
+
+TEST(Expand_rows, a8l8_scalar_replicates_luminance_and_keeps_alpha)
+{
+   const std::array src{std::byte{0x10}, std::byte{0x20}, std::byte{0xf0},
+                        std::byte{0x00}};
+   std::array<std::byte, 8> dest{};
+
+   expand_a8l8_row_scalar(src.data(), dest.data(), 2);
+
+   const std::array<std::byte, 8> expected{std::byte{0x10}, std::byte{0x10},
+                                           std::byte{0x10}, std::byte{0x20},
+                                           std::byte{0xf0}, std::byte{0xf0},
+                                           std::byte{0xf0}, std::byte{0x00}};
+
+   EXPECT_EQ(dest, expected);
+}
+
+TEST(Expand_rows, l8_matches_scalar)
+{
+   for (const std::uint32_t width : test_widths) {
+      const auto src = random_bytes(width, width);
+
+      // Guard bytes past the end of the row catch overlong stores.
+      std::vector<std::byte> dest(width * 4 + 16, std::byte{0xcd});
+      std::vector<std::byte> expected(width * 4 + 16, std::byte{0xcd});
+
+      expand_l8_row(src.data(), dest.data(), width);
+      expand_l8_row_scalar(src.data(), expected.data(), width);
+
+      EXPECT_EQ(dest, expected) << "width " << width;
+   }
+}
+
+TEST(Expand_rows, a8l8_matches_scalar)
+{
+   for (const std::uint32_t width : test_widths) {
+      const auto src = random_bytes(width * 2, width);
+
+      std::vector<std::byte> dest(width * 4 + 16, std::byte{0xcd});
+      std::vector<std::byte> expected(width * 4 + 16, std::byte{0xcd});
+
+      expand_a8l8_row(src.data(), dest.data(), width);
+      expand_a8l8_row_scalar(src.data(), expected.data(), width);
+
+      EXPECT_EQ(dest, expected) << "width " << width;
+   }
+}
+
+TEST(Expand_rows, unaligned_rows_match_scalar)
+{
+   constexpr std::uint32_t width = 37;
+
+   const auto src = random_bytes(width * 2 + 1, 1234);
+
+   std::vector<std::byte> dest(width * 4 + 1);
+   std::vector<std::byte> expected(width * 4 + 1);
+
+   expand_l8_row(src.data() + 1, dest.data() + 1, width);
+   expand_l8_row_scalar(src.data() + 1, expected.data() + 1, width);
+
+   EXPECT_EQ(dest, expected);
+
+   expand_a8l8_row(src.data() + 1, dest.data() + 1, width);
+   expand_a8l8_row_scalar(src.data() + 1, expected.data() + 1, width);
+
+   EXPECT_EQ(dest, expected);
+}
+
+}
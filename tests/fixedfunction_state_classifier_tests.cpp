@@ -0,0 +1,159 @@
+
+#include "direct3d/fixedfunction_state_classifier.hpp"
+
+#include "synthetic_fixedfunction_states.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+namespace sp::d3d9 {
+
+namespace {
+
+using namespace tests;
+
+auto classify(const Fixedfunction_stage_values& values,
+              const std::uint32_t texture_factor) noexcept -> Fixedfunction_shader
+{
+   return classify_fixedfunction_state(
+      make_fixedfunction_state_key(values, classify_texture_factor(texture_factor)));
+}
+
+constexpr std::array texture_factors{white_factor, damage_factor, 0x00df2020u,
+                                     0xfffffffeu, 0x80ffffffu};
+
+}
+
+TEST(Fixedfunction_state_classifier, recognized_states)
+{
+   EXPECT_EQ(classify(color_fill_state(), 0xff000000u), Fixedfunction_shader::color_fill);
+   EXPECT_EQ(classify(modulate_state(), damage_factor),
+             Fixedfunction_shader::damage_overlay);
+   EXPECT_EQ(classify(modulate_state(), white_factor), Fixedfunction_shader::plain_texture);
+   EXPECT_EQ(classify(scene_blur_state(), 0x40ffffffu), Fixedfunction_shader::scene_blur);
+   EXPECT_EQ(classify(zoom_blur_state(), white_factor), Fixedfunction_shader::zoom_blur);
+   EXPECT_EQ(classify(zoom_blur_state(), 0x12345678u), Fixedfunction_shader::zoom_blur);
+
+   EXPECT_EQ(classify(modulate_state(), 0x80ffffffu), Fixedfunction_shader::unknown);
+}
+
+TEST(Fixedfunction_state_classifier, texture_factor_classes)
+{
+   EXPECT_EQ(classify_texture_factor(white_factor), Texture_factor_class::white);
+   EXPECT_EQ(classify_texture_factor(0x00ffffffu), Texture_factor_class::other);
+   EXPECT_EQ(classify_texture_factor(0xffdf2021u), Texture_factor_class::other);
+   EXPECT_EQ(classify_texture_factor(0u), Texture_factor_class::other);
+
+   for (std::uint32_t alpha = 0; alpha < 256; ++alpha) {
+      EXPECT_EQ(classify_texture_factor((alpha << 24) | 0xdf2020u),
+                Texture_factor_class::damage_color);
+   }
+}
+
+TEST(Fixedfunction_state_classifier, key_layout)
+{
+   const Fixedfunction_stage_values values{
+      .stages = {{{1, 2, 3, 4, 5, 6}, {7, 8, 9, 10, 11, 0x100}}},
+      .stage2_colorop = 13,
+      .stage2_alphaop = 0xffffffffu};
+
+   EXPECT_EQ(make_fixedfunction_state_key(values, Texture_factor_class::white),
+             (Fixedfunction_state_key{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0xff, 13, 0xff,
+                                      2, 0}));
+}
+
+// Every combination of the values the patterns test for, and values they
+// don't, across every field the patterns look at.
+TEST(Fixedfunction_state_classifier, matches_reference_for_every_state)
+{
+   constexpr std::array ops{top_disable, top_selectarg1, top_selectarg2, top_modulate};
+   constexpr std::array args{ta_diffuse, ta_current, ta_texture, ta_tfactor};
+   constexpr std::array stage2_ops{top_disable, top_modulate};
+
+   const std::array stage1_args{zoom_blur_state().stages[1], modulate_state().stages[1],
+                                Fixedfunction_stage_values::Stage{0, ta_current,
+                                                                  ta_texture, 0,
+                                                                  ta_tfactor, ta_current}};
+
+   std::array<std::size_t, 6> shader_counts{};
+
+   for (std::uint32_t stage0 = 0; stage0 < 4096; ++stage0) {
+      const auto field = [stage0](const int i) { return (stage0 >> (i * 2)) & 3u; };
+
+      Fixedfunction_stage_values values{};
+
+      values.stages[0] = {ops[field(0)],  args[field(1)], args[field(2)],
+                          ops[field(3)], args[field(4)], args[field(5)]};
+
+      for (const auto& stage1 : stage1_args) {
+         values.stages[1] = stage1;
+
+         for (const auto colorop : ops) {
+            for (const auto alphaop : ops) {
+               values.stages[1].colorop = colorop;
+               values.stages[1].alphaop = alphaop;
+
+               for (const auto stage2_colorop : stage2_ops) {
+                  for (const auto stage2_alphaop : stage2_ops) {
+                     values.stage2_colorop = stage2_colorop;
+                     values.stage2_alphaop = stage2_alphaop;
+
+                     for (const auto texture_factor : texture_factors) {
+                        const auto shader = classify(values, texture_factor);
+
+                        ASSERT_EQ(shader,
+                                  classify_fixedfunction_reference(values, texture_factor))
+                           << "stage 0 " << stage0 << " texture factor " << std::hex
+                           << texture_factor;
+
+                        shader_counts[static_cast<std::size_t>(shader)] += 1;
+                     }
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   // Every shader must have been reached for the comparison to mean anything.
+   for (const auto count : shader_counts) EXPECT_GT(count, 0u);
+}
+
+// Values too large for a key byte must not alias the small values the patterns
+// test for.
+TEST(Fixedfunction_state_classifier, large_values_match_reference)
+{
+   using Stage = Fixedfunction_stage_values::Stage;
+
+   constexpr std::array stage_fields{&Stage::colorop,   &Stage::colorarg1,
+                                     &Stage::colorarg2, &Stage::alphaop,
+                                     &Stage::alphaarg1, &Stage::alphaarg2};
+
+   const std::array states{color_fill_state(), modulate_state(), scene_blur_state(),
+                           zoom_blur_state()};
+
+   for (const auto& state : states) {
+      for (std::size_t field = 0; field < 14; ++field) {
+         for (const std::uint32_t high_bits : {0x100u, 0x10000u, 0x80000000u}) {
+            auto values = state;
+
+            std::uint32_t& value =
+               field < 12 ? values.stages[field / 6].*stage_fields[field % 6]
+                          : (field == 12 ? values.stage2_colorop : values.stage2_alphaop);
+
+            value |= high_bits;
+
+            for (const auto texture_factor : texture_factors) {
+               EXPECT_EQ(classify(values, texture_factor),
+                         classify_fixedfunction_reference(values, texture_factor))
+                  << "field " << field << " high bits " << std::hex << high_bits;
+            }
+         }
+      }
+   }
+}
+
+}
@@ -0,0 +1,153 @@
+
+#include "game_support/font_cache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace sp::game_support {
+
+namespace {
+
+using namespace std::literals;
+
+class Font_cache_test : public testing::Test {
+protected:
+   void TearDown() override
+   {
+      std::error_code error;
+
+      std::filesystem::remove_all(directory, error);
+   }
+
+   auto entry_path() const -> std::filesystem::path
+   {
+      return directory / "atlas_0123456789abcdef_16_96.bin"sv;
+   }
+
+   const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() /
+      (std::string{"shader_patch_tests_"} +
+       testing::UnitTest::GetInstance()->current_test_info()->name());
+
+   const Font_cache_key key{.font_hash = 0x0123456789abcdef,
+                            .freetype_version = 2'13'2,
+                            .pixel_size = 16,
+                            .dpi = 96};
+
+   const std::vector<std::byte> payload = [] {
+      std::vector<std::byte> payload(1000);
+
+      for (std::size_t i = 0; i < payload.size(); ++i) {
+         payload[i] = static_cast<std::byte>(i * 7);
+      }
+
+      return payload;
+   }();
+};
+
+}
+
+TEST(Font_cache, hash_font_data_is_fnv_1a)
+{
+   EXPECT_EQ(hash_font_data({}), 0xcbf29ce484222325ull);
+
+   const std::byte a[] = {std::byte{'a'}};
+
+   EXPECT_EQ(hash_font_data(a), 0xaf63dc4c8601ec8cull);
+}
+
+TEST_F(Font_cache_test, saved_entries_load_back)
+{
+   save_font_cache(directory, "atlas"sv, key, payload);
+
+   ASSERT_TRUE(std::filesystem::exists(entry_path()));
+
+   const auto loaded = load_font_cache(directory, "atlas"sv, key);
+
+   ASSERT_TRUE(loaded);
+   EXPECT_EQ(*loaded, payload);
+}
+
+TEST_F(Font_cache_test, empty_payloads_round_trip)
+{
+   save_font_cache(directory, "atlas"sv, key, {});
+
+   const auto loaded = load_font_cache(directory, "atlas"sv, key);
+
+   ASSERT_TRUE(loaded);
+   EXPECT_TRUE(loaded->empty());
+}
+
+TEST_F(Font_cache_test, missing_entries_are_not_loaded)
+{
+   EXPECT_FALSE(load_font_cache(directory, "atlas"sv, key));
+
+   save_font_cache(directory, "atlas"sv, key, payload);
+
+   EXPECT_FALSE(load_font_cache(directory, "metrics"sv, key));
+}
+
+TEST_F(Font_cache_test, entries_for_another_key_are_not_loaded)
+{
+   save_font_cache(directory, "atlas"sv, key, payload);
+
+   // The FreeType version isn't part of the file name so this finds the entry
+   // and must reject it from the header.
+   Font_cache_key other_key = key;
+   other_key.freetype_version += 1;
+
+   EXPECT_FALSE(load_font_cache(directory, "atlas"sv, other_key));
+
+   other_key = key;
+   other_key.dpi = 144;
+
+   EXPECT_FALSE(load_font_cache(directory, "atlas"sv, other_key));
+}
+
+TEST_F(Font_cache_test, corrupt_payloads_are_not_loaded)
+{
+   save_font_cache(directory, "atlas"sv, key, payload);
+
+   {
+      std::fstream file{entry_path(), std::ios::binary | std::ios::in | std::ios::out};
+
+      file.seekp(-1, std::ios::end);
+      file.put('\xff');
+   }
+
+   EXPECT_FALSE(load_font_cache(directory, "atlas"sv, key));
+}
+
+TEST_F(Font_cache_test, truncated_entries_are_not_loaded)
+{
+   save_font_cache(directory, "atlas"sv, key, payload);
+
+   const auto size = std::filesystem::file_size(entry_path());
+
+   std::filesystem::resize_file(entry_path(), size - 1);
+
+   EXPECT_FALSE(load_font_cache(directory, "atlas"sv, key));
+
+   std::filesystem::resize_file(entry_path(), 16);
+
+   EXPECT_FALSE(load_font_cache(directory, "atlas"sv, key));
+}
+
+TEST_F(Font_cache_test, saving_replaces_the_previous_entry)
+{
+   save_font_cache(directory, "atlas"sv, key, payload);
+
+   const std::vector<std::byte> new_payload(10, std::byte{0x42});
+
+   save_font_cache(directory, "atlas"sv, key, new_payload);
+
+   const auto loaded = load_font_cache(directory, "atlas"sv, key);
+
+   ASSERT_TRUE(loaded);
+   EXPECT_EQ(*loaded, new_payload);
+}
+
+}
@@ -0,0 +1,259 @@
+
+#include "effects/frame_graph.hpp"
+
+#include <gtest/gtest.h>
+
+namespace sp::effects {
+
+namespace {
+
+using Resource = Frame_graph::Resource;
+
+constexpr std::uint64_t process_class = 0;
+constexpr std::uint64_t near_mask_class = 1;
+constexpr std::uint64_t near_mask_blur_class = 2;
+constexpr std::uint64_t compose_class = 3;
+
+struct Dof_graph {
+   Frame_graph graph;
+
+   Resource prepare_near;
+   Resource prepare_far;
+   Resource near_mask;
+   Resource near_mask_blur_x;
+   Resource gather_near;
+   Resource gather_far;
+   Resource floodfill_near;
+   Resource floodfill_far;
+   Resource compose;
+};
+
+// The passes Postprocess declares for depth of field. When processing at full
+// resolution the compose target has the same desc (and so alias class) as the
+// processing targets.
+auto make_dof_graph(const std::uint32_t width, const std::uint32_t height,
+                    const std::uint32_t process_factor,
+                    const std::uint32_t near_mask_factor) -> Dof_graph
+{
+   const std::uint64_t process_size =
+      std::uint64_t{width / process_factor} * (height / process_factor) * 8;
+   const std::uint64_t near_mask_size =
+      std::uint64_t{(width / process_factor + near_mask_factor - 1) / near_mask_factor} *
+      ((height / process_factor + near_mask_factor - 1) / near_mask_factor);
+
+   Dof_graph dof;
+   Frame_graph& graph = dof.graph;
+
+   const auto process = [&](const std::string_view name) {
+      return graph.create_transient(
+         {.name = name, .alias_class = process_class, .size = process_size});
+   };
+
+   dof.prepare_near = process("DOF Prepare Near");
+   dof.prepare_far = process("DOF Prepare Far");
+   dof.near_mask = graph.create_transient({.name = "DOF Near Mask",
+                                           .alias_class = near_mask_class,
+                                           .size = near_mask_size});
+   dof.near_mask_blur_x = graph.create_transient({.name = "DOF Near Mask Blur X",
+                                                  .alias_class = near_mask_blur_class,
+                                                  .size = near_mask_size});
+   dof.gather_near = process("DOF Gather Near");
+   dof.gather_far = process("DOF Gather Far");
+   dof.floodfill_near = process("DOF Floodfill Near");
+   dof.floodfill_far = process("DOF Floodfill Far");
+   dof.compose = graph.create_transient(
+      {.name = "DOF Compose",
+       .alias_class = process_factor == 1 ? process_class : compose_class,
+       .size = std::uint64_t{width} * height * 8});
+
+   graph.add_pass("Prepare", {}, {dof.prepare_near, dof.prepare_far});
+   graph.add_pass("Near Mask", {dof.prepare_near}, {dof.near_mask});
+   graph.add_pass("Blur X Near Mask", {dof.near_mask}, {dof.near_mask_blur_x});
+   graph.add_pass("Blur Y Near Mask", {dof.near_mask_blur_x}, {dof.near_mask});
+   graph.add_pass("Gather", {dof.prepare_near, dof.near_mask, dof.prepare_far},
+                  {dof.gather_near, dof.gather_far});
+   graph.add_pass("Floodfill", {dof.gather_near, dof.gather_far},
+                  {dof.floodfill_near, dof.floodfill_far});
+   graph.add_pass("Compose", {dof.floodfill_near, dof.floodfill_far}, {dof.compose});
+
+   return dof;
+}
+
+}
+
+TEST(Frame_graph, dof_full_resolution_aliases_like_the_hand_written_version)
+{
+   const Dof_graph dof = make_dof_graph(1920, 1080, 1, 16);
+   const Frame_graph_plan plan = plan_frame_graph(dof.graph);
+
+   EXPECT_TRUE(plan.errors.empty());
+
+   EXPECT_EQ(plan.slot(dof.floodfill_near), plan.slot(dof.prepare_near));
+   EXPECT_EQ(plan.slot(dof.floodfill_far), plan.slot(dof.prepare_far));
+   EXPECT_EQ(plan.slot(dof.compose), plan.slot(dof.gather_near));
+   EXPECT_NE(plan.slot(dof.gather_near), plan.slot(dof.prepare_near));
+   EXPECT_NE(plan.slot(dof.near_mask), plan.slot(dof.near_mask_blur_x));
+
+   constexpr std::uint64_t process_size = 1920ull * 1080ull * 8ull;
+   constexpr std::uint64_t near_mask_size = 120ull * 68ull;
+
+   EXPECT_EQ(plan.report.transient_count, 9u);
+   EXPECT_EQ(plan.report.slot_count, 6u);
+   EXPECT_EQ(plan.report.unaliased_bytes, 7 * process_size + 2 * near_mask_size);
+   EXPECT_EQ(plan.report.aliased_bytes, 4 * process_size + 2 * near_mask_size);
+   EXPECT_EQ(plan.report.peak_live_bytes, 4 * process_size + near_mask_size);
+}
+
+TEST(Frame_graph, dof_downsampled_compose_gets_its_own_slot)
+{
+   const Dof_graph dof = make_dof_graph(1920, 1080, 2, 8);
+   const Frame_graph_plan plan = plan_frame_graph(dof.graph);
+
+   EXPECT_TRUE(plan.errors.empty());
+
+   EXPECT_EQ(plan.slot(dof.floodfill_near), plan.slot(dof.prepare_near));
+   EXPECT_EQ(plan.slot(dof.floodfill_far), plan.slot(dof.prepare_far));
+   EXPECT_NE(plan.slot(dof.compose), plan.slot(dof.gather_near));
+   EXPECT_EQ(plan.report.slot_count, 7u);
+}
+
+TEST(Frame_graph, lifetimes_span_first_to_last_use)
+{
+   const Dof_graph dof = make_dof_graph(1920, 1080, 1, 16);
+   const Frame_graph_plan plan = plan_frame_graph(dof.graph);
+
+   const auto& prepare_near = plan.lifetimes[static_cast<std::size_t>(dof.prepare_near)];
+
+   EXPECT_EQ(prepare_near.first_pass, 0u);
+   EXPECT_EQ(prepare_near.last_pass, 4u);
+   EXPECT_EQ(prepare_near.first_write, 0u);
+
+   const auto& near_mask = plan.lifetimes[static_cast<std::size_t>(dof.near_mask)];
+
+   EXPECT_EQ(near_mask.first_pass, 1u);
+   EXPECT_EQ(near_mask.last_pass, 4u);
+
+   // The slot shared with the compose target is held until compose is done.
+   const auto& gather_near_slot = plan.slots[plan.slot(dof.gather_near)];
+
+   EXPECT_EQ(gather_near_slot.lifetime.first_pass, 4u);
+   EXPECT_EQ(gather_near_slot.lifetime.last_pass, 6u);
+}
+
+TEST(Frame_graph, read_before_write_is_reported)
+{
+   Frame_graph graph;
+
+   const auto a = graph.create_transient({.name = "A", .size = 16});
+   const auto b = graph.create_transient({.name = "B", .size = 16});
+
+   graph.add_pass("First", {a}, {b});
+   graph.add_pass("Second", {b}, {a});
+
+   const Frame_graph_plan plan = plan_frame_graph(graph);
+
+   ASSERT_EQ(plan.errors.size(), 1u);
+   EXPECT_EQ(plan.errors[0], "Pass 'First' reads transient 'A' before it is written.");
+}
+
+TEST(Frame_graph, imported_resources_are_never_aliased)
+{
+   Frame_graph graph;
+
+   const auto input = graph.import_resource("Input");
+   const auto a = graph.create_transient({.name = "A", .size = 64});
+   const auto b = graph.create_transient({.name = "B", .size = 64});
+
+   graph.add_pass("First", {input}, {a});
+   graph.add_pass("Second", {a}, {input});
+   graph.add_pass("Third", {input}, {b});
+
+   const Frame_graph_plan plan = plan_frame_graph(graph);
+
+   EXPECT_TRUE(plan.errors.empty());
+   EXPECT_EQ(plan.slot(input), Frame_graph_plan::no_slot);
+   EXPECT_EQ(plan.slot(a), plan.slot(b));
+   EXPECT_EQ(plan.report.transient_count, 2u);
+   EXPECT_EQ(plan.report.aliased_bytes, 64u);
+}
+
+TEST(Frame_graph, different_alias_classes_never_share)
+{
+   Frame_graph graph;
+
+   const auto a = graph.create_transient({.name = "A", .alias_class = 0, .size = 32});
+   const auto b = graph.create_transient({.name = "B", .alias_class = 1, .size = 32});
+
+   graph.add_pass("First", {}, {a});
+   graph.add_pass("Second", {}, {b});
+
+   const Frame_graph_plan plan = plan_frame_graph(graph);
+
+   EXPECT_NE(plan.slot(a), plan.slot(b));
+   EXPECT_EQ(plan.report.aliased_bytes, 64u);
+   EXPECT_EQ(plan.report.peak_live_bytes, 32u);
+}
+
+TEST(Frame_graph, unused_transients_get_no_slot)
+{
+   Frame_graph graph;
+
+   const auto used = graph.create_transient({.name = "Used", .size = 8});
+   const auto unused = graph.create_transient({.name = "Unused", .size = 8});
+
+   graph.add_pass("Only", {}, {used});
+
+   const Frame_graph_plan plan = plan_frame_graph(graph);
+
+   EXPECT_NE(plan.slot(used), Frame_graph_plan::no_slot);
+   EXPECT_EQ(plan.slot(unused), Frame_graph_plan::no_slot);
+   EXPECT_EQ(plan.report.transient_count, 1u);
+}
+
+TEST(Frame_graph, replanning_a_cleared_graph_matches_a_fresh_plan)
+{
+   Dof_graph dof = make_dof_graph(1920, 1080, 1, 16);
+   Frame_graph_plan plan;
+
+   plan_frame_graph(dof.graph, plan);
+
+   dof.graph.clear();
+
+   EXPECT_EQ(dof.graph.resource_count(), 0u);
+   EXPECT_EQ(dof.graph.pass_count(), 0u);
+
+   const Dof_graph downsampled = make_dof_graph(1920, 1080, 2, 8);
+
+   plan_frame_graph(downsampled.graph, plan);
+
+   const Frame_graph_plan fresh = plan_frame_graph(downsampled.graph);
+
+   EXPECT_EQ(plan.resource_slots, fresh.resource_slots);
+   EXPECT_EQ(plan.report.slot_count, fresh.report.slot_count);
+   EXPECT_EQ(plan.report.aliased_bytes, fresh.report.aliased_bytes);
+   EXPECT_EQ(plan.report.peak_live_bytes, fresh.report.peak_live_bytes);
+}
+
+TEST(Frame_graph, pass_reads_and_writes_round_trip)
+{
+   Frame_graph graph;
+
+   const auto a = graph.create_transient({.name = "A"});
+   const auto b = graph.create_transient({.name = "B"});
+   const auto c = graph.create_transient({.name = "C"});
+
+   graph.add_pass("First", {}, {a, b});
+   graph.add_pass("Second", {a, b}, {c});
+
+   ASSERT_EQ(graph.pass_count(), 2u);
+   EXPECT_EQ(graph.pass_name(1), "Second");
+   EXPECT_TRUE(graph.reads(0).empty());
+   ASSERT_EQ(graph.writes(0).size(), 2u);
+   EXPECT_EQ(graph.writes(0)[1], b);
+   ASSERT_EQ(graph.reads(1).size(), 2u);
+   EXPECT_EQ(graph.reads(1)[0], a);
+   ASSERT_EQ(graph.writes(1).size(), 1u);
+   EXPECT_EQ(graph.writes(1)[0], c);
+}
+
+}
@@ -0,0 +1,117 @@
+
+#include "core/text/glyph_atlas.hpp"
+
+#include <cstring>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+namespace sp::core::text {
+
+namespace {
+
+auto make_atlas(const std::uint32_t width, const std::uint32_t height) -> Glyph_atlas
+{
+   Glyph_atlas atlas{.width = width, .height = height, .locations = {}, .pixels = {}};
+
+   atlas.pixels.resize(std::size_t{width} * height);
+
+   for (std::size_t i = 0; i < atlas.pixels.size(); ++i) {
+      atlas.pixels[i] = static_cast<std::byte>(i * 13);
+   }
+
+   for (std::size_t i = 0; i < atlas.locations.size(); ++i) {
+      const float x = static_cast<float>(i % width);
+      const float y = static_cast<float>(i % height);
+
+      atlas.locations[i] = {.left = (x + 0.5f) / width,
+                            .right = (x + 1.5f) / width,
+                            .top = (y + 0.5f) / height,
+                            .bottom = (y + 1.5f) / height};
+   }
+
+   return atlas;
+}
+
+// Offset of the first glyph location in a serialized atlas.
+constexpr std::size_t locations_offset = 8;
+
+}
+
+TEST(Glyph_atlas, serialized_atlases_round_trip)
+{
+   const Glyph_atlas atlas = make_atlas(64, 32);
+
+   const auto payload = serialize_atlas(atlas);
+   const auto loaded = deserialize_atlas(payload);
+
+   ASSERT_TRUE(loaded);
+   EXPECT_EQ(loaded->width, atlas.width);
+   EXPECT_EQ(loaded->height, atlas.height);
+   EXPECT_EQ(loaded->pixels, atlas.pixels);
+   EXPECT_EQ(std::memcmp(loaded->locations.data(), atlas.locations.data(),
+                         sizeof(atlas.locations)),
+             0);
+}
+
+TEST(Glyph_atlas, glyphs_touching_the_far_edges_are_accepted)
+{
+   Glyph_atlas atlas = make_atlas(16, 16);
+
+   atlas.locations[0] = {.left = 0.0f,
+                         .right = 16.5f / 16.0f,
+                         .top = 0.0f,
+                         .bottom = 16.5f / 16.0f};
+
+   EXPECT_TRUE(deserialize_atlas(serialize_atlas(atlas)));
+}
+
+TEST(Glyph_atlas, truncated_payloads_are_rejected)
+{
+   const auto payload = serialize_atlas(make_atlas(64, 32));
+
+   EXPECT_FALSE(deserialize_atlas({}));
+   EXPECT_FALSE(deserialize_atlas(std::span{payload}.first(payload.size() - 1)));
+   EXPECT_FALSE(deserialize_atlas(std::span{payload}.first(locations_offset)));
+}
+
+TEST(Glyph_atlas, trailing_bytes_are_rejected)
+{
+   auto payload = serialize_atlas(make_atlas(64, 32));
+
+   payload.push_back(std::byte{0});
+
+   EXPECT_FALSE(deserialize_atlas(payload));
+}
+
+TEST(Glyph_atlas, impossible_sizes_are_rejected)
+{
+   EXPECT_FALSE(deserialize_atlas(serialize_atlas(Glyph_atlas{})));
+
+   // Claims to be wider than any atlas that could be built, with the pixels to
+   // match so only the size check can catch it.
+   EXPECT_FALSE(deserialize_atlas(serialize_atlas(make_atlas(8193, 1))));
+}
+
+TEST(Glyph_atlas, out_of_range_locations_are_rejected)
+{
+   const auto reject = [](const Glyph_location location) {
+      Glyph_atlas atlas = make_atlas(16, 16);
+
+      atlas.locations[5] = location;
+
+      return !deserialize_atlas(serialize_atlas(atlas));
+   };
+
+   constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+
+   EXPECT_TRUE(reject({.left = -0.1f, .right = 0.5f, .top = 0.0f, .bottom = 0.5f}));
+   EXPECT_TRUE(reject({.left = 0.5f, .right = 0.25f, .top = 0.0f, .bottom = 0.5f}));
+   EXPECT_TRUE(reject({.left = 0.0f, .right = 1.5f, .top = 0.0f, .bottom = 0.5f}));
+   EXPECT_TRUE(reject({.left = 0.0f, .right = 0.5f, .top = 0.5f, .bottom = 0.25f}));
+   EXPECT_TRUE(reject({.left = 0.0f, .right = 0.5f, .top = 0.0f, .bottom = 1.5f}));
+   EXPECT_TRUE(reject({.left = nan, .right = 0.5f, .top = 0.0f, .bottom = 0.5f}));
+   EXPECT_TRUE(reject({.left = 0.0f, .right = 0.5f, .top = 0.0f, .bottom = nan}));
+}
+
+}
@@ -0,0 +1,192 @@
+
+#include "log_tail.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+namespace sp {
+
+namespace {
+
+class Log_tail_test : public testing::Test {
+protected:
+   void TearDown() override
+   {
+      std::error_code error;
+
+      std::filesystem::remove(path, error);
+   }
+
+   void write(const std::string_view text) const
+   {
+      std::ofstream{path, std::ios::binary}.write(text.data(), text.size());
+   }
+
+   void append(const std::string_view text) const
+   {
+      std::ofstream{path, std::ios::binary | std::ios::app}.write(text.data(),
+                                                                  text.size());
+   }
+
+   const std::filesystem::path path =
+      std::filesystem::temp_directory_path() /
+      (std::string{"shader_patch_tests_"} +
+       testing::UnitTest::GetInstance()->current_test_info()->name() + ".log");
+};
+
+}
+
+TEST_F(Log_tail_test, reads_complete_lines_and_holds_partial_ones)
+{
+   write("Header line\r\nMessage Severity: 2\r\nfile.cpp(1)\r\nhel");
+
+   Log_tail tail{path};
+
+   auto update = tail.poll();
+
+   EXPECT_FALSE(update.reset);
+   ASSERT_EQ(update.lines.size(), 3u);
+   EXPECT_EQ(update.lines[0], "Header line");
+   EXPECT_EQ(update.lines[1], "Message Severity: 2");
+   EXPECT_EQ(update.lines[2], "file.cpp(1)");
+
+   append("lo\r\n\r\nx");
+
+   update = tail.poll();
+
+   EXPECT_FALSE(update.reset);
+   ASSERT_EQ(update.lines.size(), 2u);
+   EXPECT_EQ(update.lines[0], "hello");
+   EXPECT_EQ(update.lines[1], "");
+}
+
+TEST_F(Log_tail_test, polls_with_nothing_appended_return_nothing)
+{
+   write("one\ntwo\n");
+
+   Log_tail tail{path};
+
+   EXPECT_EQ(tail.poll().lines.size(), 2u);
+
+   const auto update = tail.poll();
+
+   EXPECT_FALSE(update.reset);
+   EXPECT_TRUE(update.lines.empty());
+}
+
+TEST_F(Log_tail_test, replaced_file_resets)
+{
+   write("First run\n");
+
+   Log_tail tail{path};
+
+   EXPECT_EQ(tail.poll().lines.size(), 1u);
+
+   write("Other\n");
+
+   const auto update = tail.poll();
+
+   EXPECT_TRUE(update.reset);
+   ASSERT_EQ(update.lines.size(), 1u);
+   EXPECT_EQ(update.lines[0], "Other");
+}
+
+TEST_F(Log_tail_test, truncated_file_resets)
+{
+   write("A long first line\nsecond\n");
+
+   Log_tail tail{path};
+
+   EXPECT_EQ(tail.poll().lines.size(), 2u);
+
+   write("A\n");
+
+   const auto update = tail.poll();
+
+   EXPECT_TRUE(update.reset);
+   ASSERT_EQ(update.lines.size(), 1u);
+   EXPECT_EQ(update.lines[0], "A");
+}
+
+TEST_F(Log_tail_test, removed_file_resets_once)
+{
+   write("line\n");
+
+   Log_tail tail{path};
+
+   EXPECT_EQ(tail.poll().lines.size(), 1u);
+
+   std::filesystem::remove(path);
+
+   EXPECT_TRUE(tail.poll().reset);
+   EXPECT_FALSE(tail.poll().reset);
+}
+
+TEST_F(Log_tail_test, initial_read_is_limited_and_skips_the_cut_line)
+{
+   write("0123456789\nabcdefghij\nklmnopqrst\n");
+
+   Log_tail tail{path, 16};
+
+   const auto update = tail.poll();
+
+   ASSERT_EQ(update.lines.size(), 1u);
+   EXPECT_EQ(update.lines[0], "klmnopqrst");
+}
+
+TEST(Log_filter, empty_pattern_matches_everything)
+{
+   const Log_filter filter{""};
+
+   EXPECT_TRUE(filter.matches_everything());
+   EXPECT_TRUE(filter.matches("anything"));
+}
+
+TEST(Log_filter, literal_is_a_case_insensitive_substring)
+{
+   const Log_filter filter{"Thing 12"};
+
+   EXPECT_FALSE(filter.matches_everything());
+   EXPECT_TRUE(filter.matches("some message about thing 123"));
+   EXPECT_TRUE(filter.matches("THING 12"));
+   EXPECT_FALSE(filter.matches("thing 2"));
+   EXPECT_FALSE(filter.matches(""));
+}
+
+TEST(Log_filter, escaped_syntax_stays_literal)
+{
+   const Log_filter filter{"file1\\.cpp"};
+
+   EXPECT_TRUE(filter.matches("a/FILE1.CPP"));
+   EXPECT_FALSE(filter.matches("a/file1xcpp"));
+}
+
+TEST(Log_filter, anchored_literal_is_a_prefix)
+{
+   const Log_filter filter{"^message sev"};
+
+   EXPECT_TRUE(filter.matches("Message Severity: 2"));
+   EXPECT_FALSE(filter.matches(" Message Severity: 2"));
+   EXPECT_FALSE(filter.matches("Message"));
+}
+
+TEST(Log_filter, regex_is_case_insensitive)
+{
+   const Log_filter filter{"file[0-9]+\\.cpp"};
+
+   EXPECT_TRUE(filter.matches("C:\\src\\FILE12.cpp(1)"));
+   EXPECT_FALSE(filter.matches("C:\\src\\file.cpp(1)"));
+}
+
+TEST(Log_filter, invalid_regex_matches_everything)
+{
+   const Log_filter filter{"("};
+
+   EXPECT_TRUE(filter.matches_everything());
+   EXPECT_TRUE(filter.matches("anything"));
+}
+
+}
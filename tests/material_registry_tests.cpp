@@ -0,0 +1,144 @@
+
+#include "material/material_registry.hpp"
+
+#include "synthetic_materials.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <set>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp::material {
+
+namespace {
+
+struct Fake_material {
+   std::string name;
+};
+
+using Registry = Basic_material_registry<Fake_material>;
+
+auto as_data(const std::string& str) -> std::span<const std::byte>
+{
+   return std::as_bytes(std::span{str});
+}
+
+// What Shader_patch::create_patch_material does with the registry, building
+// only materials it hasn't already got.
+auto load(Registry& registry, const std::span<const std::byte> data, std::size_t& builds)
+   -> Fake_material*
+{
+   if (auto* const material = registry.acquire(data); material) return material;
+
+   builds += 1;
+
+   return registry.insert(data, std::make_unique<Fake_material>());
+}
+
+}
+
+TEST(Material_registry, identical_data_shares_a_material)
+{
+   Registry registry;
+
+   const std::string sand = "sand";
+   const std::string rock = "rock";
+
+   EXPECT_EQ(registry.acquire(as_data(sand)), nullptr);
+
+   auto* const sand_material =
+      registry.insert(as_data(sand), std::make_unique<Fake_material>("sand"));
+   auto* const rock_material =
+      registry.insert(as_data(rock), std::make_unique<Fake_material>("rock"));
+
+   EXPECT_EQ(registry.acquire(as_data(std::string{"sand"})), sand_material);
+   EXPECT_NE(sand_material, rock_material);
+   EXPECT_EQ(registry.materials().size(), 2);
+   EXPECT_EQ(registry.reference_count(), 3);
+}
+
+TEST(Material_registry, materials_are_returned_on_their_last_release)
+{
+   Registry registry;
+
+   const std::string sand = "sand";
+
+   auto* const material =
+      registry.insert(as_data(sand), std::make_unique<Fake_material>("sand"));
+
+   registry.acquire(as_data(sand));
+
+   EXPECT_EQ(registry.release(material), nullptr);
+   EXPECT_FALSE(registry.empty());
+
+   const auto owned = registry.release(material);
+
+   EXPECT_EQ(owned.get(), material);
+   EXPECT_TRUE(registry.empty());
+   EXPECT_EQ(registry.reference_count(), 0);
+   EXPECT_EQ(registry.acquire(as_data(sand)), nullptr);
+}
+
+TEST(Material_registry, removal_keeps_moved_materials_findable)
+{
+   Registry registry;
+
+   const std::vector<std::string> names{"sand", "rock", "grass", "snow"};
+   std::vector<Fake_material*> materials;
+
+   for (const auto& name : names) {
+      materials.push_back(
+         registry.insert(as_data(name), std::make_unique<Fake_material>(name)));
+   }
+
+   // Removing from the front moves the last material into its place.
+   EXPECT_TRUE(registry.release(materials[0]));
+   EXPECT_TRUE(registry.release(materials[1]));
+
+   ASSERT_EQ(registry.materials().size(), 2);
+
+   EXPECT_EQ(registry.acquire(as_data(names[2])), materials[2]);
+   EXPECT_EQ(registry.acquire(as_data(names[3])), materials[3]);
+
+   EXPECT_EQ(registry.release(materials[3]), nullptr);
+   EXPECT_TRUE(registry.release(materials[3]));
+   EXPECT_EQ(registry.release(materials[2]), nullptr);
+   EXPECT_TRUE(registry.release(materials[2]));
+   EXPECT_TRUE(registry.empty());
+}
+
+TEST(Material_registry, synthetic_levels_build_each_material_once)
+{
+   const auto blobs = tests::make_synthetic_levels(8, 96, 64);
+
+   std::set<std::vector<std::byte>> unique{blobs.begin(), blobs.end()};
+
+   Registry registry;
+   std::size_t builds = 0;
+   std::vector<Fake_material*> loaded;
+
+   for (const auto& blob : blobs) loaded.push_back(load(registry, blob, builds));
+
+   EXPECT_EQ(builds, unique.size());
+   EXPECT_EQ(registry.materials().size(), unique.size());
+   EXPECT_EQ(registry.reference_count(), blobs.size());
+   EXPECT_LT(builds * 4, blobs.size());
+
+   for (std::size_t i = 0; i < blobs.size(); ++i) {
+      EXPECT_EQ(registry.acquire(blobs[i]), loaded[i]);
+      registry.release(loaded[i]);
+   }
+
+   std::size_t returned = 0;
+
+   for (auto* material : loaded) returned += registry.release(material) != nullptr;
+
+   EXPECT_EQ(returned, unique.size());
+   EXPECT_TRUE(registry.empty());
+}
+
+}
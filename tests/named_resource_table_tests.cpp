@@ -0,0 +1,152 @@
+
+#include "core/named_resource_table.hpp"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+namespace sp::core {
+
+namespace {
+
+using Table = Named_resource_table<std::shared_ptr<int>>;
+
+}
+
+TEST(Named_resource_table, finds_resources_by_name_and_pointer)
+{
+   Table table;
+
+   auto resource = std::make_shared<int>(1);
+
+   table.insert(resource, "sky");
+
+   EXPECT_EQ(table.find("sky"), resource.get());
+   EXPECT_EQ(table.find("ground"), nullptr);
+   EXPECT_EQ(table.reverse_lookup(resource.get()), "sky");
+   EXPECT_EQ(table.reverse_lookup(nullptr), std::nullopt);
+}
+
+TEST(Named_resource_table, inserting_a_name_again_replaces_the_resource)
+{
+   Table table;
+
+   auto placeholder = std::make_shared<int>(0);
+   auto loaded = std::make_shared<int>(1);
+
+   table.insert(placeholder, "sky");
+   table.insert(loaded, "sky");
+
+   EXPECT_EQ(table.find("sky"), loaded.get());
+   EXPECT_EQ(table.reverse_lookup(placeholder.get()), std::nullopt);
+   EXPECT_EQ(std::distance(table.begin(), table.end()), 1);
+}
+
+TEST(Named_resource_table, deferred_resources_load_on_first_find)
+{
+   Table table;
+
+   int loads = 0;
+
+   table.insert_deferred(
+      [&] {
+         loads += 1;
+
+         return std::make_shared<int>(2);
+      },
+      "sky");
+
+   EXPECT_EQ(loads, 0);
+
+   auto* const resource = table.find("sky");
+
+   ASSERT_NE(resource, nullptr);
+   EXPECT_EQ(*resource, 2);
+   EXPECT_EQ(table.find("sky"), resource);
+   EXPECT_EQ(loads, 1);
+}
+
+TEST(Named_resource_table, failed_deferred_loads_are_dropped)
+{
+   Table table;
+
+   int loads = 0;
+
+   table.insert_deferred(
+      [&] {
+         loads += 1;
+
+         return std::shared_ptr<int>{};
+      },
+      "sky");
+
+   EXPECT_EQ(table.find("sky"), nullptr);
+   EXPECT_EQ(table.find("sky"), nullptr);
+   EXPECT_EQ(loads, 1);
+}
+
+TEST(Named_resource_table, deferred_inserts_never_replace_resources)
+{
+   Table table;
+
+   auto resource = std::make_shared<int>(1);
+
+   table.insert(resource, "sky");
+   table.insert_deferred([] { return std::make_shared<int>(2); }, "sky");
+
+   EXPECT_EQ(table.find("sky"), resource.get());
+}
+
+TEST(Named_resource_table, inserts_replace_deferred_resources)
+{
+   Table table;
+
+   auto resource = std::make_shared<int>(1);
+
+   table.insert_deferred([] { return std::make_shared<int>(2); }, "sky");
+   table.insert(resource, "sky");
+
+   EXPECT_EQ(table.find("sky"), resource.get());
+}
+
+TEST(Named_resource_table, load_all_deferred_creates_every_resource)
+{
+   Table table;
+
+   table.insert_deferred([] { return std::make_shared<int>(1); }, "sky");
+   table.insert_deferred([] { return std::make_shared<int>(2); }, "ground");
+
+   table.load_all_deferred();
+
+   EXPECT_EQ(std::distance(table.begin(), table.end()), 2);
+}
+
+TEST(Named_resource_table, changes_bump_the_generation)
+{
+   Table table;
+
+   auto resource = std::make_shared<int>(1);
+
+   auto generation = table.generation();
+
+   const auto bumped = [&] {
+      return std::exchange(generation, table.generation()) != table.generation();
+   };
+
+   table.insert(resource, "sky");
+   EXPECT_TRUE(bumped());
+
+   table.insert_deferred([] { return std::make_shared<int>(2); }, "ground");
+   EXPECT_TRUE(bumped());
+
+   table.find("sky");
+   EXPECT_FALSE(bumped());
+
+   EXPECT_TRUE(table.erase(resource.get()));
+   EXPECT_TRUE(bumped());
+
+   EXPECT_FALSE(table.erase(resource.get()));
+   EXPECT_FALSE(bumped());
+}
+
+}
@@ -0,0 +1,157 @@
+
+#include "parallel_edit.hpp"
+
+#include "synthetic_vertex_buffer.hpp"
+#include "vertex_buffer_codec.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <tbb/global_control.h>
+#include <tbb/task_arena.h>
+
+namespace sp {
+
+namespace {
+
+using tests::Vertex_buffer;
+
+const tests::Position_compress pos_compress{.min = {-64.0f, -64.0f, -64.0f},
+                                            .div = {128.0f, 128.0f, 128.0f}};
+
+struct Segment {
+   Vertex_buffer vertex_buffer;
+   bool compressed;
+};
+
+// Segments of every size up to a few thousand vertices, each with a different
+// subset of the attributes, so threads' staging both grows and shrinks
+// between the segments they output.
+auto make_segments(const std::size_t count) -> std::vector<Segment>
+{
+   std::mt19937 random{0};
+   std::uniform_int_distribution<std::size_t> vertex_count{0, 3000};
+   std::vector<Segment> segments;
+
+   for (std::size_t i = 0; i < count; ++i) {
+      auto buffer = tests::make_synthetic_vertex_buffer(vertex_count(random),
+                                                        static_cast<std::uint32_t>(i));
+      const auto keep = random();
+
+      if (!(keep & 0b1)) buffer.positions = nullptr;
+      if (!(keep & 0b10)) buffer.blendweights = nullptr;
+      if (!(keep & 0b100)) buffer.normals = nullptr;
+      if (!(keep & 0b1000)) {
+         buffer.tangents = nullptr;
+         buffer.bitangent_signs = nullptr;
+         buffer.binormals = nullptr;
+      }
+      if (!(keep & 0b10000)) buffer.static_lighting_colors = nullptr;
+      if (!(keep & 0b100000)) buffer.texcoords = nullptr;
+
+      segments.push_back({.vertex_buffer = std::move(buffer),
+                          .compressed = (keep & 0b1000000) != 0});
+   }
+
+   return segments;
+}
+
+// Runs on eight threads however many cores the machine has, so scratch shared
+// between threads would show up. libstdc++'s parallel algorithms run in the
+// caller's TBB arena.
+template<typename Run>
+void on_eight_threads(const Run& run)
+{
+   tbb::global_control control{tbb::global_control::max_allowed_parallelism, 8};
+   tbb::task_arena arena{8};
+
+   arena.execute(run);
+}
+
+// What output_vertex_buffer writes for a segment.
+auto output_segment(const Segment& segment) -> std::vector<std::byte>
+{
+   const auto flags = get_vbuf_flags(segment.vertex_buffer, segment.compressed);
+   const auto staged =
+      encode_vbuf_vertices_staged(segment.vertex_buffer, flags, pos_compress);
+
+   return {staged.begin(), staged.end()};
+}
+
+}
+
+// Segments output in parallel, through their threads' reused staging, are
+// byte-identical to outputting them one after another.
+TEST(Parallel_edit, segments_match_serial_output)
+{
+   const auto segments = make_segments(512);
+
+   std::vector<std::vector<std::byte>> serial;
+
+   for (const auto& segment : segments) serial.push_back(output_segment(segment));
+
+   for (int run = 0; run < 4; ++run) {
+      std::vector<std::vector<std::byte>> parallel(segments.size());
+
+      on_eight_threads([&] {
+         edit_in_parallel(segments.size(), [&](const std::size_t i) {
+            parallel[i] = output_segment(segments[i]);
+         });
+      });
+
+      for (std::size_t i = 0; i < segments.size(); ++i) {
+         ASSERT_EQ(parallel[i], serial[i]) << "segment " << i << " run " << run;
+      }
+   }
+
+   for (std::size_t i = 0; i < segments.size(); ++i) {
+      const auto& segment = segments[i];
+      const auto flags = get_vbuf_flags(segment.vertex_buffer, segment.compressed);
+
+      ASSERT_EQ(serial[i], tests::reference_vbuf::encode(segment.vertex_buffer,
+                                                          flags, pos_compress))
+         << "segment " << i;
+   }
+}
+
+TEST(Parallel_edit, rethrows_lowest_index_error)
+{
+   constexpr std::size_t count = 10000;
+
+   for (int run = 0; run < 8; ++run) {
+      std::vector<char> edited(count);
+
+      try {
+         on_eight_threads([&] {
+            edit_in_parallel(count, [&](const std::size_t i) {
+               edited[i] = true;
+
+               if (i % 997 == 613) throw std::runtime_error{std::to_string(i)};
+            });
+         });
+
+         FAIL() << "no error was rethrown";
+      }
+      catch (std::runtime_error& e) {
+         EXPECT_EQ(std::string{e.what()}, "613");
+      }
+
+      // Unlike a serial loop every edit still runs, patch_model writes nothing
+      // out for a file that failed either way.
+      EXPECT_EQ(std::count(edited.begin(), edited.end(), true),
+                static_cast<std::ptrdiff_t>(count));
+   }
+}
+
+TEST(Parallel_edit, no_edits)
+{
+   edit_in_parallel(0, [](const std::size_t) { FAIL(); });
+}
+
+}
@@ -0,0 +1,144 @@
+
+#include "effects/profile_trace.hpp"
+
+#include <array>
+#include <cstdint>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp::effects {
+
+namespace {
+
+auto cpu_event(const Profile_section_id section, const std::uint16_t depth,
+               const std::uint64_t begin_ns, const std::uint64_t end_ns) -> Profile_event
+{
+   return {.section = section,
+           .timeline = Profile_timeline::cpu,
+           .depth = depth,
+           .thread = 0,
+           .begin_ns = begin_ns,
+           .end_ns = end_ns};
+}
+
+}
+
+TEST(Profile_trace, names_are_interned_once)
+{
+   Profile_section_names names;
+
+   const auto bloom = names.intern("Bloom");
+   const auto tonemap = names.intern("Tonemap");
+
+   EXPECT_NE(bloom, tonemap);
+   EXPECT_EQ(names.intern("Bloom"), bloom);
+   EXPECT_EQ(names.name(bloom), "Bloom");
+   EXPECT_EQ(names.name(tonemap), "Tonemap");
+}
+
+TEST(Profile_trace, full_buffers_drop_events)
+{
+   Profile_event_buffer buffer{2};
+
+   EXPECT_TRUE(buffer.push(cpu_event(Profile_section_id{0}, 0, 0, 10)));
+   EXPECT_TRUE(buffer.push(cpu_event(Profile_section_id{1}, 1, 2, 8)));
+   EXPECT_FALSE(buffer.push(cpu_event(Profile_section_id{2}, 1, 8, 9)));
+
+   ASSERT_EQ(buffer.events().size(), 2);
+   EXPECT_EQ(buffer.events()[1].section, Profile_section_id{1});
+   EXPECT_EQ(buffer.dropped(), 1);
+
+   buffer.clear();
+
+   EXPECT_TRUE(buffer.events().empty());
+   EXPECT_TRUE(buffer.push(cpu_event(Profile_section_id{2}, 0, 0, 1)));
+   EXPECT_EQ(buffer.events().size(), 1);
+}
+
+TEST(Profile_trace, pushes_from_many_threads_are_all_kept)
+{
+   constexpr std::uint32_t thread_count = 8;
+   constexpr std::uint64_t events_per_thread = 1000;
+
+   Profile_event_buffer buffer{thread_count * events_per_thread};
+
+   {
+      std::vector<std::jthread> threads;
+
+      for (std::uint32_t thread = 0; thread < thread_count; ++thread) {
+         threads.emplace_back([&buffer, thread] {
+            for (std::uint64_t i = 0; i < events_per_thread; ++i) {
+               Profile_event event = cpu_event(Profile_section_id{thread}, 0, i, i + 1);
+               event.thread = thread;
+
+               buffer.push(event);
+            }
+         });
+      }
+   }
+
+   std::array<std::uint64_t, thread_count> counts{};
+
+   for (const auto& event : buffer.events()) {
+      ASSERT_LT(event.thread, thread_count);
+      EXPECT_EQ(static_cast<std::uint32_t>(event.section), event.thread);
+
+      counts[event.thread] += 1;
+   }
+
+   for (const auto count : counts) EXPECT_EQ(count, events_per_thread);
+
+   EXPECT_EQ(buffer.dropped(), 0);
+}
+
+TEST(Profile_trace, captures_stop_after_their_frames)
+{
+   Profile_trace_capture capture{2};
+
+   const std::array events{cpu_event(Profile_section_id{0}, 0, 0, 10)};
+
+   capture.add_frame(events);
+
+   EXPECT_FALSE(capture.done());
+
+   capture.add_frame(events);
+   capture.add_frame(events);
+
+   EXPECT_TRUE(capture.done());
+   EXPECT_EQ(capture.event_count(), 2);
+}
+
+TEST(Profile_trace, chrome_trace_export)
+{
+   Profile_section_names names;
+
+   const auto frame = names.intern("Frame");
+   const auto quoted = names.intern("Say \"hi\"\\\n");
+
+   Profile_trace_capture capture{1};
+
+   capture.add_frame(std::array{cpu_event(frame, 0, 1000, 5500),
+                                Profile_event{.section = quoted,
+                                              .timeline = Profile_timeline::gpu,
+                                              .depth = 1,
+                                              .thread = 3,
+                                              .begin_ns = 2000,
+                                              .end_ns = 2250}});
+
+   std::ostringstream out;
+
+   capture.write_chrome_trace(out, names);
+
+   EXPECT_EQ(
+      out.str(),
+      R"({"displayTimeUnit":"ms","traceEvents":[{"name":"thread_name","ph":"M","pid":1,"tid":65536,"args":{"name":"GPU"}},
+{"name":"Frame","cat":"cpu","ph":"X","ts":1.000,"dur":4.500,"pid":1,"tid":0,"args":{"depth":0}},
+{"name":"Say \"hi\"\\\u000a","cat":"gpu","ph":"X","ts":2.000,"dur":0.250,"pid":1,"tid":65536,"args":{"depth":1}}
+]}
+)");
+}
+
+}
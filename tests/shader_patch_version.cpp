@@ -0,0 +1,14 @@
+
+#include "shader_patch_version.hpp"
+
+// The logger writes the version when it starts. The real definitions live in
+// shared/src/shader_patch_version.cpp, which needs GSL, so the tests stand in
+// for them.
+
+namespace sp {
+
+const Shader_patch_version current_shader_patch_version{};
+
+const std::string current_shader_patch_version_string = "tests";
+
+}
@@ -0,0 +1,150 @@
+
+#include "core/text/skyline_packer.hpp"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp::core::text {
+
+namespace {
+
+struct Rect {
+   std::uint32_t x;
+   std::uint32_t y;
+   std::uint32_t width;
+   std::uint32_t height;
+};
+
+bool overlaps(const Rect& l, const Rect& r) noexcept
+{
+   return l.x < r.x + r.width && r.x < l.x + l.width && l.y < r.y + r.height &&
+          r.y < l.y + l.height;
+}
+
+auto random_sizes(const std::uint32_t seed, const std::size_t count,
+                  const std::uint32_t max_size)
+   -> std::vector<std::pair<std::uint32_t, std::uint32_t>>
+{
+   std::mt19937 engine{seed};
+   std::uniform_int_distribution<std::uint32_t> size{1, max_size};
+
+   std::vector<std::pair<std::uint32_t, std::uint32_t>> sizes;
+
+   for (std::size_t i = 0; i < count; ++i) sizes.emplace_back(size(engine), size(engine));
+
+   return sizes;
+}
+
+}
+
+TEST(Skyline_packer, packed_rects_stay_in_bounds_and_never_overlap)
+{
+   constexpr std::uint32_t width = 256;
+   constexpr std::uint32_t max_height = 4096;
+
+   for (std::uint32_t seed = 0; seed < 50; ++seed) {
+      Skyline_packer packer{width, max_height};
+      std::vector<Rect> packed;
+
+      for (const auto& [w, h] : random_sizes(seed, 200, 40)) {
+         const auto position = packer.pack(w, h);
+
+         ASSERT_TRUE(position);
+         ASSERT_LE(position->x + w, width);
+         ASSERT_LE(position->y + h, packer.height());
+
+         const Rect rect{position->x, position->y, w, h};
+
+         for (const Rect& other : packed) ASSERT_FALSE(overlaps(rect, other));
+
+         packed.push_back(rect);
+      }
+
+      EXPECT_LE(packer.height(), max_height);
+   }
+}
+
+TEST(Skyline_packer, rects_that_do_not_fit_are_rejected)
+{
+   Skyline_packer packer{10, 10};
+
+   EXPECT_FALSE(packer.pack(11, 1));
+   EXPECT_FALSE(packer.pack(1, 11));
+
+   const auto position = packer.pack(10, 10);
+
+   ASSERT_TRUE(position);
+   EXPECT_EQ(position->x, 0u);
+   EXPECT_EQ(position->y, 0u);
+   EXPECT_EQ(packer.height(), 10u);
+
+   EXPECT_FALSE(packer.pack(1, 1));
+}
+
+TEST(Skyline_packer, rejected_rects_leave_the_skyline_unchanged)
+{
+   Skyline_packer packer{16, 8};
+
+   ASSERT_TRUE(packer.pack(8, 6));
+   EXPECT_FALSE(packer.pack(16, 4));
+
+   const auto position = packer.pack(8, 8);
+
+   ASSERT_TRUE(position);
+   EXPECT_EQ(position->x, 8u);
+   EXPECT_EQ(position->y, 0u);
+}
+
+TEST(Skyline_packer, rects_go_where_their_top_ends_up_lowest)
+{
+   Skyline_packer packer{16, 64};
+
+   ASSERT_TRUE(packer.pack(4, 8));
+   ASSERT_TRUE(packer.pack(4, 2));
+   ASSERT_TRUE(packer.pack(8, 4));
+
+   const auto position = packer.pack(4, 1);
+
+   ASSERT_TRUE(position);
+   EXPECT_EQ(position->x, 4u);
+   EXPECT_EQ(position->y, 2u);
+}
+
+TEST(Skyline_packer, zero_sized_rects_get_a_position_but_take_no_space)
+{
+   Skyline_packer packer{8, 8};
+
+   ASSERT_TRUE(packer.pack(0, 4));
+   ASSERT_TRUE(packer.pack(4, 0));
+   EXPECT_EQ(packer.height(), 0u);
+
+   const auto position = packer.pack(8, 8);
+
+   ASSERT_TRUE(position);
+   EXPECT_EQ(position->x, 0u);
+   EXPECT_EQ(position->y, 0u);
+}
+
+TEST(Skyline_packer, packing_is_deterministic)
+{
+   const auto sizes = random_sizes(1234, 300, 32);
+
+   const auto pack_all = [&] {
+      Skyline_packer packer{512, 8192};
+      std::vector<std::pair<std::uint32_t, std::uint32_t>> positions;
+
+      for (const auto& [w, h] : sizes) {
+         const auto position = packer.pack(w, h);
+
+         positions.emplace_back(position->x, position->y);
+      }
+
+      return positions;
+   };
+
+   EXPECT_EQ(pack_all(), pack_all());
+}
+
+}
@@ -0,0 +1,40 @@
+
+#include "shader/state_names.hpp"
+
+#include <gtest/gtest.h>
+
+namespace sp::shader {
+
+TEST(State_names, assigns_dense_ids_in_order)
+{
+   State_names names;
+
+   EXPECT_EQ(names.intern("unlit"), State_name_id{0});
+   EXPECT_EQ(names.intern("lit"), State_name_id{1});
+   EXPECT_EQ(names.intern("shadow"), State_name_id{2});
+   EXPECT_EQ(names.size(), 3u);
+}
+
+TEST(State_names, interning_a_name_again_returns_its_id)
+{
+   State_names names;
+
+   names.intern("unlit");
+   const auto lit = names.intern("lit");
+
+   EXPECT_EQ(names.intern("lit"), lit);
+   EXPECT_EQ(names.size(), 2u);
+}
+
+TEST(State_names, finds_names_and_ids)
+{
+   State_names names;
+
+   const auto lit = names.intern("lit");
+
+   EXPECT_EQ(names.find("lit"), lit);
+   EXPECT_EQ(names.find("unlit"), std::nullopt);
+   EXPECT_EQ(names.name(lit), "lit");
+}
+
+}
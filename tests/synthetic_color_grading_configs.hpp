@@ -0,0 +1,139 @@
+#pragma once
+
+#include "color_grading_config_block.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sp::tests {
+
+using namespace std::literals;
+
+constexpr std::array colorgrading_scalar_keys = {
+   "Saturation"sv,
+   "Exposure"sv,
+   "Brightness"sv,
+   "Contrast"sv,
+   "FilmicToeStrength"sv,
+   "FilmicToeLength"sv,
+   "FilmicShoulderStrength"sv,
+   "FilmicShoulderLength"sv,
+   "FilmicShoulderAngle"sv,
+   "FilmicHejiWhitepoint"sv,
+   "ShadowOffset"sv,
+   "MidtoneOffset"sv,
+   "HighlightOffset"sv,
+   "HSVHueAdjustment"sv,
+   "HSVSaturationAdjustment"sv,
+   "HSVValueAdjustment"sv,
+};
+
+constexpr std::array colorgrading_float3_keys = {
+   "ColorFilter"sv,   "ShadowColor"sv,     "MidtoneColor"sv,  "HighlightColor"sv,
+   "ChannelMixRed"sv, "ChannelMixGreen"sv, "ChannelMixBlue"sv,
+};
+
+constexpr std::array colorgrading_tonemapper_names = {
+   "Filmic"sv, "ACES sRGB Fitted"sv, "Filmic Heji 2015"sv, "Reinhard"sv, "None"sv,
+};
+
+constexpr std::array bloom_scalar_keys = {
+   "Threshold"sv,  "BlendFactor"sv,   "Intensity"sv,
+   "InnerScale"sv, "InnerMidScale"sv, "MidScale"sv,
+   "OuterMidScale"sv, "OuterScale"sv, "DirtScale"sv,
+};
+
+constexpr std::array bloom_float3_keys = {
+   "Tint"sv,         "InnerTint"sv, "InnerMidTint"sv, "MidTint"sv,
+   "OuterMidTint"sv, "OuterTint"sv, "DirtTint"sv,
+};
+
+constexpr std::array bloom_mode_names = {"Blended"sv, "Threshold"sv};
+
+// A .clrfx config with each key present about half of the time, as configs
+// written by hand tend to leave most values at their defaults.
+inline auto make_synthetic_colorgrading_config(std::mt19937& random) -> YAML::Node
+{
+   std::bernoulli_distribution present{0.5};
+   std::uniform_real_distribution<float> value{-4.0f, 4.0f};
+
+   const auto set_scalars = [&](YAML::Node& node, const auto& keys) {
+      for (const auto key : keys) {
+         if (present(random)) node[std::string{key}] = value(random);
+      }
+   };
+
+   const auto set_float3s = [&](YAML::Node& node, const auto& keys) {
+      for (const auto key : keys) {
+         if (!present(random)) continue;
+
+         YAML::Node float3;
+
+         for (int i = 0; i < 3; ++i) float3.push_back(value(random));
+
+         node[std::string{key}] = float3;
+      }
+   };
+
+   const auto pick = [&](const auto& names) {
+      return std::string{names[std::uniform_int_distribution<std::size_t>{
+         0, names.size() - 1}(random)]};
+   };
+
+   YAML::Node config;
+
+   if (present(random)) {
+      YAML::Node color_grading;
+
+      set_scalars(color_grading, colorgrading_scalar_keys);
+      set_float3s(color_grading, colorgrading_float3_keys);
+
+      if (present(random)) {
+         color_grading["Tonemapper"s] = pick(colorgrading_tonemapper_names);
+      }
+
+      config["ColorGrading"s] = color_grading;
+   }
+
+   if (present(random)) {
+      YAML::Node bloom;
+
+      set_scalars(bloom, bloom_scalar_keys);
+      set_float3s(bloom, bloom_float3_keys);
+
+      if (present(random)) bloom["Enable"s] = present(random);
+      if (present(random)) bloom["UseDirt"s] = present(random);
+      if (present(random)) bloom["Mode"s] = pick(bloom_mode_names);
+      if (present(random)) {
+         bloom["DirtTextureName"s] = "dirt_"s + std::to_string(random() % 1000);
+      }
+
+      config["Bloom"s] = bloom;
+   }
+
+   return config;
+}
+
+// The configs of a map's color grading regions, dumped as the version 1 clrg
+// chunk stored them.
+inline auto make_synthetic_colorgrading_config_yaml(const std::size_t count,
+                                                    const std::uint32_t seed)
+   -> std::vector<std::string>
+{
+   std::mt19937 random{seed};
+   std::vector<std::string> configs;
+   configs.reserve(count);
+
+   for (std::size_t i = 0; i < count; ++i) {
+      configs.push_back(YAML::Dump(make_synthetic_colorgrading_config(random)));
+   }
+
+   return configs;
+}
+
+}
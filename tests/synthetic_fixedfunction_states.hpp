@@ -0,0 +1,149 @@
+#pragma once
+
+#include "direct3d/fixedfunction_state_classifier.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace sp::tests {
+
+using namespace d3d9::fixedfunction_values;
+
+constexpr std::uint32_t top_selectarg2 = 3;
+constexpr std::uint32_t ta_diffuse = 0;
+
+constexpr std::uint32_t white_factor = 0xffffffffu;
+constexpr std::uint32_t damage_factor = 0xffdf2020u;
+
+// The stage values the game sets for each of the states it draws with fixed
+// function texturing.
+inline auto fixedfunction_state(const std::uint32_t stage0_colorop,
+                                const std::uint32_t stage0_alphaop,
+                                const std::uint32_t stage1_colorop,
+                                const std::uint32_t stage1_alphaop) noexcept
+   -> d3d9::Fixedfunction_stage_values
+{
+   return {.stages = {{{stage0_colorop, ta_tfactor, ta_texture, stage0_alphaop,
+                        ta_tfactor, ta_texture},
+                       {stage1_colorop, ta_texture, ta_current, stage1_alphaop,
+                        ta_texture, ta_current}}},
+           .stage2_colorop = top_disable,
+           .stage2_alphaop = top_disable};
+}
+
+inline auto color_fill_state() noexcept -> d3d9::Fixedfunction_stage_values
+{
+   return fixedfunction_state(top_selectarg1, top_selectarg1, top_disable, top_disable);
+}
+
+inline auto modulate_state() noexcept -> d3d9::Fixedfunction_stage_values
+{
+   return fixedfunction_state(top_modulate, top_modulate, top_disable, top_disable);
+}
+
+inline auto scene_blur_state() noexcept -> d3d9::Fixedfunction_stage_values
+{
+   return fixedfunction_state(top_modulate, top_selectarg1, top_disable, top_disable);
+}
+
+inline auto zoom_blur_state() noexcept -> d3d9::Fixedfunction_stage_values
+{
+   auto values = modulate_state();
+
+   values.stages[1] = {top_selectarg1, ta_current, ta_current,
+                       top_modulate,   ta_tfactor, ta_texture};
+
+   return values;
+}
+
+// The chain of predicates the pattern table replaced, kept as the reference it
+// must agree with.
+inline auto classify_fixedfunction_reference(const d3d9::Fixedfunction_stage_values& values,
+                                             const std::uint32_t texture_factor) noexcept
+   -> d3d9::Fixedfunction_shader
+{
+   using d3d9::Fixedfunction_shader;
+
+   const auto& stage0 = values.stages[0];
+   const auto& stage1 = values.stages[1];
+
+   const bool stage1_disabled =
+      stage1.colorop == top_disable && stage1.alphaop == top_disable;
+   const bool stage0_factor_texture =
+      stage0.colorarg1 == ta_tfactor && stage0.colorarg2 == ta_texture &&
+      stage0.alphaarg1 == ta_tfactor && stage0.alphaarg2 == ta_texture;
+   const bool stage0_modulate =
+      stage0_factor_texture && stage0.colorop == top_modulate &&
+      stage0.alphaop == top_modulate;
+
+   if (stage1_disabled && stage0_factor_texture && stage0.colorop == top_selectarg1 &&
+       stage0.alphaop == top_selectarg1) {
+      return Fixedfunction_shader::color_fill;
+   }
+
+   if (stage1_disabled && stage0_modulate &&
+       (texture_factor & 0xffffffu) == (damage_factor & 0xffffffu)) {
+      return Fixedfunction_shader::damage_overlay;
+   }
+
+   if (stage1_disabled && stage0_modulate && texture_factor == white_factor) {
+      return Fixedfunction_shader::plain_texture;
+   }
+
+   if (stage1_disabled && stage0_factor_texture && stage0.colorop == top_modulate &&
+       stage0.alphaop == top_selectarg1) {
+      return Fixedfunction_shader::scene_blur;
+   }
+
+   if (values.stage2_colorop == top_disable && values.stage2_alphaop == top_disable &&
+       stage1.colorop == top_selectarg1 && stage1.colorarg1 == ta_current &&
+       stage1.colorarg2 == ta_current && stage1.alphaop == top_modulate &&
+       stage1.alphaarg1 == ta_tfactor && stage1.alphaarg2 == ta_texture &&
+       stage0_modulate) {
+      return Fixedfunction_shader::zoom_blur;
+   }
+
+   return Fixedfunction_shader::unknown;
+}
+
+struct Fixedfunction_draw {
+   d3d9::Fixedfunction_stage_values values;
+   std::uint32_t texture_factor;
+};
+
+// A frame's worth of fixed function draws: runs of HUD and interface draws
+// with the same state broken up by the occasional screen effect.
+inline auto make_fixedfunction_draws(const std::size_t count, const std::uint32_t seed)
+   -> std::vector<Fixedfunction_draw>
+{
+   const std::array<Fixedfunction_draw, 6> draws{{
+      {modulate_state(), white_factor},
+      {modulate_state(), 0x80ffffffu},
+      {color_fill_state(), 0xff000000u},
+      {modulate_state(), damage_factor},
+      {scene_blur_state(), 0x40ffffffu},
+      {zoom_blur_state(), 0xffffffffu},
+   }};
+
+   std::mt19937 random{seed};
+   std::discrete_distribution<std::size_t> pick{60, 20, 10, 4, 3, 3};
+   std::geometric_distribution<std::size_t> run_length{0.25};
+
+   std::vector<Fixedfunction_draw> sequence;
+   sequence.reserve(count);
+
+   while (sequence.size() < count) {
+      const auto& draw = draws[pick(random)];
+
+      for (std::size_t i = run_length(random) + 1; i > 0 && sequence.size() < count; --i) {
+         sequence.push_back(draw);
+      }
+   }
+
+   return sequence;
+}
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sp::tests {
+
+// Builds .mtrl blobs laid out the way write_patch_material writes them (a
+// "matl" chunk holding VER_, INFO, PRPS and SR__ children). Only the layout
+// matters to the material registry, which keys materials on the raw data.
+class Mtrl_writer {
+public:
+   explicit Mtrl_writer(std::vector<std::byte>& out) : _out{out} {}
+
+   void begin(const std::string_view mn)
+   {
+      _out.insert(_out.end(), reinterpret_cast<const std::byte*>(mn.data()),
+                  reinterpret_cast<const std::byte*>(mn.data()) + 4);
+      _sizes.push_back(_out.size());
+      write(std::uint32_t{0});
+   }
+
+   void end()
+   {
+      const std::size_t size_offset = _sizes.back();
+      const auto size = static_cast<std::uint32_t>(_out.size() - size_offset - 4);
+
+      std::memcpy(_out.data() + size_offset, &size, sizeof(size));
+      _sizes.pop_back();
+
+      _out.resize((_out.size() + 3) & ~std::size_t{3});
+   }
+
+   template<typename T>
+   void write(const T& value)
+   {
+      const auto offset = _out.size();
+
+      _out.resize(offset + sizeof(T));
+      std::memcpy(_out.data() + offset, &value, sizeof(T));
+   }
+
+   void write(const std::string_view str)
+   {
+      _out.insert(_out.end(), reinterpret_cast<const std::byte*>(str.data()),
+                  reinterpret_cast<const std::byte*>(str.data() + str.size()));
+      _out.push_back(std::byte{0});
+   }
+
+private:
+   std::vector<std::byte>& _out;
+   std::vector<std::size_t> _sizes;
+};
+
+inline auto make_synthetic_mtrl(const std::uint32_t seed) -> std::vector<std::byte>
+{
+   std::mt19937 engine{seed};
+   std::vector<std::byte> data;
+   Mtrl_writer writer{data};
+
+   writer.begin("matl");
+
+   writer.begin("VER_");
+   writer.write(std::uint32_t{2});
+   writer.end();
+
+   writer.begin("INFO");
+   writer.write(std::string_view{"material_" + std::to_string(seed)});
+   writer.write(std::string_view{seed % 3 == 0 ? "pbr" : "normal_ext"});
+   writer.write(std::string_view{"normal"});
+   writer.end();
+
+   writer.begin("PRPS");
+
+   const std::uint32_t property_count = 4 + engine() % 12;
+
+   writer.write(property_count);
+
+   for (std::uint32_t i = 0; i < property_count; ++i) {
+      writer.write(std::string_view{"Property" + std::to_string(i)});
+      writer.write(std::uint32_t{3}); // float4
+
+      for (int value = 0; value < 12; ++value) {
+         writer.write(std::uniform_real_distribution<float>{0.0f, 1.0f}(engine));
+      }
+
+      writer.write(std::uint32_t{0});
+   }
+
+   writer.end();
+
+   writer.begin("SR__");
+   writer.write(std::uint32_t{2});
+   writer.write(std::string_view{"AlbedoMap"});
+   writer.write(std::string_view{"albedo_" + std::to_string(seed % 64)});
+   writer.write(std::string_view{"NormalMap"});
+   writer.write(std::string_view{"normal_" + std::to_string(seed % 64)});
+   writer.end();
+
+   writer.end();
+
+   return data;
+}
+
+// The materials of several levels. Each level munges its own copy of every
+// material it uses and levels share most of their materials, so the same
+// blob turns up once per level that uses it.
+inline auto make_synthetic_levels(const std::size_t level_count,
+                                  const std::size_t unique_materials,
+                                  const std::size_t materials_per_level)
+   -> std::vector<std::vector<std::byte>>
+{
+   std::mt19937 engine{static_cast<std::uint32_t>(level_count)};
+   std::vector<std::vector<std::byte>> blobs;
+
+   for (std::size_t level = 0; level < level_count; ++level) {
+      for (std::size_t i = 0; i < materials_per_level; ++i) {
+         blobs.push_back(
+            make_synthetic_mtrl(static_cast<std::uint32_t>(engine() % unique_materials)));
+      }
+   }
+
+   return blobs;
+}
+
+}
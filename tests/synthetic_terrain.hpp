@@ -0,0 +1,152 @@
+#pragma once
+
+#include "srgb_conversion_scalar.hpp"
+#include "terrain_file.hpp"
+#include "vector_types.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace sp::tests {
+
+struct Synthetic_terrain_desc {
+   std::int32_t terrain_length = 32;
+   std::int16_t half_extent = 16;
+   bool prelit = true;
+   std::uint32_t seed = 0;
+};
+
+// Builds a SWBFII .ter file with random layers and no decals, ending straight
+// after the texture weights.
+inline auto make_synthetic_terrain(const Synthetic_terrain_desc& desc)
+   -> std::vector<std::byte>
+{
+   Terr_header header{};
+
+   std::memcpy(header.mn, "TERR", 4);
+   header.version = 22;
+   header.extents[0] = -desc.half_extent;
+   header.extents[1] = -desc.half_extent;
+   header.extents[2] = desc.half_extent;
+   header.extents[3] = desc.half_extent;
+   header.height_scale = 0.03f;
+   header.grid_scale = 8.0f;
+   header.prelit = desc.prelit;
+   header.terrain_length = desc.terrain_length;
+   header.grids_per_foliage = 2;
+
+   for (float& scale : header.tex_scales) scale = 0.25f;
+
+   const std::size_t texel_count = desc.terrain_length * desc.terrain_length;
+   const std::size_t layer_count = desc.prelit ? 3 : 2;
+
+   std::vector<std::byte> file;
+   file.reserve(sizeof(Terr_header) + 8 + texel_count * (2 + 4 * layer_count + 16));
+
+   const auto write = [&](const auto& value) {
+      const auto offset = file.size();
+
+      file.resize(offset + sizeof(value));
+      std::memcpy(file.data() + offset, &value, sizeof(value));
+   };
+
+   std::mt19937 random{desc.seed};
+
+   const auto random_bytes = [&](const std::size_t size) {
+      for (std::size_t i = 0; i < size; ++i) {
+         file.push_back(static_cast<std::byte>(random() & 0xff));
+      }
+   };
+
+   write(header);
+   write(std::array<std::byte, 8>{});
+
+   for (std::size_t i = 0; i < texel_count; ++i) {
+      write(static_cast<std::int16_t>(random()));
+   }
+
+   random_bytes(texel_count * sizeof(Terrain_color) * layer_count);
+   random_bytes(texel_count * 16);
+
+   return file;
+}
+
+// The per texel conversion the loader's parallel passes replaced, kept as the
+// reference they must match exactly.
+struct Reference_terrain {
+   std::vector<Float3> position;
+   std::vector<Float3> color;
+   std::vector<Float3> diffuse_lighting;
+   std::vector<std::array<float, 16>> texture_weights;
+};
+
+inline auto decode_reference_terrain(const Terrain_file& file, const Float3 offset,
+                                     const std::array<std::uint8_t, 16>& texture_remap)
+   -> Reference_terrain
+{
+   const auto& header = file.header;
+   const Terrain_indexer& indexer = file.indexer;
+   const std::size_t texel_count = file.length() * file.length();
+
+   Reference_terrain terrain{.position = std::vector<Float3>(texel_count),
+                             .color = std::vector<Float3>(texel_count),
+                             .diffuse_lighting = std::vector<Float3>(texel_count),
+                             .texture_weights =
+                                std::vector<std::array<float, 16>>(texel_count)};
+
+   const auto color_at = [](const std::span<const std::byte> layer,
+                            const std::ptrdiff_t index) {
+      Terrain_color color;
+
+      std::memcpy(&color, &layer[index * sizeof(Terrain_color)], sizeof(color));
+
+      return std::array{decompress_srgb(color.red / 255.f),
+                        decompress_srgb(color.green / 255.f),
+                        decompress_srgb(color.blue / 255.f), color.alpha / 255.f};
+   };
+
+   for (std::ptrdiff_t y = header.extents[1]; y <= header.extents[3]; ++y) {
+      for (std::ptrdiff_t x = header.extents[0]; x <= header.extents[2]; ++x) {
+         const auto in = indexer.in(x, y);
+         const auto out = indexer.out(x, y);
+
+         std::int16_t height;
+         std::memcpy(&height, &file.heights[in * sizeof(std::int16_t)], sizeof(height));
+
+         terrain.position[out] = {x * header.grid_scale + offset.x,
+                                  height * header.height_scale + offset.y,
+                                  -(y * header.grid_scale) + offset.z};
+
+         const auto foreground = color_at(file.foreground_colors, in);
+         const auto background = color_at(file.background_colors, in);
+
+         const auto blend = [&](const std::size_t i) {
+            return (background[i] * background[3]) * (1.f - foreground[3]) +
+                   foreground[i] * foreground[3];
+         };
+
+         terrain.color[out] = {blend(0), blend(1), blend(2)};
+
+         if (header.prelit) {
+            const auto lighting = color_at(file.diffuse_lighting, in);
+
+            terrain.diffuse_lighting[out] = {lighting[0], lighting[1], lighting[2]};
+         }
+
+         for (std::size_t i = 0; i < 16; ++i) {
+            terrain.texture_weights[out][texture_remap[i]] =
+               static_cast<std::uint8_t>(file.texture_weights[in * 16 + i]) / 255.f;
+         }
+      }
+   }
+
+   return terrain;
+}
+
+}
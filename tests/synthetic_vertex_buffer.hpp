@@ -0,0 +1,435 @@
+#pragma once
+
+#include "vector_types.hpp"
+#include "vertex_buffer_codec.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace sp::tests {
+
+// The munge's Vertex_buffer with the test vector types in place of glm's.
+struct Vertex_buffer {
+   Vertex_buffer() = default;
+
+   Vertex_buffer(const std::size_t count, const Vbuf_flags flags) : count{count}
+   {
+      const auto is_set = [flags](const Vbuf_flags flag) {
+         return (flags & flag) == flag;
+      };
+
+      if (is_set(Vbuf_flags::position)) positions = std::make_unique<Float3[]>(count);
+      if (is_set(Vbuf_flags::blendindices))
+         blendindices = std::make_unique<std::uint32_t[]>(count);
+      if (is_set(Vbuf_flags::blendweight))
+         blendweights = std::make_unique<Float3[]>(count);
+      if (is_set(Vbuf_flags::normal)) normals = std::make_unique<Float3[]>(count);
+
+      if (is_set(Vbuf_flags::tangents)) {
+         tangents = std::make_unique<Float3[]>(count);
+         binormals = std::make_unique<Float3[]>(count);
+      }
+
+      if (is_set(Vbuf_flags::color)) colors = std::make_unique<std::uint32_t[]>(count);
+      if (is_set(Vbuf_flags::static_lighting))
+         static_lighting_colors = std::make_unique<std::uint32_t[]>(count);
+      if (is_set(Vbuf_flags::texcoords)) texcoords = std::make_unique<Float2[]>(count);
+   }
+
+   std::size_t count = 0;
+
+   std::unique_ptr<Float3[]> positions;
+   std::unique_ptr<std::uint32_t[]> blendindices;
+   std::unique_ptr<Float3[]> blendweights;
+   std::unique_ptr<Float3[]> normals;
+   std::unique_ptr<Float3[]> tangents;
+   std::unique_ptr<float[]> bitangent_signs;
+   std::unique_ptr<Float3[]> binormals;
+   std::unique_ptr<std::uint32_t[]> colors;
+   std::unique_ptr<std::uint32_t[]> static_lighting_colors;
+   std::unique_ptr<Float2[]> texcoords;
+};
+
+// Vertex_position_decompress and Vertex_position_compress over Float3.
+struct Position_decompress {
+   Float3 low;
+   Float3 mul;
+
+   auto operator()(const Vbuf_compressed_position compressed) const noexcept -> Float3
+   {
+      constexpr float i16min = std::numeric_limits<std::int16_t>::min();
+      constexpr float i16max = std::numeric_limits<std::int16_t>::max();
+
+      const auto decompress = [&](const float c, const float low, const float mul) {
+         return low + (c - i16min) * mul / (i16max - i16min);
+      };
+
+      return {decompress(compressed[0], low.x, mul.x),
+              decompress(compressed[1], low.y, mul.y),
+              decompress(compressed[2], low.z, mul.z)};
+   }
+};
+
+struct Position_compress {
+   Float3 min;
+   Float3 div;
+
+   auto operator()(const Float3 pos) const noexcept -> Vbuf_compressed_position
+   {
+      constexpr float i16min = std::numeric_limits<std::int16_t>::min();
+      constexpr float i16max = std::numeric_limits<std::int16_t>::max();
+
+      const auto compress = [&](const float pos, const float min, const float div) {
+         return static_cast<std::int16_t>(i16min + (pos - min) * (i16max - i16min) / div);
+      };
+
+      return {compress(pos.x, min.x, div.x), compress(pos.y, min.y, div.y),
+              compress(pos.z, min.z, div.z), 0};
+   }
+};
+
+// Every combination of the twelve VBUF flags, in the order of their bits.
+inline auto vbuf_flags_combination(const std::uint32_t index) noexcept -> Vbuf_flags
+{
+   constexpr std::array all_flags{Vbuf_flags::position,
+                                  Vbuf_flags::blendindices,
+                                  Vbuf_flags::blendweight,
+                                  Vbuf_flags::normal,
+                                  Vbuf_flags::tangents,
+                                  Vbuf_flags::color,
+                                  Vbuf_flags::static_lighting,
+                                  Vbuf_flags::texcoords,
+                                  Vbuf_flags::position_compressed,
+                                  Vbuf_flags::blendinfo_compressed,
+                                  Vbuf_flags::normal_compressed,
+                                  Vbuf_flags::texcoord_compressed};
+
+   Vbuf_flags flags{};
+
+   for (std::size_t i = 0; i < all_flags.size(); ++i) {
+      if (index & (1u << i)) flags |= all_flags[i];
+   }
+
+   return flags;
+}
+
+constexpr std::uint32_t vbuf_flags_combination_count = 1u << 12;
+
+// Random vertex bytes. Every byte has its top two bits cleared so all the
+// floats read from them are finite, with magnitudes below 2.
+inline auto make_synthetic_vbuf(const std::size_t size, const std::uint32_t seed)
+   -> std::vector<std::byte>
+{
+   std::mt19937 random{seed};
+   std::vector<std::byte> bytes(size);
+
+   for (auto& byte : bytes) byte = static_cast<std::byte>(random() & 0x3f);
+
+   return bytes;
+}
+
+// A buffer holding every attribute, with random values spanning (and for the
+// compressed attributes, exceeding) their encodable ranges.
+inline auto make_synthetic_vertex_buffer(const std::size_t count, const std::uint32_t seed)
+   -> Vertex_buffer
+{
+   constexpr auto all_attributes =
+      Vbuf_flags::position | Vbuf_flags::blendindices | Vbuf_flags::blendweight |
+      Vbuf_flags::normal | Vbuf_flags::tangents | Vbuf_flags::color |
+      Vbuf_flags::static_lighting | Vbuf_flags::texcoords;
+
+   Vertex_buffer buffer{count, all_attributes};
+   buffer.bitangent_signs = std::make_unique<float[]>(count);
+
+   std::mt19937 random{seed};
+   std::uniform_real_distribution<float> position_dist{-64.0f, 64.0f};
+   std::uniform_real_distribution<float> unit_dist{-1.1f, 1.1f};
+   std::uniform_real_distribution<float> texcoord_dist{-20.0f, 20.0f};
+
+   const auto random_unit = [&] {
+      return Float3{unit_dist(random), unit_dist(random), unit_dist(random)};
+   };
+
+   for (std::size_t i = 0; i < count; ++i) {
+      buffer.positions[i] = {position_dist(random), position_dist(random),
+                             position_dist(random)};
+      buffer.blendindices[i] = static_cast<std::uint32_t>(random());
+      buffer.blendweights[i] = random_unit();
+      buffer.normals[i] = random_unit();
+      buffer.tangents[i] = random_unit();
+      buffer.bitangent_signs[i] = (random() & 1) ? 1.0f : -1.0f;
+      buffer.binormals[i] = random_unit();
+      buffer.colors[i] = static_cast<std::uint32_t>(random());
+      buffer.static_lighting_colors[i] = static_cast<std::uint32_t>(random());
+      buffer.texcoords[i] = {texcoord_dist(random), texcoord_dist(random)};
+   }
+
+   return buffer;
+}
+
+// The per vertex reading and writing the batched codec replaced, kept as the
+// reference it must match exactly. The conversions follow glm's
+// unpackUnorm4x8 and packUnorm4x8.
+namespace reference_vbuf {
+
+inline auto unpack_unorm(const std::uint32_t packed, const int channel) -> float
+{
+   return static_cast<float>((packed >> (channel * 8)) & 0xffu) *
+          0.0039215686274509803921568627451f;
+}
+
+inline auto pack_unorm(const std::array<float, 4> values) -> std::uint32_t
+{
+   std::uint32_t packed = 0;
+
+   for (int i = 0; i < 4; ++i) {
+      const auto unorm =
+         static_cast<std::uint8_t>(std::round(std::clamp(values[i], 0.0f, 1.0f) * 255.0f));
+
+      packed |= std::uint32_t{unorm} << (i * 8);
+   }
+
+   return packed;
+}
+
+inline auto decompress_normal(const std::uint32_t normal) -> Float3
+{
+   return {unpack_unorm(normal, 2) * 2.0f - 1.0f, unpack_unorm(normal, 1) * 2.0f - 1.0f,
+           unpack_unorm(normal, 0) * 2.0f - 1.0f};
+}
+
+inline auto compress_normal(const Float3 normal, const float w = 0.0f) -> std::uint32_t
+{
+   return pack_unorm(
+      {normal.z * 0.5f + 0.5f, normal.y * 0.5f + 0.5f, normal.x * 0.5f + 0.5f, w});
+}
+
+class Reader {
+public:
+   explicit Reader(const std::byte* const bytes) : _bytes{bytes} {}
+
+   template<typename T>
+   auto read() -> T
+   {
+      T value;
+
+      std::memcpy(&value, _bytes + _offset, sizeof(T));
+      _offset += sizeof(T);
+
+      return value;
+   }
+
+   auto offset() const noexcept -> std::size_t
+   {
+      return _offset;
+   }
+
+private:
+   const std::byte* _bytes;
+   std::size_t _offset = 0;
+};
+
+class Writer {
+public:
+   template<typename T>
+   void write(const T& value)
+   {
+      const auto offset = bytes.size();
+
+      bytes.resize(offset + sizeof(T));
+      std::memcpy(bytes.data() + offset, &value, sizeof(T));
+   }
+
+   std::vector<std::byte> bytes;
+};
+
+inline void read_vertex(const Vbuf_flags flags, Reader& vbuf, const std::size_t index,
+                        const Position_decompress& pos_decompress,
+                        Vertex_buffer& output)
+{
+   const auto is_set = [flags](const Vbuf_flags flag) {
+      return (flags & flag) == flag;
+   };
+
+   if (is_set(Vbuf_flags::position)) {
+      if (is_set(Vbuf_flags::position_compressed))
+         output.positions[index] = pos_decompress(vbuf.read<Vbuf_compressed_position>());
+      else
+         output.positions[index] = vbuf.read<Float3>();
+   }
+
+   if (is_set(Vbuf_flags::blendweight)) {
+      if (is_set(Vbuf_flags::blendinfo_compressed)) {
+         const auto compressed = vbuf.read<std::uint32_t>();
+
+         output.blendweights[index] = {unpack_unorm(compressed, 2),
+                                       unpack_unorm(compressed, 1),
+                                       unpack_unorm(compressed, 0)};
+      }
+      else {
+         const auto weights = vbuf.read<Float2>();
+
+         output.blendweights[index] = {weights.x, weights.y,
+                                       static_cast<float>(1.0 - weights.x - weights.y)};
+      }
+   }
+
+   if (is_set(Vbuf_flags::blendindices))
+      output.blendindices[index] = vbuf.read<std::uint32_t>();
+
+   if (is_set(Vbuf_flags::normal)) {
+      if (is_set(Vbuf_flags::normal_compressed))
+         output.normals[index] = decompress_normal(vbuf.read<std::uint32_t>());
+      else
+         output.normals[index] = vbuf.read<Float3>();
+   }
+
+   if (is_set(Vbuf_flags::tangents)) {
+      if (is_set(Vbuf_flags::normal_compressed)) {
+         output.tangents[index] = decompress_normal(vbuf.read<std::uint32_t>());
+         output.binormals[index] = decompress_normal(vbuf.read<std::uint32_t>());
+      }
+      else {
+         output.tangents[index] = vbuf.read<Float3>();
+         output.binormals[index] = vbuf.read<Float3>();
+      }
+   }
+
+   if (is_set(Vbuf_flags::color)) output.colors[index] = vbuf.read<std::uint32_t>();
+
+   if (is_set(Vbuf_flags::static_lighting))
+      output.static_lighting_colors[index] = vbuf.read<std::uint32_t>();
+
+   if (is_set(Vbuf_flags::texcoords)) {
+      if (is_set(Vbuf_flags::texcoord_compressed)) {
+         const auto compressed = vbuf.read<Vbuf_compressed_texcoords>();
+
+         output.texcoords[index] = {static_cast<float>(compressed[0]) / 2048.f,
+                                    static_cast<float>(compressed[1]) / 2048.f};
+      }
+      else {
+         output.texcoords[index] = vbuf.read<Float2>();
+      }
+   }
+}
+
+inline void write_vertex(const Vertex_buffer& vertex_buffer, const std::size_t index,
+                         const Vbuf_flags flags, const Position_compress& pos_compress,
+                         Writer& writer)
+{
+   const auto is_set = [flags](const Vbuf_flags flag) {
+      return (flags & flag) == flag;
+   };
+
+   if (is_set(Vbuf_flags::position)) {
+      if (is_set(Vbuf_flags::position_compressed))
+         writer.write(pos_compress(vertex_buffer.positions[index]));
+      else
+         writer.write(vertex_buffer.positions[index]);
+   }
+
+   if (is_set(Vbuf_flags::blendweight)) {
+      const Float3 weights = vertex_buffer.blendweights[index];
+
+      if (is_set(Vbuf_flags::blendinfo_compressed))
+         writer.write(pack_unorm({weights.z, weights.y, weights.x, 0.0f}));
+      else
+         writer.write(Float2{weights.x, weights.y});
+   }
+
+   if (is_set(Vbuf_flags::blendindices)) writer.write(vertex_buffer.blendindices[index]);
+
+   if (is_set(Vbuf_flags::normal)) {
+      if (is_set(Vbuf_flags::normal_compressed))
+         writer.write(compress_normal(vertex_buffer.normals[index]));
+      else
+         writer.write(vertex_buffer.normals[index]);
+   }
+
+   if (is_set(Vbuf_flags::tangents)) {
+      if (is_set(Vbuf_flags::normal_compressed)) {
+         writer.write(compress_normal(vertex_buffer.tangents[index],
+                                      vertex_buffer.bitangent_signs
+                                         ? vertex_buffer.bitangent_signs[index]
+                                         : 0.0f));
+
+         if (vertex_buffer.binormals)
+            writer.write(compress_normal(vertex_buffer.binormals[index]));
+         else
+            writer.write(std::uint32_t{});
+      }
+      else {
+         writer.write(vertex_buffer.tangents[index]);
+
+         if (vertex_buffer.binormals)
+            writer.write(vertex_buffer.binormals[index]);
+         else if (vertex_buffer.bitangent_signs)
+            writer.write(Float3{0.0f, 0.0f, vertex_buffer.bitangent_signs[index]});
+         else
+            writer.write(Float3{});
+      }
+   }
+
+   if (is_set(Vbuf_flags::color)) writer.write(vertex_buffer.colors[index]);
+
+   if (is_set(Vbuf_flags::static_lighting))
+      writer.write(vertex_buffer.static_lighting_colors[index]);
+
+   if (is_set(Vbuf_flags::texcoords)) {
+      const Float2 texcoords = vertex_buffer.texcoords[index];
+
+      if (is_set(Vbuf_flags::texcoord_compressed)) {
+         constexpr float i16min = std::numeric_limits<std::int16_t>::min();
+         constexpr float i16max = std::numeric_limits<std::int16_t>::max();
+
+         writer.write(Vbuf_compressed_texcoords{
+            static_cast<std::int16_t>(
+               std::min(std::max(texcoords.x * 2048.f, i16min), i16max)),
+            static_cast<std::int16_t>(
+               std::min(std::max(texcoords.y * 2048.f, i16min), i16max))});
+      }
+      else {
+         writer.write(texcoords);
+      }
+   }
+}
+
+// Decodes count vertices, returning the buffer and the number of bytes read.
+inline auto decode(const Vbuf_flags flags, const std::byte* const bytes,
+                   const std::size_t count, const Position_decompress& pos_decompress)
+   -> std::pair<Vertex_buffer, std::size_t>
+{
+   Vertex_buffer buffer{count, flags};
+   Reader reader{bytes};
+
+   for (std::size_t i = 0; i < count; ++i) {
+      read_vertex(flags, reader, i, pos_decompress, buffer);
+   }
+
+   return {std::move(buffer), reader.offset()};
+}
+
+inline auto encode(const Vertex_buffer& vertex_buffer, const Vbuf_flags flags,
+                   const Position_compress& pos_compress) -> std::vector<std::byte>
+{
+   Writer writer;
+
+   for (std::size_t i = 0; i < vertex_buffer.count; ++i) {
+      write_vertex(vertex_buffer, i, flags, pos_compress, writer);
+   }
+
+   return std::move(writer.bytes);
+}
+
+}
+
+}
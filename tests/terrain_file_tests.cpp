@@ -0,0 +1,212 @@
+
+#include "terrain_file.hpp"
+
+#include "synthetic_terrain.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp {
+
+namespace {
+
+using tests::Float3;
+
+constexpr Float3 terrain_offset{16.0f, -2.0f, 8.0f};
+
+auto identity_remap() -> std::array<std::uint8_t, 16>
+{
+   std::array<std::uint8_t, 16> remap;
+
+   std::iota(remap.begin(), remap.end(), std::uint8_t{0});
+
+   return remap;
+}
+
+// Decodes a synthetic terrain with the parallel passes and checks every texel
+// against the per texel reference.
+void expect_matches_reference(const tests::Synthetic_terrain_desc& desc,
+                              const std::array<std::uint8_t, 16>& texture_remap)
+{
+   const auto bytes = tests::make_synthetic_terrain(desc);
+   const auto file = parse_terrain_file(bytes);
+
+   const std::size_t texel_count = file.length() * file.length();
+
+   std::vector<Float3> position(texel_count);
+   std::vector<Float3> color(texel_count);
+   std::vector<Float3> diffuse_lighting(texel_count);
+   std::vector<std::array<float, 16>> texture_weights(texel_count);
+
+   decode_terrain_heights(file, terrain_offset, std::span{position});
+   decode_terrain_colors(file, std::span{color});
+   if (desc.prelit) decode_terrain_diffuse_lighting(file, std::span{diffuse_lighting});
+   decode_terrain_texture_weights(file, texture_remap, texture_weights);
+
+   const auto reference =
+      tests::decode_reference_terrain(file, terrain_offset, texture_remap);
+
+   for (std::size_t i = 0; i < texel_count; ++i) {
+      ASSERT_EQ(position[i], reference.position[i]) << "texel " << i;
+      ASSERT_EQ(color[i], reference.color[i]) << "texel " << i;
+      ASSERT_EQ(diffuse_lighting[i], reference.diffuse_lighting[i]) << "texel " << i;
+      ASSERT_EQ(texture_weights[i], reference.texture_weights[i]) << "texel " << i;
+   }
+}
+
+}
+
+TEST(Terrain_file, layers_are_found)
+{
+   const auto bytes = tests::make_synthetic_terrain({.terrain_length = 32});
+   const auto file = parse_terrain_file(bytes);
+
+   const std::size_t texel_count = 32 * 32;
+   const std::size_t layers_offset = sizeof(Terr_header) + 8;
+
+   EXPECT_EQ(file.length(), 33);
+   EXPECT_EQ(file.heights.data(), bytes.data() + layers_offset);
+   EXPECT_EQ(file.heights.size(), texel_count * 2);
+   EXPECT_EQ(file.foreground_colors.data(), file.heights.data() + file.heights.size());
+   EXPECT_EQ(file.background_colors.data(),
+             file.foreground_colors.data() + texel_count * 4);
+   EXPECT_EQ(file.diffuse_lighting.data(),
+             file.background_colors.data() + texel_count * 4);
+   EXPECT_EQ(file.texture_weights.data(), file.diffuse_lighting.data() + texel_count * 4);
+   EXPECT_EQ(file.texture_weights.size(), texel_count * 16);
+   EXPECT_TRUE(file.trailing.empty());
+}
+
+TEST(Terrain_file, unlit_terrains_have_no_lighting_layer)
+{
+   const auto bytes =
+      tests::make_synthetic_terrain({.terrain_length = 32, .prelit = false});
+   const auto file = parse_terrain_file(bytes);
+
+   EXPECT_TRUE(file.diffuse_lighting.empty());
+   EXPECT_EQ(file.texture_weights.data(),
+             file.background_colors.data() + file.background_colors.size());
+   EXPECT_TRUE(file.trailing.empty());
+}
+
+TEST(Terrain_file, decals_are_skipped)
+{
+   auto bytes = tests::make_synthetic_terrain({.terrain_length = 16, .half_extent = 8});
+
+   Terr_header header;
+   std::memcpy(&header, bytes.data(), sizeof(header));
+   header.decal_settings.tile_count = 2;
+   std::memcpy(bytes.data(), &header, sizeof(header));
+
+   const std::array<std::byte, sizeof(Terrain_decal_tile) * 2> tiles{};
+   bytes.insert(bytes.begin() + sizeof(Terr_header), tiles.begin(), tiles.end());
+
+   const auto file = parse_terrain_file(bytes);
+
+   EXPECT_EQ(file.heights.data(), bytes.data() + sizeof(Terr_header) + tiles.size() + 8);
+   EXPECT_TRUE(file.trailing.empty());
+}
+
+TEST(Terrain_file, truncated_files_throw)
+{
+   const auto bytes =
+      tests::make_synthetic_terrain({.terrain_length = 16, .half_extent = 8});
+
+   EXPECT_THROW(parse_terrain_file(std::span{bytes}.first(sizeof(Terr_header) - 1)),
+                std::out_of_range);
+   EXPECT_THROW(parse_terrain_file(std::span{bytes}.first(bytes.size() - 1)),
+                std::out_of_range);
+}
+
+TEST(Terrain_file, trailing_data_is_kept)
+{
+   auto bytes = tests::make_synthetic_terrain({.terrain_length = 16, .half_extent = 8});
+   bytes.resize(bytes.size() + 12);
+
+   const auto file = parse_terrain_file(bytes);
+
+   EXPECT_EQ(file.trailing.size(), 12);
+   EXPECT_EQ(file.trailing.data(), bytes.data() + bytes.size() - 12);
+}
+
+TEST(Terrain_file, decodes_known_texels)
+{
+   // A 2x2 terrain wraps around to cover its 3x3 extents.
+   auto bytes = tests::make_synthetic_terrain({.terrain_length = 2, .half_extent = 1});
+   auto file = parse_terrain_file(bytes);
+
+   const auto layer = [&](const std::span<const std::byte> span) {
+      return std::span{bytes}.subspan(span.data() - bytes.data(), span.size());
+   };
+
+   const std::int16_t height = 1000;
+   std::memcpy(layer(file.heights).data(), &height, sizeof(height));
+
+   const Terrain_color opaque_red{.blue = 0, .green = 0, .red = 255, .alpha = 255};
+   const Terrain_color clear{.blue = 0, .green = 0, .red = 0, .alpha = 0};
+   const Terrain_color half_white{.blue = 255, .green = 255, .red = 255, .alpha = 128};
+
+   // Texel 0's foreground is opaque and hides the background, texel 1's is
+   // clear and shows it.
+   std::memcpy(layer(file.foreground_colors).data(), &opaque_red, 4);
+   std::memcpy(layer(file.background_colors).data(), &half_white, 4);
+   std::memcpy(layer(file.foreground_colors).data() + 4, &clear, 4);
+   std::memcpy(layer(file.background_colors).data() + 4, &half_white, 4);
+
+   file = parse_terrain_file(bytes);
+
+   std::vector<Float3> position(9);
+   std::vector<Float3> color(9);
+
+   decode_terrain_heights(file, Float3{}, std::span{position});
+   decode_terrain_colors(file, std::span{color});
+
+   // Texel 0 of the file is x = -1, y = -1, the first texel of the map.
+   EXPECT_EQ(position[0], (Float3{-8.0f, 1000 * 0.03f, 8.0f}));
+   EXPECT_EQ(color[0], (Float3{1.0f, 0.0f, 0.0f}));
+
+   // And wraps around to x = 1, y = -1 as well.
+   EXPECT_EQ(position[2].y, position[0].y);
+
+   const float half = 128 / 255.f;
+
+   EXPECT_EQ(color[1], (Float3{half, half, half}));
+}
+
+TEST(Terrain_file, matches_per_texel_reference)
+{
+   expect_matches_reference({.terrain_length = 32, .half_extent = 16, .seed = 1},
+                            identity_remap());
+}
+
+TEST(Terrain_file, matches_per_texel_reference_cropped)
+{
+   expect_matches_reference({.terrain_length = 64, .half_extent = 20, .seed = 2},
+                            identity_remap());
+}
+
+TEST(Terrain_file, matches_per_texel_reference_unlit)
+{
+   expect_matches_reference(
+      {.terrain_length = 32, .half_extent = 16, .prelit = false, .seed = 3},
+      identity_remap());
+}
+
+TEST(Terrain_file, matches_per_texel_reference_remapped)
+{
+   // Unused texture slots all map to the last slot.
+   const std::array<std::uint8_t, 16> remap{0, 1, 15, 2,  15, 3,  4,  5,
+                                            6, 7, 8,  9, 10, 11, 12, 15};
+
+   expect_matches_reference({.terrain_length = 32, .half_extent = 16, .seed = 4}, remap);
+}
+
+}
@@ -0,0 +1,128 @@
+
+#include "terrain_normal_map.hpp"
+
+#include "synthetic_terrain.hpp"
+
+#include <cstddef>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp {
+
+namespace {
+
+using tests::Float3;
+
+auto make_height_field(const int length, const std::uint32_t seed) -> std::vector<Float3>
+{
+   std::mt19937 random{seed};
+   std::uniform_real_distribution<float> height{-40.0f, 120.0f};
+
+   std::vector<Float3> positions;
+   positions.reserve(length * length);
+
+   for (int y = 0; y < length; ++y) {
+      for (int x = 0; x < length; ++x) {
+         positions.push_back({x * 8.0f, height(random), y * -8.0f});
+      }
+   }
+
+   return positions;
+}
+
+// The serial normal map munged terrains were built with before rows were done
+// in parallel, scattering each triangle's normal to its three vertices.
+auto build_serial_normal_map(const int length, const std::span<const Float3> positions)
+   -> std::vector<Float3>
+{
+   std::vector<Float3> normals(length * length);
+
+   for (auto y = 0; y < (length - 1); ++y) {
+      for (auto x = 0; x < (length - 1); ++x) {
+         const auto i0 = x + (y * length);
+         const auto i1 = x + ((y + 1) * length);
+         const auto i2 = (x + 1) + (y * length);
+         const auto i3 = (x + 1) + ((y + 1) * length);
+
+         {
+            const Float3 normal =
+               cross(positions[i2] - positions[i0], positions[i3] - positions[i0]);
+
+            normals[i0] += normal;
+            normals[i2] += normal;
+            normals[i3] += normal;
+         }
+
+         {
+            const Float3 normal =
+               cross(positions[i3] - positions[i0], positions[i1] - positions[i0]);
+
+            normals[i0] += normal;
+            normals[i3] += normal;
+            normals[i1] += normal;
+         }
+      }
+   }
+
+   for (auto& normal : normals) normal = normalize(normal);
+
+   return normals;
+}
+
+void expect_matches_serial(const int length, const std::uint32_t seed)
+{
+   const auto positions = make_height_field(length, seed);
+
+   std::vector<Float3> normals(positions.size());
+
+   build_terrain_normal_map(length, std::span<const Float3>{positions},
+                            std::span{normals});
+
+   const auto serial_normals = build_serial_normal_map(length, positions);
+
+   for (std::size_t i = 0; i < normals.size(); ++i) {
+      ASSERT_EQ(normals[i], serial_normals[i])
+         << "vertex " << (i % length) << ", " << (i / length) << " of " << length;
+   }
+}
+
+}
+
+TEST(Terrain_normal_map, flat_terrain_points_up)
+{
+   std::vector<Float3> positions;
+
+   for (int y = 0; y < 3; ++y) {
+      for (int x = 0; x < 3; ++x) positions.push_back({x * 8.0f, 0.0f, y * -8.0f});
+   }
+
+   std::vector<Float3> normals(positions.size());
+
+   build_terrain_normal_map(3, std::span<const Float3>{positions}, std::span{normals});
+
+   for (const auto& normal : normals) EXPECT_EQ(normal, (Float3{0.0f, 1.0f, 0.0f}));
+}
+
+TEST(Terrain_normal_map, parallel_matches_serial_smallest)
+{
+   expect_matches_serial(2, 0);
+}
+
+TEST(Terrain_normal_map, parallel_matches_serial)
+{
+   for (const int length : {3, 17, 64, 129}) {
+      for (std::uint32_t seed = 0; seed < 4; ++seed) {
+         expect_matches_serial(length, seed);
+      }
+   }
+}
+
+TEST(Terrain_normal_map, parallel_matches_serial_largest)
+{
+   expect_matches_serial(1025, 7);
+}
+
+}
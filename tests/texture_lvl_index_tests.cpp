@@ -0,0 +1,281 @@
+
+#include "core/texture_lvl_index.hpp"
+
+#include "ucfb_writer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <DirectXTex.h>
+#include <gtest/gtest.h>
+
+namespace sp::core {
+
+namespace {
+
+struct Synthetic_texture {
+   std::string name;
+   Texture_info info;
+   std::vector<std::vector<std::byte>> storage;
+   std::vector<Texture_data> subresources;
+};
+
+// A texture with every subresource holding exactly the data its format and
+// size need. shrink is taken off the data of the last subresource.
+auto make_texture(std::string name, const Texture_info& info,
+                  const std::size_t shrink = 0) -> Synthetic_texture
+{
+   Synthetic_texture texture{.name = std::move(name),
+                             .info = info,
+                             .storage = {},
+                             .subresources = {}};
+
+   for (std::uint32_t item = 0; item < info.array_size; ++item) {
+      for (std::uint32_t mip = 0; mip < info.mip_count; ++mip) {
+         std::size_t pitch = 0;
+         std::size_t slice_pitch = 0;
+
+         if (FAILED(DirectX::ComputePitch(info.format, std::max(info.width >> mip, 1u),
+                                          std::max(info.height >> mip, 1u), pitch,
+                                          slice_pitch))) {
+            throw std::runtime_error{"unsupported synthetic texture format"};
+         }
+
+         const std::size_t depth = std::max(info.depth >> mip, 1u);
+
+         texture.storage.emplace_back(slice_pitch * depth, std::byte{0x5a});
+         texture.subresources.push_back({.pitch = static_cast<UINT>(pitch),
+                                         .slice_pitch = static_cast<UINT>(slice_pitch),
+                                         .data = {}});
+      }
+   }
+
+   texture.storage.back().resize(texture.storage.back().size() - shrink);
+
+   for (std::size_t i = 0; i < texture.storage.size(); ++i) {
+      texture.subresources[i].data = texture.storage[i];
+   }
+
+   return texture;
+}
+
+auto make_rgba_texture() -> Synthetic_texture
+{
+   return make_texture("$rgba", {.type = Texture_type::texture2d,
+                                 .width = 64,
+                                 .height = 32,
+                                 .depth = 1,
+                                 .array_size = 1,
+                                 .mip_count = 7,
+                                 .format = DXGI_FORMAT_R8G8B8A8_UNORM});
+}
+
+auto make_bc1_cube_texture() -> Synthetic_texture
+{
+   return make_texture("$bc1_cube", {.type = Texture_type::texturecube,
+                                     .width = 16,
+                                     .height = 16,
+                                     .depth = 1,
+                                     .array_size = 6,
+                                     .mip_count = 5,
+                                     .format = DXGI_FORMAT_BC1_UNORM});
+}
+
+auto make_volume_texture() -> Synthetic_texture
+{
+   return make_texture("$volume", {.type = Texture_type::texture3d,
+                                   .width = 8,
+                                   .height = 8,
+                                   .depth = 4,
+                                   .array_size = 1,
+                                   .mip_count = 4,
+                                   .format = DXGI_FORMAT_R16G16B16A16_FLOAT});
+}
+
+// Writes an lvl holding the textures, with a foreign chunk after the first
+// one when foreign_chunk is set.
+auto make_lvl(const std::vector<Synthetic_texture>& textures,
+              const bool foreign_chunk = false) -> std::vector<std::byte>
+{
+   std::ostringstream stream;
+
+   {
+      ucfb::File_writer writer{"ucfb"_mn, stream};
+
+      for (std::size_t i = 0; i < textures.size(); ++i) {
+         const auto& texture = textures[i];
+
+         write_patch_texture(writer, texture.name, texture.info,
+                             texture.subresources, Texture_file_type::direct_texture);
+
+         if (foreign_chunk && i == 0) {
+            writer.emplace_child("skel"_mn).write(std::uint32_t{0xdeadbeefu});
+         }
+      }
+   }
+
+   const auto str = stream.str();
+   std::vector<std::byte> bytes(str.size());
+
+   std::memcpy(bytes.data(), str.data(), str.size());
+
+   return bytes;
+}
+
+auto names(const std::vector<Texture_lvl_entry>& entries) -> std::vector<std::string>
+{
+   std::vector<std::string> result;
+
+   for (const auto& entry : entries) result.push_back(entry.name);
+
+   return result;
+}
+
+// What check_patch_texture guarantees for every entry it lets through.
+void expect_sane(const Texture_lvl_entry& entry)
+{
+   const auto& info = entry.info;
+
+   EXPECT_LE(info.type, Texture_type::texturecubearray);
+   EXPECT_NE(info.width, 0u);
+   EXPECT_NE(info.height, 0u);
+   EXPECT_NE(info.depth, 0u);
+   EXPECT_NE(info.array_size, 0u);
+   EXPECT_NE(info.mip_count, 0u);
+   EXPECT_LE(info.mip_count, static_cast<std::uint32_t>(std::bit_width(
+                                std::max({info.width, info.height, info.depth}))));
+   EXPECT_NE(info.format, DXGI_FORMAT_UNKNOWN);
+
+   // The entry's chunk is still readable, as the deferred load will read it.
+   EXPECT_NO_THROW(check_patch_texture(entry.chunk)) << entry.name;
+}
+
+auto standard_lvl() -> std::vector<std::byte>
+{
+   return make_lvl({make_rgba_texture(), make_bc1_cube_texture(), make_volume_texture()});
+}
+
+}
+
+TEST(Texture_lvl_index, indexes_generated_lvl)
+{
+   const auto lvl = standard_lvl();
+   const auto entries = index_texture_lvl(lvl);
+
+   ASSERT_EQ(names(entries),
+             (std::vector<std::string>{"$rgba", "$bc1_cube", "$volume"}));
+
+   EXPECT_EQ(entries[0].info.mip_count, 7u);
+   EXPECT_EQ(entries[1].info.array_size, 6u);
+   EXPECT_EQ(entries[1].info.format, DXGI_FORMAT_BC1_UNORM);
+   EXPECT_EQ(entries[2].info.depth, 4u);
+
+   for (const auto& entry : entries) expect_sane(entry);
+}
+
+TEST(Texture_lvl_index, empty_and_foreign_input)
+{
+   EXPECT_TRUE(index_texture_lvl({}).empty());
+   EXPECT_TRUE(index_texture_lvl(make_lvl({})).empty());
+
+   auto not_ucfb = standard_lvl();
+   not_ucfb[0] = std::byte{'x'};
+
+   EXPECT_TRUE(index_texture_lvl(not_ucfb).empty());
+}
+
+TEST(Texture_lvl_index, skips_foreign_chunks)
+{
+   const auto lvl = make_lvl({make_rgba_texture(), make_volume_texture()}, true);
+
+   EXPECT_EQ(names(index_texture_lvl(lvl)),
+             (std::vector<std::string>{"$rgba", "$volume"}));
+}
+
+TEST(Texture_lvl_index, skips_textures_with_short_data)
+{
+   const auto lvl =
+      make_lvl({make_rgba_texture(),
+                make_texture("$short", make_bc1_cube_texture().info, 1),
+                make_volume_texture()});
+
+   EXPECT_EQ(names(index_texture_lvl(lvl)),
+             (std::vector<std::string>{"$rgba", "$volume"}));
+}
+
+TEST(Texture_lvl_index, skips_textures_with_bad_info)
+{
+   auto too_many_mips = make_rgba_texture();
+   too_many_mips.name = "$too_many_mips";
+   too_many_mips.info.mip_count = 8;
+
+   auto mismatched_depth = make_rgba_texture();
+   mismatched_depth.name = "$mismatched_depth";
+   mismatched_depth.info.depth = 2;
+
+   auto unknown_format = make_rgba_texture();
+   unknown_format.name = "$unknown_format";
+   unknown_format.info.format = DXGI_FORMAT_UNKNOWN;
+
+   const auto lvl = make_lvl({too_many_mips, mismatched_depth, unknown_format,
+                              make_volume_texture()});
+
+   EXPECT_EQ(names(index_texture_lvl(lvl)), (std::vector<std::string>{"$volume"}));
+}
+
+// A truncated lvl is indexed up to its first incomplete chunk.
+TEST(Texture_lvl_index, every_truncation)
+{
+   const auto lvl = standard_lvl();
+   const auto all_names = names(index_texture_lvl(lvl));
+
+   std::size_t last_count = 0;
+
+   for (std::size_t size = 0; size < lvl.size(); ++size) {
+      const auto entries = index_texture_lvl(std::span{lvl}.first(size));
+
+      ASSERT_LT(entries.size(), all_names.size()) << size;
+      ASSERT_GE(entries.size(), last_count) << size;
+      ASSERT_TRUE(std::equal(entries.begin(), entries.end(), all_names.begin(),
+                             [](const Texture_lvl_entry& entry, const std::string& name) {
+                                return entry.name == name;
+                             }))
+         << size;
+
+      for (const auto& entry : entries) expect_sane(entry);
+
+      last_count = entries.size();
+   }
+}
+
+// Randomly corrupted copies of an lvl never index an entry that would fail to
+// load from bad info or out of bounds data.
+TEST(Texture_lvl_index, corrupted_copies)
+{
+   const auto lvl = standard_lvl();
+
+   std::mt19937 random{0};
+   std::uniform_int_distribution<std::size_t> offset{0, lvl.size() - 1};
+   std::uniform_int_distribution<std::uint32_t> corruption_count{1, 8};
+   std::uniform_int_distribution<std::uint32_t> byte{0, 255};
+
+   for (int i = 0; i < 2000; ++i) {
+      auto corrupted = lvl;
+
+      for (std::uint32_t count = corruption_count(random); count > 0; --count) {
+         corrupted[offset(random)] = static_cast<std::byte>(byte(random));
+      }
+
+      for (const auto& entry : index_texture_lvl(corrupted)) expect_sane(entry);
+   }
+}
+
+}
@@ -0,0 +1,293 @@
+
+#include "direct3d/upload_scratch_buffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp::d3d9 {
+
+namespace {
+
+// Heap memory that keeps count of what is still allocated.
+struct Counted_heap_memory {
+   constexpr static std::size_t alignment = Heap_upload_memory::alignment;
+
+   static auto allocate(const std::size_t size) noexcept -> std::byte*
+   {
+      allocations += 1;
+
+      return Heap_upload_memory::allocate(size);
+   }
+
+   static void deallocate(std::byte* const memory, const std::size_t size) noexcept
+   {
+      allocations -= 1;
+
+      Heap_upload_memory::deallocate(memory, size);
+   }
+
+   inline static std::atomic_int64_t allocations = 0;
+};
+
+using Upload_ring = Basic_upload_ring<Counted_heap_memory>;
+
+// The byte ranges of every live lease, checks new ones don't overlap them.
+class Live_ranges {
+public:
+   bool insert(const std::byte* const data, const std::size_t size)
+   {
+      std::scoped_lock lock{_mutex};
+
+      auto next = _ranges.lower_bound(data);
+
+      if (next != _ranges.end() && next->first < data + size) return false;
+
+      if (next != _ranges.begin()) {
+         const auto previous = std::prev(next);
+
+         if (previous->first + previous->second > data) return false;
+      }
+
+      _ranges.emplace(data, size);
+
+      return true;
+   }
+
+   void erase(const std::byte* const data)
+   {
+      std::scoped_lock lock{_mutex};
+
+      _ranges.erase(data);
+   }
+
+private:
+   std::mutex _mutex;
+   std::map<const std::byte*, std::size_t> _ranges;
+};
+
+}
+
+TEST(Upload_ring, leases_are_aligned_and_sized)
+{
+   Upload_ring ring{1024};
+
+   auto lease = ring.lock(5);
+
+   ASSERT_TRUE(lease);
+   EXPECT_TRUE(lease.in_ring());
+   EXPECT_EQ(lease.size(), Upload_ring::alignment);
+   EXPECT_EQ(reinterpret_cast<std::uintptr_t>(lease.data()) % Upload_ring::alignment, 0u);
+
+   EXPECT_EQ(ring.lock(0).size(), Upload_ring::alignment);
+}
+
+TEST(Upload_ring, wraps_to_the_start_instead_of_straddling_the_end)
+{
+   Upload_ring ring{1024};
+
+   auto first = ring.lock(400);
+   auto second = ring.lock(400);
+
+   ASSERT_TRUE(first.in_ring() && second.in_ring());
+
+   std::byte* const start = first.data();
+
+   EXPECT_EQ(second.data(), start + 400);
+
+   first.reset();
+
+   auto third = ring.lock(400);
+
+   ASSERT_TRUE(third.in_ring());
+   EXPECT_EQ(third.data(), start);
+
+   // The skipped bytes at the end stay in use until the third lease goes.
+   EXPECT_EQ(ring.stats().in_use, 1024u);
+   EXPECT_FALSE(ring.lock(16).in_ring());
+
+   second.reset();
+   third.reset();
+
+   EXPECT_EQ(ring.stats().in_use, 0u);
+   EXPECT_EQ(ring.stats().outstanding_leases, 0u);
+}
+
+TEST(Upload_ring, space_is_reclaimed_in_lease_order)
+{
+   Upload_ring ring{1024};
+
+   auto first = ring.lock(256);
+   auto second = ring.lock(256);
+   auto third = ring.lock(256);
+
+   // Releasing the newer leases can't free anything while the oldest is held.
+   second.reset();
+   third.reset();
+
+   EXPECT_EQ(ring.stats().in_use, 768u);
+   EXPECT_EQ(ring.stats().outstanding_leases, 3u);
+
+   first.reset();
+
+   EXPECT_EQ(ring.stats().in_use, 0u);
+   EXPECT_EQ(ring.stats().outstanding_leases, 0u);
+}
+
+TEST(Upload_ring, falls_back_when_full_or_oversize)
+{
+   const auto allocations = Counted_heap_memory::allocations.load();
+
+   {
+      Upload_ring ring{1024};
+
+      auto oversize = ring.lock(2048);
+
+      EXPECT_TRUE(oversize);
+      EXPECT_FALSE(oversize.in_ring());
+      EXPECT_EQ(oversize.size(), 2048u);
+
+      auto whole = ring.lock(1024);
+      auto overflow = ring.lock(16);
+
+      EXPECT_TRUE(whole.in_ring());
+      EXPECT_TRUE(overflow);
+      EXPECT_FALSE(overflow.in_ring());
+
+      EXPECT_EQ(ring.stats().ring_leases, 1u);
+      EXPECT_EQ(ring.stats().fallback_leases, 2u);
+      EXPECT_EQ(Counted_heap_memory::allocations, allocations + 3);
+   }
+
+   EXPECT_EQ(Counted_heap_memory::allocations, allocations);
+}
+
+TEST(Upload_ring, falls_back_once_every_lease_slot_is_held)
+{
+   Upload_ring ring{65536};
+
+   std::vector<Upload_ring::Lease> leases;
+
+   while (true) {
+      auto lease = ring.lock(16);
+
+      if (!lease.in_ring()) break;
+
+      leases.push_back(std::move(lease));
+   }
+
+   EXPECT_EQ(leases.size(), ring.stats().outstanding_leases);
+   EXPECT_LT(ring.stats().in_use, ring.capacity());
+
+   leases.clear();
+
+   EXPECT_TRUE(ring.lock(16).in_ring());
+}
+
+TEST(Upload_ring, moved_leases_are_released_once)
+{
+   Upload_ring ring{1024};
+
+   auto lease = ring.lock(64);
+   Upload_ring::Lease moved = std::move(lease);
+
+   EXPECT_FALSE(lease);
+   EXPECT_TRUE(moved.in_ring());
+
+   lease = ring.lock(64);
+   lease = std::move(moved);
+
+   EXPECT_EQ(ring.stats().outstanding_leases, 2u);
+
+   lease.reset();
+
+   EXPECT_EQ(ring.stats().outstanding_leases, 0u);
+}
+
+TEST(Upload_ring, many_producers_never_overlap_and_everything_is_reclaimed)
+{
+   constexpr std::size_t capacity = 65536;
+   constexpr std::size_t thread_count = 8;
+   constexpr std::size_t iterations = 20000;
+   constexpr std::size_t max_held = 4;
+
+   const auto allocations = Counted_heap_memory::allocations.load();
+
+   std::atomic_size_t ring_bytes = 0;
+   std::atomic_size_t overlaps = 0;
+   std::atomic_size_t corrupted = 0;
+
+   {
+      Upload_ring ring{capacity};
+      Live_ranges live;
+
+      const auto producer = [&](const std::size_t thread_index) {
+         std::mt19937 engine{static_cast<std::uint32_t>(thread_index)};
+         std::vector<std::pair<Upload_ring::Lease, std::byte>> held;
+
+         const auto release = [&](const std::size_t index) {
+            auto& [lease, fill] = held[index];
+
+            if (lease.in_ring()) live.erase(lease.data());
+
+            if (std::ranges::any_of(std::span{lease.data(), lease.size()},
+                                    [&](const std::byte b) { return b != fill; })) {
+               corrupted += 1;
+            }
+
+            held.erase(held.begin() + index);
+         };
+
+         for (std::size_t i = 0; i < iterations; ++i) {
+            auto lease = ring.lock(1 + engine() % (capacity / 8));
+            const auto fill = static_cast<std::byte>(engine());
+
+            if (lease.in_ring()) {
+               if (!live.insert(lease.data(), lease.size())) overlaps += 1;
+
+               ring_bytes += lease.size();
+            }
+
+            std::memset(lease.data(), static_cast<int>(fill), lease.size());
+
+            held.emplace_back(std::move(lease), fill);
+
+            // Release out of order so reclaim has to wait on older leases.
+            if (held.size() == max_held) release(engine() % held.size());
+         }
+
+         while (!held.empty()) release(held.size() - 1);
+      };
+
+      std::vector<std::jthread> threads;
+
+      for (std::size_t i = 0; i < thread_count; ++i) threads.emplace_back(producer, i);
+
+      threads.clear();
+
+      const auto stats = ring.stats();
+
+      EXPECT_EQ(stats.in_use, 0u);
+      EXPECT_EQ(stats.outstanding_leases, 0u);
+      EXPECT_EQ(stats.ring_leases + stats.fallback_leases, thread_count * iterations);
+      EXPECT_GT(stats.ring_leases, 0u);
+
+      // Only the ring itself should still be allocated.
+      EXPECT_EQ(Counted_heap_memory::allocations, allocations + 1);
+   }
+
+   EXPECT_EQ(overlaps, 0u);
+   EXPECT_EQ(corrupted, 0u);
+   EXPECT_GT(ring_bytes, capacity * 16);
+   EXPECT_EQ(Counted_heap_memory::allocations, allocations);
+}
+
+}
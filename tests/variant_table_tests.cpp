@@ -0,0 +1,93 @@
+
+#include "shader/variant_table.hpp"
+
+#include <latch>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp::shader {
+
+TEST(Variant_table, finds_inserted_values)
+{
+   Variant_table<int> table;
+
+   EXPECT_EQ(table.find({.static_flags = 1}), nullptr);
+
+   table.insert({.static_flags = 1}, 10);
+   table.insert({.static_flags = 1, .game_flags = Vertex_shader_flags::normal}, 11);
+   table.insert({.static_flags = 2}, 20);
+
+   ASSERT_NE(table.find({.static_flags = 1}), nullptr);
+   EXPECT_EQ(*table.find({.static_flags = 1}), 10);
+   EXPECT_EQ(*table.find({.static_flags = 1, .game_flags = Vertex_shader_flags::normal}), 11);
+   EXPECT_EQ(*table.find({.static_flags = 2}), 20);
+   EXPECT_EQ(table.find({.static_flags = 3}), nullptr);
+   EXPECT_EQ(table.size(), 3u);
+}
+
+TEST(Variant_table, inserting_an_existing_key_returns_the_existing_value)
+{
+   Variant_table<int> table;
+
+   const int& first = table.insert({.static_flags = 5}, 1);
+   const int& second = table.insert({.static_flags = 5}, 2);
+
+   EXPECT_EQ(&first, &second);
+   EXPECT_EQ(second, 1);
+   EXPECT_EQ(table.size(), 1u);
+}
+
+TEST(Variant_table, values_stay_put_as_the_table_grows)
+{
+   Variant_table<std::uint64_t> table;
+   std::vector<const std::uint64_t*> values;
+
+   for (std::uint64_t i = 0; i < 4096; ++i) values.push_back(&table.insert({.static_flags = i}, i));
+
+   for (std::uint64_t i = 0; i < 4096; ++i) {
+      EXPECT_EQ(table.find({.static_flags = i}), values[i]);
+      EXPECT_EQ(*values[i], i);
+   }
+}
+
+TEST(Variant_table, racing_inserts_publish_each_key_once)
+{
+   constexpr std::size_t thread_count = 8;
+   constexpr std::uint64_t key_count = 2048;
+
+   Variant_table<std::uint64_t> table;
+   std::latch start{thread_count};
+   std::vector<std::vector<const std::uint64_t*>> results(thread_count);
+
+   {
+      std::vector<std::jthread> threads;
+
+      for (std::size_t t = 0; t < thread_count; ++t) {
+         threads.emplace_back([&, t] {
+            start.arrive_and_wait();
+
+            for (std::uint64_t i = 0; i < key_count; ++i) {
+               // Every thread inserts every key, with its own value.
+               results[t].push_back(&table.insert({.static_flags = i}, i * thread_count + t));
+            }
+         });
+      }
+   }
+
+   EXPECT_EQ(table.size(), key_count);
+
+   for (std::uint64_t i = 0; i < key_count; ++i) {
+      const std::uint64_t* published = table.find({.static_flags = i});
+
+      ASSERT_NE(published, nullptr);
+      EXPECT_EQ(*published / thread_count, i);
+
+      for (std::size_t t = 0; t < thread_count; ++t) {
+         EXPECT_EQ(results[t][i], published);
+      }
+   }
+}
+
+}
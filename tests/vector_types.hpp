@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cmath>
+
+namespace sp::tests {
+
+// Stand ins for glm's vectors in the tests of the munge's templated code.
+
+struct Float2 {
+   float x;
+   float y;
+
+   bool operator==(const Float2&) const = default;
+};
+
+struct Float3 {
+   float x;
+   float y;
+   float z;
+
+   bool operator==(const Float3&) const = default;
+
+   auto operator+=(const Float3& other) noexcept -> Float3&
+   {
+      x += other.x;
+      y += other.y;
+      z += other.z;
+
+      return *this;
+   }
+};
+
+// The vector math the munge templates find through argument dependent lookup,
+// in place of glm's.
+
+inline auto operator-(const Float3& left, const Float3& right) noexcept -> Float3
+{
+   return {left.x - right.x, left.y - right.y, left.z - right.z};
+}
+
+inline auto cross(const Float3& left, const Float3& right) noexcept -> Float3
+{
+   return {left.y * right.z - right.y * left.z, left.z * right.x - right.z * left.x,
+           left.x * right.y - right.x * left.y};
+}
+
+inline auto normalize(const Float3& vec) noexcept -> Float3
+{
+   const float inverse_length =
+      1.0f / std::sqrt(vec.x * vec.x + vec.y * vec.y + vec.z * vec.z);
+
+   return {vec.x * inverse_length, vec.y * inverse_length, vec.z * inverse_length};
+}
+
+}
@@ -0,0 +1,272 @@
+
+#include "vertex_buffer_codec.hpp"
+
+#include "synthetic_vertex_buffer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sp {
+
+namespace {
+
+using tests::Float2;
+using tests::Float3;
+using tests::Vertex_buffer;
+
+const tests::Position_decompress pos_decompress{.low = {-64.0f, -64.0f, -64.0f},
+                                                .mul = {128.0f, 128.0f, 128.0f}};
+const tests::Position_compress pos_compress{.min = {-64.0f, -64.0f, -64.0f},
+                                            .div = {128.0f, 128.0f, 128.0f}};
+
+auto bits(const Vbuf_flags flags) -> std::uint32_t
+{
+   return static_cast<std::uint32_t>(flags);
+}
+
+// Both arrays are missing or both hold count bitwise identical values.
+template<typename T>
+auto same_bytes(const std::unique_ptr<T[]>& left, const std::unique_ptr<T[]>& right,
+                const std::size_t count) -> bool
+{
+   if (!left || !right) return !left && !right;
+
+   return std::memcmp(left.get(), right.get(), sizeof(T) * count) == 0;
+}
+
+void expect_same_buffers(const Vertex_buffer& left, const Vertex_buffer& right,
+                         const Vbuf_flags flags)
+{
+   const std::size_t count = left.count;
+
+   ASSERT_EQ(count, right.count);
+
+   EXPECT_TRUE(same_bytes(left.positions, right.positions, count)) << bits(flags);
+   EXPECT_TRUE(same_bytes(left.blendindices, right.blendindices, count)) << bits(flags);
+   EXPECT_TRUE(same_bytes(left.blendweights, right.blendweights, count)) << bits(flags);
+   EXPECT_TRUE(same_bytes(left.normals, right.normals, count)) << bits(flags);
+   EXPECT_TRUE(same_bytes(left.tangents, right.tangents, count)) << bits(flags);
+   EXPECT_TRUE(same_bytes(left.binormals, right.binormals, count)) << bits(flags);
+   EXPECT_TRUE(same_bytes(left.colors, right.colors, count)) << bits(flags);
+   EXPECT_TRUE(same_bytes(left.static_lighting_colors, right.static_lighting_colors,
+                          count))
+      << bits(flags);
+   EXPECT_TRUE(same_bytes(left.texcoords, right.texcoords, count)) << bits(flags);
+}
+
+auto decode(const Vbuf_flags flags, const std::vector<std::byte>& bytes,
+            const std::size_t count) -> Vertex_buffer
+{
+   Vertex_buffer buffer{count, flags};
+
+   decode_vbuf_vertices(flags,
+                        {.data = bytes.data(),
+                         .count = count,
+                         .stride = get_vbuf_stride(flags)},
+                        pos_decompress, buffer);
+
+   return buffer;
+}
+
+auto encode(const Vertex_buffer& buffer, const Vbuf_flags flags) -> std::vector<std::byte>
+{
+   const std::size_t stride = get_vbuf_stride(flags);
+
+   std::vector<std::byte> bytes(buffer.count * stride);
+
+   encode_vbuf_vertices(buffer, flags, pos_compress,
+                        {.data = bytes.data(), .count = buffer.count, .stride = stride});
+
+   return bytes;
+}
+
+// Copies the attributes selected by flags out of a buffer holding all of them.
+auto select_attributes(const Vertex_buffer& source, const Vbuf_flags flags)
+   -> Vertex_buffer
+{
+   Vertex_buffer buffer{source.count, flags};
+
+   const auto copy = [&](auto& dest, const auto& src) {
+      if (dest) std::memcpy(dest.get(), src.get(), sizeof(dest[0]) * source.count);
+   };
+
+   copy(buffer.positions, source.positions);
+   copy(buffer.blendindices, source.blendindices);
+   copy(buffer.blendweights, source.blendweights);
+   copy(buffer.normals, source.normals);
+   copy(buffer.tangents, source.tangents);
+   copy(buffer.binormals, source.binormals);
+   copy(buffer.colors, source.colors);
+   copy(buffer.static_lighting_colors, source.static_lighting_colors);
+   copy(buffer.texcoords, source.texcoords);
+
+   return buffer;
+}
+
+}
+
+TEST(Vertex_buffer_codec, stride_matches_reference_layout)
+{
+   const auto bytes = tests::make_synthetic_vbuf(256, 0);
+
+   for (std::uint32_t i = 0; i < tests::vbuf_flags_combination_count; ++i) {
+      const Vbuf_flags flags = tests::vbuf_flags_combination(i);
+
+      const auto [buffer, size] =
+         tests::reference_vbuf::decode(flags, bytes.data(), 1, pos_decompress);
+
+      EXPECT_EQ(get_vbuf_stride(flags), size) << bits(flags);
+   }
+}
+
+TEST(Vertex_buffer_codec, decode_matches_reference_for_every_layout)
+{
+   constexpr std::size_t count = 13;
+
+   for (std::uint32_t i = 0; i < tests::vbuf_flags_combination_count; ++i) {
+      const Vbuf_flags flags = tests::vbuf_flags_combination(i);
+      const auto bytes = tests::make_synthetic_vbuf(get_vbuf_stride(flags) * count, i);
+
+      const auto [expected, size] =
+         tests::reference_vbuf::decode(flags, bytes.data(), count, pos_decompress);
+
+      expect_same_buffers(decode(flags, bytes, count), expected, flags);
+   }
+}
+
+TEST(Vertex_buffer_codec, encode_matches_reference_for_every_layout)
+{
+   constexpr std::size_t count = 13;
+
+   const auto source = tests::make_synthetic_vertex_buffer(count, 0);
+
+   for (std::uint32_t i = 0; i < 256; ++i) {
+      const Vbuf_flags attributes = tests::vbuf_flags_combination(i);
+      const bool has_tangents =
+         (attributes & Vbuf_flags::tangents) == Vbuf_flags::tangents;
+
+      // Buffers with tangents can lack binormals and carry bitangent signs.
+      for (int variant = 0; variant < (has_tangents ? 4 : 1); ++variant) {
+         auto buffer = select_attributes(source, attributes);
+
+         if (variant & 1) buffer.binormals = nullptr;
+
+         if (variant & 2) {
+            buffer.bitangent_signs = std::make_unique<float[]>(count);
+            std::memcpy(buffer.bitangent_signs.get(), source.bitangent_signs.get(),
+                        sizeof(float) * count);
+         }
+
+         for (const bool compressed : {false, true}) {
+            const Vbuf_flags flags = get_vbuf_flags(buffer, compressed);
+
+            EXPECT_EQ(encode(buffer, flags),
+                      tests::reference_vbuf::encode(buffer, flags, pos_compress))
+               << bits(flags) << " variant " << variant;
+         }
+      }
+   }
+}
+
+TEST(Vertex_buffer_codec, uncompressed_round_trip)
+{
+   constexpr std::size_t count = 1000;
+
+   const auto source = tests::make_synthetic_vertex_buffer(count, 1);
+   const Vbuf_flags flags = get_vbuf_flags(source, false);
+
+   const auto decoded = decode(flags, encode(source, flags), count);
+
+   for (std::size_t i = 0; i < count; ++i) {
+      EXPECT_EQ(decoded.positions[i], source.positions[i]);
+      EXPECT_EQ(decoded.blendindices[i], source.blendindices[i]);
+      EXPECT_EQ(decoded.blendweights[i].x, source.blendweights[i].x);
+      EXPECT_EQ(decoded.blendweights[i].y, source.blendweights[i].y);
+      EXPECT_EQ(decoded.blendweights[i].z,
+                static_cast<float>(1.0 - source.blendweights[i].x -
+                                   source.blendweights[i].y));
+      EXPECT_EQ(decoded.normals[i], source.normals[i]);
+      EXPECT_EQ(decoded.tangents[i], source.tangents[i]);
+      EXPECT_EQ(decoded.binormals[i], source.binormals[i]);
+      EXPECT_EQ(decoded.static_lighting_colors[i], source.static_lighting_colors[i]);
+      EXPECT_EQ(decoded.texcoords[i], source.texcoords[i]);
+   }
+}
+
+// Compressed values survive being decoded and encoded again, so munging an
+// already compressed model doesn't drift.
+TEST(Vertex_buffer_codec, compressed_round_trip_is_stable)
+{
+   constexpr std::size_t count = 1000;
+
+   auto source = tests::make_synthetic_vertex_buffer(count, 2);
+   source.bitangent_signs = nullptr; // Decoding doesn't recover them.
+
+   const Vbuf_flags flags = get_vbuf_flags(source, true);
+
+   const auto bytes = encode(source, flags);
+
+   EXPECT_EQ(encode(decode(flags, bytes, count), flags), bytes);
+}
+
+TEST(Vertex_buffer_codec, normal_round_trips_every_value)
+{
+   for (std::uint32_t packed = 0; packed < (1u << 24); ++packed) {
+      const auto normal = decompress_vbuf_normal<Float3>(packed);
+
+      ASSERT_EQ(compress_vbuf_normal(normal), packed);
+      ASSERT_EQ(normal, tests::reference_vbuf::decompress_normal(packed));
+   }
+}
+
+TEST(Vertex_buffer_codec, normal_keeps_w)
+{
+   for (std::uint32_t w = 0; w < 256; ++w) {
+      EXPECT_EQ(compress_vbuf_normal(Float3{-1.0f, 0.0f, 1.0f}, w / 255.0f),
+                (w << 24) | 0x00'00'80'ffu);
+   }
+}
+
+TEST(Vertex_buffer_codec, blendweights_round_trip_every_value)
+{
+   for (std::uint32_t packed = 0; packed < (1u << 24); ++packed) {
+      const auto weights = decompress_vbuf_blendweights<Float3>(packed);
+
+      ASSERT_EQ(compress_vbuf_blendweights(weights), packed);
+      ASSERT_EQ(weights.x, tests::reference_vbuf::unpack_unorm(packed, 2));
+      ASSERT_EQ(weights.z, tests::reference_vbuf::unpack_unorm(packed, 0));
+   }
+}
+
+TEST(Vertex_buffer_codec, unorm_clamps)
+{
+   EXPECT_EQ(pack_vbuf_unorm4x8({-1.0f, 2.0f, 0.5f, 1.0f}), 0xff'80'ff'00u);
+   EXPECT_EQ(compress_vbuf_normal(Float3{-4.0f, 4.0f, 0.0f}), 0x00'00'ff'80u);
+}
+
+TEST(Vertex_buffer_codec, texcoords_round_trip_every_value)
+{
+   for (int c = -32768; c <= 32767; ++c) {
+      const Vbuf_compressed_texcoords compressed{static_cast<std::int16_t>(c),
+                                                 static_cast<std::int16_t>(-1 - c)};
+
+      EXPECT_EQ(compress_vbuf_texcoords(decompress_vbuf_texcoords<Float2>(compressed)),
+                compressed);
+   }
+}
+
+TEST(Vertex_buffer_codec, texcoords_saturate)
+{
+   EXPECT_EQ(compress_vbuf_texcoords(Float2{100.0f, -100.0f}),
+             (Vbuf_compressed_texcoords{32767, -32768}));
+   EXPECT_EQ(compress_vbuf_texcoords(Float2{0.5f, -0.25f}),
+             (Vbuf_compressed_texcoords{1024, -512}));
+}
+
+}
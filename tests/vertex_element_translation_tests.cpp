@@ -0,0 +1,187 @@
+
+#include "direct3d/vertex_element_translation.hpp"
+
+#include <cstdint>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+namespace sp::d3d9 {
+
+namespace {
+
+struct Reference_translation {
+   Element_translation_result result = Element_translation_result::unknown_usage;
+   Element_translation translation;
+};
+
+// The switch create_input_layout used before the table, with the logging
+// replaced by the result it logged for.
+auto translate_element_reference(const std::uint8_t usage_value,
+                                 const std::uint8_t type_value) noexcept
+   -> Reference_translation
+{
+   using enum Element_format;
+
+   const auto usage = static_cast<Decl_usage>(usage_value);
+   const auto type = static_cast<Decl_type>(type_value);
+
+   const auto translated = [](const Element_format format,
+                              const Element_flag flag = Element_flag::none) {
+      return Reference_translation{Element_translation_result::translated,
+                                   {format, flag}};
+   };
+   const Reference_translation unknown_type{Element_translation_result::unknown_type, {}};
+
+   switch (usage) {
+   case Decl_usage::position: {
+      switch (type) {
+      case Decl_type::float1:
+         return translated(r32_float);
+      case Decl_type::float2:
+         return translated(r32g32_float);
+      case Decl_type::float3:
+         return translated(r32g32b32_float);
+      case Decl_type::float4:
+         return translated(r32g32b32a32_float);
+      case Decl_type::short2:
+         return translated(r16g16_sint);
+      case Decl_type::short4:
+         return translated(r16g16b16a16_sint, Element_flag::compressed_position);
+      default:
+         return unknown_type;
+      }
+   }
+   case Decl_usage::blendweight: {
+      switch (type) {
+      case Decl_type::float1:
+         return translated(r32_float);
+      case Decl_type::float2:
+         return translated(r32g32_float);
+      case Decl_type::float3:
+         return translated(r32g32b32_float);
+      case Decl_type::float4:
+         return translated(r32g32b32a32_float);
+      case Decl_type::d3dcolor:
+         return translated(b8g8r8a8_unorm);
+      default:
+         return unknown_type;
+      }
+   }
+   case Decl_usage::blendindices:
+   case Decl_usage::color: {
+      switch (type) {
+      case Decl_type::d3dcolor:
+         return translated(b8g8r8a8_unorm);
+      default:
+         return unknown_type;
+      }
+   }
+   case Decl_usage::normal:
+   case Decl_usage::tangent:
+   case Decl_usage::binormal: {
+      switch (type) {
+      case Decl_type::d3dcolor:
+         return translated(b8g8r8a8_unorm);
+      case Decl_type::float3:
+         return translated(r32g32b32_float);
+      default:
+         return unknown_type;
+      }
+   }
+   case Decl_usage::texcoord: {
+      switch (type) {
+      case Decl_type::float2:
+         return translated(r32g32_float);
+      case Decl_type::short2:
+         return translated(r16g16_sint, Element_flag::compressed_texcoords);
+      default:
+         return unknown_type;
+      }
+   }
+   case Decl_usage::positiont: {
+      return {Element_translation_result::pretransformed, {}};
+   }
+   default: {
+      return {Element_translation_result::unknown_usage, {}};
+   }
+   }
+}
+
+}
+
+TEST(Vertex_element_translation, matches_reference_switch)
+{
+   for (std::uint32_t usage = 0; usage <= 0xffu; ++usage) {
+      for (std::uint32_t type = 0; type <= 0xffu; ++type) {
+         const auto expected =
+            translate_element_reference(static_cast<std::uint8_t>(usage),
+                                        static_cast<std::uint8_t>(type));
+
+         Element_translation translation;
+
+         const auto result =
+            element_translations.translate(static_cast<std::uint8_t>(usage),
+                                           static_cast<std::uint8_t>(type),
+                                           translation);
+
+         ASSERT_EQ(result, expected.result) << "usage " << usage << " type " << type;
+
+         if (result == Element_translation_result::translated) {
+            ASSERT_EQ(translation, expected.translation)
+               << "usage " << usage << " type " << type;
+         }
+      }
+   }
+}
+
+TEST(Vertex_element_translation, untranslated_leaves_output_alone)
+{
+   const Element_translation sentinel{Element_format::r32_float,
+                                      Element_flag::compressed_position};
+
+   for (const auto& [usage, type] : {std::pair{Decl_usage::position, Decl_type::udec3},
+                                    std::pair{Decl_usage::positiont, Decl_type::float4},
+                                    std::pair{Decl_usage::psize, Decl_type::float1}}) {
+      Element_translation translation = sentinel;
+
+      EXPECT_NE(element_translations.translate(static_cast<std::uint8_t>(usage),
+                                               static_cast<std::uint8_t>(type),
+                                               translation),
+                Element_translation_result::translated);
+      EXPECT_EQ(translation, sentinel);
+   }
+}
+
+TEST(Vertex_element_translation, unused_type_is_unknown)
+{
+   Element_translation translation;
+
+   EXPECT_EQ(element_translations.translate(
+                static_cast<std::uint8_t>(Decl_usage::position),
+                static_cast<std::uint8_t>(Decl_type::unused), translation),
+             Element_translation_result::unknown_type);
+}
+
+TEST(Vertex_element_translation, compressed_flags)
+{
+   constexpr auto translate = [](const Decl_usage usage, const Decl_type type) {
+      Element_translation translation;
+
+      element_translations.translate(static_cast<std::uint8_t>(usage),
+                                     static_cast<std::uint8_t>(type), translation);
+
+      return translation.flag;
+   };
+
+   static_assert(translate(Decl_usage::position, Decl_type::short4) ==
+                 Element_flag::compressed_position);
+   static_assert(translate(Decl_usage::position, Decl_type::short2) ==
+                 Element_flag::none);
+   static_assert(translate(Decl_usage::texcoord, Decl_type::short2) ==
+                 Element_flag::compressed_texcoords);
+   static_assert(translate(Decl_usage::texcoord, Decl_type::float2) ==
+                 Element_flag::none);
+}
+
+}
@@ -157,6 +157,8 @@ struct user_config {
 
        bool_user_config_value{L"Use DXGI 1.2 Factory", false, L"Yes", L"No"},
 
+       bool_user_config_value{L"Record Shader Usage", false, L"Yes", L"No"},
+
        string_user_config_value{L"Shader Cache Path",
                                 LR"(.\data\shaderpatch\.shader_dxbc_cache)"},
 
@@ -6,6 +6,7 @@
 #include "material_flags.hpp"
 #include "memory_mapped_file.hpp"
 #include "optimize_mesh.hpp"
+#include "parallel_edit.hpp"
 #include "ucfb_editor.hpp"
 #include "ucfb_tweaker.hpp"
 #include "ucfb_writer.hpp"
@@ -13,6 +14,7 @@
 
 #include <fstream>
 #include <string>
+#include <vector>
 
 #include <d3d9.h>
 
@@ -278,36 +280,45 @@ void edit_segm(ucfb::Editor_parent_chunk& segm,
    edit_ibuf_vbufs(segm, options, vert_box);
 }
 
-void edit_modl(ucfb::Editor_parent_chunk& modl,
-               const std::unordered_map<Ci_string, Material_options>& material_index,
-               const bool patch_material_flags)
+auto read_vert_box(ucfb::Editor_parent_chunk& modl) -> std::array<glm::vec3, 2>
 {
-   const auto vert_box = [&] {
-      auto info = make_reader(ucfb::find(modl, "INFO"_mn));
-
-      info.read_multi<std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t>();
+   auto info = make_reader(ucfb::find(modl, "INFO"_mn));
 
-      static_assert(sizeof(std::array<glm::vec3, 2>) == 24);
+   info.read_multi<std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t>();
 
-      return info.read<std::array<glm::vec3, 2>>();
-   }();
+   static_assert(sizeof(std::array<glm::vec3, 2>) == 24);
 
-   for (auto it = ucfb::find(modl, "segm"_mn); it != modl.end();
-        it = ucfb::find(it + 1, modl.end(), "segm"_mn)) {
-      edit_segm(std::get<ucfb::Editor_parent_chunk>(it->second), material_index,
-                patch_material_flags, vert_box);
-   }
+   return info.read<std::array<glm::vec3, 2>>();
 }
 
 void edit_modl_chunks(ucfb::Editor_parent_chunk& root,
                       const std::unordered_map<Ci_string, Material_options>& material_index,
                       const bool patch_material_flags)
 {
+   struct Segment {
+      ucfb::Editor_parent_chunk& segm;
+      std::array<glm::vec3, 2> vert_box;
+   };
+
+   std::vector<Segment> segments;
+
    for (auto it = ucfb::find(root, "modl"_mn); it != root.end();
         it = ucfb::find(it + 1, root.end(), "modl"_mn)) {
-      edit_modl(std::get<ucfb::Editor_parent_chunk>(it->second), material_index,
-                patch_material_flags);
+      auto& modl = std::get<ucfb::Editor_parent_chunk>(it->second);
+      const auto vert_box = read_vert_box(modl);
+
+      for (auto segm_it = ucfb::find(modl, "segm"_mn); segm_it != modl.end();
+           segm_it = ucfb::find(segm_it + 1, modl.end(), "segm"_mn)) {
+         segments.push_back({std::get<ucfb::Editor_parent_chunk>(segm_it->second),
+                             vert_box});
+      }
    }
+
+   // Segments only edit their own chunks so they can be edited in parallel.
+   edit_in_parallel(segments.size(), [&](const std::size_t i) {
+      edit_segm(segments[i].segm, material_index, patch_material_flags,
+                segments[i].vert_box);
+   });
 }
 }
 
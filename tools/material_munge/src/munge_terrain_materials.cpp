@@ -10,6 +10,8 @@
 #include "ucfb_reader.hpp"
 #include "utility.hpp"
 
+#include <algorithm>
+#include <execution>
 #include <fstream>
 #include <stdexcept>
 #include <vector>
@@ -77,9 +79,9 @@ void munge_terrain_materials(const std::unordered_map<Ci_string, std::filesystem
                              const std::filesystem::path& input_munge_files_dir,
                              const std::filesystem::path& input_sptex_files_dir) noexcept
 {
-   for (const auto& file : source_files) {
+   const auto munge_terrain = [&](const auto& file) noexcept {
       try {
-         if (file.second.extension() != ".tmtrl"_svci) continue;
+         if (file.second.extension() != ".tmtrl"_svci) return;
 
          const auto config_last_write_time = fs::last_write_time(file.second);
 
@@ -113,6 +115,11 @@ void munge_terrain_materials(const std::unordered_map<Ci_string, std::filesystem
       catch (std::exception& e) {
          synced_error_print("Error munging "sv, file.first, ": "sv, e.what());
       }
-   }
+   };
+
+   // Each terrain writes only its own outputs so they can all be munged at
+   // once, the per-segment work inside them is parallel as well.
+   std::for_each(std::execution::par, source_files.cbegin(), source_files.cend(),
+                 munge_terrain);
 }
 }
@@ -1,7 +1,9 @@
 
 #include "optimize_mesh.hpp"
 
+#include <span>
 #include <utility>
+#include <vector>
 
 #include <DirectXMesh.h>
 
@@ -11,6 +13,17 @@ static_assert(sizeof(std::array<std::array<std::uint16_t, 3>, 2>) == 12);
 
 namespace {
 
+// Remap tables are scratch space, kept per thread so meshes optimized in
+// parallel (model segments, terrain patches) reuse their allocations.
+auto remap_scratch(const std::size_t size) noexcept -> std::span<std::uint32_t>
+{
+   thread_local std::vector<std::uint32_t> remap;
+
+   remap.resize(size);
+
+   return remap;
+}
+
 auto init_dest_vertex_buffer(const Vertex_buffer& old) noexcept -> Vertex_buffer
 {
    Vertex_buffer vertex_buffer{};
@@ -54,8 +67,7 @@ auto init_dest_vertex_buffer(const Vertex_buffer& old) noexcept -> Vertex_buffer
 auto optimize_index_buffer(Index_buffer_16 index_buffer)
    -> std::vector<std::array<std::uint16_t, 3>>
 {
-   std::vector<std::uint32_t> remap;
-   remap.resize(index_buffer.size());
+   const auto remap = remap_scratch(index_buffer.size());
 
    if (const auto result =
           DirectX::OptimizeFacesLRU(index_buffer[0].data(), index_buffer.size(),
@@ -76,8 +88,7 @@ auto optimize_index_buffer(Index_buffer_16 index_buffer)
 auto optimize_vertex_buffer(Index_buffer_16 index_buffer, const Vertex_buffer& vertex_buffer)
    -> std::pair<std::vector<std::array<std::uint16_t, 3>>, Vertex_buffer>
 {
-   std::vector<std::uint32_t> remap;
-   remap.resize(vertex_buffer.count);
+   const auto remap = remap_scratch(vertex_buffer.count);
 
    if (const auto result =
           DirectX::OptimizeVertices(index_buffer[0].data(), index_buffer.size(),
@@ -135,8 +146,7 @@ auto optimize_vertex_buffer(Index_buffer_16 index_buffer, const Vertex_buffer& v
 auto optimize_vertex_buffer(Index_buffer_16 index_buffer, Terrain_vertex_buffer vertex_buffer)
    -> std::pair<Index_buffer_16, Terrain_vertex_buffer>
 {
-   std::vector<std::uint32_t> remap;
-   remap.resize(vertex_buffer.size());
+   const auto remap = remap_scratch(vertex_buffer.size());
 
    if (const auto result =
           DirectX::OptimizeVertices(index_buffer[0].data(), index_buffer.size(),
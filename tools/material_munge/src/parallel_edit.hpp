@@ -0,0 +1,37 @@
+#pragma once
+
+#include "index_iterator.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <execution>
+#include <vector>
+
+namespace sp {
+
+// Calls edit(i) for every i below count in parallel. Each call must only write
+// to state of its own. Errors are held until every call has finished and the
+// one with the lowest index is rethrown, the same error a serial loop would
+// have stopped at.
+template<typename Edit>
+void edit_in_parallel(const std::size_t count, const Edit& edit)
+{
+   std::vector<std::exception_ptr> errors(count);
+
+   std::for_each_n(std::execution::par, Index_iterator{}, count,
+                   [&](const std::size_t i) noexcept {
+                      try {
+                         edit(i);
+                      }
+                      catch (...) {
+                         errors[i] = std::current_exception();
+                      }
+                   });
+
+   for (const auto& error : errors) {
+      if (error) std::rethrow_exception(error);
+   }
+}
+
+}
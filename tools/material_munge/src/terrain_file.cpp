@@ -0,0 +1,73 @@
+
+#include "terrain_file.hpp"
+#include "srgb_conversion_scalar.hpp"
+
+namespace sp {
+
+auto parse_terrain_file(const std::span<const std::byte> bytes) -> Terrain_file
+{
+   Terrain_reader reader{bytes};
+
+   Terrain_file file{reader.read<Terr_header>()};
+
+   const auto& header = file.header;
+   const std::size_t texel_count = header.terrain_length * header.terrain_length;
+
+   // Skip Decal Tiles
+   reader.skip(sizeof(Terrain_decal_tile) * header.decal_settings.tile_count + 8);
+
+   file.heights = reader.read_bytes(texel_count * sizeof(std::int16_t));
+   file.foreground_colors = reader.read_bytes(texel_count * sizeof(Terrain_color));
+   file.background_colors = reader.read_bytes(texel_count * sizeof(Terrain_color));
+
+   if (header.prelit) {
+      file.diffuse_lighting = reader.read_bytes(texel_count * sizeof(Terrain_color));
+   }
+
+   file.texture_weights =
+      reader.read_bytes(texel_count * sizeof(std::array<std::uint8_t, 16>));
+   file.trailing = reader.remaining();
+
+   return file;
+}
+
+auto terrain_unorm8_tables() noexcept -> const Terrain_unorm8_tables&
+{
+   static const Terrain_unorm8_tables tables = [] {
+      Terrain_unorm8_tables tables;
+
+      for (std::size_t i = 0; i < 256; ++i) {
+         tables.linear[i] = i / 255.f;
+         tables.srgb[i] = decompress_srgb(i / 255.f);
+      }
+
+      return tables;
+   }();
+
+   return tables;
+}
+
+void decode_terrain_texture_weights(
+   const Terrain_file& file, const std::array<std::uint8_t, 16>& texture_remap,
+   const std::span<std::array<float, 16>> output) noexcept
+{
+   using Unorm_weights = std::array<std::uint8_t, 16>;
+
+   const auto& header = file.header;
+   const auto& tables = terrain_unorm8_tables();
+
+   detail::for_each_terrain_row(file, [&](const std::ptrdiff_t y,
+                                          const std::ptrdiff_t out) noexcept {
+      for (std::ptrdiff_t x = header.extents[0]; x <= header.extents[2]; ++x) {
+         const auto unorm_weight = detail::load<Unorm_weights>(
+            &file.texture_weights[file.indexer.in(x, y) * sizeof(Unorm_weights)]);
+         auto& weight = output[out + (x - header.extents[0])];
+
+         for (std::size_t i = 0; i < unorm_weight.size(); ++i) {
+            weight[texture_remap[i]] = tables.linear[unorm_weight[i]];
+         }
+      }
+   });
+}
+
+}
@@ -0,0 +1,354 @@
+#pragma once
+
+#include "index_iterator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <execution>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+namespace sp {
+
+// The SWBFII .ter file format and the conversion of its layers into the
+// munge's floating point representation. Kept free of glm, the conversions are
+// templated on the three component vector type they write.
+
+enum class Terrain_munge_flags : std::uint8_t {
+   terrain = 0b1,
+   water = 0b10,
+   foliage = 0b100,
+};
+
+struct Terrain_string {
+   char chars[32];
+
+   constexpr operator std::string_view() const noexcept
+   {
+      std::string_view sv{chars, sizeof(chars)};
+
+      if (const auto offset = sv.find_first_of('\0'); offset != sv.npos)
+         sv.remove_suffix(sv.size() - offset);
+
+      return sv;
+   }
+};
+
+static_assert(sizeof(Terrain_string) == 32);
+
+struct Terrain_color {
+   std::uint8_t blue;
+   std::uint8_t green;
+   std::uint8_t red;
+   std::uint8_t alpha;
+};
+
+static_assert(sizeof(Terrain_color) == sizeof(std::uint32_t));
+
+struct Terrain_texture_name {
+   Terrain_string diffuse;
+   Terrain_string detail;
+};
+
+struct Terrain_water_settings {
+   float height;
+   float unused[3];
+   float u_velocity;
+   float v_velocity;
+   float u_repeat;
+   float v_repeat;
+   Terrain_color colour;
+   Terrain_string texture;
+};
+
+struct Terrain_decal_settings {
+   struct {
+      Terrain_string name;
+   } textures[16];
+   std::int32_t tile_count;
+};
+
+struct Terrain_decal_coords {
+   float x;
+   float z;
+};
+
+struct Terrain_decal_tile {
+   std::int32_t x;
+   std::int32_t z;
+   std::int32_t texture;
+   Terrain_decal_coords coords[4];
+};
+
+#pragma pack(push, 1) // Instead of using this you could manually read in and align the header after munge_flags
+
+struct Terr_header {
+   char mn[4];
+   std::int32_t version; // 21 = SWBF1, 22 = SWBFII, this file assumes SWBFII
+   std::int16_t extents[4];
+   std::int32_t unknown;
+   float tex_scales[16];
+   std::uint8_t tex_axes[16]; // Terrain_texture_axis
+   float tex_rotations[16];
+   float height_scale; // in meters
+   float grid_scale;   // in meters
+   std::int32_t prelit;
+   std::int32_t terrain_length;
+   std::int32_t grids_per_foliage; // unclear if any value other than 2 is valid here, Zero always saves out 2
+   Terrain_munge_flags munge_flags; // Not present in SWBF1 terrain files.
+   Terrain_texture_name texture_names[16];
+   Terrain_water_settings water_settings_0; // unused
+   Terrain_water_settings water_settings;
+   Terrain_water_settings water_settings_2_14[14]; // unused
+   Terrain_decal_settings decal_settings;          // unused
+};
+
+static_assert(sizeof(Terr_header) == 2813);
+
+#pragma pack(pop)
+
+class Terrain_indexer {
+public:
+   Terrain_indexer(const Terr_header& header)
+   {
+      _terrain_length = header.terrain_length;
+      _out_length = std::abs(header.extents[0] - header.extents[2]) + 1;
+      _in_base = header.terrain_length / 2;
+      _in_mask = header.terrain_length - 1;
+      _out_offset_y = header.extents[3];
+      _out_offset_x = header.extents[2];
+   };
+
+   auto in(const std::ptrdiff_t x, const std::ptrdiff_t y) const noexcept -> std::ptrdiff_t
+   {
+      return (((_in_base + y) & _in_mask) * _terrain_length) +
+             ((_in_base + x) & _in_mask);
+   }
+
+   auto out(const std::ptrdiff_t x, const std::ptrdiff_t y) const noexcept -> std::ptrdiff_t
+   {
+      return ((y + _out_offset_y) * _out_length) + (x + _out_offset_x);
+   }
+
+private:
+   int _terrain_length = 0;
+   int _in_base = 0;
+   int _in_mask = 0;
+   int _out_length = 0;
+   int _out_offset_y = 0;
+   int _out_offset_x = 0;
+};
+
+// Cursor over the mapped terrain file. Nothing in the file past the header is
+// guaranteed to be aligned so values are loaded with memcpy.
+class Terrain_reader {
+public:
+   explicit Terrain_reader(const std::span<const std::byte> bytes) noexcept
+      : _bytes{bytes}
+   {
+   }
+
+   template<typename T>
+   auto read() -> T
+   {
+      static_assert(std::is_trivially_copyable_v<T>);
+
+      T value;
+
+      std::memcpy(&value, read_bytes(sizeof(T)).data(), sizeof(T));
+
+      return value;
+   }
+
+   auto read_bytes(const std::size_t size) -> std::span<const std::byte>
+   {
+      if (size > _bytes.size() - _offset) {
+         throw std::out_of_range{"Unexpected end of terrain file."};
+      }
+
+      const auto bytes = _bytes.subspan(_offset, size);
+
+      _offset += size;
+
+      return bytes;
+   }
+
+   void skip(const std::size_t size)
+   {
+      (void)read_bytes(size);
+   }
+
+   auto remaining() const noexcept -> std::span<const std::byte>
+   {
+      return _bytes.subspan(_offset);
+   }
+
+private:
+   std::span<const std::byte> _bytes;
+   std::size_t _offset = 0;
+};
+
+// The header of a terrain file and views of its layers, still in the file's
+// wrapped layout.
+struct Terrain_file {
+   explicit Terrain_file(const Terr_header& header) noexcept
+      : header{header}, indexer{header}
+   {
+   }
+
+   Terr_header header;
+   Terrain_indexer indexer;
+
+   std::span<const std::byte> heights;
+   std::span<const std::byte> foreground_colors;
+   std::span<const std::byte> background_colors;
+   std::span<const std::byte> diffuse_lighting; // Empty unless the terrain is prelit.
+   std::span<const std::byte> texture_weights;
+
+   // Everything after the texture weights.
+   std::span<const std::byte> trailing;
+
+   // Length of the terrain's extents, the maps converted layers are written to
+   // are length * length texels.
+   auto length() const noexcept -> std::uint16_t
+   {
+      return static_cast<std::uint16_t>(
+         std::abs(header.extents[0] - header.extents[2]) + 1);
+   }
+};
+
+// Throws std::out_of_range if the file ends before its texture weights do.
+auto parse_terrain_file(const std::span<const std::byte> bytes) -> Terrain_file;
+
+// sRGB decode and UNORM conversion for every possible channel value, computed
+// with the same functions as a per texel conversion so results are identical.
+struct Terrain_unorm8_tables {
+   std::array<float, 256> linear;
+   std::array<float, 256> srgb;
+};
+
+auto terrain_unorm8_tables() noexcept -> const Terrain_unorm8_tables&;
+
+void decode_terrain_texture_weights(
+   const Terrain_file& file, const std::array<std::uint8_t, 16>& texture_remap,
+   const std::span<std::array<float, 16>> output) noexcept;
+
+namespace detail {
+
+template<typename T>
+auto load(const std::byte* const bytes) noexcept -> T
+{
+   T value;
+
+   std::memcpy(&value, bytes, sizeof(T));
+
+   return value;
+}
+
+inline auto load_terrain_color(const std::byte* const bytes,
+                               const Terrain_unorm8_tables& tables) noexcept
+   -> std::array<float, 4>
+{
+   const auto color = load<Terrain_color>(bytes);
+
+   return {tables.srgb[color.red], tables.srgb[color.green], tables.srgb[color.blue],
+           tables.linear[color.alpha]};
+}
+
+// Calls convert_row(y, out_row) for each row of the map in parallel, out_row is
+// the index of the first texel of the row in the map's arrays.
+template<typename Convert_row>
+void for_each_terrain_row(const Terrain_file& file, Convert_row&& convert_row) noexcept
+{
+   const auto& header = file.header;
+   const std::ptrdiff_t row_count = header.extents[3] - header.extents[1] + 1;
+
+   if (row_count <= 0) return;
+
+   std::for_each_n(std::execution::par, Index_iterator{}, row_count,
+                   [&](const std::ptrdiff_t row) noexcept {
+                      const std::ptrdiff_t y = header.extents[1] + row;
+
+                      convert_row(y, file.indexer.out(header.extents[0], y));
+                   });
+}
+
+}
+
+template<typename Vec3>
+void decode_terrain_heights(const Terrain_file& file, const Vec3 terrain_offset,
+                            const std::span<Vec3> output) noexcept
+{
+   const auto& header = file.header;
+
+   detail::for_each_terrain_row(file, [&](const std::ptrdiff_t y,
+                                          const std::ptrdiff_t out) noexcept {
+      const float z = -(y * header.grid_scale);
+
+      for (std::ptrdiff_t x = header.extents[0]; x <= header.extents[2]; ++x) {
+         const auto height = detail::load<std::int16_t>(
+            &file.heights[file.indexer.in(x, y) * sizeof(std::int16_t)]);
+
+         output[out + (x - header.extents[0])] =
+            Vec3{x * header.grid_scale + terrain_offset.x,
+                 height * header.height_scale + terrain_offset.y, z + terrain_offset.z};
+      }
+   });
+}
+
+// Blends the foreground color layer over the background layer.
+template<typename Vec3>
+void decode_terrain_colors(const Terrain_file& file,
+                           const std::span<Vec3> output) noexcept
+{
+   const auto& header = file.header;
+   const auto& tables = terrain_unorm8_tables();
+
+   detail::for_each_terrain_row(file, [&](const std::ptrdiff_t y,
+                                          const std::ptrdiff_t out) noexcept {
+      for (std::ptrdiff_t x = header.extents[0]; x <= header.extents[2]; ++x) {
+         const std::size_t offset = file.indexer.in(x, y) * sizeof(Terrain_color);
+
+         const auto foreground =
+            detail::load_terrain_color(&file.foreground_colors[offset], tables);
+         const auto background =
+            detail::load_terrain_color(&file.background_colors[offset], tables);
+         const float background_weight = 1.f - foreground[3];
+
+         output[out + (x - header.extents[0])] =
+            Vec3{(background[0] * background[3]) * background_weight +
+                    foreground[0] * foreground[3],
+                 (background[1] * background[3]) * background_weight +
+                    foreground[1] * foreground[3],
+                 (background[2] * background[3]) * background_weight +
+                    foreground[2] * foreground[3]};
+      }
+   });
+}
+
+template<typename Vec3>
+void decode_terrain_diffuse_lighting(const Terrain_file& file,
+                                     const std::span<Vec3> output) noexcept
+{
+   const auto& header = file.header;
+   const auto& tables = terrain_unorm8_tables();
+
+   detail::for_each_terrain_row(file, [&](const std::ptrdiff_t y,
+                                          const std::ptrdiff_t out) noexcept {
+      for (std::ptrdiff_t x = header.extents[0]; x <= header.extents[2]; ++x) {
+         const auto color = detail::load_terrain_color(
+            &file.diffuse_lighting[file.indexer.in(x, y) * sizeof(Terrain_color)],
+            tables);
+
+         output[out + (x - header.extents[0])] = Vec3{color[0], color[1], color[2]};
+      }
+   });
+}
+
+}
@@ -1,10 +1,13 @@
 
 #include "terrain_model_segment.hpp"
 #include "optimize_mesh.hpp"
+#include "utility.hpp"
 #include "weld_vertex_list.hpp"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <execution>
 #include <limits>
 #include <stdexcept>
 #include <tuple>
@@ -83,22 +86,33 @@ auto create_terrain_model_segments(const Terrain_triangle_list& triangles)
       sort_into_segments(triangles, get_max_xy_length(triangles));
 
    std::vector<Terrain_model_segment> segments;
-   segments.reserve(segment_grid_length * segment_grid_length);
+   segments.resize(segment_grid_length * segment_grid_length);
 
-   for (auto& row : sorted_tris) {
-      for (auto& tris : row) {
-         auto indexed_tris = weld_vertex_list(tris);
+   std::atomic_bool too_many_vertices = false;
 
-         if (indexed_tris.second.size() > std::numeric_limits<std::uint16_t>::max()) {
-            throw std::runtime_error{
-               "Terrain has too many vertices to handle!"};
-         }
+   // Segments are welded in parallel but each writes to its own slot so the
+   // output order matches the grid order regardless of scheduling.
+   std::for_each_n(std::execution::par, Index_iterator{}, segments.size(),
+                   [&](const std::ptrdiff_t i) noexcept {
+                      const auto& tris = sorted_tris[i / segment_grid_length]
+                                                    [i % segment_grid_length];
+                      auto indexed_tris = weld_vertex_list(tris);
 
-         const auto bbox = get_bbox(indexed_tris.second);
+                      if (indexed_tris.second.size() >
+                          std::numeric_limits<std::uint16_t>::max()) {
+                         too_many_vertices = true;
 
-         segments.push_back({shrink_index_buffer(indexed_tris.first),
-                             std::move(indexed_tris.second), bbox});
-      }
+                         return;
+                      }
+
+                      const auto bbox = get_bbox(indexed_tris.second);
+
+                      segments[i] = {shrink_index_buffer(indexed_tris.first),
+                                     std::move(indexed_tris.second), bbox};
+                   });
+
+   if (too_many_vertices) {
+      throw std::runtime_error{"Terrain has too many vertices to handle!"};
    }
 
    return segments;
@@ -125,10 +139,12 @@ auto create_terrain_low_detail_model_segment(const Terrain_triangle_list& triang
 auto optimize_terrain_model_segments(std::vector<Terrain_model_segment> segments) noexcept
    -> std::vector<Terrain_model_segment>
 {
-   for (auto& segment : segments) {
-      std::tie(segment.indices, segment.vertices) =
-         optimize_mesh(std::move(segment.indices), std::move(segment.vertices));
-   }
+   std::for_each(std::execution::par, segments.begin(), segments.end(),
+                 [](Terrain_model_segment& segment) noexcept {
+                    std::tie(segment.indices, segment.vertices) =
+                       optimize_mesh(std::move(segment.indices),
+                                     std::move(segment.vertices));
+                 });
 
    return segments;
 }
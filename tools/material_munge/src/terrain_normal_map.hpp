@@ -0,0 +1,74 @@
+#pragma once
+
+#include "index_iterator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <execution>
+#include <span>
+
+namespace sp {
+
+// Builds the vertex normals of a length * length terrain height field, each
+// vertex's normal is the normalized sum of the triangles around it. cross and
+// normalize are found through argument dependent lookup so this stays free of
+// glm.
+//
+// Each vertex gathers the normals of the quads around it in the same order a
+// serial scatter over the quads would add them, so rows can be done in
+// parallel and still produce identical sums.
+template<typename Vec3>
+void build_terrain_normal_map(const int length, const std::span<const Vec3> positions,
+                              const std::span<Vec3> normals) noexcept
+{
+   const auto quad_normals = [&](const int x, const int y) {
+      const auto i0 = x + (y * length);
+      const auto i1 = x + ((y + 1) * length);
+      const auto i2 = (x + 1) + (y * length);
+      const auto i3 = (x + 1) + ((y + 1) * length);
+
+      return std::array{cross(positions[i2] - positions[i0],
+                              positions[i3] - positions[i0]),
+                        cross(positions[i3] - positions[i0],
+                              positions[i1] - positions[i0])};
+   };
+
+   const auto quads = length - 1;
+
+   const auto gather_row = [&](const std::ptrdiff_t row) noexcept {
+      const auto y = static_cast<int>(row);
+
+      for (auto x = 0; x < length; ++x) {
+         Vec3 normal{};
+
+         if (y > 0) {
+            if (x > 0) {
+               const auto tris = quad_normals(x - 1, y - 1);
+
+               normal += tris[0];
+               normal += tris[1];
+            }
+
+            if (x < quads) normal += quad_normals(x, y - 1)[1];
+         }
+
+         if (y < quads) {
+            if (x > 0) normal += quad_normals(x - 1, y)[0];
+
+            if (x < quads) {
+               const auto tris = quad_normals(x, y);
+
+               normal += tris[0];
+               normal += tris[1];
+            }
+         }
+
+         normals[x + (y * length)] = normalize(normal);
+      }
+   };
+
+   std::for_each_n(std::execution::par, Index_iterator{}, length, gather_row);
+}
+
+}
@@ -2,6 +2,8 @@
 #include "generate_tangents.hpp"
 #include "image_span.hpp"
 #include "srgb_conversion.hpp"
+#include "terrain_normal_map.hpp"
+#include "utility.hpp"
 #include "vertex_buffer.hpp"
 
 #include <algorithm>
@@ -140,56 +142,29 @@ auto create_terrain_normal_map(const Terrain_map& terrain) -> std::vector<glm::v
    std::vector<glm::vec3> normals;
    normals.resize(terrain.length * terrain.length);
 
-   for (auto y = 0; y < (terrain.length - 1); ++y) {
-      for (auto x = 0; x < (terrain.length - 1); ++x) {
-         const auto i0 = x + (y * terrain.length);
-         const auto i1 = x + ((y + 1) * terrain.length);
-         const auto i2 = (x + 1) + (y * terrain.length);
-         const auto i3 = (x + 1) + ((y + 1) * terrain.length);
-
-         const auto v0 = terrain.position[i0];
-         const auto v1 = terrain.position[i1];
-         const auto v2 = terrain.position[i2];
-         const auto v3 = terrain.position[i3];
-
-         // tri 0
-         {
-            const glm::vec3 e1 = terrain.position[i2] - terrain.position[i0];
-            const glm::vec3 e2 = terrain.position[i3] - terrain.position[i0];
-            const glm::vec3 normal = glm::cross(e1, e2);
-
-            normals[i0] += normal;
-            normals[i2] += normal;
-            normals[i3] += normal;
-         }
-
-         // tri 1
-         {
-            const glm::vec3 e1 = terrain.position[i3] - terrain.position[i0];
-            const glm::vec3 e2 = terrain.position[i1] - terrain.position[i0];
-            const glm::vec3 normal = glm::cross(e1, e2);
-
-            normals[i0] += normal;
-            normals[i3] += normal;
-            normals[i1] += normal;
-         }
-      }
-   }
-
-   for (auto& normal : normals) normal = glm::normalize(normal);
+   build_terrain_normal_map(terrain.length,
+                            std::span<const glm::vec3>{terrain.position.get(),
+                                                       normals.size()},
+                            std::span{normals});
 
    return normals;
 }
 
 auto create_terrain_triangles(const Terrain_map& terrain) -> Terrain_triangle_list
 {
+   const auto quads = terrain.length - 1;
+
    Terrain_triangle_list tris;
-   tris.reserve((terrain.length - 1) * (terrain.length - 1) * 2);
+   tris.resize(quads * quads * 2);
 
    const auto normals = create_terrain_normal_map(terrain);
 
-   for (auto y = 0; y < (terrain.length - 1); ++y) {
-      for (auto x = 0; x < (terrain.length - 1); ++x) {
+   // Every quad owns two fixed slots in the list, keeping the order the same
+   // as a serial walk over the rows.
+   const auto create_row = [&](const std::ptrdiff_t row) noexcept {
+      const auto y = static_cast<int>(row);
+
+      for (auto x = 0; x < quads; ++x) {
          const glm::ivec2 xy0{x, y};
          const glm::ivec2 xy1{x, y + 1};
          const glm::ivec2 xy2{x + 1, y};
@@ -225,8 +200,10 @@ auto create_terrain_triangles(const Terrain_map& terrain) -> Terrain_triangle_li
          v3.diffuse_lighting = terrain.diffuse_lighting[i3];
          v3.base_color = terrain.color[i3];
 
+         const auto quad = (x + (y * quads)) * 2;
+
          {
-            auto& tri0 = tris.emplace_back(std::array{v0, v2, v3});
+            auto& tri0 = tris[quad] = std::array{v0, v2, v3};
 
             auto [tri0_tex_indices, tri0_tex_weights] =
                select_textures(terrain, {xy0, xy2, xy3});
@@ -240,7 +217,7 @@ auto create_terrain_triangles(const Terrain_map& terrain) -> Terrain_triangle_li
          }
 
          {
-            auto& tri1 = tris.emplace_back(std::array{v0, v3, v1});
+            auto& tri1 = tris[quad + 1] = std::array{v0, v3, v1};
 
             auto [tri1_tex_indices, tri1_tex_weights] =
                select_textures(terrain, {xy0, xy3, xy1});
@@ -253,7 +230,9 @@ auto create_terrain_triangles(const Terrain_map& terrain) -> Terrain_triangle_li
             tri1[2].texture_blend = tri1_tex_weights[2];
          }
       }
-   }
+   };
+
+   std::for_each_n(std::execution::par, Index_iterator{}, quads, create_row);
 
    return tris;
 }
@@ -315,9 +294,16 @@ void output_vertex_buffer(const Terrain_vertex_buffer& vertex_buffer,
 
    const Vertex_position_compress pos_compress{vert_box};
 
-   for (const auto& vertex : vertex_buffer) {
-      writer.write(pack_vertex(vertex, pos_compress, pack_lighting));
-   }
+   std::vector<Packed_output_terrain_vertex> packed;
+   packed.resize(vertex_buffer.size());
+
+   std::transform(std::execution::par_unseq, vertex_buffer.cbegin(),
+                  vertex_buffer.cend(), packed.begin(),
+                  [&](const Terrain_vertex& vertex) noexcept {
+                     return pack_vertex(vertex, pos_compress, pack_lighting);
+                  });
+
+   writer.write(std::span{packed});
 
    writer.write(std::uint64_t{}); // trailing unused texcoords & binormal
 }
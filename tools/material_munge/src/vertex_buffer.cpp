@@ -1,311 +1,12 @@
 
 #include "vertex_buffer.hpp"
 
-#include <limits>
+#include <span>
 #include <tuple>
+#include <vector>
 
 namespace sp {
 
-namespace {
-
-auto decompress_blendweights(const glm::uint32 weights) noexcept -> glm::vec3
-{
-   const auto swizzled_weights = static_cast<glm::vec3>(glm::unpackUnorm4x8(weights));
-
-   return {swizzled_weights.z, swizzled_weights.y, swizzled_weights.x};
-}
-
-auto compress_blendweights(const glm::vec3 weights) noexcept -> glm::uint32
-{
-   const auto swizzled_weights = glm::vec3{weights.z, weights.y, weights.x};
-
-   return glm::packUnorm4x8(glm::vec4{swizzled_weights, 0.0f});
-}
-
-auto decompress_normal(const glm::uint32 normal) noexcept -> glm::vec3
-{
-   const auto swizzled_normal =
-      static_cast<glm::vec3>(glm::unpackUnorm4x8(normal)) * 2.0f - 1.0f;
-
-   return {swizzled_normal.z, swizzled_normal.y, swizzled_normal.x};
-}
-
-auto compress_normal(const glm::vec3 normal, const float w = 0.0f) noexcept -> glm::uint32
-{
-   const auto swizzled_normal = glm::vec3{normal.z, normal.y, normal.x};
-
-   return glm::packUnorm4x8(glm::vec4{swizzled_normal * 0.5f + 0.5f, w});
-}
-
-auto compress_texcoords(const glm::vec2 texcoords) noexcept -> glm::i16vec2
-{
-   constexpr float i16min = std::numeric_limits<glm::int16>::min();
-   constexpr float i16max = std::numeric_limits<glm::int16>::max();
-
-   const auto clamped =
-      glm::clamp(texcoords * 2048.f, glm::vec2{i16min}, glm::vec2{i16max});
-
-   return static_cast<glm::i16vec2>(clamped);
-}
-
-void read_vertex(const Vbuf_flags flags, ucfb::Reader_strict<"VBUF"_mn>& vbuf,
-                 const std::size_t index,
-                 const Vertex_position_decompress& pos_decompress,
-                 Vertex_buffer& output) noexcept
-{
-   if ((flags & Vbuf_flags::position) == Vbuf_flags::position) {
-      if ((flags & Vbuf_flags::position_compressed) == Vbuf_flags::position_compressed) {
-         const auto compressed = vbuf.read<glm::i16vec4>();
-
-         output.positions[index] = pos_decompress(compressed);
-      }
-      else {
-         output.positions[index] = vbuf.read<glm::vec3>();
-      }
-   }
-
-   if ((flags & Vbuf_flags::blendweight) == Vbuf_flags::blendweight) {
-      if ((flags & Vbuf_flags::blendinfo_compressed) == Vbuf_flags::blendinfo_compressed) {
-         const auto compressed = vbuf.read<glm::uint32>();
-
-         output.blendweights[index] = decompress_blendweights(compressed);
-      }
-      else {
-         const glm::vec2 weights = vbuf.read<glm::vec2>();
-
-         output.blendweights[index] =
-            glm::vec3{weights.x, weights.y, 1.0 - weights.x - weights.y};
-      }
-   }
-
-   if ((flags & Vbuf_flags::blendindices) == Vbuf_flags::blendindices)
-      output.blendindices[index] = vbuf.read<glm::uint32>();
-
-   if ((flags & Vbuf_flags::normal) == Vbuf_flags::normal) {
-      if ((flags & Vbuf_flags::normal_compressed) == Vbuf_flags::normal_compressed) {
-         const auto compressed = vbuf.read<glm::uint32>();
-
-         output.normals[index] = decompress_normal(compressed);
-      }
-      else {
-         output.normals[index] = vbuf.read<glm::vec3>();
-      }
-   }
-
-   if ((flags & Vbuf_flags::tangents) == Vbuf_flags::tangents) {
-      if ((flags & Vbuf_flags::normal_compressed) == Vbuf_flags::normal_compressed) {
-         const auto tangent_compressed = vbuf.read<glm::uint32>();
-         const auto binormal_compressed = vbuf.read<glm::uint32>();
-
-         output.tangents[index] = decompress_normal(tangent_compressed);
-         output.binormals[index] = decompress_normal(binormal_compressed);
-      }
-      else {
-         output.tangents[index] = vbuf.read<glm::vec3>();
-         output.binormals[index] = vbuf.read<glm::vec3>();
-      }
-   }
-
-   if ((flags & Vbuf_flags::color) == Vbuf_flags::color)
-      output.colors[index] = vbuf.read<glm::uint32>();
-
-   if ((flags & Vbuf_flags::static_lighting) == Vbuf_flags::static_lighting)
-      output.static_lighting_colors[index] = vbuf.read<glm::uint32>();
-
-   if ((flags & Vbuf_flags::texcoords) == Vbuf_flags::texcoords) {
-      if ((flags & Vbuf_flags::texcoord_compressed) == Vbuf_flags::texcoord_compressed) {
-         const auto compressed = static_cast<glm::vec2>(vbuf.read<glm::i16vec2>());
-
-         output.texcoords[index] = compressed / 2048.f;
-      }
-      else {
-         output.texcoords[index] = vbuf.read<glm::vec2>();
-      }
-   }
-}
-
-void write_vertex(const Vertex_buffer& vertex_buffer, const int index,
-                  const Vbuf_flags flags, const Vertex_position_compress& pos_compress,
-                  ucfb::Editor_data_writer& writer) noexcept
-{
-   if ((flags & Vbuf_flags::position) == Vbuf_flags::position) {
-      if ((flags & Vbuf_flags::position_compressed) == Vbuf_flags::position_compressed) {
-         writer.write(pos_compress(vertex_buffer.positions[index]));
-      }
-      else {
-         writer.write(vertex_buffer.positions[index]);
-      }
-   }
-
-   if ((flags & Vbuf_flags::blendweight) == Vbuf_flags::blendweight) {
-      if ((flags & Vbuf_flags::blendinfo_compressed) == Vbuf_flags::blendinfo_compressed) {
-         writer.write(compress_blendweights(vertex_buffer.blendweights[index]));
-      }
-      else {
-         writer.write(static_cast<glm::vec2>(vertex_buffer.blendweights[index]));
-      }
-   }
-
-   if ((flags & Vbuf_flags::blendindices) == Vbuf_flags::blendindices)
-      writer.write(vertex_buffer.blendindices[index]);
-
-   if ((flags & Vbuf_flags::normal) == Vbuf_flags::normal) {
-      if ((flags & Vbuf_flags::normal_compressed) == Vbuf_flags::normal_compressed) {
-         writer.write(compress_normal(vertex_buffer.normals[index]));
-      }
-      else {
-         writer.write(vertex_buffer.normals[index]);
-      }
-   }
-
-   if ((flags & Vbuf_flags::tangents) == Vbuf_flags::tangents) {
-      if ((flags & Vbuf_flags::normal_compressed) == Vbuf_flags::normal_compressed) {
-         writer.write(compress_normal(vertex_buffer.tangents[index],
-                                      vertex_buffer.bitangent_signs
-                                         ? vertex_buffer.bitangent_signs[index]
-                                         : 0.0f));
-
-         if (vertex_buffer.binormals)
-            writer.write(compress_normal(vertex_buffer.binormals[index]));
-         else
-            writer.write(glm::uint32{});
-      }
-      else {
-         writer.write(vertex_buffer.tangents[index]);
-
-         if (vertex_buffer.binormals)
-            writer.write(vertex_buffer.binormals[index]);
-         else if (vertex_buffer.binormals && vertex_buffer.bitangent_signs)
-            writer.write(glm::vec3{glm::vec2{vertex_buffer.binormals[index]},
-                                   vertex_buffer.bitangent_signs[index]});
-         else if (vertex_buffer.bitangent_signs)
-            writer.write(glm::vec3{0.0f, 0.0f, vertex_buffer.bitangent_signs[index]});
-         else
-            writer.write(glm::vec3{});
-      }
-   }
-
-   if ((flags & Vbuf_flags::color) == Vbuf_flags::color)
-      writer.write(vertex_buffer.colors[index]);
-
-   if ((flags & Vbuf_flags::static_lighting) == Vbuf_flags::static_lighting)
-      writer.write(vertex_buffer.static_lighting_colors[index]);
-
-   if ((flags & Vbuf_flags::texcoords) == Vbuf_flags::texcoords) {
-      if ((flags & Vbuf_flags::texcoord_compressed) == Vbuf_flags::texcoord_compressed)
-         writer.write(compress_texcoords(vertex_buffer.texcoords[index]));
-      else
-         writer.write(vertex_buffer.texcoords[index]);
-   }
-}
-
-auto get_vbuf_flags(const Vertex_buffer& vertex_buffer, const bool compressed) noexcept
-   -> Vbuf_flags
-{
-   Vbuf_flags flags{};
-
-   if (vertex_buffer.positions) {
-      flags |= Vbuf_flags::position;
-
-      if (compressed) flags |= Vbuf_flags::position_compressed;
-   }
-
-   if (vertex_buffer.blendindices) {
-      flags |= Vbuf_flags::blendindices;
-
-      if (vertex_buffer.blendweights) {
-         flags |= Vbuf_flags::blendweight;
-         if (compressed) flags |= Vbuf_flags::blendinfo_compressed;
-      }
-   }
-
-   if (vertex_buffer.normals) {
-      flags |= Vbuf_flags::normal;
-
-      if (compressed) flags |= Vbuf_flags::normal_compressed;
-   }
-
-   if (vertex_buffer.tangents || vertex_buffer.bitangent_signs ||
-       vertex_buffer.binormals) {
-      flags |= Vbuf_flags::tangents;
-
-      if (compressed) flags |= Vbuf_flags::normal_compressed;
-   }
-
-   if (vertex_buffer.colors && !vertex_buffer.static_lighting_colors)
-      flags |= Vbuf_flags::color;
-   if (vertex_buffer.static_lighting_colors)
-      flags |= Vbuf_flags::static_lighting;
-
-   if (vertex_buffer.texcoords) {
-      flags |= Vbuf_flags::texcoords;
-
-      if (compressed) flags |= Vbuf_flags::texcoord_compressed;
-   }
-
-   return flags;
-}
-
-auto get_vbuf_stride(const Vbuf_flags flags) noexcept -> std::uint32_t
-{
-   std::uint32_t stride{};
-
-   if ((flags & Vbuf_flags::position) == Vbuf_flags::position) {
-      if ((flags & Vbuf_flags::position_compressed) == Vbuf_flags::position_compressed)
-         stride += sizeof(glm::i16vec4);
-      else
-         stride += sizeof(glm::vec3);
-   }
-
-   if ((flags & Vbuf_flags::blendindices) == Vbuf_flags::blendindices)
-      stride += sizeof(glm::uint32);
-
-   if ((flags & Vbuf_flags::blendweight) == Vbuf_flags::blendweight) {
-      if ((flags & Vbuf_flags::blendinfo_compressed) == Vbuf_flags::blendinfo_compressed) {
-         stride += sizeof(glm::uint32);
-      }
-      else {
-         stride += sizeof(glm::vec2);
-      }
-   }
-
-   if ((flags & Vbuf_flags::normal) == Vbuf_flags::normal) {
-      if ((flags & Vbuf_flags::normal_compressed) == Vbuf_flags::normal_compressed) {
-         stride += sizeof(glm::uint32);
-      }
-      else {
-         stride += sizeof(glm::vec3);
-      }
-   }
-
-   if ((flags & Vbuf_flags::tangents) == Vbuf_flags::tangents) {
-      if ((flags & Vbuf_flags::normal_compressed) == Vbuf_flags::normal_compressed) {
-         stride += sizeof(glm::uint32) * 2;
-      }
-      else {
-         stride += sizeof(glm::vec3) * 2;
-      }
-   }
-
-   if ((flags & Vbuf_flags::color) == Vbuf_flags::color)
-      stride += sizeof(glm::uint32);
-
-   if ((flags & Vbuf_flags::static_lighting) == Vbuf_flags::static_lighting)
-      stride += sizeof(glm::uint32);
-
-   if ((flags & Vbuf_flags::texcoords) == Vbuf_flags::texcoords) {
-      if ((flags & Vbuf_flags::texcoord_compressed) == Vbuf_flags::texcoord_compressed) {
-         stride += sizeof(glm::i16vec2);
-      }
-      else {
-         stride += sizeof(glm::vec2);
-      }
-   }
-
-   return stride;
-}
-}
-
 Vertex_buffer::Vertex_buffer(const std::size_t count, const Vbuf_flags flags) noexcept
    : count{count}
 {
@@ -344,11 +45,18 @@ auto create_vertex_buffer(ucfb::Reader_strict<"VBUF"_mn> vbuf,
 
    Vertex_buffer buffer{count, flags};
 
+   // The layout comes from the flags, the same as it does for the game. The
+   // stored stride is not trusted.
+   const auto vertex_stride = get_vbuf_stride(flags);
+   const auto vertices = vbuf.read_array<std::byte>(std::size_t{count} * vertex_stride);
+
    const Vertex_position_decompress pos_decompress{vert_box};
 
-   for (auto i = 0u; i < count; ++i) {
-      read_vertex(flags, vbuf, i, pos_decompress, buffer);
-   }
+   decode_vbuf_vertices(flags,
+                        {.data = vertices.data(),
+                         .count = count,
+                         .stride = vertex_stride},
+                        pos_decompress, buffer);
 
    return buffer;
 }
@@ -364,8 +72,6 @@ void output_vertex_buffer(const Vertex_buffer& vertex_buffer,
 
    const Vertex_position_compress pos_compress{vert_box};
 
-   for (auto i = 0; i < vertex_buffer.count; ++i) {
-      write_vertex(vertex_buffer, i, flags, pos_compress, writer);
-   }
+   writer.write(encode_vbuf_vertices_staged(vertex_buffer, flags, pos_compress));
 }
 }
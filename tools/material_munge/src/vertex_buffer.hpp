@@ -1,8 +1,8 @@
 #pragma once
 
-#include "enum_flags.hpp"
 #include "ucfb_editor.hpp"
 #include "ucfb_reader.hpp"
+#include "vertex_buffer_codec.hpp"
 
 #include <array>
 #include <cstddef>
@@ -13,25 +13,6 @@
 
 namespace sp {
 
-enum class Vbuf_flags : std::uint32_t {
-   position = 0b10u,
-   blendindices = 0b100u,
-   blendweight = 0b1000u,
-   normal = 0b100000u,
-   tangents = 0b1000000u,
-   color = 0b10000000u,
-   static_lighting = 0b100000000u,
-   texcoords = 0b1000000000u,
-
-   position_compressed = 0b1000000000000u,
-   blendinfo_compressed = 0b10000000000000u,
-   normal_compressed = 0b100000000000000u,
-   texcoord_compressed = 0b1000000000000000u
-};
-
-template<>
-struct is_enum_flag<Vbuf_flags> : std::true_type {};
-
 struct Vertex_buffer {
    Vertex_buffer() = default;
 
@@ -66,9 +47,9 @@ public:
       mul = (vert_box[1] - vert_box[0]);
    }
 
-   glm::vec3 operator()(const glm::i16vec4 compressed) const noexcept
+   glm::vec3 operator()(const Vbuf_compressed_position compressed) const noexcept
    {
-      const auto c = static_cast<glm::vec3>(compressed);
+      const auto c = glm::vec3{compressed[0], compressed[1], compressed[2]};
       constexpr float i16min = std::numeric_limits<glm::int16>::min();
       constexpr float i16max = std::numeric_limits<glm::int16>::max();
 
@@ -0,0 +1,534 @@
+#pragma once
+
+#include "enum_flags.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace sp {
+
+// Decoding and encoding of VBUF vertices. Kept free of glm, everything is
+// templated on the vertex buffer it fills or reads. Its vector types need only
+// x, y (and z) members and construction from their components, and the results
+// are identical to converting with glm's packing functions.
+
+enum class Vbuf_flags : std::uint32_t {
+   position = 0b10u,
+   blendindices = 0b100u,
+   blendweight = 0b1000u,
+   normal = 0b100000u,
+   tangents = 0b1000000u,
+   color = 0b10000000u,
+   static_lighting = 0b100000000u,
+   texcoords = 0b1000000000u,
+
+   position_compressed = 0b1000000000000u,
+   blendinfo_compressed = 0b10000000000000u,
+   normal_compressed = 0b100000000000000u,
+   texcoord_compressed = 0b1000000000000000u
+};
+
+template<>
+struct is_enum_flag<Vbuf_flags> : std::true_type {};
+
+using Vbuf_compressed_position = std::array<std::int16_t, 4>;
+using Vbuf_compressed_texcoords = std::array<std::int16_t, 2>;
+
+inline auto unpack_vbuf_unorm4x8(const std::uint32_t packed) noexcept
+   -> std::array<float, 4>
+{
+   std::array<std::uint8_t, 4> unorm;
+
+   std::memcpy(&unorm, &packed, sizeof(packed));
+
+   return {unorm[0] * (1.0f / 255.0f), unorm[1] * (1.0f / 255.0f),
+           unorm[2] * (1.0f / 255.0f), unorm[3] * (1.0f / 255.0f)};
+}
+
+inline auto pack_vbuf_unorm4x8(const std::array<float, 4> values) noexcept -> std::uint32_t
+{
+   std::array<std::uint8_t, 4> unorm;
+
+   for (std::size_t i = 0; i < unorm.size(); ++i) {
+      unorm[i] = static_cast<std::uint8_t>(
+         std::round(std::clamp(values[i], 0.0f, 1.0f) * 255.0f));
+   }
+
+   std::uint32_t packed;
+
+   std::memcpy(&packed, &unorm, sizeof(packed));
+
+   return packed;
+}
+
+template<typename Vec3>
+auto decompress_vbuf_blendweights(const std::uint32_t weights) noexcept -> Vec3
+{
+   const auto swizzled_weights = unpack_vbuf_unorm4x8(weights);
+
+   return {swizzled_weights[2], swizzled_weights[1], swizzled_weights[0]};
+}
+
+template<typename Vec3>
+auto compress_vbuf_blendweights(const Vec3& weights) noexcept -> std::uint32_t
+{
+   return pack_vbuf_unorm4x8({weights.z, weights.y, weights.x, 0.0f});
+}
+
+template<typename Vec3>
+auto decompress_vbuf_normal(const std::uint32_t normal) noexcept -> Vec3
+{
+   const auto swizzled_normal = unpack_vbuf_unorm4x8(normal);
+
+   return {swizzled_normal[2] * 2.0f - 1.0f, swizzled_normal[1] * 2.0f - 1.0f,
+           swizzled_normal[0] * 2.0f - 1.0f};
+}
+
+template<typename Vec3>
+auto compress_vbuf_normal(const Vec3& normal, const float w = 0.0f) noexcept
+   -> std::uint32_t
+{
+   return pack_vbuf_unorm4x8(
+      {normal.z * 0.5f + 0.5f, normal.y * 0.5f + 0.5f, normal.x * 0.5f + 0.5f, w});
+}
+
+template<typename Vec2>
+auto decompress_vbuf_texcoords(const Vbuf_compressed_texcoords texcoords) noexcept -> Vec2
+{
+   return {static_cast<float>(texcoords[0]) / 2048.f,
+           static_cast<float>(texcoords[1]) / 2048.f};
+}
+
+template<typename Vec2>
+auto compress_vbuf_texcoords(const Vec2& texcoords) noexcept -> Vbuf_compressed_texcoords
+{
+   constexpr float i16min = std::numeric_limits<std::int16_t>::min();
+   constexpr float i16max = std::numeric_limits<std::int16_t>::max();
+
+   return {static_cast<std::int16_t>(std::clamp(texcoords.x * 2048.f, i16min, i16max)),
+           static_cast<std::int16_t>(std::clamp(texcoords.y * 2048.f, i16min, i16max))};
+}
+
+inline auto get_vbuf_stride(const Vbuf_flags flags) noexcept -> std::uint32_t
+{
+   const auto is_set = [flags](const Vbuf_flags flag) noexcept {
+      return (flags & flag) == flag;
+   };
+
+   constexpr std::uint32_t float2_size = sizeof(float) * 2;
+   constexpr std::uint32_t float3_size = sizeof(float) * 3;
+
+   const bool normal_compressed = is_set(Vbuf_flags::normal_compressed);
+
+   std::uint32_t stride{};
+
+   if (is_set(Vbuf_flags::position)) {
+      stride += is_set(Vbuf_flags::position_compressed)
+                   ? sizeof(Vbuf_compressed_position)
+                   : float3_size;
+   }
+
+   if (is_set(Vbuf_flags::blendindices)) stride += sizeof(std::uint32_t);
+
+   if (is_set(Vbuf_flags::blendweight)) {
+      stride += is_set(Vbuf_flags::blendinfo_compressed) ? sizeof(std::uint32_t)
+                                                         : float2_size;
+   }
+
+   if (is_set(Vbuf_flags::normal)) {
+      stride += normal_compressed ? sizeof(std::uint32_t) : float3_size;
+   }
+
+   if (is_set(Vbuf_flags::tangents)) {
+      stride += (normal_compressed ? sizeof(std::uint32_t) : float3_size) * 2;
+   }
+
+   if (is_set(Vbuf_flags::color)) stride += sizeof(std::uint32_t);
+
+   if (is_set(Vbuf_flags::static_lighting)) stride += sizeof(std::uint32_t);
+
+   if (is_set(Vbuf_flags::texcoords)) {
+      stride += is_set(Vbuf_flags::texcoord_compressed)
+                   ? sizeof(Vbuf_compressed_texcoords)
+                   : float2_size;
+   }
+
+   return stride;
+}
+
+template<typename Vertex_buffer>
+auto get_vbuf_flags(const Vertex_buffer& vertex_buffer, const bool compressed) noexcept
+   -> Vbuf_flags
+{
+   Vbuf_flags flags{};
+
+   if (vertex_buffer.positions) {
+      flags |= Vbuf_flags::position;
+
+      if (compressed) flags |= Vbuf_flags::position_compressed;
+   }
+
+   if (vertex_buffer.blendindices) {
+      flags |= Vbuf_flags::blendindices;
+
+      if (vertex_buffer.blendweights) {
+         flags |= Vbuf_flags::blendweight;
+         if (compressed) flags |= Vbuf_flags::blendinfo_compressed;
+      }
+   }
+
+   if (vertex_buffer.normals) {
+      flags |= Vbuf_flags::normal;
+
+      if (compressed) flags |= Vbuf_flags::normal_compressed;
+   }
+
+   if (vertex_buffer.tangents || vertex_buffer.bitangent_signs ||
+       vertex_buffer.binormals) {
+      flags |= Vbuf_flags::tangents;
+
+      if (compressed) flags |= Vbuf_flags::normal_compressed;
+   }
+
+   if (vertex_buffer.colors && !vertex_buffer.static_lighting_colors)
+      flags |= Vbuf_flags::color;
+   if (vertex_buffer.static_lighting_colors)
+      flags |= Vbuf_flags::static_lighting;
+
+   if (vertex_buffer.texcoords) {
+      flags |= Vbuf_flags::texcoords;
+
+      if (compressed) flags |= Vbuf_flags::texcoord_compressed;
+   }
+
+   return flags;
+}
+
+// VBUF attributes are interleaved, decoding and encoding walks one attribute
+// of every vertex at a time so the flags are tested once per buffer and the
+// conversion loops are tight enough for the compiler to vectorize.
+template<typename Byte>
+struct Vbuf_view {
+   Byte* data;
+   std::size_t count;
+   std::size_t stride;
+   std::size_t offset = 0;
+};
+
+namespace detail {
+
+template<typename Stored, typename Value, typename Convert>
+void decode_vbuf_attribute(Vbuf_view<const std::byte>& vbuf, Value* const output,
+                           const Convert& convert) noexcept
+{
+   const std::byte* src = vbuf.data + vbuf.offset;
+
+   for (std::size_t i = 0; i < vbuf.count; ++i, src += vbuf.stride) {
+      Stored stored;
+
+      std::memcpy(&stored, src, sizeof(Stored));
+
+      output[i] = convert(stored);
+   }
+
+   vbuf.offset += sizeof(Stored);
+}
+
+template<typename Value>
+void decode_vbuf_attribute(Vbuf_view<const std::byte>& vbuf, Value* const output) noexcept
+{
+   decode_vbuf_attribute<Value>(vbuf, output, [](const Value& v) noexcept { return v; });
+}
+
+template<typename Generate>
+void encode_vbuf_attribute(Vbuf_view<std::byte>& vbuf, const Generate& generate) noexcept
+{
+   using Stored = decltype(generate(std::size_t{}));
+
+   static_assert(sizeof(Stored) % 4 == 0,
+                 "VBUF attributes must keep vertices 4 byte aligned.");
+
+   std::byte* dest = vbuf.data + vbuf.offset;
+
+   for (std::size_t i = 0; i < vbuf.count; ++i, dest += vbuf.stride) {
+      const Stored stored = generate(i);
+
+      std::memcpy(dest, &stored, sizeof(Stored));
+   }
+
+   vbuf.offset += sizeof(Stored);
+}
+
+template<typename Vertex_buffer>
+using Vbuf_vec2 = std::remove_cvref_t<decltype(std::declval<Vertex_buffer>().texcoords[0])>;
+
+template<typename Vertex_buffer>
+using Vbuf_vec3 = std::remove_cvref_t<decltype(std::declval<Vertex_buffer>().positions[0])>;
+
+}
+
+// Decodes every vertex of the VBUF into the buffer, which must have arrays for
+// each attribute in flags. pos_decompress is called with the
+// Vbuf_compressed_position of compressed positions.
+template<typename Vertex_buffer, typename Position_decompress>
+void decode_vbuf_vertices(const Vbuf_flags flags, Vbuf_view<const std::byte> vbuf,
+                          const Position_decompress& pos_decompress,
+                          Vertex_buffer& output) noexcept
+{
+   using Vec2 = detail::Vbuf_vec2<Vertex_buffer>;
+   using Vec3 = detail::Vbuf_vec3<Vertex_buffer>;
+
+   const auto is_set = [flags](const Vbuf_flags flag) noexcept {
+      return (flags & flag) == flag;
+   };
+
+   const bool normal_compressed = is_set(Vbuf_flags::normal_compressed);
+
+   if (is_set(Vbuf_flags::position)) {
+      if (is_set(Vbuf_flags::position_compressed)) {
+         detail::decode_vbuf_attribute<Vbuf_compressed_position>(vbuf,
+                                                                 output.positions.get(),
+                                                                 pos_decompress);
+      }
+      else {
+         detail::decode_vbuf_attribute(vbuf, output.positions.get());
+      }
+   }
+
+   if (is_set(Vbuf_flags::blendweight)) {
+      if (is_set(Vbuf_flags::blendinfo_compressed)) {
+         detail::decode_vbuf_attribute<std::uint32_t>(vbuf, output.blendweights.get(),
+                                                      decompress_vbuf_blendweights<Vec3>);
+      }
+      else {
+         detail::decode_vbuf_attribute<Vec2>(
+            vbuf, output.blendweights.get(), [](const Vec2& weights) noexcept {
+               return Vec3{weights.x, weights.y,
+                           static_cast<float>(1.0 - weights.x - weights.y)};
+            });
+      }
+   }
+
+   if (is_set(Vbuf_flags::blendindices)) {
+      detail::decode_vbuf_attribute(vbuf, output.blendindices.get());
+   }
+
+   if (is_set(Vbuf_flags::normal)) {
+      if (normal_compressed) {
+         detail::decode_vbuf_attribute<std::uint32_t>(vbuf, output.normals.get(),
+                                                      decompress_vbuf_normal<Vec3>);
+      }
+      else {
+         detail::decode_vbuf_attribute(vbuf, output.normals.get());
+      }
+   }
+
+   if (is_set(Vbuf_flags::tangents)) {
+      if (normal_compressed) {
+         detail::decode_vbuf_attribute<std::uint32_t>(vbuf, output.tangents.get(),
+                                                      decompress_vbuf_normal<Vec3>);
+         detail::decode_vbuf_attribute<std::uint32_t>(vbuf, output.binormals.get(),
+                                                      decompress_vbuf_normal<Vec3>);
+      }
+      else {
+         detail::decode_vbuf_attribute(vbuf, output.tangents.get());
+         detail::decode_vbuf_attribute(vbuf, output.binormals.get());
+      }
+   }
+
+   if (is_set(Vbuf_flags::color)) {
+      detail::decode_vbuf_attribute(vbuf, output.colors.get());
+   }
+
+   if (is_set(Vbuf_flags::static_lighting)) {
+      detail::decode_vbuf_attribute(vbuf, output.static_lighting_colors.get());
+   }
+
+   if (is_set(Vbuf_flags::texcoords)) {
+      if (is_set(Vbuf_flags::texcoord_compressed)) {
+         detail::decode_vbuf_attribute<Vbuf_compressed_texcoords>(
+            vbuf, output.texcoords.get(), decompress_vbuf_texcoords<Vec2>);
+      }
+      else {
+         detail::decode_vbuf_attribute(vbuf, output.texcoords.get());
+      }
+   }
+}
+
+// Encodes every vertex of the buffer into the VBUF. pos_compress must return a
+// type the size of Vbuf_compressed_position.
+template<typename Vertex_buffer, typename Position_compress>
+void encode_vbuf_vertices(const Vertex_buffer& vertex_buffer, const Vbuf_flags flags,
+                          const Position_compress& pos_compress,
+                          Vbuf_view<std::byte> vbuf) noexcept
+{
+   using Vec2 = detail::Vbuf_vec2<Vertex_buffer>;
+   using Vec3 = detail::Vbuf_vec3<Vertex_buffer>;
+
+   const auto is_set = [flags](const Vbuf_flags flag) noexcept {
+      return (flags & flag) == flag;
+   };
+
+   const bool normal_compressed = is_set(Vbuf_flags::normal_compressed);
+
+   if (is_set(Vbuf_flags::position)) {
+      const auto* const positions = vertex_buffer.positions.get();
+
+      if (is_set(Vbuf_flags::position_compressed)) {
+         detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+            return pos_compress(positions[i]);
+         });
+      }
+      else {
+         detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+            return positions[i];
+         });
+      }
+   }
+
+   if (is_set(Vbuf_flags::blendweight)) {
+      const auto* const blendweights = vertex_buffer.blendweights.get();
+
+      if (is_set(Vbuf_flags::blendinfo_compressed)) {
+         detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+            return compress_vbuf_blendweights(blendweights[i]);
+         });
+      }
+      else {
+         detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+            return Vec2{blendweights[i].x, blendweights[i].y};
+         });
+      }
+   }
+
+   if (is_set(Vbuf_flags::blendindices)) {
+      detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+         return vertex_buffer.blendindices[i];
+      });
+   }
+
+   if (is_set(Vbuf_flags::normal)) {
+      const auto* const normals = vertex_buffer.normals.get();
+
+      if (normal_compressed) {
+         detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+            return compress_vbuf_normal(normals[i]);
+         });
+      }
+      else {
+         detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+            return normals[i];
+         });
+      }
+   }
+
+   if (is_set(Vbuf_flags::tangents)) {
+      const auto* const tangents = vertex_buffer.tangents.get();
+      const auto* const binormals = vertex_buffer.binormals.get();
+      const auto* const bitangent_signs = vertex_buffer.bitangent_signs.get();
+
+      if (normal_compressed) {
+         if (bitangent_signs) {
+            detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+               return compress_vbuf_normal(tangents[i], bitangent_signs[i]);
+            });
+         }
+         else {
+            detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+               return compress_vbuf_normal(tangents[i]);
+            });
+         }
+
+         if (binormals) {
+            detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+               return compress_vbuf_normal(binormals[i]);
+            });
+         }
+         else {
+            detail::encode_vbuf_attribute(vbuf, [](const std::size_t) noexcept {
+               return std::uint32_t{};
+            });
+         }
+      }
+      else {
+         detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+            return tangents[i];
+         });
+
+         if (binormals) {
+            detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+               return binormals[i];
+            });
+         }
+         else if (bitangent_signs) {
+            detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+               return Vec3{0.0f, 0.0f, bitangent_signs[i]};
+            });
+         }
+         else {
+            detail::encode_vbuf_attribute(vbuf, [](const std::size_t) noexcept {
+               return Vec3{};
+            });
+         }
+      }
+   }
+
+   if (is_set(Vbuf_flags::color)) {
+      detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+         return vertex_buffer.colors[i];
+      });
+   }
+
+   if (is_set(Vbuf_flags::static_lighting)) {
+      detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+         return vertex_buffer.static_lighting_colors[i];
+      });
+   }
+
+   if (is_set(Vbuf_flags::texcoords)) {
+      const auto* const texcoords = vertex_buffer.texcoords.get();
+
+      if (is_set(Vbuf_flags::texcoord_compressed)) {
+         detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+            return compress_vbuf_texcoords(texcoords[i]);
+         });
+      }
+      else {
+         detail::encode_vbuf_attribute(vbuf, [&](const std::size_t i) noexcept {
+            return texcoords[i];
+         });
+      }
+   }
+}
+
+// Encodes the buffer into staging reused by the calling thread, so segments
+// output in parallel each reuse their thread's allocation. The span is valid
+// until the thread's next call.
+template<typename Vertex_buffer, typename Position_compress>
+auto encode_vbuf_vertices_staged(const Vertex_buffer& vertex_buffer,
+                                 const Vbuf_flags flags,
+                                 const Position_compress& pos_compress)
+   -> std::span<const std::byte>
+{
+   const auto stride = get_vbuf_stride(flags);
+
+   thread_local std::vector<std::byte> staging;
+   staging.assign(vertex_buffer.count * stride, std::byte{});
+
+   encode_vbuf_vertices(vertex_buffer, flags, pos_compress,
+                        {.data = staging.data(),
+                         .count = vertex_buffer.count,
+                         .stride = stride});
+
+   return staging;
+}
+
+}
@@ -1,11 +1,13 @@
 
 #include "munge_colorgrading_regions.hpp"
 #include "color_grading_regions_io.hpp"
+#include "compose_exception.hpp"
 #include "config_file.hpp"
 #include "string_utilities.hpp"
 
 #include <algorithm>
 #include <charconv>
+#include <tuple>
 
 #include <gsl/gsl>
 
@@ -154,9 +156,12 @@ auto load_colorgrading_regions(const std::filesystem::path& regions_path)
 
 auto load_colorgrading_configs(const std::filesystem::path& config_search_path,
                                const std::vector<Color_grading_region_desc>& descs)
-   -> std::unordered_map<std::string, YAML::Node>
+   -> std::pair<std::vector<std::string>, std::vector<Color_grading_config_block>>
 {
-   std::unordered_map<std::string, YAML::Node> configs;
+   std::vector<std::string> names;
+   std::vector<Color_grading_config_block> configs;
+
+   names.reserve(descs.size());
    configs.reserve(descs.size());
 
    for (const auto& entry :
@@ -172,22 +177,36 @@ auto load_colorgrading_configs(const std::filesystem::path& config_search_path,
          continue;
       }
 
-      configs.emplace(std::move(name), YAML::LoadFile(entry.path().string()));
+      if (std::find(names.cbegin(), names.cend(), name) != names.cend()) continue;
+
+      const auto config = YAML::LoadFile(entry.path().string());
+
+      try {
+         validate_colorgrading_config(config);
+      }
+      catch (std::exception& e) {
+         throw compose_exception<std::runtime_error>("Invalid color grading config "sv,
+                                                     entry.path().filename().string(),
+                                                     ": "sv, e.what());
+      }
+
+      names.emplace_back(std::move(name));
+      configs.push_back(compile_colorgrading_config(config));
    }
 
-   return configs;
+   return {std::move(names), std::move(configs)};
 }
 
 }
 
 void munge_colorgrading_regions(const std::filesystem::path& regions_path,
                                 const std::filesystem::path& config_search_path,
-                                const std::filesystem::path& output_path) noexcept
+                                const std::filesystem::path& output_path)
 {
    Color_grading_regions colorgrading;
 
    colorgrading.regions = load_colorgrading_regions(regions_path);
-   colorgrading.configs =
+   std::tie(colorgrading.config_names, colorgrading.configs) =
       load_colorgrading_configs(config_search_path, colorgrading.regions);
 
    auto output_filename = regions_path.filename();
@@ -195,4 +214,4 @@ void munge_colorgrading_regions(const std::filesystem::path& regions_path,
 
    write_colorgrading_regions(output_path / output_filename, colorgrading);
 }
-}
\ No newline at end of file
+}
@@ -6,6 +6,6 @@ namespace sp {
 
 void munge_colorgrading_regions(const std::filesystem::path& regions_path,
                                 const std::filesystem::path& config_search_path,
-                                const std::filesystem::path& output_path) noexcept;
+                                const std::filesystem::path& output_path);
 
 }
\ No newline at end of file